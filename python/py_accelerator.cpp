@@ -227,7 +227,16 @@ void bind_accelerator(py::module &m) {
           "counts.")
       .def("getMarginalCounts", &xacc::AcceleratorBuffer::getMarginalCounts,
            "Return the mapping of marginal measure bit strings to their "
-           "counts.");
+           "counts.")
+      .def(
+          "getParityExpectationValues",
+          [](AcceleratorBuffer &b, const std::vector<std::vector<int>> &idxs,
+             AcceleratorBuffer::BitOrder bitOrder) {
+            return b.getParityExpectationValues(idxs, bitOrder);
+          },
+          py::arg("idxs"), py::arg("bitOrder") = AcceleratorBuffer::BitOrder::MSB,
+          "Return the expectation values of Z...Z on each list of bit "
+          "indices (parity of the marginal counts).");
   py::enum_<xacc::AcceleratorBuffer::BitOrder>(m, "BitOrder")
       .value("LSB", xacc::AcceleratorBuffer::BitOrder::LSB)
       .value("MSB", xacc::AcceleratorBuffer::BitOrder::MSB)
@@ -64,7 +64,12 @@ void bind_graph(py::module &m) {
             g.setVertexProperties(index, m);
           },
           "")
-      .def("getVertexProperties", &xacc::Graph::getVertexProperties, "")
+      .def(
+          "getVertexProperties",
+          [](xacc::Graph &g, const int index) {
+            return g.getVertexProperties(index).toHeterogeneousMap();
+          },
+          "")
       .def("setEdgeWeight", &xacc::Graph::setEdgeWeight, "")
       .def("getEdgeWeight", &xacc::Graph::getEdgeWeight, "")
       .def("edgeExists", &xacc::Graph::edgeExists, "")
@@ -78,8 +78,8 @@ public:
                            properties);
   }
 
-  virtual HeterogeneousMap &getVertexProperties(const int index) override {
-    PYBIND11_OVERLOAD_PURE(HeterogeneousMap &, xacc::Graph, getVertexProperties,
+  virtual PropertyStore &getVertexProperties(const int index) override {
+    PYBIND11_OVERLOAD_PURE(PropertyStore &, xacc::Graph, getVertexProperties,
                            index);
   }
 
@@ -0,0 +1,285 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#include "EmbeddingCache.hpp"
+#include "ThreadPool.hpp"
+#include "xacc.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <queue>
+#include <random>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+// FNV-1a: stable across platforms and runs (unlike std::hash).
+class Fnv1a {
+public:
+  void add(std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  }
+  std::string hex() const {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+  }
+
+private:
+  std::uint64_t hash = 14695981039346656037ULL;
+};
+
+std::string graphFingerprint(std::shared_ptr<xacc::Graph> graph) {
+  Fnv1a hash;
+  const int n = graph->order();
+  hash.add(n);
+  // Sorted (i < j) edge list
+  for (int i = 0; i < n; i++) {
+    auto neighbors = graph->getNeighborList(i);
+    std::sort(neighbors.begin(), neighbors.end());
+    for (auto j : neighbors) {
+      if (i < j) {
+        hash.add(i);
+        hash.add(j);
+      }
+    }
+  }
+  return hash.hex();
+}
+
+// Total number of hardware qubits used
+int nbPhysicalQubits(const xacc::quantum::Embedding &embedding) {
+  int count = 0;
+  for (auto &kv : embedding) {
+    count += kv.second.size();
+  }
+  return count;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+
+EmbeddingCache::EmbeddingCache(const std::string &directory)
+    : cacheDir(directory) {
+  if (cacheDir.empty()) {
+    cacheDir = xacc::getRootDirectory() + "/embedding-cache";
+  }
+  if (!xacc::directoryExists(cacheDir)) {
+    mkdir(cacheDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  }
+}
+
+std::string EmbeddingCache::fingerprint(std::shared_ptr<Graph> problem,
+                                        std::shared_ptr<Graph> hardware) {
+  return graphFingerprint(problem) + "-" + graphFingerprint(hardware);
+}
+
+std::string EmbeddingCache::filePath(const std::string &key) const {
+  return cacheDir + "/" + key + ".emb";
+}
+
+bool EmbeddingCache::get(const std::string &key, Embedding &embedding) const {
+  const auto path = filePath(key);
+  if (!xacc::fileExists(path)) {
+    return false;
+  }
+  std::ifstream stream(path);
+  Embedding loaded;
+  try {
+    loaded.load(stream);
+  } catch (std::exception &e) {
+    xacc::warning("Ignoring corrupted embedding cache file " + path);
+    return false;
+  }
+  if (loaded.empty()) {
+    return false;
+  }
+  embedding = loaded;
+  return true;
+}
+
+void EmbeddingCache::put(const std::string &key,
+                         const Embedding &embedding) const {
+  // Write to a temporary file then rename (atomic on POSIX), so that
+  // concurrent processes never read a partially written entry. The temporary
+  // name is unique per process and thread.
+  std::stringstream tmpName;
+  tmpName << filePath(key) << ".tmp." << getpid() << "."
+          << std::this_thread::get_id();
+  {
+    std::ofstream out(tmpName.str());
+    Embedding toPersist(embedding);
+    toPersist.persist(out);
+  }
+  if (std::rename(tmpName.str().c_str(), filePath(key).c_str()) != 0) {
+    std::remove(tmpName.str().c_str());
+    xacc::warning("Could not write embedding cache file " + filePath(key));
+  }
+}
+
+int EmbeddingCache::maxChainLength(const Embedding &embedding) {
+  int maxLength = 0;
+  for (auto &kv : embedding) {
+    maxLength = std::max(maxLength, (int)kv.second.size());
+  }
+  return maxLength;
+}
+
+bool EmbeddingCache::isValid(const Embedding &embedding,
+                             std::shared_ptr<Graph> problem,
+                             std::shared_ptr<Graph> hardware) {
+  const int nProblem = problem->order();
+  const int nHardware = hardware->order();
+  std::set<int> used;
+  for (int i = 0; i < nProblem; i++) {
+    auto iter = embedding.find(i);
+    if (iter == embedding.end() || iter->second.empty()) {
+      // Isolated vertices may be left unembedded.
+      if (problem->degree(i) == 0) {
+        continue;
+      }
+      return false;
+    }
+    const auto &chain = iter->second;
+    for (auto q : chain) {
+      if (q < 0 || q >= nHardware || !used.insert(q).second) {
+        return false;
+      }
+    }
+    // Chain must be connected
+    std::set<int> visited{chain[0]};
+    std::queue<int> toVisit;
+    toVisit.push(chain[0]);
+    while (!toVisit.empty()) {
+      const int q = toVisit.front();
+      toVisit.pop();
+      for (auto r : chain) {
+        if (!visited.count(r) && hardware->edgeExists(q, r)) {
+          visited.insert(r);
+          toVisit.push(r);
+        }
+      }
+    }
+    if (visited.size() != chain.size()) {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < nProblem; i++) {
+    for (auto j : problem->getNeighborList(i)) {
+      if (i >= j) {
+        continue;
+      }
+      bool covered = false;
+      for (auto qi : embedding.at(i)) {
+        for (auto qj : embedding.at(j)) {
+          if (hardware->edgeExists(qi, qj)) {
+            covered = true;
+            break;
+          }
+        }
+        if (covered) {
+          break;
+        }
+      }
+      if (!covered) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+Embedding EmbeddingCache::embed(std::shared_ptr<EmbeddingAlgorithm> algorithm,
+                                std::shared_ptr<Graph> problem,
+                                std::shared_ptr<Graph> hardware, int nSeeds,
+                                std::map<std::string, std::string> params) {
+  const auto key = algorithm->name() + "-" + fingerprint(problem, hardware);
+  Embedding embedding;
+  if (get(key, embedding)) {
+    if (isValid(embedding, problem, hardware)) {
+      xacc::info("Using cached embedding " + filePath(key));
+      nHits++;
+      return embedding;
+    }
+    xacc::warning("Cached embedding " + filePath(key) +
+                  " is not valid, recomputing.");
+  }
+
+  nSeeds = std::max(1, nSeeds);
+  params["failhard"] = "false";
+  std::vector<std::map<std::string, std::string>> seedParams(nSeeds, params);
+  if (nSeeds > 1) {
+    // Consecutive seeds from the user-provided one (reproducible) or a
+    // random one.
+    std::uint64_t baseSeed = params.count("random_seed")
+                                 ? std::stoull(params["random_seed"])
+                                 : std::random_device()();
+    for (int i = 0; i < nSeeds; i++) {
+      seedParams[i]["random_seed"] = std::to_string(baseSeed + i);
+    }
+  }
+
+  // Note: the embedding algorithm and the graphs are shared by the
+  // concurrent searches, i.e. embed() must not modify any state.
+  std::vector<Embedding> candidates(nSeeds);
+  if (nSeeds == 1) {
+    candidates[0] = algorithm->embed(problem, hardware, seedParams[0]);
+  } else {
+    ThreadPool pool(std::min<std::size_t>(
+        nSeeds, std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::future<Embedding>> results;
+    for (int i = 0; i < nSeeds; i++) {
+      results.emplace_back(pool.enqueue([&, i]() {
+        return algorithm->embed(problem, hardware, seedParams[i]);
+      }));
+    }
+    for (int i = 0; i < nSeeds; i++) {
+      candidates[i] = results[i].get();
+    }
+  }
+
+  int best = -1;
+  for (int i = 0; i < nSeeds; i++) {
+    if (candidates[i].empty() ||
+        !isValid(candidates[i], problem, hardware)) {
+      continue;
+    }
+    if (best < 0 ||
+        std::make_pair(maxChainLength(candidates[i]),
+                       nbPhysicalQubits(candidates[i])) <
+            std::make_pair(maxChainLength(candidates[best]),
+                           nbPhysicalQubits(candidates[best]))) {
+      best = i;
+    }
+  }
+  if (best < 0) {
+    return Embedding();
+  }
+  xacc::info("Embedding found with max. chain length " +
+             std::to_string(maxChainLength(candidates[best])) + " (" +
+             std::to_string(nSeeds) + " seeds).");
+  put(key, candidates[best]);
+  return candidates[best];
+}
+
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#ifndef QUANTUM_AQC_COMPILER_EMBEDDINGCACHE_HPP_
+#define QUANTUM_AQC_COMPILER_EMBEDDINGCACHE_HPP_
+
+#include "EmbeddingAlgorithm.hpp"
+
+namespace xacc {
+namespace quantum {
+
+/**
+ * The EmbeddingCache persists minor graph embeddings on disk,
+ * keyed by fingerprints of the problem and hardware graphs, so that
+ * repeated executions of the same problem on the same hardware
+ * do not recompute the embedding.
+ *
+ * Each embedding is stored as one file (Embedding::persist format) in
+ * the cache directory, by default $XACC_ROOT/embedding-cache.
+ */
+class EmbeddingCache {
+
+public:
+  /**
+   * The Constructor
+   *
+   * @param directory The cache directory (created if needed). If empty,
+   * $XACC_ROOT/embedding-cache is used.
+   */
+  EmbeddingCache(const std::string &directory = "");
+
+  /**
+   * Return the cache key of a problem/hardware graph pair.
+   *
+   * The fingerprint is a hash of the number of vertices and of
+   * the sorted edge list of each graph, hence it does not depend on the
+   * order the edges were added. Vertex labels are significant (the
+   * embedding maps problem vertex indices to hardware vertex indices).
+   */
+  static std::string fingerprint(std::shared_ptr<Graph> problem,
+                                 std::shared_ptr<Graph> hardware);
+
+  /**
+   * Load the embedding cached for the given key.
+   *
+   * @return false if there is no (readable) cached embedding.
+   */
+  bool get(const std::string &key, Embedding &embedding) const;
+
+  /**
+   * Store the embedding for the given key, replacing any existing entry.
+   */
+  void put(const std::string &key, const Embedding &embedding) const;
+
+  /**
+   * Return the cached embedding of the problem into the hardware graph if
+   * any (and still valid), otherwise run the embedding algorithm with
+   * nSeeds different random seeds in parallel, cache and return the
+   * embedding with the shortest maximum chain length (ties are broken by
+   * the total number of hardware qubits).
+   *
+   * The seed is passed to the algorithm as the 'random_seed' parameter
+   * (consecutive seeds starting from params["random_seed"] if provided);
+   * 'failhard' is set to 'false' so that a failed seed is skipped.
+   * The searches run concurrently on the same algorithm instance, which
+   * must therefore be stateless (as are the 'cmr' and 'trivial' ones).
+   * Returns an empty embedding if all seeds fail.
+   */
+  Embedding embed(std::shared_ptr<EmbeddingAlgorithm> algorithm,
+                  std::shared_ptr<Graph> problem,
+                  std::shared_ptr<Graph> hardware, int nSeeds = 1,
+                  std::map<std::string, std::string> params =
+                      std::map<std::string, std::string>());
+
+  /**
+   * Return true if every problem vertex has a connected, non-overlapping
+   * chain of existing hardware vertices and every problem edge is
+   * covered by a hardware edge between the two chains.
+   */
+  static bool isValid(const Embedding &embedding,
+                      std::shared_ptr<Graph> problem,
+                      std::shared_ptr<Graph> hardware);
+
+  /**
+   * Return the maximum chain length of the embedding.
+   */
+  static int maxChainLength(const Embedding &embedding);
+
+  /**
+   * Number of embed() calls served from the cache.
+   */
+  int hits() const { return nHits; }
+
+protected:
+  std::string cacheDir;
+  int nHits = 0;
+  std::string filePath(const std::string &key) const;
+};
+
+} // namespace quantum
+} // namespace xacc
+
+#endif
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#include <gtest/gtest.h>
+#include "EmbeddingCache.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <atomic>
+#include <unistd.h>
+
+using namespace xacc::quantum;
+
+namespace {
+// Odd seeds find the direct embedding of an edge into a path,
+// even seeds a longer chain.
+class SeededEmbeddingAlgorithm : public EmbeddingAlgorithm {
+public:
+  std::atomic<int> nbCalls{0};
+  Embedding embed(std::shared_ptr<xacc::Graph> problem,
+                  std::shared_ptr<xacc::Graph> hardware,
+                  std::map<std::string, std::string> params) override {
+    nbCalls++;
+    Embedding embedding;
+    const auto seed = std::stoull(params["random_seed"]);
+    if (seed % 2) {
+      embedding.insert({0, {0}});
+      embedding.insert({1, {1}});
+    } else {
+      embedding.insert({0, {0, 1}});
+      embedding.insert({1, {2}});
+    }
+    return embedding;
+  }
+  const std::string name() const override { return "seeded"; }
+  const std::string description() const override { return ""; }
+};
+
+std::shared_ptr<xacc::Graph> makeGraph(int n,
+                                       std::vector<std::pair<int, int>> edges) {
+  auto graph = xacc::getService<xacc::Graph>("boost-ugraph");
+  for (int i = 0; i < n; i++) {
+    graph->addVertex();
+  }
+  for (auto &e : edges) {
+    graph->addEdge(e.first, e.second);
+  }
+  return graph;
+}
+
+std::string tmpCacheDir() {
+  const char *tmpDir = std::getenv("TMPDIR");
+  return std::string(tmpDir ? tmpDir : "/tmp") + "/xacc-embedding-cache-" +
+         std::to_string(getpid());
+}
+} // namespace
+
+TEST(EmbeddingCacheTester, checkFingerprint) {
+  auto problem = makeGraph(3, {{0, 1}, {1, 2}});
+  auto hardware = makeGraph(4, {{0, 1}, {1, 2}, {2, 3}});
+  // Edge insertion order does not matter
+  auto hardware2 = makeGraph(4, {{2, 3}, {1, 0}, {1, 2}});
+  EXPECT_EQ(EmbeddingCache::fingerprint(problem, hardware),
+            EmbeddingCache::fingerprint(problem, hardware2));
+  // A missing hardware coupler does
+  auto hardware3 = makeGraph(4, {{0, 1}, {2, 3}});
+  EXPECT_NE(EmbeddingCache::fingerprint(problem, hardware),
+            EmbeddingCache::fingerprint(problem, hardware3));
+}
+
+TEST(EmbeddingCacheTester, checkIsValid) {
+  auto problem = makeGraph(2, {{0, 1}});
+  auto hardware = makeGraph(4, {{0, 1}, {1, 2}, {2, 3}});
+  Embedding good;
+  good.insert({0, {0, 1}});
+  good.insert({1, {2}});
+  EXPECT_TRUE(EmbeddingCache::isValid(good, problem, hardware));
+  EXPECT_EQ(2, EmbeddingCache::maxChainLength(good));
+  Embedding disconnected;
+  disconnected.insert({0, {0, 2}});
+  disconnected.insert({1, {3}});
+  EXPECT_FALSE(EmbeddingCache::isValid(disconnected, problem, hardware));
+  Embedding uncovered;
+  uncovered.insert({0, {0}});
+  uncovered.insert({1, {3}});
+  EXPECT_FALSE(EmbeddingCache::isValid(uncovered, problem, hardware));
+  Embedding overlapping;
+  overlapping.insert({0, {0, 1}});
+  overlapping.insert({1, {1}});
+  EXPECT_FALSE(EmbeddingCache::isValid(overlapping, problem, hardware));
+}
+
+TEST(EmbeddingCacheTester, checkMultiSeedAndCache) {
+  auto problem = makeGraph(2, {{0, 1}});
+  auto hardware = makeGraph(4, {{0, 1}, {1, 2}, {2, 3}});
+  auto algo = std::make_shared<SeededEmbeddingAlgorithm>();
+  const auto cacheDir = tmpCacheDir();
+  EmbeddingCache cache(cacheDir);
+
+  // Seeds 10, 11, 12, 13: the odd ones give the shortest chains.
+  auto embedding =
+      cache.embed(algo, problem, hardware, 4, {{"random_seed", "10"}});
+  EXPECT_EQ(4, algo->nbCalls);
+  EXPECT_EQ(1, EmbeddingCache::maxChainLength(embedding));
+  EXPECT_EQ(0, cache.hits());
+
+  // Served from disk, also by another cache instance.
+  EmbeddingCache otherCache(cacheDir);
+  auto cached = otherCache.embed(algo, problem, hardware, 4);
+  EXPECT_EQ(4, algo->nbCalls);
+  EXPECT_EQ(1, otherCache.hits());
+  EXPECT_TRUE(cached == embedding);
+
+  // A stale entry (e.g. broken hardware coupler) is recomputed.
+  const auto key = "seeded-" + EmbeddingCache::fingerprint(problem, hardware);
+  Embedding stale;
+  stale.insert({0, {0}});
+  stale.insert({1, {3}});
+  cache.put(key, stale);
+  embedding = cache.embed(algo, problem, hardware, 1, {{"random_seed", "1"}});
+  EXPECT_EQ(5, algo->nbCalls);
+  EXPECT_TRUE(EmbeddingCache::isValid(embedding, problem, hardware));
+  Embedding stored;
+  EXPECT_TRUE(cache.get(key, stored));
+  EXPECT_TRUE(stored == embedding);
+
+  std::remove((cacheDir + "/" + key + ".emb").c_str());
+  rmdir(cacheDir.c_str());
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
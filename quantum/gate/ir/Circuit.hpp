@@ -102,17 +102,11 @@ public:
   void setTag(const std::string &tag) override { return; }
 
   void mapBits(std::vector<std::size_t> bitMap) override {
-    InstructionIterator iter(shared_from_this());
-    while (iter.hasNext()) {
-      auto next = iter.next();
-      if (!next->isComposite()) {
-        next->mapBits(bitMap);
-      }
+    // Sub-composites map their own instructions: a block repeating its
+    // instructions (e.g. Pow-U) must only map them once.
+    for (auto &inst : instructions) {
+      inst->mapBits(bitMap);
     }
-
-    // for (auto &inst : instructions) {
-    // #  inst->mapBits(bitMap);
-    // }
   }
   void setBits(const std::vector<std::size_t> bits) override {}
   const std::vector<std::size_t> bits() override { return {}; }
@@ -32,8 +32,19 @@ Pulse::Pulse(std::string name, std::string channel, double phase,
 
 Pulse::Pulse(const Pulse &inst)
     : gateName(inst.gateName), ch(inst.ch), qbits(inst.qbits),
-      parameters(inst.parameters), enabled(inst.enabled), samples(inst.samples),
-      t0(inst.t0), _duration(inst._duration) {}
+      parameters(inst.parameters), enabled(inst.enabled),
+      waveform(std::atomic_load(&inst.waveform)), waveformKey(inst.waveformKey),
+      waveformGenerator(inst.waveformGenerator), t0(inst.t0),
+      _duration(inst._duration), pulseParameters(inst.pulseParameters) {}
+
+WaveformPtr Pulse::getWaveform() {
+  auto w = std::atomic_load(&waveform);
+  if (!w && waveformGenerator) {
+    w = WaveformLibrary::instance().evaluate(waveformKey, waveformGenerator);
+    std::atomic_store(&waveform, w);
+  }
+  return w;
+}
 
 const std::string Pulse::name() const { return gateName; }
 const std::string Pulse::description() const {
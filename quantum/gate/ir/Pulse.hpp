@@ -15,6 +15,7 @@
 
 #include "Instruction.hpp"
 #include "Cloneable.hpp"
+#include "Waveform.hpp"
 
 namespace xacc {
 namespace quantum {
@@ -31,7 +32,11 @@ protected:
   std::size_t t0 = 0;
   std::size_t _duration = 0;
 
-  std::vector<std::vector<double>> samples = {};
+  // Interned samples, shared with all pulses of the same shape.
+  // For parametric pulses, null until first accessed (see setWaveform).
+  WaveformPtr waveform;
+  std::string waveformKey;
+  std::function<Waveform()> waveformGenerator;
   HeterogeneousMap pulseParameters;
 public:
   Pulse();
@@ -59,10 +64,35 @@ public:
   std::size_t duration() override { return _duration; }
   void setDuration(const std::size_t d) override { _duration = d; }
   void setSamples(const std::vector<std::vector<double>> s) override {
-    samples = s;
-    _duration = samples.size();
+    setWaveform(WaveformLibrary::instance().intern(s));
+  }
+  // Note: returns a copy, use samples() for read-only access.
+  std::vector<std::vector<double>> getSamples() override {
+    return WaveformLibrary::toPairs(samples());
+  }
+  void setWaveform(WaveformPtr w) {
+    waveformGenerator = nullptr;
+    waveformKey.clear();
+    std::atomic_store(&waveform, w);
+    _duration = w ? w->size() : 0;
+  }
+  // Parametric waveform of nbSamples samples, generated on first access
+  // and cached by key in the WaveformLibrary.
+  void setWaveform(const std::string &key, std::function<Waveform()> generator,
+                   std::size_t nbSamples) {
+    std::atomic_store(&waveform, WaveformPtr());
+    waveformKey = key;
+    waveformGenerator = std::move(generator);
+    _duration = nbSamples;
+  }
+  WaveformPtr getWaveform();
+  // Zero-copy view of the samples (empty if the pulse has none), valid
+  // until the waveform of this pulse is changed.
+  const Waveform &samples() {
+    static const Waveform empty;
+    auto w = getWaveform();
+    return w ? *w : empty;
   }
-  std::vector<std::vector<double>> getSamples() override { return samples; }
   void setPulseParams(const HeterogeneousMap &in_pulseParams) override {
     pulseParameters = in_pulseParams;
   }
@@ -110,7 +140,9 @@ public:
 
   std::shared_ptr<Instruction> clone() override {
     auto inst = std::make_shared<Pulse>(gateName, ch, parameters[0], qbits);
-    inst->setSamples(samples);
+    inst->waveform = std::atomic_load(&waveform);
+    inst->waveformKey = waveformKey;
+    inst->waveformGenerator = waveformGenerator;
     inst->setStart(t0);
     inst->setDuration(_duration);
     inst->setPulseParams(pulseParameters);
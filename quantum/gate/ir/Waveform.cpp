@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "Waveform.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace xacc {
+namespace quantum {
+WaveformLibrary &WaveformLibrary::instance() {
+  static WaveformLibrary library;
+  return library;
+}
+
+std::uint64_t WaveformLibrary::hash(const Waveform &samples) {
+  // FNV-1a over the raw sample bytes
+  std::uint64_t result = 14695981039346656037ULL;
+  const auto *bytes = reinterpret_cast<const unsigned char *>(samples.data());
+  const auto nbBytes = samples.size() * sizeof(std::complex<double>);
+  for (std::size_t i = 0; i < nbBytes; ++i) {
+    result ^= bytes[i];
+    result *= 1099511628211ULL;
+  }
+  return result ^ samples.size();
+}
+
+std::vector<std::vector<double>>
+WaveformLibrary::toPairs(const Waveform &samples) {
+  std::vector<std::vector<double>> result;
+  result.reserve(samples.size());
+  for (const auto &sample : samples) {
+    result.emplace_back(std::vector<double>{sample.real(), sample.imag()});
+  }
+  return result;
+}
+
+WaveformPtr WaveformLibrary::intern(Waveform samples) {
+  const auto key = hash(samples);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto range = m_byContent.equal_range(key);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    auto existing = iter->second.lock();
+    if (existing && *existing == samples) {
+      return existing;
+    }
+  }
+  auto waveform = std::make_shared<const Waveform>(std::move(samples));
+  m_byContent.emplace(key, waveform);
+  prune();
+  return waveform;
+}
+
+WaveformPtr
+WaveformLibrary::intern(const std::vector<std::vector<double>> &samples) {
+  Waveform waveform;
+  waveform.reserve(samples.size());
+  for (const auto &sample : samples) {
+    waveform.emplace_back(sample.empty() ? 0.0 : sample[0],
+                          sample.size() > 1 ? sample[1] : 0.0);
+  }
+  return intern(std::move(waveform));
+}
+
+WaveformPtr
+WaveformLibrary::evaluate(const std::string &key,
+                          const std::function<Waveform()> &generator) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_byKey.find(key);
+    if (iter != m_byKey.end()) {
+      if (auto existing = iter->second.lock()) {
+        return existing;
+      }
+    }
+  }
+  // Not holding the lock while generating: concurrent evaluations of the
+  // same key are resolved by interning.
+  auto waveform = intern(generator());
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_byKey[key] = waveform;
+  return waveform;
+}
+
+std::size_t WaveformLibrary::size() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::size_t count = 0;
+  for (const auto &entry : m_byContent) {
+    if (!entry.second.expired()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void WaveformLibrary::prune() {
+  if (m_byContent.size() + m_byKey.size() < m_pruneThreshold) {
+    return;
+  }
+  for (auto iter = m_byContent.begin(); iter != m_byContent.end();) {
+    iter = iter->second.expired() ? m_byContent.erase(iter) : std::next(iter);
+  }
+  for (auto iter = m_byKey.begin(); iter != m_byKey.end();) {
+    iter = iter->second.expired() ? m_byKey.erase(iter) : std::next(iter);
+  }
+  m_pruneThreshold =
+      std::max<std::size_t>(64, 2 * (m_byContent.size() + m_byKey.size()));
+}
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#ifndef QUANTUM_PULSE_IR_WAVEFORM_HPP_
+#define QUANTUM_PULSE_IR_WAVEFORM_HPP_
+
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xacc {
+namespace quantum {
+// Samples of a pulse shape (contiguous, immutable once interned).
+using Waveform = std::vector<std::complex<double>>;
+using WaveformPtr = std::shared_ptr<const Waveform>;
+
+// Process-wide library of pulse waveforms.
+//
+// Waveforms are interned by content: all pulses with the same samples share
+// a single array, whatever the way they were created (parsed from a backend
+// pulse library, a QObj, generated by an optimizer, etc.). Parametric
+// waveforms are generated once per key (e.g. shape name and parameters).
+//
+// The library only keeps weak references, hence a waveform is freed with
+// the last pulse using it: memory scales with the number of unique shapes,
+// not with the number of pulse instructions.
+class WaveformLibrary {
+public:
+  static WaveformLibrary &instance();
+
+  // Return the shared waveform with these samples.
+  WaveformPtr intern(Waveform samples);
+  // Samples as [real, imag] pairs (a missing imaginary part is 0.0).
+  WaveformPtr intern(const std::vector<std::vector<double>> &samples);
+
+  // Return the waveform of the given key, calling the generator
+  // only if it is not alive already.
+  WaveformPtr evaluate(const std::string &key,
+                       const std::function<Waveform()> &generator);
+
+  // Number of unique waveforms currently alive.
+  std::size_t size();
+
+  static std::uint64_t hash(const Waveform &samples);
+  static std::vector<std::vector<double>> toPairs(const Waveform &samples);
+
+private:
+  WaveformLibrary() = default;
+  void prune();
+
+  std::mutex m_mutex;
+  std::unordered_multimap<std::uint64_t, std::weak_ptr<const Waveform>>
+      m_byContent;
+  std::unordered_map<std::string, std::weak_ptr<const Waveform>> m_byKey;
+  // Expired entries are swept when the tables double in size.
+  std::size_t m_pruneThreshold = 64;
+};
+} // namespace quantum
+} // namespace xacc
+#endif
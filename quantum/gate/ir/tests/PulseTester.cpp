@@ -19,6 +19,7 @@
 #include "xacc_config.hpp"
 #include "xacc_service.hpp"
 #include "Utils.hpp"
+#include "Pulse.hpp"
 
 TEST(PulseTester, checkBasic) {
   // TODO load from json file prototypical pulses and cmd_defs...
@@ -90,6 +91,48 @@ TEST(PulseTester, checkBasic) {
     }
   }
 }
+TEST(PulseTester, checkWaveformInterning) {
+  using namespace xacc::quantum;
+  auto &library = WaveformLibrary::instance();
+  const auto nbAlive = library.size();
+  const std::vector<std::vector<double>> gaussian{
+      {0.1, 0.0}, {0.5, 0.01}, {1.0, 0.02}, {0.5, 0.01}, {0.1, 0.0}};
+  {
+    // Same shape: one waveform shared by all pulses and clones
+    std::vector<std::shared_ptr<xacc::Instruction>> pulses;
+    for (int i = 0; i < 1000; ++i) {
+      auto pulse = std::make_shared<Pulse>("gaussian", "d0");
+      pulse->setSamples(gaussian);
+      pulses.emplace_back(pulse);
+      pulses.emplace_back(pulse->clone());
+    }
+    EXPECT_EQ(nbAlive + 1, library.size());
+    auto first = std::dynamic_pointer_cast<Pulse>(pulses.front());
+    auto last = std::dynamic_pointer_cast<Pulse>(pulses.back());
+    EXPECT_EQ(first->samples().data(), last->samples().data());
+    EXPECT_EQ(gaussian, last->getSamples());
+    EXPECT_EQ(5, last->duration());
+  }
+  // Freed with the last pulse
+  EXPECT_EQ(nbAlive, library.size());
+
+  // Parametric waveform: generated once, on first access
+  int nbEvaluations = 0;
+  const auto generator = [&]() {
+    ++nbEvaluations;
+    return Waveform(8, std::complex<double>(0.5, 0.0));
+  };
+  auto p1 = std::make_shared<Pulse>("square", "d0");
+  auto p2 = std::make_shared<Pulse>("square", "d1");
+  p1->setWaveform("square:8:0.5", generator, 8);
+  p2->setWaveform("square:8:0.5", generator, 8);
+  EXPECT_EQ(8, p1->duration());
+  EXPECT_EQ(0, nbEvaluations);
+  EXPECT_EQ(8, p1->samples().size());
+  EXPECT_EQ(p1->samples().data(), p2->samples().data());
+  EXPECT_EQ(1, nbEvaluations);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
   ::testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,7 @@
 #include "GateFusion.hpp"
 #include <numeric>
+#include <set>
+#include <sstream>
 namespace {
     const std::complex<double> I(0.0, 1.0);
     Eigen::MatrixXcd Xmat = [] {
@@ -286,5 +288,142 @@ void GateFuser::visit(IfStmt& ifStmt)
 {
     xacc::error("Unsupported!");
 }
+
+WindowedGateFuser::WindowedGateFuser(size_t in_maxQubits, BlockHandler in_handler, size_t in_maxCacheSize):
+    m_maxQubits(in_maxQubits),
+    m_handler(std::move(in_handler)),
+    m_maxCacheSize(in_maxCacheSize)
+{
+    if (m_maxQubits < MIN_BLOCK_QUBITS || m_maxQubits > MAX_BLOCK_QUBITS)
+    {
+        xacc::error("Invalid gate fusion block size " + std::to_string(m_maxQubits) + 
+                    " (must be in [" + std::to_string(MIN_BLOCK_QUBITS) + ", " + std::to_string(MAX_BLOCK_QUBITS) + "]).");
+    }
+}
+
+bool WindowedGateFuser::isFusible(const std::shared_ptr<xacc::Instruction>& in_inst)
+{
+    static const std::set<std::string> FUSIBLE_GATES {
+        "H", "CNOT", "Rz", "Ry", "Rx", "X", "Y", "Z", "CY", "CZ", "Swap",
+        "CRZ", "CH", "S", "Sdg", "T", "Tdg", "CPhase", "I", "U" };
+    if (in_inst->isComposite() || FUSIBLE_GATES.find(in_inst->name()) == FUSIBLE_GATES.end())
+    {
+        return false;
+    }
+    // Symbolic parameters cannot be evaluated.
+    for (const auto& param : in_inst->getParameters())
+    {
+        if (!param.isNumeric())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WindowedGateFuser::add(const std::shared_ptr<xacc::Instruction>& in_inst)
+{
+    if (!isFusible(in_inst))
+    {
+        flush();
+        return false;
+    }
+
+    std::vector<size_t> newQubits = m_windowQubits;
+    for (const auto& bit : in_inst->bits())
+    {
+        const auto pos = std::lower_bound(newQubits.begin(), newQubits.end(), bit);
+        if (pos == newQubits.end() || *pos != bit)
+        {
+            newQubits.insert(pos, bit);
+        }
+    }
+    if (newQubits.size() > m_maxQubits)
+    {
+        // Start a new window with this gate.
+        flush();
+        newQubits = in_inst->bits();
+        std::sort(newQubits.begin(), newQubits.end());
+    }
+    m_window.emplace_back(in_inst);
+    m_windowQubits = std::move(newQubits);
+    return true;
+}
+
+void WindowedGateFuser::flush()
+{
+    if (m_window.empty())
+    {
+        return;
+    }
+    FusedGateBlock block;
+    block.qubits = m_windowQubits;
+    block.matrix = blockMatrix(m_windowQubits);
+    block.nbGates = m_window.size();
+    m_nbGates += m_window.size();
+    ++m_nbBlocks;
+    m_window.clear();
+    m_windowQubits.clear();
+    m_handler(block);
+}
+
+std::shared_ptr<const Eigen::MatrixXcd> WindowedGateFuser::blockMatrix(const std::vector<size_t>& in_qubits)
+{
+    const auto localIdx = [&](size_t in_bit) -> size_t {
+        return std::lower_bound(in_qubits.begin(), in_qubits.end(), in_bit) - in_qubits.begin();
+    };
+    // Exact description of the gates, on block-local qubits.
+    std::stringstream ss;
+    ss << std::hexfloat << in_qubits.size() << ":";
+    for (const auto& inst : m_window)
+    {
+        ss << inst->name();
+        for (const auto& param : inst->getParameters())
+        {
+            ss << " " << InstructionParameterToDouble(param);
+        }
+        for (const auto& bit : inst->bits())
+        {
+            ss << " q" << localIdx(bit);
+        }
+        ss << ";";
+    }
+    const auto key = ss.str();
+    auto iter = m_cache.find(key);
+    if (iter != m_cache.end())
+    {
+        ++m_cacheHits;
+        return iter->second;
+    }
+
+    ++m_cacheMisses;
+    auto localComposite = xacc::getIRProvider("quantum")->createComposite("__fused_block__");
+    for (const auto& inst : m_window)
+    {
+        std::vector<size_t> localBits;
+        for (const auto& bit : inst->bits())
+        {
+            localBits.emplace_back(localIdx(bit));
+        }
+        auto localInst = inst->clone();
+        localInst->setBits(localBits);
+        localComposite->addInstruction(localInst);
+    }
+    auto matrix = std::make_shared<const Eigen::MatrixXcd>(GateFuser::fuseGates(localComposite, in_qubits.size()));
+    if (m_cache.size() >= m_maxCacheSize)
+    {
+        m_cache.clear();
+    }
+    m_cache.emplace(key, matrix);
+    return matrix;
+}
+
+void WindowedGateFuser::resetStatistics()
+{
+    m_nbGates = 0;
+    m_nbBlocks = 0;
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+}
 } // namespace quantum
 } // namespace xacc
@@ -2,6 +2,8 @@
 #include <Eigen/Dense>
 #include "xacc.hpp"
 #include "AllGateVisitor.hpp"
+#include <functional>
+#include <unordered_map>
 
 // Implement a simple Gate fusion procedure to compute the total unitary matrix for a given circuit (composite instruction)
 using namespace xacc;
@@ -53,9 +55,73 @@ public:
     void visit(U& u) override;
     void visit(IfStmt& ifStmt) override;
 private:
-    const std::shared_ptr<xacc::CompositeInstruction> &m_program;
+    const std::shared_ptr<xacc::CompositeInstruction> m_program;
     int m_dim;
     std::vector<FusionGateItem> m_gates;
 };
+
+// Block of consecutive gates fused into a single unitary.
+struct FusedGateBlock
+{
+    // Sorted qubit indices: qubits[l] is bit l of the matrix index.
+    std::vector<size_t> qubits;
+    // 2^n x 2^n unitary (shared with the matrix cache)
+    std::shared_ptr<const Eigen::MatrixXcd> matrix;
+    // Number of fused gates
+    size_t nbGates;
+};
+
+// Windowed gate fusion: greedily groups consecutive gates acting on at most
+// 'maxQubits' qubits (in total) into fused blocks, which are passed to the
+// block handler (e.g. the simulator kernel) as soon as they are complete.
+// Block matrices are cached by the sequence of gate names, parameter values
+// and (block-local) qubits, i.e. repeated layers of an ansatz with the same
+// parameters share the same matrix.
+// Usage:
+//   if (!fuser.add(inst)) { /* apply inst directly */ }
+//   ...
+//   fuser.flush(); // before using the state
+class WindowedGateFuser
+{
+public:
+    using BlockHandler = std::function<void(const FusedGateBlock&)>;
+    // Supported range of block sizes
+    static constexpr size_t MIN_BLOCK_QUBITS = 2;
+    static constexpr size_t MAX_BLOCK_QUBITS = 5;
+
+    WindowedGateFuser(size_t in_maxQubits, BlockHandler in_handler, size_t in_maxCacheSize = 1024);
+    // Adds a gate to the current window.
+    // Returns false if the instruction cannot be fused (composite, measure,
+    // non-unitary or unsupported gate): the pending block is then flushed
+    // and the caller must handle the instruction.
+    bool add(const std::shared_ptr<xacc::Instruction>& in_inst);
+    // Completes the pending block (if any).
+    void flush();
+    // True if the gate has a matrix representation in the GateFuser.
+    static bool isFusible(const std::shared_ptr<xacc::Instruction>& in_inst);
+
+    size_t maxQubits() const { return m_maxQubits; }
+    // Statistics
+    size_t nbGates() const { return m_nbGates; }
+    size_t nbBlocks() const { return m_nbBlocks; }
+    size_t cacheHits() const { return m_cacheHits; }
+    size_t cacheMisses() const { return m_cacheMisses; }
+    void resetStatistics();
+
+private:
+    std::shared_ptr<const Eigen::MatrixXcd> blockMatrix(const std::vector<size_t>& in_qubits);
+
+    size_t m_maxQubits;
+    BlockHandler m_handler;
+    size_t m_maxCacheSize;
+    // Pending block
+    std::vector<std::shared_ptr<xacc::Instruction>> m_window;
+    std::vector<size_t> m_windowQubits;
+    std::unordered_map<std::string, std::shared_ptr<const Eigen::MatrixXcd>> m_cache;
+    size_t m_nbGates = 0;
+    size_t m_nbBlocks = 0;
+    size_t m_cacheHits = 0;
+    size_t m_cacheMisses = 0;
+};
 } // namespace quantum
 } // namespace xacc
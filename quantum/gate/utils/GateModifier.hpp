@@ -8,11 +8,14 @@ namespace quantum {
 struct GateModifier {
   virtual std::shared_ptr<Instruction> getBaseInstruction() const = 0;
 };
-// We only have control modifier at the moment...
 struct ControlModifier : public GateModifier {
   // Returns list of qubits as <qreg name, index> pairs
   virtual std::vector<std::pair<std::string, size_t>>
   getControlQubits() const = 0;
 };
+// Base instruction repeated getPower() times (U^n)
+struct PowerModifier : public GateModifier {
+  virtual size_t getPower() const = 0;
+};
 } // namespace quantum
 } // namespace xacc
@@ -20,42 +20,47 @@ namespace quantum {
 
 void IRToGraphVisitor::addSingleQubitGate(Gate &inst) {
   auto bit = inst.bits()[0];
-  auto lastNode = qubitToLastNode[bit];
-  auto lastBit = lastNode.get<std::vector<std::size_t>>("bits")[0];
+  const auto lastNodeId = qubitToLastNode[bit].get(CircuitNodeKeys::ID);
 
   id++;
 
-  CircuitNode newNode{std::make_pair("name", inst.name()),
-                      std::make_pair("id", id),
-                      std::make_pair("bits", inst.bits())};
-
-  graph->addVertex(newNode);
-  graph->addEdge(lastNode.get<std::size_t>("id"),
-                 newNode.get<std::size_t>("id"), 1);
+  CircuitNode newNode = createNode(inst.name(), id, inst.bits());
+  graph->addVertex();
+  graph->addEdge(lastNodeId, id, 1);
   const int layerId = graph->depth();
-  graph->getVertexProperties(id).insert("layer", layerId);
+  newNode.set(CircuitNodeKeys::LAYER, layerId);
+  graph->getVertexProperties(id) = newNode;
 
-  qubitToLastNode[bit] = newNode;
+  qubitToLastNode[bit] = std::move(newNode);
 }
 
 void IRToGraphVisitor::addTwoQubitGate(Gate &inst) {
   auto srcbit = inst.bits()[0];
   auto tgtbit = inst.bits()[1];
 
-  auto lastsrcnodeid = qubitToLastNode[srcbit].get<std::size_t>("id");
-  auto lasttgtnodeid = qubitToLastNode[tgtbit].get<std::size_t>("id");
+  auto lastsrcnodeid = qubitToLastNode[srcbit].get(CircuitNodeKeys::ID);
+  auto lasttgtnodeid = qubitToLastNode[tgtbit].get(CircuitNodeKeys::ID);
 
   id++;
-  CircuitNode newNode{std::make_pair("name", inst.name()),
-                      std::make_pair("id", id),
-                      std::make_pair("bits", inst.bits())};
-  graph->addVertex(newNode);
+  CircuitNode newNode = createNode(inst.name(), id, inst.bits());
+  graph->addVertex();
   graph->addEdge(lastsrcnodeid, id, 1);
   graph->addEdge(lasttgtnodeid, id, 1);
-  const auto layerId = graph->depth();
-  graph->getVertexProperties(id).insert("layer", layerId);
+  const int layerId = graph->depth();
+  newNode.set(CircuitNodeKeys::LAYER, layerId);
+  graph->getVertexProperties(id) = newNode;
   qubitToLastNode[srcbit] = newNode;
-  qubitToLastNode[tgtbit] = newNode;
+  qubitToLastNode[tgtbit] = std::move(newNode);
+}
+
+CircuitNode IRToGraphVisitor::createNode(const std::string &name,
+                                         std::size_t nodeId,
+                                         const std::vector<std::size_t> &bits) {
+  CircuitNode node;
+  node.set(CircuitNodeKeys::NAME, name);
+  node.set(CircuitNodeKeys::ID, nodeId);
+  node.set(CircuitNodeKeys::BITS, bits);
+  return node;
 }
 
 IRToGraphVisitor::IRToGraphVisitor(const int nQubits) {
@@ -63,23 +68,23 @@ IRToGraphVisitor::IRToGraphVisitor(const int nQubits) {
       "boost-digraph"); // std::make_shared<DirectedBoostGraph>(nQubits);
   std::vector<std::size_t> allQbitIds(nQubits);
   std::iota(std::begin(allQbitIds), std::end(allQbitIds), 0);
-   CircuitNode initNode{std::make_pair("name", std::string("InitialState")),
-                      std::make_pair("id", id),
-                      std::make_pair("bits", allQbitIds)};
+  CircuitNode initNode = createNode("InitialState", id, allQbitIds);
   for (int i = 0; i < nQubits; i++) {
     qubitToLastNode[i] = initNode;
   }
-  graph->addVertex(initNode);
+  graph->addVertex();
+  graph->getVertexProperties(id) = std::move(initNode);
 }
 
 std::shared_ptr<Graph> IRToGraphVisitor::getGraph() {
-   CircuitNode finalNode{std::make_pair("name", std::string("FinalState")),
-                      std::make_pair("id", id+1),
-                      std::make_pair("bits", graph->getVertexProperties(0).get<std::vector<std::size_t>>("bits"))};
-  graph->addVertex(finalNode);
+  CircuitNode finalNode = createNode(
+      "FinalState", id + 1,
+      graph->getVertexProperties(0).get(CircuitNodeKeys::BITS));
+  graph->addVertex();
+  graph->getVertexProperties(id + 1) = finalNode;
 
   for (auto &kv : qubitToLastNode) {
-    graph->addEdge(kv.second.get<std::size_t>("id"), finalNode.get<std::size_t>("id"), 1.0);
+    graph->addEdge(kv.second.get(CircuitNodeKeys::ID), id + 1, 1.0);
   }
 
   return graph;
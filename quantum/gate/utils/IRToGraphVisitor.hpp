@@ -20,7 +20,15 @@
 namespace xacc {
 namespace quantum {
 
-using CircuitNode = HeterogeneousMap;
+// Circuit graph vertex properties
+using CircuitNode = PropertyStore;
+namespace CircuitNodeKeys {
+inline const PropertyKey<std::string> NAME("name");
+// Vertex index, i.e. instruction index + 1 (0 is the initial state node)
+inline const PropertyKey<std::size_t> ID("id");
+inline const PropertyKey<std::vector<std::size_t>> BITS("bits");
+inline const PropertyKey<int> LAYER("layer");
+} // namespace CircuitNodeKeys
 
 class IRToGraphVisitor : public AllGateVisitor {
 
@@ -33,6 +41,8 @@ protected:
 
   void addSingleQubitGate(Gate &inst);
   void addTwoQubitGate(Gate &inst);
+  static CircuitNode createNode(const std::string &name, std::size_t nodeId,
+                                const std::vector<std::size_t> &bits);
 
 public:
   IRToGraphVisitor(const int nQubits);
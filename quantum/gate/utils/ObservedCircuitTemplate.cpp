@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#include "ObservedCircuitTemplate.hpp"
+#include "Circuit.hpp"
+#include "InstructionIterator.hpp"
+#include "expression_parsing_util.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <algorithm>
+#include <cmath>
+#include <regex>
+
+namespace {
+bool isMeasure(const xacc::InstPtr &in_inst) {
+  return in_inst->name() == "Measure";
+}
+
+double evaluateAffine(double in_constant,
+                      const std::vector<std::pair<size_t, double>> &in_terms,
+                      const std::vector<double> &in_params) {
+  double result = in_constant;
+  for (const auto &[varIdx, coeff] : in_terms) {
+    result += coeff * in_params[varIdx];
+  }
+  return result;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+ObservedCircuitTemplate::ObservedCircuitTemplate(
+    std::shared_ptr<CompositeInstruction> in_ansatz,
+    const std::vector<std::shared_ptr<CompositeInstruction>> &in_observed)
+    : m_variables(in_ansatz->getVariables()),
+      m_parsingUtil(xacc::getService<ExpressionParsingUtil>("exprtk")) {
+  // The ansatz is flattened (and its parameterized gates cloned) only once,
+  // all the observed circuits share the same instructions.
+  std::vector<InstPtr> ansatzInsts;
+  flatten(in_ansatz, ansatzInsts);
+  const bool ansatzHasMeasurements =
+      std::any_of(ansatzInsts.begin(), ansatzInsts.end(), isMeasure);
+
+  m_composites.reserve(in_observed.size());
+  m_hasMeasurements.reserve(in_observed.size());
+  for (auto &observed : in_observed) {
+    std::vector<InstPtr> insts;
+    bool hasMeasurements = false;
+    for (auto &inst : observed->getInstructions()) {
+      if (inst->isComposite()) {
+        if (inst->name() == in_ansatz->name()) {
+          // Observable::observe() adds a copy of the ansatz.
+          insts.insert(insts.end(), ansatzInsts.begin(), ansatzInsts.end());
+          hasMeasurements = hasMeasurements || ansatzHasMeasurements;
+        } else {
+          const auto begin = insts.size();
+          flatten(std::dynamic_pointer_cast<CompositeInstruction>(inst), insts);
+          hasMeasurements =
+              hasMeasurements ||
+              std::any_of(insts.begin() + begin, insts.end(), isMeasure);
+        }
+      } else {
+        insts.emplace_back(bindable(inst));
+        hasMeasurements = hasMeasurements || isMeasure(inst);
+      }
+    }
+
+    auto composite = std::make_shared<Circuit>(observed->name());
+    composite->setCoefficient(observed->getCoefficient());
+    // The shared instructions can appear several times (e.g. the ansatz
+    // instructions if it repeats a sub-circuit), skip the validation.
+    composite->addInstructions(std::move(insts), false);
+    m_composites.emplace_back(composite);
+    m_hasMeasurements.emplace_back(hasMeasurements);
+  }
+  m_values.resize(m_expressions.size(), 0.0);
+}
+
+const std::vector<std::shared_ptr<CompositeInstruction>> &
+ObservedCircuitTemplate::bind(const std::vector<double> &in_params) {
+  if (in_params.size() != m_variables.size()) {
+    xacc::error("Invalid circuit template binding: number of parameters "
+                "don't match. " +
+                std::to_string(in_params.size()) + ", " +
+                std::to_string(m_variables.size()));
+  }
+
+  for (size_t i = 0; i < m_expressions.size(); ++i) {
+    const auto &expression = m_expressions[i];
+    m_values[i] =
+        expression.affine
+            ? evaluateAffine(expression.constant, expression.terms, in_params)
+            : evaluate(expression.expr, in_params);
+  }
+
+  for (auto &binding : m_bindings) {
+    binding.inst->setParameter(binding.paramIdx, m_values[binding.exprIdx]);
+  }
+  return m_composites;
+}
+
+size_t ObservedCircuitTemplate::nAffineExpressions() const {
+  return std::count_if(m_expressions.begin(), m_expressions.end(),
+                       [](const Expression &e) { return e.affine; });
+}
+
+void ObservedCircuitTemplate::flatten(
+    std::shared_ptr<CompositeInstruction> in_composite,
+    std::vector<InstPtr> &out_insts) {
+  InstructionIterator iter(in_composite);
+  while (iter.hasNext()) {
+    auto inst = iter.next();
+    if (!inst->isComposite()) {
+      out_insts.emplace_back(bindable(inst));
+    }
+  }
+}
+
+InstPtr ObservedCircuitTemplate::bindable(InstPtr in_inst) {
+  if (!in_inst->isParameterized()) {
+    return in_inst;
+  }
+
+  std::vector<std::pair<int, size_t>> variableParams;
+  for (int i = 0; i < in_inst->nParameters(); ++i) {
+    const auto param = in_inst->getParameter(i);
+    if (param.isVariable()) {
+      variableParams.emplace_back(i, compile(param.toString()));
+    }
+  }
+  if (variableParams.empty()) {
+    return in_inst;
+  }
+
+  // The clone keeps the bits and buffer names, only the variable parameters
+  // are replaced (by a placeholder until the first bind()).
+  auto bound = in_inst->clone();
+  for (const auto &[paramIdx, exprIdx] : variableParams) {
+    bound->setParameter(paramIdx, 0.0);
+    m_bindings.emplace_back(Binding{bound, paramIdx, exprIdx});
+  }
+  return bound;
+}
+
+size_t ObservedCircuitTemplate::compile(const std::string &in_expr) {
+  const auto iter = m_exprIdx.find(in_expr);
+  if (iter != m_exprIdx.end()) {
+    return iter->second;
+  }
+
+  Expression expression{in_expr, true, 0.0, {}};
+  std::vector<double> probe(m_variables.size(), 0.0);
+  expression.constant = evaluate(in_expr, probe);
+
+  // Affine coefficients of the variables that appear in the expression:
+  // f(e_j) - f(0)
+  static const std::regex identifier("[A-Za-z_][A-Za-z0-9_]*");
+  std::vector<size_t> varIdxs;
+  for (auto it = std::sregex_iterator(in_expr.begin(), in_expr.end(),
+                                      identifier);
+       it != std::sregex_iterator(); ++it) {
+    const auto varIter =
+        std::find(m_variables.begin(), m_variables.end(), it->str());
+    if (varIter != m_variables.end()) {
+      const size_t varIdx = std::distance(m_variables.begin(), varIter);
+      if (std::find(varIdxs.begin(), varIdxs.end(), varIdx) == varIdxs.end()) {
+        varIdxs.emplace_back(varIdx);
+      }
+    }
+  }
+  for (const auto &varIdx : varIdxs) {
+    probe[varIdx] = 1.0;
+    const double coeff = evaluate(in_expr, probe) - expression.constant;
+    probe[varIdx] = 0.0;
+    if (coeff != 0.0) {
+      expression.terms.emplace_back(varIdx, coeff);
+    }
+  }
+
+  // Validate the affine model at generic points (all variables set),
+  // otherwise, e.g. sin(theta), evaluate the expression on each bind.
+  // Expressions singular at the zero probe, e.g. 1/theta or log(theta), have
+  // a non-finite constant or coefficients (and NaN fails every comparison).
+  expression.affine =
+      std::isfinite(expression.constant) &&
+      std::all_of(expression.terms.begin(), expression.terms.end(),
+                  [](const std::pair<size_t, double> &term) {
+                    return std::isfinite(term.second);
+                  });
+  for (const double scale : {0.3711, -1.2173}) {
+    if (!expression.affine) {
+      break;
+    }
+    for (size_t i = 0; i < probe.size(); ++i) {
+      probe[i] = scale * (1.0 + 0.1 * i);
+    }
+    const double exact = evaluate(in_expr, probe);
+    const double affine =
+        evaluateAffine(expression.constant, expression.terms, probe);
+    if (!(std::abs(exact - affine) <= 1e-9 * (1.0 + std::abs(exact)))) {
+      expression.affine = false;
+    }
+  }
+  if (!expression.affine) {
+    expression.terms.clear();
+  }
+
+  m_expressions.emplace_back(std::move(expression));
+  m_exprIdx.emplace(in_expr, m_expressions.size() - 1);
+  return m_expressions.size() - 1;
+}
+
+double ObservedCircuitTemplate::evaluate(const std::string &in_expr,
+                                         const std::vector<double> &in_params) {
+  double val = 0.0;
+  if (!m_parsingUtil->evaluate(in_expr, m_variables, in_params, val)) {
+    xacc::error("Invalid circuit template parameter expression: " + in_expr);
+  }
+  return val;
+}
+} // namespace quantum
+} // namespace xacc
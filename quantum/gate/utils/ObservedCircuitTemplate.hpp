@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xacc {
+class Instruction;
+class CompositeInstruction;
+class ExpressionParsingUtil;
+namespace quantum {
+// Observed circuits (ansatz + basis change + measurements) that are built
+// once with symbolic parameters and re-used across the iterations of a
+// variational algorithm.
+//
+// The template is constructed from the *unevaluated* ansatz and the
+// result of Observable::observe() on it. Each observed circuit is flattened:
+// - the non-parameterized gates are shared with the ansatz/observed circuits;
+// - the gates with variable parameters are cloned once and owned by the
+// template. The ansatz gates are shared by all the observed circuits, hence
+// they are bound once per parameter set, not once per term.
+// bind() then only updates the parameters of the owned gates in place, i.e.
+// no circuit is created or cloned per iteration.
+//
+// Parameter expressions are compiled once: affine expressions (e.g. 'theta',
+// '-2*theta + 0.5', 'beta0 + beta1') are evaluated as a sparse dot product,
+// the others fall back to the ExpressionParsingUtil.
+//
+// Note: the returned composites are updated by subsequent bind() calls,
+// hence they must not be modified (or retained) by the caller.
+class ObservedCircuitTemplate {
+public:
+  ObservedCircuitTemplate(
+      std::shared_ptr<CompositeInstruction> in_ansatz,
+      const std::vector<std::shared_ptr<CompositeInstruction>> &in_observed);
+
+  // Binds the parameters of all the circuits and returns them.
+  const std::vector<std::shared_ptr<CompositeInstruction>> &
+  bind(const std::vector<double> &in_params);
+  const std::vector<std::shared_ptr<CompositeInstruction>> &
+  getComposites() const {
+    return m_composites;
+  }
+  // Circuits without measurements are the identity terms of the observable.
+  bool hasMeasurements(size_t in_idx) const { return m_hasMeasurements[in_idx]; }
+  size_t nVariables() const { return m_variables.size(); }
+  // Number of (unique) parameter expressions and how many are affine.
+  size_t nExpressions() const { return m_expressions.size(); }
+  size_t nAffineExpressions() const;
+  // Number of gate parameters updated by each bind() call.
+  size_t nBindings() const { return m_bindings.size(); }
+
+private:
+  struct Expression {
+    std::string expr;
+    bool affine;
+    double constant;
+    // (variable index, coefficient)
+    std::vector<std::pair<size_t, double>> terms;
+  };
+  struct Binding {
+    std::shared_ptr<Instruction> inst;
+    int paramIdx;
+    size_t exprIdx;
+  };
+
+  // Appends the flattened instructions of in_composite to out_insts,
+  // cloning (and registering the bindings of) the parameterized gates.
+  void flatten(std::shared_ptr<CompositeInstruction> in_composite,
+               std::vector<std::shared_ptr<Instruction>> &out_insts);
+  std::shared_ptr<Instruction> bindable(std::shared_ptr<Instruction> in_inst);
+  size_t compile(const std::string &in_expr);
+  double evaluate(const std::string &in_expr,
+                  const std::vector<double> &in_params);
+
+  std::vector<std::string> m_variables;
+  std::shared_ptr<ExpressionParsingUtil> m_parsingUtil;
+  std::vector<std::shared_ptr<CompositeInstruction>> m_composites;
+  std::vector<bool> m_hasMeasurements;
+  std::vector<Expression> m_expressions;
+  std::unordered_map<std::string, size_t> m_exprIdx;
+  std::vector<Binding> m_bindings;
+  std::vector<double> m_values;
+};
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#include "PrefixTrie.hpp"
+#include "CompositeInstruction.hpp"
+#include "InstructionIterator.hpp"
+#include <limits>
+#include <unordered_map>
+
+namespace {
+void hashCombine(std::size_t &io_seed, std::size_t in_hash) {
+  io_seed ^= in_hash + 0x9e3779b97f4a7c15ULL + (io_seed << 6) + (io_seed >> 2);
+}
+
+// Gate key: name, qubits and (bound) parameters.
+std::size_t hashGate(const xacc::InstPtr &in_inst) {
+  std::size_t seed = std::hash<std::string>{}(in_inst->name());
+  for (const auto &bit : in_inst->bits()) {
+    hashCombine(seed, std::hash<std::size_t>{}(bit));
+  }
+  for (const auto &param : in_inst->getParameters()) {
+    hashCombine(seed, std::hash<std::string>{}(param.toString()));
+  }
+  return seed;
+}
+
+bool isSameGate(const xacc::InstPtr &in_a, const xacc::InstPtr &in_b) {
+  return (in_a->name() == in_b->name()) && (in_a->bits() == in_b->bits()) &&
+         (in_a->getParameters() == in_b->getParameters());
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+PrefixTrie::PrefixTrie(
+    const std::vector<std::shared_ptr<CompositeInstruction>> &in_circuits) {
+  m_nodes.push_back(Node{nullptr, 0, {}, {}});
+  m_measuredBits.resize(in_circuits.size());
+  // Edges: hash of (parent node, gate) -> child nodes
+  std::unordered_multimap<std::size_t, std::size_t> edges;
+  for (std::size_t circuitIdx = 0; circuitIdx < in_circuits.size();
+       ++circuitIdx) {
+    std::size_t nodeIdx = 0;
+    InstructionIterator it(in_circuits[circuitIdx]);
+    while (it.hasNext()) {
+      auto nextInst = it.next();
+      if (!nextInst->isEnabled() || nextInst->isComposite()) {
+        continue;
+      }
+      if (nextInst->name() == "Measure") {
+        m_measuredBits[circuitIdx].emplace_back(nextInst->bits()[0]);
+        continue;
+      }
+
+      m_nbGates++;
+      std::size_t key = std::hash<std::size_t>{}(nodeIdx);
+      hashCombine(key, hashGate(nextInst));
+      std::size_t childIdx = std::numeric_limits<std::size_t>::max();
+      const auto range = edges.equal_range(key);
+      for (auto edgeIt = range.first; edgeIt != range.second; ++edgeIt) {
+        const auto &child = m_nodes[edgeIt->second];
+        if (child.parent == nodeIdx && isSameGate(child.gate, nextInst)) {
+          childIdx = edgeIt->second;
+          break;
+        }
+      }
+      if (childIdx == std::numeric_limits<std::size_t>::max()) {
+        childIdx = m_nodes.size();
+        m_nodes.push_back(Node{nextInst, nodeIdx, {}, {}});
+        m_nodes[nodeIdx].children.emplace_back(childIdx);
+        edges.emplace(key, childIdx);
+      }
+      nodeIdx = childIdx;
+    }
+    m_nodes[nodeIdx].circuits.emplace_back(circuitIdx);
+  }
+}
+
+std::size_t PrefixTrie::checkpointBudget(std::size_t in_memoryMb,
+                                         std::size_t in_stateBytes) {
+  if (in_stateBytes == 0) {
+    return 0;
+  }
+  const std::size_t memoryBytes = in_memoryMb << 20;
+  return memoryBytes / in_stateBytes;
+}
+
+std::size_t PrefixTrie::collectSegment(std::size_t in_nodeIdx,
+                                       std::vector<InstPtr> &out_gates) const {
+  std::size_t nodeIdx = in_nodeIdx;
+  out_gates.emplace_back(m_nodes[nodeIdx].gate);
+  while (m_nodes[nodeIdx].children.size() == 1 &&
+         m_nodes[nodeIdx].circuits.empty()) {
+    nodeIdx = m_nodes[nodeIdx].children[0];
+    out_gates.emplace_back(m_nodes[nodeIdx].gate);
+  }
+  return nodeIdx;
+}
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,235 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace xacc {
+class Instruction;
+class CompositeInstruction;
+using InstPtr = std::shared_ptr<Instruction>;
+namespace quantum {
+// Prefix-sharing execution of a batch of (observed) circuits.
+//
+// The gate sequences of the circuits (flattened, enabled instructions, Measure
+// excluded) are inserted into a trie, keyed by a hash of the gate name, qubits
+// and bound parameters. Any two circuits of the batch share the trie nodes of
+// their common prefix (e.g. the ansatz of the observed circuits, or the gates
+// before a shifted parameter of a gradient circuit), hence each node is
+// simulated once rather than once per circuit.
+//
+// The trie is executed depth-first. At a branch point, the state is kept as a
+// checkpoint for the next siblings; the last child takes over the checkpoint,
+// i.e. it is dropped as soon as the traversal enters its last subtree. The
+// number of live checkpoints is bounded by the budget: past the budget, the
+// state of a branch point is not kept, and the next siblings recompute it from
+// the nearest ancestor checkpoint (or from the initial state).
+// Besides the checkpoints, only one working state is alive.
+//
+// The executor is simulator-agnostic; backends provide the state operations.
+class PrefixTrie {
+public:
+  template <typename StateType> struct Backend {
+    // The initial (all zeros) state.
+    std::function<StateType()> init;
+    // Apply a sequence of gates (no Measure).
+    std::function<void(StateType &, const std::vector<InstPtr> &)> apply;
+    std::function<StateType(const StateType &)> copy;
+  };
+
+  struct Stats {
+    // Number of gates applied (the trie size if no state is recomputed).
+    std::size_t nbAppliedGates = 0;
+    // Number of checkpoint copies.
+    std::size_t nbCheckpoints = 0;
+    // Max. number of simultaneously live checkpoints.
+    std::size_t peakCheckpoints = 0;
+    // Number of branch states recomputed (over budget).
+    std::size_t nbRecomputes = 0;
+  };
+
+  PrefixTrie(
+      const std::vector<std::shared_ptr<CompositeInstruction>> &in_circuits);
+
+  std::size_t nbCircuits() const { return m_measuredBits.size(); }
+  // Qubits measured by a circuit, in program order.
+  const std::vector<std::size_t> &measuredBits(std::size_t in_circuitIdx) const {
+    return m_measuredBits[in_circuitIdx];
+  }
+  // Number of gates of the trie, i.e. with prefix sharing.
+  std::size_t nbTrieGates() const { return m_nodes.size() - 1; }
+  // Number of gates of the batch, i.e. independent simulations.
+  std::size_t nbGates() const { return m_nbGates; }
+
+  // Number of checkpoints (state copies) fitting in a memory budget.
+  static std::size_t checkpointBudget(std::size_t in_memoryMb,
+                                      std::size_t in_stateBytes);
+
+  // Runs the batch from backend.init(); 'onCircuit' is called with the index
+  // of each circuit and its final state (before measurement).
+  template <typename StateType>
+  Stats run(const Backend<StateType> &in_backend, std::size_t in_maxCheckpoints,
+            const std::function<void(std::size_t, const StateType &)>
+                &in_onCircuit) const;
+
+private:
+  struct Node {
+    // Null for the root
+    InstPtr gate;
+    std::size_t parent;
+    std::vector<std::size_t> children;
+    // Circuits ending at this node
+    std::vector<std::size_t> circuits;
+  };
+  // Follows a chain of single-child nodes (without circuits ending there)
+  // from 'in_nodeIdx': appends their gates and returns the last node.
+  std::size_t collectSegment(std::size_t in_nodeIdx,
+                             std::vector<InstPtr> &out_gates) const;
+
+  template <typename StateType> class Executor;
+
+  std::vector<Node> m_nodes;
+  std::vector<std::vector<std::size_t>> m_measuredBits;
+  std::size_t m_nbGates = 0;
+};
+
+template <typename StateType> class PrefixTrie::Executor {
+public:
+  Executor(const PrefixTrie &in_trie, const Backend<StateType> &in_backend,
+           std::size_t in_maxCheckpoints,
+           const std::function<void(std::size_t, const StateType &)>
+               &in_onCircuit)
+      : m_trie(in_trie), m_backend(in_backend),
+        m_maxCheckpoints(in_maxCheckpoints), m_onCircuit(in_onCircuit) {}
+
+  Stats run() {
+    visit(0, m_backend.init());
+    return m_stats;
+  }
+
+private:
+  struct Checkpoint {
+    // Number of path segments applied to the state
+    std::size_t depth;
+    StateType state;
+  };
+
+  void apply(StateType &io_state, const std::vector<InstPtr> &in_gates) {
+    if (!in_gates.empty()) {
+      m_backend.apply(io_state, in_gates);
+      m_stats.nbAppliedGates += in_gates.size();
+    }
+  }
+
+  // State of the current node (end of the path), replayed from the nearest
+  // checkpoint.
+  StateType recompute() {
+    m_stats.nbRecomputes++;
+    std::size_t depth = 0;
+    StateType state = m_checkpoints.empty()
+                          ? m_backend.init()
+                          : m_backend.copy(m_checkpoints.back().state);
+    if (!m_checkpoints.empty()) {
+      depth = m_checkpoints.back().depth;
+    }
+    std::vector<InstPtr> gates;
+    for (std::size_t i = depth; i < m_path.size(); ++i) {
+      gates.insert(gates.end(), m_path[i]->begin(), m_path[i]->end());
+    }
+    apply(state, gates);
+    return state;
+  }
+
+  // io_state: state of the node (its path applied).
+  void visit(std::size_t in_nodeIdx, StateType io_state) {
+    const auto pathDepth = m_path.size();
+    // Gates of the single-child chain (stable addresses for the path)
+    std::deque<std::vector<InstPtr>> chain;
+    std::size_t nodeIdx = in_nodeIdx;
+    // Single child: continue in place.
+    while (true) {
+      const auto &node = m_trie.m_nodes[nodeIdx];
+      for (const auto &circuitIdx : node.circuits) {
+        m_onCircuit(circuitIdx, io_state);
+      }
+      if (node.children.size() != 1) {
+        break;
+      }
+      auto &segment = chain.emplace_back();
+      nodeIdx = m_trie.collectSegment(node.children[0], segment);
+      apply(io_state, segment);
+      m_path.emplace_back(&segment);
+    }
+
+    const auto &children = m_trie.m_nodes[nodeIdx].children;
+    if (!children.empty()) {
+      std::vector<std::vector<InstPtr>> segments(children.size());
+      std::vector<std::size_t> ends(children.size());
+      for (std::size_t i = 0; i < children.size(); ++i) {
+        ends[i] = m_trie.collectSegment(children[i], segments[i]);
+      }
+
+      const auto visitChild = [&](std::size_t in_childIdx, StateType in_state) {
+        apply(in_state, segments[in_childIdx]);
+        m_path.emplace_back(&segments[in_childIdx]);
+        visit(ends[in_childIdx], std::move(in_state));
+        m_path.pop_back();
+      };
+
+      if (m_checkpoints.size() < m_maxCheckpoints) {
+        m_checkpoints.push_back(Checkpoint{m_path.size(), std::move(io_state)});
+        m_stats.peakCheckpoints =
+            std::max(m_stats.peakCheckpoints, m_checkpoints.size());
+        const auto checkpointIdx = m_checkpoints.size() - 1;
+        for (std::size_t i = 0; i + 1 < children.size(); ++i) {
+          m_stats.nbCheckpoints++;
+          visitChild(i, m_backend.copy(m_checkpoints[checkpointIdx].state));
+        }
+        // The last child takes over the checkpoint.
+        StateType lastState = std::move(m_checkpoints[checkpointIdx].state);
+        m_checkpoints.pop_back();
+        visitChild(children.size() - 1, std::move(lastState));
+      } else {
+        // Over budget: the first child takes over the state, the others
+        // recompute it.
+        visitChild(0, std::move(io_state));
+        for (std::size_t i = 1; i < children.size(); ++i) {
+          visitChild(i, recompute());
+        }
+      }
+    }
+
+    m_path.resize(pathDepth);
+  }
+
+  const PrefixTrie &m_trie;
+  const Backend<StateType> &m_backend;
+  std::size_t m_maxCheckpoints;
+  const std::function<void(std::size_t, const StateType &)> &m_onCircuit;
+  // Gate segments from the root to the current node
+  std::vector<const std::vector<InstPtr> *> m_path;
+  std::vector<Checkpoint> m_checkpoints;
+  Stats m_stats;
+};
+
+template <typename StateType>
+PrefixTrie::Stats PrefixTrie::run(
+    const Backend<StateType> &in_backend, std::size_t in_maxCheckpoints,
+    const std::function<void(std::size_t, const StateType &)> &in_onCircuit)
+    const {
+  Executor<StateType> executor(*this, in_backend, in_maxCheckpoints,
+                               in_onCircuit);
+  return executor.run();
+}
+} // namespace quantum
+} // namespace xacc
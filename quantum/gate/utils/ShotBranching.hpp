@@ -0,0 +1,425 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include "AcceleratorBuffer.hpp"
+#include "CommonGates.hpp"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace xacc {
+namespace quantum {
+// Shot-branching simulation of dynamic circuits, i.e. circuits with
+// mid-circuit measurements, Reset, or conditional (IfStmt) blocks.
+//
+// Rather than re-simulating the whole circuit once per shot, all shots start
+// in a single branch. Gates are applied once per branch; at each mid-circuit
+// measurement (or reset), a branch carrying N shots is split according to a
+// binomial draw of the outcome counts: only outcomes that received shots
+// create a branch, hence deterministic measurements never split and a branch
+// with a single shot runs as a plain trajectory.
+// Branches with the same classical record and the same quantum state (e.g.
+// after resetting an unentangled qubit) are merged.
+//
+// Memory is bounded by the branch budget: when a split exceeds it, the
+// branch with the fewest shots is completed right away, one trajectory per
+// shot, before the remaining branches continue. Hence, besides the budget,
+// at most one overflow branch and its current trajectory are alive.
+//
+// Branching stops at the last mid-circuit measurement: the trailing terminal
+// measurements are sampled from each final branch state (by the backend
+// sampler, or else by depth-first binomial splitting of that state), so that
+// a final measurement of many qubits never overflows the budget.
+//
+// The engine is simulator-agnostic; backends provide the state operations.
+template <typename StateType> class ShotBranching {
+public:
+  struct Backend {
+    // Apply a sequence of gates (no Measure/Reset/IfStmt).
+    std::function<void(StateType &, const std::vector<InstPtr> &)> apply;
+    // Probability of measuring 1 on a qubit.
+    std::function<double(StateType &, std::size_t)> probabilityOne;
+    // Project a qubit onto the given outcome and renormalize.
+    std::function<void(StateType &, std::size_t, bool)> collapse;
+    // Pauli X, used to implement Reset.
+    std::function<void(StateType &, std::size_t)> flip;
+    std::function<StateType(const StateType &)> copy;
+    // Optional: true if two states are equal (up to a global phase).
+    // Branches are never merged if not provided.
+    std::function<bool(const StateType &, const StateType &)> isSameState;
+    // Optional: multinomial draw of the results of measuring 'qubits' over
+    // 'shots' shots, as (key, count) pairs where bit i of a key is the result
+    // on qubits[i] (see StreamingSampler). Terminal measurements are drawn
+    // by splitting copies of the final branch state if not provided.
+    std::function<std::vector<std::pair<uint64_t, uint64_t>>(
+        StateType &, const std::vector<std::size_t> &, int, std::mt19937_64 &)>
+        sample;
+  };
+
+  // Classical result of a measurement: 'creg' is empty if the result is
+  // addressed by the qubit index (Measure without a classical register), in
+  // which case 'qreg' is the buffer name of the measured qubit.
+  struct MeasureRecord {
+    std::string creg;
+    std::string qreg;
+    std::size_t bit;
+    bool result;
+    bool operator==(const MeasureRecord &other) const {
+      return bit == other.bit && result == other.result &&
+             creg == other.creg && qreg == other.qreg;
+    }
+  };
+
+  struct Branch {
+    StateType state;
+    int shots;
+    std::vector<MeasureRecord> records;
+    // One bit per executed measurement, in program order.
+    std::string bitString() const {
+      std::string result;
+      result.reserve(records.size());
+      for (const auto &record : records) {
+        result.push_back(record.result ? '1' : '0');
+      }
+      return result;
+    }
+    // Replays the measurement results into the buffer, as a shot-by-shot
+    // simulation would have recorded them.
+    void replay(AcceleratorBuffer &buffer) const {
+      for (const auto &record : records) {
+        if (record.creg.empty()) {
+          buffer.measure(record.bit, record.result);
+        } else {
+          buffer.measure(record.creg, record.bit, record.result);
+        }
+      }
+    }
+  };
+
+  ShotBranching(Backend backend, std::size_t branchBudget)
+      : m_backend(std::move(backend)),
+        m_branchBudget(std::max<std::size_t>(1, branchBudget)) {}
+
+  // Runs 'shots' shots of the program starting from 'initialState';
+  // 'onFinished' is called once for each final branch and terminal
+  // measurement outcome (the branch state is not collapsed onto the terminal
+  // measurement results).
+  // 'qregName' is the name of the qubit buffer: IfStmt conditions on this
+  // name (or on the register name of the measured qubits) refer to the
+  // results of Measure gates without classical register.
+  void run(const std::shared_ptr<CompositeInstruction> &program,
+           const std::string &qregName, StateType initialState, int shots,
+           std::mt19937_64 &rng,
+           const std::function<void(const Branch &)> &onFinished) {
+    m_ops.clear();
+    flatten(program, {});
+    // Trailing unconditional measurements are sampled, not branched.
+    m_terminalIdx = m_ops.size();
+    while (m_terminalIdx > 0 && m_ops[m_terminalIdx - 1].isMeasure &&
+           m_ops[m_terminalIdx - 1].conditions.empty()) {
+      --m_terminalIdx;
+    }
+    if (m_backend.sample && m_ops.size() - m_terminalIdx > MAX_SAMPLED_BITS) {
+      // Sampled outcome keys are 64-bit wide.
+      m_terminalIdx = m_ops.size() - MAX_SAMPLED_BITS;
+    }
+    m_qregName = qregName;
+    m_rng = &rng;
+    m_onFinished = onFinished;
+    m_peakBranches = 1;
+    m_nbSplits = 0;
+    std::vector<Branch> branches;
+    branches.push_back(Branch{std::move(initialState), shots, {}});
+    simulate(std::move(branches), 0, 0);
+  }
+
+  // Max. number of simultaneously live branches of the last run, i.e. at
+  // most the budget plus the trajectory of an overflow branch, plus one copy
+  // per terminal measurement if the backend has no sampler.
+  std::size_t peakBranches() const { return m_peakBranches; }
+  // Number of branch splits of the last run.
+  std::size_t nbSplits() const { return m_nbSplits; }
+
+private:
+  static constexpr std::size_t MAX_SAMPLED_BITS = 64;
+  using Condition = std::pair<std::string, std::size_t>;
+  struct Op {
+    InstPtr inst;
+    // All must hold (nested IfStmt)
+    std::vector<Condition> conditions;
+    bool isMeasure;
+    bool isReset;
+  };
+
+  void flatten(const std::shared_ptr<CompositeInstruction> &composite,
+               const std::vector<Condition> &conditions) {
+    for (auto &inst : composite->getInstructions()) {
+      if (inst->name() == "ifstmt") {
+        auto nestedConditions = conditions;
+        nestedConditions.emplace_back(inst->getBufferNames()[0],
+                                      inst->bits()[0]);
+        flatten(std::dynamic_pointer_cast<CompositeInstruction>(inst),
+                nestedConditions);
+        continue;
+      }
+      // IfStmt bodies are disabled until expanded.
+      if (!inst->isEnabled() && conditions.empty()) {
+        continue;
+      }
+      // Controlled blocks are handled as a whole by the simulator visitors.
+      if (inst->isComposite() && inst->name() != "C-U") {
+        flatten(std::dynamic_pointer_cast<CompositeInstruction>(inst),
+                conditions);
+        continue;
+      }
+      m_ops.push_back({inst, conditions, inst->name() == "Measure",
+                       inst->name() == "Reset"});
+    }
+  }
+
+  bool conditionValue(const Branch &branch, const Condition &cond) const {
+    for (auto iter = branch.records.rbegin(); iter != branch.records.rend();
+         ++iter) {
+      if (iter->bit != cond.second) {
+        continue;
+      }
+      const bool matched =
+          iter->creg.empty()
+              ? (cond.first == m_qregName || cond.first == iter->qreg)
+              : iter->creg == cond.first;
+      if (matched) {
+        return iter->result;
+      }
+    }
+    // Not assigned yet
+    return false;
+  }
+
+  bool isActive(const Branch &branch, const Op &op) const {
+    for (const auto &cond : op.conditions) {
+      if (!conditionValue(branch, cond)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void applyOutcome(Branch &branch, const Op &op, bool outcome) {
+    const auto qubit = op.inst->bits()[0];
+    m_backend.collapse(branch.state, qubit, outcome);
+    if (op.isReset) {
+      if (outcome) {
+        m_backend.flip(branch.state, qubit);
+      }
+      return;
+    }
+    recordOutcome(branch, op, outcome);
+  }
+
+  void recordOutcome(Branch &branch, const Op &op, bool outcome) const {
+    const auto qubit = op.inst->bits()[0];
+    auto measure = std::dynamic_pointer_cast<Measure>(op.inst);
+    if (measure && measure->hasClassicalRegAssignment()) {
+      branch.records.push_back({measure->getBufferNames()[1], "",
+                                measure->getClassicalBitIndex(), outcome});
+    } else {
+      const auto bufferNames = op.inst->getBufferNames();
+      branch.records.push_back(
+          {"", bufferNames.empty() ? "" : bufferNames[0], qubit, outcome});
+    }
+  }
+
+  void merge(std::vector<Branch> &branches) const {
+    if (!m_backend.isSameState) {
+      return;
+    }
+    for (std::size_t i = 0; i < branches.size(); ++i) {
+      for (std::size_t j = branches.size() - 1; j > i; --j) {
+        if (branches[i].records == branches[j].records &&
+            m_backend.isSameState(branches[i].state, branches[j].state)) {
+          branches[i].shots += branches[j].shots;
+          branches.erase(branches.begin() + j);
+        }
+      }
+    }
+  }
+
+  // Completes a branch one shot at a time.
+  void runTrajectories(Branch &&branch, std::size_t opIdx,
+                       std::size_t nbOtherBranches) {
+    for (int shot = 0; shot < branch.shots; ++shot) {
+      std::vector<Branch> single;
+      if (shot + 1 == branch.shots) {
+        single.push_back(Branch{std::move(branch.state), 1, branch.records});
+      } else {
+        single.push_back(
+            Branch{m_backend.copy(branch.state), 1, branch.records});
+      }
+      simulate(std::move(single), opIdx, nbOtherBranches);
+    }
+  }
+
+  // Advances all branches from 'opIdx' to the end of the program.
+  // 'nbOtherBranches': number of branches kept alive by the callers.
+  void simulate(std::vector<Branch> branches, std::size_t opIdx,
+                std::size_t nbOtherBranches) {
+    std::size_t i = opIdx;
+    while (i < m_terminalIdx) {
+      if (!m_ops[i].isMeasure && !m_ops[i].isReset) {
+        // Gate segment up to the next measure/reset
+        std::size_t end = i;
+        while (end < m_terminalIdx && !m_ops[end].isMeasure &&
+               !m_ops[end].isReset) {
+          ++end;
+        }
+        std::vector<InstPtr> gates;
+        for (auto &branch : branches) {
+          gates.clear();
+          for (std::size_t k = i; k < end; ++k) {
+            if (isActive(branch, m_ops[k])) {
+              gates.emplace_back(m_ops[k].inst);
+            }
+          }
+          if (!gates.empty()) {
+            m_backend.apply(branch.state, gates);
+          }
+        }
+        i = end;
+        continue;
+      }
+
+      const auto &op = m_ops[i];
+      const auto qubit = op.inst->bits()[0];
+      std::vector<Branch> next;
+      next.reserve(branches.size() + 1);
+      for (std::size_t k = 0; k < branches.size(); ++k) {
+        auto &branch = branches[k];
+        if (!isActive(branch, op)) {
+          next.push_back(std::move(branch));
+          continue;
+        }
+        const double p1 = std::min(
+            1.0, std::max(0.0, m_backend.probabilityOne(branch.state, qubit)));
+        const int nbOnes =
+            std::binomial_distribution<int>(branch.shots, p1)(*m_rng);
+        const int nbZeros = branch.shots - nbOnes;
+        if (nbOnes > 0 && nbZeros > 0) {
+          Branch one{m_backend.copy(branch.state), nbOnes, branch.records};
+          branch.shots = nbZeros;
+          applyOutcome(branch, op, false);
+          applyOutcome(one, op, true);
+          next.push_back(std::move(branch));
+          next.push_back(std::move(one));
+          ++m_nbSplits;
+        } else {
+          applyOutcome(branch, op, nbOnes > 0);
+          next.push_back(std::move(branch));
+        }
+
+        // Enforce the budget: live branches are the ones in 'next', the
+        // remaining ones in 'branches' and those kept by the callers.
+        const auto nbRemaining = branches.size() - k - 1;
+        while (next.size() > 1 &&
+               next.size() + nbRemaining + nbOtherBranches > m_branchBudget) {
+          auto smallest = std::min_element(
+              next.begin(), next.end(), [](const Branch &a, const Branch &b) {
+                return a.shots < b.shots;
+              });
+          Branch overflow = std::move(*smallest);
+          next.erase(smallest);
+          runTrajectories(std::move(overflow), i + 1,
+                          next.size() + nbRemaining + nbOtherBranches);
+        }
+        m_peakBranches = std::max(m_peakBranches,
+                                  next.size() + nbRemaining + nbOtherBranches);
+      }
+      if (op.isReset) {
+        merge(next);
+      }
+      branches = std::move(next);
+      ++i;
+    }
+
+    for (std::size_t k = 0; k < branches.size(); ++k) {
+      finish(branches[k], branches.size() - k + nbOtherBranches);
+    }
+  }
+
+  // Draws the terminal measurements of a final branch.
+  // 'nbLiveBranches': number of branches alive, including this one.
+  void finish(Branch &branch, std::size_t nbLiveBranches) {
+    if (m_terminalIdx == m_ops.size() || !m_backend.sample) {
+      splitTerminal(branch, m_terminalIdx, nbLiveBranches);
+      return;
+    }
+    std::vector<std::size_t> qubits;
+    for (std::size_t k = m_terminalIdx; k < m_ops.size(); ++k) {
+      qubits.emplace_back(m_ops[k].inst->bits()[0]);
+    }
+    const auto outcomes =
+        m_backend.sample(branch.state, qubits, branch.shots, *m_rng);
+    const auto nbRecords = branch.records.size();
+    for (const auto &[key, count] : outcomes) {
+      branch.shots = count;
+      for (std::size_t b = 0; b < qubits.size(); ++b) {
+        recordOutcome(branch, m_ops[m_terminalIdx + b], (key >> b) & 1ULL);
+      }
+      m_onFinished(branch);
+      branch.records.resize(nbRecords);
+    }
+  }
+
+  // Depth-first binomial splitting over the terminal measurements from
+  // 'opIdx': besides the branch, at most one copy per terminal measurement is
+  // alive.
+  void splitTerminal(Branch &branch, std::size_t opIdx,
+                     std::size_t nbLiveBranches) {
+    m_peakBranches = std::max(m_peakBranches, nbLiveBranches);
+    if (opIdx == m_ops.size()) {
+      m_onFinished(branch);
+      return;
+    }
+    const auto &op = m_ops[opIdx];
+    const auto qubit = op.inst->bits()[0];
+    const double p1 = std::min(
+        1.0, std::max(0.0, m_backend.probabilityOne(branch.state, qubit)));
+    const int nbOnes =
+        std::binomial_distribution<int>(branch.shots, p1)(*m_rng);
+    const int nbZeros = branch.shots - nbOnes;
+    if (nbOnes > 0 && nbZeros > 0) {
+      Branch one{m_backend.copy(branch.state), nbOnes, branch.records};
+      branch.shots = nbZeros;
+      applyOutcome(branch, op, false);
+      splitTerminal(branch, opIdx + 1, nbLiveBranches + 1);
+      branch = std::move(one);
+      applyOutcome(branch, op, true);
+      splitTerminal(branch, opIdx + 1, nbLiveBranches);
+    } else {
+      applyOutcome(branch, op, nbOnes > 0);
+      splitTerminal(branch, opIdx + 1, nbLiveBranches);
+    }
+  }
+
+  Backend m_backend;
+  std::size_t m_branchBudget;
+  std::vector<Op> m_ops;
+  // Index of the first terminal measurement
+  std::size_t m_terminalIdx = 0;
+  std::string m_qregName;
+  std::mt19937_64 *m_rng = nullptr;
+  std::function<void(const Branch &)> m_onFinished;
+  std::size_t m_peakBranches = 1;
+  std::size_t m_nbSplits = 0;
+};
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#include "StreamingSampler.hpp"
+#include "AcceleratorBuffer.hpp"
+#include "xacc.hpp"
+#include <cstring>
+
+namespace {
+constexpr char SHOT_FILE_MAGIC[8] = {'X', 'A', 'C', 'C', 'S', 'H', 'O', 'T'};
+constexpr uint32_t SHOT_FILE_VERSION = 1;
+
+template <typename T> void writeValue(std::ofstream &io_file, const T &in_val) {
+  io_file.write(reinterpret_cast<const char *>(&in_val), sizeof(T));
+}
+
+template <typename T> bool readValue(std::ifstream &io_file, T &out_val) {
+  return static_cast<bool>(
+      io_file.read(reinterpret_cast<char *>(&out_val), sizeof(T)));
+}
+
+// Fenwick tree of the remaining counts per outcome:
+// drawing a shot without replacement is a prefix-sum search, O(log #outcomes).
+class CountTree {
+public:
+  CountTree(const std::vector<xacc::quantum::StreamingSampler::Outcome> &in_outcomes)
+      : m_tree(in_outcomes.size() + 1, 0), m_total(0) {
+    for (size_t i = 0; i < in_outcomes.size(); ++i) {
+      add(i, in_outcomes[i].second);
+    }
+    m_topStep = 1;
+    while (m_topStep * 2 <= in_outcomes.size()) {
+      m_topStep *= 2;
+    }
+  }
+  uint64_t total() const { return m_total; }
+  // Index of the outcome of the shot in_rank (0 <= in_rank < total())
+  // in the cumulative counts, which is then removed.
+  size_t pop(uint64_t in_rank) {
+    size_t pos = 0;
+    for (size_t step = m_topStep; step > 0; step /= 2) {
+      if (pos + step < m_tree.size() && m_tree[pos + step] <= in_rank) {
+        pos += step;
+        in_rank -= m_tree[pos];
+      }
+    }
+    add(pos, -1);
+    return pos;
+  }
+
+private:
+  void add(size_t in_idx, int64_t in_delta) {
+    m_total += in_delta;
+    for (size_t i = in_idx + 1; i < m_tree.size(); i += i & (~i + 1)) {
+      m_tree[i] += in_delta;
+    }
+  }
+
+  std::vector<uint64_t> m_tree;
+  uint64_t m_total;
+  size_t m_topStep;
+};
+} // namespace
+
+namespace xacc {
+namespace quantum {
+void StreamingSampler::checkMeasuredBits(const std::vector<size_t> &in_bits) {
+  if (in_bits.size() > MAX_MEASURED_BITS) {
+    xacc::error("Streaming sampler: at most " +
+                std::to_string(MAX_MEASURED_BITS) +
+                " measured bits are supported, got " +
+                std::to_string(in_bits.size()) + ".");
+  }
+}
+
+std::string StreamingSampler::toBitString(uint64_t in_key, size_t in_nbBits) {
+  std::string bitString(in_nbBits, '0');
+  for (size_t i = 0; i < in_nbBits; ++i) {
+    if ((in_key >> i) & 1ULL) {
+      bitString[i] = '1';
+    }
+  }
+  return bitString;
+}
+
+void StreamingSampler::appendCounts(AcceleratorBuffer &io_buffer,
+                                    const std::vector<Outcome> &in_outcomes,
+                                    size_t in_nbBits) {
+  for (const auto &[key, count] : in_outcomes) {
+    io_buffer.appendMeasurement(toBitString(key, in_nbBits), count);
+  }
+}
+
+void ShotFileWriter::write(
+    const std::string &in_path,
+    const std::vector<StreamingSampler::Outcome> &in_outcomes,
+    size_t in_nbBits, std::mt19937_64 &in_rng, size_t in_chunkSize) {
+  std::ofstream file(in_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    xacc::error("Failed to open shot file '" + in_path + "'.");
+  }
+
+  CountTree counts(in_outcomes);
+  file.write(SHOT_FILE_MAGIC, sizeof(SHOT_FILE_MAGIC));
+  writeValue(file, SHOT_FILE_VERSION);
+  writeValue(file, static_cast<uint32_t>(in_nbBits));
+  writeValue(file, counts.total());
+
+  std::vector<uint64_t> chunk;
+  chunk.reserve(std::min<uint64_t>(std::max<size_t>(in_chunkSize, 1),
+                                   counts.total()));
+  const auto flush = [&]() {
+    writeValue(file, static_cast<uint64_t>(chunk.size()));
+    file.write(reinterpret_cast<const char *>(chunk.data()),
+               chunk.size() * sizeof(uint64_t));
+    chunk.clear();
+  };
+  while (counts.total() > 0) {
+    const uint64_t rank =
+        std::uniform_int_distribution<uint64_t>(0, counts.total() - 1)(in_rng);
+    chunk.emplace_back(in_outcomes[counts.pop(rank)].first);
+    if (chunk.size() >= in_chunkSize) {
+      flush();
+    }
+  }
+  if (!chunk.empty()) {
+    flush();
+  }
+  if (!file) {
+    xacc::error("Failed to write shot file '" + in_path + "'.");
+  }
+}
+
+ShotFileReader::ShotFileReader(const std::string &in_path)
+    : m_file(in_path, std::ios::binary), m_nbBits(0), m_nbShots(0) {
+  char magic[sizeof(SHOT_FILE_MAGIC)];
+  uint32_t version = 0;
+  uint32_t nbBits = 0;
+  if (!m_file.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, SHOT_FILE_MAGIC, sizeof(magic)) != 0 ||
+      !readValue(m_file, version) || version != SHOT_FILE_VERSION ||
+      !readValue(m_file, nbBits) || !readValue(m_file, m_nbShots)) {
+    xacc::error("Invalid shot file '" + in_path + "'.");
+  }
+  m_nbBits = nbBits;
+}
+
+bool ShotFileReader::next(std::vector<uint64_t> &out_shots) {
+  uint64_t chunkSize = 0;
+  if (!readValue(m_file, chunkSize)) {
+    out_shots.clear();
+    return false;
+  }
+  out_shots.resize(chunkSize);
+  if (!m_file.read(reinterpret_cast<char *>(out_shots.data()),
+                   chunkSize * sizeof(uint64_t))) {
+    xacc::error("Truncated shot file.");
+  }
+  return true;
+}
+} // namespace quantum
+} // namespace xacc
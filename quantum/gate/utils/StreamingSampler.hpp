@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xacc {
+class AcceleratorBuffer;
+namespace quantum {
+// Bounded-memory sampling of the measurement outcomes of a state vector.
+//
+// Rather than drawing (and sorting) one random number per shot, the shots are
+// distributed over the basis states by sequential binomial splitting: with N
+// shots left and a remaining probability mass P, basis state k receives
+// Binomial(N, p_k / P) shots. This is an exact multinomial draw, in
+// O(2^n + #distinct outcomes) time without any per-shot storage, and the scan
+// stops as soon as all the shots are assigned.
+//
+// Outcomes are keyed by the measured bits: bit i of a key is the value of
+// qubit in_bits[i], i.e. character i of the bit string.
+class StreamingSampler {
+public:
+  // (key, count)
+  using Outcome = std::pair<uint64_t, uint64_t>;
+  static constexpr size_t MAX_MEASURED_BITS = 64;
+
+  // in_probability(k): probability of the basis state k, k < in_dim.
+  // The probabilities don't need to be normalized (e.g. single precision).
+  template <typename ProbabilityFn>
+  static std::vector<Outcome> sample(uint64_t in_dim,
+                                     ProbabilityFn &&in_probability,
+                                     const std::vector<size_t> &in_bits,
+                                     uint64_t in_shots, std::mt19937_64 &in_rng);
+
+  static std::string toBitString(uint64_t in_key, size_t in_nbBits);
+  // Adds the counts to the buffer, one bit string per distinct outcome.
+  static void appendCounts(AcceleratorBuffer &io_buffer,
+                           const std::vector<Outcome> &in_outcomes,
+                           size_t in_nbBits);
+
+private:
+  static void checkMeasuredBits(const std::vector<size_t> &in_bits);
+};
+
+// Per-shot output for users who need the raw shot order.
+// The shots of the sampled counts are written in a uniformly random order
+// (drawing without replacement), hence the file is consistent with the
+// counts in the buffer and is distributed as a shot-by-shot simulation.
+//
+// Chunked binary format (native byte order):
+//   header: "XACCSHOT" | uint32 version | uint32 nbBits | uint64 nbShots
+//   chunks: uint64 nbShotsInChunk | nbShotsInChunk x uint64 keys
+// Memory is bounded by the chunk size.
+class ShotFileWriter {
+public:
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+  static void write(const std::string &in_path,
+                    const std::vector<StreamingSampler::Outcome> &in_outcomes,
+                    size_t in_nbBits, std::mt19937_64 &in_rng,
+                    size_t in_chunkSize = DEFAULT_CHUNK_SIZE);
+};
+
+class ShotFileReader {
+public:
+  ShotFileReader(const std::string &in_path);
+  size_t nbBits() const { return m_nbBits; }
+  uint64_t nbShots() const { return m_nbShots; }
+  // Reads the next chunk of shots (keys), returns false at the end.
+  bool next(std::vector<uint64_t> &out_shots);
+
+private:
+  std::ifstream m_file;
+  size_t m_nbBits;
+  uint64_t m_nbShots;
+};
+
+template <typename ProbabilityFn>
+std::vector<StreamingSampler::Outcome>
+StreamingSampler::sample(uint64_t in_dim, ProbabilityFn &&in_probability,
+                         const std::vector<size_t> &in_bits, uint64_t in_shots,
+                         std::mt19937_64 &in_rng) {
+  checkMeasuredBits(in_bits);
+  double mass = 0.0;
+  for (uint64_t k = 0; k < in_dim; ++k) {
+    mass += in_probability(k);
+  }
+
+  std::vector<Outcome> outcomes;
+  std::unordered_map<uint64_t, size_t> keyToIdx;
+  const auto addShots = [&](uint64_t in_stateIdx, uint64_t in_count) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < in_bits.size(); ++i) {
+      key |= ((in_stateIdx >> in_bits[i]) & 1ULL) << i;
+    }
+    const auto iter = keyToIdx.find(key);
+    if (iter == keyToIdx.end()) {
+      keyToIdx.emplace(key, outcomes.size());
+      outcomes.emplace_back(key, in_count);
+    } else {
+      outcomes[iter->second].second += in_count;
+    }
+  };
+
+  uint64_t remaining = in_shots;
+  uint64_t lastStateIdx = 0;
+  for (uint64_t k = 0; k < in_dim && remaining > 0; ++k) {
+    const double prob = in_probability(k);
+    if (prob <= 0.0) {
+      continue;
+    }
+    lastStateIdx = k;
+    const uint64_t count =
+        prob >= mass
+            ? remaining
+            : std::binomial_distribution<uint64_t>(remaining, prob / mass)(
+                  in_rng);
+    mass -= prob;
+    remaining -= count;
+    if (count > 0) {
+      addShots(k, count);
+    }
+  }
+  // Rounding errors of the remaining mass
+  if (remaining > 0) {
+    addShots(lastStateIdx, remaining);
+  }
+  return outcomes;
+}
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "xacc_observable.hpp"
+#include "InstructionIterator.hpp"
+#include "ObservedCircuitTemplate.hpp"
+
+using namespace xacc::quantum;
+
+namespace {
+std::vector<xacc::InstPtr>
+flattenEnabled(std::shared_ptr<xacc::CompositeInstruction> in_composite) {
+  std::vector<xacc::InstPtr> result;
+  xacc::InstructionIterator it(in_composite);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (!inst->isComposite()) {
+      result.emplace_back(inst);
+    }
+  }
+  return result;
+}
+
+// The bound template circuits must match the (evaluate + observe) circuits.
+void checkEqual(
+    const std::vector<std::shared_ptr<xacc::CompositeInstruction>> &in_expected,
+    const std::vector<std::shared_ptr<xacc::CompositeInstruction>> &in_actual) {
+  EXPECT_EQ(in_expected.size(), in_actual.size());
+  for (int i = 0; i < in_expected.size(); ++i) {
+    EXPECT_EQ(in_expected[i]->name(), in_actual[i]->name());
+    EXPECT_NEAR(std::real(in_expected[i]->getCoefficient()),
+                std::real(in_actual[i]->getCoefficient()), 1e-12);
+    const auto expected = flattenEnabled(in_expected[i]);
+    const auto actual = flattenEnabled(in_actual[i]);
+    EXPECT_EQ(expected.size(), actual.size());
+    for (int j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(expected[j]->name(), actual[j]->name());
+      EXPECT_EQ(expected[j]->bits(), actual[j]->bits());
+      EXPECT_EQ(expected[j]->nParameters(), actual[j]->nParameters());
+      for (int k = 0; k < expected[j]->nParameters(); ++k) {
+        if (expected[j]->getParameter(k).isNumeric()) {
+          EXPECT_NEAR(
+              xacc::InstructionParameterToDouble(expected[j]->getParameter(k)),
+              xacc::InstructionParameterToDouble(actual[j]->getParameter(k)),
+              1e-9);
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+TEST(ObservedCircuitTemplateTester, checkBind) {
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit template_ansatz
+        .parameters theta, phi
+        .qbit q
+        X(q[0]);
+        Ry(q[1], theta);
+        CNOT(q[1],q[0]);
+        Rz(q[0], 2*theta - phi + 0.5);
+        Rx(q[1], sin(phi));
+        Rz(q[1], 0.25);
+    )");
+  auto ansatz = xacc::getCompiled("template_ansatz");
+  auto H = xacc::quantum::getObservable(
+      "pauli", std::string("5.907 - 2.1433 X0X1 - 2.1433 Y0Y1 + .21829 Z0 - "
+                           "6.125 Z1"));
+
+  ObservedCircuitTemplate circuitTemplate(ansatz, H->observe(ansatz));
+  EXPECT_EQ(circuitTemplate.nVariables(), 2);
+  // theta, 2*theta - phi + 0.5 and sin(phi)
+  EXPECT_EQ(circuitTemplate.nExpressions(), 3);
+  EXPECT_EQ(circuitTemplate.nAffineExpressions(), 2);
+  // The ansatz gates are shared by all the observed circuits.
+  EXPECT_EQ(circuitTemplate.nBindings(), 3);
+
+  for (const auto &x : std::vector<std::vector<double>>{
+           {0.0, 0.0}, {1.2345, -6.789}, {-0.5, 3.14}}) {
+    const auto expected = H->observe(ansatz->operator()(x));
+    const auto &actual = circuitTemplate.bind(x);
+    checkEqual(expected, actual);
+    int nIdentity = 0;
+    for (int i = 0; i < actual.size(); ++i) {
+      if (!circuitTemplate.hasMeasurements(i)) {
+        nIdentity++;
+        EXPECT_EQ(actual[i]->nInstructions(), 6);
+      }
+    }
+    EXPECT_EQ(nIdentity, 1);
+  }
+}
+
+TEST(ObservedCircuitTemplateTester, checkSingularExpressions) {
+  // Expressions singular at the zero probe (inf or NaN at 0) are not affine.
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit singular_ansatz
+        .parameters theta, phi
+        .qbit q
+        Ry(q[1], theta);
+        CNOT(q[1],q[0]);
+        Rz(q[0], 1/theta);
+        Rx(q[1], theta/phi);
+    )");
+  auto ansatz = xacc::getCompiled("singular_ansatz");
+  auto H = xacc::quantum::getObservable("pauli", std::string("Z0 + X0X1"));
+
+  ObservedCircuitTemplate circuitTemplate(ansatz, H->observe(ansatz));
+  EXPECT_EQ(circuitTemplate.nExpressions(), 3);
+  EXPECT_EQ(circuitTemplate.nAffineExpressions(), 1);
+  for (const auto &x :
+       std::vector<std::vector<double>>{{1.2345, -6.789}, {-0.5, 3.14}}) {
+    checkEqual(H->observe(ansatz->operator()(x)), circuitTemplate.bind(x));
+  }
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ * License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#ifndef QUANTUM_PRECISIONBENCHMARK_HPP_
+#define QUANTUM_PRECISIONBENCHMARK_HPP_
+
+// Test helpers for the single vs. double precision checks of the state-vector
+// simulators (qpp, qsim).
+#include "xacc.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace xacc {
+namespace quantum {
+namespace test {
+// Random layered circuit (rotations + CNOT ladder), measuring all qubits.
+inline std::shared_ptr<CompositeInstruction>
+randomLayeredCircuit(int nbQubits, int nbLayers, unsigned seed) {
+  auto provider = xacc::getIRProvider("quantum");
+  auto circuit = provider->createComposite("random_layers_" +
+                                           std::to_string(nbQubits) + "_" +
+                                           std::to_string(nbLayers));
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dis(-M_PI, M_PI);
+  for (int layer = 0; layer < nbLayers; ++layer) {
+    for (size_t q = 0; q < nbQubits; ++q) {
+      circuit->addInstruction(provider->createInstruction("Rx", {q}, {dis(gen)}));
+      circuit->addInstruction(provider->createInstruction("Rz", {q}, {dis(gen)}));
+    }
+    for (size_t q = 0; q + 1 < nbQubits; ++q) {
+      circuit->addInstruction(provider->createInstruction("CNOT", {q, q + 1}));
+    }
+  }
+  for (size_t q = 0; q < nbQubits; ++q) {
+    circuit->addInstruction(provider->createInstruction("Measure", {q}));
+  }
+  return circuit;
+}
+
+// Exp-val-z and wall time (ms) of the circuit on the accelerator at the given
+// precision.
+inline std::pair<double, double>
+runWithPrecision(const std::string &accName, const std::string &precision,
+                 std::shared_ptr<CompositeInstruction> circuit, int nbQubits) {
+  auto accelerator = xacc::getAccelerator(accName, {{"precision", precision}});
+  auto buffer = xacc::qalloc(nbQubits);
+  const auto start = std::chrono::high_resolution_clock::now();
+  accelerator->execute(buffer, circuit);
+  const auto end = std::chrono::high_resolution_clock::now();
+  return {buffer->getExpectationValueZ(),
+          std::chrono::duration<double, std::milli>(end - start).count()};
+}
+
+// Error vs. speed of single precision on a 16-qubit random circuit (set
+// XACC_PRECISION_BENCHMARK_QUBITS to change size): the timings are printed
+// for reference, returns the abs. error of fp32.
+inline double benchmarkPrecision(const std::string &accName) {
+  int nbQubits = 16;
+  if (const char *env = std::getenv("XACC_PRECISION_BENCHMARK_QUBITS")) {
+    nbQubits = std::atoi(env);
+  }
+  auto circuit = randomLayeredCircuit(nbQubits, 20, 123);
+  const auto [expValFp64, timeFp64] =
+      runWithPrecision(accName, "fp64", circuit, nbQubits);
+  const auto [expValFp32, timeFp32] =
+      runWithPrecision(accName, "fp32", circuit, nbQubits);
+  std::cout << accName << ", " << nbQubits << " qubits, "
+            << circuit->nInstructions() << " instructions:\n"
+            << "  fp64: " << timeFp64 << " ms, <Z...Z> = " << expValFp64 << "\n"
+            << "  fp32: " << timeFp32 << " ms, <Z...Z> = " << expValFp32
+            << ", abs. error = " << std::abs(expValFp32 - expValFp64) << "\n";
+  return std::abs(expValFp32 - expValFp64);
+}
+} // namespace test
+} // namespace quantum
+} // namespace xacc
+#endif
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "CommonGates.hpp"
+#include "InstructionIterator.hpp"
+#include "xacc.hpp"
+#include "PrefixTrie.hpp"
+#include <random>
+
+using namespace xacc::quantum;
+
+namespace {
+// Mock simulator: the state is the sequence of applied gates.
+using GateList = std::vector<std::string>;
+
+PrefixTrie::Backend<GateList> makeBackend() {
+  PrefixTrie::Backend<GateList> backend;
+  backend.init = []() { return GateList{}; };
+  backend.apply = [](GateList &io_state,
+                     const std::vector<xacc::InstPtr> &in_gates) {
+    for (const auto &gate : in_gates) {
+      io_state.emplace_back(gate->toString());
+    }
+  };
+  backend.copy = [](const GateList &in_state) { return in_state; };
+  return backend;
+}
+
+GateList gateList(std::shared_ptr<xacc::CompositeInstruction> in_circuit) {
+  GateList result;
+  xacc::InstructionIterator it(in_circuit);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (inst->isEnabled() && !inst->isComposite() &&
+        inst->name() != "Measure") {
+      result.emplace_back(inst->toString());
+    }
+  }
+  return result;
+}
+
+// Parameter-shift style batch: a 2-layer ansatz, the circuits of the
+// +/- shifts of each angle, and a few observed (basis change) circuits.
+std::vector<std::shared_ptr<xacc::CompositeInstruction>> makeBatch() {
+  const std::vector<double> angles{0.1, 0.2, 0.3, 0.4};
+  const auto addAnsatz = [&](std::shared_ptr<Circuit> io_circuit,
+                             int in_shiftedIdx, double in_shift) {
+    for (int i = 0; i < angles.size(); ++i) {
+      const double angle = angles[i] + (i == in_shiftedIdx ? in_shift : 0.0);
+      io_circuit->addInstruction(std::make_shared<Ry>(i % 2, angle));
+      io_circuit->addInstruction(std::make_shared<CNOT>(0, 1));
+    }
+  };
+
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+  for (int i = 0; i < angles.size(); ++i) {
+    for (const double shift : {M_PI_2, -M_PI_2}) {
+      auto circuit = std::make_shared<Circuit>("shift_" + std::to_string(i) +
+                                               "_" + std::to_string(shift));
+      addAnsatz(circuit, i, shift);
+      circuit->addInstruction(std::make_shared<Measure>(0));
+      batch.emplace_back(circuit);
+    }
+  }
+  // Observed: Z0, X0X1, Z0Z1 (identical gates, different measurements)
+  auto z0 = std::make_shared<Circuit>("Z0");
+  addAnsatz(z0, -1, 0.0);
+  z0->addInstruction(std::make_shared<Measure>(0));
+  auto x0x1 = std::make_shared<Circuit>("X0X1");
+  addAnsatz(x0x1, -1, 0.0);
+  x0x1->addInstruction(std::make_shared<Hadamard>(0));
+  x0x1->addInstruction(std::make_shared<Hadamard>(1));
+  x0x1->addInstruction(std::make_shared<Measure>(0));
+  x0x1->addInstruction(std::make_shared<Measure>(1));
+  auto z0z1 = std::make_shared<Circuit>("Z0Z1");
+  addAnsatz(z0z1, -1, 0.0);
+  z0z1->addInstruction(std::make_shared<Measure>(0));
+  z0z1->addInstruction(std::make_shared<Measure>(1));
+  batch.insert(batch.end(), {z0, x0x1, z0z1});
+  return batch;
+}
+} // namespace
+
+TEST(PrefixTrieTester, checkSharing) {
+  const auto batch = makeBatch();
+  PrefixTrie trie(batch);
+  EXPECT_EQ(trie.nbCircuits(), batch.size());
+  EXPECT_EQ(trie.nbGates(), 11 * 8 + 2);
+  // The unshifted ansatz, then each shifted circuit branches off at its
+  // shifted angle: 2 * (8 - 2 * i) new gates for the shifts of angle i.
+  EXPECT_EQ(trie.nbTrieGates(), 8 + 2 * (8 + 6 + 4 + 2) + 2);
+  EXPECT_EQ(trie.measuredBits(batch.size() - 2),
+            std::vector<std::size_t>({0, 1}));
+
+  const auto backend = makeBackend();
+  for (const std::size_t budget : {0, 1, 2, 100}) {
+    std::vector<int> nbCalls(batch.size(), 0);
+    const auto stats = trie.run<GateList>(
+        backend, budget,
+        [&](std::size_t in_circuitIdx, const GateList &in_state) {
+          nbCalls[in_circuitIdx]++;
+          EXPECT_EQ(in_state, gateList(batch[in_circuitIdx]));
+        });
+    for (const auto &nbCall : nbCalls) {
+      EXPECT_EQ(nbCall, 1);
+    }
+    EXPECT_LE(stats.peakCheckpoints, budget);
+    if (budget == 0) {
+      // Branch states are replayed from the initial state.
+      EXPECT_GT(stats.nbRecomputes, 0);
+      EXPECT_LT(stats.nbAppliedGates, trie.nbGates());
+    } else {
+      // The unshifted ansatz is the last child of each branch point, which
+      // takes over the checkpoint: a single live checkpoint is enough for
+      // each gate of the trie to be applied once.
+      EXPECT_EQ(stats.peakCheckpoints, 1);
+      EXPECT_EQ(stats.nbRecomputes, 0);
+      EXPECT_EQ(stats.nbAppliedGates, trie.nbTrieGates());
+    }
+  }
+}
+
+TEST(PrefixTrieTester, checkNoSharing) {
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+  for (int i = 0; i < 3; ++i) {
+    auto circuit = std::make_shared<Circuit>("c" + std::to_string(i));
+    circuit->addInstruction(std::make_shared<Rx>(0, 0.5 * i));
+    circuit->addInstruction(std::make_shared<Hadamard>(1));
+    batch.emplace_back(circuit);
+  }
+  // Empty circuit: the initial state.
+  batch.emplace_back(std::make_shared<Circuit>("empty"));
+  PrefixTrie trie(batch);
+  EXPECT_EQ(trie.nbTrieGates(), trie.nbGates());
+  const auto stats = trie.run<GateList>(
+      makeBackend(), 1, [&](std::size_t in_circuitIdx, const GateList &in_state) {
+        EXPECT_EQ(in_state, gateList(batch[in_circuitIdx]));
+      });
+  EXPECT_EQ(stats.nbAppliedGates, trie.nbGates());
+  EXPECT_EQ(stats.peakCheckpoints, 1);
+}
+
+TEST(PrefixTrieTester, checkRandomBatch) {
+  // Random circuits drawn from a small gate set, hence with many
+  // shared prefixes of random lengths.
+  std::mt19937 rng(123);
+  const std::vector<xacc::InstPtr> gateSet{
+      std::make_shared<Hadamard>(0), std::make_shared<X>(1),
+      std::make_shared<Rz>(0, 0.5), std::make_shared<CNOT>(0, 1)};
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+  for (int i = 0; i < 50; ++i) {
+    auto circuit = std::make_shared<Circuit>("c" + std::to_string(i));
+    const int length = std::uniform_int_distribution<int>(0, 8)(rng);
+    for (int j = 0; j < length; ++j) {
+      circuit->addInstruction(
+          gateSet[std::uniform_int_distribution<int>(0, gateSet.size() - 1)(
+                      rng)]
+              ->clone());
+    }
+    batch.emplace_back(circuit);
+  }
+
+  PrefixTrie trie(batch);
+  EXPECT_LT(trie.nbTrieGates(), trie.nbGates());
+  for (const std::size_t budget : {0, 1, 2, 3, 1000}) {
+    std::vector<int> nbCalls(batch.size(), 0);
+    const auto stats = trie.run<GateList>(
+        makeBackend(), budget,
+        [&](std::size_t in_circuitIdx, const GateList &in_state) {
+          nbCalls[in_circuitIdx]++;
+          EXPECT_EQ(in_state, gateList(batch[in_circuitIdx]));
+        });
+    for (const auto &nbCall : nbCalls) {
+      EXPECT_EQ(nbCall, 1);
+    }
+    EXPECT_LE(stats.peakCheckpoints, budget);
+    if (budget >= 1000) {
+      EXPECT_EQ(stats.nbAppliedGates, trie.nbTrieGates());
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
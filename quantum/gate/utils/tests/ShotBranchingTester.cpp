@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "ShotBranching.hpp"
+#include "StreamingSampler.hpp"
+#include "Circuit.hpp"
+#include <complex>
+
+using namespace xacc::quantum;
+
+namespace {
+using State = std::vector<std::complex<double>>;
+using Engine = ShotBranching<State>;
+
+// Minimal state-vector backend (H, X, CNOT); qubit q is bit q of the index.
+Engine::Backend denseBackend() {
+  Engine::Backend backend;
+  backend.apply = [](State &state, const std::vector<xacc::InstPtr> &gates) {
+    for (auto &gate : gates) {
+      const auto bits = gate->bits();
+      const std::size_t mask = 1ULL << bits.back();
+      for (std::size_t i = 0; i < state.size(); ++i) {
+        if (i & mask) {
+          continue;
+        }
+        if (gate->name() == "H") {
+          const auto a = state[i];
+          const auto b = state[i | mask];
+          state[i] = (a + b) * M_SQRT1_2;
+          state[i | mask] = (a - b) * M_SQRT1_2;
+        } else if (gate->name() == "X" ||
+                   (gate->name() == "CNOT" && (i & (1ULL << bits[0])))) {
+          std::swap(state[i], state[i | mask]);
+        }
+      }
+    }
+  };
+  backend.probabilityOne = [](State &state, std::size_t qubit) {
+    double prob = 0.0;
+    for (std::size_t i = 0; i < state.size(); ++i) {
+      if (i & (1ULL << qubit)) {
+        prob += std::norm(state[i]);
+      }
+    }
+    return prob;
+  };
+  backend.collapse = [](State &state, std::size_t qubit, bool result) {
+    double norm = 0.0;
+    for (std::size_t i = 0; i < state.size(); ++i) {
+      if (((i >> qubit) & 1) == result) {
+        norm += std::norm(state[i]);
+      } else {
+        state[i] = 0.0;
+      }
+    }
+    for (auto &amp : state) {
+      amp /= std::sqrt(norm);
+    }
+  };
+  backend.flip = [](State &state, std::size_t qubit) {
+    for (std::size_t i = 0; i < state.size(); ++i) {
+      if (!((i >> qubit) & 1)) {
+        std::swap(state[i], state[i | (1ULL << qubit)]);
+      }
+    }
+  };
+  backend.copy = [](const State &state) { return state; };
+  backend.isSameState = [](const State &a, const State &b) {
+    std::complex<double> overlap = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      overlap += std::conj(a[i]) * b[i];
+    }
+    return std::norm(overlap) > 1.0 - 1e-12;
+  };
+  return backend;
+}
+
+State zeroState(std::size_t nbQubits) {
+  State state(1ULL << nbQubits, 0.0);
+  state[0] = 1.0;
+  return state;
+}
+
+std::map<std::string, int> runCounts(Engine &engine,
+                                     std::shared_ptr<Circuit> program,
+                                     std::size_t nbQubits, int shots,
+                                     std::size_t seed = 42) {
+  std::mt19937_64 rng(seed);
+  std::map<std::string, int> counts;
+  engine.run(program, "q", zeroState(nbQubits), shots, rng,
+             [&](const Engine::Branch &branch) {
+               counts[branch.bitString()] += branch.shots;
+             });
+  return counts;
+}
+} // namespace
+
+TEST(ShotBranchingTester, checkDeterministicNoSplit) {
+  // X; Measure; Measure: every measurement is deterministic.
+  auto program = std::make_shared<Circuit>("det");
+  program->addInstruction(std::make_shared<X>(0));
+  program->addInstruction(std::make_shared<Measure>(0));
+  program->addInstruction(std::make_shared<X>(0));
+  program->addInstruction(std::make_shared<Measure>(0));
+  Engine engine(denseBackend(), 8);
+  const auto counts = runCounts(engine, program, 1, 1000);
+  EXPECT_EQ(1, counts.size());
+  EXPECT_EQ(1000, counts.at("10"));
+  EXPECT_EQ(0, engine.nbSplits());
+}
+
+TEST(ShotBranchingTester, checkConditional) {
+  // Measure a |+> qubit, copy the result onto q[1] with a conditional X.
+  auto program = std::make_shared<Circuit>("cond");
+  program->addInstruction(std::make_shared<Hadamard>(0));
+  program->addInstruction(std::make_shared<Measure>(0));
+  auto ifStmt = std::make_shared<IfStmt>();
+  xacc::InstructionParameter bufferName(std::string("q"));
+  ifStmt->setParameter(0, bufferName);
+  ifStmt->setBits({0});
+  ifStmt->addInstruction(std::make_shared<X>(1));
+  program->addInstruction(ifStmt);
+  program->addInstruction(std::make_shared<Measure>(1));
+  Engine engine(denseBackend(), 8);
+  const auto counts = runCounts(engine, program, 2, 10000);
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(5000, counts.at("00"), 250);
+  EXPECT_NEAR(5000, counts.at("11"), 250);
+  EXPECT_EQ(1, engine.nbSplits());
+}
+
+TEST(ShotBranchingTester, checkResetMerge) {
+  // Resetting an unentangled |+> qubit: both branches are |0> and merged,
+  // the second reset splits a single branch again.
+  auto program = std::make_shared<Circuit>("reset");
+  program->addInstruction(std::make_shared<Hadamard>(0));
+  program->addInstruction(std::make_shared<Reset>(0));
+  program->addInstruction(std::make_shared<Hadamard>(0));
+  program->addInstruction(std::make_shared<Reset>(0));
+  program->addInstruction(std::make_shared<Measure>(0));
+  Engine engine(denseBackend(), 8);
+  const auto counts = runCounts(engine, program, 1, 1000);
+  EXPECT_EQ(1000, counts.at("0"));
+  EXPECT_EQ(2, engine.nbSplits());
+  EXPECT_EQ(2, engine.peakBranches());
+}
+
+TEST(ShotBranchingTester, checkBranchBudget) {
+  // Repeated measurements of fresh |+> states: 2^8 distinct outcomes.
+  const int nbRounds = 8;
+  auto program = std::make_shared<Circuit>("rounds");
+  for (int i = 0; i < nbRounds; ++i) {
+    program->addInstruction(std::make_shared<Hadamard>(0));
+    program->addInstruction(std::make_shared<Measure>(0));
+    program->addInstruction(std::make_shared<Reset>(0));
+  }
+  for (const std::size_t budget : {1, 4, 1000}) {
+    Engine engine(denseBackend(), budget);
+    const auto counts = runCounts(engine, program, 1, 20000);
+    int total = 0;
+    for (const auto &[bitString, count] : counts) {
+      EXPECT_EQ(nbRounds, bitString.size());
+      total += count;
+    }
+    EXPECT_EQ(20000, total);
+    EXPECT_EQ(1 << nbRounds, counts.size());
+    EXPECT_LE(engine.peakBranches(), budget + 1);
+    // Uniform distribution: each outcome ~ 20000 / 256 = 78
+    EXPECT_NEAR(78, counts.begin()->second, 40);
+  }
+}
+
+TEST(ShotBranchingTester, checkTerminalSampling) {
+  // A mid-circuit measurement copied onto q[1], then a final measurement of
+  // 8 qubits: only the mid-circuit measurement branches, whatever the budget.
+  const std::size_t nbQubits = 8;
+  auto program = std::make_shared<Circuit>("terminal");
+  program->addInstruction(std::make_shared<Hadamard>(0));
+  program->addInstruction(std::make_shared<Measure>(0));
+  auto ifStmt = std::make_shared<IfStmt>();
+  xacc::InstructionParameter bufferName(std::string("q"));
+  ifStmt->setParameter(0, bufferName);
+  ifStmt->setBits({0});
+  ifStmt->addInstruction(std::make_shared<X>(1));
+  program->addInstruction(ifStmt);
+  for (std::size_t q = 2; q < nbQubits; ++q) {
+    program->addInstruction(std::make_shared<Hadamard>(q));
+  }
+  for (std::size_t q = 0; q < nbQubits; ++q) {
+    program->addInstruction(std::make_shared<Measure>(q));
+  }
+
+  auto sampledBackend = denseBackend();
+  sampledBackend.sample = [](State &state,
+                             const std::vector<std::size_t> &qubits,
+                             int shots, std::mt19937_64 &rng) {
+    return StreamingSampler::sample(
+        state.size(), [&](uint64_t k) { return std::norm(state[k]); },
+        qubits, shots, rng);
+  };
+  for (const auto &backend : {denseBackend(), sampledBackend}) {
+    Engine engine(backend, 2);
+    const auto counts = runCounts(engine, program, nbQubits, 20000);
+    EXPECT_EQ(1, engine.nbSplits());
+    if (backend.sample) {
+      EXPECT_EQ(2, engine.peakBranches());
+    } else {
+      // One copy per terminal measurement at most
+      EXPECT_LE(engine.peakBranches(), 2 + nbQubits);
+    }
+    int total = 0;
+    for (const auto &[bitString, count] : counts) {
+      EXPECT_EQ(nbQubits + 1, bitString.size());
+      // Mid-circuit result, then the same value for q[0] and q[1].
+      EXPECT_EQ(bitString[0], bitString[1]);
+      EXPECT_EQ(bitString[0], bitString[2]);
+      total += count;
+    }
+    EXPECT_EQ(20000, total);
+    EXPECT_EQ(1 << (nbQubits - 1), counts.size());
+    // Uniform distribution: each outcome ~ 20000 / 128 = 156
+    EXPECT_NEAR(156, counts.begin()->second, 60);
+  }
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "AcceleratorBuffer.hpp"
+#include "StreamingSampler.hpp"
+#include <cmath>
+#include <cstdio>
+
+using namespace xacc::quantum;
+
+TEST(StreamingSamplerTester, checkDistribution) {
+  // Random 4-qubit distribution, measuring qubits 2 and 0 (in that order)
+  std::mt19937_64 rng(42);
+  std::vector<double> probs(16);
+  double sum = 0.0;
+  for (auto &p : probs) {
+    p = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    sum += p;
+  }
+  probs[5] = 0.0;
+  const std::vector<size_t> bits{2, 0};
+  std::vector<double> expected(4, 0.0);
+  for (uint64_t k = 0; k < probs.size(); ++k) {
+    const uint64_t key = ((k >> 2) & 1) | (((k >> 0) & 1) << 1);
+    expected[key] += probs[k] / (sum - probs[5]);
+  }
+
+  // Unnormalized probabilities are fine.
+  const uint64_t nbShots = 10000000;
+  const auto outcomes = StreamingSampler::sample(
+      probs.size(), [&](uint64_t k) { return probs[k]; }, bits, nbShots, rng);
+  EXPECT_EQ(outcomes.size(), 4);
+  uint64_t total = 0;
+  for (const auto &[key, count] : outcomes) {
+    total += count;
+    // Binomial(N, p): 5 sigma
+    const double mean = nbShots * expected[key];
+    EXPECT_NEAR(count, mean,
+                5.0 * std::sqrt(mean * (1.0 - expected[key])));
+  }
+  EXPECT_EQ(total, nbShots);
+
+  auto buffer = std::make_shared<xacc::AcceleratorBuffer>(4);
+  StreamingSampler::appendCounts(*buffer, outcomes, bits.size());
+  for (const auto &[key, count] : outcomes) {
+    EXPECT_EQ(buffer->getMeasurementCounts()[StreamingSampler::toBitString(
+                  key, bits.size())],
+              count);
+  }
+}
+
+TEST(StreamingSamplerTester, checkShotFile) {
+  std::mt19937_64 rng(7);
+  const std::vector<StreamingSampler::Outcome> outcomes{
+      {0b01, 5}, {0b10, 300}, {0b11, 1000}};
+  const std::string fileName = "streaming_sampler_test.shots";
+  ShotFileWriter::write(fileName, outcomes, 2, rng, 256);
+
+  ShotFileReader reader(fileName);
+  EXPECT_EQ(reader.nbBits(), 2);
+  EXPECT_EQ(reader.nbShots(), 1305);
+  std::map<uint64_t, uint64_t> counts;
+  std::vector<uint64_t> shots;
+  int nbChunks = 0;
+  while (reader.next(shots)) {
+    EXPECT_LE(shots.size(), 256);
+    for (const auto &shot : shots) {
+      counts[shot]++;
+    }
+    nbChunks++;
+  }
+  EXPECT_EQ(nbChunks, 6);
+  for (const auto &[key, count] : outcomes) {
+    EXPECT_EQ(counts[key], count);
+  }
+  std::remove(fileName.c_str());
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -1005,32 +1005,32 @@ double PauliOperator::calcExpValFromGroupedExecution(
   const auto bit_order = resultBuffer->name().find("MSB") != std::string::npos
                              ? AcceleratorBuffer::BitOrder::MSB
                              : AcceleratorBuffer::BitOrder::LSB;
-  auto temp_buffer = xacc::qalloc(resultBuffer->size());
+  // Measured bits of each term: the term expectation value is the parity of
+  // these bits, all terms are reduced in one pass over the (packed) counts.
+  std::vector<std::vector<int>> termMeasBits;
+  std::vector<std::complex<double>> termCoeffs;
   for (auto &inst : terms) {
     Term spinInst = inst.second;
-    std::vector<int> meas_bits;
     if (!spinInst.isIdentity()) {
-      // std::cout << "Term: " << inst.first << "\n";
+      std::vector<int> meas_bits;
       auto [v, w] = spinInst.toBinaryVector(resultBuffer->size());
       assert(v.size() == w.size());
       for (int i = 0; i < v.size(); ++i) {
-        // std::cout << "v = " << v[i] << "; w = " << w[i] << "\n";
         if (v[i] != 0 || w[i] != 0) {
           // Has an operator here:
           meas_bits.emplace_back(i);
         }
       }
-
-      temp_buffer->setMeasurements(
-          resultBuffer->getMarginalCounts(meas_bits, bit_order));
-      const auto coeff = spinInst.coeff();
-      const double term_exp_val = temp_buffer->getExpectationValueZ();
-      // temp_buffer->print();
-      // std::cout << "Exp = " << term_exp_val << "\n";
-      // std::cout << "Coeff = " << coeff << "\n";
-      energy += (term_exp_val * coeff);
+      termMeasBits.emplace_back(std::move(meas_bits));
+      termCoeffs.emplace_back(spinInst.coeff());
     }
   }
+
+  const auto termExpVals =
+      resultBuffer->getParityExpectationValues(termMeasBits, bit_order);
+  for (int i = 0; i < termExpVals.size(); ++i) {
+    energy += (termExpVals[i] * termCoeffs[i]);
+  }
   return energy.real();
 }
 
@@ -23,6 +23,7 @@
 #include "xacc_observable.hpp"
 #include "Circuit.hpp"
 #include "AlgorithmGradientStrategy.hpp"
+#include "PauliTermAssembly.hpp"
 
 #include <complex>
 #include <cstddef>
@@ -188,42 +189,17 @@ void ADAPT::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
   auto operators = pool->generate(buffer->size());
   std::vector<int> ansatzOps;
 
-  // Vector of commutators, need to compute them only once
-  std::vector<std::shared_ptr<Observable>> commutators;
-  if (subAlgorithm == "QAOA") {
-
-    std::complex<double> i(0, 1);
-    for (auto &op : operators) {
-
-      auto comm = observable->commutator(op);
+  // Commutators [H, A_i] (x i for QAOA) are computed only once, in
+  // parallel; their unique Pauli terms are measured once per iteration.
+  PauliTermAssembly commutators;
+  commutators.build(operators.size(), [&](std::size_t idx) {
+    auto comm = observable->commutator(operators[idx]);
+    if (subAlgorithm == "QAOA") {
       auto &tmp = *std::dynamic_pointer_cast<PauliOperator>(comm);
-      tmp = tmp * i;
-      commutators.push_back(std::make_shared<PauliOperator>(tmp));
-    }
-
-  } else {
-
-    for (auto &op : operators) {
-      commutators.push_back(observable->commutator(op));
-    }
-  }
-
-  // Gather all unique commutator terms
-  std::map<std::string, std::shared_ptr<Observable>> uniqueCommutatorTerms;
-  for (auto &commutator : commutators) {
-
-    for (auto &term : commutator->getSubTerms()) {
-
-      auto termName = std::dynamic_pointer_cast<PauliOperator>(term)
-                          ->getTerms()
-                          .begin()
-                          ->first;
-
-      if (uniqueCommutatorTerms.find(termName) == uniqueCommutatorTerms.end()) {
-        uniqueCommutatorTerms[termName] = term;
-      }
+      tmp = tmp * std::complex<double>(0, 1);
     }
-  }
+    return comm;
+  });
 
   xacc::info("Operator pool: " + pool->name());
   xacc::info("Number of operators in the pool: " +
@@ -256,47 +232,29 @@ void ADAPT::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
       x.insert(x.begin(), 0.01);
     }
 
-    // observe each term with the current ansatz
-    std::vector<std::shared_ptr<CompositeInstruction>> observedKernels;
-    for (auto &term : uniqueCommutatorTerms) {
-
-      std::vector<std::shared_ptr<CompositeInstruction>> termObservedKernel;
-      if (x.empty()) {
-        termObservedKernel = term.second->observe(ansatz);
-      } else {
-        auto tmp_x = x;
-        std::reverse(tmp_x.begin(), tmp_x.end());
-        auto evaled = ansatz->operator()(tmp_x);
-        termObservedKernel = term.second->observe(evaled);
-      }
-      observedKernels.insert(observedKernels.end(), termObservedKernel.begin(),
-                             termObservedKernel.end());
+    // observe each unique term with the current ansatz
+    std::shared_ptr<CompositeInstruction> evaled = ansatz;
+    if (!x.empty()) {
+      auto tmp_x = x;
+      std::reverse(tmp_x.begin(), tmp_x.end());
+      evaled = ansatz->operator()(tmp_x);
     }
+    auto observedKernels = commutators.observe(evaled);
 
     // execute all unique terms
     auto tmpBuffer = xacc::qalloc(buffer->size());
     accelerator->execute(tmpBuffer, observedKernels);
-
-    std::map<std::string, std::shared_ptr<AcceleratorBuffer>> termToBuffer;
-    for (auto &buffer : tmpBuffer->getChildren()) {
-      termToBuffer[buffer->name()] = buffer;
-    }
+    const auto commutatorValues =
+        commutators.evaluate(commutators.termValues(tmpBuffer->getChildren()));
 
     int maxCommutatorIdx = 0;
     double maxCommutator = 0.0, gradientNorm = 0.0;
 
     // compute the commutators
-    for (int operatorIdx = 0; operatorIdx < commutators.size(); operatorIdx++) {
-
-      double commutatorValue = 0.0;
-      for (auto &term : commutators[operatorIdx]->getNonIdentitySubTerms()) {
-        auto termName = std::dynamic_pointer_cast<PauliOperator>(term)
-                            ->getTerms()
-                            .begin()
-                            ->first;
-        commutatorValue += std::real(term->coefficient()) *
-                           termToBuffer[termName]->getExpectationValueZ();
-      }
+    for (int operatorIdx = 0; operatorIdx < commutatorValues.size();
+         operatorIdx++) {
+
+      const double commutatorValue = commutatorValues[operatorIdx];
 
       // print commutator above threshold
       if (abs(commutatorValue) > _printThreshold) {
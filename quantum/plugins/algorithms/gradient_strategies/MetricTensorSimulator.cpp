@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "MetricTensorSimulator.hpp"
+#include "GateFusion.hpp"
+#include "ThreadPool.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <iterator>
+#include <numeric>
+
+namespace {
+// Max number of qubits for the state-vector metric simulation.
+constexpr size_t MAX_QUBITS = 30;
+
+// A layer generator applied to the layer snapshot:
+// K_i|psi> and <psi|K_i|psi>.
+struct GeneratorState
+{
+    size_t paramIdx;
+    double expectation;
+    Eigen::VectorXcd state;
+};
+}
+
+namespace xacc {
+namespace algorithm {
+MetricTensorSimulator::MetricTensorSimulator(std::shared_ptr<xacc::CompositeInstruction> in_circuit, const std::vector<double>& in_x):
+    m_nbQubits(0),
+    m_nbParams(in_x.size())
+{
+    auto resolvedCirc = in_x.empty() ? in_circuit : in_circuit->operator()(in_x);
+    if (resolvedCirc->nInstructions() != in_circuit->nInstructions())
+    {
+        xacc::error("Metric tensor simulation requires a flattened circuit.");
+    }
+
+    for (const auto& bit : in_circuit->uniqueBits())
+    {
+        m_nbQubits = std::max(m_nbQubits, bit + 1);
+    }
+    if (m_nbQubits > MAX_QUBITS)
+    {
+        xacc::error("Metric tensor simulation: too many qubits (" + std::to_string(m_nbQubits) + ").");
+    }
+
+    // Pre-compute the (local) matrix of each gate.
+    auto gateRegistry = xacc::getService<IRProvider>("quantum");
+    m_gates.reserve(resolvedCirc->nInstructions());
+    for (size_t instIdx = 0; instIdx < resolvedCirc->nInstructions(); ++instIdx)
+    {
+        auto inst = resolvedCirc->getInstruction(instIdx);
+        GateOp gate;
+        if (inst->isEnabled() && !inst->isComposite() && inst->name() != "Measure")
+        {
+            gate.bits = inst->bits();
+            auto localInst = inst->clone();
+            std::vector<size_t> localBits(gate.bits.size());
+            std::iota(localBits.begin(), localBits.end(), 0);
+            localInst->setBits(localBits);
+            auto tmpKernel = gateRegistry->createComposite("__TMP__");
+            tmpKernel->addInstruction(localInst);
+            gate.matrix = xacc::quantum::GateFuser::fuseGates(tmpKernel, localBits.size());
+        }
+        m_gates.emplace_back(std::move(gate));
+    }
+}
+
+Eigen::VectorXcd MetricTensorSimulator::initialState() const
+{
+    Eigen::VectorXcd state = Eigen::VectorXcd::Zero(1ULL << m_nbQubits);
+    state(0) = 1.0;
+    return state;
+}
+
+void MetricTensorSimulator::apply(Eigen::VectorXcd& io_state, size_t in_begin, size_t in_end) const
+{
+    const size_t stateSize = io_state.size();
+    for (size_t gateIdx = in_begin; gateIdx < in_end; ++gateIdx)
+    {
+        const auto& gate = m_gates[gateIdx];
+        if (gate.bits.empty())
+        {
+            continue;
+        }
+        // Local basis state j <-> offset in the full state vector
+        // (bit l of j is the state of qubit bits[l], as in GateFuser).
+        const size_t localDim = 1ULL << gate.bits.size();
+        std::vector<size_t> offsets(localDim, 0);
+        for (size_t j = 0; j < localDim; ++j)
+        {
+            for (size_t l = 0; l < gate.bits.size(); ++l)
+            {
+                if ((j >> l) & 1)
+                {
+                    offsets[j] |= 1ULL << gate.bits[l];
+                }
+            }
+        }
+        const size_t mask = offsets[localDim - 1];
+        std::vector<std::complex<double>> amplitudes(localDim);
+        for (size_t i = 0; i < stateSize; ++i)
+        {
+            if (i & mask)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < localDim; ++j)
+            {
+                amplitudes[j] = io_state(i | offsets[j]);
+            }
+            for (size_t row = 0; row < localDim; ++row)
+            {
+                std::complex<double> result = 0.0;
+                for (size_t j = 0; j < localDim; ++j)
+                {
+                    result += gate.matrix(row, j) * amplitudes[j];
+                }
+                io_state(i | offsets[row]) = result;
+            }
+        }
+    }
+}
+
+Eigen::VectorXcd MetricTensorSimulator::applyGenerator(const Eigen::VectorXcd& in_state, const InstPtr& in_op) const
+{
+    // Generators of Rx, Ry, Rz: X/2, Y/2, Z/2
+    const auto& name = in_op->name();
+    if (name != "Rx" && name != "Ry" && name != "Rz")
+    {
+        xacc::error("Metric tensor simulation: unsupported parametrized gate " + name);
+    }
+    const size_t bitMask = 1ULL << in_op->bits()[0];
+    const std::complex<double> I(0.0, 1.0);
+    Eigen::VectorXcd result(in_state.size());
+    for (size_t i = 0; i < (size_t)in_state.size(); ++i)
+    {
+        const bool isOne = i & bitMask;
+        if (name == "Rx")
+        {
+            result(i) = 0.5 * in_state(i ^ bitMask);
+        }
+        else if (name == "Ry")
+        {
+            result(i) = (isOne ? 0.5 * I : -0.5 * I) * in_state(i ^ bitMask);
+        }
+        else
+        {
+            result(i) = (isOne ? -0.5 : 0.5) * in_state(i);
+        }
+    }
+    return result;
+}
+
+arma::dmat MetricTensorSimulator::blockDiagonal(const std::vector<ParametrizedCircuitLayer>& in_layers, size_t in_nbThreads) const
+{
+    arma::dmat gMat(m_nbParams, m_nbParams, arma::fill::zeros);
+    // Entry = <psi|KiKj|psi> - <psi|Ki|psi><psi|Kj|psi>
+    const auto computeBlock = [this](const Eigen::VectorXcd& in_psi, const ParametrizedCircuitLayer& in_layer) {
+        std::vector<GeneratorState> generators;
+        for (size_t i = 0; i < in_layer.ops.size(); ++i)
+        {
+            auto kPsi = applyGenerator(in_psi, in_layer.ops[i]);
+            const double expectation = in_psi.dot(kPsi).real();
+            generators.emplace_back(GeneratorState{ in_layer.paramInds[i], expectation, std::move(kPsi) });
+        }
+        arma::dmat blockMat(generators.size(), generators.size());
+        for (size_t i = 0; i < generators.size(); ++i)
+        {
+            for (size_t j = 0; j < generators.size(); ++j)
+            {
+                blockMat(i, j) = generators[i].state.dot(generators[j].state).real() -
+                                 generators[i].expectation * generators[j].expectation;
+            }
+        }
+        return blockMat;
+    };
+
+    // Simulate the circuit once: each block is computed from its layer
+    // snapshot while the simulation continues.
+    std::vector<std::future<arma::dmat>> blocks;
+    {
+        ThreadPool pool(in_nbThreads);
+        auto state = initialState();
+        size_t gateIdx = 0;
+        for (const auto& layer : in_layers)
+        {
+            apply(state, gateIdx, layer.preOps.size());
+            gateIdx = layer.preOps.size();
+            blocks.emplace_back(pool.enqueue([&computeBlock, &layer, psi = state]() { return computeBlock(psi, layer); }));
+        }
+
+        for (size_t layerIdx = 0; layerIdx < in_layers.size(); ++layerIdx)
+        {
+            const auto blockMat = blocks[layerIdx].get();
+            const auto& paramInds = in_layers[layerIdx].paramInds;
+            for (size_t i = 0; i < paramInds.size(); ++i)
+            {
+                for (size_t j = 0; j < paramInds.size(); ++j)
+                {
+                    gMat(paramInds[i], paramInds[j]) += blockMat(i, j);
+                }
+            }
+        }
+    }
+
+    return gMat;
+}
+
+arma::dmat MetricTensorSimulator::full(const std::vector<ParametrizedCircuitLayer>& in_layers, size_t in_nbThreads) const
+{
+    // For parameters i (layer a) and j (layer b >= a):
+    // g_ij = Re(<psi_a|Ki V_ab^dagger Kj|psi_b>) - <Ki>_a <Kj>_b
+    // where V_ab is the circuit between the two layer snapshots,
+    // hence Ki|psi_a> is propagated along with the state.
+    arma::dmat gMat(m_nbParams, m_nbParams, arma::fill::zeros);
+    ThreadPool pool(in_nbThreads);
+    std::vector<GeneratorState> propagated;
+    auto state = initialState();
+    size_t gateIdx = 0;
+    for (const auto& layer : in_layers)
+    {
+        const size_t layerBegin = layer.preOps.size();
+        std::vector<std::future<void>> propagations;
+        for (auto& generator : propagated)
+        {
+            propagations.emplace_back(pool.enqueue([this, &generator, gateIdx, layerBegin]() {
+                apply(generator.state, gateIdx, layerBegin);
+            }));
+        }
+        apply(state, gateIdx, layerBegin);
+        for (auto& propagation : propagations)
+        {
+            propagation.get();
+        }
+        gateIdx = layerBegin;
+
+        std::vector<GeneratorState> current;
+        for (size_t i = 0; i < layer.ops.size(); ++i)
+        {
+            auto kPsi = applyGenerator(state, layer.ops[i]);
+            const double expectation = state.dot(kPsi).real();
+            current.emplace_back(GeneratorState{ layer.paramInds[i], expectation, std::move(kPsi) });
+        }
+
+        // Diagonal block
+        for (const auto& gi : current)
+        {
+            for (const auto& gj : current)
+            {
+                gMat(gi.paramIdx, gj.paramIdx) += gi.state.dot(gj.state).real() - gi.expectation * gj.expectation;
+            }
+        }
+
+        // Off-diagonal blocks (previous layers x this layer)
+        std::vector<std::future<std::vector<double>>> rows;
+        for (const auto& gi : propagated)
+        {
+            rows.emplace_back(pool.enqueue([&gi, &current]() {
+                std::vector<double> row;
+                row.reserve(current.size());
+                for (const auto& gj : current)
+                {
+                    row.emplace_back(gi.state.dot(gj.state).real() - gi.expectation * gj.expectation);
+                }
+                return row;
+            }));
+        }
+        for (size_t i = 0; i < propagated.size(); ++i)
+        {
+            const auto row = rows[i].get();
+            for (size_t j = 0; j < current.size(); ++j)
+            {
+                gMat(propagated[i].paramIdx, current[j].paramIdx) += row[j];
+                gMat(current[j].paramIdx, propagated[i].paramIdx) += row[j];
+            }
+        }
+
+        std::move(current.begin(), current.end(), std::back_inserter(propagated));
+    }
+
+    return gMat;
+}
+}
+}
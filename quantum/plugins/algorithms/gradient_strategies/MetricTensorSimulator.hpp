@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include "QuantumNaturalGradient.hpp"
+#include <Eigen/Dense>
+
+namespace xacc {
+namespace algorithm {
+// Computes the Fubini-Study metric tensor of a parametrized circuit
+// by state-vector simulation, i.e. without executing any circuit:
+// the circuit is simulated once, the state is snapshotted at each
+// parametrized layer boundary, and all the entries of a layer block
+// are computed from that snapshot with direct generator expectations.
+class MetricTensorSimulator
+{
+public:
+    MetricTensorSimulator(std::shared_ptr<xacc::CompositeInstruction> in_circuit, const std::vector<double>& in_x);
+    // Block-diagonal approximation (one block per layer).
+    // Blocks are computed in parallel, while the simulation continues.
+    arma::dmat blockDiagonal(const std::vector<ParametrizedCircuitLayer>& in_layers, size_t in_nbThreads = 0) const;
+    // Full metric tensor: K_i|psi> is also propagated to the subsequent
+    // layers to compute the off-diagonal blocks, i.e. one extra state vector
+    // per parameter (propagated in parallel).
+    arma::dmat full(const std::vector<ParametrizedCircuitLayer>& in_layers, size_t in_nbThreads = 0) const;
+
+private:
+    struct GateOp
+    {
+        std::vector<size_t> bits;
+        Eigen::MatrixXcd matrix;
+    };
+    // Apply the (resolved) instructions [in_begin, in_end) to the state.
+    void apply(Eigen::VectorXcd& io_state, size_t in_begin, size_t in_end) const;
+    // K|psi>, K being the generator of a parametrized gate (e.g. X/2 for Rx)
+    Eigen::VectorXcd applyGenerator(const Eigen::VectorXcd& in_state, const InstPtr& in_op) const;
+    Eigen::VectorXcd initialState() const;
+
+private:
+    size_t m_nbQubits;
+    size_t m_nbParams;
+    std::vector<GateOp> m_gates;
+};
+}
+}
@@ -12,6 +12,7 @@
  *******************************************************************************/
 
 #include "QuantumNaturalGradient.hpp"
+#include "MetricTensorSimulator.hpp"
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include <cassert>
@@ -36,6 +37,12 @@ std::optional<xacc::quantum::PauliOperator> getGenerator(const InstPtr& in_inst)
 
     return std::nullopt;
 }
+
+// The same term can be observed in different layers (different states).
+std::string metricTermKey(size_t in_layerIdx, xacc::quantum::PauliOperator& in_term)
+{
+    return std::to_string(in_layerIdx) + ":" + in_term.toString();
+}
 }
 namespace xacc {
 namespace algorithm {
@@ -45,6 +52,33 @@ bool QuantumNaturalGradient::initialize(const HeterogeneousMap in_parameters)
     m_layers.clear();
     m_nbMetricTensorKernels = 0;
     m_metricTermToIdx.clear();
+    m_simulateMetric = false;
+    m_fullMetric = false;
+    m_nbThreads = 0;
+    if (in_parameters.keyExists<bool>("metric-simulation"))
+    {
+        m_simulateMetric = in_parameters.get<bool>("metric-simulation");
+    }
+    if (in_parameters.stringExists("metric-tensor"))
+    {
+        const auto metricType = in_parameters.getString("metric-tensor");
+        if (metricType != "block-diagonal" && metricType != "full")
+        {
+            xacc::error("Unknown 'metric-tensor' type: " + metricType + ". Valid types: 'block-diagonal' or 'full'.");
+            return false;
+        }
+        m_fullMetric = (metricType == "full");
+    }
+    if (m_fullMetric && !m_simulateMetric)
+    {
+        xacc::error("The 'full' metric tensor requires 'metric-simulation'.");
+        return false;
+    }
+    if (in_parameters.keyExists<int>("metric-threads"))
+    {
+        m_nbThreads = in_parameters.get<int>("metric-threads");
+    }
+
     // User can provide a regular gradient strategy.
     // Note: this natural gradient requires a base gradient strategy.
     if (in_parameters.pointerLikeExists<AlgorithmGradientStrategy>("gradient-strategy"))
@@ -77,9 +111,18 @@ std::vector<std::shared_ptr<CompositeInstruction>> QuantumNaturalGradient::getGr
 {
     auto baseGradientKernels = m_gradientStrategy->getGradientExecutions(in_circuit, in_x);
     m_nbMetricTensorKernels = 0;
+    m_metricTermToIdx.clear();
     // Layering the circuit:
     m_layers = ParametrizedCircuitLayer::toParametrizedLayers(in_circuit);
     m_nbParams = in_x.size();
+    if (m_simulateMetric)
+    {
+        // Only the base gradient circuits need to be executed.
+        MetricTensorSimulator simulator(in_circuit, in_x);
+        m_simulatedMetric = m_fullMetric ? simulator.full(m_layers, m_nbThreads) : simulator.blockDiagonal(m_layers, m_nbThreads);
+        return baseGradientKernels;
+    }
+
     std::vector<std::string> paramNames;
     assert(in_circuit->getVariables().size() == in_x.size());
     for (const auto& param : in_circuit->getVariables())
@@ -88,8 +131,9 @@ std::vector<std::shared_ptr<CompositeInstruction>> QuantumNaturalGradient::getGr
     }
 
     std::vector<std::shared_ptr<CompositeInstruction>>  metricTensorKernels;
-    for (auto& layer : m_layers)
+    for (size_t layerIdx = 0; layerIdx < m_layers.size(); ++layerIdx)
     {
+        auto& layer = m_layers[layerIdx];
         auto kernels = constructMetricTensorSubCircuit(layer, paramNames, in_x);
         
         // Insert *non-identity* kernels only
@@ -103,7 +147,7 @@ std::vector<std::shared_ptr<CompositeInstruction>> QuantumNaturalGradient::getGr
             if (!isIdentityTerm(layer.kiTerms[i]))
             {
                 metricTensorKernels.emplace_back(kernels[kernelIdx]);
-                m_metricTermToIdx.emplace(layer.kiTerms[i].toString(), metricTensorKernels.size() - 1);
+                m_metricTermToIdx.emplace(metricTermKey(layerIdx, layer.kiTerms[i]), metricTensorKernels.size() - 1);
             }
             kernelIdx++;
         }        
@@ -113,7 +157,7 @@ std::vector<std::shared_ptr<CompositeInstruction>> QuantumNaturalGradient::getGr
             if (!isIdentityTerm(layer.kikjTerms[i]))
             {
                 metricTensorKernels.emplace_back(kernels[kernelIdx]);
-                m_metricTermToIdx.emplace(layer.kikjTerms[i].toString(), metricTensorKernels.size());
+                m_metricTermToIdx.emplace(metricTermKey(layerIdx, layer.kikjTerms[i]), metricTensorKernels.size() - 1);
             }
             kernelIdx++;
         }  
@@ -126,7 +170,7 @@ std::vector<std::shared_ptr<CompositeInstruction>> QuantumNaturalGradient::getGr
 
 void QuantumNaturalGradient::compute(std::vector<double>& out_dx, std::vector<std::shared_ptr<AcceleratorBuffer>> in_results)
 {
-    assert(m_nbMetricTensorKernels > 0 && in_results.size() > m_nbMetricTensorKernels);
+    assert(m_simulateMetric || (m_nbMetricTensorKernels > 0 && in_results.size() > m_nbMetricTensorKernels));
     const auto iterPos = in_results.begin() + (in_results.size() - m_nbMetricTensorKernels);
     // Split the results: regular gradient results + metric tensor results.
     std::vector<std::shared_ptr<AcceleratorBuffer>> baseResults;
@@ -137,7 +181,7 @@ void QuantumNaturalGradient::compute(std::vector<double>& out_dx, std::vector<st
     // Calculate the raw gradients (using a regular gradient strategy)
     m_gradientStrategy->compute(rawDx, baseResults);
     // Solve the natural gradient equation:
-    const auto gMat = constructMetricTensorMatrix(metricTensorResults);
+    const auto gMat = m_simulateMetric ? m_simulatedMetric : constructMetricTensorMatrix(metricTensorResults);
     arma::dvec gradients(rawDx); 
     arma::dvec newGrads = arma::solve(gMat, gradients);
     // std::cout << "Regular gradients:\n" << gradients << "\n";
@@ -221,8 +265,9 @@ arma::dmat QuantumNaturalGradient::constructMetricTensorMatrix(const std::vector
 {   
     arma::dmat gMat(m_nbParams, m_nbParams, arma::fill::zeros);
     size_t blockIdx = 0;
-    for (auto& layer : m_layers)
+    for (size_t layerIdx = 0; layerIdx < m_layers.size(); ++layerIdx)
     {
+        const auto& layer = m_layers[layerIdx];
         const auto nbParamsInBlock = layer.paramInds.size();
         // Constructs the block diagonal matrices
         arma::dmat blockMat(nbParamsInBlock, nbParamsInBlock, arma::fill::zeros);
@@ -240,11 +285,12 @@ arma::dmat QuantumNaturalGradient::constructMetricTensorMatrix(const std::vector
                 auto secondOrderTerm = layer.kiTerms[i] * layer.kiTerms[j];
                 
                 const auto getExpectationForTerm = [&](xacc::quantum::PauliOperator& in_pauli){
-                    if (m_metricTermToIdx.find(in_pauli.toString()) == m_metricTermToIdx.end())
+                    const auto iter = m_metricTermToIdx.find(metricTermKey(layerIdx, in_pauli));
+                    if (iter == m_metricTermToIdx.end())
                     {
                         return 1.0;
                     }
-                    return in_results[m_metricTermToIdx[in_pauli.toString()]]->getExpectationValueZ();
+                    return in_results[iter->second]->getExpectationValueZ();
                 };
 
                 const double firstOrderTerm1Exp = getExpectationForTerm(firstOrderTerm1);
@@ -314,7 +360,7 @@ std::vector<ParametrizedCircuitLayer> ParametrizedCircuitLayer::toParametrizedLa
                     qubitsInLayer.clear();
                 }
                 currentLayer.ops.emplace_back(inst);
-                currentLayer.paramInds.emplace_back(std::distance(iter, variables.begin()));
+                currentLayer.paramInds.emplace_back(std::distance(variables.begin(), iter));
                 qubitsInLayer.emplace(bitIdx);
             } 
             else
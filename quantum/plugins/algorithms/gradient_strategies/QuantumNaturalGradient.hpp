@@ -68,6 +68,13 @@ private:
     // Keeps track of the term and the index in the kernel sequence.
     std::unordered_map<std::string, size_t> m_metricTermToIdx;
     size_t m_nbParams;
+    // Simulator fast path: the metric tensor is computed by state-vector
+    // simulation in getGradientExecutions, no metric circuits are executed.
+    bool m_simulateMetric;
+    // Full metric tensor (simulation only) rather than block-diagonal.
+    bool m_fullMetric;
+    int m_nbThreads;
+    arma::dmat m_simulatedMetric;
 };
 }
 }
@@ -15,6 +15,7 @@
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include "QuantumNaturalGradient.hpp"
+#include "MetricTensorSimulator.hpp"
 #include "Observable.hpp"
 
 using namespace xacc;
@@ -205,6 +206,64 @@ TEST(QuantumNatualGradientTester, testSingleQubitRotations)
     EXPECT_NEAR(finalCostValue, -1.0, 0.1);
 } 
 
+TEST(QuantumNatualGradientTester, checkMetricSimulation)
+{
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void metricRxRy(qbit q, double t0, double t1) {
+        Rx(q[0], t0);
+        Ry(q[0], t1);
+    }
+    __qpu__ void metricRyRy(qbit q, double t0, double t1) {
+        Ry(q[0], t0);
+        Ry(q[0], t1);
+    })", nullptr);
+    const std::vector<double> params { 0.432, -0.123 };
+    {
+        // g = diag(1/4, cos^2(t0)/4): off-diagonal entries vanish.
+        auto program = ir->getComposite("metricRxRy");
+        auto layers = ParametrizedCircuitLayer::toParametrizedLayers(program);
+        MetricTensorSimulator simulator(program, params);
+        for (const auto& gMat : { simulator.blockDiagonal(layers), simulator.full(layers, 2) })
+        {
+            EXPECT_NEAR(gMat(0, 0), 0.25, 1e-9);
+            EXPECT_NEAR(gMat(1, 1), 0.25 * std::cos(params[0]) * std::cos(params[0]), 1e-9);
+            EXPECT_NEAR(gMat(0, 1), 0.0, 1e-9);
+            EXPECT_NEAR(gMat(1, 0), 0.0, 1e-9);
+        }
+    }
+    {
+        // Same generator: all entries are 1/4, the block-diagonal
+        // approximation drops the off-diagonal ones.
+        auto program = ir->getComposite("metricRyRy");
+        auto layers = ParametrizedCircuitLayer::toParametrizedLayers(program);
+        EXPECT_EQ(layers.size(), 2);
+        MetricTensorSimulator simulator(program, params);
+        const auto gBlock = simulator.blockDiagonal(layers);
+        const auto gFull = simulator.full(layers);
+        for (size_t i = 0; i < 2; ++i)
+        {
+            for (size_t j = 0; j < 2; ++j)
+            {
+                EXPECT_NEAR(gFull(i, j), 0.25, 1e-9);
+                EXPECT_NEAR(gBlock(i, j), i == j ? 0.25 : 0.0, 1e-9);
+            }
+        }
+    }
+    {
+        // No metric tensor circuits with the simulator fast path
+        auto program = ir->getComposite("metricRxRy");
+        std::shared_ptr<Observable> observable = std::make_shared<xacc::quantum::PauliOperator>();
+        observable->fromString("Z0");
+        auto qng = xacc::getService<AlgorithmGradientStrategy>("quantum-natural-gradient");
+        EXPECT_TRUE(qng->initialize({ std::make_pair("observable", observable),
+                                      std::make_pair("metric-simulation", true),
+                                      std::make_pair("metric-tensor", "full") }));
+        auto kernels = qng->getGradientExecutions(program, params);
+        // Central difference: 2 circuits per parameter
+        EXPECT_EQ(kernels.size(), 4);
+    }
+}
+
 int main(int argc, char **argv) 
 {
     xacc::Initialize(argc, argv);
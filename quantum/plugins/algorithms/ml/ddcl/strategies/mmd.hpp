@@ -25,6 +25,26 @@ namespace algorithm {
 
 class MMDLossStrategy : public LossStrategy {
 protected:
+  // The kernel matrix only depends on the number of bits and the
+  // bandwidths: build it once instead of at every loss evaluation.
+  Eigen::MatrixXd cachedKernel;
+  int cachedNumBit = -1;
+  std::vector<double> cachedSigmas;
+
+  const Eigen::MatrixXd &kernel(int num_bit,
+                                const std::vector<double> &sigma_list) {
+    if (num_bit != cachedNumBit || sigma_list != cachedSigmas) {
+      std::vector<int> basis(1 << num_bit);
+      for (int i = 0; i < basis.size(); i++) {
+        basis[i] = i;
+      }
+      cachedKernel = mix_rbf_kernel(basis, basis, sigma_list, num_bit);
+      cachedNumBit = num_bit;
+      cachedSigmas = sigma_list;
+    }
+    return cachedKernel;
+  }
+
   // Helper functions
   Eigen::MatrixXd mix_rbf_kernel(std::vector<int> x,std::vector<int> y,
                                  std::vector<double> sigma_list, int num_bit){
@@ -64,13 +84,12 @@ protected:
       return K;
   }
 
-  double kernel_expect(Eigen::MatrixXd K,
-                       std::vector<double> px,
-                       std::vector<double>  py){
-    int len = px.size();
-    //This takes px and py and turns them into eigen::Vector objects
-    Eigen::VectorXd P = Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(px.data(), px.size());
-    Eigen::VectorXd Q = Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(py.data(), py.size());
+  double kernel_expect(const Eigen::MatrixXd &K,
+                       const std::vector<double> &px,
+                       const std::vector<double> &py){
+    //This maps px and py onto eigen::Vector objects (no copy)
+    Eigen::Map<const Eigen::VectorXd> P(px.data(), px.size());
+    Eigen::Map<const Eigen::VectorXd> Q(py.data(), py.size());
 
     auto temp = K*Q;
     double expectation = P.dot(temp);
@@ -109,13 +128,8 @@ public:
     //loss?
     int num_bit = (int)log2(target.size());
 
-    std::vector<int> basis(pow(2,num_bit));
-    for(int i = 0; i < pow(2,num_bit); i++){
-      basis[i] = i;
-    }
-
     std::vector<double> sigma_list = {0.25};
-    Eigen::MatrixXd K = mix_rbf_kernel(basis, basis, sigma_list, num_bit);
+    const Eigen::MatrixXd &K = kernel(num_bit, sigma_list);
     auto mmd = kernel_expect(K, pxy, pxy);
 
     return std::make_pair(mmd, q);
@@ -141,19 +155,23 @@ public:
   protected:
     std::vector<double> currentParameterSet;
 
-    double kernel_expect(Eigen::MatrixXd K,
-                         std::vector<double> px,
-                         std::vector<double>  py){
-      int len = px.size();
-      //This takes px and py and turns them into eigen::Vector objects
-      //YOU_CALLED_A_FIXED_SIZE_METHOD_ON_A_DYNAMIC_SIZE_MATRIX
-      Eigen::VectorXd P = Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(px.data(), px.size());
-      Eigen::VectorXd Q = Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(py.data(), py.size());
-
-      double expectation = P.dot(K*Q);
-
-
-      return expectation;
+    // Cached kernel matrix (see MMDLossStrategy::kernel)
+    Eigen::MatrixXd cachedKernel;
+    int cachedNumBit = -1;
+    std::vector<double> cachedSigmas;
+
+    const Eigen::MatrixXd &kernel(int num_bit,
+                                  const std::vector<double> &sigma_list) {
+      if (num_bit != cachedNumBit || sigma_list != cachedSigmas) {
+        std::vector<int> basis(1 << num_bit);
+        for (int i = 0; i < basis.size(); i++) {
+          basis[i] = i;
+        }
+        cachedKernel = mix_rbf_kernel(basis, basis, sigma_list, num_bit);
+        cachedNumBit = num_bit;
+        cachedSigmas = sigma_list;
+      }
+      return cachedKernel;
     }
 
     Eigen::MatrixXd mix_rbf_kernel(std::vector<int> x,std::vector<int> y,
@@ -282,23 +300,20 @@ public:
 
       std::vector<double> sigma_list = {0.1};
       int num_bit = (int) log2(q_dist.size());
-      std::vector<int> basis(pow(2,num_bit));
-      for(int i = 0; i < pow(2,num_bit); i++){
-        basis[i] = i;
-      }
-      Eigen::MatrixXd K = mix_rbf_kernel(basis, basis, sigma_list, num_bit);
-      //compute gradient vector
-      std::vector<double> grad_pos(counter);
-      std::vector<double> grad_neg(counter);
-      std::vector<double> grad_pos_targ(counter);
-      std::vector<double> grad_neg_targ(counter);
-
+      const Eigen::MatrixXd &K = kernel(num_bit, sigma_list);
+      //compute gradient vector: K is symmetric, hence
+      // qp.K.q - qp.K.t - qm.K.q + qm.K.t = (qp - qm).K.(q - t)
+      // and K.(q - t) is shared by all parameters.
+      Eigen::Map<const Eigen::VectorXd> Q(q_dist.data(), q_dist.size());
+      Eigen::Map<const Eigen::VectorXd> T(target_dist.data(),
+                                          target_dist.size());
+      const Eigen::VectorXd KD = K * (Q - T);
       for(int i = 0; i < counter; i++){
-        grad_pos[i] = kernel_expect(K, qplus_theta[i], q_dist);
-        grad_neg[i] = kernel_expect(K, qminus_theta[i], q_dist);
-        grad_pos_targ[i] = kernel_expect(K, qplus_theta[i], target_dist);
-        grad_neg_targ[i] = kernel_expect(K, qminus_theta[i], target_dist);
-        grad[i] = grad_pos[i]-grad_pos_targ[i]-grad_neg[i]+grad_neg_targ[i];
+        Eigen::Map<const Eigen::VectorXd> QP(qplus_theta[i].data(),
+                                             qplus_theta[i].size());
+        Eigen::Map<const Eigen::VectorXd> QM(qminus_theta[i].data(),
+                                             qminus_theta[i].size());
+        grad[i] = (QP - QM).dot(KD);
       }
       return;
     }
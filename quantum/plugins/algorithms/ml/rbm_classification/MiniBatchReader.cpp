@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#include "MiniBatchReader.hpp"
+#include "ThreadPool.hpp"
+#include "xacc.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char binaryMagic[8] = {'X', 'A', 'C', 'C', 'M', 'A', 'T', '1'};
+const std::size_t binaryHeaderSize = 8 + 2 * sizeof(std::uint64_t);
+
+// Parse the comma separated values of [begin, end) into out,
+// returns the number of values.
+std::size_t parseCsvLine(const char *begin, const char *end, double *out) {
+  // strtod needs a null-terminated string
+  std::string line(begin, end);
+  const char *ptr = line.c_str();
+  std::size_t count = 0;
+  while (*ptr != '\0') {
+    char *next = nullptr;
+    const double value = std::strtod(ptr, &next);
+    if (next == ptr) {
+      xacc::error("MiniBatchReader: invalid CSV value in line '" + line + "'");
+    }
+    if (out) {
+      out[count] = value;
+    }
+    ++count;
+    ptr = next;
+    while (*ptr == ' ' || *ptr == '\r' || *ptr == '\t') {
+      ++ptr;
+    }
+    if (*ptr == ',') {
+      ++ptr;
+    }
+  }
+  return count;
+}
+
+// True if the first value of the line is not a number, i.e. a header row
+// (e.g. column names).
+bool isHeaderLine(const char *begin, const char *end) {
+  std::string line(begin, end);
+  char *next = nullptr;
+  std::strtod(line.c_str(), &next);
+  return next == line.c_str();
+}
+} // namespace
+
+namespace xacc {
+namespace algorithm {
+
+MiniBatchReader::MiniBatchReader(const std::string &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    xacc::error("MiniBatchReader: cannot open " + path);
+  }
+  struct stat st;
+  fstat(fd, &st);
+  fileSize = st.st_size;
+  if (fileSize == 0) {
+    close(fd);
+    xacc::error("MiniBatchReader: empty file " + path);
+  }
+  void *mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    xacc::error("MiniBatchReader: cannot map " + path);
+  }
+  data = static_cast<const char *>(mapped);
+
+  if (fileSize >= binaryHeaderSize &&
+      std::memcmp(data, binaryMagic, sizeof(binaryMagic)) == 0) {
+    binary = true;
+    std::uint64_t shape[2];
+    std::memcpy(shape, data + sizeof(binaryMagic), sizeof(shape));
+    nRows = shape[0];
+    nCols = shape[1];
+    if (fileSize < binaryHeaderSize + nRows * nCols * sizeof(double)) {
+      xacc::error("MiniBatchReader: truncated binary file " + path);
+    }
+    return;
+  }
+
+  // CSV: index the data lines
+  std::size_t begin = 0;
+  bool headerSkipped = false;
+  while (begin < fileSize) {
+    const char *eol = static_cast<const char *>(
+        std::memchr(data + begin, '\n', fileSize - begin));
+    const std::size_t end = eol ? eol - data : fileSize;
+    std::size_t first = begin;
+    while (first < end && (data[first] == ' ' || data[first] == '\r')) {
+      ++first;
+    }
+    if (first < end && data[first] != '#') {
+      if (rowOffsets.empty()) {
+        if (!headerSkipped && isHeaderLine(data + first, data + end)) {
+          // Plain (non-commented) header row
+          headerSkipped = true;
+          begin = end + 1;
+          continue;
+        }
+        nCols = parseCsvLine(data + begin, data + end, nullptr);
+      }
+      rowOffsets.push_back(begin);
+    }
+    begin = end + 1;
+  }
+  nRows = rowOffsets.size();
+  if (nRows == 0) {
+    xacc::error("MiniBatchReader: no data in " + path);
+  }
+}
+
+MiniBatchReader::~MiniBatchReader() {
+  if (data) {
+    munmap(const_cast<char *>(data), fileSize);
+  }
+}
+
+Eigen::MatrixXd MiniBatchReader::read(const std::size_t *rowIds,
+                                      std::size_t n) const {
+  // Row-major so that each file row is copied contiguously
+  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> batch(
+      n, nCols);
+  for (std::size_t i = 0; i < n; i++) {
+    const auto row = rowIds[i];
+    if (binary) {
+      std::memcpy(batch.row(i).data(),
+                  data + binaryHeaderSize + row * nCols * sizeof(double),
+                  nCols * sizeof(double));
+      continue;
+    }
+    const auto begin = rowOffsets[row];
+    const char *eol = static_cast<const char *>(
+        std::memchr(data + begin, '\n', fileSize - begin));
+    std::vector<double> values(nCols + 1);
+    const auto count =
+        parseCsvLine(data + begin, eol ? eol : data + fileSize, values.data());
+    if (count != nCols) {
+      xacc::error("MiniBatchReader: row " + std::to_string(row) + " has " +
+                  std::to_string(count) + " values, expected " +
+                  std::to_string(nCols));
+    }
+    std::copy(values.begin(), values.begin() + nCols, batch.row(i).data());
+  }
+  return batch;
+}
+
+void MiniBatchReader::writeBinary(const std::string &path,
+                                  const Eigen::MatrixXd &data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(binaryMagic, sizeof(binaryMagic));
+  const std::uint64_t shape[2] = {(std::uint64_t)data.rows(),
+                                  (std::uint64_t)data.cols()};
+  out.write(reinterpret_cast<const char *>(shape), sizeof(shape));
+  const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      rowMajor = data;
+  out.write(reinterpret_cast<const char *>(rowMajor.data()),
+            rowMajor.size() * sizeof(double));
+}
+
+MiniBatchStream::MiniBatchStream(std::shared_ptr<MiniBatchReader> r,
+                                 int size, bool shuffleRows, bool prefetch,
+                                 std::uint64_t seed)
+    : reader(r), batchSize(std::max(1, size)), shuffle(shuffleRows),
+      rng(seed), order(r->rows()) {
+  std::iota(order.begin(), order.end(), 0);
+  if (prefetch) {
+    pool = std::make_unique<ThreadPool>(1);
+  }
+  startEpoch();
+}
+
+MiniBatchStream::~MiniBatchStream() {
+  if (pending.valid()) {
+    pending.wait();
+  }
+}
+
+std::size_t MiniBatchStream::batchesPerEpoch() const {
+  return (order.size() + batchSize - 1) / batchSize;
+}
+
+void MiniBatchStream::startEpoch() {
+  if (shuffle) {
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+  position = 0;
+  pending = readBatch(0);
+}
+
+std::future<Eigen::MatrixXd> MiniBatchStream::readBatch(std::size_t first) {
+  const auto last = std::min(order.size(), first + batchSize);
+  std::vector<std::size_t> rowIds(order.begin() + first, order.begin() + last);
+  auto task = [reader = reader, rowIds = std::move(rowIds)]() {
+    return reader->read(rowIds.data(), rowIds.size());
+  };
+  if (pool) {
+    return pool->enqueue(std::move(task));
+  }
+  return std::async(std::launch::deferred, std::move(task));
+}
+
+bool MiniBatchStream::next(Eigen::MatrixXd &batch) {
+  if (position >= order.size()) {
+    startEpoch();
+    return false;
+  }
+  batch = pending.get();
+  position += batchSize;
+  if (position < order.size()) {
+    // Read the next one while the caller works on this one
+    pending = readBatch(position);
+  }
+  return true;
+}
+
+} // namespace algorithm
+} // namespace xacc
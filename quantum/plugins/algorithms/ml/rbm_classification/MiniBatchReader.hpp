@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_ALGORITHM_RBM_CLASSIFICATION_MINIBATCH_READER_HPP_
+#define XACC_ALGORITHM_RBM_CLASSIFICATION_MINIBATCH_READER_HPP_
+
+#include <Eigen/Dense>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace xacc {
+class ThreadPool;
+namespace algorithm {
+
+// Read-only, memory-mapped view of a training data set, giving random
+// access to its rows without loading the whole file in memory.
+//
+// Two formats are supported:
+// - CSV: one row per line, comma separated; lines starting with '#'
+//   (headers), empty lines and a leading non-numeric header row are
+//   skipped. Only the offset of each row is kept, rows are parsed when read.
+// - Binary: the 8-byte magic "XACCMAT1", the number of rows and columns
+//   (uint64) then the row-major doubles, see writeBinary().
+class MiniBatchReader {
+public:
+  MiniBatchReader(const std::string &path);
+  ~MiniBatchReader();
+  MiniBatchReader(const MiniBatchReader &) = delete;
+  MiniBatchReader &operator=(const MiniBatchReader &) = delete;
+
+  std::size_t rows() const { return nRows; }
+  std::size_t cols() const { return nCols; }
+  bool isBinary() const { return binary; }
+
+  // Return the given rows (n x cols()), thread-safe.
+  Eigen::MatrixXd read(const std::size_t *rowIds, std::size_t n) const;
+
+  // Convert a data set to the binary format (faster to read than CSV).
+  static void writeBinary(const std::string &path, const Eigen::MatrixXd &data);
+
+protected:
+  const char *data = nullptr;
+  std::size_t fileSize = 0;
+  bool binary = false;
+  std::size_t nRows = 0;
+  std::size_t nCols = 0;
+  // CSV only: byte offset of each data row
+  std::vector<std::size_t> rowOffsets;
+};
+
+// Iterates over the mini-batches of a data set, epoch after epoch.
+// Rows are visited in file order, or in a new random order at each epoch if
+// shuffle is enabled. With prefetch, the next mini-batch is read by a worker thread
+// while the caller processes the current one.
+class MiniBatchStream {
+public:
+  MiniBatchStream(std::shared_ptr<MiniBatchReader> reader, int batchSize,
+                  bool shuffle = false, bool prefetch = true,
+                  std::uint64_t seed = std::random_device()());
+  ~MiniBatchStream();
+
+  // Set batch to the next mini-batch of the current epoch (the last one may
+  // be smaller). Returns false, and starts a new epoch, when the current
+  // epoch is over.
+  bool next(Eigen::MatrixXd &batch);
+
+  std::size_t batchesPerEpoch() const;
+
+protected:
+  void startEpoch();
+  std::future<Eigen::MatrixXd> readBatch(std::size_t first);
+
+  std::shared_ptr<MiniBatchReader> reader;
+  std::size_t batchSize;
+  bool shuffle;
+  std::mt19937_64 rng;
+  std::vector<std::size_t> order;
+  // First row (in order) of the next batch to be returned
+  std::size_t position = 0;
+  std::unique_ptr<ThreadPool> pool;
+  std::future<Eigen::MatrixXd> pending;
+};
+} // namespace algorithm
+} // namespace xacc
+#endif
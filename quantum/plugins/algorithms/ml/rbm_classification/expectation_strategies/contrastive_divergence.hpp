@@ -14,49 +14,59 @@
 #define XACC_ALGORITHM_RBM_CLASSIFICATION_CD_HPP_
 
 #include "rbm_classification.hpp"
+#include <random>
 
 namespace xacc {
 namespace algorithm {
 
+// Batched CD-k: k steps of block Gibbs sampling are run in parallel from
+// every row of the mini-batch, each step being one matrix-matrix product
+// (batch_size x nv times nv x nh) instead of one vector product per row.
 class ContrastiveDivergenceExpectationStrategy : public ExpectationStrategy {
 protected:
+  // Seeded once, by the "seed" option of the first call: the draws of the
+  // successive mini-batches must not replay each other.
+  std::mt19937_64 rng{std::random_device()()};
+  bool seeded = false;
 
-  Eigen::VectorXd sample(Eigen::VectorXd& probs) {
-      Eigen::VectorXd tmp = probs + Eigen::VectorXd::Random(probs.size());
-      Eigen::VectorXd tmp2 = tmp.array().floor();
-      return tmp2;
+  static Eigen::MatrixXd sigmoid(const Eigen::MatrixXd &x) {
+    return (1. + (-x.array()).exp()).inverse().matrix();
   }
+
+  // Bernoulli samples of the given probabilities (0 or 1)
+  Eigen::MatrixXd sample(const Eigen::MatrixXd &probs) {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    Eigen::MatrixXd uniform = Eigen::MatrixXd::NullaryExpr(
+        probs.rows(), probs.cols(), [&]() { return dist(rng); });
+    return (uniform.array() < probs.array()).cast<double>().matrix();
+  }
+
 public:
-const std::string name() const override { return "cd"; }
+  const std::string name() const override { return "cd"; }
   const std::string description() const override { return ""; }
   std::tuple<Eigen::MatrixXd, Eigen::VectorXd, Eigen::VectorXd>
   compute(Eigen::MatrixXd &features, Eigen::MatrixXd &w, Eigen::VectorXd &v,
           Eigen::VectorXd &h, HeterogeneousMap options = {}) override {
-
-    Eigen::VectorXd exp_h = options.get<Eigen::VectorXd>("dataexp_h");
-    Eigen::VectorXd h_sample = sample(exp_h);
-
-    Eigen::MatrixXd tmp = h_sample * w.transpose();
-     for (int col = 0; col < tmp.cols(); col++) {
-      for (int row = 0; row < tmp.rows(); row++) {
-        tmp(row, col) += v(col);
-      }
+    const int k = options.keyExists<int>("cd-k") ? options.get<int>("cd-k") : 1;
+    if (!seeded && options.keyExists<int>("seed")) {
+      rng.seed(options.get<int>("seed"));
+      seeded = true;
     }
+    const int batch_size = features.rows();
 
-    // tmp.unaryExpr([](double& x) {return 1./(1.+std::exp(-x));});
-    
-    // Eigen::MatrixXd h_probs = tmp.array().exp();//unaryExpr(s);
-    // h_probs has to be bs x n_v
-
-    Eigen::MatrixXd w_expectation;
-
-    Eigen::VectorXd v_expectation = Eigen::VectorXd::Zero(v.size());
-    Eigen::VectorXd h_expectation = Eigen::VectorXd::Zero(v.size());
+    // features is bs x n_v, w is n_v x n_h
+    Eigen::MatrixXd v_k = features;
+    Eigen::MatrixXd h_probs = sigmoid((v_k * w).rowwise() + h.transpose());
+    for (int step = 0; step < k; step++) {
+      Eigen::MatrixXd h_sample = sample(h_probs);
+      v_k = sample(
+          sigmoid((h_sample * w.transpose()).rowwise() + v.transpose()));
+      h_probs = sigmoid((v_k * w).rowwise() + h.transpose());
+    }
 
-    // for (int i = 0; i < features.rows(); i++) {
-    //   v_expectation(i) = features.row(i).sum() / features.row(i).size();
-    //   h_expectation(i) = h_probs.row(i).sum() / h_probs.row(i).size();
-    // }
+    Eigen::MatrixXd w_expectation = (v_k.transpose() * h_probs) / batch_size;
+    Eigen::VectorXd v_expectation = v_k.colwise().mean().transpose();
+    Eigen::VectorXd h_expectation = h_probs.colwise().mean().transpose();
 
     return std::make_tuple(w_expectation, v_expectation, h_expectation);
   }
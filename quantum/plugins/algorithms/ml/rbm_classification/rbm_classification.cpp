@@ -40,12 +40,30 @@ bool RBMClassification::initialize(const HeterogeneousMap &parameters) {
   if (!xacc::fileExists(train_file)) {
       xacc::error("Invalid train-file, file does not exist:\n" + train_file);
   }
-  training_data = load_csv<Eigen::MatrixXd>(train_file);
+  // Rows are read on demand from the memory-mapped file (CSV or binary).
+  training_data = std::make_shared<MiniBatchReader>(train_file);
   modelExp = "dwave-mcmc";
   if (parameters.stringExists("model-exp-strategy")) {
     modelExp = parameters.getString("model-exp-strategy");
   }
 
+  batchSize = 1;
+  nEpochs = 1;
+  shuffle = false;
+  prefetch = true;
+  if (parameters.keyExists<int>("batch-size")) {
+    batchSize = parameters.get<int>("batch-size");
+  }
+  if (parameters.keyExists<int>("epochs")) {
+    nEpochs = parameters.get<int>("epochs");
+  }
+  if (parameters.keyExists<bool>("shuffle")) {
+    shuffle = parameters.get<bool>("shuffle");
+  }
+  if (parameters.keyExists<bool>("prefetch")) {
+    prefetch = parameters.get<bool>("prefetch");
+  }
+
   _parameters = parameters;
   return true;
 }
@@ -61,8 +79,13 @@ void RBMClassification::execute(
   auto nv = rbm->getParameter(0).as<int>();
   auto nh = rbm->getParameter(1).as<int>();
 
-  int batch_size = 1;
-  int n_batches = training_data.rows() / batch_size;
+  if (training_data->cols() < nv) {
+    xacc::error("RBMClassification: train-file has " +
+                std::to_string(training_data->cols()) +
+                " columns, the RBM has " + std::to_string(nv) +
+                " visible units.");
+  }
+
   double l2reg = 0.0;
   double lr = .01;
 
@@ -71,43 +94,49 @@ void RBMClassification::execute(
   Eigen::VectorXd bh = Eigen::VectorXd::Zero(nh);
   Eigen::VectorXd bv = Eigen::VectorXd::Zero(nv);
 
-  //   std::cout << "Started:\n" << w << "\n";
   // Get the expectation strategies
   auto dataExpectations = xacc::getService<ExpectationStrategy>("data-exp");
   auto modelExpectations = xacc::getService<ExpectationStrategy>(modelExp);
+  const bool isDWave = modelExp == "dwave" || modelExp == "dwave-mcmc";
 
   // Strategy:
-  // loop through data in chunks of batch_size
-  int epoch = 0;
-  for (int batchIdx = 0; batchIdx < n_batches; batchIdx += batch_size) {
-    xacc::debug("Starting Epoch " +std::to_string(epoch));
-    epoch++;
-
-    // batch should be batch_size x nv
-    Eigen::MatrixXd batch = training_data.block(batchIdx, 0, batch_size, nv);
-
-    // Create data exp w, v, and h, as well as model versions
-    Eigen::MatrixXd tmp = Eigen::MatrixXd::Zero(1, 1);
-    Eigen::MatrixXd dataexp_W, modexp_W;
-    Eigen::VectorXd dataexp_v, dataexp_h, modexp_v, modexp_h;
-
-    // Compute the data expectations
-    std::tie(dataexp_W, dataexp_v, dataexp_h) =
-        dataExpectations->compute(batch, w, bv, bh);
-
-    // Compute the model expectations
-    if (modelExp == "dwave" || modelExp == "dwave-mcmc") {
-      std::tie(modexp_W, modexp_v, modexp_h) =
-          modelExpectations->compute(tmp, w, bv, bh, _parameters);
+  // loop through the data (in file order, or shuffled if requested) in
+  // mini-batches of batch_size rows,
+  // the next mini-batch is read while the gradient of this one is computed.
+  std::uint64_t seed = std::random_device()();
+  if (_parameters.keyExists<int>("seed")) {
+    seed = _parameters.get<int>("seed");
+  }
+  MiniBatchStream stream(training_data, batchSize, shuffle, prefetch, seed);
+  Eigen::MatrixXd rows;
+  for (int epoch = 0; epoch < nEpochs; epoch++) {
+    xacc::debug("Starting Epoch " + std::to_string(epoch));
+    while (stream.next(rows)) {
+      // batch should be batch_size x nv
+      Eigen::MatrixXd batch = rows.leftCols(nv);
+
+      // Create data exp w, v, and h, as well as model versions
+      Eigen::MatrixXd tmp = Eigen::MatrixXd::Zero(1, 1);
+      Eigen::MatrixXd dataexp_W, modexp_W;
+      Eigen::VectorXd dataexp_v, dataexp_h, modexp_v, modexp_h;
+
+      // Compute the data expectations
+      std::tie(dataexp_W, dataexp_v, dataexp_h) =
+          dataExpectations->compute(batch, w, bv, bh);
+
+      // Compute the model expectations, sampled from the model only
+      // (D-Wave) or with Gibbs chains started from the batch (CD-k)
+      std::tie(modexp_W, modexp_v, modexp_h) = modelExpectations->compute(
+          isDWave ? tmp : batch, w, bv, bh, _parameters);
+
+      // Get the deltas and update for the next iteration
+      Eigen::MatrixXd wdelta = dataexp_W - modexp_W;
+      Eigen::VectorXd v_delta = dataexp_v - modexp_v;
+      Eigen::VectorXd h_delta = dataexp_h - modexp_h;
+      w = (1. - l2reg) * w + lr * wdelta;
+      bv = (1. - l2reg) * bv + lr * v_delta;
+      bh = (1. - l2reg) * bh + lr * h_delta;
     }
-
-    // Get the deltas and update for the next iteration
-    Eigen::MatrixXd wdelta = dataexp_W - modexp_W;
-    Eigen::VectorXd v_delta = dataexp_v - modexp_v;
-    Eigen::VectorXd h_delta = dataexp_h - modexp_h;
-    w = (1. - l2reg) * w + lr * wdelta;
-    bv = (1. - l2reg) * bv + lr * v_delta;
-    bh = (1. - l2reg) * bh + lr * h_delta;
   }
 
   std::vector<double> wvec(w.data(), w.data() + w.size()),
@@ -14,9 +14,9 @@
 #define XACC_ALGORITHM_RBM_CLASSIFICATION_HPP_
 
 #include "Algorithm.hpp"
+#include "MiniBatchReader.hpp"
 #include <vector>
 #include <Eigen/Dense>
-#include <fstream>
 
 namespace xacc {
 namespace algorithm {
@@ -31,33 +31,15 @@ public:
 class RBMClassification : public Algorithm {
 protected:
   CompositeInstruction* rbm;
-  Eigen::MatrixXd training_data;
+  std::shared_ptr<MiniBatchReader> training_data;
   std::string modelExp;
+  int batchSize = 1;
+  int nEpochs = 1;
+  bool shuffle = false;
+  bool prefetch = true;
 
   HeterogeneousMap _parameters;
 
-  template <typename M> M load_csv(const std::string &path) {
-    std::ifstream indata;
-    indata.open(path);
-    std::string line;
-    std::vector<double> values;
-    int rows = 0;
-    while (std::getline(indata, line)) {
-      if (line[0] != '#') {
-        std::stringstream lineStream(line);
-        std::string cell;
-        while (std::getline(lineStream, cell, ',')) {
-          values.push_back(std::stod(cell));
-        }
-        ++rows;
-      }
-    }
-    return Eigen::Map<
-        const Eigen::Matrix<typename M::Scalar, M::RowsAtCompileTime,
-                            M::ColsAtCompileTime, Eigen::RowMajor>>(
-        values.data(), rows, values.size() / rows);
-  }
-
 public:
   bool initialize(const HeterogeneousMap &parameters) override;
   const std::vector<std::string> requiredParameters() const override;
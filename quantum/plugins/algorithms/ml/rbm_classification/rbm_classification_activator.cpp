@@ -13,6 +13,7 @@
 #include "rbm_classification.hpp"
 #include "classical_data_expectations.hpp"
 #include "dwave_rbm_mcmc_expectations.hpp"
+#include "contrastive_divergence.hpp"
 
 #include "cppmicroservices/BundleActivator.h"
 #include "cppmicroservices/BundleContext.h"
@@ -45,6 +46,10 @@ public:
     auto cdd = std::make_shared<
         xacc::algorithm::DWaveRBM_MCMCDataExpectationStrategy>();
     context.RegisterService<xacc::algorithm::ExpectationStrategy>(cdd);
+
+    auto cdk = std::make_shared<
+        xacc::algorithm::ContrastiveDivergenceExpectationStrategy>();
+    context.RegisterService<xacc::algorithm::ExpectationStrategy>(cdk);
   }
 
   /**
@@ -18,6 +18,11 @@
 
 #include "Optimizer.hpp"
 #include "Algorithm.hpp"
+#include "MiniBatchReader.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <unistd.h>
 
 using namespace xacc;
 
@@ -47,6 +52,72 @@ TEST(RBMClassificationTester, checkSimpleNist) {
 
 }
 
+namespace {
+// Scratch file name, kept out of the working directory
+std::string tmpPath(const std::string &name) {
+  const char *tmpDir = std::getenv("TMPDIR");
+  return std::string(tmpDir ? tmpDir : "/tmp") + "/xacc-" +
+         std::to_string(getpid()) + "-" + name;
+}
+} // namespace
+
+TEST(RBMClassificationTester, checkMiniBatchReader) {
+  using namespace xacc::algorithm;
+  auto csv = std::make_shared<MiniBatchReader>(
+      std::string(XACC_RBM_CLASSIFICATION_TESTS_DIR) +
+      std::string("/data/optdigits_test.csv"));
+  EXPECT_FALSE(csv->isBinary());
+  EXPECT_EQ(999, csv->rows());
+  EXPECT_EQ(65, csv->cols());
+
+  std::vector<std::size_t> allRows(csv->rows());
+  std::iota(allRows.begin(), allRows.end(), 0);
+  Eigen::MatrixXd data = csv->read(allRows.data(), allRows.size());
+  const auto binPath = tmpPath("optdigits_test.bin");
+  MiniBatchReader::writeBinary(binPath, data);
+  auto binary = std::make_shared<MiniBatchReader>(binPath);
+  EXPECT_TRUE(binary->isBinary());
+  EXPECT_EQ(0.0, (binary->read(allRows.data(), allRows.size()) - data).norm());
+
+  // Every row is visited once per epoch, with or without prefetching
+  for (bool prefetch : {true, false}) {
+    MiniBatchStream stream(binary, 100, true, prefetch, 123);
+    EXPECT_EQ(10, stream.batchesPerEpoch());
+    for (int epoch = 0; epoch < 2; epoch++) {
+      Eigen::MatrixXd batch;
+      int nRows = 0;
+      double sum = 0.0;
+      while (stream.next(batch)) {
+        nRows += batch.rows();
+        sum += batch.sum();
+      }
+      EXPECT_EQ(999, nRows);
+      EXPECT_NEAR(data.sum(), sum, 1e-6);
+    }
+  }
+  std::remove(binPath.c_str());
+
+  // Plain header row; rows are visited in file order by default.
+  const auto csvPath = tmpPath("header_test.csv");
+  {
+    std::ofstream out(csvPath);
+    out << "x,y\n1,2\n3,4\n\n5,6\n";
+  }
+  auto withHeader = std::make_shared<MiniBatchReader>(csvPath);
+  EXPECT_EQ(3, withHeader->rows());
+  EXPECT_EQ(2, withHeader->cols());
+  MiniBatchStream stream(withHeader, 2);
+  Eigen::MatrixXd batch;
+  EXPECT_TRUE(stream.next(batch));
+  EXPECT_EQ(2, batch.rows());
+  EXPECT_EQ(1.0, batch(0, 0));
+  EXPECT_EQ(4.0, batch(1, 1));
+  EXPECT_TRUE(stream.next(batch));
+  EXPECT_EQ(1, batch.rows());
+  EXPECT_EQ(6.0, batch(0, 1));
+  std::remove(csvPath.c_str());
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
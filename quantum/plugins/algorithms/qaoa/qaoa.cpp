@@ -21,6 +21,7 @@
 #include "CompositeInstruction.hpp"
 #include "AlgorithmGradientStrategy.hpp"
 #include "IRTransformation.hpp"
+#include "ObservedCircuitTemplate.hpp"
 #include <cassert>
 #include <iomanip>
 
@@ -129,6 +130,11 @@ bool QAOA::initialize(const HeterogeneousMap &parameters) {
     m_shuffleTerms = parameters.get<bool>("shuffle-terms");
   }
 
+  m_templateMode = false;
+  if (parameters.keyExists<bool>("template-mode")) {
+    m_templateMode = parameters.get<bool>("template-mode");
+  }
+
   if (m_optimizer && m_optimizer->isGradientBased() &&
       gradientStrategy == nullptr) {
     // No gradient strategy was provided, just use autodiff.
@@ -179,16 +185,35 @@ void QAOA::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
     }
   };
 
+  // Template mode: the symbolic kernel is observed once,
+  // each iteration only binds the new parameters in place.
+  // The placement transformation modifies the circuits, hence it requires
+  // fresh circuits for each iteration.
+  std::shared_ptr<xacc::quantum::ObservedCircuitTemplate> circuitTemplate;
+  if (m_templateMode) {
+    if (m_irTransformation) {
+      xacc::warning("QAOA: 'template-mode' is not supported with a placement "
+                    "transformation, ignoring it.");
+    } else {
+      circuitTemplate =
+          std::make_shared<xacc::quantum::ObservedCircuitTemplate>(
+              kernel, getObservedKernels());
+    }
+  }
+
   // Grouping is possible (no gradient strategy)
   // TODO: Gradient strategy to handle grouping as well.
   int iterCount = 0;
   if (m_costHamObs->getNonIdentitySubTerms().size() > 1 &&
-      getObservedKernels().size() == 1 && !gradientStrategy) {
+      (circuitTemplate ? circuitTemplate->getComposites().size()
+                       : getObservedKernels().size()) == 1 &&
+      !gradientStrategy) {
     OptFunction f(
         [&, this](const std::vector<double> &x, std::vector<double> &dx) {
           auto tmpBuffer = xacc::qalloc(buffer->size());
           std::vector<std::shared_ptr<CompositeInstruction>> fsToExec{
-              getObservedKernels()[0]->operator()(x)};
+              circuitTemplate ? circuitTemplate->bind(x)[0]
+                              : getObservedKernels()[0]->operator()(x)};
           if (m_irTransformation) {
             for (auto &composite : fsToExec) {
               m_irTransformation->apply(
@@ -242,19 +267,28 @@ void QAOA::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
 
         double identityCoeff = 0.0;
         int nInstructionsEnergy = 0, nInstructionsGradient = 0;
-        for (auto &f : getObservedKernels(x)) {
+        const auto observedKernels =
+            circuitTemplate ? circuitTemplate->bind(x) : getObservedKernels(x);
+        for (int i = 0; i < observedKernels.size(); i++) {
+          auto &f = observedKernels[i];
           kernelNames.push_back(f->name());
           std::complex<double> coeff = f->getCoefficient();
 
-          int nFunctionInstructions = 0;
-          if (f->getInstruction(0)->isComposite()) {
-            nFunctionInstructions =
-                kernel->nInstructions() + f->nInstructions() - 1;
+          bool isIdentity = false;
+          if (circuitTemplate) {
+            isIdentity = !circuitTemplate->hasMeasurements(i);
           } else {
-            nFunctionInstructions = f->nInstructions();
+            int nFunctionInstructions = 0;
+            if (f->getInstruction(0)->isComposite()) {
+              nFunctionInstructions =
+                  kernel->nInstructions() + f->nInstructions() - 1;
+            } else {
+              nFunctionInstructions = f->nInstructions();
+            }
+            isIdentity = nFunctionInstructions <= kernel->nInstructions();
           }
 
-          if (nFunctionInstructions > kernel->nInstructions()) {
+          if (!isIdentity) {
             fsToExec.push_back(f);
             coefficients.push_back(std::real(coeff));
           } else {
@@ -44,6 +44,8 @@ private:
     bool m_maximize = false;
     CompositeInstruction* m_initial_state = nullptr;
     bool m_shuffleTerms = false;
+    // Build the observed circuits once and only bind the parameters per iteration
+    bool m_templateMode = false;
     std::shared_ptr<xacc::IRTransformation> m_irTransformation;
 };
 } // namespace algorithm
@@ -27,6 +27,7 @@
 #include <sstream>
 #include <vector>
 #include "OperatorPool.hpp"
+#include "PauliTermAssembly.hpp"
 
 using namespace xacc;
 using namespace xacc::quantum;
@@ -125,71 +126,86 @@ const std::vector<std::string> qEOM::requiredParameters() const {
 
 void qEOM::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
 
-  // this lambda computes
-  // [A, H, B] = 1/2 x ([[A,H],B] + [A,[H,B]])
-  auto doubleCommutator = [&](std::shared_ptr<Observable> A,
-                              std::shared_ptr<Observable> B) {
-    // [A,H]
-    auto AH = A->commutator(observable);
+  // Here we loop over operators on the left and on the right,
+  // which I loosely refer to as bra and ket
+  int nOperators = operators.size();
+  // bras[i] is the conjugate of operators[i], which is also the
+  // conjugated ket of the off-diagonal blocks
+  std::vector<std::shared_ptr<Observable>> bras;
+  for (int i = 0; i < nOperators; i++) {
+    auto pauliOp = std::dynamic_pointer_cast<PauliOperator>(operators[i]);
+    bras.push_back(std::make_shared<PauliOperator>(
+        pauliOp->hermitianConjugate()));
+  }
+
+  // The double commutator [A, H, B] = 1/2 x ([[A,H],B] + [A,[H,B]])
+  // only needs the N single commutators [A,H] and [H,B] of each operator,
+  // which are computed once (in parallel) instead of for each matrix element.
+  std::vector<std::shared_ptr<Observable>> AH(nOperators), HB(nOperators),
+      HBConj(nOperators);
+  {
+    ThreadPool pool;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < nOperators; i++) {
+      futures.push_back(pool.enqueue([&, i]() {
+        AH[i] = bras[i]->commutator(observable);
+        HB[i] = observable->commutator(operators[i]);
+        if (computeDeexcitations) {
+          HBConj[i] = observable->commutator(bras[i]);
+        }
+      }));
+    }
+    for (auto &f : futures) {
+      f.get();
+    }
+  }
+
+  auto doubleCommutator = [&](int i, const std::shared_ptr<Observable> &B,
+                              const std::shared_ptr<Observable> &HB_) {
     // [[A,H],B]
-    auto AH_B = *std::dynamic_pointer_cast<PauliOperator>(AH->commutator(B));
-    // [H,B]
-    auto HB = observable->commutator(B);
+    auto AH_B = *std::dynamic_pointer_cast<PauliOperator>(AH[i]->commutator(B));
     // [A,[H,B]]
-    auto A_HB = *std::dynamic_pointer_cast<PauliOperator>(A->commutator(HB));
-
+    auto A_HB =
+        *std::dynamic_pointer_cast<PauliOperator>(bras[i]->commutator(HB_));
     // 1/2 x ([[A,H],B] + [A,[H,B]])
     auto ret = 0.5 * (AH_B + A_HB);
     return std::dynamic_pointer_cast<Observable>(
         std::make_shared<PauliOperator>(ret));
   };
 
-  // Here we loop over operators on the left and on the right,
-  // which I loosely refer to as bra and ket
-  // loop over bra
-  int nOperators = operators.size();
-  std::vector<std::shared_ptr<Observable>> matElementOps;
-
+  // qEOM matrix elements for the upper triangle (i <= j):
+  // M, V (diagonal blocks) and Q, W (off-diagonal blocks, only if computing
+  // de-excitations), assembled in parallel.
+  std::vector<std::pair<int, int>> elements;
   for (int i = 0; i < nOperators; i++) {
-
-    auto tmp_bra = (*std::dynamic_pointer_cast<PauliOperator>(operators[i]))
-                       .hermitianConjugate();
-    auto bra = std::dynamic_pointer_cast<Observable>(
-        std::make_shared<PauliOperator>(tmp_bra));
-
-    // loop over ket
     for (int j = i; j < nOperators; j++) {
-
-      auto ket = operators[j];
-      auto tmp_ketConj =
-          (*std::dynamic_pointer_cast<PauliOperator>(operators[j]))
-              .hermitianConjugate();
-      auto ketConj = std::dynamic_pointer_cast<Observable>(
-          std::make_shared<PauliOperator>(tmp_ketConj));
-
-      // qEOM matrix elements
-      // first the diagonal blocks
-      auto M_MatOperator = doubleCommutator(bra, ket);
-      matElementOps.push_back(M_MatOperator);
-      auto V_MatOperator = bra->commutator(ket);
-      matElementOps.push_back(V_MatOperator);
-
-      // off-diagonal blocks
-      // only if computing de-excitations
-      if (computeDeexcitations) {
-        auto Q_MatOperator = doubleCommutator(bra, ketConj);
-        matElementOps.push_back(Q_MatOperator);
-        auto W_MatOperator = bra->commutator(ketConj);
-        matElementOps.push_back(W_MatOperator);
-      }
+      elements.emplace_back(i, j);
     }
   }
+  const int nBlocks = computeDeexcitations ? 4 : 2;
+  PauliTermAssembly assembly;
+  assembly.build(elements.size() * nBlocks, [&](std::size_t idx) {
+    const auto i = elements[idx / nBlocks].first;
+    const auto j = elements[idx / nBlocks].second;
+    switch (idx % nBlocks) {
+    case 0:
+      return doubleCommutator(i, operators[j], HB[j]);
+    case 1:
+      return bras[i]->commutator(operators[j]);
+    case 2:
+      return doubleCommutator(i, bras[j], HBConj[j]);
+    default:
+      return bras[i]->commutator(bras[j]);
+    }
+  });
+  xacc::info("qEOM: " + std::to_string(assembly.nUniqueTerms()) +
+             " unique terms in " + std::to_string(assembly.nOperators()) +
+             " matrix elements.");
 
   // call Observable::observe() and Accelerator::execute() only once
-  auto uniqueTermsPtr = getUniqueTerms(matElementOps);
-  auto kernels = uniqueTermsPtr->observe(xacc::as_shared_ptr(kernel));
+  auto kernels = assembly.observe(xacc::as_shared_ptr(kernel));
   accelerator->execute(buffer, kernels);
-  auto buffers = buffer->getChildren();
+  const auto termValues = assembly.termValues(buffer->getChildren());
 
   // compute matrix elements
   int counter = 0;
@@ -200,17 +216,17 @@ void qEOM::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
   for (int i = 0; i < nOperators; i++) {
     for (int j = i; j < nOperators; j++) {
 
-      M(i, j) = computeOperatorExpValue(matElementOps[counter++], buffers);
+      M(i, j) = assembly.evaluate(counter++, termValues);
       M(j, i) = M(i, j);
 
-      V(i, j) = computeOperatorExpValue(matElementOps[counter++], buffers);
+      V(i, j) = assembly.evaluate(counter++, termValues);
       V(j, i) = V(i, j);
 
       if (computeDeexcitations) {
-        Q(i, j) = computeOperatorExpValue(matElementOps[counter++], buffers);
+        Q(i, j) = assembly.evaluate(counter++, termValues);
         Q(j, i) = Q(i, j);
 
-        W(i, j) = computeOperatorExpValue(matElementOps[counter++], buffers);
+        W(i, j) = assembly.evaluate(counter++, termValues);
         W(j, i) = W(i, j);
       }
     }
@@ -264,65 +280,6 @@ void qEOM::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
   return;
 }
 
-std::shared_ptr<Observable> qEOM::getUniqueTerms(
-    const std::vector<std::shared_ptr<Observable>> excitationOps) const {
-
-  // loop over all operators and all terms for each operator
-  // then check if that operator has been added to found
-  // and add it if not
-  // since each term is measured separately, we can have an operator
-  // that's the sum of all unique terms
-  auto uniqueTermsPtr = std::make_shared<PauliOperator>();
-  for (auto &op : excitationOps) {
-    for (auto &subTerm : op->getNonIdentitySubTerms()) {
-
-      auto term1 = std::dynamic_pointer_cast<PauliOperator>(subTerm)->begin();
-      if (!uniqueTermsPtr->getNonIdentitySubTerms().empty()) {
-
-        for (auto uniqueTerm : uniqueTermsPtr->getNonIdentitySubTerms()) {
-          auto term2 =
-              std::dynamic_pointer_cast<PauliOperator>(uniqueTerm)->begin();
-
-          if (term1->second.id() == term2->second.id()) {
-            continue;
-          } else {
-            uniqueTermsPtr->operator+=(
-                *std::make_shared<PauliOperator>(term1->second.ops()));
-            break;
-          }
-
-        }
-
-      } else {
-        uniqueTermsPtr->operator+=(
-            *std::make_shared<PauliOperator>(term1->second.ops()));
-      }
-    }
-  }
-
-  return uniqueTermsPtr;
-}
-
-double qEOM::computeOperatorExpValue(
-    const std::shared_ptr<Observable> &excitationOp,
-    const std::vector<std::shared_ptr<AcceleratorBuffer>> &buffers) const {
-
-  double expval = 0.0;
-  for (auto subTerm : excitationOp->getNonIdentitySubTerms()) {
-    auto term =
-        std::dynamic_pointer_cast<PauliOperator>(subTerm)->begin()->second;
-
-    for (auto buffer : buffers) {
-      if (buffer->name() == term.id()) {
-        expval += std::real(term.coeff() * buffer->getExpectationValueZ());
-        break;
-      }
-    }
-  }
-
-  return expval;
-}
-
 } // namespace algorithm
 } // namespace xacc
 
@@ -38,12 +38,6 @@ protected:
   bool computeDeexcitations = true;
   std::vector<std::shared_ptr<Observable>> operators;
 
-  std::shared_ptr<Observable>
-  getUniqueTerms(const std::vector<std::shared_ptr<Observable>>) const;
-  double computeOperatorExpValue(
-      const std::shared_ptr<Observable> &,
-      const std::vector<std::shared_ptr<AcceleratorBuffer>> &) const;
-
 public:
   bool initialize(const HeterogeneousMap &parameters) override;
   const std::vector<std::string> requiredParameters() const override;
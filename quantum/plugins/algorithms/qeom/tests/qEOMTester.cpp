@@ -23,6 +23,7 @@
 #include "OperatorPool.hpp"
 #include "FermionOperator.hpp"
 #include "ObservableTransform.hpp"
+#include "PauliTermAssembly.hpp"
 
 using namespace xacc;
 using namespace xacc::quantum;
@@ -89,6 +90,32 @@ TEST(qEOMTester, checkqEOM) {
   EXPECT_NEAR(1.60298, e[2], 1e-4);
 }
 
+TEST(qEOMTester, checkPauliTermAssembly) {
+  // X0 appears in both operators, the identity is not measured
+  std::vector<std::shared_ptr<Observable>> ops{
+      std::make_shared<PauliOperator>(PauliOperator({{0, "X"}}, 1.0) +
+                                      PauliOperator({{1, "Z"}}, 0.5)),
+      std::make_shared<PauliOperator>(PauliOperator({{0, "X"}}, 2.0) +
+                                      PauliOperator({{2, "Y"}}, 1.0) +
+                                      PauliOperator(3.0))};
+  PauliTermAssembly assembly;
+  EXPECT_EQ(0, assembly.build(ops.size(), [&](std::size_t i) { return ops[i]; }));
+  EXPECT_EQ(2, assembly.nOperators());
+  EXPECT_EQ(3, assembly.nUniqueTerms());
+  EXPECT_EQ(3, assembly.uniqueTerms()->nTerms());
+
+  auto buffers = std::vector<std::shared_ptr<AcceleratorBuffer>>{
+      std::make_shared<AcceleratorBuffer>("X0", 3),
+      std::make_shared<AcceleratorBuffer>("Z1", 3),
+      std::make_shared<AcceleratorBuffer>("Y2", 3)};
+  buffers[0]->addExtraInfo("exp-val-z", 0.5);
+  buffers[1]->addExtraInfo("exp-val-z", -1.0);
+  buffers[2]->addExtraInfo("exp-val-z", 0.25);
+  const auto values = assembly.evaluate(assembly.termValues(buffers));
+  EXPECT_NEAR(0.0, values[0], 1e-12);
+  EXPECT_NEAR(1.25, values[1], 1e-12);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
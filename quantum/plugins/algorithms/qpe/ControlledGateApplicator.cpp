@@ -371,7 +371,8 @@ bool ControlledU::expand(const xacc::HeterogeneousMap &runtimeOptions) {
 std::shared_ptr<xacc::CompositeInstruction> ControlledU::applyControl(
     const std::shared_ptr<xacc::CompositeInstruction> &in_program,
     const std::pair<std::string, size_t> &in_ctrlIdx) {
-  std::string qcor_compute_section_key = "__qcor__compute__segment__";
+  static const PropertyKey<bool> qcor_compute_section_key(
+      "__qcor__compute__segment__");
   m_gateProvider = xacc::getService<xacc::IRProvider>("quantum");
   m_composite = m_gateProvider->createComposite(
       "CTRL_" + in_program->name() + "_" + in_ctrlIdx.first +
@@ -382,9 +383,9 @@ std::shared_ptr<xacc::CompositeInstruction> ControlledU::applyControl(
   while (it.hasNext()) {
     auto nextInst = it.next();
     if (nextInst->isEnabled()) {
-      auto metadata = nextInst->getMetadata();
-      if (metadata.keyExists<bool>(qcor_compute_section_key) &&
-          metadata.get<bool>(qcor_compute_section_key)) {
+      const auto *isComputeSection =
+          nextInst->getMetadataStore().find(qcor_compute_section_key);
+      if (isComputeSection && *isComputeSection) {
         // Just add the instructino
         m_composite->addInstruction(nextInst);
       } else {
@@ -0,0 +1,53 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "PowerGateApplicator.hpp"
+
+namespace xacc {
+namespace circuits {
+bool PowerU::expand(const xacc::HeterogeneousMap &runtimeOptions) {
+  if (!runtimeOptions.keyExists<int>("power") ||
+      runtimeOptions.get<int>("power") < 1) {
+    xacc::error("A positive 'power' is required.");
+    return false;
+  }
+
+  // Own copy of U (a single one, shared by the repetitions): in-place
+  // transformations of the block (e.g. mapBits) must not modify the caller's U.
+  if (runtimeOptions.keyExists<std::shared_ptr<CompositeInstruction>>("U")) {
+    m_base = std::dynamic_pointer_cast<CompositeInstruction>(
+        runtimeOptions.get<std::shared_ptr<CompositeInstruction>>("U")
+            ->clone());
+  } else if (runtimeOptions.pointerLikeExists<CompositeInstruction>("U")) {
+    m_base = std::dynamic_pointer_cast<CompositeInstruction>(
+        runtimeOptions.getPointerLike<CompositeInstruction>("U")->clone());
+  } else {
+    xacc::error("'U' composite is required.");
+    return false;
+  }
+
+  m_power = runtimeOptions.get<int>("power");
+  m_enabled = true;
+  instructions = {m_base};
+  return true;
+}
+
+const std::string PowerU::toString() {
+  // Compact form: the repeated instructions are printed once.
+  std::string retStr = name() + "(" + std::to_string(m_power) + ") {\n";
+  if (m_base) {
+    retStr += m_base->toString();
+  }
+  return retStr + "}";
+}
+} // namespace circuits
+} // namespace xacc
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include "xacc.hpp"
+#include "Circuit.hpp"
+#include "GateModifier.hpp"
+
+namespace xacc {
+namespace circuits {
+// U^n block: the composite "U" repeated "power" times.
+// The block owns a copy of U (independent of the caller's U and of the
+// clones of the block), which is *not* copied per repetition: the block has
+// "power" children, which are all that copy, hence the InstructionIterator
+// expands the block on demand while the IR size stays O(|U|).
+// Simulators can detect the block (name "Pow-U", PowerModifier interface)
+// and apply it as a whole (e.g. a fused unitary raised to the power), then
+// disable it: a disabled block has no children, i.e. its sub-tree is
+// skipped by the iteration.
+// Note: the copy of U is shared by all the repetitions, hence in-place
+// transformations must act on it once (see mapBits) rather than on each
+// iterated instruction.
+class PowerU : public quantum::Circuit, public quantum::PowerModifier {
+public:
+  PowerU() : Circuit("Pow-U") {}
+  // Deep copy: the clones don't share U.
+  PowerU(const PowerU &other)
+      : Circuit(other), m_power(other.m_power), m_enabled(other.m_enabled) {
+    if (other.m_base) {
+      m_base = std::dynamic_pointer_cast<CompositeInstruction>(
+          other.m_base->clone());
+      instructions = {m_base};
+    }
+  }
+  bool expand(const xacc::HeterogeneousMap &runtimeOptions) override;
+  // Input: The composite "U" and the (positive) number of repetitions.
+  const std::vector<std::string> requiredKeys() override {
+    return {"U", "power"};
+  }
+
+  std::shared_ptr<Instruction> getBaseInstruction() const override {
+    if (!m_base) {
+      xacc::error("Power modifier block not yet expanded.");
+    }
+    return m_base;
+  }
+  size_t getPower() const override { return m_power; }
+
+  // Repeated view of the base composite
+  const int nInstructions() override {
+    return (m_base && m_enabled) ? static_cast<int>(m_power) : 0;
+  }
+  InstPtr getInstruction(const std::size_t idx) override {
+    if (idx >= static_cast<std::size_t>(nInstructions())) {
+      xacc::error("Invalid instruction index " + std::to_string(idx) +
+                  " for Pow-U block.");
+    }
+    return m_base;
+  }
+  std::vector<InstPtr> getInstructions() override {
+    return std::vector<InstPtr>(nInstructions(), m_base);
+  }
+  bool hasChildren() const override { return m_base != nullptr; }
+
+  // A disabled block has no children: U itself is left untouched.
+  bool isEnabled() override { return m_enabled; }
+  void enable() override { m_enabled = true; }
+  void disable() override { m_enabled = false; }
+
+  void mapBits(std::vector<std::size_t> bitMap) override {
+    if (m_base) {
+      m_base->mapBits(bitMap);
+    }
+  }
+  const std::set<std::size_t> uniqueBits() override {
+    return m_base ? m_base->uniqueBits() : std::set<std::size_t>{};
+  }
+  const std::size_t nLogicalBits() override {
+    return m_base ? m_base->nLogicalBits() : 0;
+  }
+  const std::string toString() override;
+
+  DEFINE_CLONE(PowerU);
+
+private:
+  std::shared_ptr<CompositeInstruction> m_base;
+  size_t m_power = 0;
+  bool m_enabled = true;
+};
+} // namespace circuits
+} // namespace xacc
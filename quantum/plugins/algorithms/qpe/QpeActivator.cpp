@@ -12,6 +12,7 @@
  *******************************************************************************/
 #include "qpe.hpp"
 #include "ControlledGateApplicator.hpp"
+#include "PowerGateApplicator.hpp"
 
 #include "cppmicroservices/BundleActivator.h"
 #include "cppmicroservices/BundleContext.h"
@@ -37,6 +38,7 @@ public:
     auto c = std::make_shared<xacc::algorithm::QuantumPhaseEstimation>();
     context.RegisterService<xacc::Algorithm>(c);
     context.RegisterService<xacc::Instruction>(std::make_shared<xacc::circuits::ControlledU>());
+    context.RegisterService<xacc::Instruction>(std::make_shared<xacc::circuits::PowerU>());
   }
 
   /**
@@ -133,15 +133,19 @@ void QuantumPhaseEstimation::execute(const std::shared_ptr<AcceleratorBuffer> bu
             std::make_pair("U",  m_oracle),
             std::make_pair("control-idx",  static_cast<int>(i)),
         });            
-        // Apply C-U^n
-        for (int count = 0; count < nbCalls; count++)
+        if (nbCalls == 1)
         {
-            for (int instId = 0; instId < ctrlKernel->nInstructions(); ++instId)
-            {
-                // We need to clone the instruction since it'll be repeated.
-                qpeKernel->addInstruction(ctrlKernel->getInstruction(instId)->clone());
-            }
+            qpeKernel->addInstruction(ctrlKernel);
+            continue;
         }
+        // Apply C-U^n: the controlled kernel is repeated (not copied),
+        // hence the kernel size is linear in the bit precision.
+        auto powKernel = std::dynamic_pointer_cast<CompositeInstruction>(xacc::getService<Instruction>("Pow-U"));
+        powKernel->expand( {
+            std::make_pair("U", ctrlKernel),
+            std::make_pair("power", nbCalls),
+        });
+        qpeKernel->addInstruction(powKernel);
     }
     
     // IQFT on the phase estimation register.
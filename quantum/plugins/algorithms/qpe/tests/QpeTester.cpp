@@ -15,6 +15,7 @@
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include "Algorithm.hpp"
+#include "InstructionIterator.hpp"
 
 using namespace xacc;
 
@@ -84,6 +85,127 @@ TEST(QpeTester, checkMultiQubitOracle)
   EXPECT_NEAR(result, 1.0, 0.01);
 }
 
+TEST(QpeTester, checkPowerBlock)
+{
+  auto compiler = xacc::getCompiler("xasm");
+  auto base = compiler->compile(R"(__qpu__ void pow_base(qbit q) {
+    H(q[0]);
+    CNOT(q[0], q[1]);
+    Rz(q[1], 0.3);
+  })", nullptr)->getComposite("pow_base");
+
+  const int power = 5;
+  auto powU = std::dynamic_pointer_cast<CompositeInstruction>(xacc::getService<Instruction>("Pow-U"));
+  EXPECT_TRUE(powU->expand({ std::make_pair("U", base), std::make_pair("power", power) }));
+  EXPECT_EQ(powU->nInstructions(), power);
+  EXPECT_EQ(powU->uniqueBits().size(), 2);
+
+  // The iterator expands the block
+  int nbGates = 0;
+  InstructionIterator it(powU);
+  while (it.hasNext())
+  {
+    if (!it.next()->isComposite())
+    {
+      nbGates++;
+    }
+  }
+  EXPECT_EQ(nbGates, power * base->nInstructions());
+
+  // Compare with the explicit repetition
+  auto provider = xacc::getIRProvider("quantum");
+  auto kernel = provider->createComposite("pow_kernel");
+  auto expected = provider->createComposite("pow_expected");
+  kernel->addInstruction(powU);
+  for (int i = 0; i < power; ++i)
+  {
+    for (auto& inst : base->getInstructions())
+    {
+      expected->addInstruction(inst->clone());
+    }
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    kernel->addInstruction(provider->createInstruction("Measure", { i }));
+    expected->addInstruction(provider->createInstruction("Measure", { i }));
+  }
+  auto acc = xacc::getAccelerator("qpp");
+  auto buffer = xacc::qalloc(2);
+  acc->execute(buffer, kernel);
+  auto expectedBuffer = xacc::qalloc(2);
+  acc->execute(expectedBuffer, expected);
+  EXPECT_NEAR(buffer->getExpectationValueZ(), expectedBuffer->getExpectationValueZ(), 1e-9);
+  // Block re-enabled after the simulation
+  EXPECT_TRUE(powU->isEnabled());
+  EXPECT_EQ(powU->nInstructions(), power);
+}
+
+TEST(QpeTester, checkPowerBlockOwnsBase)
+{
+    auto compiler = xacc::getCompiler("xasm");
+    auto base = compiler->compile(R"(__qpu__ void pow_shared_base(qbit q) {
+    H(q[0]);
+    CNOT(q[0], q[1]);
+  })", nullptr)->getComposite("pow_shared_base");
+    const auto baseStr = base->toString();
+    // U is also used outside of the block.
+    auto provider = xacc::getIRProvider("quantum");
+    auto outside = provider->createComposite("pow_outside");
+    outside->addInstruction(base);
+
+    auto powU = std::dynamic_pointer_cast<CompositeInstruction>(xacc::getService<Instruction>("Pow-U"));
+    EXPECT_TRUE(powU->expand({ std::make_pair("U", base), std::make_pair("power", 3) }));
+    auto cloned = std::dynamic_pointer_cast<CompositeInstruction>(powU->clone());
+
+    powU->mapBits({ 2, 3 });
+    EXPECT_EQ(powU->uniqueBits(), std::set<std::size_t>({ 2, 3 }));
+    powU->disable();
+    EXPECT_EQ(powU->nInstructions(), 0);
+
+    // Neither U nor the clone of the block are modified.
+    EXPECT_EQ(base->toString(), baseStr);
+    EXPECT_TRUE(base->isEnabled());
+    for (auto& inst : base->getInstructions())
+    {
+        EXPECT_TRUE(inst->isEnabled());
+    }
+    EXPECT_EQ(outside->uniqueBits(), std::set<std::size_t>({ 0, 1 }));
+    EXPECT_EQ(cloned->uniqueBits(), std::set<std::size_t>({ 0, 1 }));
+    EXPECT_TRUE(cloned->isEnabled());
+    EXPECT_EQ(cloned->nInstructions(), 3);
+
+    powU->enable();
+    EXPECT_EQ(powU->nInstructions(), 3);
+    EXPECT_EQ(powU->uniqueBits(), std::set<std::size_t>({ 2, 3 }));
+}
+
+TEST(QpeTester, checkHighPrecision)
+{
+  auto acc = xacc::getAccelerator("qpp", {std::make_pair("shots", 1024)});
+  // 10-bit precision: the C-U^(2^k) are repeated, not copied.
+  auto buffer = xacc::qalloc(11);
+  auto qpe = xacc::getService<Algorithm>("QPE");
+  auto compiler = xacc::getCompiler("xasm");
+  auto oracle = compiler->compile(R"(__qpu__ void oracle2(qbit q) {
+    T(q[0]);
+  })", nullptr)->getComposite("oracle2");
+  auto statePrep = compiler->compile(R"(__qpu__ void prep2(qbit q) {
+    X(q[0]);
+  })", nullptr)->getComposite("prep2");
+
+  EXPECT_TRUE(qpe->initialize({
+                    std::make_pair("accelerator", acc),
+                    std::make_pair("oracle", oracle),
+                    std::make_pair("state-preparation", statePrep)
+                  }));
+  qpe->execute(buffer);
+  const auto kernelStr = mpark::get<std::string>(buffer->getInformation("qpe-kernel"));
+  EXPECT_TRUE(kernelStr.find("Pow-U(512)") != std::string::npos);
+  // Exact phase (1/8): single outcome
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(counts.size(), 1);
+}
+
 int main(int argc, char **argv) 
 {
   xacc::Initialize(argc, argv);
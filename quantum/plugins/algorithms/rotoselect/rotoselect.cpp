@@ -14,6 +14,7 @@
 #include "rotoselect.hpp"
 #include "xacc.hpp"
 #include "xacc_service.hpp"
+#include "InstructionIterator.hpp"
 #include <random>
 #include <algorithm>
 #include <iterator>
@@ -27,6 +28,94 @@ using namespace xacc;
 namespace {
   enum class PauliType { X = 0, Y = 1, Z = 2 };
 
+  std::string pauliName(PauliType in_pauliType)
+  {
+    switch (in_pauliType)
+    {
+      case PauliType::X: return "Rx";
+      case PauliType::Y: return "Ry";
+      default: return "Rz";
+    }
+  }
+
+  // Rotation gate of a slot
+  struct SlotGate
+  {
+    PauliType type = PauliType::X;
+    double angle = 0.0;
+  };
+
+  // Variable name of the rotation slot placeholders
+  const std::string SLOT_VAR_PREFIX = "rotoselect_slot_";
+
+  // Observed circuit whose rotation gates are slots:
+  // the instructions are flattened once, binding a slot configuration only
+  // creates the slot gates (all the other instructions are shared).
+  class SlotCircuit
+  {
+  public:
+    SlotCircuit(const std::shared_ptr<CompositeInstruction>& in_observed):
+      m_name(in_observed->name()),
+      m_coeff(std::real(in_observed->getCoefficient()))
+    {
+      InstructionIterator it(in_observed);
+      while (it.hasNext())
+      {
+        auto nextInst = it.next();
+        if (!nextInst->isEnabled() || nextInst->isComposite())
+        {
+          continue;
+        }
+        int slotIdx = -1;
+        if (nextInst->isParameterized() && nextInst->getParameter(0).isVariable())
+        {
+          const auto varName = nextInst->getParameter(0).toString();
+          if (varName.rfind(SLOT_VAR_PREFIX, 0) == 0)
+          {
+            slotIdx = std::stoi(varName.substr(SLOT_VAR_PREFIX.size()));
+          }
+        }
+        if (nextInst->name() == "Measure")
+        {
+          m_hasMeasurements = true;
+        }
+        m_instructions.emplace_back(nextInst);
+        m_slotIdx.emplace_back(slotIdx);
+      }
+    }
+
+    std::shared_ptr<CompositeInstruction> bind(const std::vector<SlotGate>& in_slotGates, std::shared_ptr<IRProvider>& in_gateRegistry, const std::string& in_suffix) const
+    {
+      auto result = in_gateRegistry->createComposite(m_name + in_suffix);
+      for (size_t i = 0; i < m_instructions.size(); ++i)
+      {
+        if (m_slotIdx[i] < 0)
+        {
+          result->addInstruction(m_instructions[i]);
+        }
+        else
+        {
+          const auto& slotGate = in_slotGates[m_slotIdx[i]];
+          result->addInstruction(in_gateRegistry->createInstruction(pauliName(slotGate.type), m_instructions[i]->bits(), { slotGate.angle }));
+        }
+      }
+      result->setCoefficient(m_coeff);
+      return result;
+    }
+
+    const std::string& name() const { return m_name; }
+    double coefficient() const { return m_coeff; }
+    bool hasMeasurements() const { return m_hasMeasurements; }
+
+  private:
+    std::string m_name;
+    double m_coeff;
+    bool m_hasMeasurements = false;
+    std::vector<InstPtr> m_instructions;
+    // Slot index of each instruction (-1 if not a slot)
+    std::vector<int> m_slotIdx;
+  };
+
   std::vector<double> initializeThetaVec(int in_nbRotationGates)
   {
     std::random_device rndDevice;
@@ -138,41 +227,22 @@ void Rotoselect::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const
   // Tracking of all rotation gates (angle and type) 
   std::vector<double> thetaVec = initializeThetaVec(nbRotationGates);
   std::vector<PauliType> pauliTypeVec = initializePauliTypeVec(nbRotationGates);
-  std::unordered_map<size_t, size_t> pauliGateIdxToCircuitIdx;
-  
-  auto rotoselectKernel = gateRegistry->createComposite("rotoselectKernel");
   
-  const auto createPauliGate = [&gateRegistry](size_t in_qubitIdx, PauliType in_pauliType, double in_angle) {
-    switch (in_pauliType)
-    {
-      case PauliType::X:
-      {
-        return gateRegistry->createInstruction("Rx", { in_qubitIdx}, { in_angle });
-      }         
-      case PauliType::Y:
-      {
-        return gateRegistry->createInstruction("Ry", { in_qubitIdx }, { in_angle });
-      }
-      case PauliType::Z:
-      {
-        return gateRegistry->createInstruction("Rz", { in_qubitIdx }, { in_angle });
-      }         
-    };
-  };  
-  
-  // Step 1: initialize the quantum circuit
+  // Step 1: initialize the quantum circuit.
+  // The rotation gates are slots (placeholder gates with a 'slot' variable),
+  // which are filled with the actual Pauli rotation when the circuit is bound.
+  std::vector<std::string> slotVars;
+  for (size_t k = 0; k < nbRotationGates; ++k)
+  {
+    slotVars.emplace_back(SLOT_VAR_PREFIX + std::to_string(k));
+  }
+  auto rotoselectKernel = gateRegistry->createComposite("rotoselectKernel", slotVars);
   for (size_t i = 0; i < nbLayers; ++i)
   {
     // Pauli rotation layer:
     for (size_t j = 0; j < nbQubits; ++j)
     {
-      const auto pauliType = pauliTypeVec[i*nbQubits + j];
-      const auto angle = thetaVec[i*nbQubits + j];
-      rotoselectKernel->addInstruction(createPauliGate(j, pauliType, angle));
-      const auto circuitGateIdx = rotoselectKernel->nInstructions() - 1;
-      // Track the mapping between Pauli rotation gate and absolute index within the circuit
-      // Note: we have layers of CZ gates in between rotation layers.
-      pauliGateIdxToCircuitIdx.emplace(i*nbQubits + j, circuitGateIdx);
+      rotoselectKernel->addInstruction(gateRegistry->createInstruction("Rx", { j }, { InstructionParameter(slotVars[i*nbQubits + j]) }));
     }
 
     // CZ layer
@@ -193,99 +263,97 @@ void Rotoselect::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const
   }
   
   const auto observable = m_parameters.getPointerLike<Observable>("observable");
+  // The observed circuits are compiled once, 
+  // all the candidate gates are then evaluated by binding these templates.
+  double identityCoeff = 0.0;
+  std::vector<SlotCircuit> observedCircuits;
+  for (auto& f : observable->observe(rotoselectKernel))
+  {
+    SlotCircuit compiled(f);
+    if (compiled.hasMeasurements())
+    {
+      observedCircuits.emplace_back(std::move(compiled));
+    }
+    else
+    {
+      identityCoeff += std::real(f->getCoefficient());
+    }
+  }
+
   // Step 2: Optimization loop
   bool stopCriteriaMet = false;
   // Currently, we only use trial count as the stopping criteria.
   // We can implement other criteria, such as convergence rate, etc.
   const int nbIterations = m_parameters.get<int>("iterations");
   int iterationCount = 0;
+  int nbExecuteCalls = 0;
   
-  // Optimization note:
-  // This evaluation function is the main runner of the training loop (7 evaluations per training step/iteration).
-  // We can run all evaluations per step in parallel. In order to do so, we need:
-  // (1) Clone the rotoselectKernel for each thread, i.e. each thread has an independent copy (because it will swap a gate for evaluation).
-  // (2) Clone the accelerator (simulator) which will run the circuit to evaluate the energy for this config.
-  // This will give us good speedup in the case that the simulator is not utilize all the CPU resources (i.e. if the simulator is not multithreaded by itself).
-  const auto evaluateFn = [&](size_t in_pauliGateIdx, PauliType in_pauliType, double in_angle) -> double {
-    // Find the gate:
-    auto iter = pauliGateIdxToCircuitIdx.find(in_pauliGateIdx);
-    assert(iter != pauliGateIdxToCircuitIdx.end());
-
-    const auto currentGate = rotoselectKernel->getInstruction(iter->second);
-    assert(currentGate->nRequiredBits() == 1);
-    const auto qubitIdx = currentGate->bits()[0];
-    auto newGate = createPauliGate(qubitIdx, in_pauliType, in_angle);
-    rotoselectKernel->replaceInstruction(iter->second, newGate);
-    // Calculate the observable
-    auto kernels = observable->observe(rotoselectKernel);
-    double energy = 0.0;
+  // Current gate of each slot
+  std::vector<SlotGate> slotGates(nbRotationGates);
+  for (size_t k = 0; k < nbRotationGates; ++k)
+  {
+    slotGates[k] = { pauliTypeVec[k], thetaVec[k] };
+  }
 
+  // Evaluates the energy of all the candidate gate configurations
+  // (all the observed circuits of all candidates in one batch).
+  const auto evaluateFn = [&](const std::vector<std::vector<SlotGate>>& in_candidates) -> std::vector<double> {
+    std::vector<std::shared_ptr<CompositeInstruction>> fsToExec;
+    for (size_t c = 0; c < in_candidates.size(); ++c)
     {
-      std::vector<double> coefficients;
-      std::vector<std::string> kernelNames;
-      std::vector<std::shared_ptr<CompositeInstruction>> fsToExec;
-
-      double identityCoeff = 0.0;
-      for (auto &f : kernels) 
+      for (const auto& compiled : observedCircuits)
       {
-        kernelNames.push_back(f->name());
-        std::complex<double> coeff = f->getCoefficient();
-        int nFunctionInstructions = 0;
-        if (f->getInstruction(0)->isComposite()) 
-        {
-          nFunctionInstructions = rotoselectKernel->nInstructions() + f->nInstructions() - 1;
-        } 
-        else 
-        {
-          nFunctionInstructions = f->nInstructions();
-        }
-
-        if (nFunctionInstructions > rotoselectKernel->nInstructions()) 
-        {
-          fsToExec.push_back(f);
-          coefficients.push_back(std::real(coeff));
-        } 
-        else 
-        {
-          identityCoeff += std::real(coeff);
-        }
+        fsToExec.emplace_back(compiled.bind(in_candidates[c], gateRegistry, "_c" + std::to_string(c)));
       }
+    }
 
-      auto tmpBuffer = xacc::qalloc(buffer->size());
-      accelerator->execute(tmpBuffer, fsToExec);
-      auto buffers = tmpBuffer->getChildren();
-
-      energy = identityCoeff;
-      auto idBuffer = xacc::qalloc(buffer->size());
-      idBuffer->addExtraInfo("coefficient", identityCoeff);
-      idBuffer->setName("I");
-      idBuffer->addExtraInfo("kernel", "I");
-      idBuffer->addExtraInfo("exp-val-z", 1.0);
-      buffer->appendChild("I", idBuffer);
-
-      for (int i = 0; i < buffers.size(); i++) 
-      {
-        auto expval = buffers[i]->getExpectationValueZ();
-        energy += expval * coefficients[i];
-        buffers[i]->addExtraInfo("coefficient", coefficients[i]);
-        buffers[i]->addExtraInfo("kernel", fsToExec[i]->name());
-        buffers[i]->addExtraInfo("exp-val-z", expval);
-        buffer->appendChild(fsToExec[i]->name(), buffers[i]);
-      } 
-
+    std::vector<double> energies(in_candidates.size(), identityCoeff);
+    if (fsToExec.empty())
+    {
+      return energies;
+    }
+    auto tmpBuffer = xacc::qalloc(buffer->size());
+    accelerator->execute(tmpBuffer, fsToExec);
+    ++nbExecuteCalls;
+    auto buffers = tmpBuffer->getChildren();
+    assert(buffers.size() == fsToExec.size());
+    for (size_t i = 0; i < buffers.size(); ++i) 
+    {
+      const auto& compiled = observedCircuits[i % observedCircuits.size()];
+      const auto expval = buffers[i]->getExpectationValueZ();
+      energies[i / observedCircuits.size()] += expval * compiled.coefficient();
+      buffers[i]->addExtraInfo("coefficient", compiled.coefficient());
+      buffers[i]->addExtraInfo("kernel", compiled.name());
+      buffers[i]->addExtraInfo("exp-val-z", expval);
+      buffer->appendChild(fsToExec[i]->name(), buffers[i]);
     }
+    return energies;
+  };
 
-    // Return back the original gate:
-    rotoselectKernel->replaceInstruction(iter->second, currentGate);
-    return energy;
+  // Minimum of the sinusoid E(theta) = a*cos(theta) + b*sin(theta) + c,
+  // given E(0), E(pi/2) and E(-pi/2) (see https://arxiv.org/abs/1905.09692)
+  // Returns the angle (in [-pi, pi]) and the energy at that angle.
+  const auto minCalc = [](double in_m0, double in_mPiOver2, double in_mMinusPiOver2) -> std::pair<double, double> {
+    double angle = -M_PI_2 - atan2(2*in_m0 - in_mPiOver2 - in_mMinusPiOver2, in_mPiOver2 - in_mMinusPiOver2);
+    // Normalize to the [-pi,+pi] range
+    if (angle < -M_PI)
+    {
+      angle += 2*M_PI;
+    }  
+    assert((angle >= -M_PI && angle <= M_PI));
+    const double c = 0.5 * (in_mPiOver2 + in_mMinusPiOver2);
+    const double a = in_m0 - c;
+    const double b = 0.5 * (in_mPiOver2 - in_mMinusPiOver2);
+    return { angle, c - std::sqrt(a*a + b*b) };
   };
-  
+
   // We keep track of all the min energy value achieved at each iteration.
   // This can be used to determine stopping conditions (in addition to just iteration loop count)
   std::vector<double> minEnergyVec;
   minEnergyVec.reserve(nbIterations);
   // The training result (i.e. the min energy that is encountered so far)
   double trainingResult = std::numeric_limits<double>::max();
+  const std::vector<PauliType> allPaulis { PauliType::X, PauliType::Y, PauliType::Z };
   while (!stopCriteriaMet)
   {
     for (size_t i = 0; i < nbLayers; ++i)
@@ -293,68 +361,40 @@ void Rotoselect::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const
       for (size_t j = 0; j < nbQubits; ++j)
       {
         const auto pauliGateIdx =  i*nbQubits + j;
-        // We need 7 params to evaluate optimal params for this rotation gate
-        const double M_X_PI_2 = evaluateFn(pauliGateIdx, PauliType::X, M_PI_2);
-        const double M_X_M_PI_2 = evaluateFn(pauliGateIdx, PauliType::X, -M_PI_2);
-        const double M_Y_PI_2 = evaluateFn(pauliGateIdx, PauliType::Y, M_PI_2);
-        const double M_Y_M_PI_2 = evaluateFn(pauliGateIdx, PauliType::Y, -M_PI_2);
-        const double M_Z_PI_2 = evaluateFn(pauliGateIdx, PauliType::Z, M_PI_2);
-        const double M_Z_M_PI_2 = evaluateFn(pauliGateIdx, PauliType::Z, -M_PI_2);
-        const double M_ZERO = evaluateFn(pauliGateIdx, PauliType::X, 0.0);
-
-        // Compute the minimum for each Pauli type
-        const auto minCalc = [](double in_m0, double in_mPiOver2, double in_mMinusPiOver2){
-          double result = -M_PI_2 - atan2(2*in_m0 - in_mPiOver2 - in_mMinusPiOver2, in_mPiOver2 - in_mMinusPiOver2);
-          // Normalize to the [-pi,+pi] range
-          if (result < -M_PI)
-          {
-            result += 2*M_PI;
-          }  
-          assert((result >= -M_PI && result <= M_PI));
-          return result;
-        };
-
-        const double min_Theta_X = minCalc(M_ZERO, M_X_PI_2, M_X_M_PI_2);
-        const double min_Theta_Y = minCalc(M_ZERO, M_Y_PI_2, M_Y_M_PI_2);
-        const double min_Theta_Z = minCalc(M_ZERO, M_Z_PI_2, M_Z_M_PI_2);
-        
-        // Which Pauli give us the minimum?
-        const double min_X = evaluateFn(pauliGateIdx, PauliType::X, min_Theta_X);
-        const double min_Y = evaluateFn(pauliGateIdx, PauliType::Y, min_Theta_Y);
-        const double min_Z = evaluateFn(pauliGateIdx, PauliType::Z, min_Theta_Z);
-        double minEnergy = min_X;
-        PauliType minPauli = PauliType::X;
-        double minAngle = min_Theta_X;
-        if (min_Y < minEnergy)
+        // We need 7 evaluations to find the optimal gate for this slot:
+        // the zero angle (identity, for all Pauli types) and +/- pi/2 for each Pauli type.
+        std::vector<std::vector<SlotGate>> candidates(7, slotGates);
+        candidates[0][pauliGateIdx] = { PauliType::X, 0.0 };
+        for (size_t p = 0; p < allPaulis.size(); ++p)
         {
-          minEnergy = min_Y;
-          minPauli = PauliType::Y;
-          minAngle = min_Theta_Y;
+          candidates[1 + 2*p][pauliGateIdx] = { allPaulis[p], M_PI_2 };
+          candidates[2 + 2*p][pauliGateIdx] = { allPaulis[p], -M_PI_2 };
         }
+        const auto energies = evaluateFn(candidates);
 
-        if (min_Z < minEnergy)
+        // Which Pauli give us the minimum?
+        double minEnergy = std::numeric_limits<double>::max();
+        SlotGate minGate;
+        for (size_t p = 0; p < allPaulis.size(); ++p)
         {
-          minEnergy = min_Z;
-          minPauli = PauliType::Z;
-          minAngle = min_Theta_Z;
+          const auto [angle, energy] = minCalc(energies[0], energies[1 + 2*p], energies[2 + 2*p]);
+          if (energy < minEnergy)
+          {
+            minEnergy = energy;
+            minGate = { allPaulis[p], angle };
+          }
         }
 
         // Update the rotation gate:
         ++iterationCount;
-        auto iter = pauliGateIdxToCircuitIdx.find(pauliGateIdx);
-        assert(iter != pauliGateIdxToCircuitIdx.end());
-        const auto currentGate = rotoselectKernel->getInstruction(iter->second);
-        assert(currentGate->nRequiredBits() == 1);
-        const auto qubitIdx = currentGate->bits()[0];
-        auto newGate = createPauliGate(qubitIdx, minPauli, minAngle);
-        rotoselectKernel->replaceInstruction(iter->second, newGate);
+        const auto currentGate = slotGates[pauliGateIdx];
+        slotGates[pauliGateIdx] = minGate;
         
         if (xacc::verbose)
         {
           // Debug:
-          std::cout << "Replace " << currentGate->name() << "(" << currentGate->getParameter(0).as<double>() << ")" << " with " << newGate->name() << "(" << minAngle << ")" << " @ q[" << qubitIdx << "] \n";
+          std::cout << "Replace " << pauliName(currentGate.type) << "(" << currentGate.angle << ")" << " with " << pauliName(minGate.type) << "(" << minGate.angle << ")" << " @ q[" << j << "] \n";
           std::cout << "Min Energy: " << minEnergy << "\n";
-          std::cout << "New circuit: \n" <<  rotoselectKernel->toString();
         }
         
         minEnergyVec.emplace_back(minEnergy);
@@ -376,6 +416,7 @@ void Rotoselect::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const
 
   // Done, add info to the buffer
   buffer->addExtraInfo("opt-val", trainingResult);
+  buffer->addExtraInfo("n-execute-calls", nbExecuteCalls);
 }
 
 } // namespace algorithm
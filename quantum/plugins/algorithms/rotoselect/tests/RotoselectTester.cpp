@@ -44,6 +44,31 @@ TEST(RotoselectTester, checkSimple)
   std::cout << "Optimal value: " << buffer->getInformation("opt-val").as<double>() << "\n";
 }
 
+TEST(RotoselectTester, checkBatchedEvaluation) 
+{
+  auto acc = xacc::getAccelerator("qpp");
+  auto buffer = xacc::qalloc(2);
+ 
+  std::shared_ptr<Observable> observable = std::make_shared<xacc::quantum::PauliOperator>();
+  observable->fromString("0.01128 Z0 Z1 + 0.180931 X0 X1 + 0.397936 Z0 + 0.397936 Z1");
+
+  auto rotoselect = xacc::getService<Algorithm>("rotoselect");
+  EXPECT_TRUE(rotoselect->initialize({
+                                      std::make_pair("accelerator", acc),
+                                      std::make_pair("observable", observable),
+                                      std::make_pair("layers", 2),
+                                      std::make_pair("iterations", 8),
+                                    }));
+  rotoselect->execute(buffer);
+  // One batched execution (all candidates of a rotation slot) per iteration
+  EXPECT_EQ(buffer->getInformation("n-execute-calls").as<int>(), 8);
+  // 7 evaluation points x 3 (non-identity) terms per iteration
+  EXPECT_EQ(buffer->nChildren(), 8 * 7 * 3);
+  const auto result = buffer->getInformation("opt-val").as<double>();
+  // Variational: cannot be lower than the ground state energy (-0.8049)
+  EXPECT_GT(result, -0.806);
+}
+
 int main(int argc, char **argv) 
 {
   xacc::Initialize(argc, argv);
@@ -11,6 +11,7 @@
  *   Alexander J. McCaskey - initial API and implementation
  *******************************************************************************/
 #include "vqe.hpp"
+#include "vqe_ensemble.hpp"
 
 #include "cppmicroservices/BundleActivator.h"
 #include "cppmicroservices/BundleContext.h"
@@ -35,6 +36,8 @@ public:
   void Start(BundleContext context) {
     auto c = std::make_shared<xacc::algorithm::VQE>();
     context.RegisterService<xacc::Algorithm>(c);
+    auto ensemble = std::make_shared<xacc::algorithm::VQEEnsemble>();
+    context.RegisterService<xacc::Algorithm>(ensemble);
   }
 
   /**
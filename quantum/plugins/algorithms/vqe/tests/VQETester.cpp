@@ -18,6 +18,9 @@
 #include "Observable.hpp"
 #include "Algorithm.hpp"
 #include "PauliOperator.hpp"
+#include "ObservedCircuitTemplate.hpp"
+#include <chrono>
+#include <future>
 
 using namespace xacc;
 const std::string rucc = R"rucc(__qpu__ void f(qbit q, double t0) {
@@ -180,6 +183,180 @@ TEST(VQETester, checkChildBuffers) {
   }
 }
 
+namespace {
+// Waits for start (if valid) before running the wrapped optimizer, then
+// signals finished (if set): orders the ensemble problems without relying
+// on timing.
+class SequencedOptimizer : public Optimizer {
+public:
+  SequencedOptimizer(std::shared_ptr<Optimizer> optimizer,
+                     std::shared_future<void> start,
+                     std::shared_ptr<std::promise<void>> finished)
+      : optimizer(optimizer), start(start), finished(finished) {}
+
+  OptResult optimize(OptFunction &function) override {
+    if (start.valid()) {
+      start.wait();
+    }
+    auto result = optimizer->optimize(function);
+    if (finished) {
+      finished->set_value();
+    }
+    return result;
+  }
+  const std::string name() const override { return optimizer->name(); }
+  const std::string description() const override { return ""; }
+
+private:
+  std::shared_ptr<Optimizer> optimizer;
+  std::shared_future<void> start;
+  std::shared_ptr<std::promise<void>> finished;
+};
+} // namespace
+
+TEST(VQETester, checkEnsemble) {
+  auto acc = xacc::getAccelerator("qpp", {std::make_pair("vqe-mode", true)});
+  auto compiler = xacc::getCompiler("xasm");
+  auto ruccsd = compiler->compile(rucc, nullptr)->getComposite("f");
+
+  const std::string h2 =
+      "(0.174073,0) Z2 Z3 + (0.1202,0) Z1 Z3 + (0.165607,0) Z1 Z2 + "
+      "(0.165607,0) Z0 Z3 + (0.1202,0) Z0 Z2 + (-0.0454063,0) Y0 Y1 X2 X3 + "
+      "(-0.220041,0) Z3 + (-0.106477,0) + (0.17028,0) Z0 + (-0.220041,0) Z2 "
+      "+ (0.17028,0) Z1 + (-0.0454063,0) X0 X1 Y2 Y3 + (0.0454063,0) X0 Y1 "
+      "Y2 X3 + (0.168336,0) Z0 Z1 + (0.0454063,0) Y0 X1 X2 Y3";
+  std::vector<std::shared_ptr<Observable>> observables;
+  for (auto shift : {1.0, 0.0}) {
+    auto observable = std::make_shared<xacc::quantum::PauliOperator>();
+    observable->fromString(h2);
+    *observable += xacc::quantum::PauliOperator(shift);
+    observables.emplace_back(observable);
+  }
+
+  // One optimizer for all the problems, no bounds: every problem runs.
+  {
+    auto buffer = xacc::qalloc(4);
+    auto ensemble = xacc::getService<Algorithm>("vqe-ensemble");
+    EXPECT_TRUE(ensemble->initialize({{"ansatz", ruccsd},
+                                      {"accelerator", acc},
+                                      {"observables", observables},
+                                      {"optimizer", xacc::getOptimizer("nlopt")}}));
+    ensemble->execute(buffer);
+    const auto energies = (*buffer)["opt-vals"].as<std::vector<double>>();
+    EXPECT_NEAR(1.0 - 1.13717, energies[0], 1e-4);
+    EXPECT_NEAR(-1.13717, energies[1], 1e-4);
+    EXPECT_EQ(1, (*buffer)["opt-problem"].as<int>());
+    EXPECT_EQ(std::vector<int>({0, 0}),
+              (*buffer)["cancelled"].as<std::vector<int>>());
+  }
+
+  // The shifted problem can't beat the ground state of the other one. It
+  // only starts once the other one is done, hence is always cancelled
+  // (whether or not the problems run in parallel).
+  {
+    auto buffer = xacc::qalloc(4);
+    auto firstDone = std::make_shared<std::promise<void>>();
+    std::vector<std::shared_ptr<Optimizer>> optimizers{
+        std::make_shared<SequencedOptimizer>(
+            xacc::getOptimizer("nlopt"), firstDone->get_future().share(),
+            nullptr),
+        std::make_shared<SequencedOptimizer>(xacc::getOptimizer("nlopt"),
+                                             std::shared_future<void>(),
+                                             firstDone)};
+    auto ensemble = xacc::getService<Algorithm>("vqe-ensemble");
+    EXPECT_TRUE(ensemble->initialize(
+        {{"ansatz", ruccsd},
+         {"accelerator", acc},
+         {"observables", observables},
+         {"optimizers", optimizers},
+         {"energy-bounds", std::vector<double>{-0.2, -1.2}}}));
+    ensemble->execute(buffer);
+    EXPECT_NEAR(-1.13717, (*buffer)["opt-val"].as<double>(), 1e-4);
+    EXPECT_EQ(1, (*buffer)["opt-problem"].as<int>());
+    EXPECT_EQ(std::vector<int>({1, 0}),
+              (*buffer)["cancelled"].as<std::vector<int>>());
+    EXPECT_EQ(2, buffer->nChildren());
+  }
+}
+
+TEST(VQETester, checkTemplateMode) {
+  auto acc = xacc::getAccelerator("qpp", {std::make_pair("vqe-mode", true)});
+  auto compiler = xacc::getCompiler("xasm");
+  auto ruccsd = compiler->compile(rucc, nullptr)->getComposite("f");
+  std::shared_ptr<Observable> observable =
+      std::make_shared<xacc::quantum::PauliOperator>();
+  observable->fromString(
+      "(0.174073,0) Z2 Z3 + (0.1202,0) Z1 Z3 + (0.165607,0) Z1 Z2 + "
+      "(0.165607,0) Z0 Z3 + (0.1202,0) Z0 Z2 + (-0.0454063,0) Y0 Y1 X2 X3 + "
+      "(-0.220041,0) Z3 + (-0.106477,0) + (0.17028,0) Z0 + (-0.220041,0) Z2 "
+      "+ (0.17028,0) Z1 + (-0.0454063,0) X0 X1 Y2 Y3 + (0.0454063,0) X0 Y1 "
+      "Y2 X3 + (0.168336,0) Z0 Z1 + (0.0454063,0) Y0 X1 X2 Y3");
+
+  // Same optimization trajectory with and without the template.
+  std::vector<std::vector<double>> energies;
+  std::vector<std::shared_ptr<Algorithm>> vqes;
+  for (const bool templateMode : {false, true}) {
+    auto buffer = xacc::qalloc(4);
+    auto vqe = xacc::getService<Algorithm>("vqe");
+    EXPECT_TRUE(vqe->initialize({{"ansatz", ruccsd},
+                                 {"accelerator", acc},
+                                 {"observable", observable},
+                                 {"optimizer", xacc::getOptimizer("nlopt")},
+                                 {"template-mode", templateMode}}));
+    vqe->execute(buffer);
+    EXPECT_NEAR(-1.13717, (*buffer)["opt-val"].as<double>(), 1e-4);
+    EXPECT_EQ(buffer->nChildren(),
+              (*buffer)["params-energy"].as<std::vector<double>>().size() *
+                  observable->getSubTerms().size());
+    energies.emplace_back((*buffer)["params-energy"].as<std::vector<double>>());
+    vqes.emplace_back(vqe);
+  }
+  EXPECT_EQ(energies[0].size(), energies[1].size());
+  for (int i = 0; i < std::min(energies[0].size(), energies[1].size()); i++) {
+    EXPECT_NEAR(energies[0][i], energies[1][i], 1e-9);
+  }
+
+  // Per-iteration host-side overhead of preparing the observed circuits:
+  // evaluate + observe (new circuits) vs. binding the template.
+  const int nIters = 200;
+  using Clock = std::chrono::steady_clock;
+  const auto toMicroSeconds = [&](Clock::duration in_duration) {
+    return std::chrono::duration<double, std::micro>(in_duration).count() /
+           nIters;
+  };
+  auto start = Clock::now();
+  for (int i = 0; i < nIters; i++) {
+    auto kernels = observable->observe(ruccsd->operator()({0.01 * i}));
+    EXPECT_EQ(kernels.size(), observable->getSubTerms().size());
+  }
+  const double observeTime = toMicroSeconds(Clock::now() - start);
+
+  xacc::quantum::ObservedCircuitTemplate circuitTemplate(
+      ruccsd, observable->observe(ruccsd));
+  start = Clock::now();
+  for (int i = 0; i < nIters; i++) {
+    const auto &kernels = circuitTemplate.bind({0.01 * i});
+    EXPECT_EQ(kernels.size(), observable->getSubTerms().size());
+  }
+  const double bindTime = toMicroSeconds(Clock::now() - start);
+  std::cout << "Circuit preparation per iteration: " << observeTime
+            << " us (evaluate + observe), " << bindTime
+            << " us (template bind)\n";
+
+  // Per-iteration time of a complete objective evaluation (incl. simulation)
+  for (int mode = 0; mode < 2; mode++) {
+    auto buffer = xacc::qalloc(4);
+    start = Clock::now();
+    for (int i = 0; i < nIters; i++) {
+      vqes[mode]->execute(buffer, {0.01 * i});
+    }
+    EXPECT_EQ(buffer->nChildren(), nIters * observable->getSubTerms().size());
+    std::cout << "VQE evaluation per iteration ("
+              << (mode == 0 ? "default" : "template-mode")
+              << "): " << toMicroSeconds(Clock::now() - start) << " us\n";
+  }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
@@ -17,6 +17,7 @@
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include "AcceleratorDecorator.hpp"
+#include "ObservedCircuitTemplate.hpp"
 
 #include <memory>
 #include <iomanip>
@@ -49,6 +50,12 @@ bool VQE::initialize(const HeterogeneousMap &parameters) {
   accelerator = parameters.getPointerLike<Accelerator>("accelerator");
   kernel = parameters.getPointerLike<CompositeInstruction>("ansatz");
 
+  templateMode = false;
+  if (parameters.keyExists<bool>("template-mode")) {
+    templateMode = parameters.get<bool>("template-mode");
+  }
+  circuitTemplate.reset();
+
   // if gradient is provided
   if (parameters.pointerLikeExists<AlgorithmGradientStrategy>(
           "gradient_strategy")) {
@@ -89,6 +96,41 @@ const std::vector<std::string> VQE::requiredParameters() const {
   return {"observable", "optimizer", "accelerator", "ansatz"};
 }
 
+std::vector<std::shared_ptr<CompositeInstruction>>
+VQE::observeKernels(const std::vector<double> &x,
+                    std::vector<bool> &out_isIdentity) const {
+  out_isIdentity.clear();
+  if (templateMode) {
+    // Observe the symbolic ansatz only once,
+    // then just bind the parameters in place.
+    if (!circuitTemplate) {
+      auto ansatz = xacc::as_shared_ptr(kernel);
+      circuitTemplate = std::make_shared<quantum::ObservedCircuitTemplate>(
+          ansatz, observable->observe(ansatz));
+    }
+    const auto &kernels = circuitTemplate->bind(x);
+    for (int i = 0; i < kernels.size(); i++) {
+      out_isIdentity.push_back(!circuitTemplate->hasMeasurements(i));
+    }
+    return kernels;
+  }
+
+  // call CompositeInstruction::operator()()
+  auto evaled = kernel->operator()(x);
+  // observe
+  auto kernels = observable->observe(evaled);
+  for (auto &f : kernels) {
+    int nFunctionInstructions;
+    if (f->getInstruction(0)->isComposite()) {
+      nFunctionInstructions = kernel->nInstructions() + f->nInstructions() - 1;
+    } else {
+      nFunctionInstructions = f->nInstructions();
+    }
+    out_isIdentity.push_back(nFunctionInstructions <= kernel->nInstructions());
+  }
+  return kernels;
+}
+
 void VQE::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
 
   if (!optimizer) {
@@ -111,26 +153,17 @@ void VQE::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
         std::vector<std::string> kernelNames;
         std::vector<std::shared_ptr<CompositeInstruction>> fsToExec;
 
-        // call CompositeInstruction::operator()()
-        auto evaled = kernel->operator()(x);
-        // observe
-        auto kernels = observable->observe(evaled);
+        std::vector<bool> isIdentity;
+        auto kernels = observeKernels(x, isIdentity);
 
         double identityCoeff = 0.0;
         int nInstructionsEnergy = kernels.size(), nInstructionsGradient = 0;
-        for (auto &f : kernels) {
+        for (int i = 0; i < kernels.size(); i++) {
+          auto &f = kernels[i];
           kernelNames.push_back(f->name());
           std::complex<double> coeff = f->getCoefficient();
 
-          int nFunctionInstructions;
-          if (f->getInstruction(0)->isComposite()) {
-            nFunctionInstructions =
-                kernel->nInstructions() + f->nInstructions() - 1;
-          } else {
-            nFunctionInstructions = f->nInstructions();
-          }
-
-          if (nFunctionInstructions > kernel->nInstructions()) {
+          if (!isIdentity[i]) {
             fsToExec.push_back(f);
             coefficients.push_back(std::real(coeff));
           } else {
@@ -316,20 +349,14 @@ VQE::execute(const std::shared_ptr<AcceleratorBuffer> buffer,
   std::vector<std::shared_ptr<CompositeInstruction>> fsToExec;
 
   double identityCoeff = 0.0;
-  auto evaled = xacc::as_shared_ptr(kernel)->operator()(x);
-  auto kernels = observable->observe(evaled);
-  for (auto &f : kernels) {
+  std::vector<bool> isIdentity;
+  auto kernels = observeKernels(x, isIdentity);
+  for (int i = 0; i < kernels.size(); i++) {
+    auto &f = kernels[i];
     kernelNames.push_back(f->name());
     std::complex<double> coeff = f->getCoefficient();
 
-    int nFunctionInstructions = 0;
-    if (f->getInstruction(0)->isComposite()) {
-      nFunctionInstructions = kernel->nInstructions() + f->nInstructions() - 1;
-    } else {
-      nFunctionInstructions = f->nInstructions();
-    }
-
-    if (nFunctionInstructions > kernel->nInstructions()) {
+    if (!isIdentity[i]) {
       fsToExec.push_back(f);
       coefficients.push_back(std::real(coeff));
     } else {
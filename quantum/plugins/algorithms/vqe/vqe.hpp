@@ -17,6 +17,9 @@
 #include "AlgorithmGradientStrategy.hpp"
 
 namespace xacc {
+namespace quantum {
+class ObservedCircuitTemplate;
+}
 namespace algorithm {
 class VQE : public Algorithm {
 protected:
@@ -28,6 +31,16 @@ protected:
   std::shared_ptr<AlgorithmGradientStrategy> gradientStrategy;
 
   HeterogeneousMap parameters;
+  // Template mode: the observed circuits are built once (lazily)
+  // and each evaluation only binds the new parameters.
+  bool templateMode = false;
+  mutable std::shared_ptr<quantum::ObservedCircuitTemplate> circuitTemplate;
+
+  // Observed circuits at the given parameters;
+  // out_isIdentity[i] is true if the i-th one has nothing to measure.
+  std::vector<std::shared_ptr<CompositeInstruction>>
+  observeKernels(const std::vector<double> &x,
+                 std::vector<bool> &out_isIdentity) const;
 
 public:
   bool initialize(const HeterogeneousMap &parameters) override;
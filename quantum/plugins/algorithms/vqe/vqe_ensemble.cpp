@@ -0,0 +1,368 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#include "vqe_ensemble.hpp"
+
+#include "Observable.hpp"
+#include "ThreadPool.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <numeric>
+#include <set>
+#include <thread>
+
+namespace {
+using namespace xacc;
+
+// Wraps the problem optimizer: once the problem is cancelled, the objective
+// function no longer executes anything and returns its last value, hence
+// the optimizer terminates on a flat function (this works for any
+// optimizer, without unwinding through its implementation).
+class CancellableOptimizer : public Optimizer {
+public:
+  CancellableOptimizer(std::shared_ptr<Optimizer> optimizer,
+                       std::function<bool()> isCancelled,
+                       std::function<void(double)> onEnergy,
+                       double initialValue)
+      : optimizer(optimizer), isCancelled(isCancelled), onEnergy(onEnergy),
+        lastEnergy(initialValue) {}
+
+  OptResult optimize(OptFunction &function) override {
+    OptFunction f(
+        [&](const std::vector<double> &x, std::vector<double> &dx) {
+          if (cancelled || isCancelled()) {
+            cancelled = true;
+            std::fill(dx.begin(), dx.end(), 0.0);
+            return lastEnergy;
+          }
+          lastEnergy = function(x, dx);
+          onEnergy(lastEnergy);
+          return lastEnergy;
+        },
+        function.dimensions());
+    return optimizer->optimize(f);
+  }
+
+  bool wasCancelled() const { return cancelled; }
+  const std::string get_algorithm() const override {
+    return optimizer->get_algorithm();
+  }
+  const bool isGradientBased() const override {
+    return optimizer->isGradientBased();
+  }
+  const std::string name() const override { return optimizer->name(); }
+  const std::string description() const override {
+    return optimizer->description();
+  }
+
+private:
+  std::shared_ptr<Optimizer> optimizer;
+  std::function<bool()> isCancelled;
+  std::function<void(double)> onEnergy;
+  double lastEnergy;
+  bool cancelled = false;
+};
+
+// Accelerators available to the ensemble workers:
+// a problem holds one accelerator for its whole VQE run.
+class AcceleratorPool {
+public:
+  AcceleratorPool(const std::vector<std::shared_ptr<Accelerator>> &accs)
+      : available(accs) {}
+
+  std::shared_ptr<Accelerator> acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return !available.empty(); });
+    auto acc = available.back();
+    available.pop_back();
+    return acc;
+  }
+
+  void release(std::shared_ptr<Accelerator> acc) {
+    {
+      std::scoped_lock<std::mutex> lock(mutex);
+      available.emplace_back(acc);
+    }
+    condition.notify_one();
+  }
+
+private:
+  std::vector<std::shared_ptr<Accelerator>> available;
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
+struct ProblemResult {
+  std::shared_ptr<AcceleratorBuffer> buffer;
+  double energy = std::numeric_limits<double>::max();
+  bool cancelled = false;
+};
+
+template <typename T>
+std::shared_ptr<T> getSharedPointerLike(const HeterogeneousMap &parameters,
+                                        const std::string &key) {
+  if (parameters.keyExists<std::shared_ptr<T>>(key)) {
+    return parameters.get<std::shared_ptr<T>>(key);
+  }
+  return xacc::as_shared_ptr(parameters.getPointerLike<T>(key));
+}
+} // namespace
+
+namespace xacc {
+namespace algorithm {
+bool VQEEnsemble::initialize(const HeterogeneousMap &parameters) {
+  observables.clear();
+  ansatze.clear();
+  optimizers.clear();
+  accelerators.clear();
+  energyBounds.clear();
+  cancelTolerance = 0.0;
+
+  if (!parameters.keyExists<std::vector<std::shared_ptr<Observable>>>(
+          "observables")) {
+    xacc::info("VQE Ensemble: no observables provided.");
+    return false;
+  }
+  observables =
+      parameters.get<std::vector<std::shared_ptr<Observable>>>("observables");
+  const auto nProblems = observables.size();
+
+  if (parameters.keyExists<std::vector<std::shared_ptr<CompositeInstruction>>>(
+          "ansatze")) {
+    ansatze = parameters.get<std::vector<std::shared_ptr<CompositeInstruction>>>(
+        "ansatze");
+  } else if (parameters.pointerLikeExists<CompositeInstruction>("ansatz")) {
+    ansatze.assign(
+        nProblems,
+        getSharedPointerLike<CompositeInstruction>(parameters, "ansatz"));
+  } else {
+    xacc::info("VQE Ensemble: no ansatz provided.");
+    return false;
+  }
+
+  if (parameters.keyExists<std::vector<std::shared_ptr<Optimizer>>>(
+          "optimizers")) {
+    optimizers =
+        parameters.get<std::vector<std::shared_ptr<Optimizer>>>("optimizers");
+  } else if (parameters.pointerLikeExists<Optimizer>("optimizer")) {
+    optimizers.assign(nProblems,
+                      getSharedPointerLike<Optimizer>(parameters, "optimizer"));
+  } else {
+    xacc::info("VQE Ensemble: no optimizer provided.");
+    return false;
+  }
+
+  if (parameters.keyExists<std::vector<std::shared_ptr<Accelerator>>>(
+          "accelerators")) {
+    accelerators = parameters.get<std::vector<std::shared_ptr<Accelerator>>>(
+        "accelerators");
+  } else if (parameters.pointerLikeExists<Accelerator>("accelerator")) {
+    auto acc = getSharedPointerLike<Accelerator>(parameters, "accelerator");
+    accelerators.emplace_back(acc);
+    // Accelerators are shared services: only those which are Cloneable can
+    // run several problems at the same time.
+    auto cloneable = std::dynamic_pointer_cast<Cloneable<Accelerator>>(acc);
+    if (cloneable) {
+      int nThreads = std::thread::hardware_concurrency();
+      if (parameters.keyExists<int>("threads")) {
+        nThreads = parameters.get<int>("threads");
+      }
+      const auto nClones = std::min<size_t>(std::max(nThreads, 1), nProblems);
+      while (accelerators.size() < nClones) {
+        auto clone = cloneable->clone();
+        clone->initialize(acc->getProperties());
+        accelerators.emplace_back(clone);
+      }
+    }
+  } else {
+    xacc::info("VQE Ensemble: no accelerator provided.");
+    return false;
+  }
+
+  if (ansatze.size() != nProblems || optimizers.size() != nProblems) {
+    xacc::error("VQE Ensemble: the number of ansatze and optimizers must "
+                "match the number of observables.");
+  }
+
+  if (parameters.keyExists<std::vector<double>>("energy-bounds")) {
+    energyBounds = parameters.get<std::vector<double>>("energy-bounds");
+    if (energyBounds.size() != nProblems) {
+      xacc::error("VQE Ensemble: the number of energy bounds must match the "
+                  "number of observables.");
+    }
+  }
+  if (parameters.keyExists<double>("cancel-tolerance")) {
+    cancelTolerance = parameters.get<double>("cancel-tolerance");
+  }
+
+  this->parameters = parameters;
+  return true;
+}
+
+const std::vector<std::string> VQEEnsemble::requiredParameters() const {
+  return {"observables", "optimizer", "accelerator", "ansatz"};
+}
+
+void VQEEnsemble::execute(const std::shared_ptr<AcceleratorBuffer> buffer) const {
+  const auto nProblems = observables.size();
+
+  // Problems share the ansatz instances, i.e. each kernel is compiled once by
+  // the caller. Evaluate each of them once up-front so that their lazily
+  // initialized state (e.g. the expression parser) is set before the
+  // concurrent evaluations.
+  std::set<CompositeInstruction *> distinctAnsatze;
+  for (auto &ansatz : ansatze) {
+    if (distinctAnsatze.insert(ansatz.get()).second) {
+      ansatz->operator()(std::vector<double>(ansatz->nVariables(), 0.0));
+    }
+  }
+
+  // Gradient strategies are shared services, hence can't be used by
+  // several VQE instances at the same time.
+  size_t nWorkers = accelerators.size();
+  if (std::any_of(optimizers.begin(), optimizers.end(),
+                  [](auto &opt) { return opt->isGradientBased(); })) {
+    xacc::warning("VQE Ensemble: gradient-based optimizers, running the "
+                  "problems one at a time.");
+    nWorkers = 1;
+  }
+
+  // Each problem runs its own copy of the optimizer. An instance which can't
+  // be cloned and is shared by several problems is used by one at a time.
+  std::vector<std::shared_ptr<Optimizer>> problemOptimizers(nProblems);
+  for (size_t i = 0; i < nProblems; ++i) {
+    auto cloneable =
+        std::dynamic_pointer_cast<Cloneable<Optimizer>>(optimizers[i]);
+    if (cloneable) {
+      problemOptimizers[i] = cloneable->clone();
+    } else {
+      problemOptimizers[i] = optimizers[i];
+      if (nWorkers > 1 && std::count(optimizers.begin(), optimizers.end(),
+                                     optimizers[i]) > 1) {
+        xacc::warning("VQE Ensemble: optimizer " + optimizers[i]->name() +
+                      " can't be cloned, running the problems one at a "
+                      "time.");
+        nWorkers = 1;
+      }
+    }
+  }
+
+  // Most promising problems first: they provide the best energy,
+  // i.e. the cancellation threshold, early.
+  std::vector<size_t> order(nProblems);
+  std::iota(order.begin(), order.end(), 0);
+  if (!energyBounds.empty()) {
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return energyBounds[a] < energyBounds[b];
+    });
+  }
+
+  // Best energy found so far by any problem: VQE energies are upper bounds
+  // on the ground state energy, hence any problem whose lower bound is above
+  // can be cancelled.
+  std::atomic<double> bestEnergy(std::numeric_limits<double>::max());
+  const auto updateBest = [&bestEnergy](double energy) {
+    double current = bestEnergy.load();
+    while (energy < current &&
+           !bestEnergy.compare_exchange_weak(current, energy)) {
+    }
+  };
+  const auto isCancelled = [&, this](size_t problemIdx) {
+    return !energyBounds.empty() &&
+           energyBounds[problemIdx] > bestEnergy.load() + cancelTolerance;
+  };
+
+  // Algorithm services are Cloneable: one VQE instance per problem.
+  std::vector<std::shared_ptr<Algorithm>> vqes(nProblems);
+  for (auto &vqe : vqes) {
+    vqe = xacc::getService<Algorithm>("vqe");
+  }
+
+  AcceleratorPool accPool(std::vector<std::shared_ptr<Accelerator>>(
+      accelerators.begin(), accelerators.begin() + nWorkers));
+  std::vector<ProblemResult> results(nProblems);
+  const auto runProblem = [&, this](size_t problemIdx) {
+    auto &result = results[problemIdx];
+    result.buffer = std::make_shared<AcceleratorBuffer>(
+        "problem_" + std::to_string(problemIdx), buffer->size());
+    if (isCancelled(problemIdx)) {
+      result.cancelled = true;
+      return;
+    }
+
+    auto acc = accPool.acquire();
+    auto optimizer = std::make_shared<CancellableOptimizer>(
+        problemOptimizers[problemIdx],
+        [&]() { return isCancelled(problemIdx); },
+        updateBest,
+        energyBounds.empty() ? 0.0 : energyBounds[problemIdx]);
+    auto vqeParams = parameters;
+    vqeParams.insert("observable", observables[problemIdx]);
+    vqeParams.insert("ansatz", ansatze[problemIdx]);
+    vqeParams.insert("accelerator", acc);
+    vqeParams.insert("optimizer", std::shared_ptr<Optimizer>(optimizer));
+    if (!vqes[problemIdx]->initialize(vqeParams)) {
+      accPool.release(acc);
+      xacc::error("VQE Ensemble: failed to initialize VQE for problem " +
+                  std::to_string(problemIdx));
+    }
+    vqes[problemIdx]->execute(result.buffer);
+    accPool.release(acc);
+
+    result.cancelled = optimizer->wasCancelled();
+    result.energy = (*result.buffer)["opt-val"].as<double>();
+  };
+
+  {
+    ThreadPool pool(nWorkers);
+    std::vector<std::future<void>> tasks;
+    for (auto problemIdx : order) {
+      tasks.emplace_back(pool.enqueue(runProblem, problemIdx));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
+  }
+
+  // Collect the results (in problem order)
+  std::vector<double> energies;
+  std::vector<int> cancelled;
+  int bestIdx = -1;
+  for (size_t i = 0; i < nProblems; ++i) {
+    auto &result = results[i];
+    buffer->appendChild(result.buffer->name(), result.buffer);
+    energies.emplace_back(result.energy);
+    cancelled.emplace_back(result.cancelled);
+    if (!result.cancelled &&
+        (bestIdx < 0 || result.energy < results[bestIdx].energy)) {
+      bestIdx = i;
+    }
+  }
+
+  buffer->addExtraInfo("opt-vals", energies);
+  buffer->addExtraInfo("cancelled", cancelled);
+  if (bestIdx < 0) {
+    xacc::warning("VQE Ensemble: all the problems were cancelled, please "
+                  "check the energy bounds.");
+    return;
+  }
+  buffer->addExtraInfo("opt-problem", bestIdx);
+  buffer->addExtraInfo("opt-val", ExtraInfo(results[bestIdx].energy));
+  buffer->addExtraInfo("opt-params",
+                       (*results[bestIdx].buffer)["opt-params"]);
+}
+} // namespace algorithm
+} // namespace xacc
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Alexander J. McCaskey - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_ALGORITHM_VQE_ENSEMBLE_HPP_
+#define XACC_ALGORITHM_VQE_ENSEMBLE_HPP_
+
+#include "Algorithm.hpp"
+
+namespace xacc {
+namespace algorithm {
+// Runs a set of independent VQE problems (observable, ansatz, optimizer),
+// e.g. the symmetry sectors of a tapered Hamiltonian or the points of a
+// bond-length scan, concurrently on a pool of accelerators.
+//
+// Parameters:
+//  - observables: vector of Observables, one per problem.
+//  - ansatz (or ansatze, one per problem): shared ansatz circuits are
+//    evaluated by all the problems using them, i.e. compiled once.
+//  - optimizer (or optimizers, one per problem): each problem runs a clone
+//    of its optimizer, if the optimizer is Cloneable.
+//  - accelerator (or accelerators): one problem runs on each accelerator at
+//    a time. A single Cloneable accelerator is cloned for each thread.
+//  - threads: number of accelerator clones (default: hardware concurrency).
+//  - energy-bounds: lower bounds on the problem energies. A problem whose
+//    bound is worse than the best energy found so far (by any problem) can't
+//    be the ground state, hence it is cancelled (or never started).
+//  - cancel-tolerance: margin added to the best energy before cancelling
+//    (e.g. to account for shot noise), default 0.0.
+class VQEEnsemble : public Algorithm {
+protected:
+  std::vector<std::shared_ptr<Observable>> observables;
+  std::vector<std::shared_ptr<CompositeInstruction>> ansatze;
+  std::vector<std::shared_ptr<Optimizer>> optimizers;
+  std::vector<std::shared_ptr<Accelerator>> accelerators;
+  std::vector<double> energyBounds;
+  double cancelTolerance = 0.0;
+
+  HeterogeneousMap parameters;
+
+public:
+  bool initialize(const HeterogeneousMap &parameters) override;
+  const std::vector<std::string> requiredParameters() const override;
+
+  void execute(const std::shared_ptr<AcceleratorBuffer> buffer) const override;
+  const std::string name() const override { return "vqe-ensemble"; }
+  const std::string description() const override {
+    return "Concurrent execution of a set of VQE problems.";
+  }
+  DEFINE_ALGORITHM_CLONE(VQEEnsemble)
+};
+} // namespace algorithm
+} // namespace xacc
+#endif
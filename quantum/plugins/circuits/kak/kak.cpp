@@ -6,6 +6,7 @@
 #include <unsupported/Eigen/KroneckerProduct>
 #include <unsupported/Eigen/MatrixFunctions>
 #include "PauliOperator.hpp"
+#include "StructuredPauli.hpp"
 
 namespace {
 constexpr std::complex<double> I{0.0, 1.0};
@@ -177,18 +178,17 @@ bool isCanonicalized(double x, double y, double z) {
 }
 // Compute exp(i(x XX + y YY + z ZZ)) matrix
 Eigen::Matrix4cd interactionMatrixExp(double x, double y, double z) {
-  Eigen::MatrixXcd X{Eigen::MatrixXcd::Zero(2, 2)};
-  Eigen::MatrixXcd Y{Eigen::MatrixXcd::Zero(2, 2)};
-  Eigen::MatrixXcd Z{Eigen::MatrixXcd::Zero(2, 2)};
-  X << 0, 1, 1, 0;
-  Y << 0, -I, I, 0;
-  Z << 1, 0, 0, -1;
-  auto XX = Eigen::kroneckerProduct(X, X);
-  auto YY = Eigen::kroneckerProduct(Y, Y);
-  auto ZZ = Eigen::kroneckerProduct(Z, Z);
-  Eigen::MatrixXcd herm = x * XX + y * YY + z * ZZ;
-  herm = I * herm;
-  Eigen::MatrixXcd unitary = herm.exp();
+  // XX, YY and ZZ commute and square to identity:
+  // exp(i a P) = cos(a) I + i sin(a) P, no matrix exponential needed.
+  using xacc::circuits::PauliOp;
+  const std::pair<PauliOp, double> terms[] = {
+      {PauliOp::X, x}, {PauliOp::Y, y}, {PauliOp::Z, z}};
+  Eigen::MatrixXcd unitary = Eigen::MatrixXcd::Identity(4, 4);
+  for (const auto &[op, angle] : terms) {
+    const xacc::circuits::PauliString pauli(2, {{op, 0}, {op, 1}});
+    unitary = std::cos(angle) * unitary +
+              I * std::sin(angle) * pauli.applyLeft(unitary);
+  }
   return unitary;
 }
 
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "StructuredPauli.hpp"
+#include <Eigen/Eigenvalues>
+#include <array>
+#include <cassert>
+
+namespace {
+constexpr std::complex<double> I { 0.0, 1.0 };
+
+inline int popcount(uint64_t in_val)
+{
+    return __builtin_popcountll(in_val);
+}
+
+// Bit offsets of the 4 local basis states of a two-qubit operator.
+std::array<uint64_t, 4> embeddedOffsets(const std::pair<size_t, size_t>& in_qubits, size_t in_nbQubits)
+{
+    assert(in_qubits.first < in_nbQubits && in_qubits.second < in_nbQubits);
+    const uint64_t bit1 = 1ULL << (in_nbQubits - in_qubits.first - 1);
+    const uint64_t bit2 = 1ULL << (in_nbQubits - in_qubits.second - 1);
+    return { 0, bit2, bit1, bit1 | bit2 };
+}
+}
+
+namespace xacc {
+namespace circuits {
+PauliString::PauliString(size_t in_nbQubits):
+    m_nbQubits(in_nbQubits),
+    m_xMask(0),
+    m_zMask(0),
+    m_yPhase(1.0)
+{}
+
+PauliString::PauliString(size_t in_nbQubits, const std::vector<std::pair<PauliOp, size_t>>& in_ops):
+    PauliString(in_nbQubits)
+{
+    for (const auto& [op, qubit] : in_ops)
+    {
+        assert(qubit < m_nbQubits);
+        const uint64_t bit = 1ULL << (m_nbQubits - qubit - 1);
+        if (op == PauliOp::X || op == PauliOp::Y)
+        {
+            m_xMask |= bit;
+        }
+        if (op == PauliOp::Z || op == PauliOp::Y)
+        {
+            m_zMask |= bit;
+        }
+    }
+    // Y = i X Z
+    static const std::complex<double> powersOfI[] = { 1.0, I, -1.0, -I };
+    m_yPhase = powersOfI[popcount(m_xMask & m_zMask) % 4];
+}
+
+std::complex<double> PauliString::phase(uint64_t in_col) const
+{
+    return (popcount(in_col & m_zMask) & 1) ? -m_yPhase : m_yPhase;
+}
+
+void PauliString::addTo(Eigen::MatrixXcd& io_mat, std::complex<double> in_coeff) const
+{
+    assert(io_mat.rows() == (1LL << m_nbQubits) && io_mat.cols() == io_mat.rows());
+    for (uint64_t col = 0; col < (uint64_t)io_mat.cols(); ++col)
+    {
+        io_mat(col ^ m_xMask, col) += in_coeff * phase(col);
+    }
+}
+
+Eigen::MatrixXcd PauliString::applyLeft(const Eigen::MatrixXcd& in_mat) const
+{
+    assert(in_mat.rows() == (1LL << m_nbQubits));
+    Eigen::MatrixXcd result(in_mat.rows(), in_mat.cols());
+    for (uint64_t row = 0; row < (uint64_t)in_mat.rows(); ++row)
+    {
+        result.row(row) = phase(row ^ m_xMask) * in_mat.row(row ^ m_xMask);
+    }
+    return result;
+}
+
+Eigen::MatrixXcd PauliString::applyRight(const Eigen::MatrixXcd& in_mat) const
+{
+    assert(in_mat.cols() == (1LL << m_nbQubits));
+    Eigen::MatrixXcd result(in_mat.rows(), in_mat.cols());
+    for (uint64_t col = 0; col < (uint64_t)in_mat.cols(); ++col)
+    {
+        result.col(col) = phase(col) * in_mat.col(col ^ m_xMask);
+    }
+    return result;
+}
+
+Eigen::MatrixXcd PauliString::toMatrix() const
+{
+    const auto dim = 1ULL << m_nbQubits;
+    Eigen::MatrixXcd result = Eigen::MatrixXcd::Zero(dim, dim);
+    addTo(result);
+    return result;
+}
+
+Eigen::MatrixXcd PauliSum::toMatrix() const
+{
+    const auto dim = 1ULL << nbQubits;
+    Eigen::MatrixXcd result = Eigen::MatrixXcd::Zero(dim, dim);
+    for (const auto& [pauli, coeff] : terms)
+    {
+        pauli.addTo(result, coeff);
+    }
+    return result;
+}
+
+const std::vector<PauliString>& twoQubitPaulis()
+{
+    static const std::vector<PauliString> paulis = []() {
+        const PauliOp ops[] = { PauliOp::I, PauliOp::X, PauliOp::Y, PauliOp::Z };
+        std::vector<PauliString> result;
+        for (const auto& op1 : ops)
+        {
+            for (const auto& op2 : ops)
+            {
+                result.emplace_back(PauliString(2, { { op1, 0 }, { op2, 1 } }));
+            }
+        }
+        return result;
+    }();
+    return paulis;
+}
+
+void addEmbedded(Eigen::MatrixXcd& io_mat, const Eigen::Matrix4cd& in_op, const std::pair<size_t, size_t>& in_qubits, size_t in_nbQubits, std::complex<double> in_coeff)
+{
+    const auto offsets = embeddedOffsets(in_qubits, in_nbQubits);
+    const uint64_t mask = offsets[3];
+    for (uint64_t base = 0; base < (uint64_t)io_mat.cols(); ++base)
+    {
+        if (base & mask)
+        {
+            continue;
+        }
+        for (size_t localCol = 0; localCol < 4; ++localCol)
+        {
+            for (size_t localRow = 0; localRow < 4; ++localRow)
+            {
+                io_mat(base | offsets[localRow], base | offsets[localCol]) += in_coeff * in_op(localRow, localCol);
+            }
+        }
+    }
+}
+
+void rightMultiplyEmbedded(Eigen::MatrixXcd& io_mat, const Eigen::Matrix4cd& in_op, const std::pair<size_t, size_t>& in_qubits, size_t in_nbQubits)
+{
+    const auto offsets = embeddedOffsets(in_qubits, in_nbQubits);
+    const uint64_t mask = offsets[3];
+    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 4> columns(io_mat.rows(), 4);
+    for (uint64_t base = 0; base < (uint64_t)io_mat.cols(); ++base)
+    {
+        if (base & mask)
+        {
+            continue;
+        }
+        // Only these 4 columns are mixed by the operator.
+        for (size_t local = 0; local < 4; ++local)
+        {
+            columns.col(local) = io_mat.col(base | offsets[local]);
+        }
+        for (size_t local = 0; local < 4; ++local)
+        {
+            io_mat.col(base | offsets[local]) = columns * in_op.col(local);
+        }
+    }
+}
+
+std::vector<Eigen::Matrix4cd> expHermitianBatch(const std::vector<Eigen::Matrix4cd>& in_hermitians)
+{
+    std::vector<Eigen::Matrix4cd> result;
+    result.reserve(in_hermitians.size());
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix4cd> solver;
+    for (const auto& herm : in_hermitians)
+    {
+        // H = V D V^dagger => exp(iH) = V exp(iD) V^dagger
+        solver.compute(herm);
+        const Eigen::Vector4cd phases = (I * solver.eigenvalues().cast<std::complex<double>>()).array().exp();
+        result.emplace_back(solver.eigenvectors() * phases.asDiagonal() * solver.eigenvectors().adjoint());
+    }
+    return result;
+}
+} // namespace circuits
+} // namespace xacc
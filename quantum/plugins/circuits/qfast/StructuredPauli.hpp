@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+
+#include <Eigen/Dense>
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Structured Pauli algebra for the synthesizers (QFAST, KAK):
+// Pauli strings act on matrices by an index permutation and a phase,
+// hence the dense 2^n x 2^n Pauli matrices (4^n of them) are never built.
+//
+// Qubit ordering: Kronecker product order, i.e. qubit 0 is the most
+// significant bit of the matrix index.
+namespace xacc {
+namespace circuits {
+enum class PauliOp : size_t { I = 0, X = 1, Y = 2, Z = 3 };
+
+// P = i^|x & z| X^x Z^z, hence P|j> = i^|x & z| (-1)^|j & z| |j ^ x>
+class PauliString
+{
+public:
+    PauliString(size_t in_nbQubits = 0);
+    PauliString(size_t in_nbQubits, const std::vector<std::pair<PauliOp, size_t>>& in_ops);
+    size_t nbQubits() const { return m_nbQubits; }
+    uint64_t xMask() const { return m_xMask; }
+    uint64_t zMask() const { return m_zMask; }
+    // <j ^ x|P|j>
+    std::complex<double> phase(uint64_t in_col) const;
+    // io_mat += in_coeff * P
+    void addTo(Eigen::MatrixXcd& io_mat, std::complex<double> in_coeff = 1.0) const;
+    // P * in_mat
+    Eigen::MatrixXcd applyLeft(const Eigen::MatrixXcd& in_mat) const;
+    // in_mat * P
+    Eigen::MatrixXcd applyRight(const Eigen::MatrixXcd& in_mat) const;
+    // Dense matrix (for small number of qubits only)
+    Eigen::MatrixXcd toMatrix() const;
+
+private:
+    size_t m_nbQubits;
+    uint64_t m_xMask;
+    uint64_t m_zMask;
+    // i^|x & z|
+    std::complex<double> m_yPhase;
+};
+
+// Sum of Pauli strings with complex coefficients.
+struct PauliSum
+{
+    size_t nbQubits;
+    std::vector<std::pair<PauliString, std::complex<double>>> terms;
+    Eigen::MatrixXcd toMatrix() const;
+};
+
+// The 16 two-qubit Pauli strings P_j = sigma_(j/4) x sigma_(j%4)
+// (with I, X, Y, Z = 0, 1, 2, 3).
+const std::vector<PauliString>& twoQubitPaulis();
+
+// Two-qubit operators embedded in a n-qubit space:
+// the local index is (b1 b2), b1 being the state of in_qubits.first.
+// io_mat += in_coeff * embed(in_op)
+void addEmbedded(Eigen::MatrixXcd& io_mat, const Eigen::Matrix4cd& in_op, const std::pair<size_t, size_t>& in_qubits, size_t in_nbQubits, std::complex<double> in_coeff = 1.0);
+// io_mat = io_mat * embed(in_op), in O(4 * 4^n) rather than a dense product.
+void rightMultiplyEmbedded(Eigen::MatrixXcd& io_mat, const Eigen::Matrix4cd& in_op, const std::pair<size_t, size_t>& in_qubits, size_t in_nbQubits);
+
+// exp(i * H) of a batch of 4x4 Hermitian matrices
+// (fixed-size eigen-decompositions, no Pade approximant).
+std::vector<Eigen::Matrix4cd> expHermitianBatch(const std::vector<Eigen::Matrix4cd>& in_hermitians);
+} // namespace circuits
+} // namespace xacc
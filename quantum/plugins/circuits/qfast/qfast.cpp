@@ -12,23 +12,19 @@
  *******************************************************************************/
 
 #include "qfast.hpp"
+#include "StructuredPauli.hpp"
+#include "ThreadPool.hpp"
 #include "xacc.hpp"
 #include "xacc_service.hpp"
-#include <unsupported/Eigen/KroneckerProduct>
 #include <unsupported/Eigen/MatrixFunctions>
-#include <unsupported/Eigen/NumericalDiff>
 #include <numeric>
 #include <random>
 #include "json.hpp"
 #include "xacc_config.hpp"
 #include <fstream>
+#include <limits>
 
 namespace {
-Eigen::MatrixXcd X { Eigen::MatrixXcd::Zero(2, 2)};      
-Eigen::MatrixXcd Y { Eigen::MatrixXcd::Zero(2, 2)};       
-Eigen::MatrixXcd Z { Eigen::MatrixXcd::Zero(2, 2)};  
-Eigen::MatrixXcd Id { Eigen::MatrixXcd::Identity(2, 2)};  
-
 constexpr std::complex<double> I { 0.0, 1.0 };
 
 int getTempId()
@@ -38,58 +34,6 @@ int getTempId()
   return tempIdCounter;
 }
 
-const std::vector<Eigen::MatrixXcd>& getPaulisMap(int n)
-{
-    static std::vector<std::vector<Eigen::MatrixXcd>> cachedMap;
-    static bool init = false;
-    if (!init)
-    {
-        X << 0, 1, 1, 0;
-        Y << 0, -I, I, 0;
-        Z << 1, 0, 0, -1;
-        cachedMap.emplace_back(std::vector<Eigen::MatrixXcd> { Id });
-        cachedMap.emplace_back(std::vector<Eigen::MatrixXcd> { Id, X, Y, Z });
-        init = true;
-    }
-
-    if (n < cachedMap.size())
-    {
-        return cachedMap[n];
-    }
-
-    std::vector<Eigen::MatrixXcd> norderPaulis;
-    
-    for (const auto& paulisNminus1 : getPaulisMap(n - 1))
-    {
-        for (const auto& paulis1 : getPaulisMap(1))
-        {
-            norderPaulis.emplace_back(Eigen::kroneckerProduct(paulisNminus1, paulis1));
-        }
-    }
-    
-    cachedMap.emplace_back(std::move(norderPaulis));
-    return cachedMap[n];
-}
-
-enum class PauliOp : size_t { I = 0, X = 1, Y = 2, Z = 3 };
-const PauliOp SinglePauliOps[] = { PauliOp::I, PauliOp::X, PauliOp::Y, PauliOp::Z };
-
-// Index to the all Paulis (at a specific number of qubits):
-// Note: we limit ourselves to the case of two operators only.
-// Indexing scheme: Pauli string as base-4 bitstring:
-// with I = 0, X = 1, Y = 2, Z = 3
-// e.g. XXY = 1 * 4^2 + 1 & 4^1 + 2 * 4^0 = 22 (in base 10)
-size_t computePauliMapIndex(size_t in_nbQubits, const std::pair<PauliOp, size_t>& in_op1, const std::pair<PauliOp, size_t>& in_op2)
-{
-    assert(in_op1.second != in_op2.second);
-    assert(in_op1.second < in_nbQubits);
-    assert(in_op2.second < in_nbQubits);
-    const auto opToIndx = [&in_nbQubits](const std::pair<PauliOp, size_t>& in_op) -> size_t {
-        return static_cast<size_t>(in_op.first) * std::pow(4, in_nbQubits - in_op.second - 1);
-    };
-    return opToIndx(in_op1) + opToIndx(in_op2);
-}
-
 std::vector<std::pair<size_t, size_t>> qubitPairCombinations(size_t N)
 {
     std::string bitmask(2, 1);
@@ -150,6 +94,53 @@ void softmax(Iter iterBegin, Iter iterEnd)
     const ValueType expTol = std::accumulate(iterBegin, iterEnd, 0.0);
     std::transform(iterBegin, iterEnd, iterBegin, std::bind(std::divides<ValueType>(), std::placeholders::_1, expTol));  
 }
+
+// Finite-difference gradient, with the same steps as Eigen::NumericalDiff.
+// Parameter blocks (i.e. layers) are evaluated concurrently.
+template <typename CostFunc>
+std::vector<double> finiteDifferenceGradient(const CostFunc& in_costFunc, const Eigen::VectorXd& in_x, double in_fx, bool in_central, const std::vector<size_t>& in_blockSizes)
+{
+    const double eps = std::sqrt(std::numeric_limits<double>::epsilon());
+    std::vector<double> grad(in_x.size());
+    const auto evalBlock = [&](size_t in_begin, size_t in_end) {
+        Eigen::VectorXd x = in_x;
+        for (size_t i = in_begin; i < in_end; ++i)
+        {
+            double h = eps * std::abs(in_x(i));
+            if (h == 0.0)
+            {
+                h = eps;
+            }
+            x(i) = in_x(i) + h;
+            const double fPlus = in_costFunc(x);
+            if (in_central)
+            {
+                x(i) = in_x(i) - h;
+                grad[i] = (fPlus - in_costFunc(x)) / (2.0 * h);
+            }
+            else
+            {
+                grad[i] = (fPlus - in_fx) / h;
+            }
+            x(i) = in_x(i);
+        }
+    };
+
+    xacc::ThreadPool pool;
+    std::vector<std::future<void>> blocks;
+    size_t begin = 0;
+    for (const auto& blockSize : in_blockSizes)
+    {
+        blocks.emplace_back(pool.enqueue(evalBlock, begin, begin + blockSize));
+        begin += blockSize;
+    }
+    assert(begin == in_x.size());
+    for (auto& block : blocks)
+    {
+        block.get();
+    }
+    return grad;
+}
 }
 
 namespace xacc {
@@ -300,8 +291,7 @@ std::vector<QFAST::PauliReps> QFAST::explore()
     for (int i = 0; i < m_initialDepth; ++i)
     {
         const auto& topology = alternativeLayer ? m_locationModel->buckets.second : m_locationModel->buckets.first;
-        const auto& topologyPauli = alternativeLayer ? m_locationModel->bucketPaulis.second : m_locationModel->bucketPaulis.first;
-        addLayer(layers, topology, topologyPauli);
+        addLayer(layers, topology);
         alternativeLayer = !alternativeLayer;
     }
    
@@ -316,9 +306,8 @@ std::vector<QFAST::PauliReps> QFAST::explore()
         else
         {
             const auto& topology = alternativeLayer ? m_locationModel->buckets.second : m_locationModel->buckets.first;
-            const auto& topologyPauli = alternativeLayer ? m_locationModel->bucketPaulis.second : m_locationModel->bucketPaulis.first;
             // Add one more layer
-            addLayer(layers, topology, topologyPauli);
+            addLayer(layers, topology);
             alternativeLayer = !alternativeLayer;
         }
     }
@@ -333,17 +322,24 @@ std::vector<QFAST::Block> QFAST::refine(const std::vector<QFAST::PauliReps>& in_
     const auto fixedLoc = m_locationModel->fixLocations(refinedReps);
     assert(refinedReps.size() == fixedLoc.size());
     std::vector<double> initialParams; 
+    std::vector<size_t> blockSizes;
     // Only function params since the location has been fixed
     for (const auto& layer : refinedReps)
     {
         initialParams.insert(initialParams.end(), layer.funcValues.begin(), layer.funcValues.end());
+        blockSizes.emplace_back(layer.funcValues.size());
     }
     
     const int nbParams = initialParams.size();
     const int maxEval = nbParams * 1000;
 
-    RefineDiffFunctor diffFunctor(this, refinedReps, nbParams);
-    Eigen::NumericalDiff<RefineDiffFunctor> numDiff(diffFunctor);    
+    RefineDiffFunctor diffFunctor(this, refinedReps, fixedLoc, nbParams);
+    const auto costFunc = [&diffFunctor](const Eigen::VectorXd& in_x) {
+        // Just 1 output:
+        Eigen::VectorXd outVal(1);
+        diffFunctor(in_x, outVal);
+        return outVal(0);
+    };
     
     auto optimizer = m_optimizer ? m_optimizer : xacc::getOptimizer("nlopt");
 
@@ -385,21 +381,11 @@ std::vector<QFAST::Block> QFAST::refine(const std::vector<QFAST::PauliReps>& in_
         [&](const std::vector<double>& x, std::vector<double>& grad) 
         {
             const Eigen::VectorXd inputParams = Eigen::Map<const Eigen::VectorXd>(x.data(), x.size());
-            // Just 1 output:
-            Eigen::VectorXd outVal(1);
-            numDiff(inputParams, outVal);
-            const double costValue = outVal(0);
+            const double costValue = costFunc(inputParams);
             // If grads are needed, compute them.
             if (needGrads)
             {
-                Eigen::MatrixXd gradients(1, x.size());
-                numDiff.df(inputParams, gradients);
-                assert(gradients.rows() == 1 && gradients.cols() == x.size());
-                grad.clear();
-                for (int i = 0; i < x.size(); ++i)
-                {
-                    grad.emplace_back(gradients(0, i));
-                }
+                grad = finiteDifferenceGradient(costFunc, inputParams, costValue, false, blockSizes);
             }
             return costValue;
         },
@@ -419,44 +405,27 @@ std::vector<QFAST::Block> QFAST::refine(const std::vector<QFAST::PauliReps>& in_
     }
 
     // Double check trace distance:
-    std::vector<Eigen::MatrixXcd> layerMat;
-    {
-        Eigen::MatrixXcd accumU(Eigen::MatrixXcd::Identity(1ULL << m_nbQubits, 1ULL << m_nbQubits));
-        bool alternativeLayer = false;
-        for (auto& layer : refinedReps)
-        {
-            const auto& topology = alternativeLayer ? m_locationModel->buckets.second : m_locationModel->buckets.first;
-            const auto& topologyPauli = alternativeLayer ? m_locationModel->bucketPaulis.second : m_locationModel->bucketPaulis.first;
-            layerMat.emplace_back(layerToUnitaryMatrix(layer, topology, topologyPauli));
-            accumU = accumU * layerMat.back();
-            alternativeLayer = !alternativeLayer;
-        }
+    assert(evaluateCostFunc(fixedLayersToUnitaryMatrix(refinedReps, fixedLoc)) <= m_distanceLimit);
 
-        assert(evaluateCostFunc(accumU) <= m_distanceLimit);
+    std::vector<BlockMatrix> generators;
+    for (const auto& layer : refinedReps)
+    {
+        generators.emplace_back(layerGenerator(layer));
     }
-   
+    const auto blockMats = expHermitianBatch(generators);
+
     std::vector<QFAST::Block> resultBlocks;
-    size_t blockIdx = 0;
-    for (const auto& layer : refinedReps)
+    bool alternativeLayer = false;
+    for (size_t blockIdx = 0; blockIdx < refinedReps.size(); ++blockIdx)
     {
-        const std::pair<size_t, size_t> mapBits = (fixedLoc[blockIdx].first < fixedLoc[blockIdx].second) ? 
-            std::make_pair(0, 1) : 
-            std::make_pair(1, 0);
-        const auto subPaulis = generateAllPaulis(2, { mapBits })[0];        
-        assert(subPaulis.size() == layer.funcValues.size());
         Block newBlock;
         newBlock.qubits = fixedLoc[blockIdx];
-        Eigen::MatrixXcd gateMat = Eigen::MatrixXcd::Zero(4, 4);
-        for (size_t j = 0; j < subPaulis.size(); ++j)
-        {
-            gateMat += (layer.funcValues[j] * subPaulis[j]);
-        }
-        gateMat = I * gateMat;
         // Exponential: exp(i*H)
-        newBlock.uMat = gateMat.exp();
+        newBlock.uMat = blockMats[blockIdx];
+        const auto& topology = alternativeLayer ? m_locationModel->buckets.second : m_locationModel->buckets.first;
+        assert(allClose(layerToUnitaryMatrix(refinedReps[blockIdx], topology), newBlock.toFullMat(m_nbQubits), 1e-9));
+        alternativeLayer = !alternativeLayer;
         resultBlocks.emplace_back(newBlock);
-        assert(allClose(layerMat[blockIdx], newBlock.toFullMat(m_nbQubits)));
-        blockIdx++;
     }
     
     return resultBlocks;
@@ -466,46 +435,30 @@ int QFAST::RefineDiffFunctor::operator()(const InputType& in_x, ValueType& out_f
 {
     // Should only have one output value.
     assert(values() == 1);
-    const auto nbQubits = m_parent->m_nbQubits;
-    const auto& locationModel = m_parent->m_locationModel;
-
-    Eigen::MatrixXcd accumU(Eigen::MatrixXcd::Identity(1ULL << nbQubits, 1ULL << nbQubits));
-    std::vector<double> params;
-    size_t idx = 0;
     size_t paramIdx = 0;
-    bool alternativeLayer = false;
     auto optLayers = m_layerConfigs;
     for (auto& layer : optLayers)
     {
-        params.clear();
-        params.assign(in_x.begin() + paramIdx, in_x.begin() + paramIdx + layer.funcValues.size());
-        assert(params.size() == layer.funcValues.size());
-        paramIdx += params.size();
-        // Added the fixed location values (not being optimized)
-        params.insert(params.end(), layer.locValues.begin(), layer.locValues.end());                
-        layer.updateParams(params);
-        idx++;
-        auto& topology = alternativeLayer ? locationModel->buckets.second : locationModel->buckets.first;
-        auto& topologyPauli = alternativeLayer ? locationModel->bucketPaulis.second : locationModel->bucketPaulis.first;
-        accumU = accumU * m_parent->layerToUnitaryMatrix(layer, topology, topologyPauli);
-        alternativeLayer = !alternativeLayer;
+        // Only the function values are optimized (fixed locations).
+        const auto nbFuncParams = layer.funcValues.size();
+        layer.funcValues.assign(in_x.begin() + paramIdx, in_x.begin() + paramIdx + nbFuncParams);
+        paramIdx += nbFuncParams;
     }
 
-    const double costValue = m_parent->evaluateCostFunc(accumU);    
+    const double costValue = m_parent->evaluateCostFunc(m_parent->fixedLayersToUnitaryMatrix(optLayers, m_locations));    
     out_fvec[0] = costValue;
     return 0;
 }
 
-void QFAST::addLayer(std::vector<QFAST::PauliReps>& io_currentLayers, const Topology& in_layerTopology, const TopologyPaulis& in_topologyPaulis) const
+void QFAST::addLayer(std::vector<QFAST::PauliReps>& io_currentLayers, const Topology& in_layerTopology) const
 {
-    assert(in_layerTopology.size() == in_topologyPaulis.size());
     assert(!in_layerTopology.empty());
     
     xacc::info("[Explore] Adding a layer. Number of layers = " + std::to_string(io_currentLayers.size() + 1)); 
     // Add a layer:
     QFAST::PauliReps newLayer;
-    const double initialParam = 1.0 / in_topologyPaulis[0].size();
-    newLayer.funcValues.assign(in_topologyPaulis[0].size(), initialParam);
+    const double initialParam = 1.0 / NB_BLOCK_PAULIS;
+    newLayer.funcValues.assign(NB_BLOCK_PAULIS, initialParam);
     // Random:
     std::random_device rd;
     std::mt19937 mt(rd());
@@ -545,30 +498,15 @@ std::shared_ptr<CompositeInstruction> QFAST::genericBlockToGates(const QFAST::Bl
     return kak;
 }
  
-std::vector<std::vector<Eigen::MatrixXcd>> QFAST::generateAllPaulis(size_t in_nbQubits, const Topology& in_topology)
+QFAST::BlockMatrix QFAST::layerGenerator(const PauliReps& in_layer)
 {
-    assert(in_nbQubits >= 2);
-    
-    // Get all Paulis
-    const auto& paulis = getPaulisMap(in_nbQubits);
-
-    std::vector<std::vector<Eigen::MatrixXcd>> result;
-    
-    for (const auto& pair : in_topology)
+    assert(in_layer.funcValues.size() == NB_BLOCK_PAULIS);
+    const auto& paulis = twoQubitPaulis();
+    Eigen::MatrixXcd result = Eigen::MatrixXcd::Zero(4, 4);
+    for (size_t j = 0; j < paulis.size(); ++j)
     {
-        const auto bit1 = pair.first;
-        const auto bit2 = pair.second;
-        auto& paulisForPair = result.emplace_back(std::vector<Eigen::MatrixXcd>{});
-        for (const auto& op1 : SinglePauliOps)
-        {
-            for (const auto& op2 : SinglePauliOps)
-            {
-                paulisForPair.emplace_back(paulis[computePauliMapIndex(in_nbQubits, { op1, bit1 }, { op2, bit2 })]);
-            }
-        }
-        assert(result.back().size() == 16);
+        paulis[j].addTo(result, in_layer.funcValues[j]);
     }
-
     return result;
 }
 
@@ -578,11 +516,13 @@ bool QFAST::optimizeAtDepth(std::vector<PauliReps>& io_repsToOpt, double in_targ
    
     int nbParams = 0;
     std::vector<double> initialParams; 
+    std::vector<size_t> blockSizes;
     for (const auto& layer : io_repsToOpt)
     {
         initialParams.insert(initialParams.end(), layer.funcValues.begin(), layer.funcValues.end());
         initialParams.insert(initialParams.end(), layer.locValues.begin(), layer.locValues.end());
         nbParams += layer.nbParams();
+        blockSizes.emplace_back(layer.nbParams());
     }
     
     const int maxEval = nbParams * 100;
@@ -635,28 +575,23 @@ bool QFAST::optimizeAtDepth(std::vector<PauliReps>& io_repsToOpt, double in_targ
     }
 
     ExploreDiffFunctor diffFunctor(this, io_repsToOpt, nbParams);
-    Eigen::NumericalDiff<ExploreDiffFunctor, Eigen::NumericalDiffMode::Central> numDiff(diffFunctor);  
+    const auto costFunc = [&diffFunctor](const Eigen::VectorXd& in_x) {
+        // Just 1 output:
+        Eigen::VectorXd outVal(1);
+        diffFunctor(in_x, outVal);
+        return outVal(0);
+    };
     
     OptFunction f(
         [&](const std::vector<double>& x, std::vector<double>& grad) 
         {
             const Eigen::VectorXd inputParams = Eigen::Map<const Eigen::VectorXd>(x.data(), x.size());
-            // Just 1 output:
-            Eigen::VectorXd outVal(1);
-            numDiff(inputParams, outVal);
-            const double costValue = outVal(0);
+            const double costValue = costFunc(inputParams);
             
             // If grads are needed, compute them.
             if (needGrads)
             {
-                Eigen::MatrixXd gradients(1, x.size());
-                numDiff.df(inputParams, gradients);
-                assert(gradients.rows() == 1 && gradients.cols() == x.size());
-                grad.clear();
-                for (int i = 0; i < x.size(); ++i)
-                {
-                    grad.emplace_back(gradients(0, i));
-                }
+                grad = finiteDifferenceGradient(costFunc, inputParams, costValue, true, blockSizes);
             }
 
             return costValue;
@@ -694,8 +629,7 @@ bool QFAST::optimizeAtDepth(std::vector<PauliReps>& io_repsToOpt, double in_targ
     for (const auto& layer : io_repsToOpt)
     {
         const auto& topology = alternativeLayer ? m_locationModel->buckets.second : m_locationModel->buckets.first;
-        const auto& topologyPauli = alternativeLayer ? m_locationModel->bucketPaulis.second : m_locationModel->bucketPaulis.first;
-        accumU = accumU * layerToUnitaryMatrix(layer, topology, topologyPauli);
+        accumU = accumU * layerToUnitaryMatrix(layer, topology);
         alternativeLayer = !alternativeLayer;
     }
 
@@ -731,8 +665,7 @@ int QFAST::ExploreDiffFunctor::operator()(const InputType& in_x, ValueType& out_
         softmax(layer.locValues.begin(), layer.locValues.end());
         idx++;
         const auto& topology = alternativeLayer ? locationModel->buckets.second : locationModel->buckets.first;
-        const auto& topologyPauli = alternativeLayer ? locationModel->bucketPaulis.second : locationModel->bucketPaulis.first;
-        accumU = accumU * m_parent->layerToUnitaryMatrix(layer, topology, topologyPauli);
+        accumU = accumU * m_parent->layerToUnitaryMatrix(layer, topology);
         alternativeLayer = !alternativeLayer;
     }
 
@@ -746,8 +679,8 @@ double QFAST::computeTraceDistance(const Eigen::MatrixXcd& in_mat1, const Eigen:
     assert(in_mat1.rows() == in_mat2.rows());
     assert(in_mat1.cols() == in_mat2.cols());
     const auto d = in_mat1.cols();
-    const auto product = in_mat1.adjoint() * in_mat2;
-    const double traceNorm =  std::norm(product.trace());
+    // Tr(A^dagger B) = sum(conj(A) .* B): no need for the full product.
+    const double traceNorm =  std::norm(in_mat1.conjugate().cwiseProduct(in_mat2).sum());
     return std::sqrt(1.0 - traceNorm / (d*d));
 }
 
@@ -756,29 +689,20 @@ double QFAST::evaluateCostFunc(const Eigen::MatrixXcd& in_U) const
     return computeTraceDistance(in_U, m_targetU);
 }
 
-Eigen::MatrixXcd QFAST::layerToUnitaryMatrix(const PauliReps& in_layer, const Topology& in_layerTopology, const TopologyPaulis& in_topologyPaulis) const
+Eigen::MatrixXcd QFAST::layerToUnitaryMatrix(const PauliReps& in_layer, const Topology& in_layerTopology) const
 {
-    std::vector<Eigen::MatrixXcd> gateMatOfPair;
+    assert(in_layer.locValues.size() == in_layerTopology.size());
+    // All locations share the same block generator (function values),
+    // weighted by the location values.
+    const BlockMatrix generator = layerGenerator(in_layer);
+    Eigen::MatrixXcd hermMat(Eigen::MatrixXcd::Zero(1ULL << m_nbQubits, 1ULL << m_nbQubits));
     for (size_t i = 0; i < in_layerTopology.size(); ++i)
     {
-        auto& gateMat = gateMatOfPair.emplace_back(Eigen::MatrixXcd::Zero(1ULL << m_nbQubits, 1ULL << m_nbQubits));
-        const auto& paulis = in_topologyPaulis[i];
-        assert(paulis.size() == in_layer.funcValues.size());
-        for (size_t j = 0; j < paulis.size(); ++j)
+        if (in_layer.locValues[i] != 0.0)
         {
-            gateMat += (in_layer.funcValues[j] * paulis[j]);
+            addEmbedded(hermMat, generator, in_layerTopology[i], m_nbQubits, in_layer.locValues[i]);
         }
     }
-        
-
-    Eigen::MatrixXcd hermMat(Eigen::MatrixXcd::Zero(1ULL << m_nbQubits, 1ULL << m_nbQubits));
-
-    assert(in_layer.locValues.size() == in_layerTopology.size());
-
-    for (size_t i = 0; i < in_layerTopology.size(); ++i)
-    {
-        hermMat += in_layer.locValues[i] * gateMatOfPair[i];
-    }
 
     hermMat = I * hermMat;
     // Exponential: exp(i*H)
@@ -786,6 +710,24 @@ Eigen::MatrixXcd QFAST::layerToUnitaryMatrix(const PauliReps& in_layer, const To
     return result;
 }
 
+Eigen::MatrixXcd QFAST::fixedLayersToUnitaryMatrix(const std::vector<PauliReps>& in_layers, const Topology& in_locations) const
+{
+    assert(in_layers.size() == in_locations.size());
+    std::vector<BlockMatrix> generators;
+    generators.reserve(in_layers.size());
+    for (const auto& layer : in_layers)
+    {
+        generators.emplace_back(layerGenerator(layer));
+    }
+    const auto blockMats = expHermitianBatch(generators);
+    Eigen::MatrixXcd accumU(Eigen::MatrixXcd::Identity(1ULL << m_nbQubits, 1ULL << m_nbQubits));
+    for (size_t i = 0; i < blockMats.size(); ++i)
+    {
+        rightMultiplyEmbedded(accumU, blockMats[i], in_locations[i], m_nbQubits);
+    }
+    return accumU;
+}
+
 QFAST::LocationModel::LocationModel(size_t in_nbQubits):
     nbQubits(in_nbQubits),
     locations(qubitPairCombinations(in_nbQubits))
@@ -794,7 +736,6 @@ QFAST::LocationModel::LocationModel(size_t in_nbQubits):
     Topology firstHalf(locations.begin(), locations.begin() + halfSize);
     Topology secondHalf(locations.begin() + halfSize, locations.end());
     buckets = std::make_pair(firstHalf, secondHalf);
-    bucketPaulis = std::make_pair(generateAllPaulis(nbQubits, buckets.first), generateAllPaulis(nbQubits, buckets.second));
 }
 
 std::vector<std::pair<size_t, size_t>> QFAST::LocationModel::fixLocations(std::vector<PauliReps>& io_repsToFix) const
@@ -805,9 +746,8 @@ std::vector<std::pair<size_t, size_t>> QFAST::LocationModel::fixLocations(std::v
     for (auto& layer : io_repsToFix)
     {
         const auto& topology = alternativeLayer ? buckets.second : buckets.first;
-        const auto& topologyPauli = alternativeLayer ? bucketPaulis.second : bucketPaulis.first;
         assert(topology.size() == layer.locValues.size());
-        assert(topologyPauli[0].size() == layer.funcValues.size());
+        assert(NB_BLOCK_PAULIS == layer.funcValues.size());
 
         const auto& locVals = layer.locValues;
         const auto locIdx = std::distance(locVals.begin(), std::max_element(locVals.begin(), locVals.end()));
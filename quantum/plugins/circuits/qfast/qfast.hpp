@@ -40,7 +40,8 @@ private:
     
     // Topology is a list of qubit pairs which we will apply decomposed gates.
     using Topology = std::vector<std::pair<size_t, size_t>>;
-    using TopologyPaulis = std::vector<std::vector<Eigen::MatrixXcd>>;
+    // Number of Pauli strings (i.e. function parameters) of a block
+    static constexpr size_t NB_BLOCK_PAULIS = 1ULL << (2 * NATIVE_BLOCK_SIZE);
     struct Block 
     {
         // Qubit indices
@@ -124,7 +125,6 @@ private:
         size_t nbQubits;
         Topology locations;
         std::pair<Topology, Topology> buckets;
-        std::pair<TopologyPaulis, TopologyPaulis> bucketPaulis;
     };
 
     // Base functor for Auto-diff
@@ -177,10 +177,11 @@ private:
     // i.e. where we have fixed the gate location.
     struct RefineDiffFunctor: public Functor<double>
     {
-        RefineDiffFunctor(const QFAST* const parent, const std::vector<QFAST::PauliReps>& in_fixedLayers, int in_nbInputs, int in_nbValues = 1):
+        RefineDiffFunctor(const QFAST* const parent, const std::vector<QFAST::PauliReps>& in_fixedLayers, const Topology& in_fixedLocations, int in_nbInputs, int in_nbValues = 1):
             Functor(in_nbInputs, in_nbValues),
             m_parent(parent),
-            m_layerConfigs(in_fixedLayers)
+            m_layerConfigs(in_fixedLayers),
+            m_locations(in_fixedLocations)
         {}
 
         // Compute the cost function given the input
@@ -192,6 +193,8 @@ private:
         // The layer configuration to refine:
         // i.e. fixed locations, just need to optimize the Pauli coefficients.
         std::vector<QFAST::PauliReps> m_layerConfigs;
+        // The fixed location of each layer.
+        Topology m_locations;
     };
 
     // Returns decomposed Blocks
@@ -201,15 +204,15 @@ private:
     // Algorithm #4
     std::vector<Block> refine(const std::vector<PauliReps>& in_rawResults);
     // Algorithm #5
-    void addLayer(std::vector<PauliReps>& io_currentLayers, const Topology& in_layerTopology, const TopologyPaulis& in_topologyPaulis) const;
+    void addLayer(std::vector<PauliReps>& io_currentLayers, const Topology& in_layerTopology) const;
     // Gate Instantiation: i.e. KAK
     std::shared_ptr<CompositeInstruction> genericBlockToGates(const Block& in_genericBlock);
     
-    // Generate the list of all Paulis for a particular order (number of qubits)
-    // and topology (i.e. qubit pairs)
-    // This is the set of matrices that we can use to decompose the target unitary
-    // into two-qubit blocks (constrained by the topology)
-    static std::vector<std::vector<Eigen::MatrixXcd>>  generateAllPaulis(size_t in_nbQubits, const Topology& in_topology);
+    // Block generator (4x4): sum of the two-qubit Pauli strings
+    // weighted by the layer function parameters.
+    // Note: the Paulis are the same for all locations of a layer, 
+    // they are embedded into the full space by index mapping.
+    static BlockMatrix layerGenerator(const PauliReps& in_layer);
     
     // Computes the Hilbert-Smith trace distance between two matrix 
     static double computeTraceDistance(const Eigen::MatrixXcd& in_mat1, const Eigen::MatrixXcd& in_mat2);
@@ -222,7 +225,10 @@ private:
     bool optimizeAtDepth(std::vector<PauliReps>& io_repsToOpt, double in_targetDistance) const;
 
     // Compute the Pauli Rep. of a layer to unitary matrix
-    Eigen::MatrixXcd layerToUnitaryMatrix(const PauliReps& in_layer, const Topology& in_layerTopology, const TopologyPaulis& in_topologyPaulis) const;
+    Eigen::MatrixXcd layerToUnitaryMatrix(const PauliReps& in_layer, const Topology& in_layerTopology) const;
+    // Unitary matrix of layers at fixed locations:
+    // each layer is a two-qubit block, i.e. only 4x4 exponentials are needed.
+    Eigen::MatrixXcd fixedLayersToUnitaryMatrix(const std::vector<PauliReps>& in_layers, const Topology& in_locations) const;
 private:
     Eigen::MatrixXcd m_targetU;
     size_t m_nbQubits;
@@ -18,6 +18,9 @@
 #include "xacc_observable.hpp"
 #include "xacc_service.hpp"
 #include <Eigen/Dense>
+#include <unsupported/Eigen/KroneckerProduct>
+#include <unsupported/Eigen/MatrixFunctions>
+#include "StructuredPauli.hpp"
 using namespace xacc;
 
 TEST(QFastTester, checkSimple) 
@@ -116,6 +119,45 @@ TEST(QFastTester, checkSimple)
   }
 }
 
+TEST(QFastTester, checkStructuredPauli) 
+{
+  using namespace xacc::circuits;
+  const std::complex<double> I(0.0, 1.0);
+  Eigen::MatrixXcd X(2, 2), Y(2, 2), Z(2, 2);
+  X << 0, 1, 1, 0;
+  Y << 0, -I, I, 0;
+  Z << 1, 0, 0, -1;
+  const Eigen::MatrixXcd Id = Eigen::MatrixXcd::Identity(2, 2);
+  // Y0 Z2 on 3 qubits (qubit 0 is the leftmost Kronecker factor)
+  const PauliString yz(3, { { PauliOp::Y, 0 }, { PauliOp::Z, 2 } });
+  const Eigen::MatrixXcd dense = Eigen::kroneckerProduct(Eigen::kroneckerProduct(Y, Id).eval(), Z);
+  EXPECT_TRUE(yz.toMatrix().isApprox(dense));
+  const Eigen::MatrixXcd randMat = Eigen::MatrixXcd::Random(8, 8);
+  EXPECT_TRUE(yz.applyLeft(randMat).isApprox(dense * randMat));
+  EXPECT_TRUE(yz.applyRight(randMat).isApprox(randMat * dense));
+
+  // Two-qubit block on qubits (0, 2) of a 3-qubit system
+  EXPECT_EQ(twoQubitPaulis().size(), 16);
+  Eigen::MatrixXcd herm = Eigen::MatrixXcd::Zero(4, 4);
+  Eigen::MatrixXcd denseHerm = Eigen::MatrixXcd::Zero(8, 8);
+  const std::vector<Eigen::MatrixXcd> paulis1 { Id, X, Y, Z };
+  for (size_t j = 0; j < 16; ++j)
+  {
+    const double coeff = 0.1 * j - 0.3;
+    twoQubitPaulis()[j].addTo(herm, coeff);
+    denseHerm += coeff * Eigen::kroneckerProduct(Eigen::kroneckerProduct(paulis1[j / 4], Id).eval(), paulis1[j % 4]);
+  }
+  Eigen::MatrixXcd embedded = Eigen::MatrixXcd::Zero(8, 8);
+  addEmbedded(embedded, herm, { 0, 2 }, 3);
+  EXPECT_TRUE(embedded.isApprox(denseHerm));
+
+  const auto blocks = expHermitianBatch({ herm });
+  const Eigen::MatrixXcd expected = (I * denseHerm).exp();
+  Eigen::MatrixXcd accum = randMat;
+  rightMultiplyEmbedded(accum, blocks[0], { 0, 2 }, 3);
+  EXPECT_TRUE(accum.isApprox(randMat * expected));
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
@@ -15,6 +15,8 @@
 #include "ROErrorDecorator.hpp"
 #include "RichExtrapDecorator.hpp"
 #include "AssignmentErrorKernelDecorator.hpp"
+#include "ReadoutMitigationDecorator.hpp"
+#include "ResultCacheDecorator.hpp"
 
 #include "cppmicroservices/BundleActivator.h"
 #include "cppmicroservices/BundleContext.h"
@@ -42,6 +44,8 @@ public:
 		auto c3 = std::make_shared<xacc::quantum::ROErrorDecorator>();
 		auto c4 = std::make_shared<xacc::quantum::RDMPurificationDecorator>();
         auto c5 = std::make_shared<xacc::quantum::AssignmentErrorKernelDecorator>();
+        auto c6 = std::make_shared<xacc::quantum::ReadoutMitigationDecorator>();
+        auto c7 = std::make_shared<xacc::quantum::ResultCacheDecorator>();
 
 		context.RegisterService<xacc::AcceleratorDecorator>(c2);
         context.RegisterService<xacc::Accelerator>(c2);
@@ -58,6 +62,12 @@ public:
         context.RegisterService<xacc::AcceleratorDecorator>(c5);
         context.RegisterService<xacc::Accelerator>(c5);
 
+        context.RegisterService<xacc::AcceleratorDecorator>(c6);
+        context.RegisterService<xacc::Accelerator>(c6);
+
+        context.RegisterService<xacc::AcceleratorDecorator>(c7);
+        context.RegisterService<xacc::Accelerator>(c7);
+
 	}
 
 	/**
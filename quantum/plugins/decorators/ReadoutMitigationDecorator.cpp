@@ -0,0 +1,619 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "ReadoutMitigationDecorator.hpp"
+#include "AcceleratorBuffer.hpp"
+#include "InstructionIterator.hpp"
+#include "Utils.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+// Bitstrings are packed into 64-bit words indexed by *qubit* (not by
+// character position), so that both bit orders share the same kernels.
+void packBitString(const std::string &bitStr, bool msb, int nQubits,
+                   uint64_t *words) {
+  const int nWords = (nQubits + 63) / 64;
+  std::fill(words, words + nWords, 0);
+  for (int q = 0; q < nQubits; ++q) {
+    const char c = msb ? bitStr[bitStr.size() - 1 - q] : bitStr[q];
+    if (c == '1') {
+      words[q / 64] |= (uint64_t(1) << (q % 64));
+    }
+  }
+}
+
+inline int getBit(const uint64_t *words, int q) {
+  return (words[q / 64] >> (q % 64)) & 1;
+}
+
+inline int hammingDistance(const uint64_t *a, const uint64_t *b, int nWords) {
+  int dist = 0;
+  for (int w = 0; w < nWords; ++w) {
+    dist += __builtin_popcountll(a[w] ^ b[w]);
+  }
+  return dist;
+}
+
+// Sparse element of the reduced assignment matrix
+struct Element {
+  std::size_t row;
+  std::size_t col;
+  double value;
+};
+
+// Jacobi-preconditioned BiCGSTAB on the reduced (observed-subspace)
+// assignment matrix. Returns the number of iterations and sets the final
+// relative residual.
+int solveBiCGSTAB(const std::vector<Element> &A, const Eigen::VectorXd &b,
+                  Eigen::VectorXd &x, double tolerance, int maxIterations,
+                  double &error) {
+  const auto n = b.size();
+  Eigen::VectorXd invDiag = Eigen::VectorXd::Ones(n);
+  for (const auto &e : A) {
+    if (e.row == e.col && e.value != 0.0) {
+      invDiag(e.row) = 1.0 / e.value;
+    }
+  }
+  const auto matvec = [&A, n](const Eigen::VectorXd &in) {
+    Eigen::VectorXd out = Eigen::VectorXd::Zero(n);
+    for (const auto &e : A) {
+      out(e.row) += e.value * in(e.col);
+    }
+    return out;
+  };
+
+  const double bNorm = b.norm() > 0.0 ? b.norm() : 1.0;
+  Eigen::VectorXd r = b - matvec(x);
+  const Eigen::VectorXd rHat = r;
+  Eigen::VectorXd p = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd v = Eigen::VectorXd::Zero(n);
+  double rho = 1.0, alpha = 1.0, omega = 1.0;
+  error = r.norm() / bNorm;
+  int iter = 0;
+  while (error > tolerance && iter < maxIterations) {
+    ++iter;
+    const double rhoNew = rHat.dot(r);
+    if (rhoNew == 0.0) {
+      break;
+    }
+    const double beta = (rhoNew / rho) * (alpha / omega);
+    rho = rhoNew;
+    p = r + beta * (p - omega * v);
+    const Eigen::VectorXd y = invDiag.cwiseProduct(p);
+    v = matvec(y);
+    alpha = rho / rHat.dot(v);
+    const Eigen::VectorXd s = r - alpha * v;
+    if (s.norm() / bNorm <= tolerance) {
+      x += alpha * y;
+      error = s.norm() / bNorm;
+      break;
+    }
+    const Eigen::VectorXd z = invDiag.cwiseProduct(s);
+    const Eigen::VectorXd t = matvec(z);
+    const double tt = t.dot(t);
+    omega = tt > 0.0 ? t.dot(s) / tt : 0.0;
+    x += alpha * y + omega * z;
+    r = s - omega * t;
+    error = r.norm() / bNorm;
+    if (omega == 0.0) {
+      break;
+    }
+  }
+  return iter;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+std::map<std::string, ReadoutMitigationDecorator::Calibration>
+    ReadoutMitigationDecorator::calibrationCache;
+std::mutex ReadoutMitigationDecorator::calibrationCacheMutex;
+
+void ReadoutMitigationDecorator::initialize(const HeterogeneousMap &params) {
+  // The decorator service is shared, reset to defaults.
+  mode = "tensored";
+  pairs.clear();
+  layout.clear();
+  maxDistance = 3;
+  maxIterations = 100;
+  tolerance = 1e-8;
+  recalibrate = false;
+  if (params.stringExists("mode")) {
+    mode = params.getString("mode");
+    if (mode != "tensored" && mode != "correlated") {
+      xacc::error("Invalid readout-mitigation mode '" + mode +
+                  "'. Valid modes are 'tensored' and 'correlated'.");
+    }
+  }
+  if (params.keyExists<std::vector<std::pair<int, int>>>("pairs")) {
+    pairs = params.get<std::vector<std::pair<int, int>>>("pairs");
+  }
+  if (params.keyExists<std::vector<std::size_t>>("layout")) {
+    layout = params.get<std::vector<std::size_t>>("layout");
+  }
+  if (params.keyExists<std::vector<int>>("layout")) {
+    layout.clear();
+    for (auto &a : params.get<std::vector<int>>("layout")) {
+      layout.push_back(a);
+    }
+  }
+  if (params.keyExists<int>("max-distance")) {
+    maxDistance = params.get<int>("max-distance");
+  }
+  if (params.keyExists<int>("max-iterations")) {
+    maxIterations = params.get<int>("max-iterations");
+  }
+  if (params.keyExists<double>("tolerance")) {
+    tolerance = params.get<double>("tolerance");
+  }
+  if (params.keyExists<bool>("recalibrate")) {
+    recalibrate = params.get<bool>("recalibrate");
+  }
+}
+
+void ReadoutMitigationDecorator::clearCalibrationCache() {
+  std::lock_guard<std::mutex> lock(calibrationCacheMutex);
+  calibrationCache.clear();
+}
+
+std::vector<std::vector<int>>
+ReadoutMitigationDecorator::getBlocks(int nQubits) const {
+  std::vector<std::vector<int>> blocks;
+  std::vector<bool> assigned(nQubits, false);
+  if (mode == "correlated") {
+    if (!pairs.empty()) {
+      for (const auto &[q1, q2] : pairs) {
+        if (q1 >= nQubits || q2 >= nQubits || q1 == q2 || assigned[q1] ||
+            assigned[q2]) {
+          xacc::error("Invalid readout-mitigation pair (" +
+                      std::to_string(q1) + ", " + std::to_string(q2) + ").");
+        }
+        blocks.push_back({q1, q2});
+        assigned[q1] = assigned[q2] = true;
+      }
+    } else {
+      // Default: neighboring qubits
+      for (int q = 0; q + 1 < nQubits; q += 2) {
+        blocks.push_back({q, q + 1});
+        assigned[q] = assigned[q + 1] = true;
+      }
+    }
+  }
+  // Anything else is calibrated independently.
+  for (int q = 0; q < nQubits; ++q) {
+    if (!assigned[q]) {
+      blocks.push_back({q});
+    }
+  }
+  return blocks;
+}
+
+std::string ReadoutMitigationDecorator::calibrationKey(int nQubits) const {
+  std::stringstream ss;
+  ss << decoratedAccelerator->getSignature() << "|" << mode << "|" << nQubits
+     << "|";
+  for (const auto &block : getBlocks(nQubits)) {
+    ss << "(";
+    for (const auto &q : block) {
+      ss << q << ",";
+    }
+    ss << ")";
+  }
+  ss << "|";
+  for (const auto &q : layout) {
+    ss << q << ",";
+  }
+  return ss.str();
+}
+
+ReadoutMitigationDecorator::Calibration
+ReadoutMitigationDecorator::calibrate(int nQubits) {
+  const auto key = calibrationKey(nQubits);
+  {
+    std::lock_guard<std::mutex> lock(calibrationCacheMutex);
+    if (!recalibrate && calibrationCache.find(key) != calibrationCache.end()) {
+      return calibrationCache[key];
+    }
+  }
+
+  Calibration calibration;
+  calibration.blocks = getBlocks(nQubits);
+  std::size_t maxDim = 2;
+  for (const auto &block : calibration.blocks) {
+    const std::size_t dim = 1ULL << block.size();
+    maxDim = std::max(maxDim, dim);
+    calibration.matrices.emplace_back(dim * dim, 0.0);
+  }
+
+  // Calibration circuit k prepares the j-th qubit of every block in
+  // |(k >> j) & 1>, hence all block basis states are covered by
+  // maxDim circuits (2 for tensored, 4 for correlated pairs).
+  auto provider = xacc::getIRProvider("quantum");
+  std::vector<std::shared_ptr<CompositeInstruction>> circuits;
+  for (std::size_t k = 0; k < maxDim; ++k) {
+    auto circuit =
+        provider->createComposite("readout_cal_" + std::to_string(k));
+    for (const auto &block : calibration.blocks) {
+      for (std::size_t j = 0; j < block.size(); ++j) {
+        if ((k >> j) & 1) {
+          circuit->addInstruction(
+              provider->createInstruction("X", (std::size_t)block[j]));
+        }
+      }
+    }
+    for (int q = 0; q < nQubits; ++q) {
+      circuit->addInstruction(
+          provider->createInstruction("Measure", (std::size_t)q));
+    }
+    if (!layout.empty()) {
+      circuit->mapBits(layout);
+    }
+    circuits.emplace_back(circuit);
+  }
+
+  auto tmpBuffer = xacc::qalloc(nQubits);
+  decoratedAccelerator->execute(tmpBuffer, circuits);
+  const bool msb =
+      decoratedAccelerator->getBitOrder() == xacc::Accelerator::BitOrder::MSB;
+  const int nWords = (nQubits + 63) / 64;
+  std::vector<uint64_t> packed(nWords);
+  auto children = tmpBuffer->getChildren();
+  for (std::size_t k = 0; k < children.size(); ++k) {
+    for (const auto &[bitStr, count] : children[k]->getMeasurementCounts()) {
+      packBitString(bitStr, msb, nQubits, packed.data());
+      for (std::size_t b = 0; b < calibration.blocks.size(); ++b) {
+        const auto &block = calibration.blocks[b];
+        const std::size_t dim = 1ULL << block.size();
+        const std::size_t prepared = k & (dim - 1);
+        std::size_t measured = 0;
+        for (std::size_t j = 0; j < block.size(); ++j) {
+          measured |= getBit(packed.data(), block[j]) << j;
+        }
+        calibration.matrices[b][measured * dim + prepared] += count;
+      }
+    }
+  }
+
+  // Normalize columns: A[meas][prep] = P(meas | prep)
+  for (std::size_t b = 0; b < calibration.blocks.size(); ++b) {
+    const std::size_t dim = 1ULL << calibration.blocks[b].size();
+    auto &mat = calibration.matrices[b];
+    for (std::size_t prep = 0; prep < dim; ++prep) {
+      double colSum = 0.0;
+      for (std::size_t meas = 0; meas < dim; ++meas) {
+        colSum += mat[meas * dim + prep];
+      }
+      if (colSum <= 0.0) {
+        xacc::error("Readout calibration failed: no counts were returned for "
+                    "a calibration circuit.");
+      }
+      for (std::size_t meas = 0; meas < dim; ++meas) {
+        mat[meas * dim + prep] /= colSum;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(calibrationCacheMutex);
+  calibrationCache[key] = calibration;
+  recalibrate = false;
+  return calibration;
+}
+
+std::shared_ptr<CompositeInstruction> ReadoutMitigationDecorator::measureAll(
+    std::shared_ptr<CompositeInstruction> function, int nQubits,
+    std::vector<int> &measuredBits) {
+  // Measure all qubits (on a copy) so that every correction block is
+  // observed; results are marginalized back to the requested bits later.
+  auto provider = xacc::getIRProvider("quantum");
+  auto measured = provider->createComposite(function->name());
+  InstructionIterator it(function);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (!nextInst->isComposite() && nextInst->isEnabled()) {
+      if (nextInst->name() == "Measure") {
+        measuredBits.emplace_back(nextInst->bits()[0]);
+      } else {
+        measured->addInstruction(nextInst->clone());
+      }
+    }
+  }
+  for (int q = 0; q < nQubits; ++q) {
+    measured->addInstruction(
+        provider->createInstruction("Measure", (std::size_t)q));
+  }
+  if (!layout.empty()) {
+    measured->mapBits(layout);
+  }
+  return measured;
+}
+
+void ReadoutMitigationDecorator::mitigate(
+    std::shared_ptr<AcceleratorBuffer> buffer, const Calibration &calibration,
+    const std::vector<int> &measuredBits) {
+  const auto originalCounts = buffer->getMeasurementCounts();
+  if (originalCounts.empty()) {
+    xacc::warning("No measurement counts to mitigate in buffer '" +
+                  buffer->name() + "'.");
+    return;
+  }
+
+  const std::size_t nQubits = buffer->size();
+  const std::size_t nWords = (nQubits + 63) / 64;
+  const bool msb =
+      decoratedAccelerator->getBitOrder() == xacc::Accelerator::BitOrder::MSB;
+  const std::size_t nStates = originalCounts.size();
+
+  std::vector<int> qubitToBlock(nQubits, -1);
+  for (std::size_t b = 0; b < calibration.blocks.size(); ++b) {
+    for (const auto &q : calibration.blocks[b]) {
+      qubitToBlock[q] = b;
+    }
+  }
+
+  std::vector<std::string> bitStrings;
+  std::vector<uint64_t> packed(nStates * nWords);
+  Eigen::VectorXd probs(nStates);
+  int shots = 0;
+  bitStrings.reserve(nStates);
+  for (const auto &[bitStr, count] : originalCounts) {
+    const auto idx = bitStrings.size();
+    packBitString(bitStr, msb, nQubits, &packed[idx * nWords]);
+    probs(idx) = count;
+    bitStrings.emplace_back(bitStr);
+    shots += count;
+  }
+  probs /= shots;
+
+  // Index of the block-local basis state of a packed bitstring
+  const auto blockState = [&](std::size_t b, const uint64_t *s) {
+    const auto &block = calibration.blocks[b];
+    std::size_t state = 0;
+    for (std::size_t j = 0; j < block.size(); ++j) {
+      state |= getBit(s, block[j]) << j;
+    }
+    return state;
+  };
+  const auto blockElement = [&](std::size_t b, const uint64_t *meas,
+                                const uint64_t *prep) {
+    const std::size_t dim = 1ULL << calibration.blocks[b].size();
+    return calibration.matrices[b][blockState(b, meas) * dim +
+                                   blockState(b, prep)];
+  };
+
+  // Diagonal elements, i.e. the probability of a faithful readout of each
+  // observed bitstring.
+  std::vector<double> diag(nStates, 1.0);
+  for (std::size_t j = 0; j < nStates; ++j) {
+    const uint64_t *sj = &packed[j * nWords];
+    for (std::size_t b = 0; b < calibration.blocks.size(); ++b) {
+      diag[j] *= blockElement(b, sj, sj);
+    }
+  }
+
+  // Assemble the reduced assignment matrix. Only the blocks touched by the
+  // bit flips between two strings differ from the diagonal factor, so each
+  // element costs O(Hamming distance).
+  std::vector<Element> elements;
+  std::vector<double> colSums(nStates, 0.0);
+  std::vector<int> touched;
+  const auto addElement = [&](std::size_t i, std::size_t j) {
+    const uint64_t *si = &packed[i * nWords];
+    const uint64_t *sj = &packed[j * nWords];
+    double value = diag[j];
+    if (i != j) {
+      touched.clear();
+      for (std::size_t w = 0; w < nWords; ++w) {
+        uint64_t diff = si[w] ^ sj[w];
+        while (diff) {
+          const std::size_t q = w * 64 + __builtin_ctzll(diff);
+          diff &= diff - 1;
+          const int b = qubitToBlock[q];
+          if (std::find(touched.begin(), touched.end(), b) == touched.end()) {
+            touched.emplace_back(b);
+          }
+        }
+      }
+      for (const auto &b : touched) {
+        const double faithful = blockElement(b, sj, sj);
+        if (faithful > 0.0) {
+          value *= blockElement(b, si, sj) / faithful;
+        } else {
+          // Degenerate calibration, compute the full product instead.
+          value = 1.0;
+          for (std::size_t bb = 0; bb < calibration.blocks.size(); ++bb) {
+            value *= blockElement(bb, si, sj);
+          }
+          break;
+        }
+      }
+    }
+    if (value != 0.0) {
+      elements.push_back({i, j, value});
+      colSums[j] += value;
+    }
+  };
+
+  // Number of bitstrings within the cutoff distance of a given one, capped
+  // at nStates (past which a scan of the observed states is cheaper).
+  std::size_t nNeighbours = nStates;
+  if (maxDistance >= 0) {
+    std::size_t binomial = 1;
+    nNeighbours = 0;
+    for (int k = 1; k <= maxDistance && k <= (int)nQubits; ++k) {
+      binomial = binomial * (nQubits - k + 1) / k;
+      nNeighbours += binomial;
+      if (nNeighbours >= nStates) {
+        nNeighbours = nStates;
+        break;
+      }
+    }
+  }
+
+  if (nNeighbours < nStates) {
+    // Enumerate the neighbours of each observed state directly, by flipping
+    // up to maxDistance of its bits: O(nStates * nNeighbours) lookups.
+    const auto packedKey = [&](const uint64_t *s) {
+      return std::string(reinterpret_cast<const char *>(s),
+                         nWords * sizeof(uint64_t));
+    };
+    std::unordered_map<std::string, std::size_t> stateIndex;
+    stateIndex.reserve(nStates);
+    for (std::size_t i = 0; i < nStates; ++i) {
+      stateIndex.emplace(packedKey(&packed[i * nWords]), i);
+    }
+    std::vector<uint64_t> flipped(nWords);
+    std::function<void(std::size_t, std::size_t, int)> flipBits =
+        [&](std::size_t j, std::size_t firstQubit, int remaining) {
+          for (std::size_t q = firstQubit; q < nQubits; ++q) {
+            flipped[q / 64] ^= (uint64_t(1) << (q % 64));
+            const auto it = stateIndex.find(packedKey(flipped.data()));
+            if (it != stateIndex.end()) {
+              addElement(it->second, j);
+            }
+            if (remaining > 1) {
+              flipBits(j, q + 1, remaining - 1);
+            }
+            flipped[q / 64] ^= (uint64_t(1) << (q % 64));
+          }
+        };
+    for (std::size_t j = 0; j < nStates; ++j) {
+      addElement(j, j);
+      std::copy(&packed[j * nWords], &packed[j * nWords] + nWords,
+                flipped.begin());
+      if (maxDistance > 0) {
+        flipBits(j, 0, maxDistance);
+      }
+    }
+  } else {
+    for (std::size_t j = 0; j < nStates; ++j) {
+      const uint64_t *sj = &packed[j * nWords];
+      for (std::size_t i = 0; i < nStates; ++i) {
+        if (maxDistance < 0 ||
+            hammingDistance(&packed[i * nWords], sj, nWords) <= maxDistance) {
+          addElement(i, j);
+        }
+      }
+    }
+  }
+  // Renormalize the columns so that the reduced matrix stays stochastic.
+  for (auto &e : elements) {
+    e.value /= colSums[e.col];
+  }
+
+  Eigen::VectorXd quasiProbs = probs;
+  double error = 0.0;
+  const int iterations = solveBiCGSTAB(elements, probs, quasiProbs, tolerance,
+                                       maxIterations, error);
+  if (error > tolerance) {
+    xacc::warning("Readout mitigation solver did not converge (error = " +
+                  std::to_string(error) + ").");
+  }
+
+  // Clip and renormalize the quasi-probability distribution.
+  for (int i = 0; i < quasiProbs.size(); ++i) {
+    if (quasiProbs(i) < 0.0) {
+      quasiProbs(i) = 0.0;
+    }
+  }
+  const double sumProbs = quasiProbs.sum();
+  if (sumProbs > 0.0) {
+    quasiProbs /= sumProbs;
+  }
+
+  std::map<std::string, double> origCounts;
+  for (const auto &[bitStr, count] : originalCounts) {
+    origCounts[bitStr] = count;
+  }
+  buffer->clearMeasurements();
+  for (std::size_t i = 0; i < nStates; ++i) {
+    const int count = std::floor(shots * quasiProbs(i) + 0.5);
+    if (count > 0) {
+      buffer->appendMeasurement(bitStrings[i], count);
+    }
+  }
+
+  if (!measuredBits.empty() && measuredBits.size() < nQubits) {
+    const auto bitOrder = msb ? xacc::AcceleratorBuffer::BitOrder::MSB
+                              : xacc::AcceleratorBuffer::BitOrder::LSB;
+    const auto marginalCounts =
+        buffer->getMarginalCounts(measuredBits, bitOrder);
+    buffer->clearMeasurements();
+    buffer->setMeasurements(marginalCounts);
+  }
+
+  if (buffer->hasExtraInfoKey("exp-val-z")) {
+    // Any backend-provided expectation value is unmitigated, recompute it.
+    double expVal = 0.0;
+    int total = 0;
+    for (const auto &[bitStr, count] : buffer->getMeasurementCounts()) {
+      const bool odd = std::count(bitStr.begin(), bitStr.end(), '1') % 2;
+      expVal += odd ? -count : count;
+      total += count;
+    }
+    if (total > 0) {
+      buffer->addExtraInfo("exp-val-z", expVal / total);
+    }
+  }
+  buffer->addExtraInfo("unmitigated-counts", origCounts);
+  buffer->addExtraInfo("readout-mitigation-iterations", iterations);
+  buffer->addExtraInfo("readout-mitigation-error", error);
+}
+
+void ReadoutMitigationDecorator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> function) {
+  if (!decoratedAccelerator) {
+    xacc::error("readout-mitigation: no decorated accelerator.");
+  }
+  const int nQubits = buffer->size();
+  const auto calibration = calibrate(nQubits);
+  std::vector<int> measuredBits;
+  auto measured = measureAll(function, nQubits, measuredBits);
+  decoratedAccelerator->execute(buffer, measured);
+  mitigate(buffer, calibration, measuredBits);
+}
+
+void ReadoutMitigationDecorator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>> functions) {
+  if (!decoratedAccelerator) {
+    xacc::error("readout-mitigation: no decorated accelerator.");
+  }
+  const int nQubits = buffer->size();
+  const auto calibration = calibrate(nQubits);
+  std::vector<std::shared_ptr<CompositeInstruction>> measuredFunctions;
+  std::map<std::string, std::vector<int>> measuredBits;
+  for (auto &f : functions) {
+    std::vector<int> bits;
+    measuredFunctions.emplace_back(measureAll(f, nQubits, bits));
+    measuredBits[f->name()] = bits;
+  }
+
+  // All circuits are submitted as a single batch.
+  decoratedAccelerator->execute(buffer, measuredFunctions);
+  for (auto &child : buffer->getChildren()) {
+    if (measuredBits.find(child->name()) != measuredBits.end()) {
+      mitigate(child, calibration, measuredBits[child->name()]);
+    }
+  }
+}
+
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_READOUTMITIGATIONDECORATOR_HPP_
+#define XACC_READOUTMITIGATIONDECORATOR_HPP_
+
+#include "AcceleratorDecorator.hpp"
+#include <map>
+#include <mutex>
+
+namespace xacc {
+
+namespace quantum {
+
+// Scalable readout-error mitigation.
+// The assignment (confusion) matrix is modeled as a tensor product of
+// small blocks: one 2x2 block per qubit ("tensored" mode) or one 4x4 block
+// per qubit pair ("correlated" mode). Calibration therefore only needs
+// 2 (resp. 4) circuits regardless of the number of qubits.
+// Correction is performed in the subspace spanned by the observed
+// bitstrings only: the reduced assignment matrix is assembled on the fly
+// from the calibration blocks (never as a 2^n x 2^n matrix), restricted to
+// a Hamming-distance neighborhood, column-renormalized, and inverted with a
+// preconditioned iterative solver.
+// Calibration data is cached per backend signature and reused across
+// executions (and decorator instances) until 'recalibrate' is requested.
+class ReadoutMitigationDecorator : public AcceleratorDecorator {
+public:
+  // Calibration data: one column-stochastic matrix (measured x prepared)
+  // per block of qubits (1 qubit in tensored mode, up to 2 in correlated).
+  struct Calibration {
+    std::vector<std::vector<int>> blocks;
+    std::vector<std::vector<double>> matrices;
+  };
+
+protected:
+  std::string mode = "tensored";
+  std::vector<std::pair<int, int>> pairs;
+  std::vector<std::size_t> layout;
+  int maxDistance = 3;
+  int maxIterations = 100;
+  double tolerance = 1e-8;
+  bool recalibrate = false;
+
+  static std::map<std::string, Calibration> calibrationCache;
+  static std::mutex calibrationCacheMutex;
+
+  std::vector<std::vector<int>> getBlocks(int nQubits) const;
+  std::string calibrationKey(int nQubits) const;
+  Calibration calibrate(int nQubits);
+  // Map measured bitstrings to mitigated counts using the calibration data.
+  void mitigate(std::shared_ptr<AcceleratorBuffer> buffer,
+                const Calibration &calibration,
+                const std::vector<int> &measuredBits);
+  std::shared_ptr<CompositeInstruction>
+  measureAll(std::shared_ptr<CompositeInstruction> function, int nQubits,
+             std::vector<int> &measuredBits);
+
+public:
+  ReadoutMitigationDecorator() = default;
+
+  void initialize(const HeterogeneousMap &params = {}) override;
+  void updateConfiguration(const HeterogeneousMap &config) override {
+    decoratedAccelerator->updateConfiguration(config);
+  }
+  const std::vector<std::string> configurationKeys() override {
+    return {"mode",           "pairs",     "layout",     "max-distance",
+            "max-iterations", "tolerance", "recalibrate"};
+  }
+
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::shared_ptr<CompositeInstruction> function) override;
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   functions) override;
+
+  const std::string name() const override { return "readout-mitigation"; }
+  const std::string description() const override {
+    return "Tensored/correlated readout-error mitigation in the subspace of "
+           "observed bitstrings.";
+  }
+
+  // Clear all cached calibrations (e.g., after a backend recalibration).
+  static void clearCalibrationCache();
+
+  ~ReadoutMitigationDecorator() override {}
+};
+
+} // namespace quantum
+} // namespace xacc
+#endif
@@ -0,0 +1,452 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "ResultCacheDecorator.hpp"
+#include "AcceleratorBuffer.hpp"
+#include "xacc.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace {
+// Exact (hexadecimal) representation of a double, so that parameter values
+// which differ in the last bits don't share a cache entry.
+std::string exactString(double val) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%a", val);
+  return buf;
+}
+
+// Appends the canonical form of the enabled gates to 'out'.
+// Returns false if an unbound (symbolic) parameter is found.
+bool canonicalize(std::shared_ptr<xacc::Instruction> inst,
+                  std::string &out) {
+  if (!inst->isEnabled()) {
+    return true;
+  }
+  if (inst->isComposite()) {
+    auto composite =
+        std::dynamic_pointer_cast<xacc::CompositeInstruction>(inst);
+    for (auto &child : composite->getInstructions()) {
+      if (!canonicalize(child, out)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  out += inst->name();
+  if (inst->isParameterized()) {
+    out += "(";
+    for (const auto &p : inst->getParameters()) {
+      if (p.which() == 0) {
+        out += std::to_string(p.as<int>());
+      } else if (p.which() == 1) {
+        out += exactString(p.as<double>());
+      } else {
+        const auto str = p.as<std::string>();
+        char *end = nullptr;
+        const double val = std::strtod(str.c_str(), &end);
+        if (str.empty() || *end != '\0') {
+          return false;
+        }
+        out += exactString(val);
+      }
+      out += ",";
+    }
+    out += ")";
+  }
+  for (const auto &bit : inst->bits()) {
+    out += " " + std::to_string(bit);
+  }
+  out += ";";
+  return true;
+}
+
+// Serializes the backend properties into the cache key. Long values (e.g. the
+// JSON of a noise model or backend) are hashed, and keys must not contain
+// new lines (see the file format).
+class PropertiesKeyVisitor
+    : public xacc::visitor_base<int, bool, double, std::size_t, std::string,
+                                std::vector<int>, std::vector<double>,
+                                std::vector<std::string>> {
+public:
+  std::string key;
+
+  void operator()(const std::string &name, const int &val) {
+    add(name, std::to_string(val));
+  }
+  void operator()(const std::string &name, const bool &val) {
+    add(name, val ? "true" : "false");
+  }
+  void operator()(const std::string &name, const double &val) {
+    add(name, exactString(val));
+  }
+  void operator()(const std::string &name, const std::size_t &val) {
+    add(name, std::to_string(val));
+  }
+  void operator()(const std::string &name, const std::string &val) {
+    add(name, val);
+  }
+  template <typename T>
+  void operator()(const std::string &name, const std::vector<T> &vals) {
+    std::string str;
+    for (const auto &val : vals) {
+      str += toString(val) + ",";
+    }
+    add(name, str);
+  }
+
+private:
+  static std::string toString(int val) { return std::to_string(val); }
+  static std::string toString(double val) { return exactString(val); }
+  static std::string toString(const std::string &val) { return val; }
+
+  void add(const std::string &name, const std::string &val) {
+    key += name + "=";
+    if (val.size() > 64 || val.find('\n') != std::string::npos ||
+        val.find(';') != std::string::npos) {
+      key += "#" + std::to_string(std::hash<std::string>{}(val));
+    } else {
+      key += val;
+    }
+    key += ";";
+  }
+};
+
+xacc::quantum::ResultCacheDecorator::CachedResult
+toCachedResult(std::shared_ptr<xacc::AcceleratorBuffer> buffer) {
+  xacc::quantum::ResultCacheDecorator::CachedResult result;
+  result.counts = buffer->getMeasurementCounts();
+  if (buffer->hasExtraInfoKey("exp-val-z")) {
+    result.hasExpVal = true;
+    result.expVal = mpark::get<double>(buffer->getInformation("exp-val-z"));
+  }
+  return result;
+}
+
+void fromCachedResult(
+    const xacc::quantum::ResultCacheDecorator::CachedResult &result,
+    std::shared_ptr<xacc::AcceleratorBuffer> buffer) {
+  buffer->setMeasurements(result.counts);
+  if (result.hasExpVal) {
+    buffer->addExtraInfo("exp-val-z", result.expVal);
+  }
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+void ResultCacheDecorator::initialize(const HeterogeneousMap &params) {
+  // The decorator service is shared: reset the configuration, but keep the
+  // cached results (entries are keyed by the backend configuration anyway).
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  maxEntries = 1024;
+  cacheFile.clear();
+  unsaved.clear();
+  nFileEntries = 0;
+  rewrite = false;
+  if (params.keyExists<int>("max-entries")) {
+    const auto val = params.get<int>("max-entries");
+    if (val < 1) {
+      xacc::error("result-cache: 'max-entries' must be positive.");
+    }
+    maxEntries = val;
+  }
+  if (params.keyExists<bool>("clear-cache") &&
+      params.get<bool>("clear-cache")) {
+    lru.clear();
+    index.clear();
+    nHits = 0;
+    nMisses = 0;
+  }
+  while (lru.size() > maxEntries) {
+    index.erase(lru.back().first);
+    lru.pop_back();
+  }
+  if (params.stringExists("cache-file")) {
+    cacheFile = params.getString("cache-file");
+    load();
+  }
+}
+
+void ResultCacheDecorator::updateConfiguration(
+    const HeterogeneousMap &config) {
+  decoratedAccelerator->updateConfiguration(config);
+}
+
+std::size_t ResultCacheDecorator::size() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  return lru.size();
+}
+
+void ResultCacheDecorator::clearCache() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  lru.clear();
+  index.clear();
+  nHits = 0;
+  nMisses = 0;
+  unsaved.clear();
+  rewrite = !cacheFile.empty();
+}
+
+std::string
+ResultCacheDecorator::cacheKey(std::shared_ptr<CompositeInstruction> function,
+                               int nQubits) {
+  PropertiesKeyVisitor visitor;
+  decoratedAccelerator->getProperties().visit(visitor);
+  std::string key = decoratedAccelerator->getSignature() + "|" + visitor.key +
+                    "|" + std::to_string(nQubits) + "|";
+  if (!canonicalize(function, key)) {
+    return "";
+  }
+  return key;
+}
+
+bool ResultCacheDecorator::lookup(const std::string &key,
+                                  CachedResult &result) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto iter = index.find(key);
+  if (iter == index.end()) {
+    ++nMisses;
+    return false;
+  }
+  ++nHits;
+  // Move to front (most recently used)
+  lru.splice(lru.begin(), lru, iter->second);
+  result = iter->second->second;
+  return true;
+}
+
+void ResultCacheDecorator::store(const std::string &key,
+                                 const CachedResult &result) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto iter = index.find(key);
+  if (iter != index.end()) {
+    iter->second->second = result;
+    lru.splice(lru.begin(), lru, iter->second);
+  } else {
+    lru.emplace_front(key, result);
+    index[key] = lru.begin();
+    if (lru.size() > maxEntries) {
+      index.erase(lru.back().first);
+      lru.pop_back();
+    }
+  }
+  if (!cacheFile.empty()) {
+    unsaved.emplace_back(key);
+  }
+}
+
+void ResultCacheDecorator::reportStatistics(
+    std::shared_ptr<AcceleratorBuffer> buffer) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  const auto total = nHits + nMisses;
+  buffer->addExtraInfo("result-cache-hits", static_cast<int>(nHits));
+  buffer->addExtraInfo("result-cache-misses", static_cast<int>(nMisses));
+  buffer->addExtraInfo("result-cache-hit-rate",
+                       total > 0 ? static_cast<double>(nHits) / total : 0.0);
+}
+
+// File format, one entry per two lines:
+//   <key>
+//   <has exp-val-z> <exp-val-z> <number of bitstrings> (<bitstring> <count>)*
+// Keys don't contain new lines (see canonicalize() and PropertiesKeyVisitor).
+// Entries are appended as they are stored, hence the most recently used entry
+// of a key is the last one in the file.
+void ResultCacheDecorator::load() {
+  // Entries cached before loading are not in the file yet.
+  rewrite = rewrite || !lru.empty();
+  std::ifstream stream(cacheFile);
+  if (!stream) {
+    // Not an error: the file is created at the first save.
+    return;
+  }
+  std::string key, line;
+  std::vector<std::pair<std::string, CachedResult>> entries;
+  while (std::getline(stream, key) && std::getline(stream, line)) {
+    std::istringstream ss(line);
+    CachedResult result;
+    std::string expValStr;
+    std::size_t nCounts = 0;
+    if (!(ss >> result.hasExpVal >> expValStr >> nCounts)) {
+      xacc::warning("result-cache: skipping invalid entry in " + cacheFile);
+      continue;
+    }
+    result.expVal = std::strtod(expValStr.c_str(), nullptr);
+    std::string bitStr;
+    int count;
+    for (std::size_t i = 0; i < nCounts && (ss >> bitStr >> count); ++i) {
+      result.counts[bitStr] = count;
+    }
+    entries.emplace_back(std::move(key), std::move(result));
+  }
+  nFileEntries = entries.size();
+
+  int nLoaded = 0;
+  for (auto iter = entries.rbegin();
+       iter != entries.rend() && lru.size() < maxEntries; ++iter) {
+    if (index.find(iter->first) == index.end()) {
+      lru.emplace_back(std::move(*iter));
+      index[lru.back().first] = std::prev(lru.end());
+      ++nLoaded;
+    }
+  }
+  xacc::info("result-cache: loaded " + std::to_string(nLoaded) +
+             " entries from " + cacheFile);
+}
+
+void ResultCacheDecorator::writeEntry(std::ostream &stream,
+                                      const std::string &key,
+                                      const CachedResult &result) const {
+  stream << key << "\n"
+         << result.hasExpVal << " " << exactString(result.expVal) << " "
+         << result.counts.size();
+  for (const auto &[bitStr, count] : result.counts) {
+    stream << " " << bitStr << " " << count;
+  }
+  stream << "\n";
+}
+
+void ResultCacheDecorator::save() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (cacheFile.empty() || (!rewrite && unsaved.empty())) {
+    return;
+  }
+  // Compact the file (stale and evicted entries) once it has grown past twice
+  // the cache size, otherwise append the new entries.
+  const bool compact =
+      rewrite || nFileEntries + unsaved.size() > 2 * maxEntries;
+  std::ofstream stream(cacheFile, compact ? std::ios::trunc : std::ios::app);
+  if (!stream) {
+    xacc::warning("result-cache: cannot write to " + cacheFile);
+    return;
+  }
+  if (compact) {
+    // Least recently used first
+    for (auto iter = lru.rbegin(); iter != lru.rend(); ++iter) {
+      writeEntry(stream, iter->first, iter->second);
+    }
+    nFileEntries = lru.size();
+  } else {
+    for (const auto &key : unsaved) {
+      // Skip the entries evicted since they were stored.
+      auto iter = index.find(key);
+      if (iter != index.end()) {
+        writeEntry(stream, key, iter->second->second);
+        ++nFileEntries;
+      }
+    }
+  }
+  unsaved.clear();
+  rewrite = false;
+}
+
+void ResultCacheDecorator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> function) {
+  if (!decoratedAccelerator) {
+    xacc::error("result-cache: no decorated accelerator.");
+  }
+  const auto key = cacheKey(function, buffer->size());
+  CachedResult cached;
+  if (!key.empty() && lookup(key, cached)) {
+    fromCachedResult(cached, buffer);
+  } else {
+    decoratedAccelerator->execute(buffer, function);
+    if (!key.empty()) {
+      store(key, toCachedResult(buffer));
+    }
+  }
+  reportStatistics(buffer);
+  save();
+}
+
+void ResultCacheDecorator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>> functions) {
+  if (!decoratedAccelerator) {
+    xacc::error("result-cache: no decorated accelerator.");
+  }
+
+  // Results of the cache hits, and the circuits to execute. Circuits which
+  // are identical within the batch (e.g. different observable terms sharing
+  // the same measurement basis) are only executed once.
+  std::vector<std::string> keys(functions.size());
+  std::vector<CachedResult> results(functions.size());
+  std::vector<bool> resolved(functions.size(), false);
+  std::unordered_map<std::string, std::size_t> firstMiss;
+  std::vector<std::shared_ptr<CompositeInstruction>> toExecute;
+  // Position of each executed circuit in 'toExecute': the results are matched
+  // by position since the circuits of a batch may share a name (e.g. the
+  // shifted circuits of a parameter-shift gradient).
+  std::vector<std::size_t> executedIdx(functions.size(), 0);
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    keys[i] = cacheKey(functions[i], buffer->size());
+    if (keys[i].empty()) {
+      executedIdx[i] = toExecute.size();
+      toExecute.emplace_back(functions[i]);
+      continue;
+    }
+    if (firstMiss.find(keys[i]) != firstMiss.end()) {
+      continue;
+    }
+    if (lookup(keys[i], results[i])) {
+      resolved[i] = true;
+    } else {
+      firstMiss[keys[i]] = i;
+      executedIdx[i] = toExecute.size();
+      toExecute.emplace_back(functions[i]);
+    }
+  }
+
+  std::vector<std::shared_ptr<AcceleratorBuffer>> executed;
+  if (!toExecute.empty()) {
+    auto tmpBuffer = xacc::qalloc(buffer->size());
+    decoratedAccelerator->execute(tmpBuffer, toExecute);
+    executed = tmpBuffer->getChildren();
+    if (executed.size() != toExecute.size()) {
+      xacc::error("result-cache: expected " +
+                  std::to_string(toExecute.size()) + " results, got " +
+                  std::to_string(executed.size()) + ".");
+    }
+  }
+
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    const auto childName = functions[i]->name();
+    if (!resolved[i]) {
+      auto dup = keys[i].empty() ? firstMiss.end() : firstMiss.find(keys[i]);
+      if (dup == firstMiss.end() || dup->second == i) {
+        // Executed by the decorated accelerator
+        const auto &executedChild = executed[executedIdx[i]];
+        buffer->appendChild(childName, executedChild);
+        if (!keys[i].empty()) {
+          results[i] = toCachedResult(executedChild);
+          store(keys[i], results[i]);
+        }
+        continue;
+      }
+      // Duplicate of a circuit executed in this batch.
+      results[i] = results[dup->second];
+    }
+    auto child = std::make_shared<AcceleratorBuffer>(childName, buffer->size());
+    fromCachedResult(results[i], child);
+    buffer->appendChild(childName, child);
+  }
+  reportStatistics(buffer);
+  save();
+}
+
+} // namespace quantum
+} // namespace xacc
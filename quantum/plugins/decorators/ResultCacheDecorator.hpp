@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_RESULTCACHEDECORATOR_HPP_
+#define XACC_RESULTCACHEDECORATOR_HPP_
+
+#include "AcceleratorDecorator.hpp"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace xacc {
+
+namespace quantum {
+
+// Memoization of circuit execution results across iterations of variational
+// loops (VQE, QAOA, Rotoselect, gradients), where the same (fully-bound)
+// circuits are frequently re-submitted.
+//
+// The cache key is the canonical form of the parameter-bound circuit (gate
+// names, qubits and exact parameter values), the number of qubits, and the
+// decorated backend signature and properties (e.g. shots, vqe-mode, noise
+// model), so that a differently configured backend doesn't share entries.
+// The measurement counts and the 'exp-val-z' value are stored in a bounded
+// LRU cache, optionally persisted to (and reloaded from) a file: new entries
+// are appended to the file, which is only rewritten when it has grown past
+// twice the cache size.
+// Note: for sampling backends, a cache hit returns the *same* shot sample as
+// the cached execution rather than a new one.
+//
+// Cumulative statistics are reported on the buffer as 'result-cache-hits',
+// 'result-cache-misses' and 'result-cache-hit-rate'.
+class ResultCacheDecorator : public AcceleratorDecorator {
+public:
+  struct CachedResult {
+    std::map<std::string, int> counts;
+    bool hasExpVal = false;
+    double expVal = 0.0;
+  };
+
+protected:
+  std::size_t maxEntries = 1024;
+  std::string cacheFile;
+
+  // LRU: most recently used at the front of the list.
+  std::list<std::pair<std::string, CachedResult>> lru;
+  std::unordered_map<std::string,
+                     std::list<std::pair<std::string, CachedResult>>::iterator>
+      index;
+  std::size_t nHits = 0;
+  std::size_t nMisses = 0;
+  // Keys stored since the last save, and number of entries in the file.
+  std::vector<std::string> unsaved;
+  std::size_t nFileEntries = 0;
+  // The file no longer matches the cache (e.g. cleared): rewrite it.
+  bool rewrite = false;
+  std::mutex cacheMutex;
+
+  // Returns an empty string if the circuit can't be cached
+  // (e.g. it has unbound parameters).
+  std::string cacheKey(std::shared_ptr<CompositeInstruction> function,
+                       int nQubits);
+  bool lookup(const std::string &key, CachedResult &result);
+  void store(const std::string &key, const CachedResult &result);
+  void reportStatistics(std::shared_ptr<AcceleratorBuffer> buffer);
+  void load();
+  void save();
+  void writeEntry(std::ostream &stream, const std::string &key,
+                  const CachedResult &result) const;
+
+public:
+  ResultCacheDecorator() = default;
+
+  void initialize(const HeterogeneousMap &params = {}) override;
+  void updateConfiguration(const HeterogeneousMap &config) override;
+  const std::vector<std::string> configurationKeys() override {
+    return {"max-entries", "cache-file", "clear-cache"};
+  }
+
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::shared_ptr<CompositeInstruction> function) override;
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   functions) override;
+
+  const std::string name() const override { return "result-cache"; }
+  const std::string description() const override {
+    return "LRU cache of circuit execution results, keyed by the bound "
+           "circuit and the backend signature and properties.";
+  }
+
+  std::size_t size();
+  void clearCache();
+
+  ~ResultCacheDecorator() override {}
+};
+
+} // namespace quantum
+} // namespace xacc
+#endif
@@ -0,0 +1,283 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+
+#include "AcceleratorDecorator.hpp"
+#include "xacc.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include "xacc_service.hpp"
+#include "NoiseModel.hpp"
+#include "xacc_observable.hpp"
+#include <Eigen/Dense>
+#include <cmath>
+#include <random>
+
+using namespace xacc;
+
+namespace {
+const std::string ro_error_noise_model =
+    R"({"gate_noise": [], "bit_order": "MSB", "readout_errors": [{"register_location": "0", "prob_meas0_prep1": 0.025, "prob_meas1_prep0": 0.015}, {"register_location": "1", "prob_meas0_prep1": 0.035, "prob_meas1_prep0": 0.02}]})";
+
+// Returns fixed counts: exact single-qubit flip rates for the readout
+// calibration circuits, and the given counts for any other circuit.
+class FixedCountsAccelerator : public xacc::Accelerator {
+public:
+  FixedCountsAccelerator(int nQubits, const std::vector<double> &p01,
+                         const std::vector<double> &p10,
+                         const std::map<std::string, int> &counts)
+      : nQubits(nQubits), p01(p01), p10(p10), counts(counts) {}
+  const std::string name() const override { return "fixed-counts"; }
+  const std::string description() const override { return ""; }
+  const std::string getSignature() override {
+    return name() + ":" + std::to_string(nQubits);
+  }
+  void initialize(const HeterogeneousMap &params = {}) override {}
+  void updateConfiguration(const HeterogeneousMap &config) override {}
+  const std::vector<std::string> configurationKeys() override { return {}; }
+
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::shared_ptr<CompositeInstruction> f) override {
+    const std::string calPrefix = "readout_cal_";
+    if (f->name().rfind(calPrefix, 0) != 0) {
+      buffer->setMeasurements(counts);
+      return;
+    }
+    // Tensored calibration: every qubit prepared in |prep>
+    const int prep = std::stoi(f->name().substr(calPrefix.size()));
+    const auto &rates = prep ? p10 : p01;
+    std::map<std::string, int> calCounts;
+    int flipped = 0;
+    for (int q = 0; q < nQubits; ++q) {
+      std::string bitStr(nQubits, prep ? '1' : '0');
+      bitStr[nQubits - 1 - q] = prep ? '0' : '1';
+      calCounts[bitStr] = std::lround(rates[q] * shots);
+      flipped += calCounts[bitStr];
+    }
+    calCounts[std::string(nQubits, prep ? '1' : '0')] = shots - flipped;
+    buffer->setMeasurements(calCounts);
+  }
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   functions) override {
+    for (auto &f : functions) {
+      auto child = std::make_shared<AcceleratorBuffer>(f->name(), nQubits);
+      execute(child, f);
+      buffer->appendChild(f->name(), child);
+    }
+  }
+
+  static constexpr int shots = 100000;
+
+private:
+  int nQubits;
+  std::vector<double> p01;
+  std::vector<double> p10;
+  std::map<std::string, int> counts;
+};
+} // namespace
+
+TEST(ReadoutMitigationDecoratorTest, checkTensored) {
+  const int shots = 8192;
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", ro_error_noise_model}});
+  const std::string ibmNoiseJson = noiseModel->toJson();
+  auto acc = xacc::getAccelerator(
+      "aer", {{"noise-model", ibmNoiseJson}, {"shots", shots}});
+  auto buffer = xacc::qalloc(2);
+  auto compiler = xacc::getService<xacc::Compiler>("xasm");
+  const std::string src = R"src(__qpu__ void bell_tensored(qbit q) {
+       H(q[0]);
+       CX(q[0], q[1]);
+       Measure(q[0]);
+       Measure(q[1]);
+       }
+       )src";
+
+  auto ir = compiler->compile(src, acc);
+  auto decorator = xacc::getAcceleratorDecorator("readout-mitigation", acc,
+                                                 {{"mode", "tensored"}});
+  decorator->execute(buffer, ir->getComposites()[0]);
+  buffer->print();
+  EXPECT_TRUE(buffer->hasExtraInfoKey("unmitigated-counts"));
+  auto unmitigated_counts = buffer->getInformation("unmitigated-counts")
+                                .as<std::map<std::string, double>>();
+  EXPECT_GT(static_cast<double>(buffer->getMeasurementCounts()["00"]),
+            unmitigated_counts["00"]);
+  EXPECT_GT(static_cast<double>(buffer->getMeasurementCounts()["11"]),
+            unmitigated_counts["11"]);
+  // Readout errors only, hence the mitigated distribution is close to ideal.
+  EXPECT_NEAR(buffer->computeMeasurementProbability("00"), 0.5, 0.05);
+  EXPECT_NEAR(buffer->computeMeasurementProbability("11"), 0.5, 0.05);
+}
+
+TEST(ReadoutMitigationDecoratorTest, checkCorrelatedPartialMeasure) {
+  const int shots = 8192;
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", ro_error_noise_model}});
+  const std::string ibmNoiseJson = noiseModel->toJson();
+  auto acc = xacc::getAccelerator(
+      "aer", {{"noise-model", ibmNoiseJson}, {"shots", shots}});
+  auto buffer = xacc::qalloc(2);
+  auto compiler = xacc::getService<xacc::Compiler>("xasm");
+  const std::string src = R"src(__qpu__ void x_correlated(qbit q) {
+       X(q[1]);
+       Measure(q[1]);
+       }
+       )src";
+
+  auto ir = compiler->compile(src, acc);
+  auto decorator = xacc::getAcceleratorDecorator(
+      "readout-mitigation", acc,
+      {{"mode", "correlated"},
+       {"pairs", std::vector<std::pair<int, int>>{{0, 1}}}});
+  decorator->execute(buffer, ir->getComposites()[0]);
+  buffer->print();
+  // Marginalized back to the single measured qubit.
+  EXPECT_EQ(buffer->getMeasurementCounts().size(), 1);
+  EXPECT_NEAR(buffer->computeMeasurementProbability("1"), 1.0, 0.01);
+}
+
+TEST(ReadoutMitigationDecoratorTest, checkVecExecution) {
+  const int shots = 8192;
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", ro_error_noise_model}});
+  const std::string ibmNoiseJson = noiseModel->toJson();
+  auto acc = xacc::getAccelerator(
+      "aer", {{"noise-model", ibmNoiseJson}, {"shots", shots}});
+  auto H_N_2 = xacc::quantum::getObservable(
+      "pauli", std::string("5.907 - 2.1433 X0X1 "
+                           "- 2.1433 Y0Y1"
+                           "+ .21829 Z0 - 6.125 Z1"));
+
+  auto optimizer = xacc::getOptimizer("nlopt");
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit deuteron_ansatz_ro_mitigation
+        .parameters theta
+        .qbit q
+        X(q[0]);
+        Ry(q[1], theta);
+        CNOT(q[1],q[0]);
+    )");
+  auto ansatz = xacc::getCompiled("deuteron_ansatz_ro_mitigation");
+  auto decorator = xacc::getAcceleratorDecorator("readout-mitigation", acc);
+  auto vqe = xacc::getAlgorithm("vqe");
+  vqe->initialize({{"ansatz", ansatz},
+                   {"observable", H_N_2},
+                   {"accelerator", decorator},
+                   {"optimizer", optimizer}});
+
+  auto buffer = xacc::qalloc(2);
+  vqe->execute(buffer, {0.594});
+  const double energy = H_N_2->postProcess(buffer);
+  std::cout << "Energy = " << energy << "\n";
+  EXPECT_NEAR(energy, -1.74886, 0.1);
+}
+
+TEST(ReadoutMitigationDecoratorTest, checkSparseLargeRegister) {
+  // 16 qubits, a few hundred observed states out of 2^16: the neighbours of
+  // each state are looked up by bit flips.
+  const int nQubits = 16;
+  const int maxDistance = 2;
+  std::vector<double> p01, p10;
+  for (int q = 0; q < nQubits; ++q) {
+    p01.emplace_back(0.01 + 0.001 * q);
+    p10.emplace_back(0.02 + 0.0015 * q);
+  }
+
+  // Noisy readout of a few random states
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> bitDist(0, 1);
+  std::bernoulli_distribution flipDist(0.02);
+  std::vector<std::string> ideal(4, std::string(nQubits, '0'));
+  for (auto &bitStr : ideal) {
+    for (auto &c : bitStr) {
+      c = bitDist(gen) ? '1' : '0';
+    }
+  }
+  std::map<std::string, int> counts;
+  for (int shot = 0; shot < 20000; ++shot) {
+    auto bitStr = ideal[shot % ideal.size()];
+    for (auto &c : bitStr) {
+      if (flipDist(gen)) {
+        c = c == '1' ? '0' : '1';
+      }
+    }
+    counts[bitStr]++;
+  }
+  const int nStates = counts.size();
+  // More observed states than Hamming neighbours (16 + 120)
+  EXPECT_GT(nStates, nQubits + nQubits * (nQubits - 1) / 2);
+
+  auto acc =
+      std::make_shared<FixedCountsAccelerator>(nQubits, p01, p10, counts);
+  auto decorator = xacc::getAcceleratorDecorator(
+      "readout-mitigation", acc,
+      {{"mode", "tensored"}, {"max-distance", maxDistance}});
+  auto provider = xacc::getIRProvider("quantum");
+  auto buffer = xacc::qalloc(nQubits);
+  decorator->execute(buffer, provider->createComposite("sparse_counts"));
+
+  // Dense reference: the reduced assignment matrix over the observed states,
+  // each element taken from the full tensor product.
+  const auto assignment = [&](int q, char meas, char prep) {
+    const double flip = std::lround(
+        (prep == '1' ? p10[q] : p01[q]) * FixedCountsAccelerator::shots) /
+        (double)FixedCountsAccelerator::shots;
+    return meas == prep ? 1.0 - flip : flip;
+  };
+  std::vector<std::string> states;
+  Eigen::VectorXd probs(nStates);
+  for (const auto &[bitStr, count] : counts) {
+    probs(states.size()) = count / 20000.0;
+    states.emplace_back(bitStr);
+  }
+  Eigen::MatrixXd A = Eigen::MatrixXd::Zero(nStates, nStates);
+  for (int j = 0; j < nStates; ++j) {
+    for (int i = 0; i < nStates; ++i) {
+      int distance = 0;
+      double value = 1.0;
+      for (int q = 0; q < nQubits; ++q) {
+        const auto c = nQubits - 1 - q;
+        distance += states[i][c] != states[j][c];
+        value *= assignment(q, states[i][c], states[j][c]);
+      }
+      if (distance <= maxDistance) {
+        A(i, j) = value;
+      }
+    }
+    A.col(j) /= A.col(j).sum();
+  }
+  Eigen::VectorXd expected = A.fullPivLu().solve(probs);
+  expected = expected.cwiseMax(0.0);
+  expected /= expected.sum();
+
+  auto mitigated = buffer->getMeasurementCounts();
+  for (int i = 0; i < nStates; ++i) {
+    const int expectedCount = std::floor(20000 * expected(i) + 0.5);
+    EXPECT_NEAR(expectedCount, mitigated[states[i]], 1) << states[i];
+  }
+  // Mitigation moves counts back to the ideal states
+  for (const auto &bitStr : ideal) {
+    EXPECT_GT(mitigated[bitStr], counts[bitStr]);
+  }
+}
+
+int main(int argc, char **argv) {
+  int ret = 0;
+  xacc::Initialize();
+  ::testing::InitGoogleTest(&argc, argv);
+  ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
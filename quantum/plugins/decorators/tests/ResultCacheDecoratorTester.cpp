@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "AcceleratorDecorator.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+
+using namespace xacc;
+
+namespace {
+std::shared_ptr<CompositeInstruction> getAnsatz(const std::string &name) {
+  auto compiler = xacc::getCompiler("xasm");
+  auto ir = compiler->compile("__qpu__ void " + name + R"((qbit q, double t) {
+    X(q[0]);
+    Ry(q[1], t);
+    CX(q[1], q[0]);
+    H(q[0]);
+    Measure(q[0]);
+    Measure(q[1]);
+  })");
+  return ir->getComposites()[0];
+}
+
+int getInt(std::shared_ptr<AcceleratorBuffer> buffer, const std::string &key) {
+  return mpark::get<int>(buffer->getInformation(key));
+}
+} // namespace
+
+TEST(ResultCacheDecoratorTester, checkSimple) {
+  auto acc = xacc::getAccelerator("qpp", {{"shots", 1024}});
+  auto decorator = xacc::getAcceleratorDecorator("result-cache", acc,
+                                                 {{"clear-cache", true}});
+  auto ansatz = getAnsatz("cache_simple");
+
+  auto buffer1 = xacc::qalloc(2);
+  decorator->execute(buffer1, (*ansatz)({0.5}));
+  EXPECT_EQ(getInt(buffer1, "result-cache-hits"), 0);
+  EXPECT_EQ(getInt(buffer1, "result-cache-misses"), 1);
+
+  // Same parameters: served from the cache
+  auto buffer2 = xacc::qalloc(2);
+  decorator->execute(buffer2, (*ansatz)({0.5}));
+  EXPECT_EQ(getInt(buffer2, "result-cache-hits"), 1);
+  EXPECT_EQ(buffer1->getMeasurementCounts(), buffer2->getMeasurementCounts());
+
+  // Different parameters: executed
+  auto buffer3 = xacc::qalloc(2);
+  decorator->execute(buffer3, (*ansatz)({0.5 + 1e-12}));
+  EXPECT_EQ(getInt(buffer3, "result-cache-hits"), 1);
+  EXPECT_EQ(getInt(buffer3, "result-cache-misses"), 2);
+  EXPECT_NEAR(mpark::get<double>(buffer3->getInformation("result-cache-hit-rate")),
+              1.0 / 3.0, 1e-9);
+}
+
+TEST(ResultCacheDecoratorTester, checkBatch) {
+  auto acc = xacc::getAccelerator("qpp", {{"shots", 1024}});
+  auto decorator = xacc::getAcceleratorDecorator(
+      "result-cache", acc, {{"clear-cache", true}, {"max-entries", 2}});
+  auto ansatz = getAnsatz("cache_batch");
+  auto f1 = (*ansatz)({0.1});
+  f1->setName("f1");
+  auto f2 = (*ansatz)({0.2});
+  f2->setName("f2");
+  // Identical to f1
+  auto f3 = (*ansatz)({0.1});
+  f3->setName("f3");
+
+  auto buffer = xacc::qalloc(2);
+  decorator->execute(buffer, {f1, f2, f3});
+  EXPECT_EQ(buffer->nChildren(), 3);
+  EXPECT_EQ(buffer->getChildren()[0]->name(), "f1");
+  EXPECT_EQ(buffer->getChildren()[2]->name(), "f3");
+  EXPECT_EQ(buffer->getChildren()[0]->getMeasurementCounts(),
+            buffer->getChildren()[2]->getMeasurementCounts());
+
+  auto f4 = (*ansatz)({0.3});
+  f4->setName("f4");
+  auto buffer2 = xacc::qalloc(2);
+  decorator->execute(buffer2, {f2, f4});
+  EXPECT_EQ(buffer2->nChildren(), 2);
+  EXPECT_EQ(getInt(buffer2, "result-cache-hits"), 1);
+
+  // f1 has been evicted (max-entries = 2)
+  auto buffer3 = xacc::qalloc(2);
+  decorator->execute(buffer3, {f1});
+  EXPECT_EQ(getInt(buffer3, "result-cache-hits"), 1);
+  EXPECT_EQ(getInt(buffer3, "result-cache-misses"), 4);
+}
+
+TEST(ResultCacheDecoratorTester, checkBatchSharedNames) {
+  // Different circuits of a batch may share a name (e.g. the shifted circuits
+  // of a parameter-shift gradient).
+  auto acc = xacc::getAccelerator("qpp", {{"shots", 1024}});
+  auto decorator = xacc::getAcceleratorDecorator("result-cache", acc,
+                                                 {{"clear-cache", true}});
+  auto compiler = xacc::getCompiler("xasm");
+  auto fx = compiler->compile(R"(__qpu__ void shared_name_x(qbit q) {
+    X(q[0]);
+    X(q[1]);
+    Measure(q[0]);
+    Measure(q[1]);
+  })")->getComposite("shared_name_x");
+  auto fi = compiler->compile(R"(__qpu__ void shared_name_i(qbit q) {
+    Measure(q[0]);
+    Measure(q[1]);
+  })")->getComposite("shared_name_i");
+  fx->setName("term");
+  fi->setName("term");
+  const std::map<std::string, int> countsX{{"11", 1024}};
+  const std::map<std::string, int> countsI{{"00", 1024}};
+
+  auto buffer = xacc::qalloc(2);
+  decorator->execute(buffer, {fx, fi});
+  ASSERT_EQ(buffer->nChildren(), 2);
+  EXPECT_EQ(buffer->getChildren()[0]->getMeasurementCounts(), countsX);
+  EXPECT_EQ(buffer->getChildren()[1]->getMeasurementCounts(), countsI);
+  EXPECT_EQ(getInt(buffer, "result-cache-misses"), 2);
+
+  // Each circuit has its own cache entry.
+  for (const auto &[function, counts] : {std::make_pair(fi, countsI),
+                                         std::make_pair(fx, countsX)}) {
+    auto single = xacc::qalloc(2);
+    decorator->execute(single, function);
+    EXPECT_EQ(single->getMeasurementCounts(), counts);
+  }
+  auto buffer2 = xacc::qalloc(2);
+  decorator->execute(buffer2, {fi, fx});
+  ASSERT_EQ(buffer2->nChildren(), 2);
+  EXPECT_EQ(buffer2->getChildren()[0]->getMeasurementCounts(), countsI);
+  EXPECT_EQ(buffer2->getChildren()[1]->getMeasurementCounts(), countsX);
+  EXPECT_EQ(getInt(buffer2, "result-cache-hits"), 4);
+  EXPECT_EQ(getInt(buffer2, "result-cache-misses"), 2);
+}
+
+TEST(ResultCacheDecoratorTester, checkBackendConfiguration) {
+  auto acc = xacc::getAccelerator("qpp", {{"shots", 1024}});
+  auto decorator = xacc::getAcceleratorDecorator("result-cache", acc,
+                                                 {{"clear-cache", true}});
+  auto ansatz = getAnsatz("cache_config");
+  auto buffer1 = xacc::qalloc(2);
+  decorator->execute(buffer1, (*ansatz)({0.7}));
+  EXPECT_EQ(getInt(buffer1, "result-cache-misses"), 1);
+
+  // Same circuit, differently configured backend: not served from the cache
+  decorator->updateConfiguration({{"shots", 512}});
+  auto buffer2 = xacc::qalloc(2);
+  decorator->execute(buffer2, (*ansatz)({0.7}));
+  EXPECT_EQ(getInt(buffer2, "result-cache-hits"), 0);
+  EXPECT_EQ(getInt(buffer2, "result-cache-misses"), 2);
+  int total = 0;
+  for (const auto &[bitStr, count] : buffer2->getMeasurementCounts()) {
+    total += count;
+  }
+  EXPECT_EQ(total, 512);
+
+  // Back to the first configuration: cache hit
+  decorator->updateConfiguration({{"shots", 1024}});
+  auto buffer3 = xacc::qalloc(2);
+  decorator->execute(buffer3, (*ansatz)({0.7}));
+  EXPECT_EQ(getInt(buffer3, "result-cache-hits"), 1);
+  EXPECT_EQ(buffer1->getMeasurementCounts(), buffer3->getMeasurementCounts());
+}
+
+TEST(ResultCacheDecoratorTester, checkPersistence) {
+  const std::string fileName = "result_cache_test.txt";
+  std::remove(fileName.c_str());
+  auto acc = xacc::getAccelerator("qpp", {{"shots", 1024}});
+  auto ansatz = getAnsatz("cache_file");
+  auto decorator = xacc::getAcceleratorDecorator(
+      "result-cache", acc, {{"clear-cache", true}, {"cache-file", fileName}});
+  auto buffer1 = xacc::qalloc(2);
+  decorator->execute(buffer1, (*ansatz)({1.5}));
+
+  // Reload from the file only
+  decorator = xacc::getAcceleratorDecorator(
+      "result-cache", acc, {{"clear-cache", true}, {"cache-file", fileName}});
+  auto buffer2 = xacc::qalloc(2);
+  decorator->execute(buffer2, (*ansatz)({1.5}));
+  EXPECT_EQ(getInt(buffer2, "result-cache-hits"), 1);
+  EXPECT_EQ(buffer1->getMeasurementCounts(), buffer2->getMeasurementCounts());
+  std::remove(fileName.c_str());
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
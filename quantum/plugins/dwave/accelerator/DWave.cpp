@@ -1,5 +1,6 @@
 #include "DWave.hpp"
 #include "EmbeddingAlgorithm.hpp"
+#include "EmbeddingCache.hpp"
 #include "dwave_sapi.h"
 #include "xacc.hpp"
 
@@ -96,7 +97,19 @@ void DWave::execute(std::shared_ptr<AcceleratorBuffer> buffer,
   if (!buffer->hasExtraInfoKey("embedding")) {
 
     auto embeddingAlgo = xacc::getService<EmbeddingAlgorithm>(default_emb_algo);
-    embedding = embeddingAlgo->embed(probGraph, hardwareGraph);
+    if (use_embedding_cache) {
+      // Reuse the embedding of a previous execution of the same problem
+      // graph on the same hardware graph, otherwise keep the best
+      // (shortest max. chain) of several parallel embedding searches.
+      EmbeddingCache cache;
+      embedding = cache.embed(embeddingAlgo, probGraph, hardwareGraph,
+                              embedding_seeds);
+      if (embedding.empty()) {
+        xacc::error("[Dwave Backend] Couldn't find embedding.");
+      }
+    } else {
+      embedding = embeddingAlgo->embed(probGraph, hardwareGraph);
+    }
     buffer->addExtraInfo("embedding", embedding);
 
   } else {
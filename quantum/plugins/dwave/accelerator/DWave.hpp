@@ -34,6 +34,10 @@ protected:
   sapi_Connection *connection = NULL;
   const sapi_SolverProperties *solver_properties = NULL;
   std::string default_emb_algo = "cmr";
+  // Embeddings are cached on disk, see EmbeddingCache
+  bool use_embedding_cache = true;
+  // Number of parallel embedding searches (random seeds)
+  int embedding_seeds = 4;
 
   void searchAPIKey(std::string &key);
   void findApiKeyInFile(std::string &key, const std::string &p);
@@ -84,6 +88,15 @@ public:
     if (params.stringExists("embedding-algorithm")) {
         default_emb_algo = params.getString("embedding-algorithm");
     }
+    if (params.keyExists<bool>("embedding-cache")) {
+        use_embedding_cache = params.get<bool>("embedding-cache");
+    }
+    if (params.keyExists<int>("embedding-seeds")) {
+        embedding_seeds = params.get<int>("embedding-seeds");
+        if (embedding_seeds < 1) {
+            xacc::error("[Dwave Backend] Invalid 'embedding-seeds' parameter.");
+        }
+    }
   }
 
   std::vector<std::pair<int, int>> getConnectivity() override;
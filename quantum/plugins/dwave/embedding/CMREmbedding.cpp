@@ -70,14 +70,27 @@ private:
   find_embedding::optional_parameters _params;
   _params.localInteractionPtr =
       std::make_shared<XACCInteractions>(); //.reset(new XACCInteractions());
+  if (params.count("random_seed")) {
+    _params.seed(std::stoull(params["random_seed"]));
+  }
+  if (params.count("tries")) {
+    _params.tries = std::stoi(params["tries"]);
+  }
+  if (params.count("timeout")) {
+    _params.timeout = std::stod(params["timeout"]);
+  }
+  const bool failHard =
+      !(params.count("failhard") && params["failhard"] == "false");
 
   if (find_embedding::findEmbedding(prob, hard, _params, chains)) {
     for (auto chain : chains) {
       embedding.insert(std::make_pair(counter, chain));
       counter++;
     }
-  } else {
+  } else if (failHard) {
     xacc::error("Couldn't find embedding.");
+  } else {
+    xacc::info("Couldn't find embedding, returning empty embedding.");
   }
 
   return embedding;
@@ -14,6 +14,7 @@
 #define OPENPULSEVISITOR_HPP_
 
 #include <memory>
+#include <set>
 #include "AllGateVisitor.hpp"
 #include "Pulse.hpp"
 #include "json.hpp"
@@ -64,6 +65,9 @@ protected:
 	constexpr static double pi = 3.1415926;
 
     bool hasAcquire = false;
+    // Names already added to the library (pulse shapes are typically
+    // played many times in a schedule).
+    std::set<std::string> libraryNames;
 public:
 
     std::vector<xacc::ibm_pulse::Instruction> instructions;
@@ -91,11 +95,12 @@ public:
         inst.set_t0(i.start());
 
         std::vector<std::string> builtIns {"fc", "acquire", "parametric_pulse", "delay" };
-        if (std::find(builtIns.begin(), builtIns.end(), i.name()) == std::end(builtIns)) {
+        if (std::find(builtIns.begin(), builtIns.end(), i.name()) == std::end(builtIns) &&
+            libraryNames.insert(i.name()).second) {
             // add to default libr
             xacc::ibm_pulse::PulseLibrary lib;
             lib.set_name(i.name());
-            lib.set_samples(i.getSamples());
+            lib.set_samples(WaveformLibrary::toPairs(i.samples()));
             library.push_back(lib);
         }
 
@@ -101,6 +101,10 @@ HeterogeneousMap AerAccelerator::getProperties() {
   if (m_simtype == "qasm") {
     props.insert("shots", m_shots);
   }
+  props.insert("sim-type", m_simtype);
+  if (!noise_model.empty()) {
+    props.insert("noise-model", noise_model.dump());
+  }
   return props;
 }
 
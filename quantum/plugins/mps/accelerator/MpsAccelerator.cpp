@@ -0,0 +1,493 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "MpsAccelerator.hpp"
+#include "xacc_plugin.hpp"
+#include "InstructionIterator.hpp"
+#include "IRUtils.hpp"
+#include <cassert>
+#include <set>
+#include <unordered_map>
+
+namespace {
+using Matrix2 = xacc::quantum::mps::MpsState::Matrix2;
+using Matrix4 = xacc::quantum::mps::MpsState::Matrix4;
+using Complex = std::complex<double>;
+constexpr Complex I(0.0, 1.0);
+
+bool isMeasureGate(const std::shared_ptr<xacc::Instruction> &in_instr) {
+  return in_instr->name() == "Measure";
+}
+
+// True if all measurements are terminal (no gate acts on a measured qubit),
+// i.e. shots can be sampled from the final state.
+bool shotCountFromFinalState(
+    const std::shared_ptr<xacc::CompositeInstruction> &in_composite) {
+  std::set<std::size_t> measuredQubits;
+  xacc::InstructionIterator it(in_composite);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (!inst->isEnabled()) {
+      continue;
+    }
+    if (inst->name() == "ifstmt" || inst->name() == "Reset") {
+      return false;
+    }
+    if (inst->isComposite()) {
+      continue;
+    }
+    if (isMeasureGate(inst)) {
+      auto measure = std::dynamic_pointer_cast<xacc::quantum::Measure>(inst);
+      if (measure && measure->hasClassicalRegAssignment()) {
+        return false;
+      }
+      if (!measuredQubits.emplace(inst->bits()[0]).second) {
+        return false;
+      }
+    } else {
+      for (const auto &bit : inst->bits()) {
+        if (measuredQubits.count(bit)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Maps an observed sub-circuit (basis change + measure) to a Pauli string:
+// no basis change -> Z, H -> X, Rx(pi/2) -> Y.
+// Returns false if the sub-circuit contains any other instruction.
+bool toPauliString(
+    const std::shared_ptr<xacc::CompositeInstruction> &in_composite,
+    std::map<std::size_t, char> &out_pauli) {
+  std::map<std::size_t, char> basis;
+  out_pauli.clear();
+  xacc::InstructionIterator it(in_composite);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (!inst->isEnabled() || inst->isComposite()) {
+      continue;
+    }
+    const auto bit = inst->bits()[0];
+    if (out_pauli.count(bit)) {
+      return false;
+    }
+    if (isMeasureGate(inst)) {
+      out_pauli[bit] = basis.count(bit) ? basis[bit] : 'Z';
+    } else if (basis.count(bit)) {
+      return false;
+    } else if (inst->name() == "H") {
+      basis[bit] = 'X';
+    } else if (inst->name() == "Rx" &&
+               std::abs(xacc::InstructionParameterToDouble(
+                            inst->getParameter(0)) -
+                        M_PI_2) < 1e-12) {
+      basis[bit] = 'Y';
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+Matrix2 rx(double theta) {
+  Matrix2 mat;
+  mat << std::cos(theta / 2.0), -I * std::sin(theta / 2.0),
+      -I * std::sin(theta / 2.0), std::cos(theta / 2.0);
+  return mat;
+}
+
+Matrix2 ry(double theta) {
+  Matrix2 mat;
+  mat << std::cos(theta / 2.0), -std::sin(theta / 2.0), std::sin(theta / 2.0),
+      std::cos(theta / 2.0);
+  return mat;
+}
+
+Matrix2 rz(double theta) {
+  Matrix2 mat;
+  mat << std::exp(-I * theta / 2.0), 0.0, 0.0, std::exp(I * theta / 2.0);
+  return mat;
+}
+
+Matrix2 phase(Complex p) {
+  Matrix2 mat;
+  mat << 1.0, 0.0, 0.0, p;
+  return mat;
+}
+
+Matrix2 pauliX() {
+  Matrix2 mat;
+  mat << 0.0, 1.0, 1.0, 0.0;
+  return mat;
+}
+
+Matrix2 pauliY() {
+  Matrix2 mat;
+  mat << 0.0, -I, I, 0.0;
+  return mat;
+}
+
+Matrix2 hadamard() {
+  Matrix2 mat;
+  mat << M_SQRT1_2, M_SQRT1_2, M_SQRT1_2, -M_SQRT1_2;
+  return mat;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+void MpsVisitor::initialize(mps::MpsState *state, std::mt19937_64 *rng,
+                            std::shared_ptr<AcceleratorBuffer> buffer) {
+  m_state = state;
+  m_rng = rng;
+  m_buffer = buffer;
+  m_bitString.clear();
+}
+
+void MpsVisitor::apply1(Gate &gate, const Matrix2 &mat) {
+  m_state->apply(gate.bits()[0], mat);
+}
+
+void MpsVisitor::apply2(Gate &gate, const Matrix4 &mat) {
+  m_state->apply(gate.bits()[0], gate.bits()[1], mat);
+}
+
+void MpsVisitor::applyControlled(Gate &gate, const Matrix2 &mat) {
+  Matrix4 full = Matrix4::Identity();
+  full.bottomRightCorner<2, 2>() = mat;
+  apply2(gate, full);
+}
+
+void MpsVisitor::visit(Hadamard &h) { apply1(h, hadamard()); }
+
+void MpsVisitor::visit(CNOT &cnot) { applyControlled(cnot, pauliX()); }
+
+void MpsVisitor::visit(Rz &rz) {
+  apply1(rz, ::rz(InstructionParameterToDouble(rz.getParameter(0))));
+}
+
+void MpsVisitor::visit(Ry &ry) {
+  apply1(ry, ::ry(InstructionParameterToDouble(ry.getParameter(0))));
+}
+
+void MpsVisitor::visit(Rx &rx) {
+  apply1(rx, ::rx(InstructionParameterToDouble(rx.getParameter(0))));
+}
+
+void MpsVisitor::visit(X &x) { apply1(x, pauliX()); }
+
+void MpsVisitor::visit(Y &y) { apply1(y, pauliY()); }
+
+void MpsVisitor::visit(Z &z) { apply1(z, phase(-1.0)); }
+
+void MpsVisitor::visit(CY &cy) { applyControlled(cy, pauliY()); }
+
+void MpsVisitor::visit(CZ &cz) { applyControlled(cz, phase(-1.0)); }
+
+void MpsVisitor::visit(Swap &s) {
+  Matrix4 mat = Matrix4::Zero();
+  mat(0, 0) = mat(1, 2) = mat(2, 1) = mat(3, 3) = 1.0;
+  apply2(s, mat);
+}
+
+void MpsVisitor::visit(CRZ &crz) {
+  applyControlled(crz, ::rz(InstructionParameterToDouble(crz.getParameter(0))));
+}
+
+void MpsVisitor::visit(CH &ch) { applyControlled(ch, hadamard()); }
+
+void MpsVisitor::visit(S &s) { apply1(s, phase(I)); }
+
+void MpsVisitor::visit(Sdg &sdg) { apply1(sdg, phase(-I)); }
+
+void MpsVisitor::visit(T &t) { apply1(t, phase(std::exp(I * M_PI_4))); }
+
+void MpsVisitor::visit(Tdg &tdg) { apply1(tdg, phase(std::exp(-I * M_PI_4))); }
+
+void MpsVisitor::visit(CPhase &cphase) {
+  applyControlled(
+      cphase,
+      phase(std::exp(I * InstructionParameterToDouble(cphase.getParameter(0)))));
+}
+
+void MpsVisitor::visit(Measure &measure) {
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  const bool result = m_state->measure(measure.bits()[0], dist(*m_rng));
+  m_bitString.push_back(result ? '1' : '0');
+  if (measure.hasClassicalRegAssignment()) {
+    m_buffer->measure(measure.getBufferNames()[1],
+                      measure.getClassicalBitIndex(), result);
+  } else {
+    m_buffer->measure(measure.bits()[0], result);
+  }
+}
+
+void MpsVisitor::visit(U &u) {
+  const auto theta = InstructionParameterToDouble(u.getParameter(0));
+  const auto phi = InstructionParameterToDouble(u.getParameter(1));
+  const auto lambda = InstructionParameterToDouble(u.getParameter(2));
+  Matrix2 mat;
+  mat << std::cos(theta / 2.0), -std::exp(I * lambda) * std::sin(theta / 2.0),
+      std::exp(I * phi) * std::sin(theta / 2.0),
+      std::exp(I * (phi + lambda)) * std::cos(theta / 2.0);
+  apply1(u, mat);
+}
+
+void MpsVisitor::visit(iSwap &in_iSwapGate) {
+  Matrix4 mat = Matrix4::Zero();
+  mat(0, 0) = mat(3, 3) = 1.0;
+  mat(1, 2) = mat(2, 1) = I;
+  apply2(in_iSwapGate, mat);
+}
+
+void MpsVisitor::visit(fSim &in_fsimGate) {
+  const auto theta = InstructionParameterToDouble(in_fsimGate.getParameter(0));
+  const auto phi = InstructionParameterToDouble(in_fsimGate.getParameter(1));
+  Matrix4 mat = Matrix4::Zero();
+  mat(0, 0) = 1.0;
+  mat(1, 1) = mat(2, 2) = std::cos(theta);
+  mat(1, 2) = mat(2, 1) = -I * std::sin(theta);
+  mat(3, 3) = std::exp(-I * phi);
+  apply2(in_fsimGate, mat);
+}
+
+void MpsVisitor::visit(XY &xy) {
+  const auto theta = InstructionParameterToDouble(xy.getParameter(0));
+  Matrix4 mat = Matrix4::Zero();
+  mat(0, 0) = mat(3, 3) = 1.0;
+  mat(1, 1) = mat(2, 2) = std::cos(theta / 2.0);
+  mat(1, 2) = mat(2, 1) = I * std::sin(theta / 2.0);
+  apply2(xy, mat);
+}
+
+void MpsVisitor::visit(RZZ &rzz) {
+  // exp(-i theta/2 Z x Z)
+  const auto theta = InstructionParameterToDouble(rzz.getParameter(0));
+  const auto even = std::exp(-I * theta / 2.0);
+  const auto odd = std::exp(I * theta / 2.0);
+  Matrix4 mat = Matrix4::Zero();
+  mat(0, 0) = mat(3, 3) = even;
+  mat(1, 1) = mat(2, 2) = odd;
+  apply2(rzz, mat);
+}
+
+void MpsVisitor::visit(Reset &in_resetGate) {
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  m_state->reset(in_resetGate.bits()[0], dist(*m_rng));
+}
+
+void MpsAccelerator::initialize(const HeterogeneousMap &params) {
+  m_shots = -1;
+  m_maxBondDim = 0;
+  m_truncationThreshold = 1e-16;
+  m_rng.seed(std::random_device()());
+  updateConfiguration(params);
+  // Enable VQE mode by default if not using shots.
+  if (!params.keyExists<bool>("vqe-mode")) {
+    m_vqeMode = (m_shots < 1);
+  }
+}
+
+void MpsAccelerator::updateConfiguration(const HeterogeneousMap &params) {
+  if (params.keyExists<int>("shots")) {
+    m_shots = params.get<int>("shots");
+    if (m_shots < 1) {
+      xacc::error("Invalid 'shots' parameter.");
+    }
+  }
+  if (params.keyExists<int>("max-bond-dim")) {
+    m_maxBondDim = params.get<int>("max-bond-dim");
+    if (m_maxBondDim < 0) {
+      xacc::error("Invalid 'max-bond-dim' parameter.");
+    }
+  }
+  if (params.keyExists<double>("truncation-threshold")) {
+    m_truncationThreshold = params.get<double>("truncation-threshold");
+    if (m_truncationThreshold < 0.0) {
+      xacc::error("Invalid 'truncation-threshold' parameter.");
+    }
+  }
+  if (params.keyExists<int>("seed")) {
+    m_rng.seed(params.get<int>("seed"));
+  }
+  if (params.keyExists<bool>("vqe-mode")) {
+    m_vqeMode = params.get<bool>("vqe-mode");
+    if (m_vqeMode) {
+      xacc::info("Enable VQE Mode.");
+    }
+  }
+}
+
+std::vector<std::size_t>
+MpsAccelerator::simulate(mps::MpsState &state,
+                         std::shared_ptr<AcceleratorBuffer> buffer,
+                         const std::shared_ptr<CompositeInstruction> composite) {
+  auto visitor = std::make_shared<MpsVisitor>();
+  visitor->initialize(&state, &m_rng, buffer);
+  std::vector<std::size_t> measureBitIdxs;
+  InstructionIterator it(composite);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (!nextInst->isEnabled() || nextInst->isComposite()) {
+      continue;
+    }
+    for (const auto &bit : nextInst->bits()) {
+      if (bit >= state.nQubits()) {
+        xacc::error("MPS simulator: qubit index " + std::to_string(bit) +
+                    " is out of range (buffer size " +
+                    std::to_string(state.nQubits()) + ").");
+      }
+    }
+    if (isMeasureGate(nextInst)) {
+      // Just collect the indices of measured qubit
+      measureBitIdxs.emplace_back(nextInst->bits()[0]);
+    } else {
+      nextInst->accept(visitor);
+    }
+  }
+  return measureBitIdxs;
+}
+
+void MpsAccelerator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> compositeInstruction) {
+  if (!shotCountFromFinalState(compositeInstruction)) {
+    runShots(buffer, compositeInstruction);
+    return;
+  }
+
+  mps::MpsState state(buffer->size(), m_maxBondDim, m_truncationThreshold);
+  const auto measureBitIdxs = simulate(state, buffer, compositeInstruction);
+  if (!measureBitIdxs.empty()) {
+    if (m_shots < 1) {
+      std::map<std::size_t, char> zString;
+      for (const auto &bit : measureBitIdxs) {
+        zString.emplace(bit, 'Z');
+      }
+      buffer->addExtraInfo("exp-val-z", state.expectation(zString));
+    } else {
+      // Bit string: one bit per measurement, in program order.
+      std::unordered_map<std::string, int> counts;
+      std::string bitString(measureBitIdxs.size(), '0');
+      for (const auto &bits : state.sample(measureBitIdxs, m_shots, m_rng)) {
+        for (std::size_t i = 0; i < bits.size(); ++i) {
+          bitString[i] = bits[i] ? '1' : '0';
+        }
+        counts[bitString]++;
+      }
+      for (const auto &[bitStr, count] : counts) {
+        buffer->appendMeasurement(bitStr, count);
+      }
+    }
+  }
+  addTruncationInfo(buffer, state);
+}
+
+void MpsAccelerator::runShots(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> composite) {
+  auto visitor = std::make_shared<MpsVisitor>();
+  // No shots: run a single trajectory.
+  const int nShots = m_shots < 1 ? 1 : m_shots;
+  double truncationError = 0.0;
+  int maxBondDim = 1;
+  for (int shot = 0; shot < nShots; ++shot) {
+    mps::MpsState state(buffer->size(), m_maxBondDim, m_truncationThreshold);
+    visitor->initialize(&state, &m_rng, buffer);
+    buffer->reset_single_measurements();
+    InstructionIterator it(composite);
+    while (it.hasNext()) {
+      auto nextInst = it.next();
+      if (!nextInst->isEnabled()) {
+        continue;
+      }
+      if (nextInst->isComposite()) {
+        if (nextInst->name() == "ifstmt") {
+          // Enable/disable the body based on the classical register value.
+          std::dynamic_pointer_cast<IfStmt>(nextInst)->expand({});
+        }
+        continue;
+      }
+      nextInst->accept(visitor);
+    }
+
+    const auto &bitString = visitor->getBitString();
+    if (m_shots < 1) {
+      const auto nOnes = std::count(bitString.begin(), bitString.end(), '1');
+      buffer->addExtraInfo("exp-val-z", nOnes % 2 == 0 ? 1.0 : -1.0);
+    } else {
+      buffer->appendMeasurement(bitString);
+    }
+    truncationError = std::max(truncationError, state.truncationError());
+    maxBondDim = std::max(maxBondDim, state.maxBondDimension());
+  }
+  buffer->addExtraInfo("mps-truncation-error", truncationError);
+  buffer->addExtraInfo("mps-max-bond-dim", maxBondDim);
+}
+
+void MpsAccelerator::addTruncationInfo(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const mps::MpsState &state) const {
+  buffer->addExtraInfo("mps-truncation-error", state.truncationError());
+  buffer->addExtraInfo("mps-max-bond-dim", state.maxBondDimension());
+}
+
+void MpsAccelerator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>>
+        compositeInstructions) {
+  if (!m_vqeMode || compositeInstructions.size() <= 1) {
+    for (auto &f : compositeInstructions) {
+      auto tmpBuffer =
+          std::make_shared<xacc::AcceleratorBuffer>(f->name(), buffer->size());
+      execute(tmpBuffer, f);
+      buffer->appendChild(f->name(), tmpBuffer);
+    }
+    return;
+  }
+
+  auto kernelDecomposed =
+      ObservedAnsatz::fromObservedComposites(compositeInstructions);
+  // Always validate kernel decomposition in DEBUG
+  assert(kernelDecomposed.validate(compositeInstructions));
+  // Simulate the base ansatz once, then evaluate each observed sub-circuit
+  // as a Pauli expectation value on the resulting MPS.
+  mps::MpsState state(buffer->size(), m_maxBondDim, m_truncationThreshold);
+  simulate(state, buffer, kernelDecomposed.getBase());
+  for (auto &obsCircuit : kernelDecomposed.getObservedSubCircuits()) {
+    auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(
+        obsCircuit->name(), buffer->size());
+    std::map<std::size_t, char> pauli;
+    double expVal = 0.0;
+    if (toPauliString(obsCircuit, pauli)) {
+      expVal = state.expectation(pauli);
+    } else {
+      // General basis change: apply it to a copy of the state.
+      auto stateCopy = state;
+      const auto measureBitIdxs = simulate(stateCopy, tmpBuffer, obsCircuit);
+      std::map<std::size_t, char> zString;
+      for (const auto &bit : measureBitIdxs) {
+        zString.emplace(bit, 'Z');
+      }
+      expVal = stateCopy.expectation(zString);
+    }
+    tmpBuffer->addExtraInfo("exp-val-z", expVal);
+    buffer->appendChild(obsCircuit->name(), tmpBuffer);
+  }
+  addTruncationInfo(buffer, state);
+}
+} // namespace quantum
+} // namespace xacc
+
+REGISTER_ACCELERATOR(xacc::quantum::MpsAccelerator)
@@ -0,0 +1,127 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include "xacc.hpp"
+#include "AllGateVisitor.hpp"
+#include "MpsState.hpp"
+
+namespace xacc {
+namespace quantum {
+// Applies XACC gates directly to an MPS.
+// Measure collapses the state (shot-by-shot simulation); terminal
+// measurements are not visited, the accelerator samples the final MPS.
+class MpsVisitor : public AllGateVisitor {
+public:
+  void initialize(mps::MpsState *state, std::mt19937_64 *rng,
+                  std::shared_ptr<AcceleratorBuffer> buffer);
+  const std::string &getBitString() const { return m_bitString; }
+
+  void visit(Hadamard &h) override;
+  void visit(CNOT &cnot) override;
+  void visit(Rz &rz) override;
+  void visit(Ry &ry) override;
+  void visit(Rx &rx) override;
+  void visit(X &x) override;
+  void visit(Y &y) override;
+  void visit(Z &z) override;
+  void visit(CY &cy) override;
+  void visit(CZ &cz) override;
+  void visit(Swap &s) override;
+  void visit(CRZ &crz) override;
+  void visit(CH &ch) override;
+  void visit(S &s) override;
+  void visit(Sdg &sdg) override;
+  void visit(T &t) override;
+  void visit(Tdg &tdg) override;
+  void visit(CPhase &cphase) override;
+  void visit(Measure &measure) override;
+  void visit(Identity &i) override {}
+  void visit(U &u) override;
+  void visit(iSwap &in_iSwapGate) override;
+  void visit(fSim &in_fsimGate) override;
+  void visit(XY &xy) override;
+  void visit(RZZ &rzz) override;
+  void visit(Reset &in_resetGate) override;
+
+private:
+  void apply1(Gate &gate, const mps::MpsState::Matrix2 &mat);
+  void apply2(Gate &gate, const mps::MpsState::Matrix4 &mat);
+  // Controlled single-qubit gate
+  void applyControlled(Gate &gate, const mps::MpsState::Matrix2 &mat);
+
+  mps::MpsState *m_state = nullptr;
+  std::mt19937_64 *m_rng = nullptr;
+  std::shared_ptr<AcceleratorBuffer> m_buffer;
+  std::string m_bitString;
+};
+
+// Matrix product state simulator.
+// Two-qubit gates are applied by SVD of the two-site tensor; non-adjacent
+// gates are routed by a swap network. Shots are generated by perfect
+// sampling of the final MPS; circuits with mid-circuit measurements, Reset
+// or IfStmt are simulated shot-by-shot.
+// Options:
+// - "shots" (int): number of shots; if not set, the expectation value of the
+//   measured Z-parity ("exp-val-z") is computed from the MPS.
+// - "max-bond-dim" (int): bond dimension cap (default: unlimited).
+// - "truncation-threshold" (double): discarded weight allowed per two-site
+//   update (default: 1e-16).
+// - "seed" (int): RNG seed.
+// - "vqe-mode" (bool): evaluate observed circuits as Pauli expectation values
+//   of a single simulated ansatz state (default: true if no shots).
+// The accumulated discarded weight and the final bond dimension are
+// reported as "mps-truncation-error" and "mps-max-bond-dim" in the buffer.
+class MpsAccelerator : public Accelerator {
+public:
+  // Identifiable interface impls
+  const std::string name() const override { return "mps"; }
+  const std::string description() const override {
+    return "XACC native matrix product state simulator.";
+  }
+
+  // Accelerator interface impls
+  void initialize(const HeterogeneousMap &params = {}) override;
+  void updateConfiguration(const HeterogeneousMap &config) override;
+  const std::vector<std::string> configurationKeys() override {
+    return {"shots", "max-bond-dim", "truncation-threshold", "seed",
+            "vqe-mode"};
+  }
+  HeterogeneousMap getProperties() override { return {{"shots", m_shots}}; }
+  BitOrder getBitOrder() override { return BitOrder::LSB; }
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::shared_ptr<CompositeInstruction>
+                   compositeInstruction) override;
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   compositeInstructions) override;
+
+private:
+  // Applies all gates and returns the measured qubits (terminal
+  // measurements only).
+  std::vector<std::size_t>
+  simulate(mps::MpsState &state, std::shared_ptr<AcceleratorBuffer> buffer,
+           const std::shared_ptr<CompositeInstruction> composite);
+  // Shot-by-shot simulation (mid-circuit measure/reset, IfStmt)
+  void runShots(std::shared_ptr<AcceleratorBuffer> buffer,
+                const std::shared_ptr<CompositeInstruction> composite);
+  void addTruncationInfo(std::shared_ptr<AcceleratorBuffer> buffer,
+                         const mps::MpsState &state) const;
+
+  int m_shots = -1;
+  int m_maxBondDim = 0;
+  double m_truncationThreshold = 1e-16;
+  bool m_vqeMode = true;
+  std::mt19937_64 m_rng;
+};
+} // namespace quantum
+} // namespace xacc
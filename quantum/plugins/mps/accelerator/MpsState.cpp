@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "MpsState.hpp"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace {
+using Matrix = xacc::quantum::mps::MpsState::Matrix;
+
+Eigen::Matrix2cd pauliMatrix(char pauli) {
+  Eigen::Matrix2cd mat;
+  switch (pauli) {
+  case 'X':
+    mat << 0.0, 1.0, 1.0, 0.0;
+    break;
+  case 'Y':
+    mat << 0.0, std::complex<double>(0.0, -1.0), std::complex<double>(0.0, 1.0),
+        0.0;
+    break;
+  case 'Z':
+    mat << 1.0, 0.0, 0.0, -1.0;
+    break;
+  default:
+    mat.setIdentity();
+  }
+  return mat;
+}
+
+const Eigen::Matrix4cd &swapMatrix() {
+  static const Eigen::Matrix4cd swapMat = []() {
+    Eigen::Matrix4cd mat = Eigen::Matrix4cd::Zero();
+    mat(0, 0) = 1.0;
+    mat(1, 2) = 1.0;
+    mat(2, 1) = 1.0;
+    mat(3, 3) = 1.0;
+    return mat;
+  }();
+  return swapMat;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+namespace mps {
+MpsState::MpsState(std::size_t nQubits, int maxBondDim,
+                   double truncationThreshold)
+    : m_tensors(nQubits), m_siteOf(nQubits), m_qubitAt(nQubits),
+      m_maxBondDim(maxBondDim), m_truncationThreshold(truncationThreshold) {
+  // |0...0> product state
+  for (std::size_t i = 0; i < nQubits; ++i) {
+    m_tensors[i][0] = Matrix::Ones(1, 1);
+    m_tensors[i][1] = Matrix::Zero(1, 1);
+  }
+  std::iota(m_siteOf.begin(), m_siteOf.end(), 0);
+  std::iota(m_qubitAt.begin(), m_qubitAt.end(), 0);
+}
+
+void MpsState::apply(std::size_t q, const Matrix2 &gate) {
+  auto &tensor = m_tensors[m_siteOf[q]];
+  const Matrix m0 = tensor[0];
+  tensor[0] = gate(0, 0) * m0 + gate(0, 1) * tensor[1];
+  tensor[1] = gate(1, 0) * m0 + gate(1, 1) * tensor[1];
+}
+
+void MpsState::apply(std::size_t q1, std::size_t q2, const Matrix4 &gate) {
+  assert(q1 != q2);
+  // Swap network: bring q2 next to q1.
+  while (m_siteOf[q2] > m_siteOf[q1] + 1) {
+    swapSites(m_siteOf[q2] - 1);
+  }
+  while (m_siteOf[q2] + 1 < m_siteOf[q1]) {
+    swapSites(m_siteOf[q2]);
+  }
+
+  if (m_siteOf[q1] < m_siteOf[q2]) {
+    applyAdjacent(m_siteOf[q1], gate);
+  } else {
+    const auto &swapMat = swapMatrix();
+    applyAdjacent(m_siteOf[q2], swapMat * gate * swapMat);
+  }
+}
+
+void MpsState::swapSites(std::size_t site) {
+  applyAdjacent(site, swapMatrix());
+  const auto qa = m_qubitAt[site];
+  const auto qb = m_qubitAt[site + 1];
+  std::swap(m_qubitAt[site], m_qubitAt[site + 1]);
+  m_siteOf[qa] = site + 1;
+  m_siteOf[qb] = site;
+}
+
+void MpsState::moveCenter(std::size_t site) {
+  while (m_center < site) {
+    // Left-orthonormalize the center: [M0; M1] = Q R
+    auto &tensor = m_tensors[m_center];
+    const auto dl = tensor[0].rows();
+    const auto dr = tensor[0].cols();
+    Matrix stacked(2 * dl, dr);
+    stacked << tensor[0], tensor[1];
+    Eigen::HouseholderQR<Matrix> qr(stacked);
+    const auto k = std::min(2 * dl, dr);
+    const Matrix q = qr.householderQ() * Matrix::Identity(2 * dl, k);
+    const Matrix r = q.adjoint() * stacked;
+    tensor[0] = q.topRows(dl);
+    tensor[1] = q.bottomRows(dl);
+    auto &next = m_tensors[m_center + 1];
+    next[0] = r * next[0];
+    next[1] = r * next[1];
+    ++m_center;
+  }
+  while (m_center > site) {
+    // Right-orthonormalize the center: [M0, M1] = L Q
+    auto &tensor = m_tensors[m_center];
+    const auto dl = tensor[0].rows();
+    const auto dr = tensor[0].cols();
+    Matrix stacked(dl, 2 * dr);
+    stacked << tensor[0], tensor[1];
+    const Matrix stackedAdj = stacked.adjoint();
+    Eigen::HouseholderQR<Matrix> qr(stackedAdj);
+    const auto k = std::min(2 * dr, dl);
+    const Matrix q = qr.householderQ() * Matrix::Identity(2 * dr, k);
+    const Matrix l = stacked * q;
+    const Matrix qAdj = q.adjoint();
+    tensor[0] = qAdj.leftCols(dr);
+    tensor[1] = qAdj.rightCols(dr);
+    auto &prev = m_tensors[m_center - 1];
+    prev[0] = prev[0] * l;
+    prev[1] = prev[1] * l;
+    --m_center;
+  }
+}
+
+void MpsState::applyAdjacent(std::size_t site, const Matrix4 &gate) {
+  if (m_center != site && m_center != site + 1) {
+    moveCenter(site);
+  }
+  auto &left = m_tensors[site];
+  auto &right = m_tensors[site + 1];
+  const auto dl = left[0].rows();
+  const auto dr = right[0].cols();
+
+  // Two-site tensor Theta[s1, s2] = M_site[s1] * M_site+1[s2]
+  std::array<Matrix, 4> theta;
+  for (int s1 = 0; s1 < 2; ++s1) {
+    for (int s2 = 0; s2 < 2; ++s2) {
+      theta[2 * s1 + s2] = left[s1] * right[s2];
+    }
+  }
+  Matrix big = Matrix::Zero(2 * dl, 2 * dr);
+  for (int out = 0; out < 4; ++out) {
+    auto block = big.block((out / 2) * dl, (out % 2) * dr, dl, dr);
+    for (int in = 0; in < 4; ++in) {
+      if (gate(out, in) != 0.0) {
+        block += gate(out, in) * theta[in];
+      }
+    }
+  }
+
+  Eigen::BDCSVD<Matrix> svd(big, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  const auto &singularValues = svd.singularValues();
+  const double totalWeight = singularValues.squaredNorm();
+  // Smallest rank whose discarded weight is within the threshold
+  Eigen::Index rank = singularValues.size();
+  double discarded = 0.0;
+  while (rank > 1) {
+    const double w =
+        singularValues(rank - 1) * singularValues(rank - 1) / totalWeight;
+    if (discarded + w > m_truncationThreshold) {
+      break;
+    }
+    discarded += w;
+    --rank;
+  }
+  if (m_maxBondDim > 0 && rank > m_maxBondDim) {
+    for (Eigen::Index i = m_maxBondDim; i < rank; ++i) {
+      discarded +=
+          singularValues(i) * singularValues(i) / totalWeight;
+    }
+    rank = m_maxBondDim;
+  }
+  m_truncationError += discarded;
+
+  // Renormalize the kept spectrum and absorb it to the right:
+  // the orthogonality center moves to site + 1.
+  const Eigen::VectorXd kept =
+      singularValues.head(rank) / singularValues.head(rank).norm();
+  const Matrix u = svd.matrixU().leftCols(rank);
+  const Matrix sv = kept.asDiagonal() * svd.matrixV().leftCols(rank).adjoint();
+  left[0] = u.topRows(dl);
+  left[1] = u.bottomRows(dl);
+  right[0] = sv.leftCols(dr);
+  right[1] = sv.rightCols(dr);
+  m_center = site + 1;
+}
+
+bool MpsState::measure(std::size_t q, double rand) {
+  const auto site = m_siteOf[q];
+  moveCenter(site);
+  auto &tensor = m_tensors[site];
+  const double p0 = tensor[0].squaredNorm();
+  const double p1 = tensor[1].squaredNorm();
+  const bool result = rand * (p0 + p1) >= p0;
+  const double norm = std::sqrt(result ? p1 : p0);
+  tensor[result ? 0 : 1].setZero();
+  tensor[result ? 1 : 0] /= norm;
+  return result;
+}
+
+void MpsState::reset(std::size_t q, double rand) {
+  if (measure(q, rand)) {
+    auto &tensor = m_tensors[m_siteOf[q]];
+    std::swap(tensor[0], tensor[1]);
+  }
+}
+
+std::vector<std::vector<bool>>
+MpsState::sample(const std::vector<std::size_t> &qubits, int nShots,
+                 std::mt19937_64 &rng) {
+  std::vector<std::vector<bool>> samples;
+  if (qubits.empty()) {
+    return samples;
+  }
+  // All sites right of the first one are right-canonical.
+  moveCenter(0);
+  std::size_t lastSite = 0;
+  for (const auto &q : qubits) {
+    lastSite = std::max(lastSite, m_siteOf[q]);
+  }
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  samples.reserve(nShots);
+  std::vector<bool> siteBits(lastSite + 1);
+  Eigen::RowVectorXcd env, v0, v1;
+  for (int shot = 0; shot < nShots; ++shot) {
+    env = Eigen::RowVectorXcd::Ones(1);
+    for (std::size_t site = 0; site <= lastSite; ++site) {
+      v0 = env * m_tensors[site][0];
+      v1 = env * m_tensors[site][1];
+      const double p0 = v0.squaredNorm();
+      const double p1 = v1.squaredNorm();
+      const bool bit = dist(rng) * (p0 + p1) >= p0;
+      siteBits[site] = bit;
+      env = bit ? v1 / std::sqrt(p1) : v0 / std::sqrt(p0);
+    }
+    std::vector<bool> bits(qubits.size());
+    for (std::size_t i = 0; i < qubits.size(); ++i) {
+      bits[i] = siteBits[m_siteOf[qubits[i]]];
+    }
+    samples.emplace_back(std::move(bits));
+  }
+  return samples;
+}
+
+double MpsState::expectation(const std::map<std::size_t, char> &pauli) const {
+  if (pauli.empty()) {
+    return 1.0;
+  }
+  std::map<std::size_t, Eigen::Matrix2cd> ops;
+  std::size_t first = m_center;
+  std::size_t last = m_center;
+  for (const auto &[q, p] : pauli) {
+    const auto site = m_siteOf[q];
+    ops.emplace(site, pauliMatrix(p));
+    first = std::min(first, site);
+    last = std::max(last, site);
+  }
+
+  // Left-canonical sites before 'first' contract to the identity, and so do
+  // right-canonical sites after 'last'.
+  Matrix env = Matrix::Identity(m_tensors[first][0].rows(),
+                                m_tensors[first][0].rows());
+  for (std::size_t site = first; site <= last; ++site) {
+    const auto &tensor = m_tensors[site];
+    const auto iter = ops.find(site);
+    Matrix next = Matrix::Zero(tensor[0].cols(), tensor[0].cols());
+    if (iter == ops.end()) {
+      for (int s = 0; s < 2; ++s) {
+        next += tensor[s].adjoint() * env * tensor[s];
+      }
+    } else {
+      const auto &op = iter->second;
+      for (int s = 0; s < 2; ++s) {
+        for (int t = 0; t < 2; ++t) {
+          if (op(s, t) != 0.0) {
+            next += op(s, t) * (tensor[s].adjoint() * env * tensor[t]);
+          }
+        }
+      }
+    }
+    env = std::move(next);
+  }
+  return env.trace().real();
+}
+
+int MpsState::maxBondDimension() const {
+  Eigen::Index maxDim = 1;
+  for (const auto &tensor : m_tensors) {
+    maxDim = std::max(maxDim, tensor[0].cols());
+  }
+  return maxDim;
+}
+} // namespace mps
+} // namespace quantum
+} // namespace xacc
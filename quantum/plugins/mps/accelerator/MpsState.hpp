@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include <Eigen/Dense>
+#include <array>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace xacc {
+namespace quantum {
+namespace mps {
+// Matrix product state in mixed-canonical form.
+// Each site tensor is stored as two (left bond x right bond) matrices, one
+// per physical index. Sites left of the orthogonality center are
+// left-canonical, sites to the right are right-canonical.
+// Qubits are mapped to sites through a permutation that is updated when
+// SWAPs are used to route non-adjacent two-qubit gates, i.e. qubits are not
+// swapped back after the gate.
+class MpsState {
+public:
+  using Matrix = Eigen::MatrixXcd;
+  using Matrix2 = Eigen::Matrix2cd;
+  using Matrix4 = Eigen::Matrix4cd;
+
+  // maxBondDim = 0: no limit.
+  // truncationThreshold: max. discarded weight (sum of squared normalized
+  // singular values) per two-site update.
+  MpsState(std::size_t nQubits, int maxBondDim = 0,
+           double truncationThreshold = 1e-16);
+
+  std::size_t nQubits() const { return m_qubitAt.size(); }
+
+  // Single-qubit gate
+  void apply(std::size_t q, const Matrix2 &gate);
+  // Two-qubit gate, matrix in the |q1 q2> basis (q1 is the high bit).
+  void apply(std::size_t q1, std::size_t q2, const Matrix4 &gate);
+  // Projective Z measurement; 'rand' is a uniform random number in [0, 1).
+  bool measure(std::size_t q, double rand);
+  void reset(std::size_t q, double rand);
+
+  // Perfect sampling (Ferris & Vidal, PRB 85, 165146): each shot is drawn
+  // site-by-site from the exact conditional distributions, without
+  // modifying the state.
+  std::vector<std::vector<bool>> sample(const std::vector<std::size_t> &qubits,
+                                        int nShots, std::mt19937_64 &rng);
+
+  // Expectation value of a Pauli string (qubit -> 'X', 'Y' or 'Z') by
+  // contracting the transfer matrices of the sites between the support and
+  // the orthogonality center (no MPO is constructed).
+  double expectation(const std::map<std::size_t, char> &pauli) const;
+
+  // Accumulated discarded weight of all truncations.
+  double truncationError() const { return m_truncationError; }
+  // Largest bond dimension of the current state.
+  int maxBondDimension() const;
+
+private:
+  void moveCenter(std::size_t site);
+  // Apply a two-site gate on sites (site, site + 1).
+  void applyAdjacent(std::size_t site, const Matrix4 &gate);
+  void swapSites(std::size_t site);
+
+  std::vector<std::array<Matrix, 2>> m_tensors;
+  std::vector<std::size_t> m_siteOf;
+  std::vector<std::size_t> m_qubitAt;
+  std::size_t m_center = 0;
+  int m_maxBondDim;
+  double m_truncationThreshold;
+  double m_truncationError = 0.0;
+};
+} // namespace mps
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include "xacc_observable.hpp"
+#include "Optimizer.hpp"
+#include "Algorithm.hpp"
+
+TEST(MpsAcceleratorTester, testBell) {
+  auto accelerator =
+      xacc::getAccelerator("mps", {{"shots", 8192}, {"seed", 42}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void mps_bell(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, program);
+  buffer->print();
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(4096, counts.at("00"), 300);
+  EXPECT_NEAR(4096, counts.at("11"), 300);
+  EXPECT_NEAR(0.0, (*buffer)["mps-truncation-error"].as<double>(), 1e-12);
+  EXPECT_EQ(2, (*buffer)["mps-max-bond-dim"].as<int>());
+}
+
+TEST(MpsAcceleratorTester, testNonAdjacent) {
+  // Long-range CNOTs are routed with swaps: q[0] -> q[4] -> q[2]
+  auto accelerator = xacc::getAccelerator("mps", {{"shots", 1000}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void mps_nonadj(qbit q) {
+      X(q[0]);
+      CX(q[0], q[4]);
+      CX(q[4], q[2]);
+      Measure(q[0]);
+      Measure(q[1]);
+      Measure(q[2]);
+      Measure(q[3]);
+      Measure(q[4]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(5);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(1, counts.size());
+  EXPECT_EQ(1000, counts.at("10101"));
+}
+
+TEST(MpsAcceleratorTester, testLargeGHZ) {
+  const int nQubits = 100;
+  auto accelerator =
+      xacc::getAccelerator("mps", {{"shots", 1024}, {"seed", 1}});
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("mps_ghz");
+  program->addInstruction(provider->createInstruction("H", {0}));
+  for (std::size_t i = 0; i + 1 < nQubits; ++i) {
+    program->addInstruction(provider->createInstruction("CNOT", {i, i + 1}));
+  }
+  for (std::size_t i = 0; i < nQubits; ++i) {
+    program->addInstruction(provider->createInstruction("Measure", {i}));
+  }
+  auto buffer = xacc::qalloc(nQubits);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_EQ(1024, counts.at(std::string(nQubits, '0')) +
+                      counts.at(std::string(nQubits, '1')));
+  EXPECT_EQ(2, (*buffer)["mps-max-bond-dim"].as<int>());
+}
+
+TEST(MpsAcceleratorTester, testMidCircuitReset) {
+  auto accelerator =
+      xacc::getAccelerator("mps", {{"shots", 2048}, {"seed", 7}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void mps_reset(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Reset(q[0]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(1024, counts.at("00"), 150);
+  EXPECT_NEAR(1024, counts.at("01"), 150);
+}
+
+TEST(MpsAcceleratorTester, testTruncation) {
+  // Random brickwork circuit: capping the bond dimension must be reported.
+  const int nQubits = 10;
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("mps_brickwork");
+  for (int layer = 0; layer < 8; ++layer) {
+    for (std::size_t i = 0; i < nQubits; ++i) {
+      program->addInstruction(provider->createInstruction(
+          "U", {i}, {0.3 * (i + 1), 0.7 * layer, 0.1 * i * layer}));
+    }
+    for (std::size_t i = layer % 2; i + 1 < nQubits; i += 2) {
+      program->addInstruction(provider->createInstruction("CNOT", {i, i + 1}));
+    }
+  }
+  program->addInstruction(provider->createInstruction("Measure", {0}));
+  program->addInstruction(provider->createInstruction("Measure", {5}));
+
+  auto exact = xacc::getAccelerator("mps");
+  auto bufferExact = xacc::qalloc(nQubits);
+  exact->execute(bufferExact, program);
+  auto qpp = xacc::getAccelerator("qpp");
+  auto bufferQpp = xacc::qalloc(nQubits);
+  qpp->execute(bufferQpp, program);
+  EXPECT_NEAR(bufferQpp->getExpectationValueZ(),
+              bufferExact->getExpectationValueZ(), 1e-9);
+
+  auto capped = xacc::getAccelerator("mps", {{"max-bond-dim", 2}});
+  auto bufferCapped = xacc::qalloc(nQubits);
+  capped->execute(bufferCapped, program);
+  EXPECT_EQ(2, (*bufferCapped)["mps-max-bond-dim"].as<int>());
+  EXPECT_GT((*bufferCapped)["mps-truncation-error"].as<double>(), 0.0);
+}
+
+TEST(MpsAcceleratorTester, testDeuteronH2) {
+  auto accelerator = xacc::getAccelerator("mps");
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void mps_ansatz(qbit q, double t) {
+      X(q[0]);
+      Ry(q[1], t);
+      CX(q[1], q[0]);
+    })",
+                                  accelerator);
+  auto program = ir->getComposite("mps_ansatz");
+  auto H_N_2 = xacc::quantum::getObservable(
+      "pauli", std::string("5.907 - 2.1433 X0X1 "
+                           "- 2.1433 Y0Y1"
+                           "+ .21829 Z0 - 6.125 Z1"));
+  auto optimizer = xacc::getOptimizer("nlopt");
+  auto vqe = xacc::getAlgorithm("vqe");
+  vqe->initialize({std::make_pair("ansatz", program),
+                   std::make_pair("observable", H_N_2),
+                   std::make_pair("accelerator", accelerator),
+                   std::make_pair("optimizer", optimizer)});
+  auto buffer = xacc::qalloc(2);
+  vqe->execute(buffer);
+  EXPECT_NEAR((*buffer)["opt-val"].as<double>(), -1.74886, 1e-4);
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -2,12 +2,14 @@
 
 #include <armadillo>
 #include <iomanip>
+#include <algorithm>
 
 #include "FermionOperator.hpp"
 #include "xacc_observable.hpp"
 #include "xacc_plugin.hpp"
 #include "xacc_service.hpp"
 #include "xacc.hpp"
+#include "ThreadPool.hpp"
 
 namespace xacc {
 
@@ -17,6 +19,28 @@ bool ptr_is_a(std::shared_ptr<Observable> ptr) {
 }
 std::shared_ptr<xacc::Observable> QubitTapering::transform(
     std::shared_ptr<xacc::Observable> Hptr_input) {
+  auto allSectors = sectors(Hptr_input);
+
+  // Keep the minimizing sector
+  auto best = std::min_element(allSectors.begin(), allSectors.end(),
+                               [](const auto &a, const auto &b) {
+                                 return a.groundStateEnergy <
+                                        b.groundStateEnergy;
+                               });
+  if (best == allSectors.end()) {
+    return std::make_shared<PauliOperator>();
+  }
+
+  std::stringstream s;
+  s << std::setprecision(12) << best->groundStateEnergy;
+  xacc::info("Reduced Hamiltonian:" + best->reduced->toString() +
+             ", with energy = " + s.str());
+
+  return best->reduced;
+}
+
+std::vector<QubitTapering::TaperedSector>
+QubitTapering::sectors(std::shared_ptr<xacc::Observable> Hptr_input) {
 
   // First we pre-process the observable to a PauliOperator
   auto obs_str = Hptr_input->toString();
@@ -192,12 +216,17 @@ std::shared_ptr<xacc::Observable> QubitTapering::transform(
         return;
       });
 
-  // Create the reduced hamiltonian
+  std::map<int, int> keepSites2Logical;
+  counter = 0;
+  for (auto &i : keep_sites) {
+    keepSites2Logical.insert({i, counter});
+    counter++;
+  }
+
+  // Create the reduced hamiltonian of each sector
   // by mapping operators on unused qubits to
   // +-1 subspace
-  auto actualReduced = std::make_shared<PauliOperator>();
-  //   PauliOperator& actualReduced = *actualReduced_ptr.get();
-  double energy = 0.0;
+  std::vector<TaperedSector> result;
   for (auto &phases : phase_configs) {
     counter = 0;
     std::map<int, int> Z2_dict;
@@ -230,44 +259,29 @@ std::shared_ptr<xacc::Observable> QubitTapering::transform(
       }
     }
 
-    // Get the ground state energy to check if this is the
-    // minimizing sector
-    auto reducedEnergy = computeGroundStateEnergy(reduced, n);
-    if (reducedEnergy < energy) {
-      energy = reducedEnergy;
-      actualReduced = reduced_ptr;
-    }
+    result.push_back({phases, reduced_ptr, 0.0});
   }
 
-  counter = 0;
-  std::map<int, int> keepSites2Logical;
-  for (auto &i : keep_sites) {
-    keepSites2Logical.insert({i, counter});
-    counter++;
+  // The sectors are independent: map each one to the logical qubits
+  // and compute its ground state energy concurrently. Mapping first
+  // drops the tapered (identity) qubits from the eigen-solve.
+  {
+    ThreadPool pool;
+    std::vector<std::future<void>> tasks;
+    for (auto &sector : result) {
+      tasks.emplace_back(pool.enqueue([&, this]() {
+        auto siteMap = keepSites2Logical;
+        sector.reduced->mapQubitSites(siteMap);
+        sector.groundStateEnergy =
+            computeGroundStateEnergy(*sector.reduced, keep_sites.size());
+      }));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
   }
 
-  actualReduced->mapQubitSites(keepSites2Logical);
-
-  std::stringstream s;
-  s << std::setprecision(12) << energy;
-  std::cout << "Reduced Hamiltonian:" << actualReduced->toString()
-            << ", with energy = " << s.str() << "\n";
-
-  return actualReduced;
-
-  //   auto newIR = actualReduced.toXACCIR();
-
-  //   // See if we have an ansatz and if so grab
-  //   // it and add it to the reduced IR
-  //   auto ansatz = std::dynamic_pointer_cast<Function>(
-  //       ir->getKernels()[0]->getInstruction(0));
-  //   if (ansatz) {
-  //     for (auto &k : newIR->getKernels()) {
-  //       k->insertInstruction(0, ansatz);
-  //     }
-  //   }
-
-  //   return newIR;
+  return result;
 }
 
 const double QubitTapering::computeGroundStateEnergy(PauliOperator &op,
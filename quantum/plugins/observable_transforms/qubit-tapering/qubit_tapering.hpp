@@ -11,9 +11,20 @@ namespace xacc {
 
 class QubitTapering : public xacc::ObservableTransform {
  public:
+  // A +-1 symmetry sector of the tapered Hamiltonian,
+  // the reduced operator acts on the kept (logical) qubits.
+  struct TaperedSector {
+    std::vector<int> phases;
+    std::shared_ptr<PauliOperator> reduced;
+    double groundStateEnergy;
+  };
+
   QubitTapering() = default;
   std::shared_ptr<xacc::Observable> transform(
       std::shared_ptr<xacc::Observable> obs) override;
+  // All the sectors, with their exact ground state energies
+  // (evaluated concurrently), e.g. to seed an ensemble of sector VQEs.
+  std::vector<TaperedSector> sectors(std::shared_ptr<xacc::Observable> obs);
 
   const std::string name() const override { return "qubit-tapering"; }
   const std::string description() const override {
@@ -18,6 +18,7 @@
 #include "xacc_observable.hpp"
 #include "xacc_service.hpp"
 #include "ObservableTransform.hpp"
+#include "qubit_tapering.hpp"
 
 auto str = std::string(
     "(-0.165606823582,-0)  1^ 2^ 1 2 + (0.120200490713,0)  1^ 0^ 0 1 + "
@@ -61,6 +62,51 @@ TEST(QubitTaperingTester, checkH2) {
   EXPECT_TRUE(test == expected);
 }
 
+TEST(QubitTaperingTester, checkSectors) {
+  auto H_vqe = xacc::quantum::getObservable("fermion", str);
+
+  auto transformation = std::dynamic_pointer_cast<xacc::QubitTapering>(
+      xacc::getService<xacc::ObservableTransform>("qubit-tapering"));
+  auto sectors = transformation->sectors(H_vqe);
+  EXPECT_FALSE(sectors.empty());
+
+  double minEnergy = 0.0;
+  for (auto &sector : sectors) {
+    // Mapped to the single kept qubit
+    EXPECT_LE(sector.reduced->nQubits(), 1);
+    minEnergy = std::min(minEnergy, sector.groundStateEnergy);
+  }
+  EXPECT_NEAR(-1.13717, minEnergy, 1e-4);
+}
+
+TEST(QubitTaperingTester, checkMinimumSector) {
+  // Shifted so that every sector has a positive ground state energy:
+  // transform() still keeps the minimizing one.
+  auto H_vqe = xacc::quantum::getObservable("fermion", str);
+  auto H_pauli = xacc::getService<xacc::ObservableTransform>("jw")->transform(H_vqe);
+  auto shifted = std::make_shared<xacc::quantum::PauliOperator>(
+      dynamic_cast<xacc::quantum::PauliOperator &>(*H_pauli) +
+      xacc::quantum::PauliOperator(5.0));
+
+  auto transformation = std::dynamic_pointer_cast<xacc::QubitTapering>(
+      xacc::getService<xacc::ObservableTransform>("qubit-tapering"));
+  auto sectors = transformation->sectors(shifted);
+  EXPECT_GT(sectors.size(), 1);
+  auto best = sectors.begin();
+  for (auto it = sectors.begin(); it != sectors.end(); ++it) {
+    EXPECT_GT(it->groundStateEnergy, 0.0);
+    if (it->groundStateEnergy < best->groundStateEnergy) {
+      best = it;
+    }
+  }
+  EXPECT_NEAR(5.0 - 1.13717, best->groundStateEnergy, 1e-4);
+
+  auto transformed = transformation->transform(shifted);
+  xacc::quantum::PauliOperator test =
+      dynamic_cast<xacc::quantum::PauliOperator &>(*transformed.get());
+  EXPECT_TRUE(test == *best->reduced);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,7 @@
 #include "GOAT.hpp"
 #include <iostream>
+#include <algorithm>
+#include <sstream>
 #include "LBFGS.h"
 #include "xacc_service.hpp"
 #include "xacc_observable.hpp"
@@ -149,7 +151,8 @@ Matrix GOAT_PulseOptim::constructMatrixFromPauliString(const std::string& in_pau
     return coefficient * result;
 }
 
-void GoatHamiltonian::construct(int in_dimension, const std::string& in_H0, const std::vector<std::string>& in_Hi, const std::vector<std::string>& in_fi, const std::vector<std::string>& in_params)
+void GoatHamiltonian::construct(int in_dimension, const std::string& in_H0, const std::vector<std::string>& in_Hi, const std::vector<std::string>& in_fi, const std::vector<std::string>& in_params,
+    propagation::ControlHamiltonian::Storage in_storage)
 {
     if (!in_H0.empty())
     {
@@ -165,6 +168,13 @@ void GoatHamiltonian::construct(int in_dimension, const std::string& in_H0, cons
         hamOps.emplace_back(std::make_pair(in_fi[i], GOAT_PulseOptim::constructMatrixFromPauliString(in_Hi[i], in_dimension)));
     }
 
+    std::vector<Matrix> ops;
+    for (const auto& hamOp : hamOps)
+    {
+        ops.emplace_back(hamOp.second);
+    }
+    controlHamiltonian = std::make_unique<propagation::ControlHamiltonian>(m_h0, ops, in_storage);
+
     m_paramVals.resize(in_params.size());
     for (int i = 0; i < in_params.size(); ++i)
     {
@@ -173,6 +183,11 @@ void GoatHamiltonian::construct(int in_dimension, const std::string& in_H0, cons
     // Add time variable
     m_symbolTable.add_variable("t", m_time);
 
+    const auto toLower = [](std::string in_str) {
+        std::transform(in_str.begin(), in_str.end(), in_str.begin(), ::tolower);
+        return in_str;
+    };
+
     for (int i = 0; i < hamOps.size(); ++i)
     {
         expression_t expression;
@@ -181,50 +196,75 @@ void GoatHamiltonian::construct(int in_dimension, const std::string& in_H0, cons
         assert(compileOk);
         // Cache the compiled expressions
         m_exprs.emplace_back(std::move(expression));
+
+        // Params that this expression depends on (ExprTk symbols are case-insensitive)
+        std::vector<std::string> variables;
+        const bool collectOk = exprtk::collect_variables(hamOps[i].first, variables);
+        std::vector<int> dependencies;
+        for (int idx = 0; idx < in_params.size(); ++idx)
+        {
+            const bool isUsed = !collectOk || std::any_of(variables.begin(), variables.end(), [&](const std::string& in_var) {
+                return toLower(in_var) == toLower(in_params[idx]);
+            });
+            if (isUsed)
+            {
+                dependencies.emplace_back(idx);
+            }
+        }
+        m_dependencies.emplace_back(std::move(dependencies));
     }
 
     params = in_params;
     dimension = in_dimension;
+    m_cacheValid = false;
     hamiltonian = [this](double in_time, OptimParams in_paramVals) -> Matrix {      
         assert(in_paramVals.size() == params.size());
-       
-        Matrix hamMat = m_h0;
-        for (int i = 0; i < hamOps.size(); ++i)
-        {
-            const auto& expression = m_exprs[i];
-            // Set the variables before evaluation
-            m_paramVals = in_paramVals;
-            m_time = in_time;
-            const auto evaled = expression.value();
-            hamMat = hamMat + evaled * hamOps[i].second;
-        }
-        
-        return hamMat;
+        std::vector<double> values;
+        std::vector<std::vector<double>> grads;
+        evaluate(in_time, in_paramVals, values, grads);
+        return controlHamiltonian->combine(1.0, values);
     };
 
-
     for (int idx = 0; idx < params.size(); ++idx)
     {
         // Differential of H w.r.t. sigma parameter
         dHda.emplace_back([this, idx](double in_time, OptimParams in_paramVals) -> Matrix {
             assert(in_paramVals.size() == params.size());
-            Matrix hamMat = Matrix::Zero(1 << dimension, 1 << dimension);
-            for (int i = 0; i < hamOps.size(); ++i)
+            std::vector<double> values;
+            std::vector<std::vector<double>> grads;
+            evaluate(in_time, in_paramVals, values, grads);
+            return controlHamiltonian->combine(0.0, grads[idx]);
+        });
+    }
+
+    assert(dHda.size() == params.size());
+}
+
+void GoatHamiltonian::evaluate(double in_time, const OptimParams& in_params, std::vector<double>& out_values, std::vector<std::vector<double>>& out_grads)
+{
+    assert(in_params.size() == params.size());
+    if (!m_cacheValid || in_time != m_time || !std::equal(in_params.begin(), in_params.end(), m_paramVals.begin()))
+    {
+        // Set the variables before evaluation
+        // Note: copy in place, the symbol table refers to the elements of m_paramVals.
+        std::copy(in_params.begin(), in_params.end(), m_paramVals.begin());
+        m_time = in_time;
+        m_cachedValues.resize(m_exprs.size());
+        m_cachedGrads.assign(params.size(), std::vector<double>(m_exprs.size(), 0.0));
+        for (int i = 0; i < m_exprs.size(); ++i)
+        {
+            m_cachedValues[i] = m_exprs[i].value();
+            for (const auto& idx : m_dependencies[i])
             {
-                const auto& expression = m_exprs[i];
-                // Set the variables before evaluation
-                m_paramVals = in_paramVals;
-                m_time = in_time;
                 // Calculate the derivative w.r.t. the parameter
-                const auto derivativeEvaled = exprtk::derivative(expression, params[idx]);
-                hamMat = hamMat + derivativeEvaled * hamOps[i].second;
+                m_cachedGrads[idx][i] = exprtk::derivative(m_exprs[i], m_paramVals[idx]);
             }
-            
-            return hamMat;
-        });
+        }
+        m_cacheValid = true;
     }
 
-    assert(dHda.size() == params.size());
+    out_values = m_cachedValues;
+    out_grads = m_cachedGrads;
 }
 
 GOAT_PulseOptim::GOAT_PulseOptim(const Matrix& in_targetU, const Hamiltonian& in_hamiltonian, const dHdalpha& in_dHda, 
@@ -403,6 +443,17 @@ Matrix GOAT_PulseOptim::DefaultIntegrator::integrate(const Hamiltonian& in_hamil
     return result;
 }
 
+GOAT_PulseOptim::PropagatorIntegrator::PropagatorIntegrator(GoatHamiltonian& in_hamiltonian, std::unique_ptr<propagation::IPropagator>&& io_propagator):
+    m_hamiltonian(in_hamiltonian),
+    m_propagator(std::move(io_propagator))
+{}
+
+Matrix GOAT_PulseOptim::PropagatorIntegrator::integrate(const Hamiltonian& in_hamiltonian, const dHdalpha& in_dHda, const OptimParams& in_params, double in_stopTime)
+{
+    assert(in_dHda.size() == m_hamiltonian.nbParams());
+    return m_propagator->propagate(*m_hamiltonian.controlHamiltonian, m_hamiltonian, in_params, in_stopTime);
+}
+
 void GOAT_PulseOptim::DefaultGradientStepper::optimize(xacc::OptFunction* io_problem, const OptimParams& in_initialParams) 
 {
     // TODO: get rid of this Default Stepper.
@@ -478,6 +529,20 @@ void GOAT_PulseOptim::MLPackGradientStepper::optimize(xacc::OptFunction* io_prob
 // - Required: { "max-time" : double }: max control time horizon
 //
 // - Optional: { "optimizer" : string }: can be "ml-pack" or "default"
+//
+// - Optional: { "integrator" : string }: propagator of the equations of motion
+//  "rk45" (default): adaptive-step Dormand-Prince Runge-Kutta
+//  "rk4": fixed-step Runge-Kutta
+//  "magnus": fixed-step 4th-order Magnus expansion
+//
+// - Optional: { "integrator-rtol" : double, "integrator-atol" : double }: error tolerances (rk45)
+//  defaults: 1e-8 and 1e-10
+//
+// - Optional: { "integrator-steps" : int }: number of time steps (rk4 and magnus)
+//  defaults: 10000 (rk4) and 200 (magnus)
+//
+// - Optional: { "hamiltonian-storage" : string }: "auto" (default), "dense" or "sparse"
+//  "auto" uses sparse operators when there are only a few sparse Hamiltonian terms.
 void PulseOptimGOAT::setOptions(const HeterogeneousMap& in_options)
 {   
     const auto fatalError = [](const std::string& in_fieldName){
@@ -605,6 +670,65 @@ void PulseOptimGOAT::setOptions(const HeterogeneousMap& in_options)
         return;
     }
     
+    std::string integrator = "rk45";
+    if (in_options.stringExists("integrator")) 
+    {
+        integrator = in_options.getString("integrator");
+    }
+
+    if (integrator != "rk45" && integrator != "rk4" && integrator != "magnus")
+    {
+        xacc::error("Invalid integrator '" + integrator + "'. Valid values are 'rk45', 'rk4' and 'magnus'.");
+        return;
+    }
+
+    double rtol = 1e-8;
+    if (in_options.keyExists<double>("integrator-rtol")) 
+    {
+        rtol = in_options.get<double>("integrator-rtol");
+    }
+
+    double atol = 1e-10;
+    if (in_options.keyExists<double>("integrator-atol")) 
+    {
+        atol = in_options.get<double>("integrator-atol");
+    }
+
+    if (rtol <= 0.0 || atol <= 0.0)
+    {
+        xacc::error("Invalid integrator tolerances.");
+        return;
+    }
+
+    int nbSteps = (integrator == "magnus") ? 200 : DEFAULT_NUMBER_STEPS;
+    if (in_options.keyExists<int>("integrator-steps")) 
+    {
+        nbSteps = in_options.get<int>("integrator-steps");
+    }
+
+    if (nbSteps < 1)
+    {
+        xacc::error("Invalid 'integrator-steps' parameter.");
+        return;
+    }
+
+    std::string storageName = "auto";
+    if (in_options.stringExists("hamiltonian-storage")) 
+    {
+        storageName = in_options.getString("hamiltonian-storage");
+    }
+
+    const std::unordered_map<std::string, propagation::ControlHamiltonian::Storage> storageTypes {
+        { "auto", propagation::ControlHamiltonian::Storage::Auto },
+        { "dense", propagation::ControlHamiltonian::Storage::Dense },
+        { "sparse", propagation::ControlHamiltonian::Storage::Sparse }
+    };
+    if (storageTypes.find(storageName) == storageTypes.end())
+    {
+        xacc::error("Invalid 'hamiltonian-storage' parameter.");
+        return;
+    }
+
     std::unique_ptr<IGradientStepper> gradientOptimizer = [](const std::string& in_optimizerName) -> std::unique_ptr<IGradientStepper> {
         if (in_optimizerName == "ml-pack") 
         {
@@ -615,10 +739,45 @@ void PulseOptimGOAT::setOptions(const HeterogeneousMap& in_options)
     }(optimizer);
 
     // We have a valid set of paramters here.
-    m_hamiltonian = std::make_unique<GoatHamiltonian>();
-    m_hamiltonian->construct(dimension, H0, controlOps, controlFuncs, controlParams);
+    // Compiling the control function expressions is expensive:
+    // reuse the existing Hamiltonian if it is the same one.
+    std::stringstream hamiltonianKey;
+    hamiltonianKey << dimension << "|" << H0 << "|" << storageName;
+    for (int i = 0; i < controlOps.size(); ++i)
+    {
+        hamiltonianKey << "|" << controlOps[i] << ":" << controlFuncs[i];
+    }
+    for (const auto& param : controlParams)
+    {
+        hamiltonianKey << "|" << param;
+    }
+
+    if (!m_hamiltonian || hamiltonianKey.str() != m_hamiltonianKey)
+    {
+        // Release the optimizer first: it refers to the Hamiltonian functions.
+        m_goatOptimizer.reset();
+        m_hamiltonian = std::make_unique<GoatHamiltonian>();
+        m_hamiltonian->construct(dimension, H0, controlOps, controlFuncs, controlParams, storageTypes.at(storageName));
+        m_hamiltonianKey = hamiltonianKey.str();
+    }
+
+    std::unique_ptr<propagation::IPropagator> propagator = [&]() -> std::unique_ptr<propagation::IPropagator> {
+        if (integrator == "rk4") 
+        {
+            return std::make_unique<propagation::RK4Propagator>(nbSteps);
+        }
+
+        if (integrator == "magnus") 
+        {
+            return std::make_unique<propagation::MagnusPropagator>(nbSteps);
+        }
+        
+        return std::make_unique<propagation::RK45Propagator>(rtol, atol);
+    }();
+
     // All parameters have been validated: construct the GOAT pulse optimizer
-    m_goatOptimizer = std::make_unique<GOAT_PulseOptim>(targetUmat, m_hamiltonian->hamiltonian, m_hamiltonian->dHda, initParams, tMax, nullptr, std::move(gradientOptimizer));
+    m_goatOptimizer = std::make_unique<GOAT_PulseOptim>(targetUmat, m_hamiltonian->hamiltonian, m_hamiltonian->dHda, initParams, tMax, 
+        std::make_unique<GOAT_PulseOptim::PropagatorIntegrator>(*m_hamiltonian, std::move(propagator)), std::move(gradientOptimizer));
 }
 
 OptResult PulseOptimGOAT::optimize() 
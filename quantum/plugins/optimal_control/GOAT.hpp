@@ -5,6 +5,7 @@
 #include "xacc.hpp"
 #include "exprtk.hpp"
 #include "OptimalControl.hpp"
+#include "Propagator.hpp"
 
 namespace xacc {
 using symbol_table_t = exprtk::symbol_table<double>;
@@ -46,14 +47,23 @@ struct IGradientStepper
     virtual void optimize(xacc::OptFunction* io_problem, const OptimParams& in_initialParams) = 0;
 };
 
-struct GoatHamiltonian
+// H(t) = H0 + sum_i f_i(t, params) H_i
+// The control functions f_i are ExprTk expressions, compiled once (in construct).
+// It provides both the function form (hamiltonian/dHda) and the structured form
+// (controlHamiltonian + control coefficients) used by the propagators.
+struct GoatHamiltonian : public propagation::IControlCoefficients
 {
     Hamiltonian hamiltonian;
     dHdalpha dHda;
     int dimension;
     std::vector<std::pair<std::string, Matrix>> hamOps;
     std::vector<std::string> params;
-    void construct(int in_dimension, const std::string& in_H0, const std::vector<std::string>& in_Hi, const std::vector<std::string>& in_fi, const std::vector<std::string>& in_params);
+    std::unique_ptr<propagation::ControlHamiltonian> controlHamiltonian;
+    void construct(int in_dimension, const std::string& in_H0, const std::vector<std::string>& in_Hi, const std::vector<std::string>& in_fi, const std::vector<std::string>& in_params,
+        propagation::ControlHamiltonian::Storage in_storage = propagation::ControlHamiltonian::Storage::Auto);
+    // IControlCoefficients:
+    size_t nbParams() const override { return params.size(); }
+    void evaluate(double in_time, const OptimParams& in_params, std::vector<double>& out_values, std::vector<std::vector<double>>& out_grads) override;
 private:
     // Cache of the symbol table that are used by the expressions.
     // These symbols are linked to m_paramVals and m_time.
@@ -65,6 +75,14 @@ private:
     double m_time;
     // Compiled expressions
     std::vector<expression_t> m_exprs;
+    // Indices of the params that each expression depends on
+    // (the derivatives w.r.t. other params are zero, no need to evaluate them).
+    std::vector<std::vector<int>> m_dependencies;
+    // Values and derivatives at the last evaluated (time, params):
+    // Runge-Kutta stages and the H/dHda functions evaluate the same point multiple times.
+    bool m_cacheValid = false;
+    std::vector<double> m_cachedValues;
+    std::vector<std::vector<double>> m_cachedGrads;
     Matrix m_h0;
 };
 
@@ -81,6 +99,18 @@ public:
         double m_dt;
     };
 
+    // Integrator using one of the propagators (RK4, adaptive RK45, Magnus) on the structured
+    // form of a GoatHamiltonian (the Hamiltonian functions passed to integrate must be those of in_hamiltonian).
+    struct PropagatorIntegrator : public IIntegrator
+    {
+        PropagatorIntegrator(GoatHamiltonian& in_hamiltonian, std::unique_ptr<propagation::IPropagator>&& io_propagator);
+        virtual Matrix integrate(const Hamiltonian& in_hamiltonian, const dHdalpha& in_dHda, const OptimParams& in_params, double in_stopTime) override;
+
+    private:
+        GoatHamiltonian& m_hamiltonian;
+        std::unique_ptr<propagation::IPropagator> m_propagator;
+    };
+
     struct DefaultGradientStepper : public IGradientStepper
     {
         virtual void optimize(xacc::OptFunction* io_problem, const OptimParams& in_initialParams) override;
@@ -135,6 +165,9 @@ public:
 private:
     std::unique_ptr<GOAT_PulseOptim> m_goatOptimizer;
     std::unique_ptr<GoatHamiltonian> m_hamiltonian;
+    // Description of m_hamiltonian: the compiled Hamiltonian is reused
+    // if the same one is requested again (e.g. optimizing multiple pulses).
+    std::string m_hamiltonianKey;
 };
 
 class PauliUnitaryMatrixUtil : public UnitaryMatrixUtil
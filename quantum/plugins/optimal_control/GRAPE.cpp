@@ -1,5 +1,5 @@
 #include "GRAPE.hpp"
-#include <unsupported/Eigen/MatrixFunctions>
+#include "Propagator.hpp"
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 
@@ -78,15 +78,19 @@ std::vector<std::vector<double>> GrapePulseOptim::evaluate()
         return resultMat;  
     };
 
-    std::vector<Eigen::MatrixXcd> U_list;
-    U_list.reserve(m_configs.nbSamples);
-    // Compute incremental U aling the time series
+    std::vector<Eigen::MatrixXcd> generators;
+    generators.reserve(m_configs.nbSamples);
     for (int i = 0; i < m_configs.nbSamples; ++i)
     {
         const Eigen::MatrixXcd hMat = evalHmatAtStep(i, m_configs, m_pulses.back());
-        U_list.emplace_back((-I * hMat * m_configs.dt).exp());
+        generators.emplace_back(-I * hMat * m_configs.dt);
     }
 
+    // Compute incremental U aling the time series
+    // (the slices are independent: exponentiate them as a batch, in parallel)
+    std::vector<Eigen::MatrixXcd> U_list;
+    propagation::expmBatch(generators, U_list);
+
     // Forward and backward unitary matrices
     std::vector<Eigen::MatrixXcd> U_f_list;
     std::vector<Eigen::MatrixXcd> U_b_list;
@@ -0,0 +1,471 @@
+#include "Propagator.hpp"
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+#ifdef WITH_OPENMP_
+#include <omp.h>
+#endif
+
+namespace {
+using namespace xacc::propagation;
+const std::complex<double> I(0.0, 1.0);
+
+// Pade coefficients and the max 1-norm for which each degree is accurate to double precision
+// (Higham 2005, Table 2.3)
+constexpr double PADE_3[] = { 120.0, 60.0, 12.0, 1.0 };
+constexpr double PADE_5[] = { 30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0 };
+constexpr double PADE_7[] = { 17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0 };
+constexpr double PADE_9[] = { 17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0, 2162160.0, 110880.0, 3960.0, 90.0, 1.0 };
+constexpr double PADE_13[] = { 64764752532480000.0, 32382376266240000.0, 7771770303897600.0, 1187353796428800.0,
+    129060195264000.0, 10559470521600.0, 670442572800.0, 33522128640.0, 1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0 };
+constexpr double THETA_3 = 1.495585217958292e-2;
+constexpr double THETA_5 = 2.539398330063230e-1;
+constexpr double THETA_7 = 9.504178996162932e-1;
+constexpr double THETA_9 = 2.097847961257068e0;
+constexpr double THETA_13 = 5.371920351148152e0;
+
+// Horizontal layout of the state: [U, dU_1, ..., dU_n]
+// so that H is applied to the whole state in one product.
+Matrix initialState(int in_dim, size_t in_nbParams)
+{
+    Matrix state = Matrix::Zero(in_dim, in_dim * (in_nbParams + 1));
+    state.leftCols(in_dim).setIdentity();
+    return state;
+}
+
+// Convert to the (vertical) layout expected by GOAT: U stacked on top of the dU's
+Matrix toStackedLayout(const Matrix& in_state, int in_dim)
+{
+    const auto nbBlocks = in_state.cols() / in_dim;
+    Matrix result(in_dim * nbBlocks, in_dim);
+    for (int i = 0; i < nbBlocks; ++i)
+    {
+        result.middleRows(i * in_dim, in_dim) = in_state.middleCols(i * in_dim, in_dim);
+    }
+    return result;
+}
+
+// RHS of the GOAT equations of motion
+class GoatRhs
+{
+public:
+    GoatRhs(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params):
+        m_hamiltonian(in_hamiltonian),
+        m_coeffs(in_coeffs),
+        m_params(in_params)
+    {}
+
+    void operator()(double in_time, const Matrix& in_state, Matrix& out_deriv)
+    {
+        const int dim = m_hamiltonian.dimension();
+        m_coeffs.evaluate(in_time, m_params, m_values, m_grads);
+        out_deriv.resize(in_state.rows(), in_state.cols());
+        // H * [U, dU_1, ..., dU_n]
+        m_hamiltonian.apply(1.0, m_values, in_state, out_deriv);
+        // + [0, dH/dalpha_1 * U, ..., dH/dalpha_n * U]
+        for (size_t j = 0; j < m_grads.size(); ++j)
+        {
+            m_hamiltonian.apply(0.0, m_grads[j], in_state.leftCols(dim), out_deriv.middleCols((j + 1) * dim, dim), true);
+        }
+        out_deriv *= -I;
+    }
+
+private:
+    const ControlHamiltonian& m_hamiltonian;
+    IControlCoefficients& m_coeffs;
+    const std::vector<double>& m_params;
+    std::vector<double> m_values;
+    std::vector<std::vector<double>> m_grads;
+};
+
+bool isZero(const std::vector<double>& in_coeffs)
+{
+    return std::all_of(in_coeffs.begin(), in_coeffs.end(), [](double in_val) { return in_val == 0.0; });
+}
+}
+
+namespace xacc {
+namespace propagation {
+void ExpmWorkspace::expm(const Matrix& in_mat, Matrix& out_exp)
+{
+    assert(in_mat.rows() == in_mat.cols());
+    const auto dim = in_mat.rows();
+    const double norm = in_mat.cwiseAbs().colwise().sum().maxCoeff();
+    const auto identity = Matrix::Identity(dim, dim);
+
+    const auto padeLowDegree = [&](const double* in_coeffs, int in_degree) {
+        // U = A * (sum_k b_(2k+1) A^2k), V = sum_k b_2k A^2k
+        m_a2.noalias() = in_mat * in_mat;
+        m_tmp = in_coeffs[in_degree] * m_a2 + in_coeffs[in_degree - 2] * identity;
+        m_v = in_coeffs[in_degree - 1] * m_a2 + in_coeffs[in_degree - 3] * identity;
+        for (int k = in_degree - 5; k >= 0; k -= 2)
+        {
+            // Horner scheme in A^2
+            m_u.noalias() = m_tmp * m_a2;
+            m_tmp = m_u + in_coeffs[k + 1] * identity;
+            m_u.noalias() = m_v * m_a2;
+            m_v = m_u + in_coeffs[k] * identity;
+        }
+        m_u.noalias() = in_mat * m_tmp;
+    };
+
+    int nbSquarings = 0;
+    if (norm <= THETA_3)
+    {
+        padeLowDegree(PADE_3, 3);
+    }
+    else if (norm <= THETA_5)
+    {
+        padeLowDegree(PADE_5, 5);
+    }
+    else if (norm <= THETA_7)
+    {
+        padeLowDegree(PADE_7, 7);
+    }
+    else if (norm <= THETA_9)
+    {
+        padeLowDegree(PADE_9, 9);
+    }
+    else
+    {
+        nbSquarings = std::max(0, static_cast<int>(std::ceil(std::log2(norm / THETA_13))));
+        const double scale = std::ldexp(1.0, -nbSquarings);
+        const auto& b = PADE_13;
+        m_tmp = scale * in_mat;
+        m_a2.noalias() = m_tmp * m_tmp;
+        m_a4.noalias() = m_a2 * m_a2;
+        m_a6.noalias() = m_a4 * m_a2;
+        // U = A * (A6 * (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I)
+        m_v = b[13] * m_a6 + b[11] * m_a4 + b[9] * m_a2;
+        m_u.noalias() = m_a6 * m_v;
+        m_u += b[7] * m_a6 + b[5] * m_a4 + b[3] * m_a2 + b[1] * identity;
+        m_v.noalias() = m_tmp * m_u;
+        m_u.swap(m_v);
+        // V = A6 * (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+        m_tmp = b[12] * m_a6 + b[10] * m_a4 + b[8] * m_a2;
+        m_v.noalias() = m_a6 * m_tmp;
+        m_v += b[6] * m_a6 + b[4] * m_a4 + b[2] * m_a2 + b[0] * identity;
+    }
+
+    // r = (V - U)^-1 (V + U)
+    m_tmp = m_v - m_u;
+    m_lu.compute(m_tmp);
+    m_tmp = m_v + m_u;
+    out_exp = m_lu.solve(m_tmp);
+    for (int i = 0; i < nbSquarings; ++i)
+    {
+        m_tmp.noalias() = out_exp * out_exp;
+        out_exp.swap(m_tmp);
+    }
+}
+
+Matrix expm(const Matrix& in_mat)
+{
+    ExpmWorkspace workspace;
+    Matrix result;
+    workspace.expm(in_mat, result);
+    return result;
+}
+
+void expmBatch(const std::vector<Matrix>& in_mats, std::vector<Matrix>& out_exps)
+{
+    const int nbMats = in_mats.size();
+    out_exps.resize(nbMats);
+#ifdef WITH_OPENMP_
+#pragma omp parallel if (nbMats > 1)
+    {
+        ExpmWorkspace workspace;
+#pragma omp for schedule(static)
+        for (int i = 0; i < nbMats; ++i)
+        {
+            workspace.expm(in_mats[i], out_exps[i]);
+        }
+    }
+#else
+    ExpmWorkspace workspace;
+    for (int i = 0; i < nbMats; ++i)
+    {
+        workspace.expm(in_mats[i], out_exps[i]);
+    }
+#endif
+}
+
+ControlHamiltonian::ControlHamiltonian(const Matrix& in_h0, const std::vector<Matrix>& in_ops, Storage in_storage):
+    m_dim(in_h0.rows()),
+    m_sparse(false),
+    m_hasH0(!in_h0.isZero(0.0)),
+    m_h0(in_h0),
+    m_ops(in_ops)
+{
+    assert(in_h0.rows() == in_h0.cols());
+    if (in_storage == Storage::Auto && in_ops.size() <= MAX_SPARSE_TERMS && m_dim >= MIN_SPARSE_DIMENSION)
+    {
+        const auto countNonZeros = [](const Matrix& in_mat) {
+            return (in_mat.array() != std::complex<double>(0.0, 0.0)).count();
+        };
+
+        double nnz = countNonZeros(in_h0);
+        for (const auto& op : in_ops)
+        {
+            nnz += countNonZeros(op);
+        }
+        m_sparse = nnz / (static_cast<double>(m_dim) * m_dim) <= MAX_SPARSE_DENSITY;
+    }
+    else
+    {
+        m_sparse = (in_storage == Storage::Sparse);
+    }
+
+    if (m_sparse)
+    {
+        m_h0Sparse = in_h0.sparseView();
+        for (const auto& op : in_ops)
+        {
+            assert(op.rows() == m_dim && op.cols() == m_dim);
+            m_opsSparse.emplace_back(op.sparseView());
+        }
+    }
+}
+
+Matrix ControlHamiltonian::combine(double in_h0Weight, const std::vector<double>& in_coeffs) const
+{
+    assert(in_coeffs.size() == m_ops.size());
+    Matrix result = in_h0Weight * m_h0;
+    for (size_t k = 0; k < m_ops.size(); ++k)
+    {
+        if (in_coeffs[k] != 0.0)
+        {
+            result += in_coeffs[k] * m_ops[k];
+        }
+    }
+    return result;
+}
+
+void ControlHamiltonian::apply(double in_h0Weight, const std::vector<double>& in_coeffs, const Eigen::Ref<const Matrix>& in_mat, Eigen::Ref<Matrix> out_mat, bool in_accumulate) const
+{
+    assert(in_coeffs.size() == m_ops.size());
+    if (!in_accumulate)
+    {
+        out_mat.setZero();
+    }
+
+    if ((in_h0Weight == 0.0 || !m_hasH0) && isZero(in_coeffs))
+    {
+        return;
+    }
+
+    if (!m_sparse)
+    {
+        out_mat.noalias() += combine(in_h0Weight, in_coeffs) * in_mat;
+        return;
+    }
+
+    if (in_h0Weight != 0.0 && m_hasH0)
+    {
+        out_mat.noalias() += in_h0Weight * (m_h0Sparse * in_mat);
+    }
+    for (size_t k = 0; k < m_opsSparse.size(); ++k)
+    {
+        if (in_coeffs[k] != 0.0)
+        {
+            out_mat.noalias() += in_coeffs[k] * (m_opsSparse[k] * in_mat);
+        }
+    }
+}
+
+RK4Propagator::RK4Propagator(int in_nbSteps):
+    m_nbSteps(in_nbSteps)
+{
+    if (m_nbSteps < 1)
+    {
+        throw std::invalid_argument("The number of integration steps must be positive.");
+    }
+}
+
+Matrix RK4Propagator::propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime)
+{
+    const int dim = in_hamiltonian.dimension();
+    GoatRhs rhs(in_hamiltonian, in_coeffs, in_params);
+    Matrix state = initialState(dim, in_coeffs.nbParams());
+    Matrix k1, k2, k3, k4;
+    const double dt = in_stopTime / m_nbSteps;
+    for (int i = 0; i < m_nbSteps; ++i)
+    {
+        const double time = i * dt;
+        rhs(time, state, k1);
+        rhs(time + dt / 2, state + (dt / 2) * k1, k2);
+        rhs(time + dt / 2, state + (dt / 2) * k2, k3);
+        rhs(time + dt, state + dt * k3, k4);
+        state += (k1 + 2 * k2 + 2 * k3 + k4) * (dt / 6);
+    }
+
+    return toStackedLayout(state, dim);
+}
+
+RK45Propagator::RK45Propagator(double in_rtol, double in_atol, int in_maxSteps):
+    m_rtol(in_rtol),
+    m_atol(in_atol),
+    m_maxSteps(in_maxSteps),
+    m_nbAccepted(0),
+    m_nbRejected(0)
+{
+    if (m_rtol <= 0.0 || m_atol <= 0.0)
+    {
+        throw std::invalid_argument("Integration tolerances must be positive.");
+    }
+}
+
+Matrix RK45Propagator::propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime)
+{
+    // Dormand-Prince tableau
+    constexpr double c2 = 1.0/5, c3 = 3.0/10, c4 = 4.0/5, c5 = 8.0/9;
+    constexpr double a21 = 1.0/5;
+    constexpr double a31 = 3.0/40, a32 = 9.0/40;
+    constexpr double a41 = 44.0/45, a42 = -56.0/15, a43 = 32.0/9;
+    constexpr double a51 = 19372.0/6561, a52 = -25360.0/2187, a53 = 64448.0/6561, a54 = -212.0/729;
+    constexpr double a61 = 9017.0/3168, a62 = -355.0/33, a63 = 46732.0/5247, a64 = 49.0/176, a65 = -5103.0/18656;
+    // 5th-order solution (also the stage of the next step: first same as last)
+    constexpr double b1 = 35.0/384, b3 = 500.0/1113, b4 = 125.0/192, b5 = -2187.0/6784, b6 = 11.0/84;
+    // Difference between the 5th and the embedded 4th order solutions
+    constexpr double e1 = 71.0/57600, e3 = -71.0/16695, e4 = 71.0/1920, e5 = -17253.0/339200, e6 = 22.0/525, e7 = -1.0/40;
+    // Step size controller
+    constexpr double SAFETY = 0.9, MIN_FACTOR = 0.2, MAX_FACTOR = 5.0;
+
+    m_nbAccepted = 0;
+    m_nbRejected = 0;
+    const int dim = in_hamiltonian.dimension();
+    GoatRhs rhs(in_hamiltonian, in_coeffs, in_params);
+    Matrix state = initialState(dim, in_coeffs.nbParams());
+    if (in_stopTime <= 0.0)
+    {
+        return toStackedLayout(state, dim);
+    }
+
+    Matrix k1, k2, k3, k4, k5, k6, k7, newState, errMat;
+    const auto errorNorm = [this](const Matrix& in_err, const Matrix& in_y0, const Matrix& in_y1) {
+        const auto scale = m_atol + m_rtol * in_y0.array().abs().max(in_y1.array().abs());
+        return std::sqrt((in_err.array().abs() / scale).square().mean());
+    };
+
+    double time = 0.0;
+    rhs(time, state, k1);
+    // Initial step size (Hairer, Norsett and Wanner)
+    double dt = [&]() {
+        const double d0 = errorNorm(state, state, state);
+        const double d1 = errorNorm(k1, state, state);
+        const double h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+        return std::min(h0, in_stopTime);
+    }();
+
+    while (time < in_stopTime)
+    {
+        if (m_nbAccepted + m_nbRejected >= m_maxSteps)
+        {
+            throw std::runtime_error("RK45: max number of integration steps exceeded.");
+        }
+
+        const bool lastStep = (time + dt >= in_stopTime);
+        if (lastStep)
+        {
+            dt = in_stopTime - time;
+        }
+
+        rhs(time + c2 * dt, state + dt * (a21 * k1), k2);
+        rhs(time + c3 * dt, state + dt * (a31 * k1 + a32 * k2), k3);
+        rhs(time + c4 * dt, state + dt * (a41 * k1 + a42 * k2 + a43 * k3), k4);
+        rhs(time + c5 * dt, state + dt * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4), k5);
+        rhs(time + dt, state + dt * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5), k6);
+        newState = state + dt * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+        rhs(time + dt, newState, k7);
+        errMat = dt * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+        const double err = errorNorm(errMat, state, newState);
+        const double factor = (err == 0.0) ? MAX_FACTOR : std::min(MAX_FACTOR, std::max(MIN_FACTOR, SAFETY * std::pow(err, -0.2)));
+        if (err <= 1.0)
+        {
+            time = lastStep ? in_stopTime : time + dt;
+            state.swap(newState);
+            k1.swap(k7);
+            ++m_nbAccepted;
+        }
+        else
+        {
+            ++m_nbRejected;
+        }
+        dt *= factor;
+    }
+
+    return toStackedLayout(state, dim);
+}
+
+MagnusPropagator::MagnusPropagator(int in_nbSteps):
+    m_nbSteps(in_nbSteps)
+{
+    if (m_nbSteps < 1)
+    {
+        throw std::invalid_argument("The number of integration steps must be positive.");
+    }
+}
+
+Matrix MagnusPropagator::propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime)
+{
+    const int dim = in_hamiltonian.dimension();
+    const size_t nbParams = in_coeffs.nbParams();
+    const double dt = in_stopTime / m_nbSteps;
+    // Gauss-Legendre nodes and the commutator weight of the 4th-order Magnus expansion
+    const double gaussOffset = std::sqrt(3.0) / 6.0;
+    const double commutatorWeight = std::sqrt(3.0) / 12.0 * dt * dt;
+
+    Matrix U = Matrix::Identity(dim, dim);
+    std::vector<Matrix> dUs(nbParams, Matrix::Zero(dim, dim));
+    std::vector<double> values1, values2;
+    std::vector<std::vector<double>> grads1, grads2;
+    // Exponentials of the (augmented) Magnus generators
+    std::vector<Matrix> generators(std::max<size_t>(nbParams, 1));
+    std::vector<Matrix> exps;
+
+    for (int i = 0; i < m_nbSteps; ++i)
+    {
+        const double time = i * dt;
+        in_coeffs.evaluate(time + (0.5 - gaussOffset) * dt, in_params, values1, grads1);
+        in_coeffs.evaluate(time + (0.5 + gaussOffset) * dt, in_params, values2, grads2);
+        const Matrix A1 = -I * in_hamiltonian.combine(1.0, values1);
+        const Matrix A2 = -I * in_hamiltonian.combine(1.0, values2);
+        // Omega = dt/2 (A1 + A2) + sqrt(3)/12 dt^2 [A2, A1]
+        const Matrix omega = (dt / 2) * (A1 + A2) + commutatorWeight * (A2 * A1 - A1 * A2);
+        if (nbParams == 0)
+        {
+            generators[0] = omega;
+        }
+
+        for (size_t j = 0; j < nbParams; ++j)
+        {
+            // dOmega/dalpha_j
+            const Matrix B1 = -I * in_hamiltonian.combine(0.0, grads1[j]);
+            const Matrix B2 = -I * in_hamiltonian.combine(0.0, grads2[j]);
+            auto& generator = generators[j];
+            generator = Matrix::Zero(2 * dim, 2 * dim);
+            generator.topLeftCorner(dim, dim) = omega;
+            generator.bottomRightCorner(dim, dim) = omega;
+            generator.bottomLeftCorner(dim, dim) = (dt / 2) * (B1 + B2) + commutatorWeight * (B2 * A1 + A2 * B1 - B1 * A2 - A1 * B2);
+        }
+
+        expmBatch(generators, exps);
+        const Matrix expOmega = exps[0].topLeftCorner(dim, dim);
+        for (size_t j = 0; j < nbParams; ++j)
+        {
+            dUs[j] = exps[j].bottomLeftCorner(dim, dim) * U + expOmega * dUs[j];
+        }
+        U = expOmega * U;
+    }
+
+    Matrix result(dim * (nbParams + 1), dim);
+    result.topRows(dim) = U;
+    for (size_t j = 0; j < nbParams; ++j)
+    {
+        result.middleRows((j + 1) * dim, dim) = dUs[j];
+    }
+    return result;
+}
+}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <complex>
+#include <Eigen/Dense>
+#include <Eigen/SparseCore>
+
+namespace xacc {
+// Propagation engine for the optimal control methods (GOAT and GRAPE):
+// (1) Matrix exponentials (Pade approximation with scaling and squaring), single or batched.
+// (2) Control Hamiltonians of the form H(t) = H0 + sum_k c_k(t) H_k (dense or sparse operators).
+// (3) Propagators of the GOAT equations of motion, i.e. U(t) and dU/dalpha_j(t) with U(0) = I:
+//    dU/dt = -iHU; d(dU/dalpha_j)/dt = -i(dH/dalpha_j U + H dU/dalpha_j)
+namespace propagation {
+using Matrix = Eigen::MatrixXcd;
+using SparseMatrix = Eigen::SparseMatrix<std::complex<double>>;
+
+// Matrix exponential: Pade approximant of degree 3, 5, 7, 9 or 13 (depending on the 1-norm)
+// with scaling and squaring (Higham, SIAM J. Matrix Anal. Appl. 26 (2005)).
+// The workspace keeps the scratch matrices and the LU decomposition of the Pade denominator
+// between calls, hence a sequence of exponentials of the same size doesn't reallocate.
+class ExpmWorkspace
+{
+public:
+    void expm(const Matrix& in_mat, Matrix& out_exp);
+
+private:
+    Matrix m_a2;
+    Matrix m_a4;
+    Matrix m_a6;
+    Matrix m_u;
+    Matrix m_v;
+    Matrix m_tmp;
+    Eigen::PartialPivLU<Matrix> m_lu;
+};
+
+Matrix expm(const Matrix& in_mat);
+// Exponentials of a batch of matrices (e.g. the time slices of a pulse).
+// The batch is distributed across threads (OpenMP), one workspace per thread.
+void expmBatch(const std::vector<Matrix>& in_mats, std::vector<Matrix>& out_exps);
+
+// H(t) = H0 + sum_k c_k(t) H_k
+// The operators are stored either dense or sparse.
+// The sparse path avoids dense matrix-matrix products (O(nnz * dim) rather than O(dim^3)),
+// which pays off when there are only a few (sparse, e.g. Pauli strings) terms.
+class ControlHamiltonian
+{
+public:
+    enum class Storage { Auto, Dense, Sparse };
+    // Auto: use sparse storage if there are at most MAX_SPARSE_TERMS terms
+    // and their combined density is below MAX_SPARSE_DENSITY.
+    static constexpr size_t MAX_SPARSE_TERMS = 8;
+    static constexpr double MAX_SPARSE_DENSITY = 0.1;
+    // Sparse storage is not worth it for very small systems.
+    static constexpr int MIN_SPARSE_DIMENSION = 8;
+
+    ControlHamiltonian(const Matrix& in_h0, const std::vector<Matrix>& in_ops, Storage in_storage = Storage::Auto);
+    int dimension() const { return m_dim; }
+    size_t nbTerms() const { return m_ops.size(); }
+    bool isSparse() const { return m_sparse; }
+    // Returns in_h0Weight * H0 + sum_k in_coeffs[k] * H_k
+    Matrix combine(double in_h0Weight, const std::vector<double>& in_coeffs) const;
+    // out_mat (+)= (in_h0Weight * H0 + sum_k in_coeffs[k] * H_k) * in_mat
+    void apply(double in_h0Weight, const std::vector<double>& in_coeffs, const Eigen::Ref<const Matrix>& in_mat, Eigen::Ref<Matrix> out_mat, bool in_accumulate = false) const;
+
+private:
+    int m_dim;
+    bool m_sparse;
+    bool m_hasH0;
+    Matrix m_h0;
+    std::vector<Matrix> m_ops;
+    SparseMatrix m_h0Sparse;
+    std::vector<SparseMatrix> m_opsSparse;
+};
+
+// Control coefficients c_k(t, alpha) and their derivatives w.r.t. the control params.
+struct IControlCoefficients
+{
+    virtual ~IControlCoefficients() = default;
+    virtual size_t nbParams() const = 0;
+    // out_values[k] = c_k(t); out_grads[j][k] = dc_k/dalpha_j (t)
+    virtual void evaluate(double in_time, const std::vector<double>& in_params, std::vector<double>& out_values, std::vector<std::vector<double>>& out_grads) = 0;
+};
+
+// Solves the GOAT equations of motion on [0, in_stopTime].
+// Returns U(T) stacked on top of the dU/dalpha_j(T) matrices (same layout as IIntegrator).
+struct IPropagator
+{
+    virtual ~IPropagator() = default;
+    virtual Matrix propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime) = 0;
+    // Number of (accepted) time steps of the last propagation
+    virtual int nbSteps() const = 0;
+};
+
+// Classic 4th-order Runge-Kutta, fixed steps.
+class RK4Propagator : public IPropagator
+{
+public:
+    RK4Propagator(int in_nbSteps);
+    Matrix propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime) override;
+    int nbSteps() const override { return m_nbSteps; }
+
+private:
+    int m_nbSteps;
+};
+
+// Dormand-Prince 5(4) Runge-Kutta with adaptive step size (error per step controlled by rtol/atol).
+class RK45Propagator : public IPropagator
+{
+public:
+    RK45Propagator(double in_rtol = 1e-8, double in_atol = 1e-10, int in_maxSteps = 1000000);
+    Matrix propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime) override;
+    int nbSteps() const override { return m_nbAccepted; }
+    int nbRejectedSteps() const { return m_nbRejected; }
+
+private:
+    double m_rtol;
+    double m_atol;
+    int m_maxSteps;
+    int m_nbAccepted;
+    int m_nbRejected;
+};
+
+// 4th-order Magnus expansion (2-point Gauss quadrature), fixed steps.
+// Each step is exact for a piecewise-constant Hamiltonian and unitary by construction,
+// hence much larger steps than Runge-Kutta can be used.
+// The dU/dalpha_j are propagated together with U via the exponential of the block-triangular
+// generator [[Omega, 0], [dOmega/dalpha_j, Omega]] (its lower-left block is the Frechet derivative).
+class MagnusPropagator : public IPropagator
+{
+public:
+    MagnusPropagator(int in_nbSteps);
+    Matrix propagate(const ControlHamiltonian& in_hamiltonian, IControlCoefficients& in_coeffs, const std::vector<double>& in_params, double in_stopTime) override;
+    int nbSteps() const override { return m_nbSteps; }
+
+private:
+    int m_nbSteps;
+};
+}
+}
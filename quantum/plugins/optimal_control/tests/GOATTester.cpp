@@ -3,6 +3,8 @@
 #include <string>
 #include "GOAT.hpp"
 #include "exprtk.hpp"
+#include "Propagator.hpp"
+#include <unsupported/Eigen/MatrixFunctions>
 
 using namespace xacc;
 using symbol_table_t = exprtk::symbol_table<double>;
@@ -219,6 +221,115 @@ TEST(GOATTester, testMlPack)
     std::cout << "##########################################\n";
 }
 
+TEST(GOATTester, testMatrixExponential)
+{
+    // Hermitian generators over a wide range of norms (all Pade degrees and scaling-squaring)
+    for (const double scale : { 1e-3, 0.1, 0.5, 1.0, 5.0, 50.0 })
+    {
+        Matrix H = Matrix::Random(8, 8);
+        H = (H + H.adjoint()).eval() * scale;
+        const Matrix generator = std::complex<double>(0.0, -1.0) * H;
+        const Matrix expected = generator.exp();
+        EXPECT_LT((propagation::expm(generator) - expected).norm(), 1e-10 * expected.norm());
+    }
+
+    std::vector<Matrix> batch;
+    for (int i = 0; i < 20; ++i)
+    {
+        batch.emplace_back(Matrix::Random(4, 4));
+    }
+    std::vector<Matrix> exps;
+    propagation::expmBatch(batch, exps);
+    ASSERT_EQ(exps.size(), batch.size());
+    for (int i = 0; i < batch.size(); ++i)
+    {
+        EXPECT_LT((exps[i] - batch[i].exp()).norm(), 1e-10);
+    }
+}
+
+TEST(GOATTester, testPropagators)
+{
+    // 3-qubit system: static ZZ coupling, X drives (Gaussian pulses) on each qubit.
+    const int dimension = 3;
+    GoatHamiltonian hamiltonian;
+    hamiltonian.construct(dimension, "0.1 Z0 Z1", { "X0", "X1", "X2" }, 
+        { "0.05*exp(-(t-50)^2/(2*s0^2))", "0.05*exp(-(t-50)^2/(2*s1^2))", "0.05*exp(-(t-50)^2/(2*s2^2))" }, { "s0", "s1", "s2" });
+    EXPECT_EQ(hamiltonian.nbParams(), 3);
+    const OptimParams params { 10.0, 15.0, 20.0 };
+    const double tMax = 100.0;
+    const int dimH = 1 << dimension;
+
+    // Reference: fine fixed-step RK4
+    propagation::RK4Propagator rk4(20000);
+    const Matrix reference = rk4.propagate(*hamiltonian.controlHamiltonian, hamiltonian, params, tMax);
+    ASSERT_EQ(reference.rows(), dimH * (params.size() + 1));
+    ASSERT_EQ(reference.cols(), dimH);
+    // U is unitary
+    EXPECT_LT((reference.topRows(dimH).adjoint() * reference.topRows(dimH) - Matrix::Identity(dimH, dimH)).norm(), 1e-8);
+
+    propagation::RK45Propagator rk45(1e-10, 1e-12);
+    const Matrix rk45Result = rk45.propagate(*hamiltonian.controlHamiltonian, hamiltonian, params, tMax);
+    EXPECT_LT((rk45Result - reference).norm(), 1e-6);
+    // Adaptive steps: much less than the fixed-step reference
+    EXPECT_LT(rk45.nbSteps(), 2000);
+    std::cout << "RK45: " << rk45.nbSteps() << " steps (" << rk45.nbRejectedSteps() << " rejected)\n";
+
+    propagation::MagnusPropagator magnus(400);
+    const Matrix magnusResult = magnus.propagate(*hamiltonian.controlHamiltonian, hamiltonian, params, tMax);
+    EXPECT_LT((magnusResult - reference).norm(), 1e-6);
+
+    // The sparse Hamiltonian path must give the same results as the dense one.
+    std::vector<Matrix> ops;
+    for (const auto& op : hamiltonian.hamOps)
+    {
+        ops.emplace_back(op.second);
+    }
+    const Matrix h0 = GOAT_PulseOptim::constructMatrixFromPauliString("0.1 Z0 Z1", dimension);
+    const propagation::ControlHamiltonian denseHam(h0, ops, propagation::ControlHamiltonian::Storage::Dense);
+    const propagation::ControlHamiltonian sparseHam(h0, ops, propagation::ControlHamiltonian::Storage::Sparse);
+    EXPECT_FALSE(denseHam.isSparse());
+    EXPECT_TRUE(sparseHam.isSparse());
+    const Matrix denseResult = rk45.propagate(denseHam, hamiltonian, params, tMax);
+    const Matrix sparseResult = rk45.propagate(sparseHam, hamiltonian, params, tMax);
+    EXPECT_LT((denseResult - sparseResult).norm(), 1e-8);
+
+    // dU/dalpha vs. finite difference
+    const double delta = 1e-5;
+    for (int j = 0; j < params.size(); ++j)
+    {
+        OptimParams shifted(params);
+        shifted[j] += delta;
+        const Matrix shiftedResult = rk45.propagate(*hamiltonian.controlHamiltonian, hamiltonian, shifted, tMax);
+        const Matrix finiteDiff = (shiftedResult.topRows(dimH) - rk45Result.topRows(dimH)) / delta;
+        EXPECT_LT((finiteDiff - rk45Result.middleRows((j + 1) * dimH, dimH)).norm(), 1e-4);
+    }
+}
+
+TEST(GOATTester, testIntegrators)
+{
+    // Same problem as testSimple, via the service interface, using each integrator.
+    for (const std::string integrator : { "rk4", "rk45", "magnus" })
+    {
+        xacc::HeterogeneousMap configs {
+            std::make_pair("method", "GOAT"),
+            std::make_pair("dimension", 1),
+            std::make_pair("target-U", "X0"),
+            std::make_pair("control-params", std::vector<std::string> { "sigma" }),
+            std::make_pair("control-funcs", std::vector<std::string> { "0.06283185307*exp(-t^2/(2*sigma^2))" }),
+            std::make_pair("control-H", std::vector<std::string> { "X0" }),
+            std::make_pair("initial-parameters", std::vector<double> { 8.0 }),
+            std::make_pair("max-time", 100.0),
+            std::make_pair("integrator", integrator)
+        };
+
+        auto optimizer = xacc::getOptimizer("quantum-control", configs);
+        const auto result = optimizer->optimize();
+        std::cout << integrator << ": cost = " << result.first << ", sigma = " << result.second[0] << "\n";
+        EXPECT_NEAR(result.first, 0.0, 1e-3);
+        EXPECT_NEAR(result.second[0], 20.0, 2.0);
+    }
+}
+
 int main(int argc, char **argv) 
 {
     xacc::Initialize();
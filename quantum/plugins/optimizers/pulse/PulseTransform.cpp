@@ -3,6 +3,8 @@
 #include "xacc_service.hpp"
 #include "GateFusion.hpp"
 #include <math.h> 
+#include <iomanip>
+#include <sstream>
 #include "exprtk.hpp"
 #include "Pulse.hpp"
 
@@ -31,9 +33,9 @@ namespace {
         return result;
     }
 
-    std::vector<std::vector<double>> pulseFunc(const std::string& in_functionString, double in_tMax, double in_dt)
+    xacc::quantum::Waveform pulseFunc(const std::string& in_functionString, double in_tMax, double in_dt)
     {
-        std::vector<std::vector<double>> result;
+        xacc::quantum::Waveform result;
         expression_t expression;
         parser_t parser;
         symbol_table_t symbol_table;
@@ -44,12 +46,22 @@ namespace {
         
         while (g_time < in_tMax)
         {
-            const std::complex<double> exprVal = expression.value();
-            result.emplace_back(std::vector<double>{exprVal.real(), exprVal.imag()});
+            result.emplace_back(expression.value());
             g_time += in_dt;
         }
         return result;
     }
+
+    // Number of samples generated by pulseFunc
+    size_t nbPulseSamples(double in_tMax, double in_dt)
+    {
+        size_t result = 0;
+        for (double time = 0.0; time < in_tMax; time += in_dt)
+        {
+            ++result;
+        }
+        return result;
+    }
 }
 
 namespace xacc {
@@ -241,7 +253,10 @@ namespace quantum {
                 const std::string pulse_name = "Optim_Pulse_" + std::to_string(id);          
                 auto pulse = std::make_shared<xacc::quantum::Pulse>(pulse_name);
                 pulse->setChannel(controlChannels[id]);
-                pulse->setSamples(pulseFunc(pulseFn, tMax, backendDt));
+                // Evaluated lazily, once per unique (function, time grid).
+                std::ostringstream waveformKey;
+                waveformKey << std::setprecision(17) << "expr:" << pulseFn << ":" << tMax << ":" << backendDt;
+                pulse->setWaveform(waveformKey.str(), [pulseFn, tMax, backendDt]() { return pulseFunc(pulseFn, tMax, backendDt); }, nbPulseSamples(tMax, backendDt));
                 program->addInstruction(pulse);
                 ++id;
             }
@@ -267,17 +282,9 @@ namespace quantum {
                 auto pulse = std::make_shared<xacc::quantum::Pulse>(pulse_name);
                 pulse->setChannel(controlChannels[pulseId]);
                 
-                std::vector<std::vector<double>> samples;
-                samples.reserve(pulseLength);
-
-                for (int i = 0; i < pulseLength; ++i)
-                {
-                    const auto idx = i + pulseId*pulseLength;
-                    const std::vector<double> sample { optimResult.second[idx] };
-                    samples.emplace_back(sample);
-                }
-
-                pulse->setSamples(samples);
+                const auto begin = optimResult.second.begin() + pulseId*pulseLength;
+                xacc::quantum::Waveform samples(begin, begin + pulseLength);
+                pulse->setWaveform(xacc::quantum::WaveformLibrary::instance().intern(std::move(samples)));
                 program->addInstruction(pulse);
             }
         }
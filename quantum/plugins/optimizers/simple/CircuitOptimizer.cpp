@@ -12,6 +12,7 @@
  *******************************************************************************/
 #include "CircuitOptimizer.hpp"
 #include "Graph.hpp"
+#include "IRToGraphVisitor.hpp"
 #include "CountGatesOfTypeVisitor.hpp"
 #include "CommonGates.hpp"
 #include "Circuit.hpp"
@@ -148,11 +149,11 @@ void CircuitOptimizer::apply(std::shared_ptr<CompositeInstruction> gateFunction,
       // gateFunction->enabledView());
       auto graphView = gateFunction->toGraph();
       for (int i = 1; i < graphView->order() - 2; i++) {
-        auto node = graphView->getVertexProperties(i);
-        if (node.getString("name") == "CNOT" &&
-            gateFunction->getInstruction(node.get<std::size_t>("id") - 1)
+        const auto &node = graphView->getVertexProperties(i);
+        if (node.get(CircuitNodeKeys::NAME) == "CNOT" &&
+            gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)
                 ->isEnabled()) {
-          auto nAsVec = graphView->getNeighborList(node.get<std::size_t>("id"));
+          auto nAsVec = graphView->getNeighborList(node.get(CircuitNodeKeys::ID));
           // std::vector<int> nAsVec(neighbors.begin(), neighbors.end());
           // Note: There is an edge-case if the CNOT is last gate on a pair of qubit wires,
           // i.e. both of its neighbors will be the final state node.
@@ -160,7 +161,7 @@ void CircuitOptimizer::apply(std::shared_ptr<CompositeInstruction> gateFunction,
           if (nAsVec[0] == nAsVec[1] && nAsVec[0] != graphView->order() - 1) {
             // Check that the neighbor gate is indeed a CNOT gate, i.e. not a different 2-qubit gate.
             if (gateFunction->getInstruction(nAsVec[0] - 1)->name() == "CNOT") {
-              gateFunction->getInstruction(node.get<std::size_t>("id") - 1)->disable();
+              gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)->disable();
               gateFunction->getInstruction(nAsVec[0] - 1)->disable();
               modified = true;
               break;
@@ -180,15 +181,15 @@ void CircuitOptimizer::apply(std::shared_ptr<CompositeInstruction> gateFunction,
       auto graphView = gateFunction->toGraph();
 
       for (int i = 1; i < graphView->order() - 2; ++i) {
-        auto node = graphView->getVertexProperties(i);
+        const auto &node = graphView->getVertexProperties(i);
 
-        auto nAsVec = graphView->getNeighborList(node.get<std::size_t>("id"));
+        auto nAsVec = graphView->getNeighborList(node.get(CircuitNodeKeys::ID));
         //   std::vector<int> nAsVec(adj.begin(), adj.end());
         if (nAsVec.size() == 1) {
-          auto nextNode = graphView->getVertexProperties(nAsVec[0]);
-          if (node.getString("name") == "H" &&
-              nextNode.getString("name") == "H") {
-            gateFunction->getInstruction(node.get<std::size_t>("id") - 1)->disable();
+          const auto &nextNode = graphView->getVertexProperties(nAsVec[0]);
+          if (node.get(CircuitNodeKeys::NAME) == "H" &&
+              nextNode.get(CircuitNodeKeys::NAME) == "H") {
+            gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)->disable();
             gateFunction->getInstruction(nAsVec[0] - 1)->disable();
             modified = true;
             break;
@@ -210,30 +211,30 @@ void CircuitOptimizer::apply(std::shared_ptr<CompositeInstruction> gateFunction,
       // start/end nodes get added: start at 1, stop at n-2 b/c last will be n-2
       // neighbor
       for (int i = 1; i < graphView->order() - 2; i++) {
-        auto node = graphView->getVertexProperties(i);
-        auto nAsVec = graphView->getNeighborList(node.get<std::size_t>("id"));
+        const auto &node = graphView->getVertexProperties(i);
+        auto nAsVec = graphView->getNeighborList(node.get(CircuitNodeKeys::ID));
         // if it has more than 1 neighbor, don't consider
         if (nAsVec.size() == 1) {
-          auto nextNode = graphView->getVertexProperties(nAsVec[0]);
-          if (isRotation(node.getString("name")) &&
-              isRotation(nextNode.getString("name")) &&
-              node.getString("name") == nextNode.getString("name")) {
+          const auto &nextNode = graphView->getVertexProperties(nAsVec[0]);
+          if (isRotation(node.get(CircuitNodeKeys::NAME)) &&
+              isRotation(nextNode.get(CircuitNodeKeys::NAME)) &&
+              node.get(CircuitNodeKeys::NAME) == nextNode.get(CircuitNodeKeys::NAME)) {
             auto val1 =
-                ipToDouble(gateFunction->getInstruction(node.get<std::size_t>("id") - 1)
+                ipToDouble(gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)
                                ->getParameter(0));
             auto val2 = ipToDouble(
-                gateFunction->getInstruction(nextNode.get<std::size_t>("id") - 1)
+                gateFunction->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1)
                     ->getParameter(0));
 
             if (std::fabs(val1 + val2) < 1e-12) {
-              gateFunction->getInstruction(node.get<std::size_t>("id") - 1)->disable();
-              gateFunction->getInstruction(nextNode.get<std::size_t>("id") - 1)
+              gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)->disable();
+              gateFunction->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1)
                   ->disable();
             } else {
               InstructionParameter tmp(val1 + val2);
-              gateFunction->getInstruction(node.get<std::size_t>("id") - 1)
+              gateFunction->getInstruction(node.get(CircuitNodeKeys::ID) - 1)
                   ->setParameter(0, tmp);
-              gateFunction->getInstruction(nextNode.get<std::size_t>("id") - 1)
+              gateFunction->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1)
                   ->disable();
             }
             modified = true;
@@ -317,9 +318,9 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
   std::vector<std::size_t> hadamardNodeIds;
   // We collect all Hadamard nodes ahead of time for the iteration and matching
   for (int i = 1; i < graphView->order() - 1; ++i) {
-    const auto node = graphView->getVertexProperties(i);
-    if (node.getString("name") == "H") {
-      hadamardNodeIds.emplace_back(node.get<std::size_t>("id"));
+    const auto &node = graphView->getVertexProperties(i);
+    if (node.get(CircuitNodeKeys::NAME) == "H") {
+      hadamardNodeIds.emplace_back(node.get(CircuitNodeKeys::ID));
     }
   }
 
@@ -342,8 +343,8 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
     // This is a single-qubit gate, hence must have only one neighbor
     // (either another gate or the final state)
     assert(neighborNodes.size() == 1);
-    const auto nextNode = graphView->getVertexProperties(neighborNodes.front());
-    const auto nextGateName = nextNode.getString("name");
+    const auto &nextNode = graphView->getVertexProperties(neighborNodes.front());
+    const auto nextGateName = nextNode.get(CircuitNodeKeys::NAME);
 
     if (nextGateName == "CNOT") {
       // We try to match against this gate pattern:
@@ -351,14 +352,14 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
       //       |
       //       |
       // H-----+-----H
-      const auto cnotInst = io_program->getInstruction(nextNode.get<std::size_t>("id") - 1);
-      const auto cnotNeighborNodes = graphView->getNeighborList(nextNode.get<std::size_t>("id"));
+      const auto cnotInst = io_program->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1);
+      const auto cnotNeighborNodes = graphView->getNeighborList(nextNode.get(CircuitNodeKeys::ID));
       if (cnotNeighborNodes.size() == 2) {
         if (container::contains(hadamardNodeIds, cnotNeighborNodes[0]) && container::contains(hadamardNodeIds, cnotNeighborNodes[1])) {
           // Try to find the remaining left leg
           std::size_t remainingHadamardNodeId = 0;
           for (const auto& checkNode: hadamardNodeIds) {
-            if (checkNode != hadamardNode && graphView->getNeighborList(checkNode)[0] == nextNode.get<std::size_t>("id")) {
+            if (checkNode != hadamardNode && graphView->getNeighborList(checkNode)[0] == nextNode.get(CircuitNodeKeys::ID)) {
               remainingHadamardNodeId = checkNode;
               break;
             }
@@ -366,7 +367,7 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
 
           if (remainingHadamardNodeId != 0) {
             // We've found the complete pattern.
-            matchedReductionPatterns.emplace_back(std::vector<std::size_t>({ hadamardNode, remainingHadamardNodeId, nextNode.get<std::size_t>("id"), (std::size_t) cnotNeighborNodes[0], (std::size_t) cnotNeighborNodes[1] }));
+            matchedReductionPatterns.emplace_back(std::vector<std::size_t>({ hadamardNode, remainingHadamardNodeId, nextNode.get(CircuitNodeKeys::ID), (std::size_t) cnotNeighborNodes[0], (std::size_t) cnotNeighborNodes[1] }));
             // Add all 4 hadamard gates to the tracking list
             matchedHadamardNodeIds.emplace(hadamardNode);
             matchedHadamardNodeIds.emplace(remainingHadamardNodeId);
@@ -379,11 +380,11 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
 
     if (nextGateName == "Rz")
     {
-      assert(io_program->getInstruction(nextNode.get<std::size_t>("id") - 1)->bits()[0] == qubitIndex);
+      assert(io_program->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1)->bits()[0] == qubitIndex);
       // We only match Rz(+/- pi/2), i.e. the Phase gate and its dagger.
 
       // Check if total angle is either +/- pi/2, i.e. equivalent to a P gate or its dagger.
-      const double rawAngle = ipToDouble(io_program->getInstruction(nextNode.get<std::size_t>("id") - 1)->getParameter(0));
+      const double rawAngle = ipToDouble(io_program->getInstruction(nextNode.get(CircuitNodeKeys::ID) - 1)->getParameter(0));
       const double normalizedAngle = getNormalizedRotationAngle(rawAngle);
       const bool isPhaseGate = isPiOver2(normalizedAngle);
       const bool isPhaseDaggerGate = isMinusPiOver2(normalizedAngle);
@@ -392,16 +393,16 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
         // There are two potential patterns that we need to check:
         // (1) H - P - H (or P dagger)
         // (2) H - P - CNOT^k - P - H (or P dagger)
-        const auto phaseGateNeighborNodeIds = graphView->getNeighborList(nextNode.get<std::size_t>("id"));
+        const auto phaseGateNeighborNodeIds = graphView->getNeighborList(nextNode.get(CircuitNodeKeys::ID));
         assert(phaseGateNeighborNodeIds.size() == 1);
-        const auto phaseGateNeighborNode = graphView->getVertexProperties(phaseGateNeighborNodeIds.front());
-        if (phaseGateNeighborNode.getString("name") == "H") {
+        const auto &phaseGateNeighborNode = graphView->getVertexProperties(phaseGateNeighborNodeIds.front());
+        if (phaseGateNeighborNode.get(CircuitNodeKeys::NAME) == "H") {
           // Got it, this is the H - P - H (or P dagger)
-          assert(container::contains(hadamardNodeIds, phaseGateNeighborNode.get<std::size_t>("id")));
-          matchedReductionPatterns.emplace_back(std::vector<std::size_t>({ hadamardNode, nextNode.get<std::size_t>("id"), phaseGateNeighborNode.get<std::size_t>("id") }));
+          assert(container::contains(hadamardNodeIds, phaseGateNeighborNode.get(CircuitNodeKeys::ID)));
+          matchedReductionPatterns.emplace_back(std::vector<std::size_t>({ hadamardNode, nextNode.get(CircuitNodeKeys::ID), phaseGateNeighborNode.get(CircuitNodeKeys::ID) }));
           // Add the two Hadamard gates to the tracking list
           matchedHadamardNodeIds.emplace(hadamardNode);
-          matchedHadamardNodeIds.emplace(phaseGateNeighborNode.get<std::size_t>("id"));
+          matchedHadamardNodeIds.emplace(phaseGateNeighborNode.get(CircuitNodeKeys::ID));
         }
 
         // Lastly, try match against the H - P - CNOT^k - P - H (or P dagger) pattern
@@ -411,8 +412,8 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
         const auto isNextNodeCnotTargetQubit = [&graphView, &io_program](int in_qubitIndex, int in_startNodeId, std::vector<int>& io_cnotNodeIdToAppend) ->bool {
           const auto neighbors = graphView->getNeighborList(in_startNodeId);
           for (const auto& neighbor: neighbors) {
-            const auto nodeProps = graphView->getVertexProperties(neighbor);
-            const auto instIdx = nodeProps.get<std::size_t>("id") - 1;
+            const auto &nodeProps = graphView->getVertexProperties(neighbor);
+            const auto instIdx = nodeProps.get(CircuitNodeKeys::ID) - 1;
             if (instIdx < io_program->nInstructions()) {
               const auto inst = io_program->getInstruction(instIdx);
               if (inst->name() == "CNOT" && inst->bits()[1] == in_qubitIndex) {
@@ -425,7 +426,7 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
         };
         std::vector<int> cnotNodeIdx;
         // We start from the Phase gate node
-        int startVerticeId = nextNode.get<std::size_t>("id");
+        int startVerticeId = nextNode.get(CircuitNodeKeys::ID);
         while (true) {
           if (isNextNodeCnotTargetQubit(qubitIndex, startVerticeId, cnotNodeIdx)) {
             // If found a CNOT gate (target the correct qubit), continue from that CNOT
@@ -443,8 +444,8 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
             // Need to check the remaining pattern: Rz(+/-pi/2) then H
             const auto nodesAfterLastCnot = graphView->getNeighborList(cnotNodeIdx.back());
             for (const auto& nodeToCheck: nodesAfterLastCnot) {
-              const auto nodeProp = graphView->getVertexProperties(nodeToCheck);
-              if (nodeProp.getString("name") == "Rz") {
+              const auto &nodeProp = graphView->getVertexProperties(nodeToCheck);
+              if (nodeProp.get(CircuitNodeKeys::NAME) == "Rz") {
                 // Must be Rz on that qbit line
                 if(io_program->getInstruction(nodeToCheck - 1)->bits()[0] == qubitIndex) {
                   // This Rz (after CNOT's) must match the one before CNOT's,
@@ -472,7 +473,7 @@ bool CircuitOptimizer::tryReduceHadamardGates(std::shared_ptr<CompositeInstructi
               // First H
               completePattern.emplace_back(hadamardNode);
               // First Phase gate (or phase dagger)
-              completePattern.emplace_back(nextNode.get<std::size_t>("id"));
+              completePattern.emplace_back(nextNode.get(CircuitNodeKeys::ID));
               // Sequence of CNOT gates
               for (const auto& cnotId : cnotNodeIdx) {
                 completePattern.emplace_back(cnotId);
@@ -567,21 +568,21 @@ bool CircuitOptimizer::tryRotationMergingUsingPhasePolynomials(std::shared_ptr<C
   // (to handle backward search from a CNOT anchor point)
   std::unordered_map<int, std::vector<int>> qubitToNodeIds;
   for (int i = 1; i < graphView->order() - 1; ++i) {
-    const auto node = graphView->getVertexProperties(i);
-    const auto& instruction = io_program->getInstruction(node.get<std::size_t>("id") - 1);
+    const auto &node = graphView->getVertexProperties(i);
+    const auto& instruction = io_program->getInstruction(node.get(CircuitNodeKeys::ID) - 1);
     for (const auto& bit: instruction->bits()) {
       auto& currentList = qubitToNodeIds[bit];
       // Add the node Id to the tracking list of this qubit.
-      currentList.emplace_back(node.get<std::size_t>("id"));
+      currentList.emplace_back(node.get(CircuitNodeKeys::ID));
     }
   }
 
   for (int i = 1; i < graphView->order() - 1; /* increment in loop*/) {
     std::unordered_map<int, std::pair<int, int>> qubitToBoundary;
-    const auto node = graphView->getVertexProperties(i);
+    const auto &node = graphView->getVertexProperties(i);
     // Starting at a CNOT gate as anchor point
-    if (node.getString("name") == "CNOT") {
-      const auto& cnotInst = io_program->getInstruction(node.get<std::size_t>("id") - 1);
+    if (node.get(CircuitNodeKeys::NAME) == "CNOT") {
+      const auto& cnotInst = io_program->getInstruction(node.get(CircuitNodeKeys::ID) - 1);
       assert(cnotInst->bits().size() == 2);
       const auto ctrlIndex = cnotInst->bits()[0];
       const auto targetIndex = cnotInst->bits()[1];
@@ -655,13 +656,13 @@ bool CircuitOptimizer::tryRotationMergingUsingPhasePolynomials(std::shared_ptr<C
       // Forward search:
       {
         // Control wire:
-        for (const auto& nodeToCheck: graphView->getNeighborList(node.get<std::size_t>("id"))) {
+        for (const auto& nodeToCheck: graphView->getNeighborList(node.get(CircuitNodeKeys::ID))) {
           if (nodeToCheck < graphView->order() - 1 && container::contains(io_program->getInstruction(nodeToCheck - 1)->bits(), ctrlIndex)) {
             findRightBoundary(ctrlIndex, nodeToCheck);
           }
         }
         // Target wire"
-        for (const auto& nodeToCheck: graphView->getNeighborList(node.get<std::size_t>("id"))) {
+        for (const auto& nodeToCheck: graphView->getNeighborList(node.get(CircuitNodeKeys::ID))) {
           if (nodeToCheck < graphView->order() - 1 && container::contains(io_program->getInstruction(nodeToCheck - 1)->bits(), targetIndex)) {
             findRightBoundary(targetIndex, nodeToCheck);
           }
@@ -680,8 +681,8 @@ bool CircuitOptimizer::tryRotationMergingUsingPhasePolynomials(std::shared_ptr<C
         }
 
         for (int idx = 1; idx < graphView->order() - 1; ++idx) {
-          const auto node = graphView->getVertexProperties(idx);
-          const auto& instruction = io_program->getInstruction(node.get<std::size_t>("id") - 1);
+          const auto &node = graphView->getVertexProperties(idx);
+          const auto& instruction = io_program->getInstruction(node.get(CircuitNodeKeys::ID) - 1);
 
           if (instruction->bits().size() == 1 && container::contains(qubits, instruction->bits()[0])) {
             const auto& boundary = qubitToBoundary[instruction->bits()[0]];
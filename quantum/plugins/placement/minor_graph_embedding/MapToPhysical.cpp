@@ -15,6 +15,7 @@
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include "EmbeddingAlgorithm.hpp"
+#include "EmbeddingCache.hpp"
 
 namespace xacc {
 namespace quantum {
@@ -91,8 +92,24 @@ namespace quantum {
       }
     }
 
-    // Compute the minor graph embedding
-    auto embedding =  embeddingAlgorithm->embed(pbGraph, hwGraph);
+    // Compute the minor graph embedding (or reuse the cached one),
+    // keeping the best of several parallel searches: a valid placement
+    // requires chains of length 1.
+    bool useCache = true;
+    if (options.keyExists<bool>("embedding-cache")) {
+      useCache = options.get<bool>("embedding-cache");
+    }
+    int nSeeds = 4;
+    if (options.keyExists<int>("embedding-seeds")) {
+      nSeeds = options.get<int>("embedding-seeds");
+    }
+    Embedding embedding;
+    if (useCache) {
+      EmbeddingCache cache;
+      embedding = cache.embed(embeddingAlgorithm, pbGraph, hwGraph, nSeeds);
+    } else {
+      embedding = embeddingAlgorithm->embed(pbGraph, hwGraph);
+    }
     
     std::vector<std::size_t> physicalMap;
     // check the output
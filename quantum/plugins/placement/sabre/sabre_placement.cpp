@@ -0,0 +1,548 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "sabre_placement.hpp"
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include "xacc_plugin.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace {
+constexpr int UNREACHABLE = std::numeric_limits<int>::max() / 4;
+
+// Coupling graph with precomputed all-pairs distances
+struct CouplingMap {
+  int nQubits = 0;
+  std::vector<std::vector<int>> neighbors;
+  std::vector<std::vector<int>> dist;
+
+  CouplingMap(const std::vector<std::pair<int, int>> &edges) {
+    for (const auto &[q1, q2] : edges) {
+      nQubits = std::max(nQubits, std::max(q1, q2) + 1);
+    }
+    neighbors.resize(nQubits);
+    for (const auto &[q1, q2] : edges) {
+      if (q1 == q2) {
+        continue;
+      }
+      if (std::find(neighbors[q1].begin(), neighbors[q1].end(), q2) ==
+          neighbors[q1].end()) {
+        neighbors[q1].emplace_back(q2);
+        neighbors[q2].emplace_back(q1);
+      }
+    }
+    // BFS from every vertex: O(V * E)
+    dist.assign(nQubits, std::vector<int>(nQubits, UNREACHABLE));
+    for (int src = 0; src < nQubits; ++src) {
+      auto &d = dist[src];
+      d[src] = 0;
+      std::queue<int> bfs;
+      bfs.push(src);
+      while (!bfs.empty()) {
+        const int u = bfs.front();
+        bfs.pop();
+        for (const auto &v : neighbors[u]) {
+          if (d[v] == UNREACHABLE) {
+            d[v] = d[u] + 1;
+            bfs.push(v);
+          }
+        }
+      }
+    }
+  }
+};
+
+// Gate dependency DAG (on logical qubits)
+struct GateDag {
+  std::vector<std::vector<int>> qubits;
+  std::vector<std::vector<int>> successors;
+  std::vector<int> nPredecessors;
+
+  GateDag(const std::vector<std::vector<int>> &gateQubits, int nLogical,
+          bool reversed)
+      : qubits(gateQubits) {
+    if (reversed) {
+      std::reverse(qubits.begin(), qubits.end());
+    }
+    successors.resize(qubits.size());
+    nPredecessors.assign(qubits.size(), 0);
+    std::vector<int> lastGate(nLogical, -1);
+    for (int g = 0; g < qubits.size(); ++g) {
+      for (const auto &q : qubits[g]) {
+        if (lastGate[q] >= 0 &&
+            (successors[lastGate[q]].empty() ||
+             successors[lastGate[q]].back() != g)) {
+          successors[lastGate[q]].emplace_back(g);
+          nPredecessors[g]++;
+        }
+        lastGate[q] = g;
+      }
+    }
+  }
+};
+
+struct SabreConfig {
+  int extendedSetSize = 20;
+  double extendedSetWeight = 0.5;
+  double decayDelta = 0.001;
+  int decayResetInterval = 5;
+};
+
+// A routed operation: either an original gate (gate index >= 0) or a SWAP
+// (gate index = -1) on the physical qubits.
+struct RoutedOp {
+  int gate;
+  int p1;
+  int p2;
+};
+
+struct RoutingResult {
+  int nSwaps = 0;
+  std::vector<int> finalLayout;
+  std::vector<RoutedOp> ops;
+};
+
+class SabreRouter {
+public:
+  SabreRouter(const CouplingMap &coupling, const SabreConfig &config,
+              unsigned seed)
+      : m_coupling(coupling), m_config(config), m_rng(seed) {}
+
+  // Route the DAG starting from the logical -> physical layout.
+  RoutingResult route(const GateDag &dag, const std::vector<int> &layout,
+                      bool recordOps) {
+    RoutingResult result;
+    const int nPhys = m_coupling.nQubits;
+    std::vector<int> l2p = layout;
+    std::vector<int> p2l(nPhys, -1);
+    for (int l = 0; l < l2p.size(); ++l) {
+      p2l[l2p[l]] = l;
+    }
+    std::vector<int> remainingPreds = dag.nPredecessors;
+    std::vector<int> front;
+    for (int g = 0; g < dag.qubits.size(); ++g) {
+      if (remainingPreds[g] == 0) {
+        front.emplace_back(g);
+      }
+    }
+    std::vector<double> decay(nPhys, 1.0);
+    std::vector<int> visitStamp(dag.qubits.size(), 0);
+    int stamp = 0;
+    int swapsSinceDecayReset = 0;
+    int swapsWithoutProgress = 0;
+    // Escape hatch against (rare) heuristic live-locks
+    const int maxSwapsWithoutProgress = 10 * std::max(10, nPhys);
+
+    const auto isExecutable = [&](int g) {
+      const auto &qs = dag.qubits[g];
+      return qs.size() < 2 || m_coupling.dist[l2p[qs[0]]][l2p[qs[1]]] == 1;
+    };
+    const auto applySwap = [&](int pa, int pb) {
+      const int la = p2l[pa];
+      const int lb = p2l[pb];
+      std::swap(p2l[pa], p2l[pb]);
+      if (la >= 0) {
+        l2p[la] = pb;
+      }
+      if (lb >= 0) {
+        l2p[lb] = pa;
+      }
+      result.nSwaps++;
+      if (recordOps) {
+        result.ops.push_back({-1, pa, pb});
+      }
+    };
+
+    std::vector<int> work;
+    std::vector<int> blocked;
+    std::vector<int> extendedSet;
+    std::vector<std::pair<int, int>> candidates;
+    while (!front.empty()) {
+      // Execute everything that is executable
+      bool progress = false;
+      work = front;
+      blocked.clear();
+      while (!work.empty()) {
+        const int g = work.back();
+        work.pop_back();
+        if (isExecutable(g)) {
+          progress = true;
+          if (recordOps) {
+            const auto &qs = dag.qubits[g];
+            result.ops.push_back({g, qs.empty() ? -1 : l2p[qs[0]],
+                                  qs.size() < 2 ? -1 : l2p[qs[1]]});
+          }
+          for (const auto &s : dag.successors[g]) {
+            if (--remainingPreds[s] == 0) {
+              work.emplace_back(s);
+            }
+          }
+        } else {
+          blocked.emplace_back(g);
+        }
+      }
+      front.swap(blocked);
+      if (front.empty()) {
+        break;
+      }
+      if (progress) {
+        std::fill(decay.begin(), decay.end(), 1.0);
+        swapsSinceDecayReset = 0;
+        swapsWithoutProgress = 0;
+        continue;
+      }
+
+      if (swapsWithoutProgress > maxSwapsWithoutProgress) {
+        // Route the first blocked gate along a shortest path.
+        const auto &qs = dag.qubits[front.front()];
+        if (m_coupling.dist[l2p[qs[0]]][l2p[qs[1]]] >= UNREACHABLE) {
+          xacc::error("[SABRE Placement] Physical qubits " +
+                      std::to_string(l2p[qs[0]]) + " and " +
+                      std::to_string(l2p[qs[1]]) +
+                      " are not connected in the coupling graph.");
+        }
+        while (m_coupling.dist[l2p[qs[0]]][l2p[qs[1]]] > 1) {
+          const int src = l2p[qs[0]];
+          const int dst = l2p[qs[1]];
+          for (const auto &n : m_coupling.neighbors[src]) {
+            if (m_coupling.dist[n][dst] < m_coupling.dist[src][dst]) {
+              applySwap(src, n);
+              break;
+            }
+          }
+        }
+        swapsWithoutProgress = 0;
+        continue;
+      }
+
+      // Extended set: the next 2-qubit gates in the DAG after the front layer
+      extendedSet.clear();
+      ++stamp;
+      {
+        std::vector<int> frontier = front;
+        std::size_t idx = 0;
+        while (idx < frontier.size() &&
+               extendedSet.size() < m_config.extendedSetSize) {
+          const int g = frontier[idx++];
+          for (const auto &s : dag.successors[g]) {
+            if (visitStamp[s] != stamp) {
+              visitStamp[s] = stamp;
+              frontier.emplace_back(s);
+              if (dag.qubits[s].size() == 2) {
+                extendedSet.emplace_back(s);
+                if (extendedSet.size() >= m_config.extendedSetSize) {
+                  break;
+                }
+              }
+            }
+          }
+        }
+      }
+
+      // Candidate SWAPs: coupling edges touching the front layer qubits
+      candidates.clear();
+      for (const auto &g : front) {
+        for (const auto &q : dag.qubits[g]) {
+          const int p = l2p[q];
+          for (const auto &n : m_coupling.neighbors[p]) {
+            const auto edge = std::make_pair(std::min(p, n), std::max(p, n));
+            if (std::find(candidates.begin(), candidates.end(), edge) ==
+                candidates.end()) {
+              candidates.emplace_back(edge);
+            }
+          }
+        }
+      }
+
+      // Score: H = max(decay) * (D_front / |F| + W * D_ext / |E|)
+      double bestScore = std::numeric_limits<double>::max();
+      std::vector<std::pair<int, int>> bestSwaps;
+      for (const auto &[pa, pb] : candidates) {
+        const auto physAfterSwap = [&](int l) {
+          const int p = l2p[l];
+          return p == pa ? pb : (p == pb ? pa : p);
+        };
+        const auto layerCost = [&](const std::vector<int> &gates) {
+          double cost = 0.0;
+          for (const auto &g : gates) {
+            const auto &qs = dag.qubits[g];
+            if (qs.size() == 2) {
+              cost += m_coupling.dist[physAfterSwap(qs[0])][physAfterSwap(qs[1])];
+            }
+          }
+          return gates.empty() ? 0.0 : cost / gates.size();
+        };
+        double score = layerCost(front);
+        if (!extendedSet.empty()) {
+          score += m_config.extendedSetWeight * layerCost(extendedSet);
+        }
+        score *= std::max(decay[pa], decay[pb]);
+        if (score < bestScore - 1e-12) {
+          bestScore = score;
+          bestSwaps.clear();
+          bestSwaps.emplace_back(pa, pb);
+        } else if (std::abs(score - bestScore) <= 1e-12) {
+          bestSwaps.emplace_back(pa, pb);
+        }
+      }
+
+      std::uniform_int_distribution<std::size_t> pick(0, bestSwaps.size() - 1);
+      const auto [pa, pb] = bestSwaps[pick(m_rng)];
+      applySwap(pa, pb);
+      decay[pa] += m_config.decayDelta;
+      decay[pb] += m_config.decayDelta;
+      swapsWithoutProgress++;
+      if (++swapsSinceDecayReset >= m_config.decayResetInterval) {
+        std::fill(decay.begin(), decay.end(), 1.0);
+        swapsSinceDecayReset = 0;
+      }
+    }
+
+    result.finalLayout = l2p;
+    return result;
+  }
+
+private:
+  const CouplingMap &m_coupling;
+  const SabreConfig &m_config;
+  std::mt19937 m_rng;
+};
+} // namespace
+
+namespace xacc {
+namespace quantum {
+void SabrePlacement::apply(std::shared_ptr<CompositeInstruction> program,
+                           const std::shared_ptr<Accelerator> acc,
+                           const HeterogeneousMap &options) {
+  if (!acc) {
+    xacc::warning("[SABRE Placement] Provided QPU was null. Cannot run "
+                  "SABRE placement.");
+    return;
+  }
+  auto connectivity = acc->getConnectivity();
+  if (connectivity.empty()) {
+    // Fully-connected, nothing to do.
+    return;
+  }
+
+  SabreConfig config;
+  int nRestarts = 8;
+  int nIterations = 3;
+  int nThreads = 0;
+  int seed = 0;
+  std::vector<int> initialLayout;
+  if (options.keyExists<int>("restarts")) {
+    nRestarts = std::max(1, options.get<int>("restarts"));
+  }
+  if (options.keyExists<int>("iterations")) {
+    nIterations = std::max(0, options.get<int>("iterations"));
+  }
+  if (options.keyExists<int>("threads")) {
+    nThreads = std::max(0, options.get<int>("threads"));
+  }
+  if (options.keyExists<int>("seed")) {
+    seed = options.get<int>("seed");
+  }
+  if (options.keyExists<int>("extended-set-size")) {
+    config.extendedSetSize = options.get<int>("extended-set-size");
+  }
+  if (options.keyExists<double>("extended-set-weight")) {
+    config.extendedSetWeight = options.get<double>("extended-set-weight");
+  }
+  if (options.keyExists<double>("decay")) {
+    config.decayDelta = options.get<double>("decay");
+  }
+  if (options.keyExists<std::vector<int>>("initial-layout")) {
+    initialLayout = options.get<std::vector<int>>("initial-layout");
+  }
+
+  const CouplingMap coupling(connectivity);
+
+  // Flatten the program and assign logical qubit indices to each
+  // (buffer, bit) pair.
+  std::vector<InstPtr> instructions;
+  std::vector<std::vector<int>> gateQubits;
+  std::map<std::pair<std::string, std::size_t>, int> logicalIdx;
+  InstructionIterator it(program);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (inst->isComposite() || !inst->isEnabled()) {
+      continue;
+    }
+    const auto bits = inst->bits();
+    const auto bufferNames = inst->getBufferNames();
+    if (bits.size() > 2) {
+      xacc::error("[SABRE Placement] Gate " + inst->name() + " acts on " +
+                  std::to_string(bits.size()) +
+                  " qubits. Please decompose multi-qubit gates first.");
+    }
+    std::vector<int> qs;
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+      const auto key = std::make_pair(
+          i < bufferNames.size() ? bufferNames[i] : std::string(), bits[i]);
+      auto iter = logicalIdx.find(key);
+      if (iter == logicalIdx.end()) {
+        iter = logicalIdx.emplace(key, (int)logicalIdx.size()).first;
+      }
+      qs.emplace_back(iter->second);
+    }
+    instructions.emplace_back(inst);
+    gateQubits.emplace_back(qs);
+  }
+
+  // Logical qubits are ordered by (buffer, bit) for the default layout.
+  {
+    int idx = 0;
+    std::vector<int> remap(logicalIdx.size());
+    for (auto &[key, l] : logicalIdx) {
+      remap[l] = idx++;
+    }
+    for (auto &qs : gateQubits) {
+      for (auto &q : qs) {
+        q = remap[q];
+      }
+    }
+  }
+
+  const int nLogical = logicalIdx.size();
+  std::vector<int> usablePhys;
+  for (int p = 0; p < coupling.nQubits; ++p) {
+    if (!coupling.neighbors[p].empty()) {
+      usablePhys.emplace_back(p);
+    }
+  }
+  if (nLogical > usablePhys.size()) {
+    xacc::error("[SABRE Placement] The program requires " +
+                std::to_string(nLogical) + " qubits, but the device only has " +
+                std::to_string(usablePhys.size()) + " connected qubits.");
+  }
+
+  const GateDag forwardDag(gateQubits, nLogical, false);
+  const GateDag backwardDag(gateQubits, nLogical, true);
+
+  // Starting layouts: user-provided, else the trivial layout (if valid)
+  // followed by random ones.
+  std::vector<std::vector<int>> startLayouts;
+  if (!initialLayout.empty()) {
+    if (initialLayout.size() < nLogical) {
+      xacc::error("[SABRE Placement] 'initial-layout' is too short.");
+    }
+    initialLayout.resize(nLogical);
+    startLayouts.emplace_back(initialLayout);
+  } else {
+    std::mt19937 rng(seed);
+    if (nLogical <= coupling.nQubits &&
+        std::all_of(usablePhys.begin(), usablePhys.begin() + nLogical,
+                    [&, i = 0](int p) mutable { return p == i++; })) {
+      std::vector<int> trivial(nLogical);
+      std::iota(trivial.begin(), trivial.end(), 0);
+      startLayouts.emplace_back(trivial);
+    }
+    while (startLayouts.size() < nRestarts) {
+      auto phys = usablePhys;
+      std::shuffle(phys.begin(), phys.end(), rng);
+      phys.resize(nLogical);
+      startLayouts.emplace_back(phys);
+    }
+  }
+
+  const auto runRestart = [&](std::size_t restartIdx) {
+    SabreRouter router(coupling, config, seed + 7919 * (restartIdx + 1));
+    auto layout = startLayouts[restartIdx];
+    for (int iter = 0; iter < nIterations; ++iter) {
+      layout = router.route(forwardDag, layout, false).finalLayout;
+      layout = router.route(backwardDag, layout, false).finalLayout;
+    }
+    auto result = router.route(forwardDag, layout, true);
+    // Keep the initial layout of the final pass
+    result.finalLayout = layout;
+    return result;
+  };
+
+  std::vector<RoutingResult> results(startLayouts.size());
+  if (startLayouts.size() == 1 || nThreads == 1) {
+    for (std::size_t i = 0; i < startLayouts.size(); ++i) {
+      results[i] = runRestart(i);
+    }
+  } else {
+    xacc::ThreadPool pool(
+        std::min<std::size_t>(nThreads, startLayouts.size()));
+    std::vector<std::future<RoutingResult>> futures;
+    for (std::size_t i = 0; i < startLayouts.size(); ++i) {
+      futures.emplace_back(pool.enqueue(runRestart, i));
+    }
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+      results[i] = futures[i].get();
+    }
+  }
+
+  std::size_t bestIdx = 0;
+  for (std::size_t i = 1; i < results.size(); ++i) {
+    if (results[i].nSwaps < results[bestIdx].nSwaps) {
+      bestIdx = i;
+    }
+  }
+  const auto &best = results[bestIdx];
+  {
+    std::stringstream ss;
+    ss << "[SABRE Placement] Routed " << instructions.size()
+       << " instructions with " << best.nSwaps << " SWAPs (best of "
+       << results.size() << " restarts). Initial layout:";
+    for (const auto &p : best.finalLayout) {
+      ss << " " << p;
+    }
+    xacc::info(ss.str());
+  }
+
+  // All mapped instructions act on a single physical register.
+  std::string bufferName = "q";
+  if (!program->getBufferNames().empty()) {
+    bufferName = program->getBufferNames()[0];
+  } else if (!instructions.empty() &&
+             !instructions.front()->getBufferNames().empty()) {
+    bufferName = instructions.front()->getBufferNames()[0];
+  }
+  auto provider = xacc::getIRProvider("quantum");
+  std::vector<InstPtr> routed;
+  routed.reserve(best.ops.size());
+  for (const auto &op : best.ops) {
+    if (op.gate < 0) {
+      auto swap = provider->createInstruction(
+          "Swap", {(std::size_t)op.p1, (std::size_t)op.p2});
+      swap->setBufferNames({bufferName, bufferName});
+      routed.emplace_back(swap);
+    } else {
+      auto inst = instructions[op.gate]->clone();
+      std::vector<std::size_t> bits;
+      if (op.p1 >= 0) {
+        bits.emplace_back(op.p1);
+      }
+      if (op.p2 >= 0) {
+        bits.emplace_back(op.p2);
+      }
+      inst->setBits(bits);
+      inst->setBufferNames(std::vector<std::string>(bits.size(), bufferName));
+      routed.emplace_back(inst);
+    }
+  }
+  program->clear();
+  program->addInstructions(std::move(routed), false);
+}
+} // namespace quantum
+} // namespace xacc
+
+REGISTER_IRTRANSFORMATION(xacc::quantum::SabrePlacement)
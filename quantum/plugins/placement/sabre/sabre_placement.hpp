@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+
+#include "IRTransformation.hpp"
+#include "InstructionIterator.hpp"
+
+namespace xacc {
+namespace quantum {
+// SABRE-style qubit mapping and routing
+// (Li, Ding, Xie, "Tackling the Qubit Mapping Problem for NISQ-Era Quantum
+// Devices", ASPLOS 2019).
+// - All-pairs distances are precomputed (BFS) from the Accelerator
+// connectivity.
+// - SWAPs are selected with the front-layer + extended-set lookahead
+// heuristic with decay.
+// - The initial layout is refined by forward/backward (reversed circuit)
+// passes, starting from several random layouts that are routed in parallel;
+// the solution with the least number of SWAPs is kept.
+// Options:
+// - "restarts" (int): number of initial layouts (default: 8)
+// - "iterations" (int): forward/backward refinement rounds (default: 3)
+// - "threads" (int): thread pool size (default: hardware concurrency)
+// - "seed" (int): RNG seed (default: 0)
+// - "extended-set-size" (int): lookahead window (default: 20)
+// - "extended-set-weight" (double): lookahead weight (default: 0.5)
+// - "decay" (double): decay increment to favor parallel SWAPs (default: 0.001)
+// - "initial-layout" (std::vector<int>): logical -> physical qubit; if given,
+//   used as the (only) starting layout.
+class SabrePlacement : public IRTransformation {
+public:
+  SabrePlacement() {}
+  void apply(std::shared_ptr<CompositeInstruction> program,
+             const std::shared_ptr<Accelerator> acc,
+             const HeterogeneousMap &options = {}) override;
+  const IRTransformationType type() const override {
+    return IRTransformationType::Placement;
+  }
+  const std::string name() const override { return "sabre"; }
+  const std::string description() const override {
+    return "SABRE bidirectional lookahead qubit mapping and routing.";
+  }
+};
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,361 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include "InstructionIterator.hpp"
+#include "NoiseModel.hpp"
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <tuple>
+using namespace xacc;
+
+namespace {
+class AcceleratorWithConnectivity : public xacc::Accelerator {
+protected:
+  std::vector<std::pair<int, int>> edges;
+
+public:
+  AcceleratorWithConnectivity(std::vector<std::pair<int, int>> &&connections)
+      : edges(connections) {}
+  const std::string name() const override { return "acc_with_connectivity"; }
+  const std::string description() const override { return ""; }
+  void initialize(const HeterogeneousMap &params = {}) override { return; }
+  void execute(std::shared_ptr<xacc::AcceleratorBuffer> buf,
+               std::shared_ptr<xacc::CompositeInstruction> f) override {}
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   functions) override {}
+  void updateConfiguration(const HeterogeneousMap &config) override {}
+  const std::vector<std::string> configurationKeys() override { return {}; }
+
+  std::vector<std::pair<int, int>> getConnectivity() override { return edges; }
+};
+
+// rows x cols grid coupling map
+std::vector<std::pair<int, int>> gridConnectivity(int rows, int cols) {
+  std::vector<std::pair<int, int>> edges;
+  for (int r = 0; r < rows; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      const int q = r * cols + c;
+      if (c + 1 < cols) {
+        edges.emplace_back(q, q + 1);
+      }
+      if (r + 1 < rows) {
+        edges.emplace_back(q, q + cols);
+      }
+    }
+  }
+  return edges;
+}
+
+// Heavy-hex coupling map with the layout of IBM's 127-qubit devices for
+// (rows, cols) = (7, 15): rows of cols qubits, linked by a bridge qubit every
+// 4 columns (alternately starting at column 0 and 2). The first row has no
+// last column and the last row no first column. Qubits are numbered row by
+// row, not as on the devices, which is irrelevant to routing.
+std::vector<std::pair<int, int>> heavyHexConnectivity(int rows, int cols) {
+  std::vector<std::pair<int, int>> edges;
+  std::vector<std::vector<int>> rowQubits(rows, std::vector<int>(cols, -1));
+  int next = 0;
+  for (int r = 0; r < rows; ++r) {
+    const int first = (r == rows - 1) ? 1 : 0;
+    const int last = (r == 0) ? cols - 2 : cols - 1;
+    for (int c = first; c <= last; ++c) {
+      rowQubits[r][c] = next++;
+      if (c > first) {
+        edges.emplace_back(rowQubits[r][c - 1], rowQubits[r][c]);
+      }
+    }
+    if (r > 0) {
+      for (int c = (r % 2) ? 0 : 2; c < cols; c += 4) {
+        if (rowQubits[r - 1][c] >= 0 && rowQubits[r][c] >= 0) {
+          const int bridge = next++;
+          edges.emplace_back(rowQubits[r - 1][c], bridge);
+          edges.emplace_back(bridge, rowQubits[r][c]);
+        }
+      }
+    }
+  }
+  return edges;
+}
+
+std::shared_ptr<CompositeInstruction> randomCircuit(int nQubits, int nCnots,
+                                                    unsigned seed) {
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("random_" + std::to_string(seed));
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> dist(0, nQubits - 1);
+  for (int i = 0; i < nCnots; ++i) {
+    const std::size_t a = dist(rng);
+    std::size_t b = dist(rng);
+    while (b == a) {
+      b = dist(rng);
+    }
+    program->addInstruction(provider->createInstruction("H", {a}));
+    program->addInstruction(provider->createInstruction("CNOT", {a, b}));
+  }
+  return program;
+}
+
+// Check that all 2-qubit gates are on coupled qubits.
+bool isRouted(std::shared_ptr<CompositeInstruction> program,
+              const std::vector<std::pair<int, int>> &edges) {
+  std::set<std::pair<int, int>> coupled;
+  for (const auto &[a, b] : edges) {
+    coupled.emplace(a, b);
+    coupled.emplace(b, a);
+  }
+  InstructionIterator it(program);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (!inst->isComposite() && inst->bits().size() == 2 &&
+        coupled.count(std::make_pair((int)inst->bits()[0], (int)inst->bits()[1])) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int countInstructions(std::shared_ptr<CompositeInstruction> program,
+                      const std::string &name) {
+  int count = 0;
+  InstructionIterator it(program);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (!inst->isComposite() && inst->name() == name) {
+      count++;
+    }
+  }
+  return count;
+}
+} // namespace
+
+TEST(SabrePlacementTester, checkSimple) {
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(
+      std::vector<std::pair<int, int>>{{0, 1}, {1, 2}});
+  auto irt = xacc::getIRTransformation("sabre");
+  auto compiler = xacc::getCompiler("xasm");
+  auto program = compiler->compile(R"(__qpu__ void test_sabre_simple(qreg q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      CX(q[1], q[2]);
+      CX(q[0], q[2]);
+      Measure(q[0]);
+      Measure(q[1]);
+      Measure(q[2]);
+  })")->getComposite("test_sabre_simple");
+
+  irt->apply(program, nullptr);
+  EXPECT_EQ(7, program->nInstructions());
+
+  irt->apply(program, qpu, {{"seed", 1}});
+  // A triangle on a line needs exactly one SWAP
+  EXPECT_EQ(1, countInstructions(program, "Swap"));
+  EXPECT_EQ(8, program->nInstructions());
+  EXPECT_EQ(3, countInstructions(program, "Measure"));
+  EXPECT_TRUE(isRouted(program, qpu->getConnectivity()));
+}
+
+TEST(SabrePlacementTester, checkNoSwapNeeded) {
+  auto edges = gridConnectivity(2, 3);
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(std::move(edges));
+  auto irt = xacc::getIRTransformation("sabre");
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("chain");
+  // A linear chain of CNOTs can always be embedded into a grid.
+  for (std::size_t i = 0; i < 5; ++i) {
+    program->addInstruction(provider->createInstruction("CNOT", {i, i + 1}));
+  }
+  irt->apply(program, qpu, {{"restarts", 4}});
+  EXPECT_EQ(0, countInstructions(program, "Swap"));
+  EXPECT_EQ(5, program->nInstructions());
+  EXPECT_TRUE(isRouted(program, qpu->getConnectivity()));
+}
+
+TEST(SabrePlacementTester, checkInitialLayout) {
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(
+      std::vector<std::pair<int, int>>{{0, 1}, {1, 2}, {2, 3}});
+  auto irt = xacc::getIRTransformation("sabre");
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("layout");
+  program->addInstruction(provider->createInstruction("CNOT", {0, 1}));
+  irt->apply(program, qpu,
+             {{"initial-layout", std::vector<int>{3, 2}}, {"iterations", 0}});
+  EXPECT_EQ(1, program->nInstructions());
+  EXPECT_EQ(3, program->getInstruction(0)->bits()[0]);
+  EXPECT_EQ(2, program->getInstruction(0)->bits()[1]);
+}
+
+TEST(SabrePlacementTester, checkRandomCircuits) {
+  auto edges = gridConnectivity(4, 4);
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(
+      gridConnectivity(4, 4));
+  auto irt = xacc::getIRTransformation("sabre");
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    auto program = randomCircuit(16, 50, seed);
+    irt->apply(program, qpu, {{"seed", (int)seed}});
+    EXPECT_TRUE(isRouted(program, edges));
+    EXPECT_EQ(50, countInstructions(program, "CNOT"));
+    EXPECT_EQ(50, countInstructions(program, "H"));
+  }
+}
+
+// Routing benchmarks (disabled by default; run with
+// --gtest_also_run_disabled_tests).
+// Compare SWAP overhead (in CNOTs) and routing time against the other
+// placement passes:
+//  - staq swap-shortest-path and TriQ on random circuits,
+//  - minor-graph-embedding-placement, which does not insert SWAPs, on
+//    circuits admitting a SWAP-free placement.
+TEST(SabrePlacementTester, DISABLED_benchmarkRouters) {
+  const int rows = 4;
+  const int cols = 5;
+  const int nQubits = rows * cols;
+  auto edges = gridConnectivity(rows, cols);
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(
+      gridConnectivity(rows, cols));
+  auto sabre = xacc::getIRTransformation("sabre");
+  // Large enough for all the coupling maps below
+  auto buffer = xacc::qalloc(127);
+  buffer->setName("q");
+  xacc::storeBuffer(buffer);
+
+  // Random circuit, with buffer names (needed by the staq-based passes)
+  const auto makeCircuit = [](int in_nQubits, int in_nCnots) {
+    auto program = randomCircuit(in_nQubits, in_nCnots, in_nCnots);
+    InstructionIterator it(program);
+    while (it.hasNext()) {
+      auto inst = it.next();
+      inst->setBufferNames(std::vector<std::string>(inst->bits().size(), "q"));
+    }
+    return program;
+  };
+  // SWAP overhead (in CNOTs) and routing time (ms) of a pass.
+  const auto route = [](const std::string &in_pass,
+                        std::shared_ptr<CompositeInstruction> io_program,
+                        std::shared_ptr<Accelerator> in_qpu, int in_nCnots,
+                        const HeterogeneousMap &in_options = {}) {
+    auto irt = xacc::getIRTransformation(in_pass);
+    const auto start = std::chrono::high_resolution_clock::now();
+    irt->apply(io_program, in_qpu, in_options);
+    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+    // swap-shortest-path and TriQ expand SWAPs into 3 CNOTs.
+    const int overhead = 3 * countInstructions(io_program, "Swap") +
+                         countInstructions(io_program, "CNOT") - in_nCnots;
+    return std::make_pair(overhead, time);
+  };
+
+  // Random circuits on the grid and on a 127-qubit heavy-hex device
+  const auto heavyHex = heavyHexConnectivity(7, 15);
+  const std::vector<std::tuple<std::string, int, std::vector<std::pair<int, int>>>>
+      topologies{{std::to_string(rows) + "x" + std::to_string(cols) + " grid",
+                  nQubits, edges},
+                 {"127-qubit heavy-hex", 127, heavyHex}};
+  for (const auto &[topology, nTopologyQubits, topologyEdges] : topologies) {
+    auto topologyQpu = std::make_shared<AcceleratorWithConnectivity>(
+        std::vector<std::pair<int, int>>(topologyEdges));
+    for (const int nCnots : {50, 200, 500, 2000}) {
+      auto p1 = makeCircuit(nTopologyQubits, nCnots);
+      const auto [sabreOverhead, sabreTime] =
+          route("sabre", p1, topologyQpu, nCnots);
+      EXPECT_TRUE(isRouted(p1, topologyEdges));
+      std::cout << "[" << topology << ", " << nCnots
+                << " CNOTs] SWAP overhead (CNOTs): sabre = " << sabreOverhead
+                << " (" << sabreTime << " ms)";
+      if (xacc::hasService<IRTransformation>("swap-shortest-path")) {
+        const auto [overhead, time] =
+            route("swap-shortest-path", makeCircuit(nTopologyQubits, nCnots),
+                  topologyQpu, nCnots);
+        std::cout << ", swap-shortest-path = " << overhead << " (" << time
+                  << " ms)";
+      }
+      std::cout << "\n";
+    }
+  }
+
+  // A CNOT ladder along a path of the grid: no SWAP needed, the passes
+  // only differ by the time to find the placement.
+  if (xacc::hasService<IRTransformation>("minor-graph-embedding-placement")) {
+    auto provider = xacc::getIRProvider("quantum");
+    const std::size_t ladderLength = nQubits / 2;
+    const auto makeLadder = [&]() {
+      auto program = provider->createComposite("ladder");
+      for (int layer = 0; layer < 10; ++layer) {
+        for (std::size_t i = 0; i + 1 < ladderLength; ++i) {
+          program->addInstruction(
+              provider->createInstruction("CNOT", {i, i + 1}));
+        }
+      }
+      return program;
+    };
+    const int nCnots = 10 * (ladderLength - 1);
+    const auto [sabreOverhead, sabreTime] =
+        route("sabre", makeLadder(), qpu, nCnots);
+    const auto [mgeOverhead, mgeTime] =
+        route("minor-graph-embedding-placement", makeLadder(), qpu, nCnots,
+              {{"embedding-cache", false}});
+    std::cout << "[" << rows << "x" << cols << " grid, " << nCnots
+              << " CNOT ladder] SWAP overhead (CNOTs): sabre = "
+              << sabreOverhead << " (" << sabreTime
+              << " ms), minor-graph-embedding-placement = " << mgeOverhead
+              << " (" << mgeTime << " ms)\n";
+  }
+
+  // TriQ needs a device model: IBM Melbourne from the TriQ test resources,
+  // whose coupling map is that of its CNOT calibration data.
+  if (xacc::hasService<IRTransformation>("triQ")) {
+    std::ifstream inFile(std::string(TRIQ_RESOURCE_DIR) + "/backend.json");
+    std::stringstream strStream;
+    strStream << inFile.rdbuf();
+    const std::string jsonStr = strStream.str();
+    auto noiseModel = xacc::getService<NoiseModel>("IBM");
+    noiseModel->initialize({{"backend-json", jsonStr}});
+    std::vector<std::pair<int, int>> deviceEdges;
+    for (const auto &[q1, q2, fidelity] :
+         noiseModel->averageTwoQubitGateFidelity()) {
+      deviceEdges.emplace_back(q1, q2);
+    }
+    auto device = std::make_shared<AcceleratorWithConnectivity>(
+        std::vector<std::pair<int, int>>(deviceEdges));
+    const int nDeviceQubits = noiseModel->nQubits();
+    for (const int nCnots : {20, 50, 100}) {
+      auto p1 = makeCircuit(nDeviceQubits, nCnots);
+      const auto [sabreOverhead, sabreTime] =
+          route("sabre", p1, device, nCnots);
+      EXPECT_TRUE(isRouted(p1, deviceEdges));
+      const auto [triqOverhead, triqTime] =
+          route("triQ", makeCircuit(nDeviceQubits, nCnots), device, nCnots,
+                {{"backend-json", jsonStr}});
+      std::cout << "[" << noiseModel->name() << " " << nDeviceQubits
+                << "-qubit device, " << nCnots
+                << " CNOTs] SWAP overhead (CNOTs): sabre = " << sabreOverhead
+                << " (" << sabreTime << " ms), triQ = " << triqOverhead
+                << " (" << triqTime << " ms)\n";
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
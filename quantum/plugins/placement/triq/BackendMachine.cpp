@@ -1,30 +1,75 @@
 #include "BackendMachine.hpp"
 #include "NoiseModel.hpp"
 #include "xacc.hpp"
+#include "xacc_service.hpp"
+#include "CompositeInstruction.hpp"
+#include <cstdlib>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 namespace {
-// Returns the temp. file name
-template <typename RowIterFn>
-std::string createConfigFile(size_t in_nbRows, RowIterFn rowIter) {
-  std::stringstream ss;
-  ss << in_nbRows << "\n";
-  for (size_t i = 0; i < in_nbRows; ++i) {
-    ss << rowIter(i) << "\n";
+// TriQ's Machine loads its calibration data from files, given by name.
+// On Linux, the file is an anonymous in-memory file (memfd), accessed through
+// /proc/self/fd; elsewhere, it's a temp. file (honoring TMPDIR), removed on
+// destruction.
+class ConfigFile {
+public:
+  template <typename RowIterFn>
+  ConfigFile(size_t in_nbRows, RowIterFn rowIter) {
+    std::stringstream ss;
+    ss << in_nbRows << "\n";
+    for (size_t i = 0; i < in_nbRows; ++i) {
+      ss << rowIter(i) << "\n";
+    }
+    const std::string contents = ss.str();
+#ifdef __linux__
+    m_fd = memfd_create("triq_config", 0);
+    if (m_fd != -1) {
+      m_fileName = "/proc/self/fd/" + std::to_string(m_fd);
+    }
+#endif
+    if (m_fd == -1) {
+      const char *tmpDir = std::getenv("TMPDIR");
+      std::string fnTemplate =
+          std::string(tmpDir ? tmpDir : "/tmp") + "/ConfigXXXXXX";
+      m_fd = mkstemp(&fnTemplate[0]);
+      if (m_fd == -1) {
+        xacc::error("Failed to create a temporary file.");
+      }
+      m_fileName = fnTemplate;
+      m_isTempFile = true;
+    }
+    for (size_t written = 0; written < contents.size();) {
+      const auto ret = write(m_fd, contents.data() + written,
+                             contents.size() - written);
+      if (ret <= 0) {
+        xacc::error("Failed to write the TriQ configuration.");
+      }
+      written += ret;
+    }
   }
-  char fnTemplate[] = "/tmp/ConfigXXXXXX";
-  if (mkstemp(fnTemplate) == -1) {
-    xacc::error("Failed to create a temporary file.");
+  ConfigFile(const ConfigFile &) = delete;
+  ConfigFile &operator=(const ConfigFile &) = delete;
+  ~ConfigFile() {
+    close(m_fd);
+    if (m_isTempFile) {
+      remove(m_fileName.c_str());
+    }
   }
-  const std::string configFilename(fnTemplate);
-  std::ofstream inFile(configFilename);
-  inFile << ss.str();
-  return configFilename;
-}
+  const std::string &fileName() const { return m_fileName; }
+
+private:
+  int m_fd = -1;
+  std::string m_fileName;
+  bool m_isTempFile = false;
+};
 } // namespace
 
 namespace xacc {
 BackendMachine::BackendMachine(const NoiseModel &backendNoiseModel) {
-  // Generates the three config files the initialize the base class:
+  // Generates the three config files to initialize the base class:
   const size_t nbQubits = backendNoiseModel.nQubits();
   nQ = nbQubits;
   for (size_t i = 0; i < nbQubits; ++i) {
@@ -33,19 +78,18 @@ BackendMachine::BackendMachine(const NoiseModel &backendNoiseModel) {
 
   // Query fidelity information:
   const auto roErrors = backendNoiseModel.readoutErrors();
-  const auto mFileName =
-      createConfigFile(roErrors.size(), [&roErrors](size_t in_idx) {
-        std::stringstream ss;
-        const auto [meas0Prep1, meas1Prep0] = roErrors[in_idx];
-        const double avgRoFidelity =
-            0.5 * ((1.0 - meas0Prep1) + (1.0 - meas1Prep0));
-        ss << in_idx << " " << avgRoFidelity;
-        return ss.str();
-      });
+  const ConfigFile mFile(roErrors.size(), [&roErrors](size_t in_idx) {
+    std::stringstream ss;
+    const auto [meas0Prep1, meas1Prep0] = roErrors[in_idx];
+    const double avgRoFidelity =
+        0.5 * ((1.0 - meas0Prep1) + (1.0 - meas1Prep0));
+    ss << in_idx << " " << avgRoFidelity;
+    return ss.str();
+  });
 
   const auto singleQubitFidelity =
       backendNoiseModel.averageSingleQubitGateFidelity();
-  const auto sFileName = createConfigFile(
+  const ConfigFile sFile(
       singleQubitFidelity.size(), [&singleQubitFidelity](size_t in_idx) {
         std::stringstream ss;
         ss << in_idx << " " << singleQubitFidelity[in_idx];
@@ -81,7 +125,7 @@ BackendMachine::BackendMachine(const NoiseModel &backendNoiseModel) {
   }();
   assert(twoQubitFidelityAvg.size() * 2 == twoQubitFidelity.size());
   xacc::info("Two-qubit fidelity data: ");
-  const auto tFileName = createConfigFile(
+  const ConfigFile tFile(
       twoQubitFidelityAvg.size(), [&twoQubitFidelityAvg](size_t in_idx) {
         std::stringstream ss;
         const auto [q1, q2, fidelity] = twoQubitFidelityAvg[in_idx];
@@ -96,19 +140,14 @@ BackendMachine::BackendMachine(const NoiseModel &backendNoiseModel) {
       std::cout.rdbuf(NULL);
     }
     // Load to TriQ Machine model
-    read_s_reliability(sFileName);
-    read_m_reliability(mFileName);
-    read_t_reliability(tFileName);
+    read_s_reliability(sFile.fileName());
+    read_m_reliability(mFile.fileName());
+    read_t_reliability(tFile.fileName());
     compute_swap_paths();
     print_swap_paths();
     compute_swap_info();
     std::cout.rdbuf(origBuf);
   }
-
-  // Clean-up the temporary files.
-  remove(sFileName.c_str());
-  remove(mFileName.c_str());
-  remove(tFileName.c_str());
 }
 
 void XaccTargetter::print_header(std::ofstream &out_file) {
@@ -170,4 +209,63 @@ void XaccTargetter::print_measure_ops(std::ofstream &out_file) {
   }
 }
 void XaccTargetter::print_footer(std::ofstream &out_file) {}
+
+void XaccTargetter::to_xacc_ir(::Circuit *C,
+                               std::shared_ptr<CompositeInstruction> result,
+                               const std::string &bufferName) {
+  // QASM gate name (as printed by print_code) to XACC gate name
+  static const std::map<std::string, std::string> qasmToXacc{
+      {"cx", "CNOT"}, {"cz", "CZ"},   {"swap", "Swap"}, {"h", "H"},
+      {"x", "X"},     {"y", "Y"},     {"z", "Z"},       {"s", "S"},
+      {"sdg", "Sdg"}, {"t", "T"},     {"tdg", "Tdg"},   {"rx", "Rx"},
+      {"ry", "Ry"},   {"rz", "Rz"},   {"u1", "U"},      {"u2", "U"},
+      {"u3", "U"},    {"id", "I"}};
+  auto provider = xacc::getIRProvider("quantum");
+  std::vector<InstPtr> instructions;
+  instructions.reserve(C->gates.size() + final_map.size());
+  for (auto g : C->gates) {
+    // Same filtering as the code printer
+    if (typeid(*g) == typeid(MeasZ)) {
+      continue;
+    }
+    if (typeid(*g) == typeid(U1) && g->lambda == 0) {
+      continue;
+    }
+    const auto qasmName = gate_print_ibm[typeid(*g)];
+    const auto iter = qasmToXacc.find(qasmName);
+    if (iter == qasmToXacc.end()) {
+      xacc::error("TriQ: unsupported gate '" + qasmName + "'.");
+    }
+    std::vector<std::size_t> bits;
+    for (const auto &var : g->vars) {
+      bits.emplace_back(var->id);
+    }
+    std::vector<InstructionParameter> params;
+    if (typeid(*g) == typeid(U1)) {
+      params = {0.0, 0.0, g->lambda};
+    } else if (typeid(*g) == typeid(U2)) {
+      params = {M_PI / 2.0, g->phi, g->lambda};
+    } else if (typeid(*g) == typeid(U3)) {
+      params = {g->theta, g->phi, g->lambda};
+    } else if (typeid(*g) == typeid(RX) || typeid(*g) == typeid(RY) ||
+               typeid(*g) == typeid(RZ)) {
+      params = {g->theta};
+    }
+    auto inst = provider->createInstruction(iter->second, bits, params);
+    inst->setBufferNames(std::vector<std::string>(bits.size(), bufferName));
+    instructions.emplace_back(inst);
+  }
+  // Measure ops (ordered by program qubit for reproducibility)
+  std::map<int, int> progToHwQubit;
+  for (const auto &[q, hwq] : final_map) {
+    progToHwQubit.emplace(q->id, hwq);
+  }
+  for (const auto &[q, hwq] : progToHwQubit) {
+    auto meas = provider->createInstruction("Measure", (std::size_t)hwq);
+    meas->setBufferNames({bufferName});
+    instructions.emplace_back(meas);
+  }
+  // Routed gates are valid by construction, skip validation.
+  result->addInstructions(std::move(instructions), false);
+}
 } // namespace xacc
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "machine.hpp"
 #include "targetter.hpp"
+#include <memory>
 namespace xacc {
 class NoiseModel;
+class CompositeInstruction;
 // Override TriQ's Machine class
 class BackendMachine : public ::Machine {
 public:
@@ -27,5 +29,10 @@ public:
   virtual void print_measure_ops(ofstream &out_file) override;
   virtual void print_footer(ofstream &out_file) override;
   void add_gate_print_maps();
+  // Direct TriQ circuit -> XACC IR conversion (equivalent to print_code
+  // followed by OpenQASM compilation, without the text round trip)
+  void to_xacc_ir(::Circuit *C,
+                  std::shared_ptr<xacc::CompositeInstruction> result,
+                  const std::string &bufferName);
 };
 } // namespace xacc
\ No newline at end of file
@@ -99,6 +99,84 @@ TEST(TriQPlacementTester, checkSimple) {
   EXPECT_GT(buffer->computeMeasurementProbability("111"), 0.35);
 }
 
+// The same TriQ instance is used for a batch of circuits:
+// the backend machine model is parsed once and reused.
+TEST(TriQPlacementTester, checkBatchSameBackend) {
+  const std::string BACKEND_JSON_FILE =
+      std::string(RESOURCE_DIR) + "/backend.json";
+  std::ifstream inFile;
+  inFile.open(BACKEND_JSON_FILE);
+  std::stringstream strStream;
+  strStream << inFile.rdbuf();
+  const std::string jsonStr = strStream.str();
+  auto irt = xacc::getIRTransformation("triQ");
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  for (int i = 0; i < 3; ++i) {
+    auto ir = xasmCompiler->compile(
+        "__qpu__ void ghz_batch_" + std::to_string(i) + R"((qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      CX(q[1], q[2]);
+      CX(q[0], q[2]);
+      Measure(q[0]);
+      Measure(q[1]);
+      Measure(q[2]);
+})");
+    auto program = ir->getComposites()[0];
+    irt->apply(program, nullptr, {{"backend-json", jsonStr}});
+    int nbMeasures = 0;
+    for (size_t instIdx = 0; instIdx < program->nInstructions(); ++instIdx) {
+      auto instPtr = program->getInstruction(instIdx);
+      if (instPtr->name() == "Measure") {
+        nbMeasures++;
+      }
+      if (instPtr->bits().size() == 2) {
+        const size_t q0 = instPtr->bits()[0];
+        const size_t q1 = instPtr->bits()[1];
+        EXPECT_NE(q0, q1);
+        // No q0-q2 connection on Melbourne
+        EXPECT_FALSE((q0 == 0 && q1 == 2) || (q0 == 2 && q1 == 0));
+      }
+    }
+    EXPECT_EQ(nbMeasures, 3);
+  }
+}
+
+// Gates without a TriQ equivalent (CPhase) go through the Staq translation.
+TEST(TriQPlacementTester, checkStaqFallback) {
+  const std::string BACKEND_JSON_FILE =
+      std::string(RESOURCE_DIR) + "/backend.json";
+  std::ifstream inFile;
+  inFile.open(BACKEND_JSON_FILE);
+  std::stringstream strStream;
+  strStream << inFile.rdbuf();
+  const std::string jsonStr = strStream.str();
+  auto irt = xacc::getIRTransformation("triQ");
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void cphase_fallback(qbit q) {
+      H(q[0]);
+      CPhase(q[0], q[2], 0.5);
+      Measure(q[0]);
+      Measure(q[2]);
+})");
+  auto program = ir->getComposites()[0];
+  irt->apply(program, nullptr, {{"backend-json", jsonStr}});
+  int nbMeasures = 0;
+  for (size_t instIdx = 0; instIdx < program->nInstructions(); ++instIdx) {
+    auto instPtr = program->getInstruction(instIdx);
+    EXPECT_NE(instPtr->name(), "CPhase");
+    if (instPtr->name() == "Measure") {
+      nbMeasures++;
+    }
+    if (instPtr->bits().size() == 2) {
+      const size_t q0 = instPtr->bits()[0];
+      const size_t q1 = instPtr->bits()[1];
+      EXPECT_FALSE((q0 == 0 && q1 == 2) || (q0 == 2 && q1 == 0));
+    }
+  }
+  EXPECT_EQ(nbMeasures, 2);
+}
+
 // Note: this test took a long time to complete.
 // Hence, we don't enable it by default.
 // Test the edge case whereby one qubit becomes effectively
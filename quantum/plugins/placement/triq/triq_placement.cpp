@@ -24,6 +24,7 @@
 #include "optimize_1q.hpp"
 #include "BackendMachine.hpp"
 #include "NoiseModel.hpp"
+#include <set>
 
 namespace {
 std::string xaccGateToTriqGate(const std::string &in_xaccGateName) {
@@ -41,9 +42,69 @@ std::string xaccGateToTriqGate(const std::string &in_xaccGateName) {
     return "RZ";
   } else if (in_xaccGateName == "Swap") {
     return "SWAP";
+  } else if (in_xaccGateName == "U") {
+    return "U3";
   }
   return in_xaccGateName;
 }
+
+// Carry gate angles over to TriQ so that they are preserved by the
+// direct IR reconstruction.
+void setTriqGateParams(::Gate *pG, xacc::InstPtr xaccInst) {
+  const auto params = xaccInst->getParameters();
+  if (params.empty() || !params[0].isNumeric()) {
+    return;
+  }
+  const std::string gateName = xaccInst->name();
+  if (gateName == "Rx" || gateName == "Ry" || gateName == "Rz") {
+    pG->theta = xacc::InstructionParameterToDouble(params[0]);
+  } else if (gateName == "U" && params.size() == 3) {
+    pG->theta = xacc::InstructionParameterToDouble(params[0]);
+    pG->phi = xacc::InstructionParameterToDouble(params[1]);
+    pG->lambda = xacc::InstructionParameterToDouble(params[2]);
+  }
+}
+
+// Flattens the circuit in place if all its gates have a TriQ equivalent
+// (see xaccGateToTriqGate), with bound parameters, on a single register.
+// Returns false otherwise (e.g. CPhase, Reset, conditionals), in which case
+// the circuit is left unchanged.
+bool flattenToTriqGates(std::shared_ptr<xacc::CompositeInstruction> io_function) {
+  static const std::set<std::string> triqGates{
+      "H",  "X",  "Y",  "Z", "S",    "Sdg",  "T",    "Tdg",
+      "Rx", "Ry", "Rz", "U", "CNOT", "CZ",   "Swap", "Measure"};
+  std::vector<xacc::InstPtr> instructions;
+  std::string bufferName;
+  xacc::InstructionIterator it(io_function);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (inst->isComposite() && inst->name() == "ifstmt") {
+      return false;
+    }
+    if (!inst->isEnabled() || inst->isComposite() || inst->name() == "I") {
+      continue;
+    }
+    if (triqGates.find(inst->name()) == triqGates.end()) {
+      return false;
+    }
+    for (const auto &param : inst->getParameters()) {
+      if (!param.isNumeric()) {
+        return false;
+      }
+    }
+    for (const auto &name : inst->getBufferNames()) {
+      if (bufferName.empty()) {
+        bufferName = name;
+      } else if (name != bufferName) {
+        return false;
+      }
+    }
+    instructions.emplace_back(inst);
+  }
+  io_function->clear();
+  io_function->addInstructions(std::move(instructions), false);
+  return true;
+}
 } // namespace
 namespace xacc {
 namespace quantum {
@@ -100,14 +161,14 @@ void TriQPlacement::apply(std::shared_ptr<CompositeInstruction> function,
     xacc::warning("No backend information was provided. Skipped!");
     return;
   }
-  // Step 1: make sure the circuit is in OpenQASM dialect,
-  // i.e. using the Staq compiler to translate.
-  auto staq = xacc::getCompiler("staq");
-  const auto openQASMSrc = staq->translate(function);
-  // std::cout << "Before placement: \n" << openQASMSrc << "\n";
-  auto ir = staq->compile(openQASMSrc);
-  function->clear();
-  function->addInstructions(ir->getComposites()[0]->getInstructions());
+  // Step 1: flatten the circuit to the TriQ gate set. Circuits with other
+  // gates are translated to the OpenQASM dialect by the Staq compiler.
+  if (!flattenToTriqGates(function)) {
+    auto staq = xacc::getCompiler("staq");
+    auto ir = staq->compile(staq->translate(function));
+    function->clear();
+    function->addInstructions(ir->getComposites()[0]->getInstructions());
+  }
 
   // Step 2: construct TriQ's Circuit
   Circuit triqCirc;
@@ -115,12 +176,13 @@ void TriQPlacement::apply(std::shared_ptr<CompositeInstruction> function,
   for (size_t i = 0; i < nbQubits; i++) {
     triqCirc.qubits.push_back(new ProgQubit(i));
   }
-  // Assuming the circuit has been flattened (after Staq translation)
+  // The circuit has been flattened (step 1)
   for (size_t instIdx = 0; instIdx < function->nInstructions(); ++instIdx) {
     auto xaccInst = function->getInstruction(instIdx);
     const std::string gateName = xaccInst->name();
     ::Gate *pG = ::Gate::create_new_gate(xaccGateToTriqGate(gateName));
     pG->id = instIdx;
+    setTriqGateParams(pG, xaccInst);
     // Make sure the expected number of qubits matched for each gate
     assert(xaccInst->bits().size() == pG->nvars);
     for (const auto& qubitIdx : xaccInst->bits()) {
@@ -149,35 +211,77 @@ void TriQPlacement::apply(std::shared_ptr<CompositeInstruction> function,
   }
   // DEBUG:
   // triqCirc.print_gates();
-  auto backendNoiseModel = providedNoiseModel
-                               ? xacc::as_shared_ptr(providedNoiseModel)
-                               : xacc::getService<xacc::NoiseModel>("IBM");
-  if (!backendName.empty()) {
-    backendNoiseModel->initialize({{"backend", backendName}});
-  } else {
-    backendNoiseModel->initialize({{"backend-json", backendJson}});
-  }
-
-  BackendMachine backendModel(*backendNoiseModel);
+  auto backendModel =
+      getBackendMachine(backendName, backendJson, providedNoiseModel);
   // Step 3: Run TriQ (placement + optimize) for this backend
-  // TriQ outputs a lot to std::cout, hence we need to bypass its logs. 
+  // TriQ outputs a lot to std::cout, hence we need to bypass its logs.
   std::cout << std::flush;
   auto origBuf = std::cout.rdbuf();
   if (!xacc::verbose) {
     std::cout.rdbuf(NULL);
   }
-  const auto resultQasm = runTriQ(triqCirc, backendModel, compileAlgo, approxFactor);
+  // Step 4: Reconstruct the Composite directly from TriQ's routed circuit
+  auto provider = xacc::getIRProvider("quantum");
+  auto routed = provider->createComposite(function->name());
+  std::string bufferName = "q";
+  if (!function->getBufferNames().empty()) {
+    bufferName = function->getBufferNames()[0];
+  } else if (function->nInstructions() > 0 &&
+             !function->getInstruction(0)->getBufferNames().empty()) {
+    bufferName = function->getInstruction(0)->getBufferNames()[0];
+  }
+  routed->setBufferNames({bufferName});
+  runTriQ(triqCirc, *backendModel, compileAlgo, approxFactor, routed);
   std::cout.rdbuf(origBuf);
-  // DEBUG:
-  // std::cout << "After placement: \n" << resultQasm << "\n";
-  // Step 4: Reconstruct the Composite
-  auto newIr = staq->compile(resultQasm);
   function->clear();
-  function->addInstructions(newIr->getComposites()[0]->getInstructions());
+  function->addInstructions(routed->getInstructions());
 }
 
-std::string TriQPlacement::runTriQ(Circuit &program, Machine &machine,
-                                   int algorithmSelector, double approxFactor) const {
+std::shared_ptr<BackendMachine>
+TriQPlacement::getBackendMachine(const std::string &backendName,
+                                 const std::string &backendJson,
+                                 xacc::NoiseModel *providedNoiseModel) {
+  // Key on the calibration data rather than the backend type: the backend
+  // JSON if that's all the noise model is initialized from, otherwise the
+  // JSON of the initialized noise model (e.g. a backend fetched by name,
+  // whose calibration data may have changed).
+  const std::string noiseModelName =
+      providedNoiseModel ? providedNoiseModel->name() : "IBM";
+  std::shared_ptr<xacc::NoiseModel> backendNoiseModel;
+  std::string cacheKey;
+  if (backendName.empty() && !providedNoiseModel) {
+    cacheKey = noiseModelName + ":json:" +
+               std::to_string(std::hash<std::string>{}(backendJson));
+  } else {
+    backendNoiseModel = providedNoiseModel
+                            ? xacc::as_shared_ptr(providedNoiseModel)
+                            : xacc::getService<xacc::NoiseModel>("IBM");
+    if (!backendName.empty()) {
+      backendNoiseModel->initialize({{"backend", backendName}});
+    } else {
+      backendNoiseModel->initialize({{"backend-json", backendJson}});
+    }
+    cacheKey = noiseModelName + ":model:" +
+               std::to_string(
+                   std::hash<std::string>{}(backendNoiseModel->toJson()));
+  }
+  std::lock_guard<std::mutex> lock(m_machineCacheMutex);
+  auto iter = m_machineCache.find(cacheKey);
+  if (iter != m_machineCache.end()) {
+    return iter->second;
+  }
+  if (!backendNoiseModel) {
+    backendNoiseModel = xacc::getService<xacc::NoiseModel>("IBM");
+    backendNoiseModel->initialize({{"backend-json", backendJson}});
+  }
+  auto machine = std::make_shared<BackendMachine>(*backendNoiseModel);
+  m_machineCache.emplace(cacheKey, machine);
+  return machine;
+}
+
+void TriQPlacement::runTriQ(
+    Circuit &program, Machine &machine, int algorithmSelector,
+    double approxFactor, std::shared_ptr<CompositeInstruction> result) const {
   ::Mapper pMapper(&machine, &program);
   pMapper.set_config(MapSum, VarUnique);
   pMapper.config.approx_factor = approxFactor;
@@ -217,23 +321,14 @@ std::string TriQPlacement::runTriQ(Circuit &program, Machine &machine,
   // is not very stable (crash)
   // OptimizeSingleQubitOps sq_opt(C_trans);
   // auto C_1q_opt = sq_opt.test_optimize();
-  char fnTemplate[] = "/tmp/CircuitXXXXXX";
-  if (mkstemp(fnTemplate) == -1) {
-    xacc::error("Failed to create a temporary file.");
-  }
-  const std::string outFilename(fnTemplate);
-  Tgen.print_code(C_trans, outFilename);
-  
+  const auto bufferNames = result->getBufferNames();
+  Tgen.to_xacc_ir(C_trans, result,
+                  bufferNames.empty() ? "q" : bufferNames[0]);
+
   if (C_trans) {
     delete C_trans;
   }
   delete torder;
-  // Load the output QASM:
-  std::ifstream outFile(outFilename);
-  std::string optSrc((std::istreambuf_iterator<char>(outFile)), std::istreambuf_iterator<char>());
-  // Delete the temporary file
-  remove(outFilename.c_str());  
-  return optSrc;
 }
 } // namespace quantum
 } // namespace xacc
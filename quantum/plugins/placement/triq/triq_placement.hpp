@@ -16,6 +16,7 @@
 #include "xacc.hpp"
 #include "IRTransformation.hpp"
 #include "InstructionIterator.hpp"
+#include <mutex>
 
 using namespace xacc;
 // Forward declarations
@@ -23,6 +24,8 @@ class Circuit;
 class Machine;
 
 namespace xacc {
+class BackendMachine;
+class NoiseModel;
 namespace quantum {
 
 class TriQPlacement : public xacc::IRTransformation {
@@ -38,8 +41,18 @@ public:
   const std::string name() const override { return "triQ"; }
   const std::string description() const override { return ""; }
 private:
-  // Returns the QASM source string after placement
-  std::string runTriQ(Circuit& program, Machine& machine, int algorithmSelector, double approxFactor) const;
+  // Run TriQ and write the routed circuit to the result composite
+  void runTriQ(Circuit &program, Machine &machine, int algorithmSelector,
+               double approxFactor,
+               std::shared_ptr<CompositeInstruction> result) const;
+  // Get the (cached) TriQ machine model for the backend
+  std::shared_ptr<BackendMachine>
+  getBackendMachine(const std::string &backendName,
+                    const std::string &backendJson,
+                    xacc::NoiseModel *providedNoiseModel);
+  // Parsed machine/calibration models, keyed by backend
+  std::map<std::string, std::shared_ptr<BackendMachine>> m_machineCache;
+  std::mutex m_machineCacheMutex;
 };
 } // namespace quantum
 } // namespace xacc
@@ -13,7 +13,9 @@
 #include "QppAccelerator.hpp"
 #include <thread>
 #include <mutex>
-#include "IRUtils.hpp"
+#include "PrefixTrie.hpp"
+#include "ShotBranching.hpp"
+#include "StreamingSampler.hpp"
 
 namespace {
     inline bool isMeasureGate(const xacc::InstPtr& in_instr)
@@ -81,37 +83,21 @@ namespace {
         return result;
     }
 
-    void generateMeasureBitString(std::shared_ptr<xacc::AcceleratorBuffer> in_buffer, const std::vector<size_t>& in_bits, const KetVectorType& in_stateVec, int in_shotCount, xacc::quantum::randomEngine& in_rng)
+    // Samples the measured bits from the final state vector (see StreamingSampler):
+    // the counts are added to the buffer, no per-shot data is kept unless a shot file is requested.
+    template <typename StateVectorType>
+    void generateMeasureBitString(std::shared_ptr<xacc::AcceleratorBuffer> in_buffer, const std::vector<size_t>& in_bits, const StateVectorType& in_stateVec, int in_shotCount, xacc::quantum::randomEngine& in_rng, const std::string& in_shotFilePrefix, int in_shotFileChunkSize)
     {
-      const std::vector<double> sorted_random_vals = [&]() {
-        std::vector<double> rs;
-        rs.reserve(in_shotCount);
-        for (uint64_t i = 0; i < in_shotCount; ++i) {
-          rs.emplace_back(in_rng.randProb());
-        }
-        std::sort(rs.begin(), rs.end());
-        return rs;
-      }();
-
-      const auto generateBitString =
-          [&in_bits](uint64_t wave_func_idx) -> std::string {
-        std::string bit_string;
-        bit_string.reserve(in_bits.size());
-        for (const auto &bit : in_bits) {
-          bit_string.push_back((wave_func_idx & (1ULL << bit)) ? '1' : '0');
-        }
-        return bit_string;
-      };
-      uint64_t m = 0;
-      double csum = 0.0;
-      std::vector<uint64_t> bitstrings;
-      for (uint64_t k = 0; k < in_stateVec.size(); ++k) {
-        csum += std::norm(in_stateVec[k]);
-        while (sorted_random_vals[m] < csum && m < in_shotCount) {
-          in_buffer->appendMeasurement(generateBitString(k));
-          ++m;
+        const auto outcomes = xacc::quantum::StreamingSampler::sample(
+            in_stateVec.size(), [&in_stateVec](uint64_t k) { return static_cast<double>(std::norm(in_stateVec[k])); },
+            in_bits, in_shotCount, in_rng.m_engine);
+        xacc::quantum::StreamingSampler::appendCounts(*in_buffer, outcomes, in_bits.size());
+        if (!in_shotFilePrefix.empty())
+        {
+            const std::string shotFile = in_shotFilePrefix + in_buffer->name() + ".shots";
+            xacc::quantum::ShotFileWriter::write(shotFile, outcomes, in_bits.size(), in_rng.m_engine, in_shotFileChunkSize);
+            in_buffer->addExtraInfo("shot-file", shotFile);
         }
-      }
     }
 
     // Helper to determine if shot count distribution can be simulated by 
@@ -194,6 +180,16 @@ namespace quantum {
     void QppAccelerator::initialize(const HeterogeneousMap& params)
     {
         m_visitor = std::make_shared<QppVisitor>();
+        m_visitorFp32 = std::make_shared<QppVisitorT<float>>();
+        m_singlePrecision = false;
+        setPrecision(params);
+        m_fusionMaxQubits = 0;
+        setGateFusion(params);
+        m_shotFilePrefix.clear();
+        m_shotFileChunkSize = xacc::quantum::ShotFileWriter::DEFAULT_CHUNK_SIZE;
+        setShotFile(params);
+        m_checkpointMemoryMb = 1024;
+        setCheckpointMemory(params);
         // Default: no shots (unless otherwise specified)
         m_shots = -1;
         if (params.keyExists<int>("shots"))
@@ -224,6 +220,78 @@ namespace quantum {
         if (params.keyExists<std::vector<std::pair<int,int>>>("connectivity")) {
             m_connectivity = params.get<std::vector<std::pair<int,int>>>("connectivity");
         }
+
+        m_shotBranching = true;
+        m_branchBudget = 32;
+        if (params.keyExists<bool>("shot-branching"))
+        {
+            m_shotBranching = params.get<bool>("shot-branching");
+        }
+        if (params.keyExists<int>("branch-budget"))
+        {
+            m_branchBudget = params.get<int>("branch-budget");
+            if (m_branchBudget < 1)
+            {
+                xacc::error("Invalid 'branch-budget' parameter.");
+            }
+        }
+    }
+
+    void QppAccelerator::setPrecision(const HeterogeneousMap& params)
+    {
+        if (params.stringExists("precision"))
+        {
+            const auto precision = params.getString("precision");
+            if (precision != "fp32" && precision != "fp64")
+            {
+                xacc::error("Invalid 'precision' parameter: " + precision + " (must be 'fp32' or 'fp64').");
+            }
+            m_singlePrecision = (precision == "fp32");
+        }
+    }
+
+    void QppAccelerator::setGateFusion(const HeterogeneousMap& params)
+    {
+        if (params.keyExists<int>("fusion-max-qubits"))
+        {
+            m_fusionMaxQubits = params.get<int>("fusion-max-qubits");
+            if (m_fusionMaxQubits != 0 && (m_fusionMaxQubits < WindowedGateFuser::MIN_BLOCK_QUBITS || m_fusionMaxQubits > WindowedGateFuser::MAX_BLOCK_QUBITS))
+            {
+                xacc::error("Invalid 'fusion-max-qubits' parameter: " + std::to_string(m_fusionMaxQubits) + 
+                            " (must be 0 or in [" + std::to_string(WindowedGateFuser::MIN_BLOCK_QUBITS) + ", " + 
+                            std::to_string(WindowedGateFuser::MAX_BLOCK_QUBITS) + "]).");
+            }
+        }
+        m_visitor->setGateFusion(m_fusionMaxQubits);
+        m_visitorFp32->setGateFusion(m_fusionMaxQubits);
+    }
+
+    void QppAccelerator::setShotFile(const HeterogeneousMap& params)
+    {
+        if (params.stringExists("shot-file-prefix"))
+        {
+            m_shotFilePrefix = params.getString("shot-file-prefix");
+        }
+        if (params.keyExists<int>("shot-file-chunk-size"))
+        {
+            m_shotFileChunkSize = params.get<int>("shot-file-chunk-size");
+            if (m_shotFileChunkSize < 1)
+            {
+                xacc::error("Invalid 'shot-file-chunk-size' parameter.");
+            }
+        }
+    }
+
+    void QppAccelerator::setCheckpointMemory(const HeterogeneousMap& params)
+    {
+        if (params.keyExists<int>("checkpoint-memory"))
+        {
+            m_checkpointMemoryMb = params.get<int>("checkpoint-memory");
+            if (m_checkpointMemoryMb < 0)
+            {
+                xacc::error("Invalid 'checkpoint-memory' parameter.");
+            }
+        }
     }
 
     void QppAccelerator::updateConfiguration(const HeterogeneousMap &params) {
@@ -247,12 +315,29 @@ namespace quantum {
         m_connectivity =
             params.get<std::vector<std::pair<int, int>>>("connectivity");
       }
+
+      if (params.keyExists<bool>("shot-branching")) {
+        m_shotBranching = params.get<bool>("shot-branching");
+      }
+      if (params.keyExists<int>("branch-budget")) {
+        m_branchBudget = params.get<int>("branch-budget");
+      }
+      setPrecision(params);
+      setGateFusion(params);
+      setShotFile(params);
+      setCheckpointMemory(params);
     }
 
     void QppAccelerator::execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction)
+    {
+        withVisitor([&](auto& visitor) { executeCircuit(visitor, buffer, compositeInstruction); });
+    }
+
+    template <typename FP>
+    void QppAccelerator::executeCircuit(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction)
     {
         const auto runCircuit = [&](bool shotsMode){
-            m_visitor->initialize(buffer, shotsMode);
+            visitor->initialize(buffer, shotsMode);
 
             // Walk the IR tree, and visit each node
             InstructionIterator it(compositeInstruction);
@@ -262,7 +347,7 @@ namespace quantum {
                 if (nextInst->isEnabled())
                 {
                     try {
-                        nextInst->accept(m_visitor);
+                        visitor->visitFused(nextInst);
                     } catch (std::exception& ex) {
                         std::cout <<"  QPP CAUGHT EXCEPTION:\n";
                         xacc::error("");
@@ -270,7 +355,7 @@ namespace quantum {
                 }
             }
 
-            m_visitor->finalize();
+            visitor->finalize();
         };
 
         // Not possible to simulate shot count by direct sampling,
@@ -281,6 +366,10 @@ namespace quantum {
             {
                 runCircuit(false);
             }
+            else if (m_shotBranching)
+            {
+                runShotBranching(visitor, buffer, compositeInstruction);
+            }
             else
             {
                 for (int i = 0; i < m_shots; ++i)
@@ -293,7 +382,7 @@ namespace quantum {
         {
             // Index of measure bits
             std::vector<size_t> measureBitIdxs;
-            m_visitor->initialize(buffer);
+            visitor->initialize(buffer);
             // Walk the IR tree, and visit each node
             InstructionIterator it(compositeInstruction);
             while (it.hasNext())
@@ -303,7 +392,7 @@ namespace quantum {
                 {
                     if (!isMeasureGate(nextInst))
                     {
-                        nextInst->accept(m_visitor);
+                        visitor->visitFused(nextInst);
                     }
                     else
                     {
@@ -313,26 +402,138 @@ namespace quantum {
                 }
             }
             
+            visitor->flushFusedGates();
+            if (const auto* fuser = visitor->getGateFuser())
+            {
+                // Number of state vector sweeps for the fused gates
+                buffer->addExtraInfo("fused-gates", static_cast<int>(fuser->nbGates()));
+                buffer->addExtraInfo("fused-blocks", static_cast<int>(fuser->nbBlocks()));
+            }
             // Run bit-string simulation
             if (!measureBitIdxs.empty())
             {
-                const auto& stateVec = m_visitor->getStateVec();
+                const auto& stateVec = visitor->getStateVec();
                 if (m_shots < 0)
                 {
-                    const double expectedValueZ = QppVisitor::calcExpectationValueZ(stateVec, measureBitIdxs);
+                    const double expectedValueZ = QppVisitorT<FP>::calcExpectationValueZ(stateVec, measureBitIdxs);
                     buffer->addExtraInfo("exp-val-z", expectedValueZ);
                 }
                 else
                 {
-                    generateMeasureBitString(buffer, measureBitIdxs, stateVec, m_shots, m_rng);
+                    generateMeasureBitString(buffer, measureBitIdxs, stateVec, m_shots, m_rng, m_shotFilePrefix, m_shotFileChunkSize);
                 }
             }
             // Note: must save the state-vector before finalizing the visitor.
-            cacheExecutionInfo();
-            m_visitor->finalize();
+            cacheExecutionInfo(visitor);
+            visitor->finalize();
         }
     }
     
+    template <typename FP>
+    void QppAccelerator::runShotBranching(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction)
+    {
+        // Note: the state vector is indexed according to the XACC convention,
+        // i.e. qubit q is bit q of the index.
+        using KetVectorType = typename QppVisitorT<FP>::StateVectorType;
+        using Engine = ShotBranching<KetVectorType>;
+        typename Engine::Backend backend;
+        // Controlled blocks (C-U) are handled by the visitor if possible (it then
+        // disables the block), otherwise their decomposition is applied.
+        std::function<void(const InstPtr&)> applyInst = [&](const InstPtr& in_inst) {
+            in_inst->accept(visitor);
+            if (in_inst->isComposite() && in_inst->isEnabled())
+            {
+                for (auto& subInst : xacc::ir::asComposite(in_inst)->getInstructions())
+                {
+                    if (subInst->isEnabled())
+                    {
+                        applyInst(subInst);
+                    }
+                }
+            }
+        };
+        backend.apply = [&](KetVectorType& io_state, const std::vector<InstPtr>& in_gates) {
+            visitor->swapStateVec(io_state);
+            for (auto& gate : in_gates)
+            {
+                applyInst(gate);
+            }
+            visitor->swapStateVec(io_state);
+        };
+        backend.probabilityOne = [](KetVectorType& in_state, size_t in_qubit) {
+            const uint64_t mask = 1ULL << in_qubit;
+            double prob = 0.0;
+            for (uint64_t i = 0; i < in_state.size(); ++i)
+            {
+                if (i & mask)
+                {
+                    prob += std::norm(in_state[i]);
+                }
+            }
+            return prob;
+        };
+        backend.collapse = [](KetVectorType& io_state, size_t in_qubit, bool in_result) {
+            const uint64_t mask = 1ULL << in_qubit;
+            double norm = 0.0;
+            for (uint64_t i = 0; i < io_state.size(); ++i)
+            {
+                if (((i & mask) != 0) == in_result)
+                {
+                    norm += std::norm(io_state[i]);
+                }
+                else
+                {
+                    io_state[i] = 0.0;
+                }
+            }
+            io_state /= static_cast<FP>(std::sqrt(norm));
+        };
+        backend.flip = [](KetVectorType& io_state, size_t in_qubit) {
+            const uint64_t mask = 1ULL << in_qubit;
+            for (uint64_t i = 0; i < io_state.size(); ++i)
+            {
+                if (!(i & mask))
+                {
+                    std::swap(io_state[i], io_state[i | mask]);
+                }
+            }
+        };
+        backend.copy = [](const KetVectorType& in_state) { return in_state; };
+        backend.isSameState = [](const KetVectorType& in_state1, const KetVectorType& in_state2) {
+            // Tolerance: rounding errors of the amplitudes
+            const double tol = std::is_same<FP, float>::value ? 1e-6 : 1e-12;
+            return std::norm(in_state1.dot(in_state2)) > 1.0 - tol;
+        };
+        backend.sample = [](KetVectorType& in_state, const std::vector<size_t>& in_qubits, int in_shots, std::mt19937_64& io_rng) {
+            return xacc::quantum::StreamingSampler::sample(
+                in_state.size(), [&in_state](uint64_t k) { return static_cast<double>(std::norm(in_state[k])); },
+                in_qubits, in_shots, io_rng);
+        };
+
+        // The visitor only provides the gate implementations here,
+        // its state vector is exchanged with the one of each branch.
+        visitor->initialize(buffer);
+        KetVectorType initialState;
+        visitor->swapStateVec(initialState);
+        std::map<std::string, int> counts;
+        Engine engine(backend, m_branchBudget);
+        engine.run(compositeInstruction, buffer->name(), std::move(initialState), m_shots, m_rng.m_engine,
+            [&](const typename Engine::Branch& in_branch) {
+                counts[in_branch.bitString()] += in_branch.shots;
+                // Classical register values of the last branch are kept in the buffer
+                // (same as the last shot of a shot-by-shot simulation).
+                buffer->reset_single_measurements();
+                in_branch.replay(*buffer);
+            });
+        visitor->finalize();
+        for (const auto& [bitString, count] : counts)
+        {
+            buffer->appendMeasurement(bitString, count);
+        }
+        xacc::info("Shot branching: " + std::to_string(engine.nbSplits()) + " splits, max. " +
+                   std::to_string(engine.peakBranches()) + " branches.");
+    }
+
     void QppAccelerator::execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions)
     {
         if (!m_vqeMode || compositeInstructions.size() <= 1) 
@@ -346,42 +547,68 @@ namespace quantum {
         }
         else 
         {
-            auto kernelDecomposed = ObservedAnsatz::fromObservedComposites(compositeInstructions);
-            // Always validate kernel decomposition in DEBUG
-            assert(kernelDecomposed.validate(compositeInstructions));
-            m_visitor->initialize(buffer);            
-            // Base kernel:
-            auto baseKernel = kernelDecomposed.getBase();
-            // Basis-change + measures
-            auto obsCircuits = kernelDecomposed.getObservedSubCircuits();
-            // Walk the base IR tree, and visit each node
-            InstructionIterator it(baseKernel);
-            while (it.hasNext()) 
-            {
-                auto nextInst = it.next();
-                if (nextInst->isEnabled() && !nextInst->isComposite()) 
-                {
-                    nextInst->accept(m_visitor);
-                }
-            }
+            withVisitor([&](auto& visitor) { executeObserved(visitor, buffer, compositeInstructions); });
+        }
+    }
 
-            // Now we have a wavefunction that represents execution of the ansatz.
-            // Run the observable sub-circuits (change of basis + measurements)
-            for (int i = 0; i < obsCircuits.size(); ++i) 
+    template <typename FP>
+    void QppAccelerator::executeObserved(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions)
+    {
+        using StateType = typename QppVisitorT<FP>::StateVectorType;
+        // Any prefix shared by the circuits (ansatz, gradient shifts, etc.) is simulated once.
+        const PrefixTrie trie(compositeInstructions);
+        PrefixTrie::Backend<StateType> backend;
+        const size_t dim = 1ULL << buffer->size();
+        backend.init = [dim]() {
+            // |0...0>
+            StateType state = StateType::Zero(dim);
+            state[0] = 1.0;
+            return state;
+        };
+        backend.apply = [&](StateType& io_state, const std::vector<InstPtr>& in_gates) {
+            visitor->swapStateVec(io_state);
+            for (auto& gate : in_gates)
             {
-                auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(obsCircuits[i]->name(), buffer->size());
-                const double e = m_visitor->getExpectationValueZ(obsCircuits[i]);
-                tmpBuffer->addExtraInfo("exp-val-z", e);
-                buffer->appendChild(obsCircuits[i]->name(), tmpBuffer);
+                visitor->visitFused(gate);
             }
-            m_visitor->finalize();
+            visitor->flushFusedGates();
+            visitor->swapStateVec(io_state);
+        };
+        backend.copy = [](const StateType& in_state) { return in_state; };
+
+        // The visitor only provides the gate implementations here,
+        // its state vector is exchanged with the one of each trie node.
+        visitor->initialize(buffer);
+        std::vector<double> expectationValues(compositeInstructions.size(), 0.0);
+        const auto budget = PrefixTrie::checkpointBudget(m_checkpointMemoryMb, dim * sizeof(std::complex<FP>));
+        const auto stats = trie.run<StateType>(backend, budget, [&](size_t in_circuitIdx, const StateType& in_state) {
+            const auto& measuredBits = trie.measuredBits(in_circuitIdx);
+            expectationValues[in_circuitIdx] = QppVisitorT<FP>::calcExpectationValueZ(
+                in_state, std::vector<qpp::idx>(measuredBits.begin(), measuredBits.end()));
+        });
+        visitor->finalize();
+        xacc::info("Prefix sharing: " + std::to_string(stats.nbAppliedGates) + " gates applied (" +
+                   std::to_string(trie.nbGates()) + " in the batch), " + std::to_string(stats.nbCheckpoints) +
+                   " checkpoints, " + std::to_string(stats.nbRecomputes) + " recomputed.");
+
+        for (int i = 0; i < compositeInstructions.size(); ++i) 
+        {
+            auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(compositeInstructions[i]->name(), buffer->size());
+            tmpBuffer->addExtraInfo("exp-val-z", expectationValues[i]);
+            buffer->appendChild(compositeInstructions[i]->name(), tmpBuffer);
         }
     }
 
     void QppAccelerator::apply(std::shared_ptr<AcceleratorBuffer> buffer, std::shared_ptr<Instruction> inst) 
     {
-        if (!m_visitor->isInitialized()) {
-            m_visitor->initialize(buffer);
+        withVisitor([&](auto& visitor) { applyInstruction(visitor, buffer, inst); });
+    }
+
+    template <typename FP>
+    void QppAccelerator::applyInstruction(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, std::shared_ptr<Instruction> inst)
+    {
+        if (!visitor->isInitialized()) {
+            visitor->initialize(buffer);
             m_currentBuffer = std::make_pair(buffer.get(), buffer->size());
         }
 
@@ -390,7 +617,7 @@ namespace quantum {
             if (buffer->size() > m_currentBuffer.second) {
                 const auto nbQubitsToAlloc = buffer->size() - m_currentBuffer.second;
                 // std::cout << "Allocate " << nbQubitsToAlloc << " qubits.\n";
-                m_visitor->allocateQubits(nbQubitsToAlloc);
+                visitor->allocateQubits(nbQubitsToAlloc);
                 m_currentBuffer.second = buffer->size();
             }
             else {
@@ -404,7 +631,7 @@ namespace quantum {
         }
         if (inst->name() == "Measure")
         {
-            const auto measRes = m_visitor->measure(inst->bits()[0]);
+            const auto measRes = visitor->measure(inst->bits()[0]);
             buffer->measure(inst->bits()[0], (measRes ? 1 : 0));
         }
         else
@@ -412,7 +639,7 @@ namespace quantum {
             auto gateCast = std::dynamic_pointer_cast<xacc::quantum::Gate>(inst);
             assert(gateCast);
             try {
-                m_visitor->applyGate(*gateCast);
+                visitor->applyGate(*gateCast);
             } catch(std::exception& e) {
                 // std::cout << "CAUGHT QPP EXCP\n";
                 std::stringstream ss;
@@ -422,11 +649,12 @@ namespace quantum {
         }
     }
 
-    void QppAccelerator::cacheExecutionInfo() {
+    template <typename FP>
+    void QppAccelerator::cacheExecutionInfo(std::shared_ptr<QppVisitorT<FP>> visitor) {
       // Cache the state-vector:
       // Note: qpp stores wavefunction in Eigen vectors,
       // hence, maps to std::vector.
-      auto stateVec = m_visitor->getStateVec();
+      auto stateVec = visitor->getStateVec();
       ExecutionInfo::WaveFuncType waveFunc(stateVec.data(),
                                            stateVec.data() + stateVec.size());
       m_executionInfo = {
@@ -44,7 +44,10 @@ public:
     virtual void initialize(const HeterogeneousMap& params = {}) override;
     virtual void updateConfiguration(const HeterogeneousMap& config) override;
     virtual const std::vector<std::string> configurationKeys() override { return {}; }
-    virtual HeterogeneousMap getProperties() override { return {{"shots", m_shots}}; }
+    virtual HeterogeneousMap getProperties() override
+    {
+        return {{"shots", m_shots}, {"vqe-mode", m_vqeMode}, {"precision", std::string(m_singlePrecision ? "fp32" : "fp64")}};
+    }
     virtual BitOrder getBitOrder() override {return BitOrder::LSB;}
     virtual void execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction) override;
     virtual void execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions) override;
@@ -56,13 +59,52 @@ public:
     virtual xacc::HeterogeneousMap getExecutionInfo() const override { return m_executionInfo; }
   
   private:
+    // Run in_func with the visitor of the selected precision
+    template <typename Func>
+    void withVisitor(Func&& in_func) {
+      if (m_singlePrecision) {
+        in_func(m_visitorFp32);
+      } else {
+        in_func(m_visitor);
+      }
+    }
+    // Implementations for both precisions (see QppVisitorT)
+    template <typename FP>
+    void executeCircuit(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction);
+    template <typename FP>
+    void executeObserved(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions);
+    template <typename FP>
+    void applyInstruction(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, std::shared_ptr<Instruction> inst);
     // Cache execution info after execution
-    void cacheExecutionInfo();
+    template <typename FP>
+    void cacheExecutionInfo(std::shared_ptr<QppVisitorT<FP>> visitor);
+    // Run shots of a dynamic circuit (mid-circuit measure/reset, if statements)
+    template <typename FP>
+    void runShotBranching(std::shared_ptr<QppVisitorT<FP>> visitor, std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction);
+    void setPrecision(const HeterogeneousMap& params);
+    void setGateFusion(const HeterogeneousMap& params);
+    void setShotFile(const HeterogeneousMap& params);
+    void setCheckpointMemory(const HeterogeneousMap& params);
     std::shared_ptr<QppVisitor> m_visitor;
+    // Single-precision ("precision" = "fp32") state vectors
+    std::shared_ptr<QppVisitorT<float>> m_visitorFp32;
+    bool m_singlePrecision = false;
+    // Max. number of qubits of the fused gate blocks (0: no fusion)
+    int m_fusionMaxQubits = 0;
     // Number of 'shots' if random sampling simulation is enabled.
     // -1 means disabled (no shots, just expectation value)
     int m_shots = -1;
     bool m_vqeMode;
+    // Shot-branching simulation of dynamic circuits
+    bool m_shotBranching = true;
+    int m_branchBudget = 32;
+    // Optional per-shot output of the sampled shots (chunked binary file):
+    // '<prefix><buffer name>.shots' for each sampled circuit.
+    std::string m_shotFilePrefix;
+    int m_shotFileChunkSize = 1 << 20;
+    // Memory budget (MB) of the state checkpoints of the prefix-sharing
+    // execution of observed circuits (VQE mode).
+    int m_checkpointMemoryMb = 1024;
     std::vector<std::pair<int,int>> m_connectivity;
     xacc::HeterogeneousMap m_executionInfo;
     std::pair<AcceleratorBuffer*, size_t> m_currentBuffer;
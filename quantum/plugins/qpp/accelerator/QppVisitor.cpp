@@ -18,6 +18,9 @@
 #include <memory>
 #include "GateModifier.hpp"
 #include "GateFusion.hpp"
+#include "InstructionIterator.hpp"
+#include <set>
+#include <sstream>
 namespace {
     // Add gate matrix for iSwap and fSim gates
     qpp::cmat iSwapGateMat()
@@ -43,6 +46,91 @@ namespace {
         return gateMat; 
     }
 
+    // Fused unitary of a composite acting on in_bits (sorted), with local
+    // qubit l (i.e. in_bits[l]) as bit l of the matrix index.
+    // Returns false if the composite contains non-fusible instructions.
+    bool fuseComposite(const std::shared_ptr<xacc::CompositeInstruction>& in_composite, const std::vector<size_t>& in_bits, qpp::cmat& out_mat)
+    {
+        auto localComposite = xacc::getIRProvider("quantum")->createComposite("__fused_block__");
+        InstructionIterator it(in_composite);
+        while (it.hasNext())
+        {
+            auto nextInst = it.next();
+            if (!nextInst->isEnabled() || nextInst->isComposite())
+            {
+                continue;
+            }
+            if (!xacc::quantum::WindowedGateFuser::isFusible(nextInst))
+            {
+                return false;
+            }
+            std::vector<size_t> localBits;
+            for (const auto& bit : nextInst->bits())
+            {
+                localBits.emplace_back(std::lower_bound(in_bits.begin(), in_bits.end(), bit) - in_bits.begin());
+            }
+            auto localInst = nextInst->clone();
+            localInst->setBits(localBits);
+            localComposite->addInstruction(localInst);
+        }
+        out_mat = xacc::quantum::GateFuser::fuseGates(localComposite, in_bits.size());
+        return true;
+    }
+
+    // Exact description of a composite (gates, qubits and parameters).
+    std::string compositeKey(const std::shared_ptr<xacc::CompositeInstruction>& in_composite)
+    {
+        std::stringstream ss;
+        ss << std::hexfloat;
+        InstructionIterator it(in_composite);
+        while (it.hasNext())
+        {
+            auto nextInst = it.next();
+            if (!nextInst->isEnabled() || nextInst->isComposite())
+            {
+                continue;
+            }
+            ss << nextInst->name();
+            for (const auto& param : nextInst->getParameters())
+            {
+                if (param.isNumeric())
+                {
+                    ss << " " << xacc::InstructionParameterToDouble(param);
+                }
+                else
+                {
+                    ss << " " << param.toString();
+                }
+            }
+            for (const auto& bit : nextInst->bits())
+            {
+                ss << " q" << bit;
+            }
+            ss << ";";
+        }
+        return ss.str();
+    }
+
+    // in_mat^in_power by repeated squaring
+    qpp::cmat matrixPower(const qpp::cmat& in_mat, size_t in_power)
+    {
+        qpp::cmat result = qpp::cmat::Identity(in_mat.rows(), in_mat.cols());
+        qpp::cmat base = in_mat;
+        while (in_power > 0)
+        {
+            if (in_power & 1)
+            {
+                result = result * base;
+            }
+            in_power >>= 1;
+            if (in_power > 0)
+            {
+                base = base * base;
+            }
+        }
+        return result;
+    }
+
     qpp::cmat u3GateMat(double in_theta, double in_phi, double in_lambda) 
     {
       qpp::cmat gateMat(2, 2);
@@ -60,21 +148,29 @@ namespace {
 namespace xacc {
 namespace quantum {
 
-    void QppVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, bool shotsMode)
+    template <typename FP>
+    void QppVisitorT<FP>::initialize(std::shared_ptr<AcceleratorBuffer> buffer, bool shotsMode)
     {
         m_buffer = std::move(buffer);
-        const std::vector<qpp::idx> initialState(m_buffer->size(), 0);
-        m_stateVec = qpp::mket(initialState);
+        // |0...0>
+        m_stateVec = StateVectorType::Zero(1ULL << m_buffer->size());
+        m_stateVec[0] = 1.0;
         const std::vector<qpp::idx> dims(m_buffer->size(), 2);
         m_dims = std::move(dims);
         m_measureBits.clear();
         m_shotsMode = shotsMode;
         m_initialized = true;
         m_controlledBlocks.clear();
+        if (m_fuser)
+        {
+            m_fuser->resetStatistics();
+        }
     }
 
-    void QppVisitor::finalize()
+    template <typename FP>
+    void QppVisitorT<FP>::finalize()
     {
+        flushFusedGates();
         if (m_shotsMode)
         {
             m_buffer->appendMeasurement(m_bitString);
@@ -91,7 +187,8 @@ namespace quantum {
         m_controlledBlocks.clear();
     }
 
-    qpp::idx QppVisitor::xaccIdxToQppIdx(size_t in_idx) const
+    template <typename FP>
+    qpp::idx QppVisitorT<FP>::xaccIdxToQppIdx(size_t in_idx) const
     {
         assert(in_idx < m_buffer->size());
         // QPP is using a different *endian* than the one of XACC,
@@ -101,7 +198,76 @@ namespace quantum {
         return m_buffer->size() - in_idx - 1;
     }
 
-    double QppVisitor::calcExpectationValueZ(const KetVectorType& in_stateVec, const std::vector<qpp::idx>& in_bits)
+    template <typename FP>
+    void QppVisitorT<FP>::applyMat(const qpp::cmat& in_mat, const std::vector<qpp::idx>& in_targets)
+    {
+        // No-op cast for double precision
+        m_stateVec = qpp::apply(m_stateVec, in_mat.template cast<std::complex<FP>>(), in_targets);
+    }
+
+    template <typename FP>
+    void QppVisitorT<FP>::applyCtrlMat(const qpp::cmat& in_mat, const std::vector<qpp::idx>& in_ctrls, const std::vector<qpp::idx>& in_targets)
+    {
+        m_stateVec = qpp::applyCTRL(m_stateVec, in_mat.template cast<std::complex<FP>>(), in_ctrls, in_targets);
+    }
+
+    template <typename FP>
+    qpp::idx QppVisitorT<FP>::measureQubit(size_t in_bit)
+    {
+        if constexpr (std::is_same<FP, double>::value)
+        {
+            const auto qubitIdx = xaccIdxToQppIdx(in_bit);
+            const auto measured = qpp::measure(m_stateVec, qpp::Gates::get_instance().Id2, { qubitIdx }, 2,  false);
+            const auto& measProbs = std::get<qpp::PROB>(measured);
+            const auto& postMeasStates = std::get<qpp::ST>(measured);
+            const auto randomSelectedResult = std::get<qpp::RES>(measured);
+
+            assert(measProbs.size() == 2 && postMeasStates.size() == 2 && randomSelectedResult < 2);
+            if (xacc::verbose)
+            {
+                std::cout << ">> Probability of all results: ";
+                std::cout << qpp::disp(measProbs, ", ") << "\n";
+            }
+            const auto& collapsedState = postMeasStates[randomSelectedResult];
+            m_stateVec = Eigen::Map<const qpp::ket>(collapsedState.data(), collapsedState.size());
+            return randomSelectedResult;
+        }
+        else
+        {
+            // qpp measurements are double-precision only:
+            // collapse the state in place (same random generator as qpp).
+            const uint64_t mask = 1ULL << in_bit;
+            double probOne = 0.0;
+            for (uint64_t i = 0; i < m_stateVec.size(); ++i)
+            {
+                if (i & mask)
+                {
+                    probOne += std::norm(m_stateVec[i]);
+                }
+            }
+            const qpp::idx result = (qpp::rand(0.0, 1.0) < probOne) ? 1 : 0;
+            const FP scale = 1.0 / std::sqrt(result ? probOne : 1.0 - probOne);
+            for (uint64_t i = 0; i < m_stateVec.size(); ++i)
+            {
+                if (((i & mask) != 0) == (result == 1))
+                {
+                    m_stateVec[i] *= scale;
+                }
+                else
+                {
+                    m_stateVec[i] = 0.0;
+                }
+            }
+            if (xacc::verbose)
+            {
+                std::cout << ">> Probability of all results: " << 1.0 - probOne << ", " << probOne << "\n";
+            }
+            return result;
+        }
+    }
+
+    template <typename FP>
+    double QppVisitorT<FP>::calcExpectationValueZ(const StateVectorType& in_stateVec, const std::vector<qpp::idx>& in_bits)
     {
         const auto hasEvenParity = [](size_t x, const std::vector<size_t>& in_qubitIndices) -> bool {
             size_t count = 0;
@@ -125,161 +291,184 @@ namespace quantum {
         return result;
     }
 
-    void QppVisitor::visit(Hadamard& h)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Hadamard& h)
     {
        const auto qubitIdx = xaccIdxToQppIdx(h.bits()[0]);
-       m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().H, { qubitIdx });
+       applyMat(qpp::Gates::get_instance().H, { qubitIdx });
     }
 
-    void QppVisitor::visit(CNOT& cnot)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CNOT& cnot)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(cnot.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(cnot.bits()[1]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().CNOT, { ctrlIdx,  targetIdx}, m_dims);
+        applyMat(qpp::Gates::get_instance().CNOT, { ctrlIdx,  targetIdx});
     }
 
-    void QppVisitor::visit(Rz& rz)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Rz& rz)
     {
         const auto qubitIdx = xaccIdxToQppIdx(rz.bits()[0]);
         const auto angleTheta = InstructionParameterToDouble(rz.getParameter(0));
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().RZ(angleTheta), { qubitIdx });
+        applyMat(qpp::Gates::get_instance().RZ(angleTheta), { qubitIdx });
     }
 
-    void QppVisitor::visit(Ry& ry)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Ry& ry)
     {
         const auto qubitIdx = xaccIdxToQppIdx(ry.bits()[0]);
         const auto angleTheta = InstructionParameterToDouble(ry.getParameter(0));
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().RY(angleTheta), { qubitIdx });
+        applyMat(qpp::Gates::get_instance().RY(angleTheta), { qubitIdx });
     }
 
-    void QppVisitor::visit(Rx& rx)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Rx& rx)
     {
         const auto qubitIdx = xaccIdxToQppIdx(rx.bits()[0]);
         const auto angleTheta = InstructionParameterToDouble(rx.getParameter(0));
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().RX(angleTheta), { qubitIdx });
+        applyMat(qpp::Gates::get_instance().RX(angleTheta), { qubitIdx });
     }
 
-    void QppVisitor::visit(X& x)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(X& x)
     {
         const auto qubitIdx = xaccIdxToQppIdx(x.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().X, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().X, { qubitIdx });
     }
 
-    void QppVisitor::visit(Y& y)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Y& y)
     {
         const auto qubitIdx = xaccIdxToQppIdx(y.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().Y, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().Y, { qubitIdx });
     }
 
-    void QppVisitor::visit(Z& z)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Z& z)
     {
         const auto qubitIdx = xaccIdxToQppIdx(z.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().Z, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().Z, { qubitIdx });
     }
 
-    void QppVisitor::visit(CY& cy)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CY& cy)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(cy.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(cy.bits()[1]);
-        m_stateVec = qpp::applyCTRL(m_stateVec, qpp::Gates::get_instance().Y, { ctrlIdx } ,  { targetIdx });
+        applyCtrlMat(qpp::Gates::get_instance().Y, { ctrlIdx }, { targetIdx });
     }
 
-    void QppVisitor::visit(CZ& cz)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CZ& cz)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(cz.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(cz.bits()[1]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().CZ, { ctrlIdx,  targetIdx}, m_dims);
+        applyMat(qpp::Gates::get_instance().CZ, { ctrlIdx,  targetIdx});
     }
 
-    void QppVisitor::visit(Swap& s)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Swap& s)
     {
         const auto qIdx1 = xaccIdxToQppIdx(s.bits()[0]);
         const auto qIdx2 = xaccIdxToQppIdx(s.bits()[1]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().SWAP, { qIdx1, qIdx2 });
+        applyMat(qpp::Gates::get_instance().SWAP, { qIdx1, qIdx2 });
     }
 
-    void QppVisitor::visit(CRZ& crz)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CRZ& crz)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(crz.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(crz.bits()[1]);
         const auto angleTheta = InstructionParameterToDouble(crz.getParameter(0));
-        m_stateVec = qpp::applyCTRL(m_stateVec, qpp::Gates::get_instance().RZ(angleTheta), { ctrlIdx } ,  { targetIdx });
+        applyCtrlMat(qpp::Gates::get_instance().RZ(angleTheta), { ctrlIdx }, { targetIdx });
     }
 
-    void QppVisitor::visit(CH& ch)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CH& ch)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(ch.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(ch.bits()[1]);
-        m_stateVec = qpp::applyCTRL(m_stateVec, qpp::Gates::get_instance().H, { ctrlIdx } ,  { targetIdx });
+        applyCtrlMat(qpp::Gates::get_instance().H, { ctrlIdx }, { targetIdx });
     }
 
-    void QppVisitor::visit(S& s)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(S& s)
     {
         const auto qubitIdx = xaccIdxToQppIdx(s.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().S, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().S, { qubitIdx });
     }
 
-    void QppVisitor::visit(Sdg& sdg)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Sdg& sdg)
     {
         const auto qubitIdx = xaccIdxToQppIdx(sdg.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().S.adjoint(), { qubitIdx });
+        applyMat(qpp::Gates::get_instance().S.adjoint(), { qubitIdx });
     }
 
-    void QppVisitor::visit(T& t)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(T& t)
     {
         const auto qubitIdx = xaccIdxToQppIdx(t.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().T, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().T, { qubitIdx });
     }
 
-    void QppVisitor::visit(Tdg& tdg)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Tdg& tdg)
     {
         const auto qubitIdx = xaccIdxToQppIdx(tdg.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().T.adjoint(), { qubitIdx });
+        applyMat(qpp::Gates::get_instance().T.adjoint(), { qubitIdx });
     }
 
-    void QppVisitor::visit(CPhase& cphase)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(CPhase& cphase)
     {
         const auto ctrlIdx = xaccIdxToQppIdx(cphase.bits()[0]);
         const auto targetIdx = xaccIdxToQppIdx(cphase.bits()[1]);
         const auto angleTheta = InstructionParameterToDouble(cphase.getParameter(0));
         qpp::cmat gateMat { qpp::cmat::Zero(2, 2)};       
         gateMat << 1, 0, 0, std::exp(std::complex<double>(0.0, angleTheta));
-        m_stateVec = qpp::applyCTRL(m_stateVec, gateMat, { ctrlIdx } ,  { targetIdx });
+        applyCtrlMat(gateMat, { ctrlIdx }, { targetIdx });
     }
 
-    void QppVisitor::visit(Identity& i)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Identity& i)
     {
         const auto qubitIdx = xaccIdxToQppIdx(i.bits()[0]);
-        m_stateVec = qpp::apply(m_stateVec, qpp::Gates::get_instance().Id2, { qubitIdx });
+        applyMat(qpp::Gates::get_instance().Id2, { qubitIdx });
     }
 
-    void QppVisitor::visit(U& u)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(U& u)
     {
         const auto qubitIdx = xaccIdxToQppIdx(u.bits()[0]);
         const auto theta = InstructionParameterToDouble(u.getParameter(0));
         const auto phi = InstructionParameterToDouble(u.getParameter(1));
         const auto lambda = InstructionParameterToDouble(u.getParameter(2));
-        m_stateVec = qpp::apply(m_stateVec, u3GateMat(theta, phi, lambda), { qubitIdx });
+        applyMat(u3GateMat(theta, phi, lambda), { qubitIdx });
     }
 
-    void QppVisitor::visit(iSwap& in_iSwapGate) 
+    template <typename FP>
+    void QppVisitorT<FP>::visit(iSwap& in_iSwapGate) 
     {
         const auto qIdx1 = xaccIdxToQppIdx(in_iSwapGate.bits()[0]);
         const auto qIdx2 = xaccIdxToQppIdx(in_iSwapGate.bits()[1]);
 
-        m_stateVec = qpp::apply(m_stateVec, iSwapGateMat(), { qIdx1, qIdx2 });
+        applyMat(iSwapGateMat(), { qIdx1, qIdx2 });
     }
 
-    void QppVisitor::visit(fSim& in_fsimGate) 
+    template <typename FP>
+    void QppVisitorT<FP>::visit(fSim& in_fsimGate) 
     {
         const auto qIdx1 = xaccIdxToQppIdx(in_fsimGate.bits()[0]);
         const auto qIdx2 = xaccIdxToQppIdx(in_fsimGate.bits()[1]);
         const auto theta = InstructionParameterToDouble(in_fsimGate.getParameter(0));
         const auto phi = InstructionParameterToDouble(in_fsimGate.getParameter(1));
-        m_stateVec = qpp::apply(m_stateVec, fSimGateMat(theta, phi), { qIdx1, qIdx2 });
+        applyMat(fSimGateMat(theta, phi), { qIdx1, qIdx2 });
     }
 
-    void QppVisitor::visit(Measure& measure)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Measure& measure)
     {
         if (xacc::verbose)
         {
@@ -287,13 +476,6 @@ namespace quantum {
             std::cout << ">> State before measurement: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
 
-        const auto qubitIdx = xaccIdxToQppIdx(measure.bits()[0]);
-        const auto measured = qpp::measure(m_stateVec, qpp::Gates::get_instance().Id2, { qubitIdx }, 2,  false);
-        const auto& measProbs = std::get<qpp::PROB>(measured);
-        const auto& postMeasStates = std::get<qpp::ST>(measured);
-        const auto randomSelectedResult = std::get<qpp::RES>(measured);
-
-        assert(measProbs.size() == 2 && postMeasStates.size() == 2 && randomSelectedResult < 2);
         m_measureBits.emplace_back(measure.bits()[0]);
         if (!m_shotsMode)
         {
@@ -301,22 +483,16 @@ namespace quantum {
             const double expectedValueZ = calcExpectationValueZ(m_stateVec, m_measureBits);
             m_buffer->addExtraInfo("exp-val-z", expectedValueZ);
         }
-        else
+
+        const auto randomSelectedResult = measureQubit(measure.bits()[0]);
+        if (m_shotsMode)
         {
             m_bitString.append(std::to_string(randomSelectedResult));
         }
 
         if (xacc::verbose)
         {
-            std::cout << ">> Probability of all results: ";
-            std::cout << qpp::disp(measProbs, ", ") << "\n";
             std::cout << ">> Measurement result is: " << randomSelectedResult << "\n";
-        }
-
-        const auto& collapsedState = postMeasStates[randomSelectedResult];
-        m_stateVec = Eigen::Map<const qpp::ket>(collapsedState.data(), collapsedState.size());
-        if (xacc::verbose)
-        {
             std::cout << ">> State after measurement: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
 
@@ -335,7 +511,8 @@ namespace quantum {
         }
     }
     
-    void QppVisitor::visit(Reset& in_resetGate) 
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Reset& in_resetGate) 
     {
         if (xacc::verbose)
         {
@@ -343,8 +520,19 @@ namespace quantum {
             std::cout << ">> State before reset: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
 
-        const auto qubitIdx = xaccIdxToQppIdx(in_resetGate.bits()[0]);
-        m_stateVec = qpp::reset(m_stateVec, { qubitIdx });
+        if constexpr (std::is_same<FP, double>::value)
+        {
+            const auto qubitIdx = xaccIdxToQppIdx(in_resetGate.bits()[0]);
+            m_stateVec = qpp::reset(m_stateVec, { qubitIdx });
+        }
+        else
+        {
+            // Measure, then flip the qubit back to |0> if needed.
+            if (measureQubit(in_resetGate.bits()[0]) == 1)
+            {
+                applyMat(qpp::Gates::get_instance().X, { xaccIdxToQppIdx(in_resetGate.bits()[0]) });
+            }
+        }
         
         if (xacc::verbose)
         {
@@ -352,7 +540,8 @@ namespace quantum {
         }
     }
 
-    void QppVisitor::visit(IfStmt& ifStmt)
+    template <typename FP>
+    void QppVisitorT<FP>::visit(IfStmt& ifStmt)
     {
         ifStmt.expand({});
 
@@ -362,7 +551,8 @@ namespace quantum {
         }
     }
 
-    void QppVisitor::visit(Circuit& in_circuit) 
+    template <typename FP>
+    void QppVisitorT<FP>::visit(Circuit& in_circuit) 
     {
       //   std::cout << "HOWDY: Visit quantum circuit: " << in_circuit.name()
       //             << "\n";
@@ -421,14 +611,53 @@ namespace quantum {
         for (const auto &bit : asComp->uniqueBits()) {
           targetIdx.emplace_back(xaccIdxToQppIdx(bit));
         }
-        m_stateVec = qpp::applyCTRL(m_stateVec, uMat, {ctrlIdx}, {targetIdx});
+        applyCtrlMat(uMat, ctrlIdx, targetIdx);
         // No need to handle this sub-circuit anymore.
         in_circuit.disable();
         m_controlledBlocks.emplace_back(in_circuit);
+      } else if (in_circuit.name() == "Pow-U") {
+        auto *asPowerBlock =
+            dynamic_cast<xacc::quantum::PowerModifier *>(&in_circuit);
+        if (!asPowerBlock || asPowerBlock->getPower() < 2) {
+          return;
+        }
+        auto baseCircuit = xacc::ir::asComposite(asPowerBlock->getBaseInstruction());
+        const auto uniqueBits = baseCircuit->uniqueBits();
+        const std::vector<size_t> bits(uniqueBits.begin(), uniqueBits.end());
+        // Large blocks are simulated gate-by-gate (expanded by the iterator).
+        if (bits.empty() || bits.size() > MAX_FUSED_POWER_QUBITS) {
+          return;
+        }
+
+        const auto power = asPowerBlock->getPower();
+        const std::string cacheKey = std::to_string(power) + "|" + compositeKey(baseCircuit);
+        auto iter = m_fusedPowerCache.find(cacheKey);
+        if (iter == m_fusedPowerCache.end()) {
+          qpp::cmat baseMat;
+          if (!fuseComposite(baseCircuit, bits, baseMat)) {
+            return;
+          }
+          if (m_fusedPowerCache.size() >= MAX_FUSED_POWER_CACHE_SIZE) {
+            m_fusedPowerCache.clear();
+          }
+          iter = m_fusedPowerCache.emplace(cacheKey, matrixPower(baseMat, power)).first;
+        }
+
+        // The fused matrix has local qubit l as bit l of its index,
+        // i.e. the last qpp target.
+        std::vector<qpp::idx> targetIdx;
+        for (auto it = bits.rbegin(); it != bits.rend(); ++it) {
+          targetIdx.emplace_back(xaccIdxToQppIdx(*it));
+        }
+        applyMat(iter->second, targetIdx);
+        // The whole block has been applied: skip its sub-tree.
+        in_circuit.disable();
+        m_controlledBlocks.emplace_back(in_circuit);
       }
     }
     
-    void QppVisitor::applyGate(Gate& in_gate) 
+    template <typename FP>
+    void QppVisitorT<FP>::applyGate(Gate& in_gate) 
     {
         if (in_gate.name() == "Measure")
         {
@@ -437,35 +666,24 @@ namespace quantum {
         in_gate.accept(this);
     }
 
-    bool QppVisitor::measure(size_t in_bit) 
+    template <typename FP>
+    bool QppVisitorT<FP>::measure(size_t in_bit) 
     {
-        const auto qubitIdx = xaccIdxToQppIdx(in_bit);
-        const auto measured = qpp::measure(m_stateVec, qpp::Gates::get_instance().Id2, { qubitIdx }, 2,  false);
-        const auto& measProbs = std::get<qpp::PROB>(measured);
-        const auto& postMeasStates = std::get<qpp::ST>(measured);
-        const auto randomSelectedResult = std::get<qpp::RES>(measured);
-
-        assert(measProbs.size() == 2 && postMeasStates.size() == 2 && randomSelectedResult < 2);
-       
+        flushFusedGates();
+        const auto randomSelectedResult = measureQubit(in_bit);
         if (xacc::verbose)
         {
-            std::cout << ">> Probability of all results: ";
-            std::cout << qpp::disp(measProbs, ", ") << "\n";
             std::cout << ">> Measurement result is: " << randomSelectedResult << "\n";
-        }
-
-        const auto& collapsedState = postMeasStates[randomSelectedResult];
-        m_stateVec = Eigen::Map<const qpp::ket>(collapsedState.data(), collapsedState.size());
-        if (xacc::verbose)
-        {
             std::cout << ">> State after measurement: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
         // 0 -> False; 1 -> True
         return (randomSelectedResult == 1);
     }
 
-    double QppVisitor::getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_composite) 
+    template <typename FP>
+    double QppVisitorT<FP>::getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_composite) 
     {
+        flushFusedGates();
         auto cachedStateVec = m_stateVec;
         std::vector<size_t> measureBitIdxs;
 
@@ -493,7 +711,8 @@ namespace quantum {
         return result;
     }
 
-    void QppVisitor::allocateQubits(size_t in_nbQubits) 
+    template <typename FP>
+    void QppVisitorT<FP>::allocateQubits(size_t in_nbQubits) 
     {
         assert(in_nbQubits > 0);
         if (xacc::verbose)
@@ -501,9 +720,11 @@ namespace quantum {
             std::cout << ">> Allocate : " << in_nbQubits << " qubits.\n";
             std::cout << ">> State before allocate: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
-        const std::vector<qpp::idx> initialState(in_nbQubits, 0);
-        auto new_stateVec = qpp::mket(initialState);
-        m_stateVec = qpp::kron(new_stateVec, m_stateVec);
+        // |0...0> (new qubits) x current state:
+        // the current amplitudes followed by zeros.
+        StateVectorType new_stateVec = StateVectorType::Zero(m_stateVec.size() << in_nbQubits);
+        new_stateVec.head(m_stateVec.size()) = m_stateVec;
+        m_stateVec.swap(new_stateVec);
         const std::vector<qpp::idx> new_dims(in_nbQubits, 2);
         m_dims.insert(m_dims.end(), new_dims.begin(), new_dims.end());
         if (xacc::verbose)
@@ -511,4 +732,101 @@ namespace quantum {
             std::cout << ">> State after allocate: " << qpp::disp(m_stateVec, ", ") << "\n";
         }
     }
+
+    template <typename FP>
+    void QppVisitorT<FP>::setGateFusion(size_t in_maxQubits)
+    {
+        if (in_maxQubits == 0)
+        {
+            m_fuser.reset();
+            return;
+        }
+        if (m_fuser && m_fuser->maxQubits() == in_maxQubits)
+        {
+            // Keep the cached block matrices
+            return;
+        }
+        m_fuser = std::make_unique<WindowedGateFuser>(in_maxQubits, [this](const FusedGateBlock& in_block) { applyFusedBlock(in_block); });
+    }
+
+    template <typename FP>
+    void QppVisitorT<FP>::visitFused(const InstPtr& in_inst)
+    {
+        // Plain sub-circuits are expanded by the instruction iterator:
+        // no need to close the current block.
+        const bool isBlockModifier = in_inst->name() == "C-U" || in_inst->name() == "Pow-U" || in_inst->name() == "ifstmt";
+        if (m_fuser && in_inst->isComposite() && !isBlockModifier)
+        {
+            return;
+        }
+        if (!m_fuser || !m_fuser->add(in_inst))
+        {
+            in_inst->accept(this);
+        }
+    }
+
+    template <typename FP>
+    void QppVisitorT<FP>::flushFusedGates()
+    {
+        if (m_fuser)
+        {
+            m_fuser->flush();
+        }
+    }
+
+    template <typename FP>
+    void QppVisitorT<FP>::applyFusedBlock(const FusedGateBlock& in_block)
+    {
+        // The state vector is split into groups of 2^k amplitudes which only
+        // differ by the block qubits: each group is multiplied by the block
+        // matrix in place, hence the whole block takes one sweep.
+        const auto& qubits = in_block.qubits;
+        const size_t blockDim = 1ULL << qubits.size();
+        assert(blockDim <= (1ULL << WindowedGateFuser::MAX_BLOCK_QUBITS));
+        const Eigen::Matrix<std::complex<FP>, Eigen::Dynamic, Eigen::Dynamic> mat = in_block.matrix->template cast<std::complex<FP>>();
+        // Offset of each amplitude of a group w.r.t. the group base index
+        std::vector<uint64_t> offsets(blockDim, 0);
+        for (size_t j = 0; j < blockDim; ++j)
+        {
+            for (size_t l = 0; l < qubits.size(); ++l)
+            {
+                if ((j >> l) & 1)
+                {
+                    offsets[j] |= 1ULL << qubits[l];
+                }
+            }
+        }
+
+        const int64_t nbGroups = m_stateVec.size() >> qubits.size();
+#ifdef WITH_OPENMP_
+#pragma omp parallel for
+#endif // WITH_OPENMP_
+        for (int64_t g = 0; g < nbGroups; ++g)
+        {
+            // Base index: insert a zero bit at each (sorted) block qubit position.
+            uint64_t base = g;
+            for (const auto& q : qubits)
+            {
+                const uint64_t lowMask = (1ULL << q) - 1;
+                base = ((base & ~lowMask) << 1) | (base & lowMask);
+            }
+            std::complex<FP> amps[1ULL << WindowedGateFuser::MAX_BLOCK_QUBITS];
+            for (size_t j = 0; j < blockDim; ++j)
+            {
+                amps[j] = m_stateVec[base + offsets[j]];
+            }
+            for (size_t i = 0; i < blockDim; ++i)
+            {
+                std::complex<FP> sum = 0.0;
+                for (size_t j = 0; j < blockDim; ++j)
+                {
+                    sum += mat(i, j) * amps[j];
+                }
+                m_stateVec[base + offsets[i]] = sum;
+            }
+        }
+    }
+
+    template class QppVisitorT<float>;
+    template class QppVisitorT<double>;
 }}
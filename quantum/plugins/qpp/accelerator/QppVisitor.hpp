@@ -16,10 +16,12 @@
 #include "InstructionVisitor.hpp"
 #include <functional>
 #include <memory>
+#include <unordered_map>
 #include "Identifiable.hpp"
 #include "AllGateVisitor.hpp"
 #include "AcceleratorBuffer.hpp"
 #include "OptionsProvider.hpp"
+#include "GateFusion.hpp"
 #include "qpp.h"
 
 using namespace xacc;
@@ -27,8 +29,16 @@ using KetVectorType = qpp::ket;
 
 namespace xacc {
 namespace quantum {
-class QppVisitor : public AllGateVisitor, public InstructionVisitor<Circuit>, public OptionsProvider, public xacc::Cloneable<QppVisitor> {
+// State vector with single (FP = float) or double (FP = double) precision amplitudes
+template <typename FP>
+using QppKet = Eigen::Matrix<std::complex<FP>, Eigen::Dynamic, 1>;
+
+// Note: qpp gates (and measurements) are double-precision, gate matrices are
+// cast to the precision of the state vector before being applied.
+template <typename FP>
+class QppVisitorT : public AllGateVisitor, public InstructionVisitor<Circuit>, public OptionsProvider, public xacc::Cloneable<QppVisitorT<FP>> {
 public:
+  using StateVectorType = QppKet<FP>;
   void initialize(std::shared_ptr<AcceleratorBuffer> buffer, bool shotsMode = false);
   void finalize();
 
@@ -58,23 +68,43 @@ public:
   void visit(fSim& in_fsimGate) override;
   void visit(Reset& in_resetGate) override;
   void visit(Circuit& in_circuit) override;
-  virtual std::shared_ptr<QppVisitor> clone() override { return std::make_shared<QppVisitor>(); }
-  const KetVectorType& getStateVec() const { return m_stateVec; }
-  static double calcExpectationValueZ(const KetVectorType& in_stateVec, const std::vector<qpp::idx>& in_bits);
+  virtual std::shared_ptr<QppVisitorT<FP>> clone() override { return std::make_shared<QppVisitorT<FP>>(); }
+  const StateVectorType& getStateVec() const { return m_stateVec; }
+  static double calcExpectationValueZ(const StateVectorType& in_stateVec, const std::vector<qpp::idx>& in_bits);
   double getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_composite);
 
   // Gate-by-gate API (FTQC)
   void applyGate(Gate& in_gate);
   bool measure(size_t in_bit);
   bool isInitialized() const { return m_initialized; }
+  // Exchange the simulated state with an external one (shot branching)
+  void swapStateVec(StateVectorType& io_stateVec) { m_stateVec.swap(io_stateVec); }
   // Allocate more qubits (zero state)
   void allocateQubits(size_t in_nbQubits);
+
+  // Windowed gate fusion: consecutive gates acting on at most in_maxQubits
+  // qubits are applied as one fused block, i.e. in a single sweep over the
+  // state vector (in_maxQubits = 0: disabled).
+  void setGateFusion(size_t in_maxQubits);
+  // Visit an instruction, fusing it with the preceding gates if possible.
+  // Note: flushFusedGates() must be called before accessing the state vector.
+  void visitFused(const InstPtr& in_inst);
+  void flushFusedGates();
+  // Null if gate fusion is disabled
+  const WindowedGateFuser* getGateFuser() const { return m_fuser.get(); }
 private:
   qpp::idx xaccIdxToQppIdx(size_t in_idx) const;
+  // Apply a (double-precision) gate matrix on the state vector
+  void applyMat(const qpp::cmat& in_mat, const std::vector<qpp::idx>& in_targets);
+  void applyCtrlMat(const qpp::cmat& in_mat, const std::vector<qpp::idx>& in_ctrls, const std::vector<qpp::idx>& in_targets);
+  // Measure (and collapse) a qubit (XACC index)
+  qpp::idx measureQubit(size_t in_bit);
+  // Apply a fused block in place
+  void applyFusedBlock(const FusedGateBlock& in_block);
 private:
   std::shared_ptr<AcceleratorBuffer> m_buffer;  
   std::vector<qpp::idx> m_dims;
-  KetVectorType m_stateVec;
+  StateVectorType m_stateVec;
   std::vector<qpp::idx> m_measureBits;
   // If true, it will perform a trajectory simulation and return the bit string of measurement results.
   // Otherwise, it will only compute the expectation value.
@@ -82,5 +112,18 @@ private:
   std::string m_bitString;
   bool m_initialized = false;
   std::vector<std::reference_wrapper<xacc::quantum::Circuit>> m_controlledBlocks;
+  // Pow-U blocks acting on up to this number of qubits are applied as a
+  // single fused unitary (raised to the power by repeated squaring).
+  static constexpr size_t MAX_FUSED_POWER_QUBITS = 8;
+  static constexpr size_t MAX_FUSED_POWER_CACHE_SIZE = 64;
+  // Fused U^n matrices, by power and base circuit.
+  std::unordered_map<std::string, qpp::cmat> m_fusedPowerCache;
+  std::unique_ptr<WindowedGateFuser> m_fuser;
 };
+
+// Default (double-precision) visitor
+using QppVisitor = QppVisitorT<double>;
+// Both precisions are instantiated in QppVisitor.cpp
+extern template class QppVisitorT<float>;
+extern template class QppVisitorT<double>;
 }}
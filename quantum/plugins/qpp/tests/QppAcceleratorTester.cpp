@@ -18,7 +18,15 @@
 #include "xacc_service.hpp"
 #include "Algorithm.hpp"
 #include "CommonGates.hpp"
+#include "StreamingSampler.hpp"
+#include "InstructionIterator.hpp"
+#include "PrecisionBenchmark.hpp"
 #include <random>
+#include <chrono>
+#include <cstdio>
+
+using namespace xacc::quantum::test;
+
 namespace {
     template <typename T>
     std::vector<T> linspace(T a, T b, size_t N)
@@ -634,6 +642,49 @@ Measure(q[0], cReg[3]);
   EXPECT_EQ(buffer->getMeasurementCounts()["1101"], 1024);
 }
 
+TEST(QppAcceleratorTester, checkShotBranching)
+{
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void teleport_branching(qbit q) {
+    Rx(q[0], -0.123);
+    H(q[1]);
+    CX(q[1], q[2]);
+    CX(q[0], q[1]);
+    H(q[0]);
+    Measure(q[0]);
+    Measure(q[1]);
+    if (q[0]) {
+      Z(q[2]);
+    }
+    if (q[1]) {
+      X(q[2]);
+    }
+    Rx(q[2], 0.123);
+    Reset(q[0]);
+    Reset(q[1]);
+    Measure(q[2]);
+  })");
+  auto program = ir->getComposites()[0];
+  const int nbShots = 8192;
+  // Shot-by-shot reference, shot-branching with default/tiny budgets.
+  for (const auto &config :
+       {xacc::HeterogeneousMap{{"shot-branching", false}},
+        xacc::HeterogeneousMap{}, xacc::HeterogeneousMap{{"branch-budget", 1}}}) {
+    auto accelerator = xacc::getAccelerator("qpp", {{"shots", nbShots}});
+    accelerator->updateConfiguration(config);
+    auto buffer = xacc::qalloc(3);
+    buffer->setName("q");
+    xacc::storeBuffer(buffer);
+    accelerator->execute(buffer, program);
+    const auto counts = buffer->getMeasurementCounts();
+    EXPECT_EQ(4, counts.size());
+    // Uniform Bell measurement outcomes, perfect teleportation.
+    for (const auto &bitString : {"000", "100", "010", "110"}) {
+      EXPECT_NEAR(nbShots / 4, counts.at(bitString), 300);
+    }
+  }
+}
+
 TEST(QppAcceleratorTester, testFtqcApply)
 {
     auto provider = xacc::getIRProvider("quantum");
@@ -785,6 +836,246 @@ TEST(QppAcceleratorTester, checkRandomSeed) {
             buffer2->getMeasurementCounts()["11"]);
 }
 
+TEST(QppAcceleratorTester, checkPrecision) {
+  auto circuit = randomLayeredCircuit(8, 10, 42);
+  const auto [expValFp64, timeFp64] =
+      runWithPrecision("qpp", "fp64", circuit, 8);
+  const auto [expValFp32, timeFp32] =
+      runWithPrecision("qpp", "fp32", circuit, 8);
+  EXPECT_NEAR(expValFp32, expValFp64, 1e-4);
+
+  // Sampling from a single-precision state vector
+  auto accelerator =
+      xacc::getAccelerator("qpp", {{"precision", "fp32"}, {"shots", 1024}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void bell_fp32(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                                  accelerator);
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, ir->getComposite("bell_fp32"));
+  EXPECT_EQ(buffer->getMeasurementCounts().size(), 2);
+  EXPECT_EQ(buffer->getMeasurementCounts()["00"] +
+                buffer->getMeasurementCounts()["11"],
+            1024);
+
+  // Restore default settings
+  xacc::getAccelerator("qpp", {{"precision", "fp64"}});
+}
+
+// Error vs. speed of single precision: not a pass/fail test, the timings are
+// printed for reference. Run with --gtest_also_run_disabled_tests.
+TEST(QppAcceleratorTester, DISABLED_benchmarkPrecision) {
+  EXPECT_LT(benchmarkPrecision("qpp"), 1e-3);
+  xacc::getAccelerator("qpp", {{"precision", "fp64"}});
+}
+
+TEST(QppAcceleratorTester, checkGateFusion) {
+  // Hardware-efficient ansatz: Ry-Rz layers + CNOT ladder.
+  const int nbQubits = 8;
+  const int nbLayers = 10;
+  auto provider = xacc::getIRProvider("quantum");
+  auto circuit = provider->createComposite("hwe_ansatz_fusion");
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dis(-M_PI, M_PI);
+  for (int layer = 0; layer < nbLayers; ++layer) {
+    for (size_t q = 0; q < nbQubits; ++q) {
+      circuit->addInstruction(provider->createInstruction("Ry", {q}, {dis(gen)}));
+      circuit->addInstruction(provider->createInstruction("Rz", {q}, {dis(gen)}));
+    }
+    for (size_t q = 0; q + 1 < nbQubits; ++q) {
+      circuit->addInstruction(provider->createInstruction("CNOT", {q, q + 1}));
+    }
+  }
+  for (size_t q = 0; q < nbQubits; ++q) {
+    circuit->addInstruction(provider->createInstruction("Measure", {q}));
+  }
+
+  auto accelerator = xacc::getAccelerator("qpp");
+  auto refBuffer = xacc::qalloc(nbQubits);
+  accelerator->execute(refBuffer, circuit);
+  const double expected = refBuffer->getExpectationValueZ();
+
+  for (int k = 2; k <= 5; ++k) {
+    auto fusedAcc = xacc::getAccelerator("qpp", {{"fusion-max-qubits", k}});
+    auto buffer = xacc::qalloc(nbQubits);
+    fusedAcc->execute(buffer, circuit);
+    EXPECT_NEAR(buffer->getExpectationValueZ(), expected, 1e-9);
+    const int nbGates = (*buffer)["fused-gates"].as<int>();
+    const int nbBlocks = (*buffer)["fused-blocks"].as<int>();
+    std::cout << "k = " << k << ": " << nbGates << " gates in " << nbBlocks
+              << " blocks.\n";
+    EXPECT_EQ(nbGates, nbLayers * (3 * nbQubits - 1));
+    if (k >= 4) {
+      EXPECT_GE(nbGates, 3 * nbBlocks);
+    }
+  }
+
+  // Dynamic circuit (mid-circuit measurement): blocks are flushed before
+  // measuring.
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void fusion_teleport(qbit q) {
+      X(q[0]);
+      H(q[1]);
+      CNOT(q[1], q[2]);
+      CNOT(q[0], q[1]);
+      H(q[0]);
+      Measure(q[0]);
+      Measure(q[1]);
+      if (q[0]) {
+        Z(q[2]);
+      }
+      if (q[1]) {
+        X(q[2]);
+      }
+      Measure(q[2]);
+    })",
+                                  nullptr);
+  // Shot-by-shot simulation
+  auto shotsAcc = xacc::getAccelerator(
+      "qpp",
+      {{"shots", 256}, {"shot-branching", false}, {"fusion-max-qubits", 3}});
+  auto buffer = xacc::qalloc(3);
+  buffer->setName("q");
+  xacc::storeBuffer(buffer);
+  shotsAcc->execute(buffer, ir->getComposite("fusion_teleport"));
+  for (const auto &[bitString, count] : buffer->getMeasurementCounts()) {
+    // The teleported state is |1>
+    EXPECT_EQ(bitString.back(), '1');
+  }
+  // Restore default settings
+  xacc::getAccelerator("qpp", {{"fusion-max-qubits", 0}});
+}
+
+TEST(QppAcceleratorTester, checkStreamingSampler) {
+  // q0: random, q1: random (not measured), q2: 1
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void streaming_sampler(qbit q) {
+      H(q[0]);
+      H(q[1]);
+      X(q[2]);
+      Measure(q[0]);
+      Measure(q[2]);
+    })",
+                                  nullptr);
+  auto program = ir->getComposite("streaming_sampler");
+
+  // Counts only: 10^8 shots don't require any per-shot storage.
+  {
+    const int nbShots = 100000000;
+    auto accelerator = xacc::getAccelerator("qpp", {{"shots", nbShots}});
+    auto buffer = xacc::qalloc(3);
+    const auto start = std::chrono::steady_clock::now();
+    accelerator->execute(buffer, program);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << nbShots << " shots: " << elapsed.count() << " ms\n";
+    auto counts = buffer->getMeasurementCounts();
+    EXPECT_EQ(counts.size(), 2);
+    EXPECT_EQ(counts["01"] + counts["11"], nbShots);
+    // Binomial(N, 1/2): 5 sigma
+    EXPECT_NEAR(counts["01"], nbShots / 2, 5 * std::sqrt(nbShots / 4.0));
+  }
+
+  // Per-shot output: a random order of the sampled shots
+  {
+    const int nbShots = 10000;
+    auto accelerator = xacc::getAccelerator(
+        "qpp", {{"shots", nbShots},
+                {"shot-file-prefix", std::string("qpp_streaming_")},
+                {"shot-file-chunk-size", 4096}});
+    auto buffer = xacc::qalloc(3);
+    accelerator->execute(buffer, program);
+    const auto shotFile = (*buffer)["shot-file"].as<std::string>();
+    xacc::quantum::ShotFileReader reader(shotFile);
+    EXPECT_EQ(reader.nbBits(), 2);
+    EXPECT_EQ(reader.nbShots(), nbShots);
+    std::map<std::string, int> fileCounts;
+    std::vector<uint64_t> shots;
+    int nbChunks = 0;
+    while (reader.next(shots)) {
+      EXPECT_LE(shots.size(), 4096);
+      for (const auto &shot : shots) {
+        fileCounts[xacc::quantum::StreamingSampler::toBitString(shot, 2)]++;
+      }
+      nbChunks++;
+    }
+    EXPECT_EQ(nbChunks, 3);
+    EXPECT_EQ(fileCounts, buffer->getMeasurementCounts());
+    std::remove(shotFile.c_str());
+  }
+}
+
+TEST(QppAcceleratorTester, checkPrefixSharing) {
+  auto H = xacc::quantum::getObservable(
+      "pauli", std::string("5.907 - 2.1433 X0X1 - 2.1433 Y0Y1 + .21829 Z0 - "
+                           "6.125 Z1 + 0.5 X0Z1"));
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit prefix_sharing_ansatz
+        .parameters t0, t1
+        .qbit q
+        X(q[0]);
+        Ry(q[1], t0);
+        CNOT(q[1],q[0]);
+        Ry(q[0], t1);
+        CNOT(q[0],q[1]);
+    )");
+  auto ansatz = xacc::getCompiled("prefix_sharing_ansatz");
+
+  // Energy and parameter-shift gradient circuits: the observed circuits of
+  // each parameter set share the ansatz, and the shifted ansatzes share the
+  // gates before the shifted angle.
+  const std::vector<double> x{0.3, -0.7};
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+  const auto addObserved = [&](const std::vector<double> &in_params) {
+    for (auto &circuit : H->observe(ansatz->operator()(in_params))) {
+      xacc::InstructionIterator it(circuit);
+      bool hasMeasure = false;
+      while (it.hasNext()) {
+        hasMeasure = hasMeasure || (it.next()->name() == "Measure");
+      }
+      // Skip the identity term
+      if (hasMeasure) {
+        batch.emplace_back(circuit);
+      }
+    }
+  };
+  addObserved(x);
+  for (int i = 0; i < x.size(); ++i) {
+    for (const double shift : {M_PI_2, -M_PI_2}) {
+      auto shifted = x;
+      shifted[i] += shift;
+      addObserved(shifted);
+    }
+  }
+
+  const auto runBatch = [&](const xacc::HeterogeneousMap &in_config) {
+    auto accelerator = xacc::getAccelerator("qpp", in_config);
+    auto buffer = xacc::qalloc(2);
+    accelerator->execute(buffer, batch);
+    std::vector<double> result;
+    for (auto &child : buffer->getChildren()) {
+      result.emplace_back(child->getExpectationValueZ());
+    }
+    return result;
+  };
+  // Reference: independent simulations
+  const auto expected = runBatch({{"vqe-mode", false}});
+  EXPECT_EQ(expected.size(), batch.size());
+  // With checkpoints, and replaying the branch states (no checkpoint memory)
+  for (const int memory : {1024, 0}) {
+    const auto actual = runBatch({{"vqe-mode", true}, {"checkpoint-memory", memory}});
+    EXPECT_EQ(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); ++i) {
+      EXPECT_NEAR(actual[i], expected[i], 1e-9);
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
 
@@ -13,6 +13,8 @@
  *******************************************************************************/
 #include <typeinfo>
 #include "QrackAccelerator.hpp"
+#include "ShotBranching.hpp"
+#include "PrefixTrie.hpp"
 
 namespace xacc {
 namespace quantum {
@@ -88,6 +90,42 @@ namespace quantum {
                 xacc::error("Invalid 'zero_threshold' parameter. (Must be >= 0.)");
             }
         }
+
+        m_shotBranching = true;
+        if (params.keyExists<bool>("shot-branching"))
+        {
+            m_shotBranching = params.get<bool>("shot-branching");
+        }
+
+        m_branchBudget = 32;
+        if (params.keyExists<int>("branch-budget"))
+        {
+            m_branchBudget = params.get<int>("branch-budget");
+            if (m_branchBudget < 1)
+            {
+                xacc::error("Invalid 'branch-budget' parameter. (Must be >= 1.)");
+            }
+        }
+
+        if (params.keyExists<int>("seed"))
+        {
+            m_rng.seed(params.get<int>("seed"));
+        }
+
+        m_checkpointMemoryMb = 1024;
+        setCheckpointMemory(params);
+    }
+
+    void QrackAccelerator::setCheckpointMemory(const HeterogeneousMap& params)
+    {
+        if (params.keyExists<int>("checkpoint-memory"))
+        {
+            m_checkpointMemoryMb = params.get<int>("checkpoint-memory");
+            if (m_checkpointMemoryMb < 0)
+            {
+                xacc::error("Invalid 'checkpoint-memory' parameter.");
+            }
+        }
     }
 
     void QrackAccelerator::execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction)
@@ -124,7 +162,7 @@ namespace quantum {
                 }
             }
 
-            if (!canSample && xacc::verbose)
+            if (!canSample && !m_shotBranching && xacc::verbose)
             {
                 std::cout << "Cannot sample; must repeat circuit per shot. If possible, consider removing conditionals, running 1 shot, and/or only measuring at the end of the circuit." << std::endl;
             }
@@ -151,6 +189,10 @@ namespace quantum {
         {
             runCircuit(m_shots);
         }
+        else if (m_shotBranching)
+        {
+            runShotBranching(buffer, compositeInstruction);
+        }
         else
         {
            for (int i = 0; i < m_shots; ++i)
@@ -159,8 +201,80 @@ namespace quantum {
            }
         }
     }
+    void QrackAccelerator::runShotBranching(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction)
+    {
+        using Engine = ShotBranching<Qrack::QInterfacePtr>;
+        Engine::Backend backend;
+        // Controlled blocks (C-U) are applied via their decomposition.
+        std::function<void(const InstPtr&)> applyInst = [&](const InstPtr& in_inst) {
+            in_inst->accept(m_visitor);
+            if (in_inst->isComposite() && in_inst->isEnabled())
+            {
+                for (auto& subInst : xacc::ir::asComposite(in_inst)->getInstructions())
+                {
+                    if (subInst->isEnabled())
+                    {
+                        applyInst(subInst);
+                    }
+                }
+            }
+        };
+        backend.apply = [&](Qrack::QInterfacePtr& io_qReg, const std::vector<InstPtr>& in_gates) {
+            m_visitor->swapState(io_qReg);
+            for (auto& gate : in_gates)
+            {
+                applyInst(gate);
+            }
+            m_visitor->swapState(io_qReg);
+        };
+        backend.probabilityOne = [](Qrack::QInterfacePtr& in_qReg, size_t in_qubit) {
+            return (double)in_qReg->Prob(in_qubit);
+        };
+        backend.collapse = [](Qrack::QInterfacePtr& io_qReg, size_t in_qubit, bool in_result) {
+            io_qReg->ForceM(in_qubit, in_result);
+        };
+        backend.flip = [](Qrack::QInterfacePtr& io_qReg, size_t in_qubit) {
+            io_qReg->X(in_qubit);
+        };
+        backend.copy = [](const Qrack::QInterfacePtr& in_qReg) {
+            return in_qReg->Clone();
+        };
+        backend.isSameState = [](const Qrack::QInterfacePtr& in_qReg1, const Qrack::QInterfacePtr& in_qReg2) {
+            return in_qReg1->ApproxCompare(in_qReg2);
+        };
+
+        // The visitor only provides the gate implementations here,
+        // its simulator is exchanged with the one of each branch.
+        m_visitor->initialize(buffer, 1, m_use_opencl, m_use_qunit, m_use_qunit_multi, m_use_stabilizer, m_use_binary_decision_tree, m_use_paging, m_use_z_x_fusion, m_use_cpu_gpu_hybrid, m_device_id, m_do_normalize, m_zero_threshold);
+        Qrack::QInterfacePtr initialState;
+        m_visitor->swapState(initialState);
+        std::map<std::string, int> counts;
+        Engine engine(backend, m_branchBudget);
+        engine.run(compositeInstruction, buffer->name(), std::move(initialState), m_shots, m_rng,
+            [&](const Engine::Branch& in_branch) {
+                counts[in_branch.bitString()] += in_branch.shots;
+                // Measurement results of the last branch are kept in the buffer
+                // (same as the last shot of a shot-by-shot simulation).
+                buffer->reset_single_measurements();
+                in_branch.replay(*buffer);
+            });
+        for (const auto& [bitString, count] : counts)
+        {
+            buffer->appendMeasurement(bitString, count);
+        }
+        xacc::info("Shot branching: " + std::to_string(engine.nbSplits()) + " splits, max. " +
+                   std::to_string(engine.peakBranches()) + " branches.");
+    }
+
     void QrackAccelerator::execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions)
     {
+        // Expectation values only (no shots): simulate the shared prefixes once.
+        if (m_shots < 1 && compositeInstructions.size() > 1)
+        {
+            executeObserved(buffer, compositeInstructions);
+            return;
+        }
+
         for (auto& f : compositeInstructions)
         {
             auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(f->name(), buffer->size());
@@ -168,4 +282,47 @@ namespace quantum {
             buffer->appendChild(f->name(), tmpBuffer);
         }
     }
+
+    void QrackAccelerator::executeObserved(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions)
+    {
+        const PrefixTrie trie(compositeInstructions);
+        PrefixTrie::Backend<Qrack::QInterfacePtr> backend;
+        backend.init = [&]() {
+            m_visitor->initialize(buffer, -1, m_use_opencl, m_use_qunit, m_use_qunit_multi, m_use_stabilizer, m_use_binary_decision_tree, m_use_paging, m_use_z_x_fusion, m_use_cpu_gpu_hybrid, m_device_id, m_do_normalize, m_zero_threshold);
+            Qrack::QInterfacePtr qReg;
+            m_visitor->swapState(qReg);
+            return qReg;
+        };
+        backend.apply = [&](Qrack::QInterfacePtr& io_qReg, const std::vector<InstPtr>& in_gates) {
+            m_visitor->swapState(io_qReg);
+            for (auto& gate : in_gates)
+            {
+                gate->accept(m_visitor);
+            }
+            m_visitor->swapState(io_qReg);
+        };
+        backend.copy = [](const Qrack::QInterfacePtr& in_qReg) {
+            return in_qReg->Clone();
+        };
+
+        std::vector<double> expectationValues(compositeInstructions.size(), 0.0);
+        // Checkpoints are budgeted as full state vectors.
+        const auto budget = PrefixTrie::checkpointBudget(m_checkpointMemoryMb, (1ULL << buffer->size()) * sizeof(Qrack::complex));
+        const auto stats = trie.run<Qrack::QInterfacePtr>(backend, budget,
+            [&](size_t in_circuitIdx, const Qrack::QInterfacePtr& in_qReg) {
+                const auto& measuredBits = trie.measuredBits(in_circuitIdx);
+                expectationValues[in_circuitIdx] = QrackVisitor::calcExpectationValueZ(
+                    in_qReg, std::vector<bitLenInt>(measuredBits.begin(), measuredBits.end()));
+            });
+        xacc::info("Prefix sharing: " + std::to_string(stats.nbAppliedGates) + " gates applied (" +
+                   std::to_string(trie.nbGates()) + " in the batch), " + std::to_string(stats.nbCheckpoints) +
+                   " checkpoints, " + std::to_string(stats.nbRecomputes) + " recomputed.");
+
+        for (int i = 0; i < compositeInstructions.size(); ++i)
+        {
+            auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(compositeInstructions[i]->name(), buffer->size());
+            tmpBuffer->addExtraInfo("exp-val-z", expectationValues[i]);
+            buffer->appendChild(compositeInstructions[i]->name(), tmpBuffer);
+        }
+    }
 }}
@@ -14,6 +14,7 @@
 #pragma once
 #include "xacc.hpp"
 #include "QrackVisitor.hpp"
+#include <random>
 
 namespace xacc {
 namespace quantum {
@@ -35,6 +36,11 @@ public:
     virtual void execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction) override;
     virtual void execute(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions) override;
 private:
+    void setCheckpointMemory(const HeterogeneousMap& params);
+    // Run shots of a dynamic circuit (mid-circuit measure/reset, if statements)
+    void runShotBranching(std::shared_ptr<AcceleratorBuffer> buffer, const std::shared_ptr<CompositeInstruction> compositeInstruction);
+    // Expectation values of a batch of circuits, with prefix sharing
+    void executeObserved(std::shared_ptr<AcceleratorBuffer> buffer, const std::vector<std::shared_ptr<CompositeInstruction>> compositeInstructions);
     std::shared_ptr<QrackVisitor> m_visitor;
     int m_shots = -1;
     bool m_use_opencl = true;
@@ -48,5 +54,13 @@ private:
     int m_device_id = -1;
     bool m_do_normalize = false;
     double m_zero_threshold = REAL1_EPSILON;
+    // Shot-branching simulation of dynamic circuits
+    bool m_shotBranching = true;
+    int m_branchBudget = 32;
+    // Random draws of the shot branching (reproducible with the "seed" option)
+    std::mt19937_64 m_rng{std::random_device{}()};
+    // Memory budget (MB) of the state checkpoints of the prefix-sharing
+    // execution of observed circuits
+    int m_checkpointMemoryMb = 1024;
 };
 }}
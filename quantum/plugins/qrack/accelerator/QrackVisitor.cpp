@@ -30,6 +30,11 @@ namespace quantum {
     }
 
     double QrackVisitor::calcExpectationValueZ() const
+    {
+        return calcExpectationValueZ(m_qReg, m_measureBits);
+    }
+
+    double QrackVisitor::calcExpectationValueZ(const Qrack::QInterfacePtr& in_qReg, const std::vector<bitLenInt>& in_bits)
     {
         const auto hasEvenParity = [](size_t x, const std::vector<bitLenInt>& in_qubitIndices) -> bool {
             size_t count = 0;
@@ -43,13 +48,13 @@ namespace quantum {
             return (count & 1) == 0;
         };
 
-        std::vector<Qrack::complex> wfn((bitCapIntOcl)m_qReg->GetMaxQPower());
-        m_qReg->GetQuantumState(&(wfn[0]));
+        std::vector<Qrack::complex> wfn((bitCapIntOcl)in_qReg->GetMaxQPower());
+        in_qReg->GetQuantumState(&(wfn[0]));
 
         double result = 0.0;
         for(uint64_t i = 0; i < wfn.size(); ++i)
         {
-            result += (hasEvenParity(i, m_measureBits) ? 1.0 : -1.0) * std::norm(wfn[i]);
+            result += (hasEvenParity(i, in_bits) ? 1.0 : -1.0) * std::norm(wfn[i]);
         }
 
         return result;
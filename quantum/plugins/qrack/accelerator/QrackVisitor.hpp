@@ -36,6 +36,9 @@ class QrackVisitor : public AllGateVisitor, public OptionsProvider, public xacc:
 public:
   void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int shots, bool use_opencl, bool use_qunit, bool use_qunit_multi, bool use_stabilizer, bool use_binary_decision_tree, bool use_paging, bool use_z_x_fusion, bool use_cpu_gpu_hybrid, int device_id, bool doNormalize, double zero_threshold);
   void finalize();
+  // Exchange the simulated state with an external one (shot branching)
+  void swapState(Qrack::QInterfacePtr& io_qReg) { std::swap(m_qReg, io_qReg); }
+  static double calcExpectationValueZ(const Qrack::QInterfacePtr& in_qReg, const std::vector<bitLenInt>& in_bits);
 
   void visit(Hadamard& h) override;
   void visit(CNOT& cnot) override;
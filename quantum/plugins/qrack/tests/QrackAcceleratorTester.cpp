@@ -18,6 +18,7 @@
 #include "xacc_observable.hpp"
 #include "xacc_service.hpp"
 #include "Algorithm.hpp"
+#include "InstructionIterator.hpp"
 
 namespace {
     template <typename T>
@@ -328,6 +329,79 @@ TEST(QrackAcceleratorTester, testFsim)
     }
 }
 
+TEST(QrackAcceleratorTester, testPrefixSharing)
+{
+    auto H = xacc::quantum::getObservable(
+        "pauli", std::string("5.907 - 2.1433 X0X1 - 2.1433 Y0Y1 + .21829 Z0 - 6.125 Z1 + 0.5 X0Z1"));
+    xacc::qasm(R"(
+        .compiler xasm
+        .circuit prefix_sharing_ansatz
+        .parameters t0, t1
+        .qbit q
+        X(q[0]);
+        Ry(q[1], t0);
+        CNOT(q[1],q[0]);
+        Ry(q[0], t1);
+        CNOT(q[0],q[1]);
+    )");
+    auto ansatz = xacc::getCompiled("prefix_sharing_ansatz");
+
+    // Energy and parameter-shift gradient circuits
+    const std::vector<double> x { 0.3, -0.7 };
+    std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+    const auto addObserved = [&](const std::vector<double>& in_params) {
+        for (auto& circuit : H->observe(ansatz->operator()(in_params)))
+        {
+            xacc::InstructionIterator it(circuit);
+            bool hasMeasure = false;
+            while (it.hasNext())
+            {
+                hasMeasure = hasMeasure || (it.next()->name() == "Measure");
+            }
+            // Skip the identity term
+            if (hasMeasure)
+            {
+                batch.emplace_back(circuit);
+            }
+        }
+    };
+    addObserved(x);
+    for (int i = 0; i < x.size(); ++i)
+    {
+        for (const double shift : { M_PI_2, -M_PI_2 })
+        {
+            auto shifted = x;
+            shifted[i] += shift;
+            addObserved(shifted);
+        }
+    }
+
+    // Reference: one circuit at a time
+    auto accelerator = xacc::getAccelerator("qrack");
+    std::vector<double> expected;
+    for (auto& circuit : batch)
+    {
+        auto buffer = xacc::qalloc(2);
+        accelerator->execute(buffer, circuit);
+        expected.emplace_back(buffer->getExpectationValueZ());
+    }
+
+    // With checkpoints, and replaying the branch states (no checkpoint memory)
+    for (const int memory : { 1024, 0 })
+    {
+        accelerator = xacc::getAccelerator("qrack", { std::make_pair("checkpoint-memory", memory) });
+        auto buffer = xacc::qalloc(2);
+        accelerator->execute(buffer, batch);
+        const auto children = buffer->getChildren();
+        EXPECT_EQ(children.size(), batch.size());
+        for (int i = 0; i < children.size(); ++i)
+        {
+            EXPECT_EQ(children[i]->name(), batch[i]->name());
+            EXPECT_NEAR(children[i]->getExpectationValueZ(), expected[i], 1e-5);
+        }
+    }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
 
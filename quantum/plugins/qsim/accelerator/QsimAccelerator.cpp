@@ -12,10 +12,13 @@
  *******************************************************************************/
 #include "QsimAccelerator.hpp"
 #include "xacc_plugin.hpp"
-#include "IRUtils.hpp"
+#include "PrefixTrie.hpp"
+#include "ShotBranching.hpp"
+#include "StreamingSampler.hpp"
 #include <cassert>
 #include <optional>
 #include <thread>
+#include <type_traits>
 namespace {
 inline bool isMeasureGate(const xacc::InstPtr &in_instr) {
   return (in_instr->name() == "Measure");
@@ -69,24 +72,23 @@ void PrintAmplitudes(unsigned num_qubits, const StateSpace &state_space,
 // 1. Copy state onto scratch
 // 2. Evolve scratch forward with Z terms
 // 3. Compute < state | scratch >
-template <typename Params, typename StateSpace, typename State>
+template <typename FP, typename Params, typename StateSpace, typename State>
 double computeExpValZ(const Params& params, size_t num_threads, const std::vector<size_t> &meas_bits,
                       const StateSpace &state_space, const State &state) {
   auto scratch = state_space.Create(state.num_qubits());
   // copy from src to scratch.
   const bool copyOk = state_space.Copy(state, scratch);
   assert(copyOk);
-  qsim::Circuit<qsim::GateQSim<float>> meas_circuit;
+  qsim::Circuit<qsim::GateQSim<FP>> meas_circuit;
   meas_circuit.num_qubits = state.num_qubits();
   size_t time = 0;
   for (const auto &bit : meas_bits) {
-    meas_circuit.gates.emplace_back(qsim::GateZ<float>::Create(time++, bit));
+    meas_circuit.gates.emplace_back(qsim::GateZ<FP>::Create(time++, bit));
   }
-  using namespace qsim;
-  using Fuser = MultiQubitGateFuser<IO, GateQSim<float>>;
+  using Fuser = typename xacc::quantum::QsimTypes<FP>::Fuser;
   auto fused_circuit =
       Fuser::FuseGates(params, meas_circuit.num_qubits, meas_circuit.gates);
-  xacc::quantum::QsimAccelerator::Simulator sim(num_threads);
+  typename xacc::quantum::QsimTypes<FP>::Simulator sim(num_threads);
   for (const auto &fused_gate : fused_circuit) {
     qsim::ApplyFusedGate(sim, fused_gate, scratch);
   }
@@ -130,18 +132,93 @@ void QsimAccelerator::initialize(const HeterogeneousMap &params) {
       xacc::info("Enable VQE Mode.");
     }
   }
+
+  m_shotBranching = true;
+  if (params.keyExists<bool>("shot-branching")) {
+    m_shotBranching = params.get<bool>("shot-branching");
+  }
+  m_branchBudget = 32;
+  if (params.keyExists<int>("branch-budget")) {
+    m_branchBudget = params.get<int>("branch-budget");
+    if (m_branchBudget < 1) {
+      xacc::error("Invalid 'branch-budget' parameter.");
+    }
+  }
+
+  // State vector precision: single (default, vectorized simulator) or double.
+  m_doublePrecision = false;
+  if (params.stringExists("precision")) {
+    const auto precision = params.getString("precision");
+    if (precision != "fp32" && precision != "fp64") {
+      xacc::error("Invalid 'precision' parameter '" + precision +
+                  "'. Valid values are 'fp32' and 'fp64'.");
+    }
+    m_doublePrecision = (precision == "fp64");
+  }
+
+  m_shotFilePrefix.clear();
+  if (params.stringExists("shot-file-prefix")) {
+    m_shotFilePrefix = params.getString("shot-file-prefix");
+  }
+  m_shotFileChunkSize = ShotFileWriter::DEFAULT_CHUNK_SIZE;
+  if (params.keyExists<int>("shot-file-chunk-size")) {
+    m_shotFileChunkSize = params.get<int>("shot-file-chunk-size");
+    if (m_shotFileChunkSize < 1) {
+      xacc::error("Invalid 'shot-file-chunk-size' parameter.");
+    }
+  }
+
+  m_checkpointMemoryMb = 1024;
+  setCheckpointMemory(params);
+}
+
+void QsimAccelerator::setCheckpointMemory(const HeterogeneousMap &params) {
+  if (params.keyExists<int>("checkpoint-memory")) {
+    m_checkpointMemoryMb = params.get<int>("checkpoint-memory");
+    if (m_checkpointMemoryMb < 0) {
+      xacc::error("Invalid 'checkpoint-memory' parameter.");
+    }
+  }
+}
+
+template <typename FP>
+typename QsimTypes<FP>::Runner::Parameter
+QsimAccelerator::getRunnerParameter() const {
+  if constexpr (std::is_same_v<FP, float>) {
+    return m_qsimParam;
+  } else {
+    typename QsimTypes<FP>::Runner::Parameter param;
+    param.seed = m_qsimParam.seed;
+    param.verbosity = m_qsimParam.verbosity;
+    return param;
+  }
 }
 
 void QsimAccelerator::execute(
     std::shared_ptr<AcceleratorBuffer> buffer,
     const std::shared_ptr<CompositeInstruction> compositeInstruction) {
+  if (m_doublePrecision) {
+    executeCircuit<double>(buffer, compositeInstruction);
+  } else {
+    executeCircuit<float>(buffer, compositeInstruction);
+  }
+}
+
+template <typename FP>
+void QsimAccelerator::executeCircuit(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> compositeInstruction) {
+  using StateSpace = typename QsimTypes<FP>::StateSpace;
+  using State = typename QsimTypes<FP>::State;
+  using Runner = typename QsimTypes<FP>::Runner;
+  const auto qsimParam = getRunnerParameter<FP>();
   const bool qsimSimulateSamples = m_shots > 0 && !m_vqeMode;
   const bool areAllMeasurementsTerminal =
       shotCountFromFinalStateVec(compositeInstruction);
 
   if (!qsimSimulateSamples || areAllMeasurementsTerminal) {
     // Construct Qsim circuit:
-    QsimCircuitVisitor visitor(buffer->size());
+    QsimCircuitVisitorT<FP> visitor(buffer->size());
     std::vector<size_t> measureBitIdxs;
     // Walk the IR tree, and visit each node
     InstructionIterator it(compositeInstruction);
@@ -162,25 +239,33 @@ void QsimAccelerator::execute(
     State state = stateSpace.Create(circuit.num_qubits);
     stateSpace.SetStateZero(state);
     
-    if (Runner::Run(m_qsimParam, Factory(m_numThreads), circuit, state)) {
+    if (Runner::Run(qsimParam, FactoryT<FP>(m_numThreads), circuit, state)) {
       // PrintAmplitudes(circuit.num_qubits, stateSpace, state);
       if (qsimSimulateSamples) {
         // Generate bit strings
         xacc::info("Provided circuit has no intermediate measurements. "
                    "Sampling repeatedly from final state vector.");
-        const auto samples =
-            stateSpace.Sample(state, m_shots, m_qsimParam.seed);
-        for (const auto &sample : samples) {
-          std::string bitString;
-          for (const auto &bit : measureBitIdxs) {
-            const auto bit_mask = 1ULL << bit;
-            bitString.push_back((sample & bit_mask) == bit_mask ? '1' : '0');
-          }
-          buffer->appendMeasurement(bitString);
+        // Streaming sampler: counts per outcome, no per-shot samples.
+        std::mt19937_64 rng(qsimParam.seed);
+        const auto outcomes = StreamingSampler::sample(
+            uint64_t{1} << circuit.num_qubits,
+            [&](uint64_t k) {
+              return static_cast<double>(
+                  std::norm(stateSpace.GetAmpl(state, k)));
+            },
+            measureBitIdxs, m_shots, rng);
+        StreamingSampler::appendCounts(*buffer, outcomes,
+                                       measureBitIdxs.size());
+        if (!m_shotFilePrefix.empty()) {
+          const std::string shotFile =
+              m_shotFilePrefix + buffer->name() + ".shots";
+          ShotFileWriter::write(shotFile, outcomes, measureBitIdxs.size(),
+                                rng, m_shotFileChunkSize);
+          buffer->addExtraInfo("shot-file", shotFile);
         }
       } else {
         const double expectedValueZ =
-            computeExpValZ(m_qsimParam, m_numThreads, measureBitIdxs, stateSpace, state);
+            computeExpValZ<FP>(qsimParam, m_numThreads, measureBitIdxs, stateSpace, state);
         // Just add exp-val-z info
         buffer->addExtraInfo("exp-val-z", expectedValueZ);
       }
@@ -192,6 +277,10 @@ void QsimAccelerator::execute(
     // (measure gates in the middle, if statements, etc.)
     xacc::info("Provided circuit has intermediate measurements.");
     assert(m_shots > 0);
+    if (m_shotBranching) {
+      runShotBranching<FP>(buffer, compositeInstruction);
+      return;
+    }
     for (size_t i = 0; i < m_shots; ++i) {
       const std::string tempBufferName =
           buffer->name() + "__" + std::to_string(i);
@@ -202,7 +291,7 @@ void QsimAccelerator::execute(
       while (it.hasNext()) {
         auto nextInst = it.next();
         if (nextInst->isEnabled() && !nextInst->isComposite()) {
-          apply(temp_buffer, nextInst);
+          applyInstruction<FP>(temp_buffer, nextInst);
         }
         if (nextInst->name() == "ifstmt") {
           auto ifStmtCast = std::dynamic_pointer_cast<IfStmt>(nextInst);
@@ -217,15 +306,103 @@ void QsimAccelerator::execute(
   }
 }
 
+template <typename FP>
+void QsimAccelerator::runShotBranching(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> compositeInstruction) {
+  using StateSpace = typename QsimTypes<FP>::StateSpace;
+  using State = typename QsimTypes<FP>::State;
+  using Fuser = typename QsimTypes<FP>::Fuser;
+  using Engine = ShotBranching<State>;
+  const size_t nbQubits = buffer->size();
+  const auto qsimParam = getRunnerParameter<FP>();
+  StateSpace stateSpace(m_numThreads);
+  typename QsimTypes<FP>::Simulator sim(m_numThreads);
+  typename Engine::Backend backend;
+  backend.apply = [&](State &io_state, const std::vector<InstPtr> &in_gates) {
+    QsimCircuitVisitorT<FP> visitor(nbQubits);
+    // Controlled blocks (C-U) are handled by the visitor if possible (it then
+    // disables the block), otherwise their decomposition is applied.
+    std::function<void(const InstPtr &)> visitInst =
+        [&](const InstPtr &in_inst) {
+          in_inst->accept(&visitor);
+          if (in_inst->isComposite() && in_inst->isEnabled()) {
+            for (auto &subInst :
+                 xacc::ir::asComposite(in_inst)->getInstructions()) {
+              if (subInst->isEnabled()) {
+                visitInst(subInst);
+              }
+            }
+          }
+        };
+    for (auto &gate : in_gates) {
+      visitInst(gate);
+    }
+    auto circuit = visitor.getQsimCircuit();
+    auto fused_circuit =
+        Fuser::FuseGates(qsimParam, circuit.num_qubits, circuit.gates);
+    for (const auto &fused_gate : fused_circuit) {
+      qsim::ApplyFusedGate(sim, fused_gate, io_state);
+    }
+  };
+  backend.probabilityOne = [&](State &in_state, size_t in_qubit) {
+    return 0.5 * (1.0 - computeExpValZ<FP>(qsimParam, m_numThreads, {in_qubit},
+                                           stateSpace, in_state));
+  };
+  backend.collapse = [&](State &io_state, size_t in_qubit, bool in_result) {
+    typename StateSpace::MeasurementResult result;
+    result.mask = 1ULL << in_qubit;
+    result.bits = in_result ? result.mask : 0;
+    result.valid = true;
+    stateSpace.Collapse(result, io_state);
+  };
+  backend.flip = [&](State &io_state, size_t in_qubit) {
+    qsim::ApplyGate(sim, qsim::GateX<FP>::Create(0, in_qubit), io_state);
+  };
+  backend.copy = [&](const State &in_state) {
+    State copied = stateSpace.Create(in_state.num_qubits());
+    stateSpace.Copy(in_state, copied);
+    return copied;
+  };
+  backend.isSameState = [&](const State &in_state1, const State &in_state2) {
+    // Tolerance depends on the precision of the amplitudes
+    constexpr double tol = std::is_same_v<FP, float> ? 1e-6 : 1e-12;
+    return std::norm(stateSpace.InnerProduct(in_state1, in_state2)) >
+           1.0 - tol;
+  };
+  backend.sample = [&](State &in_state, const std::vector<size_t> &in_qubits,
+                       int in_shots, std::mt19937_64 &io_rng) {
+    return StreamingSampler::sample(
+        uint64_t{1} << in_state.num_qubits(),
+        [&](uint64_t k) {
+          return static_cast<double>(std::norm(stateSpace.GetAmpl(in_state, k)));
+        },
+        in_qubits, in_shots, io_rng);
+  };
+
+  State initialState = stateSpace.Create(nbQubits);
+  stateSpace.SetStateZero(initialState);
+  std::mt19937_64 rng(qsimParam.seed);
+  Engine engine(backend, m_branchBudget);
+  engine.run(compositeInstruction, buffer->name(), std::move(initialState),
+             m_shots, rng, [&](const typename Engine::Branch &in_branch) {
+               // Same bit string as a shot-by-shot simulation.
+               AcceleratorBuffer shotBuffer(buffer->name(), nbQubits);
+               in_branch.replay(shotBuffer);
+               buffer->appendMeasurement(
+                   shotBuffer.single_measurements_to_bitstring(),
+                   in_branch.shots);
+             });
+  xacc::info("Shot branching: " + std::to_string(engine.nbSplits()) +
+             " splits, max. " + std::to_string(engine.peakBranches()) +
+             " branches.");
+}
+
 void QsimAccelerator::execute(
     std::shared_ptr<AcceleratorBuffer> buffer,
     const std::vector<std::shared_ptr<CompositeInstruction>>
         compositeInstructions) {
-  // The time to do observed circuit analysis is not optimal for a large number
-  // of circuits so just run it one by one.
-  constexpr int MAX_NUMBER_CIRCUITS_TO_ANALYZE = 100;
-  if (!m_vqeMode || compositeInstructions.size() <= 1 ||
-      compositeInstructions.size() > MAX_NUMBER_CIRCUITS_TO_ANALYZE) {
+  if (!m_vqeMode || compositeInstructions.size() <= 1) {
     // Cannot run VQE mode, just run each composite independently.
     for (auto &f : compositeInstructions) {
       auto tmpBuffer =
@@ -235,94 +412,102 @@ void QsimAccelerator::execute(
     }
   } else {
     xacc::info("Running VQE mode");
-    auto kernelDecomposed =
-        ObservedAnsatz::fromObservedComposites(compositeInstructions);
-    // Always validate kernel decomposition in DEBUG
-    assert(kernelDecomposed.validate(compositeInstructions));
-    QsimCircuitVisitor visitor(buffer->size());
-    // Base kernel:
-    auto baseKernel = kernelDecomposed.getBase();
-    // Basis-change + measures
-    auto obsCircuits = kernelDecomposed.getObservedSubCircuits();
-    // Walk the base IR tree, and visit each node
-    InstructionIterator it(baseKernel);
-    while (it.hasNext()) {
-      auto nextInst = it.next();
-      if (nextInst->isEnabled() && !nextInst->isComposite()) {
-        nextInst->accept(&visitor);
-      }
-    }
-
-    // Run the base circuit:
-    auto circuit = visitor.getQsimCircuit();
-    StateSpace stateSpace(m_numThreads);
-    State state = stateSpace.Create(circuit.num_qubits);
-    stateSpace.SetStateZero(state);
-
-    const bool runOk = Runner::Run(m_qsimParam, Factory(m_numThreads), circuit, state);
-    assert(runOk);
-
-    // Now we have a wavefunction that represents execution of the ansatz.
-    // Run the observable sub-circuits (change of basis + measurements)
-    for (int i = 0; i < obsCircuits.size(); ++i) {
-      auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(
-          obsCircuits[i]->name(), buffer->size());
-      const double e = getExpectationValueZ(obsCircuits[i], stateSpace, state);
-      tmpBuffer->addExtraInfo("exp-val-z", e);
-      buffer->appendChild(obsCircuits[i]->name(), tmpBuffer);
+    if (m_doublePrecision) {
+      executeObserved<double>(buffer, compositeInstructions);
+    } else {
+      executeObserved<float>(buffer, compositeInstructions);
     }
   }
 }
 
-double QsimAccelerator::getExpectationValueZ(
-    std::shared_ptr<CompositeInstruction> compositeInstruction,
-    const StateSpace &stateSpace, const State &state) const {
-  // Construct Qsim circuit:
-  QsimCircuitVisitor visitor(state.num_qubits());
-  std::vector<size_t> measureBitIdxs;
-  // Walk the IR tree, and visit each node
-  InstructionIterator it(compositeInstruction);
-  while (it.hasNext()) {
-    auto nextInst = it.next();
-    if (nextInst->isEnabled()) {
-      if (!isMeasureGate(nextInst)) {
-        nextInst->accept(&visitor);
-      } else {
-        // Just collect the indices of measured qubit
-        measureBitIdxs.emplace_back(nextInst->bits()[0]);
-      }
+template <typename FP>
+void QsimAccelerator::executeObserved(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>>
+        compositeInstructions) {
+  using StateSpace = typename QsimTypes<FP>::StateSpace;
+  using State = typename QsimTypes<FP>::State;
+  using Fuser = typename QsimTypes<FP>::Fuser;
+  // Any prefix shared by the circuits (ansatz, gradient shifts, etc.) is
+  // simulated once.
+  const PrefixTrie trie(compositeInstructions);
+  const size_t nbQubits = buffer->size();
+  const auto qsimParam = getRunnerParameter<FP>();
+  StateSpace stateSpace(m_numThreads);
+  typename QsimTypes<FP>::Simulator sim(m_numThreads);
+  PrefixTrie::Backend<State> backend;
+  backend.init = [&]() {
+    State state = stateSpace.Create(nbQubits);
+    stateSpace.SetStateZero(state);
+    return state;
+  };
+  backend.apply = [&](State &io_state, const std::vector<InstPtr> &in_gates) {
+    QsimCircuitVisitorT<FP> visitor(nbQubits);
+    for (auto &gate : in_gates) {
+      gate->accept(&visitor);
     }
-  }
-
-  auto circuit = visitor.getQsimCircuit();
-  if (!circuit.gates.empty()) {
-    auto scratch = stateSpace.Create(state.num_qubits());
-    // copy from src to scratch.
-    const bool copyOk = stateSpace.Copy(state, scratch);
-    assert(copyOk);
+    auto circuit = visitor.getQsimCircuit();
     auto fused_circuit =
-        Fuser::FuseGates(m_qsimParam, circuit.num_qubits, circuit.gates);
-    xacc::quantum::QsimAccelerator::Simulator sim(m_numThreads);
+        Fuser::FuseGates(qsimParam, circuit.num_qubits, circuit.gates);
     for (const auto &fused_gate : fused_circuit) {
-      qsim::ApplyFusedGate(sim, fused_gate, scratch);
+      qsim::ApplyFusedGate(sim, fused_gate, io_state);
     }
-    return computeExpValZ(m_qsimParam, m_numThreads, measureBitIdxs, stateSpace, scratch);
-  } else {
-    return computeExpValZ(m_qsimParam, m_numThreads, measureBitIdxs, stateSpace, state);
+  };
+  backend.copy = [&](const State &in_state) {
+    State copied = stateSpace.Create(in_state.num_qubits());
+    stateSpace.Copy(in_state, copied);
+    return copied;
+  };
+
+  std::vector<double> expectationValues(compositeInstructions.size(), 0.0);
+  const auto budget = PrefixTrie::checkpointBudget(
+      m_checkpointMemoryMb, (1ULL << nbQubits) * sizeof(std::complex<FP>));
+  const auto stats = trie.run<State>(
+      backend, budget, [&](size_t in_circuitIdx, const State &in_state) {
+        expectationValues[in_circuitIdx] =
+            computeExpValZ<FP>(qsimParam, m_numThreads,
+                               trie.measuredBits(in_circuitIdx), stateSpace,
+                               in_state);
+      });
+  xacc::info("Prefix sharing: " + std::to_string(stats.nbAppliedGates) +
+             " gates applied (" + std::to_string(trie.nbGates()) +
+             " in the batch), " + std::to_string(stats.nbCheckpoints) +
+             " checkpoints, " + std::to_string(stats.nbRecomputes) +
+             " recomputed.");
+
+  for (int i = 0; i < compositeInstructions.size(); ++i) {
+    auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(
+        compositeInstructions[i]->name(), buffer->size());
+    tmpBuffer->addExtraInfo("exp-val-z", expectationValues[i]);
+    buffer->appendChild(compositeInstructions[i]->name(), tmpBuffer);
   }
 }
 
 // Sync. (FTQC) gate application.
 void QsimAccelerator::apply(std::shared_ptr<AcceleratorBuffer> buffer,
                             std::shared_ptr<Instruction> inst) {
+  if (m_doublePrecision) {
+    applyInstruction<double>(buffer, inst);
+  } else {
+    applyInstruction<float>(buffer, inst);
+  }
+}
+
+template <typename FP>
+void QsimAccelerator::applyInstruction(std::shared_ptr<AcceleratorBuffer> buffer,
+                                       std::shared_ptr<Instruction> inst) {
+  using StateSpace = typename QsimTypes<FP>::StateSpace;
+  using State = typename QsimTypes<FP>::State;
+  using Runner = typename QsimTypes<FP>::Runner;
+  // Note: one simulation state per precision.
   static std::shared_ptr<AcceleratorBuffer> current_buffer;
-  static std::unique_ptr<QsimCircuitVisitor> visitor;
+  static std::unique_ptr<QsimCircuitVisitorT<FP>> visitor;
   static StateSpace stateSpace(m_numThreads);
   static std::optional<State> current_state;
   xacc::info("Apply: " + inst->toString());
   if (!current_buffer || (current_buffer->name() != buffer->name())) {
     current_buffer = buffer;
-    visitor = std::make_unique<QsimCircuitVisitor>(buffer->size());
+    visitor = std::make_unique<QsimCircuitVisitorT<FP>>(buffer->size());
     current_state = stateSpace.Create(buffer->size());
     stateSpace.SetStateZero(*current_state);
   }
@@ -335,12 +520,13 @@ void QsimAccelerator::apply(std::shared_ptr<AcceleratorBuffer> buffer,
     // copy from src to scratch.
     const bool copyOk = stateSpace.Copy(*current_state, scratch);
     assert(copyOk);
-    std::vector<StateSpace::MeasurementResult> meas_results;
+    std::vector<typename StateSpace::MeasurementResult> meas_results;
     // std::cout << "Before: \n";
     // PrintAmplitudes(scratch.num_qubits(), stateSpace, scratch);
     m_qsimParam.seed = time(NULL);
-    const bool runOk =
-        Runner::Run(m_qsimParam, Factory(m_numThreads), qsimCirc, scratch, meas_results);
+    const bool runOk = Runner::Run(getRunnerParameter<FP>(),
+                                   FactoryT<FP>(m_numThreads), qsimCirc,
+                                   scratch, meas_results);
     assert(runOk);
     if (meas_results.size() == 1 && meas_results[0].bitstring.size() == 1) {
       const auto bitResult = meas_results[0].bitstring[0];
@@ -357,7 +543,7 @@ void QsimAccelerator::apply(std::shared_ptr<AcceleratorBuffer> buffer,
     stateSpace.Copy(scratch, *current_state);
 
     // Make new visitor, i.e. clear the circuit.
-    visitor = std::make_unique<QsimCircuitVisitor>(buffer->size());
+    visitor = std::make_unique<QsimCircuitVisitorT<FP>>(buffer->size());
   }
 }
 } // namespace quantum
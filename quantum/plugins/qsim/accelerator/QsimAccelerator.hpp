@@ -33,16 +33,19 @@
 #include "fuser_basic.h"
 #include "run_qsim.h"
 #include "simmux.h"
+#include "simulator_basic.h"
 #include "io_file.h"
 #include "fuser_mqubit.h"
 
 namespace xacc {
 namespace quantum {
-class QsimCircuitVisitor : public AllGateVisitor, public InstructionVisitor<Circuit> {
+// Gate precision: FP = float (default) or double
+template <typename FP>
+class QsimCircuitVisitorT : public AllGateVisitor, public InstructionVisitor<Circuit> {
 public:
-  using fp_type = float;
+  using fp_type = FP;
 
-  QsimCircuitVisitor(size_t nbQubits) {
+  QsimCircuitVisitorT(size_t nbQubits) {
     m_circuit.num_qubits = nbQubits;
     m_circuit.gates.clear();
     m_time = 0;
@@ -258,7 +261,7 @@ public:
     return m_circuit;
   }
 
-  ~QsimCircuitVisitor() {
+  ~QsimCircuitVisitorT() {
     for (auto &block : m_controlledBlocks) {
       // We temporarily disabled these blocks while handling the simulation,
       // now reset the status.
@@ -273,11 +276,24 @@ private:
   std::vector<std::reference_wrapper<xacc::quantum::Circuit>> m_controlledBlocks;
 };
 
-struct Factory {
-  Factory(unsigned num_threads) : num_threads(num_threads) {}
+using QsimCircuitVisitor = QsimCircuitVisitorT<float>;
 
-  using Simulator = qsim::Simulator<qsim::For>;
-  using StateSpace = Simulator::StateSpace;
+// The vectorized (AVX/SSE) simulators selected by simmux.h are
+// single-precision only: double precision uses the basic simulator.
+template <typename FP> struct QsimSimulatorType;
+template <> struct QsimSimulatorType<float> {
+  using type = qsim::Simulator<qsim::For>;
+};
+template <> struct QsimSimulatorType<double> {
+  using type = qsim::SimulatorBasic<qsim::For, double>;
+};
+
+template <typename FP>
+struct FactoryT {
+  FactoryT(unsigned num_threads) : num_threads(num_threads) {}
+
+  using Simulator = typename QsimSimulatorType<FP>::type;
+  using StateSpace = typename Simulator::StateSpace;
 
   StateSpace CreateStateSpace() const { return StateSpace(num_threads); }
 
@@ -285,15 +301,26 @@ struct Factory {
 
   unsigned num_threads;
 };
+using Factory = FactoryT<float>;
+
+// Qsim types for a given precision
+template <typename FP>
+struct QsimTypes {
+  using Simulator = typename FactoryT<FP>::Simulator;
+  using StateSpace = typename Simulator::StateSpace;
+  using State = typename StateSpace::State;
+  using Fuser = qsim::MultiQubitGateFuser<qsim::IO, qsim::GateQSim<FP>>;
+  using Runner = qsim::QSimRunner<qsim::IO, Fuser, FactoryT<FP>>;
+};
 
 class QsimAccelerator : public Accelerator {
 public:
-  // Qsim type:
-  using Simulator = qsim::Simulator<qsim::For>;
-  using StateSpace = Simulator::StateSpace;
-  using State = StateSpace::State;
-  using Fuser = qsim::MultiQubitGateFuser<qsim::IO, qsim::GateQSim<float>>;
-  using Runner = qsim::QSimRunner<qsim::IO, Fuser, Factory>;
+  // Qsim type (default, single precision):
+  using Simulator = QsimTypes<float>::Simulator;
+  using StateSpace = QsimTypes<float>::StateSpace;
+  using State = QsimTypes<float>::State;
+  using Fuser = QsimTypes<float>::Fuser;
+  using Runner = QsimTypes<float>::Runner;
 
   // Identifiable interface impls
   virtual const std::string name() const override { return "qsim"; }
@@ -311,7 +338,9 @@ public:
   }
   virtual BitOrder getBitOrder() override { return BitOrder::LSB; }
   virtual HeterogeneousMap getProperties() override {
-    return {{"shots", m_shots}};
+    return {{"shots", m_shots},
+            {"vqe-mode", m_vqeMode},
+            {"precision", std::string(m_doublePrecision ? "fp64" : "fp32")}};
   }
   virtual void execute(std::shared_ptr<AcceleratorBuffer> buffer,
                        const std::shared_ptr<CompositeInstruction>
@@ -323,13 +352,43 @@ public:
                      std::shared_ptr<Instruction> inst) override;
 
 private:
-  double getExpectationValueZ(
-      std::shared_ptr<CompositeInstruction> compositeInstruction,
-      const StateSpace &stateSpace, const State &state) const;
+  void setCheckpointMemory(const HeterogeneousMap &params);
+  // Implementations for both precisions ("precision" option)
+  template <typename FP>
+  void executeCircuit(
+      std::shared_ptr<AcceleratorBuffer> buffer,
+      const std::shared_ptr<CompositeInstruction> compositeInstruction);
+  template <typename FP>
+  void executeObserved(std::shared_ptr<AcceleratorBuffer> buffer,
+                       const std::vector<std::shared_ptr<CompositeInstruction>>
+                           compositeInstructions);
+  template <typename FP>
+  void applyInstruction(std::shared_ptr<AcceleratorBuffer> buffer,
+                        std::shared_ptr<Instruction> inst);
+  // Run shots of a dynamic circuit (mid-circuit measure/reset, if statements)
+  template <typename FP>
+  void runShotBranching(
+      std::shared_ptr<AcceleratorBuffer> buffer,
+      const std::shared_ptr<CompositeInstruction> compositeInstruction);
+  // Runner parameters (seed, etc.) for the given precision
+  template <typename FP>
+  typename QsimTypes<FP>::Runner::Parameter getRunnerParameter() const;
   Runner::Parameter m_qsimParam;
+  // Double-precision state vector ("precision" = "fp64")
+  bool m_doublePrecision;
   int m_shots;
   bool m_vqeMode;
   int m_numThreads;
+  // Shot-branching simulation of dynamic circuits
+  bool m_shotBranching;
+  int m_branchBudget;
+  // Optional per-shot output of the sampled shots (chunked binary file):
+  // '<prefix><buffer name>.shots' for each sampled circuit.
+  std::string m_shotFilePrefix;
+  int m_shotFileChunkSize;
+  // Memory budget (MB) of the state checkpoints of the prefix-sharing
+  // execution of observed circuits (VQE mode).
+  int m_checkpointMemoryMb;
 };
 } // namespace quantum
 } // namespace xacc
@@ -17,7 +17,12 @@
 #include "Algorithm.hpp"
 #include "xacc_observable.hpp"
 #include <random>
+#include <chrono>
 #include "CommonGates.hpp"
+#include "InstructionIterator.hpp"
+#include "PrecisionBenchmark.hpp"
+
+using namespace xacc::quantum::test;
 
 namespace {
 template <typename T> std::vector<T> linspace(T a, T b, size_t N) {
@@ -387,9 +392,118 @@ TEST(QsimAcceleratorTester, checkRandomSeed) {
   auto buffer = xacc::qalloc(2);
   accelerator->execute(buffer, program);
   buffer->print();
+  EXPECT_EQ(buffer->getMeasurementCounts()["00"] +
+                buffer->getMeasurementCounts()["11"],
+            8192);
   // The result will be deterministic since we seed the simulator
-  EXPECT_EQ(buffer->getMeasurementCounts()["00"], 4059);
-  EXPECT_EQ(buffer->getMeasurementCounts()["11"], 4133);
+  auto buffer2 = xacc::qalloc(2);
+  xacc::getAccelerator("qsim", {{"shots", 8192}, {"seed", 123}})
+      ->execute(buffer2, program);
+  EXPECT_EQ(buffer->getMeasurementCounts(), buffer2->getMeasurementCounts());
+}
+
+TEST(QsimAcceleratorTester, checkPrecision) {
+  auto circuit = randomLayeredCircuit(8, 10, 42);
+  const auto [expValFp64, timeFp64] =
+      runWithPrecision("qsim", "fp64", circuit, 8);
+  const auto [expValFp32, timeFp32] =
+      runWithPrecision("qsim", "fp32", circuit, 8);
+  EXPECT_NEAR(expValFp32, expValFp64, 1e-4);
+
+  // Sampling from a single-precision state vector
+  auto accelerator =
+      xacc::getAccelerator("qsim", {{"precision", "fp32"}, {"shots", 1024}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void bell_fp32(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                                  accelerator);
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, ir->getComposite("bell_fp32"));
+  EXPECT_EQ(buffer->getMeasurementCounts().size(), 2);
+  EXPECT_EQ(buffer->getMeasurementCounts()["00"] +
+                buffer->getMeasurementCounts()["11"],
+            1024);
+
+  // Restore default settings
+  xacc::getAccelerator("qsim", {{"precision", "fp32"}});
+}
+
+// Error vs. speed of single precision: not a pass/fail test, the timings are
+// printed for reference. Run with --gtest_also_run_disabled_tests.
+TEST(QsimAcceleratorTester, DISABLED_benchmarkPrecision) {
+  EXPECT_LT(benchmarkPrecision("qsim"), 1e-3);
+  xacc::getAccelerator("qsim", {{"precision", "fp32"}});
+}
+
+TEST(QsimAcceleratorTester, checkPrefixSharing) {
+  auto H = xacc::quantum::getObservable(
+      "pauli", std::string("5.907 - 2.1433 X0X1 - 2.1433 Y0Y1 + .21829 Z0 - "
+                           "6.125 Z1 + 0.5 X0Z1"));
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit prefix_sharing_ansatz
+        .parameters t0, t1
+        .qbit q
+        X(q[0]);
+        Ry(q[1], t0);
+        CNOT(q[1],q[0]);
+        Ry(q[0], t1);
+        CNOT(q[0],q[1]);
+    )");
+  auto ansatz = xacc::getCompiled("prefix_sharing_ansatz");
+
+  // Energy and parameter-shift gradient circuits: the observed circuits of
+  // each parameter set share the ansatz, and the shifted ansatzes share the
+  // gates before the shifted angle.
+  const std::vector<double> x{0.3, -0.7};
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> batch;
+  const auto addObserved = [&](const std::vector<double> &in_params) {
+    for (auto &circuit : H->observe(ansatz->operator()(in_params))) {
+      xacc::InstructionIterator it(circuit);
+      bool hasMeasure = false;
+      while (it.hasNext()) {
+        hasMeasure = hasMeasure || (it.next()->name() == "Measure");
+      }
+      // Skip the identity term
+      if (hasMeasure) {
+        batch.emplace_back(circuit);
+      }
+    }
+  };
+  addObserved(x);
+  for (int i = 0; i < x.size(); ++i) {
+    for (const double shift : {M_PI_2, -M_PI_2}) {
+      auto shifted = x;
+      shifted[i] += shift;
+      addObserved(shifted);
+    }
+  }
+
+  const auto runBatch = [&](const xacc::HeterogeneousMap &in_config) {
+    auto accelerator = xacc::getAccelerator("qsim", in_config);
+    auto buffer = xacc::qalloc(2);
+    accelerator->execute(buffer, batch);
+    std::vector<double> result;
+    for (auto &child : buffer->getChildren()) {
+      result.emplace_back(child->getExpectationValueZ());
+    }
+    return result;
+  };
+  // Reference: independent simulations
+  const auto expected = runBatch({{"vqe-mode", false}});
+  EXPECT_EQ(expected.size(), batch.size());
+  // With checkpoints, and replaying the branch states (no checkpoint memory)
+  for (const int memory : {1024, 0}) {
+    const auto actual = runBatch({{"vqe-mode", true}, {"checkpoint-memory", memory}});
+    EXPECT_EQ(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); ++i) {
+      EXPECT_NEAR(actual[i], expected[i], 1e-5);
+    }
+  }
 }
 
 int main(int argc, char **argv) {
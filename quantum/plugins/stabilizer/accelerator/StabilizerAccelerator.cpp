@@ -0,0 +1,463 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "StabilizerAccelerator.hpp"
+#include "xacc_plugin.hpp"
+#include "InstructionIterator.hpp"
+#include "ThreadPool.hpp"
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+using namespace xacc::quantum::stabilizer;
+// Shots per Pauli-frame batch = 64 * BATCH_WORDS
+constexpr std::size_t BATCH_WORDS = 16;
+
+bool requiresShotByShotSimulation(
+    const std::shared_ptr<xacc::CompositeInstruction> &in_composite) {
+  xacc::InstructionIterator it(in_composite);
+  while (it.hasNext()) {
+    auto inst = it.next();
+    if (inst->name() == "ifstmt") {
+      return true;
+    }
+    if (inst->name() == "Measure") {
+      auto measure = std::dynamic_pointer_cast<xacc::quantum::Measure>(inst);
+      if (measure && measure->hasClassicalRegAssignment()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+} // namespace
+
+namespace xacc {
+namespace quantum {
+void StabilizerVisitor::add(stabilizer::OpType type, std::size_t q1,
+                            std::size_t q2) {
+  m_ops.push_back({type, static_cast<std::uint32_t>(q1),
+                   static_cast<std::uint32_t>(q2)});
+}
+
+int StabilizerVisitor::quarterTurns(double angle,
+                                    const std::string &gateName) const {
+  const double k = angle / M_PI_2;
+  const double rounded = std::round(k);
+  if (std::abs(k - rounded) > 1e-9) {
+    nonClifford(gateName + "(" + std::to_string(angle) + ")");
+  }
+  return ((static_cast<long long>(rounded) % 4) + 4) % 4;
+}
+
+void StabilizerVisitor::nonClifford(const std::string &gateName) const {
+  xacc::error("Stabilizer simulator: " + gateName +
+              " is not a Clifford gate.");
+}
+
+void StabilizerVisitor::rz(std::size_t q, int k) {
+  // Rz(k * pi/2) = S^k (up to a global phase)
+  if (k == 1) {
+    add(stabilizer::OpType::S, q);
+  } else if (k == 2) {
+    add(stabilizer::OpType::Z, q);
+  } else if (k == 3) {
+    add(stabilizer::OpType::Sdg, q);
+  }
+}
+
+void StabilizerVisitor::rx(std::size_t q, int k) {
+  if (k != 0) {
+    add(stabilizer::OpType::H, q);
+    rz(q, k);
+    add(stabilizer::OpType::H, q);
+  }
+}
+
+void StabilizerVisitor::ry(std::size_t q, int k) {
+  // Ry(pi/2) = H * Z
+  for (int i = 0; i < k; ++i) {
+    add(stabilizer::OpType::Z, q);
+    add(stabilizer::OpType::H, q);
+  }
+}
+
+void StabilizerVisitor::visit(Hadamard &h) {
+  add(stabilizer::OpType::H, h.bits()[0]);
+}
+
+void StabilizerVisitor::visit(CNOT &cnot) {
+  add(stabilizer::OpType::CX, cnot.bits()[0], cnot.bits()[1]);
+}
+
+void StabilizerVisitor::visit(Rz &rz) {
+  this->rz(rz.bits()[0],
+           quarterTurns(InstructionParameterToDouble(rz.getParameter(0)),
+                        rz.name()));
+}
+
+void StabilizerVisitor::visit(Ry &ry) {
+  this->ry(ry.bits()[0],
+           quarterTurns(InstructionParameterToDouble(ry.getParameter(0)),
+                        ry.name()));
+}
+
+void StabilizerVisitor::visit(Rx &rx) {
+  this->rx(rx.bits()[0],
+           quarterTurns(InstructionParameterToDouble(rx.getParameter(0)),
+                        rx.name()));
+}
+
+void StabilizerVisitor::visit(X &x) { add(stabilizer::OpType::X, x.bits()[0]); }
+
+void StabilizerVisitor::visit(Y &y) { add(stabilizer::OpType::Y, y.bits()[0]); }
+
+void StabilizerVisitor::visit(Z &z) { add(stabilizer::OpType::Z, z.bits()[0]); }
+
+void StabilizerVisitor::visit(CY &cy) {
+  add(stabilizer::OpType::Sdg, cy.bits()[1]);
+  add(stabilizer::OpType::CX, cy.bits()[0], cy.bits()[1]);
+  add(stabilizer::OpType::S, cy.bits()[1]);
+}
+
+void StabilizerVisitor::visit(CZ &cz) {
+  add(stabilizer::OpType::CZ, cz.bits()[0], cz.bits()[1]);
+}
+
+void StabilizerVisitor::visit(Swap &s) {
+  add(stabilizer::OpType::Swap, s.bits()[0], s.bits()[1]);
+}
+
+void StabilizerVisitor::visit(CRZ &crz) {
+  // CRZ(pi) = Sdg(ctrl) * CZ
+  const int k = quarterTurns(
+      InstructionParameterToDouble(crz.getParameter(0)) / 2.0, crz.name());
+  for (int i = 0; i < k; ++i) {
+    add(stabilizer::OpType::CZ, crz.bits()[0], crz.bits()[1]);
+    add(stabilizer::OpType::Sdg, crz.bits()[0]);
+  }
+}
+
+void StabilizerVisitor::visit(CH &ch) { nonClifford(ch.name()); }
+
+void StabilizerVisitor::visit(S &s) { add(stabilizer::OpType::S, s.bits()[0]); }
+
+void StabilizerVisitor::visit(Sdg &sdg) {
+  add(stabilizer::OpType::Sdg, sdg.bits()[0]);
+}
+
+void StabilizerVisitor::visit(T &t) { nonClifford(t.name()); }
+
+void StabilizerVisitor::visit(Tdg &tdg) { nonClifford(tdg.name()); }
+
+void StabilizerVisitor::visit(CPhase &cphase) {
+  // CPhase(pi) = CZ
+  const int k = quarterTurns(
+      InstructionParameterToDouble(cphase.getParameter(0)) / 2.0,
+      cphase.name());
+  if (k % 2 == 1) {
+    add(stabilizer::OpType::CZ, cphase.bits()[0], cphase.bits()[1]);
+  }
+}
+
+void StabilizerVisitor::visit(Measure &measure) {
+  add(stabilizer::OpType::Measure, measure.bits()[0]);
+}
+
+void StabilizerVisitor::visit(U &u) {
+  // U(theta, phi, lambda) = Rz(phi) Ry(theta) Rz(lambda)
+  const auto theta = InstructionParameterToDouble(u.getParameter(0));
+  const auto phi = InstructionParameterToDouble(u.getParameter(1));
+  const auto lambda = InstructionParameterToDouble(u.getParameter(2));
+  rz(u.bits()[0], quarterTurns(lambda, u.name()));
+  ry(u.bits()[0], quarterTurns(theta, u.name()));
+  rz(u.bits()[0], quarterTurns(phi, u.name()));
+}
+
+void StabilizerVisitor::visit(iSwap &in_iSwapGate) {
+  // iSwap = Swap * CZ * (S x S)
+  const auto q1 = in_iSwapGate.bits()[0];
+  const auto q2 = in_iSwapGate.bits()[1];
+  add(stabilizer::OpType::S, q1);
+  add(stabilizer::OpType::S, q2);
+  add(stabilizer::OpType::CZ, q1, q2);
+  add(stabilizer::OpType::Swap, q1, q2);
+}
+
+void StabilizerVisitor::visit(fSim &in_fsimGate) {
+  nonClifford(in_fsimGate.name());
+}
+
+void StabilizerVisitor::visit(XY &xy) { nonClifford(xy.name()); }
+
+void StabilizerVisitor::visit(RZZ &rzz) {
+  const int k = quarterTurns(InstructionParameterToDouble(rzz.getParameter(0)),
+                             rzz.name());
+  if (k != 0) {
+    add(stabilizer::OpType::CX, rzz.bits()[0], rzz.bits()[1]);
+    rz(rzz.bits()[1], k);
+    add(stabilizer::OpType::CX, rzz.bits()[0], rzz.bits()[1]);
+  }
+}
+
+void StabilizerVisitor::visit(Reset &in_resetGate) {
+  add(stabilizer::OpType::Reset, in_resetGate.bits()[0]);
+}
+
+void StabilizerAccelerator::initialize(const HeterogeneousMap &params) {
+  m_shots = -1;
+  m_threads = 0;
+  m_seed = std::random_device()();
+  updateConfiguration(params);
+}
+
+void StabilizerAccelerator::updateConfiguration(
+    const HeterogeneousMap &params) {
+  if (params.keyExists<int>("shots")) {
+    m_shots = params.get<int>("shots");
+    if (m_shots < 1) {
+      xacc::error("Invalid 'shots' parameter.");
+    }
+  }
+  if (params.keyExists<int>("seed")) {
+    m_seed = params.get<int>("seed");
+  }
+  if (params.keyExists<int>("threads")) {
+    m_threads = params.get<int>("threads");
+  }
+  m_rng.seed(m_seed);
+}
+
+void StabilizerAccelerator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> compositeInstruction) {
+  if (requiresShotByShotSimulation(compositeInstruction)) {
+    runShots(buffer, compositeInstruction);
+    return;
+  }
+
+  // Lower the circuit to primitive Clifford ops.
+  auto visitor = std::make_shared<StabilizerVisitor>();
+  InstructionIterator it(compositeInstruction);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (nextInst->isEnabled() && !nextInst->isComposite()) {
+      for (const auto &bit : nextInst->bits()) {
+        if (bit >= buffer->size()) {
+          xacc::error("Stabilizer simulator: qubit index " +
+                      std::to_string(bit) + " is out of range (buffer size " +
+                      std::to_string(buffer->size()) + ").");
+        }
+      }
+      nextInst->accept(visitor);
+    }
+  }
+  const auto &ops = visitor->getOps();
+
+  // Reference sample: random outcomes are fixed to 0.
+  stabilizer::Tableau tableau(buffer->size());
+  std::vector<bool> reference;
+  for (const auto &op : ops) {
+    const bool result = tableau.apply(op, false);
+    if (op.type == stabilizer::OpType::Measure) {
+      reference.emplace_back(result);
+    }
+  }
+
+  if (reference.empty()) {
+    return;
+  }
+
+  if (m_shots < 1) {
+    computeExpectationValueZ(buffer, ops, reference);
+  } else {
+    sample(buffer, ops, reference);
+  }
+}
+
+void StabilizerAccelerator::computeExpectationValueZ(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<stabilizer::Op> &ops,
+    const std::vector<bool> &reference) {
+  // The measured parity flip is a linear function of the frame randomness:
+  // it is either identically zero (deterministic parity) or uniformly random
+  // (zero expectation). A batch of 256 frames distinguishes the two cases
+  // with a failure probability of 2^-256.
+  constexpr std::size_t nWords = 4;
+  stabilizer::FrameSimulator frames(buffer->size(), nWords);
+  const auto &flips = frames.run(ops, reference.size(), m_rng);
+  bool refParity = false;
+  std::uint64_t parityFlips = 0;
+  for (std::size_t w = 0; w < nWords; ++w) {
+    std::uint64_t parity = 0;
+    for (std::size_t m = 0; m < reference.size(); ++m) {
+      parity ^= flips[m * nWords + w];
+    }
+    parityFlips |= parity;
+  }
+  for (const auto &bit : reference) {
+    refParity ^= bit;
+  }
+  const double expectedValueZ =
+      parityFlips != 0 ? 0.0 : (refParity ? -1.0 : 1.0);
+  buffer->addExtraInfo("exp-val-z", expectedValueZ);
+}
+
+void StabilizerAccelerator::sample(std::shared_ptr<AcceleratorBuffer> buffer,
+                                   const std::vector<stabilizer::Op> &ops,
+                                   const std::vector<bool> &reference) {
+  const std::size_t nQubits = buffer->size();
+  const std::size_t nMeas = reference.size();
+  const std::size_t nKeyWords = (nMeas + 63) / 64;
+  const std::size_t shotsPerBatch = 64 * BATCH_WORDS;
+  const std::size_t nShots = m_shots;
+  const std::size_t nBatches = (nShots + shotsPerBatch - 1) / shotsPerBatch;
+  const std::size_t nThreads =
+      m_threads > 0 ? m_threads
+                    : std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t nTasks = std::min(nBatches, nThreads);
+  const auto baseSeed = m_rng();
+
+  // Each task samples every nTasks-th batch and accumulates the counts of
+  // the packed outcomes (one bit per measurement).
+  using PackedCounts = std::unordered_map<std::string, int>;
+  const auto runTask = [&](std::size_t taskId) {
+    PackedCounts counts;
+    stabilizer::FrameSimulator frames(nQubits, BATCH_WORDS);
+    std::uint64_t block[64];
+    std::vector<std::uint64_t> keys(shotsPerBatch * nKeyWords);
+    for (std::size_t b = taskId; b < nBatches; b += nTasks) {
+      std::seed_seq seq{baseSeed, static_cast<std::uint64_t>(b)};
+      std::mt19937_64 rng(seq);
+      const auto &flips = frames.run(ops, nMeas, rng);
+      const std::size_t nShotsInBatch =
+          std::min(shotsPerBatch, nShots - b * shotsPerBatch);
+      // Transpose measurement-major flips into shot-major packed outcomes,
+      // 64 x 64 bits at a time.
+      for (std::size_t w = 0; w < BATCH_WORDS && 64 * w < nShotsInBatch;
+           ++w) {
+        for (std::size_t g = 0; g < nKeyWords; ++g) {
+          for (std::size_t i = 0; i < 64; ++i) {
+            const auto m = g * 64 + i;
+            block[i] = m < nMeas ? flips[m * BATCH_WORDS + w] ^
+                                       (reference[m] ? ~0ULL : 0ULL)
+                                 : 0ULL;
+          }
+          stabilizer::transpose64(block);
+          for (std::size_t l = 0; l < 64; ++l) {
+            keys[(w * 64 + l) * nKeyWords + g] = block[l];
+          }
+        }
+      }
+      for (std::size_t s = 0; s < nShotsInBatch; ++s) {
+        counts[std::string(reinterpret_cast<const char *>(&keys[s * nKeyWords]),
+                           nKeyWords * sizeof(std::uint64_t))]++;
+      }
+    }
+    return counts;
+  };
+
+  PackedCounts counts;
+  if (nTasks <= 1) {
+    counts = runTask(0);
+  } else {
+    xacc::ThreadPool pool(nTasks);
+    std::vector<std::future<PackedCounts>> futures;
+    for (std::size_t t = 0; t < nTasks; ++t) {
+      futures.emplace_back(pool.enqueue(runTask, t));
+    }
+    for (auto &f : futures) {
+      for (const auto &[key, count] : f.get()) {
+        counts[key] += count;
+      }
+    }
+  }
+
+  // Bit string: one bit per measurement, in program order (same as qpp).
+  std::vector<std::uint64_t> words(nKeyWords);
+  std::string bitString(nMeas, '0');
+  for (const auto &[key, count] : counts) {
+    std::memcpy(words.data(), key.data(), key.size());
+    for (std::size_t m = 0; m < nMeas; ++m) {
+      bitString[m] = ((words[m >> 6] >> (m & 63)) & 1ULL) ? '1' : '0';
+    }
+    buffer->appendMeasurement(bitString, count);
+  }
+}
+
+void StabilizerAccelerator::runShots(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::shared_ptr<CompositeInstruction> composite) {
+  auto visitor = std::make_shared<StabilizerVisitor>();
+  // No shots: run a single trajectory to compute the parity.
+  const int nShots = m_shots < 1 ? 1 : m_shots;
+  for (int shot = 0; shot < nShots; ++shot) {
+    stabilizer::Tableau tableau(buffer->size());
+    buffer->reset_single_measurements();
+    std::string bitString;
+    InstructionIterator it(composite);
+    while (it.hasNext()) {
+      auto nextInst = it.next();
+      if (!nextInst->isEnabled()) {
+        continue;
+      }
+      if (nextInst->isComposite()) {
+        if (nextInst->name() == "ifstmt") {
+          // Enable/disable the body based on the classical register value.
+          std::dynamic_pointer_cast<IfStmt>(nextInst)->expand({});
+        }
+        continue;
+      }
+      visitor->clear();
+      nextInst->accept(visitor);
+      for (const auto &op : visitor->getOps()) {
+        const bool randomBit = (op.type == stabilizer::OpType::Measure ||
+                                op.type == stabilizer::OpType::Reset) &&
+                               (m_rng() & 1ULL);
+        const bool result = tableau.apply(op, randomBit);
+        if (op.type == stabilizer::OpType::Measure) {
+          bitString.push_back(result ? '1' : '0');
+          auto measure = std::dynamic_pointer_cast<Measure>(nextInst);
+          if (measure && measure->hasClassicalRegAssignment()) {
+            buffer->measure(measure->getBufferNames()[1],
+                            measure->getClassicalBitIndex(), result);
+          } else {
+            buffer->measure(op.q1, result);
+          }
+        }
+      }
+    }
+
+    if (m_shots < 1) {
+      const auto nOnes = std::count(bitString.begin(), bitString.end(), '1');
+      buffer->addExtraInfo("exp-val-z", nOnes % 2 == 0 ? 1.0 : -1.0);
+    } else {
+      buffer->appendMeasurement(bitString);
+    }
+  }
+}
+
+void StabilizerAccelerator::execute(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>>
+        compositeInstructions) {
+  for (auto &f : compositeInstructions) {
+    auto tmpBuffer =
+        std::make_shared<xacc::AcceleratorBuffer>(f->name(), buffer->size());
+    execute(tmpBuffer, f);
+    buffer->appendChild(f->name(), tmpBuffer);
+  }
+}
+} // namespace quantum
+} // namespace xacc
+
+REGISTER_ACCELERATOR(xacc::quantum::StabilizerAccelerator)
@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include "xacc.hpp"
+#include "AllGateVisitor.hpp"
+#include "StabilizerTableau.hpp"
+
+namespace xacc {
+namespace quantum {
+// Lowers XACC gates to primitive Clifford ops.
+// Rotation gates are accepted if their angles are multiples of pi/2;
+// non-Clifford gates raise an error.
+class StabilizerVisitor : public AllGateVisitor {
+public:
+  void clear() { m_ops.clear(); }
+  const std::vector<stabilizer::Op> &getOps() const { return m_ops; }
+
+  void visit(Hadamard &h) override;
+  void visit(CNOT &cnot) override;
+  void visit(Rz &rz) override;
+  void visit(Ry &ry) override;
+  void visit(Rx &rx) override;
+  void visit(X &x) override;
+  void visit(Y &y) override;
+  void visit(Z &z) override;
+  void visit(CY &cy) override;
+  void visit(CZ &cz) override;
+  void visit(Swap &s) override;
+  void visit(CRZ &crz) override;
+  void visit(CH &ch) override;
+  void visit(S &s) override;
+  void visit(Sdg &sdg) override;
+  void visit(T &t) override;
+  void visit(Tdg &tdg) override;
+  void visit(CPhase &cphase) override;
+  void visit(Measure &measure) override;
+  void visit(Identity &i) override {}
+  void visit(U &u) override;
+  void visit(iSwap &in_iSwapGate) override;
+  void visit(fSim &in_fsimGate) override;
+  void visit(XY &xy) override;
+  void visit(RZZ &rzz) override;
+  void visit(Reset &in_resetGate) override;
+
+private:
+  void add(stabilizer::OpType type, std::size_t q1, std::size_t q2 = 0);
+  // Number of quarter turns (mod 4) of a Clifford rotation angle.
+  int quarterTurns(double angle, const std::string &gateName) const;
+  void rz(std::size_t q, int k);
+  void rx(std::size_t q, int k);
+  void ry(std::size_t q, int k);
+  void nonClifford(const std::string &gateName) const;
+
+  std::vector<stabilizer::Op> m_ops;
+};
+
+// Clifford circuit simulator based on a bit-packed stabilizer tableau.
+// Shots are sampled in bulk: a single reference sample is computed with the
+// tableau, then batches of 64 * k shots are generated by propagating Pauli
+// frames (word-parallel over the shots) through the circuit.
+// Distinct outcomes are accumulated as packed bitstrings and only converted
+// to the AcceleratorBuffer string representation once per unique outcome.
+// Options:
+// - "shots" (int): number of shots; if not set, only the exact
+//   expectation value of the measured Z-parity ("exp-val-z") is computed.
+// - "seed" (int): RNG seed.
+// - "threads" (int): number of threads for sampling
+//   (default: hardware concurrency).
+class StabilizerAccelerator : public Accelerator {
+public:
+  // Identifiable interface impls
+  const std::string name() const override { return "stabilizer"; }
+  const std::string description() const override {
+    return "XACC native stabilizer (Clifford tableau) simulator.";
+  }
+
+  // Accelerator interface impls
+  void initialize(const HeterogeneousMap &params = {}) override;
+  void updateConfiguration(const HeterogeneousMap &config) override;
+  const std::vector<std::string> configurationKeys() override {
+    return {"shots", "seed", "threads"};
+  }
+  HeterogeneousMap getProperties() override { return {{"shots", m_shots}}; }
+  BitOrder getBitOrder() override { return BitOrder::LSB; }
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::shared_ptr<CompositeInstruction>
+                   compositeInstruction) override;
+  void execute(std::shared_ptr<AcceleratorBuffer> buffer,
+               const std::vector<std::shared_ptr<CompositeInstruction>>
+                   compositeInstructions) override;
+
+private:
+  // Bulk sampling (no classical feed-forward)
+  void sample(std::shared_ptr<AcceleratorBuffer> buffer,
+              const std::vector<stabilizer::Op> &ops,
+              const std::vector<bool> &reference);
+  void computeExpectationValueZ(std::shared_ptr<AcceleratorBuffer> buffer,
+                                const std::vector<stabilizer::Op> &ops,
+                                const std::vector<bool> &reference);
+  // Shot-by-shot simulation (e.g., circuits with IfStmt)
+  void runShots(std::shared_ptr<AcceleratorBuffer> buffer,
+                const std::shared_ptr<CompositeInstruction> composite);
+
+  int m_shots = -1;
+  std::size_t m_seed = 0;
+  int m_threads = 0;
+  std::mt19937_64 m_rng;
+};
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,336 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "StabilizerTableau.hpp"
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+
+namespace {
+inline int popcount(std::uint64_t w) { return std::bitset<64>(w).count(); }
+} // namespace
+
+namespace xacc {
+namespace quantum {
+namespace stabilizer {
+Tableau::Tableau(std::size_t nQubits)
+    : m_nQubits(nQubits), m_nWords((nQubits + 63) / 64),
+      m_x((2 * nQubits + 1) * m_nWords, 0), m_z((2 * nQubits + 1) * m_nWords, 0),
+      m_r(2 * nQubits + 1, 0) {
+  // Destabilizers: X_i; Stabilizers: Z_i
+  for (std::size_t i = 0; i < m_nQubits; ++i) {
+    xRow(i)[i >> 6] |= 1ULL << (i & 63);
+    zRow(i + m_nQubits)[i >> 6] |= 1ULL << (i & 63);
+  }
+}
+
+void Tableau::h(std::size_t q) {
+  const auto w = q >> 6;
+  const auto mask = 1ULL << (q & 63);
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    auto &xw = m_x[row * m_nWords + w];
+    auto &zw = m_z[row * m_nWords + w];
+    const bool xb = xw & mask;
+    const bool zb = zw & mask;
+    m_r[row] ^= (xb & zb);
+    if (xb != zb) {
+      xw ^= mask;
+      zw ^= mask;
+    }
+  }
+}
+
+void Tableau::s(std::size_t q) {
+  const auto w = q >> 6;
+  const auto mask = 1ULL << (q & 63);
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    const auto xw = m_x[row * m_nWords + w];
+    auto &zw = m_z[row * m_nWords + w];
+    if (xw & mask) {
+      m_r[row] ^= (zw & mask) ? 1 : 0;
+      zw ^= mask;
+    }
+  }
+}
+
+void Tableau::sdg(std::size_t q) {
+  const auto w = q >> 6;
+  const auto mask = 1ULL << (q & 63);
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    const auto xw = m_x[row * m_nWords + w];
+    auto &zw = m_z[row * m_nWords + w];
+    if (xw & mask) {
+      m_r[row] ^= (zw & mask) ? 0 : 1;
+      zw ^= mask;
+    }
+  }
+}
+
+void Tableau::x(std::size_t q) {
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    m_r[row] ^= zBit(row, q);
+  }
+}
+
+void Tableau::y(std::size_t q) {
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    m_r[row] ^= xBit(row, q) ^ zBit(row, q);
+  }
+}
+
+void Tableau::z(std::size_t q) {
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    m_r[row] ^= xBit(row, q);
+  }
+}
+
+void Tableau::cx(std::size_t c, std::size_t t) {
+  const auto wc = c >> 6;
+  const auto wt = t >> 6;
+  const auto bc = c & 63;
+  const auto bt = t & 63;
+  for (std::size_t row = 0; row < 2 * m_nQubits; ++row) {
+    auto *xr = &m_x[row * m_nWords];
+    auto *zr = &m_z[row * m_nWords];
+    const std::uint64_t xc = (xr[wc] >> bc) & 1ULL;
+    const std::uint64_t zc = (zr[wc] >> bc) & 1ULL;
+    const std::uint64_t xt = (xr[wt] >> bt) & 1ULL;
+    const std::uint64_t zt = (zr[wt] >> bt) & 1ULL;
+    m_r[row] ^= xc & zt & (xt ^ zc ^ 1ULL);
+    xr[wt] ^= xc << bt;
+    zr[wc] ^= zt << bc;
+  }
+}
+
+void Tableau::cz(std::size_t a, std::size_t b) {
+  h(b);
+  cx(a, b);
+  h(b);
+}
+
+void Tableau::swap(std::size_t a, std::size_t b) {
+  cx(a, b);
+  cx(b, a);
+  cx(a, b);
+}
+
+void Tableau::copyRow(std::size_t dest, std::size_t src) {
+  std::copy_n(xRow(src), m_nWords, xRow(dest));
+  std::copy_n(zRow(src), m_nWords, zRow(dest));
+  m_r[dest] = m_r[src];
+}
+
+void Tableau::clearRow(std::size_t row) {
+  std::fill_n(xRow(row), m_nWords, 0ULL);
+  std::fill_n(zRow(row), m_nWords, 0ULL);
+  m_r[row] = 0;
+}
+
+void Tableau::rowsum(std::size_t h, std::size_t i) {
+  auto *x1 = xRow(h);
+  auto *z1 = zRow(h);
+  const auto *x2 = xRow(i);
+  const auto *z2 = zRow(i);
+  // Per-bit-position mod-4 counters of the i^k factors
+  // picked up by the single-qubit Pauli products.
+  std::uint64_t cnt1 = 0;
+  std::uint64_t cnt2 = 0;
+  for (std::size_t w = 0; w < m_nWords; ++w) {
+    const auto oldX1 = x1[w];
+    const auto oldZ1 = z1[w];
+    x1[w] ^= x2[w];
+    z1[w] ^= z2[w];
+    const auto x1z2 = oldX1 & z2[w];
+    const auto antiCommutes = (x2[w] & oldZ1) ^ x1z2;
+    cnt2 ^= (cnt1 ^ x1[w] ^ z1[w] ^ x1z2) & antiCommutes;
+    cnt1 ^= antiCommutes;
+  }
+  const int exponent = (popcount(cnt1) + 2 * popcount(cnt2)) & 3;
+  m_r[h] ^= m_r[i] ^ ((exponent >> 1) & 1);
+}
+
+bool Tableau::measure(std::size_t q, bool randomOutcome, bool *isRandom) {
+  const auto n = m_nQubits;
+  std::size_t p = 2 * n;
+  for (std::size_t row = n; row < 2 * n; ++row) {
+    if (xBit(row, q)) {
+      p = row;
+      break;
+    }
+  }
+
+  if (p < 2 * n) {
+    // Random outcome
+    for (std::size_t row = 0; row < 2 * n; ++row) {
+      if (row != p && xBit(row, q)) {
+        rowsum(row, p);
+      }
+    }
+    copyRow(p - n, p);
+    clearRow(p);
+    zRow(p)[q >> 6] |= 1ULL << (q & 63);
+    m_r[p] = randomOutcome;
+    if (isRandom) {
+      *isRandom = true;
+    }
+    return randomOutcome;
+  }
+
+  // Deterministic outcome: accumulate the stabilizers in the scratch row
+  const auto scratch = 2 * n;
+  clearRow(scratch);
+  for (std::size_t row = 0; row < n; ++row) {
+    if (xBit(row, q)) {
+      rowsum(scratch, row + n);
+    }
+  }
+  if (isRandom) {
+    *isRandom = false;
+  }
+  return m_r[scratch];
+}
+
+void Tableau::reset(std::size_t q, bool randomOutcome) {
+  if (measure(q, randomOutcome)) {
+    x(q);
+  }
+}
+
+bool Tableau::apply(const Op &op, bool randomOutcome) {
+  switch (op.type) {
+  case OpType::H:
+    h(op.q1);
+    break;
+  case OpType::S:
+    s(op.q1);
+    break;
+  case OpType::Sdg:
+    sdg(op.q1);
+    break;
+  case OpType::X:
+    x(op.q1);
+    break;
+  case OpType::Y:
+    y(op.q1);
+    break;
+  case OpType::Z:
+    z(op.q1);
+    break;
+  case OpType::CX:
+    cx(op.q1, op.q2);
+    break;
+  case OpType::CZ:
+    cz(op.q1, op.q2);
+    break;
+  case OpType::Swap:
+    swap(op.q1, op.q2);
+    break;
+  case OpType::Measure:
+    return measure(op.q1, randomOutcome);
+  case OpType::Reset:
+    reset(op.q1, randomOutcome);
+    break;
+  }
+  return false;
+}
+
+FrameSimulator::FrameSimulator(std::size_t nQubits, std::size_t nWords)
+    : m_nQubits(nQubits), m_nWords(nWords), m_x(nQubits * nWords),
+      m_z(nQubits * nWords) {}
+
+const std::vector<std::uint64_t> &
+FrameSimulator::run(const std::vector<Op> &ops, std::size_t nMeasurements,
+                    std::mt19937_64 &rng) {
+  const auto W = m_nWords;
+  m_flips.assign(nMeasurements * W, 0);
+  // |0> is a Z eigenstate: randomize the Z frames.
+  std::fill(m_x.begin(), m_x.end(), 0ULL);
+  for (auto &zw : m_z) {
+    zw = rng();
+  }
+
+  std::size_t measIdx = 0;
+  for (const auto &op : ops) {
+    auto *x1 = &m_x[op.q1 * W];
+    auto *z1 = &m_z[op.q1 * W];
+    switch (op.type) {
+    case OpType::H:
+      std::swap_ranges(x1, x1 + W, z1);
+      break;
+    case OpType::S:
+    case OpType::Sdg:
+      for (std::size_t w = 0; w < W; ++w) {
+        z1[w] ^= x1[w];
+      }
+      break;
+    case OpType::X:
+    case OpType::Y:
+    case OpType::Z:
+      // Paulis only change signs, which the reference sample accounts for.
+      break;
+    case OpType::CX: {
+      auto *x2 = &m_x[op.q2 * W];
+      auto *z2 = &m_z[op.q2 * W];
+      for (std::size_t w = 0; w < W; ++w) {
+        x2[w] ^= x1[w];
+        z1[w] ^= z2[w];
+      }
+      break;
+    }
+    case OpType::CZ: {
+      auto *x2 = &m_x[op.q2 * W];
+      auto *z2 = &m_z[op.q2 * W];
+      for (std::size_t w = 0; w < W; ++w) {
+        z1[w] ^= x2[w];
+        z2[w] ^= x1[w];
+      }
+      break;
+    }
+    case OpType::Swap: {
+      std::swap_ranges(x1, x1 + W, &m_x[op.q2 * W]);
+      std::swap_ranges(z1, z1 + W, &m_z[op.q2 * W]);
+      break;
+    }
+    case OpType::Measure: {
+      assert(measIdx < nMeasurements);
+      auto *flips = &m_flips[measIdx * W];
+      for (std::size_t w = 0; w < W; ++w) {
+        flips[w] = x1[w];
+        z1[w] ^= rng();
+      }
+      ++measIdx;
+      break;
+    }
+    case OpType::Reset:
+      for (std::size_t w = 0; w < W; ++w) {
+        x1[w] = 0;
+        z1[w] = rng();
+      }
+      break;
+    }
+  }
+  return m_flips;
+}
+
+void transpose64(std::uint64_t *a) {
+  std::uint64_t mask = 0x00000000FFFFFFFFULL;
+  for (std::size_t j = 32; j != 0; j >>= 1, mask ^= (mask << j)) {
+    for (std::size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      const std::uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+      a[k] ^= t << j;
+      a[k | j] ^= t;
+    }
+  }
+}
+} // namespace stabilizer
+} // namespace quantum
+} // namespace xacc
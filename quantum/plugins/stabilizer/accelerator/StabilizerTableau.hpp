@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace xacc {
+namespace quantum {
+namespace stabilizer {
+// Primitive Clifford operations.
+// All supported XACC gates are lowered to a sequence of these.
+enum class OpType : std::uint8_t {
+  H,
+  S,
+  Sdg,
+  X,
+  Y,
+  Z,
+  CX,
+  CZ,
+  Swap,
+  Measure,
+  Reset
+};
+
+struct Op {
+  OpType type;
+  std::uint32_t q1;
+  std::uint32_t q2;
+};
+
+// Aaronson-Gottesman tableau (quant-ph/0406196).
+// Rows [0, n) are destabilizers, [n, 2n) are stabilizers and row 2n is a
+// scratch row. The X and Z parts of each row are bit-packed into 64-bit
+// words, so that row multiplication (rowsum) is word-parallel:
+// the phase of the product is accumulated with bit-parallel mod-4 counters
+// and popcounts rather than bit-by-bit.
+class Tableau {
+public:
+  explicit Tableau(std::size_t nQubits);
+
+  std::size_t nQubits() const { return m_nQubits; }
+
+  void h(std::size_t q);
+  void s(std::size_t q);
+  void sdg(std::size_t q);
+  void x(std::size_t q);
+  void y(std::size_t q);
+  void z(std::size_t q);
+  void cx(std::size_t c, std::size_t t);
+  void cz(std::size_t a, std::size_t b);
+  void swap(std::size_t a, std::size_t b);
+  // Z-basis measurement.
+  // If the outcome is random, 'randomOutcome' is used as the result and
+  // 'isRandom' (if provided) is set to true.
+  bool measure(std::size_t q, bool randomOutcome, bool *isRandom = nullptr);
+  // Reset to |0> (measure, then flip if needed)
+  void reset(std::size_t q, bool randomOutcome);
+  // Apply a primitive op; returns the measurement result for Measure ops.
+  // 'randomOutcome' is used for random Measure/Reset outcomes.
+  bool apply(const Op &op, bool randomOutcome = false);
+
+private:
+  std::uint64_t *xRow(std::size_t row) { return &m_x[row * m_nWords]; }
+  std::uint64_t *zRow(std::size_t row) { return &m_z[row * m_nWords]; }
+  bool xBit(std::size_t row, std::size_t q) const {
+    return (m_x[row * m_nWords + (q >> 6)] >> (q & 63)) & 1ULL;
+  }
+  bool zBit(std::size_t row, std::size_t q) const {
+    return (m_z[row * m_nWords + (q >> 6)] >> (q & 63)) & 1ULL;
+  }
+  // Row h <- Row h * Row i (phase tracked)
+  void rowsum(std::size_t h, std::size_t i);
+  void copyRow(std::size_t dest, std::size_t src);
+  void clearRow(std::size_t row);
+
+  std::size_t m_nQubits;
+  std::size_t m_nWords;
+  std::vector<std::uint64_t> m_x;
+  std::vector<std::uint64_t> m_z;
+  std::vector<std::uint8_t> m_r;
+};
+
+// Pauli-frame sampler.
+// Propagates Pauli frames (the difference between a shot and a reference
+// sample) for 64 * nWords shots at once: each qubit's X and Z frame
+// components are stored as bit-vectors over the shots, so every Clifford
+// gate is a handful of word-wide XOR/SWAP operations for the whole batch.
+// Measurement flips w.r.t. the reference sample are recorded per
+// measurement; random outcomes emerge from Z-frame randomization at
+// initialization, measurement and reset.
+class FrameSimulator {
+public:
+  FrameSimulator(std::size_t nQubits, std::size_t nWords);
+  std::size_t nWords() const { return m_nWords; }
+  // Run a batch; returns the flip words: flips[m * nWords + w] for the
+  // m-th measurement (in program order).
+  const std::vector<std::uint64_t> &run(const std::vector<Op> &ops,
+                                        std::size_t nMeasurements,
+                                        std::mt19937_64 &rng);
+
+private:
+  std::size_t m_nQubits;
+  std::size_t m_nWords;
+  std::vector<std::uint64_t> m_x;
+  std::vector<std::uint64_t> m_z;
+  std::vector<std::uint64_t> m_flips;
+};
+
+// Transpose a 64x64 bit matrix in place
+// (bit j of a[i] <-> bit i of a[j]).
+void transpose64(std::uint64_t *a);
+} // namespace stabilizer
+} // namespace quantum
+} // namespace xacc
@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include <chrono>
+
+TEST(StabilizerAcceleratorTester, testBell) {
+  auto accelerator =
+      xacc::getAccelerator("stabilizer", {{"shots", 8192}, {"seed", 42}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void stab_bell(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, program);
+  buffer->print();
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(4096, counts.at("00"), 300);
+  EXPECT_NEAR(4096, counts.at("11"), 300);
+}
+
+TEST(StabilizerAcceleratorTester, testDeterministic) {
+  auto accelerator = xacc::getAccelerator("stabilizer", {{"shots", 1000}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  // Rx(pi) = X, Ry(pi/2) Z Ry(-pi/2) = X, S S = Z
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void stab_det(qbit q) {
+      Rx(q[0], pi);
+      Ry(q[1], pi/2);
+      Z(q[1]);
+      Ry(q[1], -pi/2);
+      H(q[2]);
+      S(q[2]);
+      S(q[2]);
+      H(q[2]);
+      CX(q[2], q[3]);
+      Measure(q[0]);
+      Measure(q[1]);
+      Measure(q[2]);
+      Measure(q[3]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(4);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(1, counts.size());
+  EXPECT_EQ(1000, counts.at("1111"));
+}
+
+TEST(StabilizerAcceleratorTester, testExpVal) {
+  auto accelerator = xacc::getAccelerator("stabilizer");
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void stab_exp1(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Measure(q[0]);
+      Measure(q[1]);
+    }
+    __qpu__ void stab_exp2(qbit q) {
+      H(q[0]);
+      Measure(q[0]);
+    }
+    __qpu__ void stab_exp3(qbit q) {
+      X(q[0]);
+      Measure(q[0]);
+    })",
+                                  accelerator);
+  const std::vector<double> expected{1.0, 0.0, -1.0};
+  for (int i = 0; i < 3; ++i) {
+    auto buffer = xacc::qalloc(2);
+    accelerator->execute(buffer, ir->getComposites()[i]);
+    EXPECT_NEAR(expected[i], buffer->getExpectationValueZ(), 1e-12);
+  }
+}
+
+TEST(StabilizerAcceleratorTester, testNonClifford) {
+  auto accelerator = xacc::getAccelerator("stabilizer", {{"shots", 10}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void stab_t(qbit q) {
+      H(q[0]);
+      T(q[0]);
+      Measure(q[0]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(1);
+  EXPECT_ANY_THROW(accelerator->execute(buffer, program));
+}
+
+TEST(StabilizerAcceleratorTester, testMidCircuitReset) {
+  auto accelerator =
+      xacc::getAccelerator("stabilizer", {{"shots", 4096}, {"seed", 7}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  // Reset of half of a Bell pair: the other qubit stays random.
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void stab_reset(qbit q) {
+      H(q[0]);
+      CX(q[0], q[1]);
+      Reset(q[0]);
+      Measure(q[0]);
+      Measure(q[1]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(2);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(2048, counts.at("00"), 250);
+  EXPECT_NEAR(2048, counts.at("01"), 250);
+}
+
+TEST(StabilizerAcceleratorTester, testConditional) {
+  auto accelerator = xacc::getAccelerator("stabilizer", {{"shots", 1024}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  // Feed-forward: q[1] is flipped iff q[0] is measured as 1.
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void stab_cond(qbit q) {
+      H(q[0]);
+      Measure(q[0]);
+      if (q[0]) {
+        X(q[1]);
+      }
+      Measure(q[1]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(2);
+  buffer->setName("q");
+  xacc::storeBuffer(buffer);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  EXPECT_GT(counts.at("00"), 400);
+  EXPECT_GT(counts.at("11"), 400);
+}
+
+TEST(StabilizerAcceleratorTester, testLargeGHZ) {
+  // 1000-qubit GHZ state, 100k shots.
+  const int nQubits = 1000;
+  const int nShots = 100000;
+  auto accelerator =
+      xacc::getAccelerator("stabilizer", {{"shots", nShots}, {"seed", 1}});
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite("ghz");
+  program->addInstruction(provider->createInstruction("H", {0}));
+  for (std::size_t i = 0; i + 1 < nQubits; ++i) {
+    program->addInstruction(provider->createInstruction("CNOT", {i, i + 1}));
+  }
+  for (std::size_t i = 0; i < nQubits; ++i) {
+    program->addInstruction(provider->createInstruction("Measure", {i}));
+  }
+  auto buffer = xacc::qalloc(nQubits);
+  const auto start = std::chrono::high_resolution_clock::now();
+  accelerator->execute(buffer, program);
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::high_resolution_clock::now() - start)
+                           .count();
+  std::cout << nQubits << "-qubit GHZ, " << nShots << " shots: " << elapsed
+            << " ms\n";
+  const auto counts = buffer->getMeasurementCounts();
+  EXPECT_EQ(2, counts.size());
+  const auto nZeros = counts.at(std::string(nQubits, '0'));
+  const auto nOnes = counts.at(std::string(nQubits, '1'));
+  EXPECT_EQ(nShots, nZeros + nOnes);
+  EXPECT_NEAR(nShots / 2, nZeros, 1500);
+}
+
+int main(int argc, char **argv) {
+  xacc::Initialize(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -27,6 +27,28 @@ void RotationFolding::apply(std::shared_ptr<CompositeInstruction> program,
                             const std::shared_ptr<Accelerator> accelerator,
                             const HeterogeneousMap &options) {
 
+  // Fold rotations, then clean up
+  const auto optimize = [](ast::Program &prog) {
+    optimization::fold_rotations(prog);
+    optimization::simplify(prog);
+  };
+
+  // In-memory translation to the staq AST (no OpenQASM round trip),
+  // unless the program can only be expressed in OpenQASM
+  // (e.g. it has conditionals) or the text translation is requested.
+  const bool useAst = !options.keyExists<bool>("ast-translation") ||
+                      options.get<bool>("ast-translation");
+  if (useAst) {
+    auto prog = internal_staq::XACCToStaqAst::translate(program);
+    if (prog) {
+      optimize(*prog);
+      auto optimized = internal_staq::staqAstToInstructions(*prog);
+      program->clear();
+      program->addInstructions(std::move(optimized), false);
+      return;
+    }
+  }
+
   // map to openqasm
   auto staq = xacc::getCompiler("staq");
   auto src = staq->translate(program);
@@ -34,9 +56,7 @@ void RotationFolding::apply(std::shared_ptr<CompositeInstruction> program,
   // parse that to get staq ast
   auto prog = parser::parse_string(src);
 
-  // fold rotations
-  optimization::fold_rotations(*prog);
-  optimization::simplify(*prog);
+  optimize(*prog);
 
   // map prog back to staq src string and
   // compile to ir
@@ -66,15 +66,21 @@ void SwapShort::apply(std::shared_ptr<CompositeInstruction> program,
     adj[edge.second][edge.first] = true;
   }
 
-  // map to openqasm
+  // Staq AST: in-memory translation if possible (see RotationFolding),
+  // otherwise parse the OpenQASM translation.
+  const bool useAst = !options.keyExists<bool>("ast-translation") ||
+                      options.get<bool>("ast-translation");
   auto staq = xacc::getCompiler("staq");
-  auto src = staq->translate(program);
-
-    // std::cout << "HELLO WORLD:\n" << src << "\n";
-  // parse that to get staq ast
+  std::string src;
   ast::ptr<ast::Program> prog;
+  if (useAst) {
+    prog = internal_staq::XACCToStaqAst::translate(program);
+  }
   try {
-    prog = parser::parse_string(src);
+    if (!prog) {
+      src = staq->translate(program);
+      prog = parser::parse_string(src);
+    }
     transformations::desugar(*prog);
     transformations::Inliner::config c;
     // Make sure we treat map all control pauli 
@@ -87,7 +93,8 @@ void SwapShort::apply(std::shared_ptr<CompositeInstruction> program,
   } catch (std::exception &e) {
     std::stringstream ss;
     ss << e.what();
-    ss << "\nXACC Error in Staq Swap Short, here was the src:\n" << src << "\n";
+    ss << "\nXACC Error in Staq Swap Short, here was the src:\n"
+       << (src.empty() ? program->toString() : src) << "\n";
     xacc::error(ss.str());
   }
 
@@ -101,6 +108,14 @@ void SwapShort::apply(std::shared_ptr<CompositeInstruction> program,
 
   mapping::map_onto_device(device, *prog);
 
+  if (src.empty()) {
+    // Direct translation back to XACC IR
+    auto mapped = internal_staq::staqAstToInstructions(*prog);
+    program->clear();
+    program->addInstructions(std::move(mapped), false);
+    return;
+  }
+
   // map prog back to staq src string and
   // compile to ir
   std::stringstream ss;
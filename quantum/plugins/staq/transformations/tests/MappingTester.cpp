@@ -14,6 +14,8 @@
 
 #include "xacc.hpp"
 #include "xacc_service.hpp"
+#include <chrono>
+#include <random>
 using namespace xacc;
 
 class AcceleratorWithConnectivity : public xacc::Accelerator {
@@ -130,6 +132,102 @@ TEST(Staq_MappingTester, checkSwapShortSwap) {
   std::cout << program->toString() << "\n";
 }
 
+TEST(Staq_MappingTester, checkSwapShortAstTranslation) {
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(
+      std::vector<std::pair<int, int>>{{0, 1}, {1, 2}, {2, 3}});
+
+  auto irt = xacc::getIRTransformation("swap-shortest-path");
+  auto compiler = xacc::getCompiler("xasm");
+  const std::string src = R"(__qpu__ void KERNEL(qreg x) {
+      H(x[0]);
+      CX(x[0], x[3]);
+      Rz(x[3], 0.123);
+      CZ(x[1], x[3]);
+      Swap(x[0], x[2]);
+      Measure(x[0]);
+      Measure(x[3]);
+  })";
+  auto compile = [&](const std::string &name) {
+    auto kernelSrc = src;
+    kernelSrc.replace(kernelSrc.find("KERNEL"), 6, name);
+    return compiler->compile(kernelSrc)->getComposite(name);
+  };
+  auto viaText = compile("test_swap_text");
+  auto viaAst = compile("test_swap_ast");
+  irt->apply(viaText, qpu, {{"ast-translation", false}});
+  irt->apply(viaAst, qpu);
+
+  ASSERT_EQ(viaText->nInstructions(), viaAst->nInstructions());
+  for (int i = 0; i < viaText->nInstructions(); i++) {
+    EXPECT_EQ(viaText->getInstruction(i)->name(),
+              viaAst->getInstruction(i)->name());
+    EXPECT_EQ(viaText->getInstruction(i)->bits(),
+              viaAst->getInstruction(i)->bits());
+  }
+}
+
+// Pass time: OpenQASM text round trip vs. in-memory AST translation
+// on a 10^5-gate random circuit, mapped onto a 4x5 grid.
+// Run with --gtest_also_run_disabled_tests.
+TEST(Staq_MappingTester, DISABLED_benchmarkSwapShortAstTranslation) {
+  const int nRows = 4;
+  const int nCols = 5;
+  const int nQubits = nRows * nCols;
+  const int nGates = 100000;
+  std::vector<std::pair<int, int>> edges;
+  for (int row = 0; row < nRows; row++) {
+    for (int col = 0; col < nCols; col++) {
+      const int q = row * nCols + col;
+      if (col + 1 < nCols) {
+        edges.emplace_back(q, q + 1);
+      }
+      if (row + 1 < nRows) {
+        edges.emplace_back(q, q + nCols);
+      }
+    }
+  }
+  auto qpu = std::make_shared<AcceleratorWithConnectivity>(std::move(edges));
+
+  auto provider = xacc::getIRProvider("quantum");
+  auto irt = xacc::getIRTransformation("swap-shortest-path");
+  std::map<bool, double> elapsed;
+  for (const bool useAst : {false, true}) {
+    auto program = provider->createComposite(
+        useAst ? "benchmark_swap_ast" : "benchmark_swap_text");
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> qubitDist(0, nQubits - 1);
+    std::uniform_real_distribution<double> angleDist(-M_PI, M_PI);
+    for (int i = 0; i < nGates; i++) {
+      const auto q0 = qubitDist(gen);
+      switch (i % 3) {
+      case 0:
+        program->addInstruction(provider->createInstruction("H", {q0}));
+        break;
+      case 1:
+        program->addInstruction(
+            provider->createInstruction("Rz", {q0}, {angleDist(gen)}));
+        break;
+      default: {
+        auto q1 = qubitDist(gen);
+        while (q1 == q0) {
+          q1 = qubitDist(gen);
+        }
+        program->addInstruction(provider->createInstruction("CNOT", {q0, q1}));
+      }
+      }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    irt->apply(program, qpu, {{"ast-translation", useAst}});
+    elapsed[useAst] = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    EXPECT_GE(program->nInstructions(), nGates);
+  }
+  std::cout << "Swap shortest path (" << nGates
+            << " gates): text = " << elapsed[false]
+            << " s, AST = " << elapsed[true] << " s\n";
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   xacc::set_verbose(true);
@@ -14,6 +14,57 @@
 
 #include "xacc.hpp"
 #include "xacc_service.hpp"
+#include <chrono>
+#include <random>
+
+namespace {
+// Random Clifford+T+Rz circuit
+std::shared_ptr<xacc::CompositeInstruction> randomCircuit(const std::string &name,
+                                                          int nQubits,
+                                                          int nGates) {
+  auto provider = xacc::getIRProvider("quantum");
+  auto program = provider->createComposite(name);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> gateDist(0, 6);
+  std::uniform_int_distribution<std::size_t> qubitDist(0, nQubits - 1);
+  std::uniform_real_distribution<double> angleDist(-M_PI, M_PI);
+  const std::vector<std::string> gates{"H", "T", "Tdg", "S", "X", "Rz", "CNOT"};
+  for (int i = 0; i < nGates; i++) {
+    const auto gateName = gates[gateDist(gen)];
+    const auto q0 = qubitDist(gen);
+    if (gateName == "CNOT") {
+      auto q1 = qubitDist(gen);
+      while (q1 == q0) {
+        q1 = qubitDist(gen);
+      }
+      program->addInstruction(provider->createInstruction(gateName, {q0, q1}));
+    } else if (gateName == "Rz") {
+      program->addInstruction(
+          provider->createInstruction(gateName, {q0}, {angleDist(gen)}));
+    } else {
+      program->addInstruction(provider->createInstruction(gateName, {q0}));
+    }
+  }
+  return program;
+}
+
+void expectSameCircuit(std::shared_ptr<xacc::CompositeInstruction> a,
+                       std::shared_ptr<xacc::CompositeInstruction> b) {
+  ASSERT_EQ(a->nInstructions(), b->nInstructions());
+  for (int i = 0; i < a->nInstructions(); i++) {
+    auto instA = a->getInstruction(i);
+    auto instB = b->getInstruction(i);
+    EXPECT_EQ(instA->name(), instB->name());
+    EXPECT_EQ(instA->bits(), instB->bits());
+    ASSERT_EQ(instA->nParameters(), instB->nParameters());
+    for (int j = 0; j < instA->nParameters(); j++) {
+      EXPECT_NEAR(
+          xacc::InstructionParameterToDouble(instA->getParameter(j)),
+          xacc::InstructionParameterToDouble(instB->getParameter(j)), 1e-9);
+    }
+  }
+}
+} // namespace
 
 TEST(Staq_RotationFoldingTester, checkSimple) {
   auto irt = xacc::getIRTransformation("rotation-folding");
@@ -104,6 +155,72 @@ TEST(Staq_RotationFoldingTester, checkSimple) {
   EXPECT_NEAR(0.00000005, program->getInstruction(0)->getParameter(0).as<double>(), 1e-12);
 }
 
+TEST(Staq_RotationFoldingTester, checkSymbolic) {
+  auto irt = xacc::getIRTransformation("rotation-folding");
+  auto compiler = xacc::getCompiler("xasm");
+  auto program = compiler->compile(R"(__qpu__ void test_symbolic(qreg q, double theta) {
+      T(q[0]);
+      Rz(q[1], theta);
+      T(q[0]);
+      H(q[1]);
+  })")->getComposite("test_symbolic");
+
+  irt->apply(program, nullptr);
+
+  // The symbolic rotation is kept (not supported by the OpenQASM translation).
+  EXPECT_EQ(3, program->nInstructions());
+  std::shared_ptr<xacc::Instruction> rz;
+  for (auto &inst : program->getInstructions()) {
+    if (inst->name() == "Rz") {
+      rz = inst;
+    } else {
+      EXPECT_TRUE(inst->name() == "S" || inst->name() == "H");
+    }
+  }
+  ASSERT_TRUE(rz != nullptr);
+  EXPECT_EQ(1, rz->bits()[0]);
+  EXPECT_TRUE(rz->getParameter(0).isVariable());
+  EXPECT_EQ("theta", rz->getParameter(0).toString());
+
+  auto evaled = (*program)({0.25});
+  for (auto &inst : evaled->getInstructions()) {
+    if (inst->name() == "Rz") {
+      EXPECT_NEAR(0.25, inst->getParameter(0).as<double>(), 1e-12);
+    }
+  }
+}
+
+TEST(Staq_RotationFoldingTester, checkAstTranslation) {
+  auto irt = xacc::getIRTransformation("rotation-folding");
+  auto viaText = randomCircuit("rotation_folding_text", 5, 500);
+  auto viaAst = randomCircuit("rotation_folding_ast", 5, 500);
+  irt->apply(viaText, nullptr, {{"ast-translation", false}});
+  irt->apply(viaAst, nullptr);
+  EXPECT_LT(viaAst->nInstructions(), 500);
+  expectSameCircuit(viaText, viaAst);
+}
+
+// Pass time: OpenQASM text round trip vs. in-memory AST translation
+// on 10^5-gate circuits (swap-shortest-path: see MappingTester).
+// Run with --gtest_also_run_disabled_tests.
+TEST(Staq_RotationFoldingTester, DISABLED_benchmarkAstTranslation) {
+  const int nGates = 100000;
+  auto irt = xacc::getIRTransformation("rotation-folding");
+  std::map<bool, double> elapsed;
+  for (const bool useAst : {false, true}) {
+    auto program = randomCircuit(
+        useAst ? "benchmark_ast" : "benchmark_text", 20, nGates);
+    const auto start = std::chrono::steady_clock::now();
+    irt->apply(program, nullptr, {{"ast-translation", useAst}});
+    elapsed[useAst] = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    EXPECT_LT(program->nInstructions(), nGates);
+  }
+  std::cout << "Rotation folding (" << nGates
+            << " gates): text = " << elapsed[false]
+            << " s, AST = " << elapsed[true] << " s\n";
+}
 
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
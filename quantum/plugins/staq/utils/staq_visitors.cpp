@@ -12,6 +12,8 @@
  *******************************************************************************/
 #include "staq_visitors.hpp"
 #include "Instruction.hpp"
+#include "InstructionIterator.hpp"
+#include "transformations/inline.hpp"
 
 namespace xacc {
 namespace internal_staq {
@@ -142,5 +144,135 @@ void XACCToStaqOpenQasm::visit(IfStmt &ifStmt) {
     i->accept(this);
   }
 }
+
+namespace {
+// The qelib1 gate declarations (the header of any XACC -> Staq translation),
+// parsed only once.
+const Program &qelibHeader() {
+  static const ptr<Program> header =
+      staq::parser::parse_string("OPENQASM 2.0;\ninclude \"qelib1.inc\";\n");
+  return *header;
+}
+
+ptr<Expr> toStaqExpr(const InstructionParameter &param) {
+  if (param.which() == 2) {
+    const auto str = param.as<std::string>();
+    char *end = nullptr;
+    const double val = std::strtod(str.c_str(), &end);
+    if (str.empty() || *end != '\0') {
+      // Symbolic parameter
+      return VarExpr::create({}, str);
+    }
+    return RealExpr::create({}, val);
+  }
+  return RealExpr::create({}, xacc::InstructionParameterToDouble(param));
+}
+} // namespace
+
+ptr<Program>
+XACCToStaqAst::translate(std::shared_ptr<CompositeInstruction> program) {
+  auto visitor = std::make_shared<XACCToStaqAst>();
+  InstructionIterator iter(program);
+  while (iter.hasNext()) {
+    auto next = iter.next();
+    if (!next->isEnabled()) {
+      continue;
+    }
+    if (next->isComposite()) {
+      if (std::dynamic_pointer_cast<xacc::quantum::IfStmt>(next)) {
+        return nullptr;
+      }
+      continue;
+    }
+    visitor->m_handled = false;
+    visitor->m_bufferName =
+        next->getBufferNames().empty() ? "q" : next->getBufferName(0);
+    next->accept(visitor);
+    if (!visitor->m_handled) {
+      return nullptr;
+    }
+  }
+
+  ptr<Program> header(qelibHeader().clone());
+  auto body = std::move(header->body());
+  for (const auto &kv : visitor->m_qregs) {
+    body.emplace_back(RegisterDecl::create({}, kv.first, true, kv.second));
+  }
+  for (const auto &kv : visitor->m_cregs) {
+    body.emplace_back(RegisterDecl::create({}, kv.first, false, kv.second));
+  }
+  body.splice(body.end(), visitor->m_body);
+  return Program::create({}, true, std::move(body));
+}
+
+VarAccess XACCToStaqAst::qubit(Instruction &inst, int idx) {
+  const auto regName = inst.getBufferNames().size() > idx
+                           ? inst.getBufferName(idx)
+                           : m_bufferName;
+  const int bit = inst.bits()[idx];
+  auto &size = m_qregs[regName];
+  size = std::max(size, bit + 1);
+  return VarAccess({}, regName, bit);
+}
+
+void XACCToStaqAst::addGate(const std::string &name, Instruction &inst,
+                            int nParams) {
+  std::vector<ptr<Expr>> cargs;
+  for (int i = 0; i < nParams; i++) {
+    cargs.emplace_back(toStaqExpr(inst.getParameter(i)));
+  }
+  std::vector<VarAccess> qargs;
+  for (int i = 0; i < inst.bits().size(); i++) {
+    qargs.emplace_back(qubit(inst, i));
+  }
+  m_body.emplace_back(
+      DeclaredGate::create({}, name, std::move(cargs), std::move(qargs)));
+  m_handled = true;
+}
+
+void XACCToStaqAst::visit(Hadamard &h) { addGate("h", h); }
+void XACCToStaqAst::visit(CNOT &cx) {
+  m_body.emplace_back(CNOTGate::create({}, qubit(cx, 0), qubit(cx, 1)));
+  m_handled = true;
+}
+void XACCToStaqAst::visit(Rz &rz) { addGate("rz", rz, 1); }
+void XACCToStaqAst::visit(Ry &ry) { addGate("ry", ry, 1); }
+void XACCToStaqAst::visit(Rx &rx) { addGate("rx", rx, 1); }
+void XACCToStaqAst::visit(X &x) { addGate("x", x); }
+void XACCToStaqAst::visit(Y &y) { addGate("y", y); }
+void XACCToStaqAst::visit(Z &z) { addGate("z", z); }
+void XACCToStaqAst::visit(CY &cy) { addGate("cy", cy); }
+void XACCToStaqAst::visit(CZ &cz) { addGate("cz", cz); }
+void XACCToStaqAst::visit(Swap &s) { addGate("swap", s); }
+void XACCToStaqAst::visit(CRZ &crz) { addGate("crz", crz, 1); }
+void XACCToStaqAst::visit(CH &ch) { addGate("ch", ch); }
+void XACCToStaqAst::visit(S &s) { addGate("s", s); }
+void XACCToStaqAst::visit(Sdg &sdg) { addGate("sdg", sdg); }
+void XACCToStaqAst::visit(T &t) { addGate("t", t); }
+void XACCToStaqAst::visit(Tdg &tdg) { addGate("tdg", tdg); }
+void XACCToStaqAst::visit(CPhase &cphase) { addGate("cu1", cphase, 1); }
+void XACCToStaqAst::visit(Measure &m) {
+  if (m.hasClassicalRegAssignment()) {
+    // Not handled: the text translation declares the classical registers.
+    return;
+  }
+  auto q = qubit(m, 0);
+  const auto cregName = q.var() + "_c";
+  auto &size = m_cregs[cregName];
+  size = std::max(size, q.offset().value() + 1);
+  VarAccess c({}, cregName, q.offset().value());
+  m_body.emplace_back(MeasureStmt::create({}, std::move(q), std::move(c)));
+  m_handled = true;
+}
+void XACCToStaqAst::visit(Identity &i) { m_handled = true; }
+void XACCToStaqAst::visit(U &u) { addGate("u3", u, 3); }
+
+std::vector<InstPtr> staqAstToInstructions(Program &prog) {
+  staq::transformations::inline_ast(
+      prog, {false, staq::transformations::default_overrides, "anc"});
+  StaqToIr translate("", "");
+  translate.visit(prog);
+  return translate.getInstructions();
+}
 } // namespace internal_staq
-} // namespace xacc
\ No newline at end of file
+} // namespace xacc
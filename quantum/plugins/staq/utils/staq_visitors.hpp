@@ -21,6 +21,8 @@
 #include "xacc.hpp"
 #include "xacc_service.hpp"
 #include "AllGateVisitor.hpp"
+#include <list>
+#include <sstream>
 
 using namespace staq::ast;
 
@@ -181,8 +183,8 @@ public:
   void visit(RealExpr &r) override {}
   void visit(VarExpr &v) override {}
   void visit(ResetStmt &reset) override {
-    m_runtimeInsts.emplace_back(
-        std::make_shared<xacc::quantum::Reset>(reset.arg().offset().value()));
+    append(std::make_shared<xacc::quantum::Reset>(reset.arg().offset().value()),
+           {reset.arg().var()});
   }
   void visit(IfStmt &) override {}
   void visit(BarrierGate &) override {}
@@ -198,27 +200,47 @@ public:
   }
 
   void visit(MeasureStmt &m) override {
-    m_runtimeInsts.emplace_back(
-        std::make_shared<xacc::quantum::Measure>(m.q_arg().offset().value()));
+    append(std::make_shared<xacc::quantum::Measure>(m.q_arg().offset().value()),
+           {m.q_arg().var()});
   }
 
   void visit(UGate &u) override {
-    m_runtimeInsts.emplace_back(std::make_shared<xacc::quantum::U>(
-        u.arg().offset().value(), u.theta().constant_eval().value(),
-        u.phi().constant_eval().value(), u.lambda().constant_eval().value()));
+    if (u.theta().constant_eval() && u.phi().constant_eval() &&
+        u.lambda().constant_eval()) {
+      append(std::make_shared<xacc::quantum::U>(
+                 u.arg().offset().value(), u.theta().constant_eval().value(),
+                 u.phi().constant_eval().value(),
+                 u.lambda().constant_eval().value()),
+             {u.arg().var()});
+    } else {
+      append(m_provider->createInstruction(
+                 "U", {static_cast<std::size_t>(u.arg().offset().value())},
+                 {toParameter(u.theta()), toParameter(u.phi()),
+                  toParameter(u.lambda())}),
+             {u.arg().var()});
+    }
   }
 
   void visit(CNOTGate &cx) override {
-    m_runtimeInsts.emplace_back(std::make_shared<xacc::quantum::CNOT>(
-        cx.ctrl().offset().value(), cx.tgt().offset().value()));
+    append(std::make_shared<xacc::quantum::CNOT>(cx.ctrl().offset().value(),
+                                                 cx.tgt().offset().value()),
+           {cx.ctrl().var(), cx.tgt().var()});
   }
 
   void visit(DeclaredGate &g) override {
+    std::vector<std::string> regNames;
+    for (int i = 0; i < g.num_qargs(); i++) {
+      regNames.emplace_back(g.qarg(i).var());
+    }
+    bool constantArgs = true;
+    for (int i = 0; i < g.num_cargs(); i++) {
+      constantArgs = constantArgs && g.carg(i).constant_eval().has_value();
+    }
     // Handle common gates:
     auto funcIter = staq_to_xacc_ir_ctor.find(g.name());
-    if (funcIter != staq_to_xacc_ir_ctor.end()) {
+    if (constantArgs && funcIter != staq_to_xacc_ir_ctor.end()) {
       const auto &ctorFunc = funcIter->second;
-      m_runtimeInsts.emplace_back(ctorFunc(g));
+      append(ctorFunc(g), regNames);
     } else {
       auto xacc_name = staq_to_xacc.at(g.name());
       // Otherwise, just do generic construction
@@ -228,11 +250,11 @@ public:
         gate_bits.emplace_back(g.qarg(i).offset().value());
       }
       for (int i = 0; i < g.num_cargs(); i++) {
-        gate_params.emplace_back(g.carg(i).constant_eval().value());
+        gate_params.emplace_back(toParameter(g.carg(i)));
       }
 
-      m_runtimeInsts.emplace_back(
-          m_provider->createInstruction(xacc_name, gate_bits, gate_params));
+      append(m_provider->createInstruction(xacc_name, gate_bits, gate_params),
+             regNames);
     }
   }
 
@@ -240,10 +262,6 @@ public:
     auto composite =
         xacc::getService<IRProvider>("quantum")->createComposite(m_kernelName);
     composite->setBufferNames({m_regName});
-    for (auto &gate: m_runtimeInsts) {
-      std::vector regNames(gate->bits().size(), m_regName);
-      gate->setBufferNames(regNames);
-    }
     // Since the instructions were *compiled* by staq (valid AST),
     // hence, we skip all validation.
     composite->addInstructions(std::move(m_runtimeInsts), false);
@@ -252,7 +270,26 @@ public:
     return ir;
   }
 
+  // The translated instructions, with the register names of the AST.
+  std::vector<InstPtr> getInstructions() { return std::move(m_runtimeInsts); }
+
 private:
+  void append(InstPtr gate, const std::vector<std::string> &regNames) {
+    gate->setBufferNames(regNames);
+    m_runtimeInsts.emplace_back(gate);
+  }
+
+  // Non-constant expressions (i.e. symbolic parameters) are kept as strings.
+  static InstructionParameter toParameter(Expr &expr) {
+    auto value = expr.constant_eval();
+    if (value) {
+      return InstructionParameter(value.value());
+    }
+    std::stringstream ss;
+    ss << expr;
+    return InstructionParameter(ss.str());
+  }
+
   std::vector<InstPtr> m_runtimeInsts;
   std::shared_ptr<IRProvider> m_provider;
   std::string m_kernelName;
@@ -297,6 +334,57 @@ public:
   void visit(IfStmt &ifStmt) override;
 };
 
+// XACC IR to Staq AST, i.e. the in-memory equivalent of XACCToStaqOpenQasm
+// (+ parsing) for the Staq passes (rotation folding, mapping, etc.).
+// Symbolic parameters are kept as (free) Staq variables, hence they survive
+// the passes, which treat them as unknown angles.
+class XACCToStaqAst : public AllGateVisitor {
+public:
+  // Returns a null pointer if the program contains instructions that don't
+  // have an AST translation (e.g. conditionals, resets or explicit classical
+  // registers), in which case callers should use the OpenQASM translation.
+  static ptr<Program> translate(std::shared_ptr<CompositeInstruction> program);
+
+  void visit(Hadamard &h) override;
+  void visit(CNOT &cnot) override;
+  void visit(Rz &rz) override;
+  void visit(Ry &ry) override;
+  void visit(Rx &rx) override;
+  void visit(X &x) override;
+  void visit(Y &y) override;
+  void visit(Z &z) override;
+  void visit(CY &cy) override;
+  void visit(CZ &cz) override;
+  void visit(Swap &s) override;
+  void visit(CRZ &crz) override;
+  void visit(CH &ch) override;
+  void visit(S &s) override;
+  void visit(Sdg &sdg) override;
+  void visit(T &t) override;
+  void visit(Tdg &tdg) override;
+  void visit(CPhase &cphase) override;
+  void visit(Measure &measure) override;
+  void visit(Identity &i) override;
+  void visit(U &u) override;
+
+private:
+  VarAccess qubit(Instruction &inst, int idx);
+  void addGate(const std::string &name, Instruction &inst, int nParams = 0);
+
+  std::list<ptr<Stmt>> m_body;
+  // Register name -> size
+  std::map<std::string, int> m_qregs;
+  std::map<std::string, int> m_cregs;
+  // Register of the instruction being translated (for the gates which
+  // are decomposed on the fly by AllGateVisitor, e.g. Rphi).
+  std::string m_bufferName;
+  bool m_handled = false;
+};
+
+// Staq AST to XACC IR instructions: gates which don't have an XACC
+// equivalent are inlined (same as the 'staq' compiler).
+std::vector<InstPtr> staqAstToInstructions(Program &prog);
+
 } // namespace internal_staq
 } // namespace xacc
 
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Daniel Claudino - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_ALGORITHM_PAULI_TERM_ASSEMBLY_HPP_
+#define XACC_ALGORITHM_PAULI_TERM_ASSEMBLY_HPP_
+#include "AcceleratorBuffer.hpp"
+#include "PauliOperator.hpp"
+#include "ThreadPool.hpp"
+#include "xacc.hpp"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace xacc {
+namespace quantum {
+
+// Evaluates the expectation values of many operators (e.g. the commutator
+// matrix elements of qEOM or the ADAPT gradients) on the same state:
+// - the operators are constructed concurrently,
+// - the union of their (non-identity) Pauli strings is observed, hence each
+//   unique string is measured once,
+// - each operator value is then a sparse linear combination of the measured
+//   Pauli string expectation values.
+//
+// As in the algorithms using it, only the real part of the non-identity
+// terms contributes to an operator value.
+class PauliTermAssembly {
+public:
+  // Construct and register nOperators operators,
+  // generator(i) is called concurrently for i in [0, nOperators).
+  // Returns the index of the first one.
+  std::size_t
+  build(std::size_t nOperators,
+        const std::function<std::shared_ptr<Observable>(std::size_t)> &generator,
+        std::size_t nThreads = 0) {
+    std::vector<std::shared_ptr<Observable>> built(nOperators);
+    if (nOperators == 1 || nThreads == 1) {
+      for (std::size_t i = 0; i < nOperators; ++i) {
+        built[i] = generator(i);
+      }
+    } else if (nOperators > 1) {
+      ThreadPool pool(nThreads);
+      std::vector<std::future<std::shared_ptr<Observable>>> futures;
+      futures.reserve(nOperators);
+      for (std::size_t i = 0; i < nOperators; ++i) {
+        futures.emplace_back(pool.enqueue(generator, i));
+      }
+      for (std::size_t i = 0; i < nOperators; ++i) {
+        built[i] = futures[i].get();
+      }
+    }
+    const auto first = combinations.size();
+    for (auto &op : built) {
+      add(op);
+    }
+    return first;
+  }
+
+  // Register an operator, returns its index.
+  std::size_t add(const std::shared_ptr<Observable> &op) {
+    Combination combination;
+    auto pauli = std::dynamic_pointer_cast<PauliOperator>(op);
+    if (!pauli) {
+      xacc::error("PauliTermAssembly: operators must be PauliOperators.");
+    }
+    for (auto &kv : pauli->getTerms()) {
+      auto &term = kv.second;
+      if (term.isIdentity() || term.coeff() == 0.0) {
+        continue;
+      }
+      auto iter = termIndex.find(kv.first);
+      if (iter == termIndex.end()) {
+        iter = termIndex.emplace(kv.first, termOps.size()).first;
+        termOps.emplace_back(term.ops());
+      }
+      combination.emplace_back(iter->second, term.coeff());
+    }
+    combinations.emplace_back(std::move(combination));
+    return combinations.size() - 1;
+  }
+
+  std::size_t nOperators() const { return combinations.size(); }
+  std::size_t nUniqueTerms() const { return termOps.size(); }
+
+  // Sum of the unique Pauli strings (unit coefficients).
+  std::shared_ptr<PauliOperator> uniqueTerms() const {
+    auto sum = std::make_shared<PauliOperator>();
+    for (const auto &ops : termOps) {
+      sum->operator+=(PauliOperator(ops, 1.0));
+    }
+    return sum;
+  }
+
+  // Kernels measuring each unique Pauli string once
+  // (named after the Pauli string).
+  std::vector<std::shared_ptr<CompositeInstruction>>
+  observe(std::shared_ptr<CompositeInstruction> kernel) const {
+    if (termOps.empty()) {
+      return {};
+    }
+    return uniqueTerms()->observe(kernel);
+  }
+
+  // Expectation values of the unique Pauli strings,
+  // read from the child buffers of the observed kernels.
+  std::vector<double> termValues(
+      const std::vector<std::shared_ptr<AcceleratorBuffer>> &buffers) const {
+    std::vector<double> values(termOps.size(), 0.0);
+    for (auto &buffer : buffers) {
+      auto iter = termIndex.find(buffer->name());
+      if (iter != termIndex.end()) {
+        values[iter->second] = buffer->getExpectationValueZ();
+      }
+    }
+    return values;
+  }
+
+  // Value of one registered operator.
+  double evaluate(std::size_t opIdx, const std::vector<double> &values) const {
+    double result = 0.0;
+    for (const auto &entry : combinations[opIdx]) {
+      result += std::real(entry.second) * values[entry.first];
+    }
+    return result;
+  }
+
+  // Values of all registered operators.
+  std::vector<double> evaluate(const std::vector<double> &values) const {
+    std::vector<double> result(combinations.size());
+    for (std::size_t i = 0; i < combinations.size(); ++i) {
+      result[i] = evaluate(i, values);
+    }
+    return result;
+  }
+
+private:
+  // (unique term index, coefficient)
+  using Combination = std::vector<std::pair<std::size_t, std::complex<double>>>;
+  std::vector<Combination> combinations;
+  std::unordered_map<std::string, std::size_t> termIndex;
+  std::vector<std::map<int, std::string>> termOps;
+};
+} // namespace quantum
+} // namespace xacc
+#endif
@@ -97,24 +97,24 @@ std::shared_ptr<Instruction> QuantumIRProvider::createInstruction(
             "samples")) {
       const auto complexSamples =
           analog_options.get<std::vector<std::complex<double>>>("samples");
-      std::vector<std::vector<double>> sampleVec;
-      sampleVec.reserve(complexSamples.size());
-      for (const auto &sample : complexSamples) {
-        sampleVec.emplace_back(
-            std::vector<double>{sample.real(), sample.imag()});
+      if (auto pulse = std::dynamic_pointer_cast<Pulse>(inst)) {
+        pulse->setWaveform(
+            WaveformLibrary::instance().intern(complexSamples));
+      } else {
+        inst->setSamples(WaveformLibrary::toPairs(complexSamples));
       }
-      inst->setSamples(sampleVec);
     }
 
     if (analog_options.keyExists<std::vector<double>>("samples")) {
-      const auto complexSamples =
+      const auto realSamples =
           analog_options.get<std::vector<double>>("samples");
-      std::vector<std::vector<double>> sampleVec;
-      sampleVec.reserve(complexSamples.size());
-      for (const auto &sample : complexSamples) {
-        sampleVec.emplace_back(std::vector<double>{sample, 0.0});
+      Waveform waveform(realSamples.begin(), realSamples.end());
+      if (auto pulse = std::dynamic_pointer_cast<Pulse>(inst)) {
+        pulse->setWaveform(
+            WaveformLibrary::instance().intern(std::move(waveform)));
+      } else {
+        inst->setSamples(WaveformLibrary::toPairs(waveform));
       }
-      inst->setSamples(sampleVec);
     }
 
     if (analog_options.keyExists<int>("duration")) {
@@ -13,6 +13,7 @@
 #include "AcceleratorBuffer.hpp"
 #include "xacc.hpp"
 
+#include <algorithm>
 #include <numeric>
 
 #define RAPIDJSON_HAS_STDSTRING 1
@@ -411,11 +412,6 @@ std::shared_ptr<AcceleratorBuffer> AcceleratorBuffer::clone() {
  */
 const double AcceleratorBuffer::getExpectationValueZ() {
   double aver = 0.0;
-  auto has_even_parity = [](const std::string &x) -> bool {
-    int c = std::count(x.begin(), x.end(), '1');
-    return c%2 == 0;
-  };
-
   if (this->hasExtraInfoKey("ro-fixed-exp-val-z")) {
     aver = mpark::get<double>(getInformation("ro-fixed-exp-val-z"));
   } else if (this->hasExtraInfoKey("exp-val-z")) {
@@ -427,14 +423,7 @@ const double AcceleratorBuffer::getExpectationValueZ() {
       return 0;
     }
 
-    for (auto &kv : bitStringToCounts) {
-      auto par = has_even_parity(kv.first);
-      auto p = computeMeasurementProbability(kv.first);
-      if (!par) {
-        p = -p;
-      }
-      aver += p;
-    }
+    aver = PackedCounts::fromCounts(bitStringToCounts).parityExpectation();
   }
   return aver;
 }
@@ -465,29 +454,40 @@ std::map<std::string, int> AcceleratorBuffer::getMeasurementCounts() {
 std::map<std::string, int>
 AcceleratorBuffer::getMarginalCounts(const std::vector<int> &measIdxs,
                                      BitOrder bitOrder) {
-  std::map<std::string, int> result;
-
-  const auto bitMask = [&](const std::string &bitString) {
-    std::string marginalBitString;
-    for (const auto &bit : measIdxs) {
-      if (bitOrder == BitOrder::MSB) {
-        marginalBitString.push_back(bitString[bitString.size() - bit - 1]);
-      } else {
-        marginalBitString.push_back(bitString[bit]);
-      }
-    }
-    return marginalBitString;
-  };
-  for (const auto &[bitString, count] : bitStringToCounts) {
-    auto marginalBitStr = bitMask(bitString);
-    if (result.find(marginalBitStr) != result.end()) {
-      result[marginalBitStr] += count;
-    } else {
-      result[marginalBitStr] = count;
-    }
+  // The k-th character of the marginal bit strings is bit measIdxs[k].
+  return getPackedCounts(bitOrder).marginal(measIdxs).toCounts(false);
+}
+
+PackedCounts AcceleratorBuffer::getPackedCounts(BitOrder bitOrder) {
+  return PackedCounts::fromCounts(bitStringToCounts,
+                                  bitOrder == BitOrder::MSB);
+}
+
+void AcceleratorBuffer::setPackedMeasurements(const PackedCounts &counts,
+                                              BitOrder bitOrder) {
+  setMeasurements(counts.toCounts(bitOrder == BitOrder::MSB));
+}
+
+std::vector<double> AcceleratorBuffer::getParityExpectationValues(
+    const std::vector<std::vector<int>> &measIdxs, BitOrder bitOrder) {
+  // Identity terms (no bits) have an expectation of 1, with or without counts
+  if (std::all_of(measIdxs.begin(), measIdxs.end(),
+                  [](const auto &bits) { return bits.empty(); })) {
+    return std::vector<double>(measIdxs.size(), 1.0);
+  }
+  if (bitStringToCounts.empty()) {
+    xacc::error("called getParityExpectationValues() on an AcceleratorBuffer "
+                "with no measurements!");
+    return {};
   }
 
-  return result;
+  const auto packedCounts = getPackedCounts(bitOrder);
+  std::vector<std::vector<PackedCounts::Word>> masks;
+  masks.reserve(measIdxs.size());
+  for (const auto &bits : measIdxs) {
+    masks.emplace_back(packedCounts.mask(bits));
+  }
+  return packedCounts.parityExpectations(masks);
 }
 /**
  * Print information about this AcceleratorBuffer to standard out.
@@ -19,6 +19,7 @@
 #include <iostream>
 #include "Utils.hpp"
 #include "heterogeneous.hpp"
+#include "PackedCounts.hpp"
 
 namespace xacc {
 
@@ -196,6 +197,17 @@ public:
   getMarginalCounts(const std::vector<int> &measIdxs,
                     BitOrder bitOrder = BitOrder::MSB);
 
+  // Packed (bit-parallel) copy of the measurement counts,
+  // bit i is the bit at index i of the bit strings (see getMarginalCounts).
+  virtual PackedCounts getPackedCounts(BitOrder bitOrder = BitOrder::MSB);
+  virtual void setPackedMeasurements(const PackedCounts &counts,
+                                     BitOrder bitOrder = BitOrder::MSB);
+  // Expectation values of Z...Z on lists of bit indices, i.e. the
+  // parity of the marginal counts, computed in one pass over the counts.
+  virtual std::vector<double>
+  getParityExpectationValues(const std::vector<std::vector<int>> &measIdxs,
+                             BitOrder bitOrder = BitOrder::MSB);
+
   virtual void clearMeasurements() {
     // measurements.clear();
     bitStringToCounts.clear();
@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#include "PackedCounts.hpp"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+namespace {
+using Word = xacc::PackedCounts::Word;
+// Entries are processed in tiles: the tile of parity words stays in cache
+// while all the words (and masks) are folded into it.
+constexpr std::size_t TILE_SIZE = 1024;
+
+inline int parity(Word x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_parityll(x);
+#else
+  x ^= x >> 32;
+  x ^= x >> 16;
+  x ^= x >> 8;
+  x ^= x >> 4;
+  x ^= x >> 2;
+  x ^= x >> 1;
+  return x & 1;
+#endif
+}
+
+struct WordsHash {
+  std::size_t operator()(const std::vector<Word> &words) const {
+    std::size_t seed = words.size();
+    for (const auto &w : words) {
+      seed ^= std::hash<Word>()(w) + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+              (seed >> 2);
+    }
+    return seed;
+  }
+};
+} // namespace
+
+namespace xacc {
+PackedCounts::PackedCounts(int nBits)
+    : m_nBits(nBits), m_words((nBits + WORD_BITS - 1) / WORD_BITS) {}
+
+PackedCounts PackedCounts::fromCounts(const std::map<std::string, int> &counts,
+                                      bool msbFirst) {
+  std::size_t maxLength = 0;
+  for (const auto &[bitString, count] : counts) {
+    maxLength = std::max(maxLength, bitString.size());
+  }
+
+  PackedCounts result(maxLength);
+  result.reserve(counts.size());
+  for (const auto &[bitString, count] : counts) {
+    result.append(bitString, count, msbFirst);
+  }
+  return result;
+}
+
+bool PackedCounts::bit(int bitIdx, std::size_t i) const {
+  if (bitIdx < 0 || bitIdx >= m_nBits) {
+    return false;
+  }
+  return (m_words[bitIdx / WORD_BITS][i] >> (bitIdx % WORD_BITS)) & 1;
+}
+
+void PackedCounts::append(const std::string &bitString, std::uint64_t count,
+                          bool msbFirst) {
+  assert(bitString.size() <= m_nBits);
+  const int length = bitString.size();
+  for (auto &words : m_words) {
+    words.emplace_back(0);
+  }
+
+  for (int pos = 0; pos < length; ++pos) {
+    if (bitString[pos] == '1') {
+      const int bitIdx = msbFirst ? length - 1 - pos : pos;
+      m_words[bitIdx / WORD_BITS].back() |= Word(1) << (bitIdx % WORD_BITS);
+    }
+  }
+  m_counts.emplace_back(count);
+  m_totalCounts += count;
+}
+
+void PackedCounts::append(const std::vector<Word> &bits, std::uint64_t count) {
+  assert(bits.size() == m_words.size());
+  for (int w = 0; w < m_words.size(); ++w) {
+    m_words[w].emplace_back(bits[w]);
+  }
+  m_counts.emplace_back(count);
+  m_totalCounts += count;
+}
+
+void PackedCounts::reserve(std::size_t n) {
+  for (auto &words : m_words) {
+    words.reserve(n);
+  }
+  m_counts.reserve(n);
+}
+
+void PackedCounts::clear() {
+  for (auto &words : m_words) {
+    words.clear();
+  }
+  m_counts.clear();
+  m_totalCounts = 0;
+}
+
+std::vector<PackedCounts::Word>
+PackedCounts::mask(const std::vector<int> &bitIdxs) const {
+  std::vector<Word> result(m_words.size(), 0);
+  for (const auto &bitIdx : bitIdxs) {
+    if (bitIdx >= 0 && bitIdx < m_nBits) {
+      result[bitIdx / WORD_BITS] |= Word(1) << (bitIdx % WORD_BITS);
+    }
+  }
+  return result;
+}
+
+double PackedCounts::parityExpectation(const std::vector<Word> &mask) const {
+  return parityExpectations({mask})[0];
+}
+
+double PackedCounts::parityExpectation() const {
+  std::vector<Word> allBits(m_words.size(), ~Word(0));
+  if (!allBits.empty() && m_nBits % WORD_BITS != 0) {
+    allBits.back() = (Word(1) << (m_nBits % WORD_BITS)) - 1;
+  }
+  return parityExpectation(allBits);
+}
+
+std::vector<double> PackedCounts::parityExpectations(
+    const std::vector<std::vector<Word>> &masks) const {
+  const auto nbEntries = m_counts.size();
+  const int nbWords = m_words.size();
+  std::vector<std::int64_t> sums(masks.size(), 0);
+  Word folded[TILE_SIZE];
+  for (std::size_t begin = 0; begin < nbEntries; begin += TILE_SIZE) {
+    const std::size_t tileSize = std::min(TILE_SIZE, nbEntries - begin);
+    const std::uint64_t *counts = m_counts.data() + begin;
+    for (int m = 0; m < masks.size(); ++m) {
+      const auto &mask = masks[m];
+      assert(mask.size() == nbWords);
+      // Fold the masked words: parity(x & m) ^ parity(y & n) = parity((x & m) ^ (y & n))
+      std::fill(folded, folded + tileSize, 0);
+      for (int w = 0; w < nbWords; ++w) {
+        if (mask[w] == 0) {
+          continue;
+        }
+        const Word maskWord = mask[w];
+        const Word *words = m_words[w].data() + begin;
+        for (std::size_t i = 0; i < tileSize; ++i) {
+          folded[i] ^= words[i] & maskWord;
+        }
+      }
+      // Even parity: +count, odd parity: -count
+      std::int64_t sum = 0;
+      for (std::size_t i = 0; i < tileSize; ++i) {
+        const std::int64_t count = counts[i];
+        sum += count - 2 * count * parity(folded[i]);
+      }
+      sums[m] += sum;
+    }
+  }
+
+  std::vector<double> result(masks.size(), 0.0);
+  if (m_totalCounts > 0) {
+    for (int m = 0; m < masks.size(); ++m) {
+      result[m] = static_cast<double>(sums[m]) / m_totalCounts;
+    }
+  }
+  return result;
+}
+
+PackedCounts PackedCounts::marginal(const std::vector<int> &bitIdxs) const {
+  PackedCounts result(bitIdxs.size());
+  const auto nbEntries = m_counts.size();
+  const int nbWords = result.m_words.size();
+  std::vector<Word> key(nbWords);
+  const auto extract = [&](std::size_t i) {
+    std::fill(key.begin(), key.end(), 0);
+    for (int k = 0; k < bitIdxs.size(); ++k) {
+      if (bit(bitIdxs[k], i)) {
+        key[k / WORD_BITS] |= Word(1) << (k % WORD_BITS);
+      }
+    }
+  };
+
+  // Merge the entries that have the same marginal bits
+  if (nbWords <= 1) {
+    std::unordered_map<Word, std::size_t> keyToIdx;
+    for (std::size_t i = 0; i < nbEntries; ++i) {
+      extract(i);
+      const Word singleKey = nbWords == 0 ? 0 : key[0];
+      const auto iter = keyToIdx.find(singleKey);
+      if (iter == keyToIdx.end()) {
+        keyToIdx.emplace(singleKey, result.size());
+        result.append(key, m_counts[i]);
+      } else {
+        result.m_counts[iter->second] += m_counts[i];
+        result.m_totalCounts += m_counts[i];
+      }
+    }
+  } else {
+    std::unordered_map<std::vector<Word>, std::size_t, WordsHash> keyToIdx;
+    for (std::size_t i = 0; i < nbEntries; ++i) {
+      extract(i);
+      const auto iter = keyToIdx.find(key);
+      if (iter == keyToIdx.end()) {
+        keyToIdx.emplace(key, result.size());
+        result.append(key, m_counts[i]);
+      } else {
+        result.m_counts[iter->second] += m_counts[i];
+        result.m_totalCounts += m_counts[i];
+      }
+    }
+  }
+  return result;
+}
+
+std::map<std::string, int> PackedCounts::toCounts(bool msbFirst) const {
+  std::map<std::string, int> result;
+  for (std::size_t i = 0; i < m_counts.size(); ++i) {
+    std::string bitString(m_nBits, '0');
+    for (int bitIdx = 0; bitIdx < m_nBits; ++bitIdx) {
+      if (bit(bitIdx, i)) {
+        bitString[msbFirst ? m_nBits - 1 - bitIdx : bitIdx] = '1';
+      }
+    }
+    result[bitString] += m_counts[i];
+  }
+  return result;
+}
+} // namespace xacc
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *******************************************************************************/
+#ifndef XACC_ACCELERATOR_PACKEDCOUNTS_HPP_
+#define XACC_ACCELERATOR_PACKEDCOUNTS_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xacc {
+
+// Packed representation of measurement counts:
+// each distinct bit string is stored as a multi-word (64-bit) bit vector,
+// with the counts in a separate array.
+//
+// The words are stored word-major (all first words, then all second words,
+// etc.), hence parity reductions over a Z-mask, i.e. (-1)^popcount(bits & mask),
+// are tight, vectorizable loops over contiguous arrays rather than
+// string scans.
+//
+// Bit i of an entry is the measurement result of (classical) bit i.
+// When packing bit strings, msbFirst specifies where bit 0 is:
+// the last character (msbFirst = true, default) or the first one.
+class PackedCounts {
+public:
+  using Word = std::uint64_t;
+  static constexpr int WORD_BITS = 64;
+
+  PackedCounts(int nBits = 0);
+  static PackedCounts fromCounts(const std::map<std::string, int> &counts,
+                                 bool msbFirst = true);
+
+  int nBits() const { return m_nBits; }
+  int nWords() const { return m_words.size(); }
+  // Number of distinct bit strings
+  std::size_t size() const { return m_counts.size(); }
+  bool empty() const { return m_counts.empty(); }
+  std::uint64_t totalCounts() const { return m_totalCounts; }
+  const std::vector<std::uint64_t> &counts() const { return m_counts; }
+  // Word w of the entry i
+  Word word(int w, std::size_t i) const { return m_words[w][i]; }
+  bool bit(int bitIdx, std::size_t i) const;
+
+  // Note: entries are not merged, appending the same bit string twice
+  // creates two entries (the reductions are still correct).
+  void append(const std::string &bitString, std::uint64_t count,
+              bool msbFirst = true);
+  void append(const std::vector<Word> &bits, std::uint64_t count);
+  void reserve(std::size_t n);
+  void clear();
+
+  // Z-mask of a list of bit indices (bits >= nBits() are ignored)
+  std::vector<Word> mask(const std::vector<int> &bitIdxs) const;
+  // sum_i counts[i] * (-1)^popcount(bits[i] & mask) / totalCounts
+  double parityExpectation(const std::vector<Word> &mask) const;
+  // Same, for a batch of masks: each entry is loaded once for all masks.
+  std::vector<double>
+  parityExpectations(const std::vector<std::vector<Word>> &masks) const;
+  // Expectation value of Z...Z on all bits
+  double parityExpectation() const;
+
+  // Marginal counts on the given bits:
+  // bit k of the result is bit bitIdxs[k] of this (duplicates are merged).
+  PackedCounts marginal(const std::vector<int> &bitIdxs) const;
+
+  std::map<std::string, int> toCounts(bool msbFirst = true) const;
+
+private:
+  int m_nBits;
+  // m_words[w][i]: word w of the entry i
+  std::vector<std::vector<Word>> m_words;
+  std::vector<std::uint64_t> m_counts;
+  std::uint64_t m_totalCounts = 0;
+};
+} // namespace xacc
+#endif
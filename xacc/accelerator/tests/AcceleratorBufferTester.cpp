@@ -14,6 +14,7 @@
 
 #include "AcceleratorBuffer.hpp"
 #include <cmath>
+#include <numeric>
 using namespace xacc;
 
 TEST(AcceleratorBufferTester, checkGetExpectationValueZ) {
@@ -289,6 +290,96 @@ TEST(AcceleratorBufferTester, checkMarginalCount) {
   }
 }
 
+TEST(AcceleratorBufferTester, checkPackedCounts) {
+  // Multi-word (100-bit) bit strings
+  const int nBits = 100;
+  std::map<std::string, int> counts;
+  std::srand(12345);
+  for (int i = 0; i < 500; ++i) {
+    std::string bitString(nBits, '0');
+    for (auto &c : bitString) {
+      c = (std::rand() % 2) ? '1' : '0';
+    }
+    counts[bitString] += 1 + std::rand() % 100;
+  }
+
+  AcceleratorBuffer buffer("qreg", nBits);
+  buffer.setMeasurements(counts);
+
+  // Reference: string-based parity of the marginal bits
+  const auto expectedParity = [&](const std::vector<int> &bits,
+                                  AcceleratorBuffer::BitOrder bitOrder) {
+    double sum = 0.0;
+    int total = 0;
+    for (const auto &[bitString, count] : counts) {
+      int nbOnes = 0;
+      for (const auto &bit : bits) {
+        const auto c = bitOrder == AcceleratorBuffer::BitOrder::MSB
+                           ? bitString[bitString.size() - 1 - bit]
+                           : bitString[bit];
+        nbOnes += (c == '1');
+      }
+      sum += (nbOnes % 2 == 0) ? count : -count;
+      total += count;
+    }
+    return sum / total;
+  };
+
+  const std::vector<std::vector<int>> masks{
+      {0}, {63}, {64}, {99}, {0, 1}, {3, 70, 99}, {10, 20, 30, 40, 50, 60, 70}};
+  for (const auto bitOrder : {AcceleratorBuffer::BitOrder::MSB,
+                              AcceleratorBuffer::BitOrder::LSB}) {
+    const auto expVals = buffer.getParityExpectationValues(masks, bitOrder);
+    EXPECT_EQ(expVals.size(), masks.size());
+    for (int i = 0; i < masks.size(); ++i) {
+      EXPECT_NEAR(expVals[i], expectedParity(masks[i], bitOrder), 1e-12);
+    }
+  }
+
+  // All-bit parity
+  std::vector<int> allBits(nBits);
+  std::iota(allBits.begin(), allBits.end(), 0);
+  EXPECT_NEAR(buffer.getExpectationValueZ(),
+              expectedParity(allBits, AcceleratorBuffer::BitOrder::MSB), 1e-12);
+
+  // Round trip and marginals
+  const auto packed = buffer.getPackedCounts();
+  EXPECT_EQ(packed.nBits(), nBits);
+  EXPECT_EQ(packed.nWords(), 2);
+  EXPECT_EQ(packed.size(), counts.size());
+  EXPECT_EQ(packed.toCounts(), counts);
+  const std::vector<int> marginalBits{5, 64, 99};
+  const auto marginal = buffer.getMarginalCounts(marginalBits);
+  int marginalTotal = 0;
+  for (const auto &[bitString, count] : marginal) {
+    EXPECT_EQ(bitString.size(), marginalBits.size());
+    marginalTotal += count;
+  }
+  EXPECT_EQ(marginalTotal, packed.totalCounts());
+  EXPECT_LE(marginal.size(), 8);
+  EXPECT_NEAR(
+      PackedCounts::fromCounts(marginal, false).parityExpectation(),
+      expectedParity(marginalBits, AcceleratorBuffer::BitOrder::MSB), 1e-12);
+
+  AcceleratorBuffer other("qreg", nBits);
+  other.setPackedMeasurements(packed);
+  EXPECT_EQ(other.getMeasurementCounts(), counts);
+}
+
+TEST(AcceleratorBufferTester, checkIdentityParity) {
+  // No counts needed for identity terms
+  AcceleratorBuffer buffer("qreg", 2);
+  EXPECT_EQ(std::vector<double>({1.0, 1.0}),
+            buffer.getParityExpectationValues({{}, {}}));
+  EXPECT_TRUE(buffer.getParityExpectationValues({}).empty());
+
+  buffer.setMeasurements({{"01", 300}, {"10", 100}});
+  const auto expVals = buffer.getParityExpectationValues({{}, {0}, {0, 1}});
+  EXPECT_NEAR(1.0, expVals[0], 1e-12);
+  EXPECT_NEAR(-0.5, expVals[1], 1e-12);
+  EXPECT_NEAR(-1.0, expVals[2], 1e-12);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -16,6 +16,7 @@
 #include "Identifiable.hpp"
 #include "Instruction.hpp"
 #include "Cloneable.hpp"
+#include "PropertyStore.hpp"
 
 namespace xacc {
 
@@ -36,7 +37,9 @@ public:
   virtual void setVertexProperties(const int index, HeterogeneousMap& properties) = 0;
   virtual void setVertexProperties(const int index, HeterogeneousMap&& properties) = 0;
 
-  virtual HeterogeneousMap& getVertexProperties(const int index) = 0;
+  // Vertex properties are kept in a PropertyStore, which exposes the
+  // HeterogeneousMap accessors as well as faster PropertyKey lookups.
+  virtual PropertyStore& getVertexProperties(const int index) = 0;
 
   virtual void setEdgeWeight(const int srcIndex, const int tgtIndex,
                      const double weight) = 0;
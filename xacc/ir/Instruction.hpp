@@ -17,6 +17,7 @@
 #include "Cloneable.hpp"
 #include "InstructionVisitor.hpp"
 #include "heterogeneous.hpp"
+#include "PropertyStore.hpp"
 #include <limits>
 
 namespace xacc {
@@ -102,17 +103,19 @@ class Instruction : public BaseInstructionVisitable,
                     public Identifiable,
                     public Cloneable<Instruction> {
 protected:
-  HeterogeneousMap metadata;
+  PropertyStore metadata;
 
 public:
   // Instructions can carry domain-specific metadata as a 
   // key-value dictionary of information. Here we provide 
   // a method for attaching metadata
   virtual void attachMetadata(HeterogeneousMap&& m) {
-    metadata = m;
+    metadata = PropertyStore(m);
   }
   // Retrieve this intruction's metadata. 
-  virtual HeterogeneousMap getMetadata() {return metadata;}
+  virtual HeterogeneousMap getMetadata() {return metadata.toHeterogeneousMap();}
+  // Typed (no copy) access to the metadata, e.g. for IR passes.
+  const PropertyStore& getMetadataStore() const { return metadata; }
 
   virtual void applyRuntimeArguments() = 0;
   virtual void addArgument(std::shared_ptr<CompositeArgument> arg,
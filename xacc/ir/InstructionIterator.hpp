@@ -20,6 +20,11 @@ namespace xacc {
 /**
  * The InstructionIterator provides a mechanism for
  * a pre-order traversal of an Instruction tree.
+ *
+ * The children of a composite are only retrieved when the traversal
+ * proceeds past it (i.e. at the next call to hasNext() or next()), hence
+ * clients can act on a composite as a whole (e.g. apply a repeated block
+ * as a single fused operation) and disable it to skip its sub-tree.
  */
 class InstructionIterator {
 
@@ -34,6 +39,25 @@ protected:
    */
   std::stack<std::shared_ptr<Instruction>> instStack;
 
+  /**
+   * The last returned Instruction, whose children
+   * haven't been pushed to the stack yet.
+   */
+  std::shared_ptr<Instruction> pending;
+
+  void expandPending() {
+    if (!pending) {
+      return;
+    }
+    auto f = std::dynamic_pointer_cast<CompositeInstruction>(pending);
+    pending.reset();
+    if (f) {
+      for (int i = f->nInstructions() - 1; i >= 0; i--) {
+        instStack.push(f->getInstruction(i));
+      }
+    }
+  }
+
 public:
   /**
    * The constructor, takes the root of the tree
@@ -49,21 +73,20 @@ public:
    * Return true if there are still instructions left to traverse.
    * @return
    */
-  bool hasNext() { return !instStack.empty(); }
+  bool hasNext() {
+    expandPending();
+    return !instStack.empty();
+  }
 
   /**
    * Return the next Instruction in the tree.
    * @return
    */
   std::shared_ptr<Instruction> next() {
+    expandPending();
     std::shared_ptr<Instruction> next = instStack.top();
     instStack.pop();
-    auto f = std::dynamic_pointer_cast<CompositeInstruction>(next);
-    if (f) {
-      for (int i = f->nInstructions() - 1; i >= 0; i--) {
-        instStack.push(f->getInstruction(i));
-      }
-    }
+    pending = next;
     return next;
   }
 };
@@ -66,25 +66,25 @@ void DirectedBoostGraph::addVertex() { add_vertex(*_graph.get()); }
 void DirectedBoostGraph::addVertex(
     HeterogeneousMap &&properties) {
   auto v = add_vertex(*_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 void DirectedBoostGraph::addVertex(
     HeterogeneousMap &properties) {
   auto v = add_vertex(*_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 void DirectedBoostGraph::setVertexProperties(
     const int index,
     HeterogeneousMap &&properties) {
   auto v = vertex(index, *_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 void DirectedBoostGraph::setVertexProperties(
     const int index, HeterogeneousMap &properties) {
   auto v = vertex(index, *_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 // void DirectedBoostGraph::setVertexProperty(const int index,
@@ -108,7 +108,7 @@ void DirectedBoostGraph::setVertexProperties(
 //   }
 //   return;
 // }
-HeterogeneousMap&
+PropertyStore&
 DirectedBoostGraph::getVertexProperties(const int index) {
   return (*_graph.get())[index].properties;
 }
@@ -14,7 +14,7 @@
 #define XACC_UTILS_IGRAPH_HPP_
 
 #include "Graph.hpp"
-#include "heterogeneous.hpp"
+#include "PropertyStore.hpp"
 #include <memory>
 #include <sstream>
 #include "Utils.hpp"
@@ -34,7 +34,7 @@ namespace xacc {
 
 class DirectedBoostVertex {
 public:
-  HeterogeneousMap properties;
+  PropertyStore properties;
 };
 using d_adj_list = adjacency_list<vecS, vecS, directedS, DirectedBoostVertex,
                                 boost::property<boost::edge_weight_t, double>>;
@@ -109,7 +109,7 @@ public:
 //   void setVertexProperty(const int index, const std::string prop,
                         //  InstructionParameter &p) override;
 
-  HeterogeneousMap&
+  PropertyStore&
   getVertexProperties(const int index) override;
 //   virtual InstructionParameter &
 //   getVertexProperty(const int index, const std::string property) override;
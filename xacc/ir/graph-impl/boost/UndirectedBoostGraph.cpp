@@ -68,25 +68,25 @@ void UndirectedBoostGraph::addVertex() { add_vertex(*_graph.get()); }
 void UndirectedBoostGraph::addVertex(
     HeterogeneousMap &&properties) {
   auto v = add_vertex(*_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 void UndirectedBoostGraph::addVertex(
     HeterogeneousMap &properties) {
   auto v = add_vertex(*_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 void UndirectedBoostGraph::setVertexProperties(
     const int index,
     HeterogeneousMap &&properties) {
   auto v = vertex(index, *_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 void UndirectedBoostGraph::setVertexProperties(
     const int index, HeterogeneousMap &properties) {
   auto v = vertex(index, *_graph.get());
-  (*_graph.get())[v].properties = properties;
+  (*_graph.get())[v].properties = PropertyStore(properties);
 }
 
 // void UndirectedBoostGraph::setVertexProperty(const int index,
@@ -111,7 +111,7 @@ void UndirectedBoostGraph::setVertexProperties(
 //   }
 //   return;
 // }
-HeterogeneousMap&
+PropertyStore&
 UndirectedBoostGraph::getVertexProperties(const int index) {
   return (*_graph.get())[index].properties;
 }
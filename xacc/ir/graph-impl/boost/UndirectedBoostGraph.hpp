@@ -34,7 +34,7 @@ namespace xacc {
 
 class UndirectedBoostVertex {
 public:
-  HeterogeneousMap properties;
+  PropertyStore properties;
 };
 using u_adj_list = adjacency_list<vecS, vecS, undirectedS, UndirectedBoostVertex,
                                 boost::property<boost::edge_weight_t, double>>;
@@ -131,7 +131,7 @@ public:
 //   void setVertexProperty(const int index, const std::string prop,
 //                          InstructionParameter &p) override;
 
-  HeterogeneousMap&
+  PropertyStore&
   getVertexProperties(const int index) override;
 //   virtual InstructionParameter &
 //   getVertexProperty(const int index, const std::string property) override;
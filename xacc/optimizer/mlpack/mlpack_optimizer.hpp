@@ -17,6 +17,7 @@
 #include <utility>
 
 #include "Optimizer.hpp"
+#include "Cloneable.hpp"
 #include <armadillo>
 #include <ensmallen.hpp>
 
@@ -64,7 +65,7 @@ public:
   }
 };
 
-class MLPACKOptimizer : public Optimizer {
+class MLPACKOptimizer : public Optimizer, public Cloneable<Optimizer> {
 public:
   MLPACKOptimizer() = default;
   OptResult optimize(OptFunction &function) override;
@@ -73,6 +74,14 @@ public:
 
   const std::string name() const override { return "mlpack"; }
   const std::string description() const override { return ""; }
+
+  // Copy with the same options, e.g. to run several optimizations at once.
+  // The service itself is not cloned, getOptimizer() returns the registered
+  // instance.
+  std::shared_ptr<Optimizer> clone() override {
+    return std::make_shared<MLPACKOptimizer>(*this);
+  }
+  bool shouldClone() override { return false; }
 };
 } // namespace xacc
 #endif
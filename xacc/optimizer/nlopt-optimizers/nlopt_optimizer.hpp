@@ -17,6 +17,7 @@
 #include <utility>
 
 #include "Optimizer.hpp"
+#include "Cloneable.hpp"
 
 namespace xacc {
 
@@ -24,7 +25,7 @@ struct ExtraNLOptData {
     std::function<double(const std::vector<double>&, std::vector<double>&)> f;
 };
 
-class NLOptimizer : public Optimizer {
+class NLOptimizer : public Optimizer, public Cloneable<Optimizer> {
 public:
   OptResult optimize(OptFunction &function) override;
   const bool isGradientBased() const override;
@@ -32,6 +33,14 @@ public:
 
   const std::string name() const override { return "nlopt"; }
   const std::string description() const override { return ""; }
+
+  // Copy with the same options, e.g. to run several optimizations at once.
+  // The service itself is not cloned, getOptimizer() returns the registered
+  // instance.
+  std::shared_ptr<Optimizer> clone() override {
+    return std::make_shared<NLOptimizer>(*this);
+  }
+  bool shouldClone() override { return false; }
 };
 } // namespace xacc
 #endif
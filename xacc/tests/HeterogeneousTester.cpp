@@ -12,6 +12,7 @@
  *******************************************************************************/
 #include "CompositeInstruction.hpp"
 #include "heterogeneous.hpp"
+#include "PropertyStore.hpp"
 #include <gtest/gtest.h>
 #include <stdexcept>
 #include "xacc.hpp"
@@ -178,6 +179,40 @@ TEST(HeterogeneousMapTester, checkMerge) {
   c.visit(v);
 }
 
+TEST(HeterogeneousMapTester, checkPropertyStore) {
+  static const xacc::PropertyKey<std::size_t> ID("id");
+  static const xacc::PropertyKey<std::string> NAME("name");
+  xacc::PropertyStore store;
+  store.set(ID, std::size_t(3));
+  store.set(NAME, std::string("CNOT"));
+  store.insert("layer", 1);
+  store.insert("label", "ctrl");
+  EXPECT_EQ(store.size(), 4);
+  EXPECT_EQ(store.get(ID), 3);
+  EXPECT_EQ(store.get(NAME), "CNOT");
+  // Typed keys and string keys are interchangeable
+  EXPECT_EQ(store.get<std::size_t>("id"), 3);
+  EXPECT_EQ(store.getString("name"), "CNOT");
+  EXPECT_EQ(store.getString("label"), "ctrl");
+  EXPECT_TRUE(store.keyExists<int>("layer"));
+  EXPECT_FALSE(store.keyExists<double>("layer"));
+  EXPECT_EQ(store.find(xacc::PropertyKey<int>("id")), nullptr);
+  // Update in place
+  store.insert("layer", 2);
+  EXPECT_EQ(store.get<int>("layer"), 2);
+  EXPECT_EQ(store.size(), 4);
+
+  // Round trip to/from the user-facing map
+  auto map = store.toHeterogeneousMap();
+  EXPECT_EQ(map.get<std::size_t>("id"), 3);
+  EXPECT_EQ(map.getString("name"), "CNOT");
+  xacc::PropertyStore fromMap(map);
+  EXPECT_EQ(fromMap.get(ID), 3);
+  EXPECT_EQ(fromMap.get<int>("layer"), 2);
+  print_visitor v;
+  fromMap.visit(v);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
   ::testing::InitGoogleTest(&argc, argv);
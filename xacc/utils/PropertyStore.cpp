@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#include "PropertyStore.hpp"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+// Name <-> id registry. Names are stored in a deque so that the references
+// returned by name() remain valid while new names are interned.
+class InternTable {
+public:
+  std::uint32_t intern(const std::string &name) {
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      auto iter = ids.find(name);
+      if (iter != ids.end()) {
+        return iter->second;
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto iter = ids.find(name);
+    if (iter != ids.end()) {
+      return iter->second;
+    }
+    const auto id = static_cast<std::uint32_t>(names.size());
+    names.emplace_back(name);
+    ids.emplace(name, id);
+    return id;
+  }
+
+  const std::string &name(std::uint32_t id) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.at(id);
+  }
+
+private:
+  std::shared_mutex mutex;
+  std::unordered_map<std::string, std::uint32_t> ids;
+  std::deque<std::string> names;
+};
+
+InternTable &keyTable() {
+  static InternTable table;
+  return table;
+}
+
+InternTable &typeTable() {
+  static InternTable table;
+  return table;
+}
+} // namespace
+
+namespace xacc {
+PropertyKeyId internPropertyKey(const std::string &name) {
+  return keyTable().intern(name);
+}
+
+const std::string &propertyKeyName(PropertyKeyId id) {
+  return keyTable().name(id);
+}
+
+PropertyTypeId internPropertyType(const char *typeName) {
+  // Some ABIs mark type names which are not merged across libraries
+  // with a leading '*'.
+  if (typeName[0] == '*') {
+    ++typeName;
+  }
+  return typeTable().intern(typeName);
+}
+} // namespace xacc
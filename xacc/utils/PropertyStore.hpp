@@ -0,0 +1,219 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_PROPERTY_STORE_HPP_
+#define XACC_PROPERTY_STORE_HPP_
+
+#include "heterogeneous.hpp"
+#include <cstdint>
+#include <typeinfo>
+
+namespace xacc {
+// Property key names and value types are interned once into small integer
+// ids (process-wide, i.e. shared by all plugins), hence lookups and type
+// checks are integer comparisons.
+using PropertyKeyId = std::uint32_t;
+using PropertyTypeId = std::uint32_t;
+PropertyKeyId internPropertyKey(const std::string &name);
+const std::string &propertyKeyName(PropertyKeyId id);
+PropertyTypeId internPropertyType(const char *typeName);
+
+// Type names are compared (once per type and per library) at interning,
+// which also makes the ids consistent across plugin boundaries.
+template <typename T> PropertyTypeId propertyTypeId() {
+  static const PropertyTypeId id = internPropertyType(typeid(T).name());
+  return id;
+}
+
+// Compile-time typed key, e.g.
+//   static const PropertyKey<std::size_t> ID("id");
+//   auto id = store.get(ID);
+template <typename T> class PropertyKey {
+public:
+  using value_type = T;
+  explicit PropertyKey(const std::string &name)
+      : keyId(internPropertyKey(name)) {}
+  PropertyKeyId id() const { return keyId; }
+  const std::string &name() const { return propertyKeyName(keyId); }
+
+private:
+  PropertyKeyId keyId;
+};
+
+// Flat key-value property store for the IR hot paths (graph vertices,
+// instruction metadata): a handful of entries per object, looked up by
+// interned key id and type id.
+//
+// The string-keyed methods mirror HeterogeneousMap (which remains the
+// user-facing API) so both can be used interchangeably; prefer the
+// PropertyKey overloads in loops.
+class PropertyStore {
+public:
+  PropertyStore() = default;
+  explicit PropertyStore(const HeterogeneousMap &map) {
+    entries.reserve(map.items.size());
+    for (const auto &[key, value] : map.items) {
+      entries.push_back({internPropertyKey(key),
+                         internPropertyType(value.type().name()), value});
+    }
+  }
+
+  HeterogeneousMap toHeterogeneousMap() const {
+    HeterogeneousMap map;
+    for (const auto &entry : entries) {
+      map.items[propertyKeyName(entry.key)] = entry.value;
+    }
+    return map;
+  }
+
+  // Typed API
+  template <typename T> void set(const PropertyKey<T> &key, T value) {
+    setImpl<T>(key.id(), std::move(value));
+  }
+  // Returns nullptr if the key doesn't exist or has another type.
+  template <typename T> const T *find(const PropertyKey<T> &key) const {
+    return findImpl<T>(key.id());
+  }
+  template <typename T> bool contains(const PropertyKey<T> &key) const {
+    return find(key) != nullptr;
+  }
+  template <typename T> const T &get(const PropertyKey<T> &key) const {
+    const auto *value = find(key);
+    if (!value) {
+      emit_error("PropertyStore::get() error - Invalid type or key (" +
+                 key.name() + ").");
+    }
+    return *value;
+  }
+
+  // HeterogeneousMap-compatible API
+  template <class T> void insert(const std::string key, const T &_t) {
+    using ValueType = std::decay_t<const T &>;
+    setImpl<ValueType>(internPropertyKey(key), _t);
+  }
+
+  template <typename T> const T get(const std::string key) const {
+    const auto *value = findImpl<T>(internPropertyKey(key));
+    if (!value) {
+      emit_error("PropertyStore::get() error - Invalid type or key (" + key +
+                 ").");
+      return T();
+    }
+    return *value;
+  }
+
+  template <typename T> bool keyExists(const std::string key) const {
+    return findImpl<T>(internPropertyKey(key)) != nullptr;
+  }
+
+  bool key_exists_any_type(const std::string key) const {
+    return findEntry(internPropertyKey(key)) != nullptr;
+  }
+
+  bool stringExists(const std::string key) const {
+    return keyExists<std::string>(key) || keyExists<const char *>(key);
+  }
+
+  const std::string getString(const std::string key) const {
+    const auto keyId = internPropertyKey(key);
+    if (const auto *value = findImpl<std::string>(keyId)) {
+      return *value;
+    }
+    if (const auto *value = findImpl<const char *>(keyId)) {
+      return *value;
+    }
+    emit_error("No string-like value at provided key (" + key + ").");
+    return "";
+  }
+
+  template <typename T>
+  const T get_or_default(const std::string &key, const T _default) const {
+    const auto *value = findImpl<T>(internPropertyKey(key));
+    return value ? *value : _default;
+  }
+
+  size_t size() const { return entries.size(); }
+  void clear() { entries.clear(); }
+
+  template <class T> void visit(T &&visitor) const {
+    visit_impl(visitor, typename std::decay_t<T>::types{});
+  }
+
+private:
+  struct Entry {
+    PropertyKeyId key;
+    PropertyTypeId type;
+    std::any value;
+  };
+  std::vector<Entry> entries;
+
+  const Entry *findEntry(PropertyKeyId key) const {
+    for (const auto &entry : entries) {
+      if (entry.key == key) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename T> const T *findImpl(PropertyKeyId key) const {
+    const auto *entry = findEntry(key);
+    if (!entry || entry->type != propertyTypeId<T>()) {
+      return nullptr;
+    }
+    return valuePtr<T>(*entry);
+  }
+
+  template <typename T> static const T *valuePtr(const Entry &entry) {
+    // The type ids match: this only fails if the value was created in
+    // another library with a different type_info instance.
+    if (const auto *value = std::any_cast<T>(&entry.value)) {
+      return value;
+    }
+#ifdef APPLY_RTTI_ANY_CAST_FIX
+    return __internal::force_cast_ptr<T>(entry.value);
+#else
+    return nullptr;
+#endif
+  }
+
+  template <typename T> void setImpl(PropertyKeyId key, T value) {
+    for (auto &entry : entries) {
+      if (entry.key == key) {
+        entry.type = propertyTypeId<T>();
+        entry.value = std::move(value);
+        return;
+      }
+    }
+    entries.push_back({key, propertyTypeId<T>(), std::move(value)});
+  }
+
+  template <class V, class HEAD, class... TAIL>
+  static void try_visit(V &visitor, const Entry &entry) {
+    if (entry.type == propertyTypeId<HEAD>()) {
+      if (const auto *value = valuePtr<HEAD>(entry)) {
+        visitor(propertyKeyName(entry.key), *value);
+      }
+    } else if constexpr (sizeof...(TAIL) > 0) {
+      try_visit<V, TAIL...>(visitor, entry);
+    }
+  }
+
+  template <class V, class... U>
+  void visit_impl(V &&visitor, xacc::type_list<U...>) const {
+    for (const auto &entry : entries) {
+      try_visit<std::decay_t<V>, U...>(visitor, entry);
+    }
+  }
+};
+} // namespace xacc
+#endif
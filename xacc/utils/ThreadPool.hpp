@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (c) 2020 UT-Battelle, LLC.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompanies this
+ * distribution. The Eclipse Public License is available at
+ * http://www.eclipse.org/legal/epl-v10.html and the Eclipse Distribution
+ *License is available at https://eclipse.org/org/documents/edl-v10.php
+ *
+ * Contributors:
+ *   Thien Nguyen - initial API and implementation
+ *******************************************************************************/
+#ifndef XACC_UTILS_THREADPOOL_HPP_
+#define XACC_UTILS_THREADPOOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace xacc {
+// Simple fixed-size thread pool.
+// Tasks are submitted with enqueue(), which returns a std::future
+// for the task's result. The destructor drains the queue and joins
+// all worker threads.
+class ThreadPool {
+public:
+  // nThreads = 0: use the hardware concurrency.
+  explicit ThreadPool(std::size_t nThreads = 0) {
+    if (nThreads == 0) {
+      nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(nThreads);
+    for (std::size_t i = 0; i < nThreads; ++i) {
+      workers.emplace_back([this] {
+        for (;;) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            condition.wait(lock, [this] { return stop || !tasks.empty(); });
+            if (stop && tasks.empty()) {
+              return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  template <typename F, typename... Args>
+  auto enqueue(F &&f, Args &&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type> {
+    using ReturnType = typename std::result_of<F(Args...)>::type;
+    auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<ReturnType> result = task->get_future();
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      tasks.emplace([task]() { (*task)(); });
+    }
+    condition.notify_one();
+    return result;
+  }
+
+  std::size_t size() const { return workers.size(); }
+
+  ~ThreadPool() {
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      stop = true;
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex queueMutex;
+  std::condition_variable condition;
+  bool stop = false;
+};
+} // namespace xacc
+#endif
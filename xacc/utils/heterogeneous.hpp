@@ -71,6 +71,21 @@ template <typename T> T force_cast(std::any in_any) {
   }
 }
 
+// Same as force_cast, but returns a pointer to the stored value (no copy).
+template <typename T> const T *force_cast_ptr(const std::any &in_any) {
+  static_assert(sizeof(std::any) == sizeof(funcPtr) + sizeof(Storage));
+  const void *storageLoc =
+      (const void *)((std::uintptr_t)&in_any + sizeof(funcPtr));
+  const Storage &storage = *reinterpret_cast<const Storage *>(storageLoc);
+  constexpr bool fit =
+      (sizeof(T) <= sizeof(Storage)) && (alignof(T) <= alignof(Storage));
+  if (fit) {
+    return reinterpret_cast<const T *>(&(storage._M_buffer));
+  } else {
+    return reinterpret_cast<const T *>(storage._M_ptr);
+  }
+}
+
 template <typename T> bool isType(std::any in_any) {
   if ((in_any.type() == typeid(T)) ||
       (strcmp(in_any.type().name(), typeid(T).name()) == 0)) {
@@ -85,6 +100,7 @@ namespace xacc {
   void emit_error(const std::string&& s);
 
 class HeterogeneousMap;
+class PropertyStore;
 
 template <class...> struct is_heterogeneous_map : std::false_type {};
 
@@ -235,18 +251,18 @@ public:
   }
 
   template <typename T> bool keyExists(const std::string key) const {
-    if (items.count(key)) {
+    auto iter = items.find(key);
+    if (iter != items.end()) {
       // we have the key, make sure it is the right type
-      try {
-        std::any_cast<T>(items.at(key));
-      } catch (std::exception &e) {
+      // (pointer any_cast: no copy, no exception on mismatch)
+      if (std::any_cast<T>(&iter->second)) {
+        return true;
+      }
 #ifdef APPLY_RTTI_ANY_CAST_FIX
-        return __internal::isType<T>(items.at(key));
+      return __internal::isType<T>(iter->second);
 #else
-        return false;
+      return false;
 #endif
-      }
-      return true;
     }
     return false;
   }
@@ -267,6 +283,7 @@ public:
   }
 
 private:
+  friend class PropertyStore;
   std::map<std::string, std::any> items;
 
   template <typename T>